@@ -0,0 +1,136 @@
+//---------------------------------------------------------------------------
+// BenchAuxil.cpp
+//
+// Auxiliary functions shared by the Zyzzyva benchmarks.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "BenchAuxil.h"
+#include "WordEngine.h"
+#include "MainSettings.h"
+#include "Auxil.h"
+#include "Defs.h"
+#include <QFile>
+
+// The lexicon benchmarked unless another is named by the environment
+// variable below
+QString BENCH_LEXICON = Defs::LEXICON_OWL2;
+const char* BENCH_LEXICON_VARIABLE = "ZYZZYVA_BENCH_LEXICON";
+
+//---------------------------------------------------------------------------
+//  getLexicon
+//
+//! Get the lexicon to benchmark.
+//
+//! @return the lexicon named by the environment, or the default lexicon
+//---------------------------------------------------------------------------
+QString
+BenchAuxil::getLexicon()
+{
+    QString lexicon = QString::fromLocal8Bit(qgetenv(BENCH_LEXICON_VARIABLE));
+    return lexicon.isEmpty() ? BENCH_LEXICON : lexicon;
+}
+
+//---------------------------------------------------------------------------
+//  loadLexicon
+//
+//! Load a lexicon from its word graph files, with the stems, and connect to
+//! its database if it has been built.
+//
+//! @param engine the word engine to load the lexicon into
+//! @param lexicon the name of the lexicon
+//! @param hasDatabase returns whether the database was connected
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+BenchAuxil::loadLexicon(WordEngine* engine, const QString& lexicon,
+                        bool* hasDatabase)
+{
+    if (hasDatabase)
+        *hasDatabase = false;
+
+    QString prefix = Auxil::getLexiconPrefix(lexicon);
+    if (prefix.isEmpty())
+        return false;
+
+    MainSettings::setLetterDistribution("A:9 B:2 C:2 D:4 E:12 F:2 G:3 H:2 "
+                                        "I:9 J:1 K:1 L:4 M:2 N:6 O:8 P:2 "
+                                        "Q:1 R:6 S:4 T:6 U:4 V:2 W:2 X:1 "
+                                        "Y:2 Z:1 _:2");
+
+    QString wordsDir = Auxil::getWordsDir();
+    if (!engine->importDawgFile(lexicon, wordsDir + prefix + ".dwg", false) ||
+        !engine->importDawgFile(lexicon, wordsDir + prefix + "-R.dwg", true))
+    {
+        return false;
+    }
+
+    engine->importStems(lexicon, wordsDir +
+                        "/North-American/6-letter-stems.txt");
+    engine->importStems(lexicon, wordsDir +
+                        "/North-American/7-letter-stems.txt");
+
+    QString dbFilename = Auxil::getDatabaseFilename(lexicon);
+    bool connected = QFile::exists(dbFilename) &&
+        engine->connectToDatabase(lexicon, dbFilename);
+    if (hasDatabase)
+        *hasDatabase = connected;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  makeCondition
+//
+//! Create a search condition.
+//
+//! @param type the type of the condition
+//! @param stringValue the string value
+//! @param minValue the minimum value
+//! @param maxValue the maximum value
+//! @return the condition
+//---------------------------------------------------------------------------
+SearchCondition
+BenchAuxil::makeCondition(SearchCondition::SearchType type, const QString&
+                          stringValue, int minValue, int maxValue)
+{
+    SearchCondition condition;
+    condition.type = type;
+    condition.stringValue = stringValue;
+    condition.minValue = minValue;
+    condition.maxValue = maxValue;
+    return condition;
+}
+
+//---------------------------------------------------------------------------
+//  reportNsPerOp
+//
+//! Report the average time taken by an operation.
+//
+//! @param nsecs the total time in nanoseconds
+//! @param numOps the number of operations
+//---------------------------------------------------------------------------
+void
+BenchAuxil::reportNsPerOp(qint64 nsecs, qint64 numOps)
+{
+    if (!numOps)
+        return;
+    qDebug("%.1f ns/op over %lld ops", double(nsecs) / numOps,
+           (long long) numOps);
+}
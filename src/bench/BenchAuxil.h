@@ -0,0 +1,43 @@
+//---------------------------------------------------------------------------
+// BenchAuxil.h
+//
+// Auxiliary functions shared by the Zyzzyva benchmarks.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_BENCH_AUXIL_H
+#define ZYZZYVA_BENCH_AUXIL_H
+
+#include "SearchCondition.h"
+#include <QString>
+
+class WordEngine;
+
+namespace BenchAuxil {
+    QString getLexicon();
+    bool loadLexicon(WordEngine* engine, const QString& lexicon,
+                     bool* hasDatabase = 0);
+    SearchCondition makeCondition(SearchCondition::SearchType type, const
+                                  QString& stringValue, int minValue = 0,
+                                  int maxValue = 0);
+    void reportNsPerOp(qint64 nsecs, qint64 numOps);
+}
+
+#endif // ZYZZYVA_BENCH_AUXIL_H
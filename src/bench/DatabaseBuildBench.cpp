@@ -0,0 +1,149 @@
+//---------------------------------------------------------------------------
+// DatabaseBuildBench.cpp
+//
+// A class for benchmarking the creation of lexicon databases.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "DatabaseBuildBench.h"
+#include "BenchAuxil.h"
+#include "CreateDatabaseThread.h"
+#include "LexiconSnapshot.h"
+#include "Auxil.h"
+#include "Defs.h"
+#include <QtTest/QtTest>
+
+// Comma-separated worker thread counts to build the database with, if not
+// the default of one thread and one per processor
+const char* BENCH_THREADS_VARIABLE = "ZYZZYVA_BENCH_THREADS";
+
+//---------------------------------------------------------------------------
+//  initTestCase
+//
+//! Load the benchmark lexicon, and choose a temporary file to build its
+//! database in.
+//---------------------------------------------------------------------------
+void
+DatabaseBuildBench::initTestCase()
+{
+    lexicon = BenchAuxil::getLexicon();
+    QVERIFY2(BenchAuxil::loadLexicon(&engine, lexicon), "Cannot load lexicon");
+
+    definitionFilename = Auxil::getWordsDir() +
+        Auxil::getLexiconPrefix(lexicon) + ".txt";
+    dbFilename = QString("%1/zyzzyva-bench-%2.db").arg(QDir::tempPath())
+        .arg(Auxil::getPid());
+}
+
+//---------------------------------------------------------------------------
+//  benchBuild_data
+//
+//! Set up the worker thread counts to build the database with.
+//---------------------------------------------------------------------------
+void
+DatabaseBuildBench::benchBuild_data()
+{
+    QTest::addColumn<int>("numThreads");
+
+    QList<int> threadCounts;
+    QString counts = QString::fromLocal8Bit(qgetenv(BENCH_THREADS_VARIABLE));
+    foreach (const QString& count, counts.split(",", QString::SkipEmptyParts))
+    {
+        if (count.toInt() > 0)
+            threadCounts.append(count.toInt());
+    }
+    if (threadCounts.isEmpty()) {
+        threadCounts.append(1);
+        if (QThread::idealThreadCount() > 1)
+            threadCounts.append(QThread::idealThreadCount());
+    }
+
+    foreach (int numThreads, threadCounts) {
+        QString name = QString("%1-threads").arg(numThreads);
+        QTest::newRow(name.toUtf8().constData()) << numThreads;
+    }
+}
+
+//---------------------------------------------------------------------------
+//  benchBuild
+//
+//! Benchmark creating the database with a number of worker threads,
+//! reporting the rows processed per second by each stage and in all.
+//---------------------------------------------------------------------------
+void
+DatabaseBuildBench::benchBuild()
+{
+    QFETCH(int, numThreads);
+    removeBuildFiles();
+
+    CreateDatabaseThread thread (&engine, lexicon, dbFilename,
+                                 definitionFilename);
+    thread.setNumThreads(numThreads);
+
+    // The stages finish on the build thread, which is waited for below
+    connect(&thread, SIGNAL(stageFinished(const QString&, int, int)),
+            SLOT(stageFinished(const QString&, int, int)),
+            Qt::DirectConnection);
+
+    QElapsedTimer timer;
+    QBENCHMARK_ONCE {
+        timer.start();
+        thread.start();
+        thread.wait();
+    }
+    qint64 msecs = timer.elapsed();
+    int numWords = engine.getNumWords(lexicon);
+
+    removeBuildFiles();
+    QVERIFY2(!thread.getCancelled(), thread.getError().toUtf8().constData());
+
+    qDebug("total: %d words in %lld ms, %.0f words/s", numWords,
+           (long long) msecs, msecs ? numWords * 1000.0 / msecs : 0.0);
+}
+
+//---------------------------------------------------------------------------
+//  stageFinished
+//
+//! Report the rows processed per second by a stage of creating the
+//! database.
+//
+//! @param stage the name of the stage
+//! @param rows the number of rows processed
+//! @param msecs the time the stage took in milliseconds
+//---------------------------------------------------------------------------
+void
+DatabaseBuildBench::stageFinished(const QString& stage, int rows, int msecs)
+{
+    qDebug("%s: %d rows in %d ms, %.0f rows/s", stage.toUtf8().constData(),
+           rows, msecs, msecs ? rows * 1000.0 / msecs : 0.0);
+}
+
+//---------------------------------------------------------------------------
+//  removeBuildFiles
+//
+//! Remove the temporary database file and the files made with it.
+//---------------------------------------------------------------------------
+void
+DatabaseBuildBench::removeBuildFiles() const
+{
+    QFile::remove(dbFilename);
+    QFile::remove(dbFilename + ".build");
+    QFile::remove(LexiconSnapshot::getFilename(dbFilename));
+}
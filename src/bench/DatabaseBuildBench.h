@@ -0,0 +1,54 @@
+//---------------------------------------------------------------------------
+// DatabaseBuildBench.h
+//
+// A class for benchmarking the creation of lexicon databases.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_DATABASE_BUILD_BENCH_H
+#define ZYZZYVA_DATABASE_BUILD_BENCH_H
+
+#include "WordEngine.h"
+#include <QObject>
+#include <QString>
+
+class DatabaseBuildBench : public QObject
+{
+    Q_OBJECT
+    public:
+    DatabaseBuildBench() { }
+
+    private slots:
+    void initTestCase();
+    void benchBuild_data();
+    void benchBuild();
+    void stageFinished(const QString& stage, int rows, int msecs);
+
+    private:
+    void removeBuildFiles() const;
+
+    private:
+    WordEngine engine;
+    QString lexicon;
+    QString dbFilename;
+    QString definitionFilename;
+};
+
+#endif // ZYZZYVA_DATABASE_BUILD_BENCH_H
@@ -0,0 +1,246 @@
+//---------------------------------------------------------------------------
+// DawgBench.cpp
+//
+// A class for benchmarking the encodings of the reverse DAWG.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "DawgBench.h"
+#include "BenchAuxil.h"
+#include "Defs.h"
+#include <QtTest/QtTest>
+
+using namespace BenchAuxil;
+
+// Every how many words of the lexicon front extensions are found for
+const int EXTENSION_WORD_STEP = 50;
+
+//---------------------------------------------------------------------------
+//  initTestCase
+//
+//! Load the benchmark lexicon, and build two word graphs of its words, one
+//! with the packed reverse DAWG and one with the succinct reverse DAWG.
+//---------------------------------------------------------------------------
+void
+DawgBench::initTestCase()
+{
+    lexicon = getLexicon();
+    QVERIFY2(loadLexicon(&engine, lexicon), "Cannot load lexicon");
+
+    SearchSpec spec;
+    spec.conditions.append(makeCondition(SearchCondition::Length, QString(),
+                                         1, Defs::MAX_WORD_LEN));
+    words = engine.search(lexicon, spec, true);
+    QVERIFY2(!words.isEmpty(), "Lexicon has no words");
+
+    QVERIFY2(buildGraph(&packedGraph, false), "Cannot build packed graph");
+    QVERIFY2(buildGraph(&succinctGraph, true),
+             "Cannot build succinct graph");
+}
+
+//---------------------------------------------------------------------------
+//  buildGraph
+//
+//! Build a word graph of the words of the lexicon, with the same tables
+//! the word engine builds when it loads a lexicon.
+//
+//! @param graph the graph to build
+//! @param succinct whether to hold the reverse DAWG in the succinct
+//! encoding
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+DawgBench::buildGraph(WordGraph* graph, bool succinct) const
+{
+    if (!graph->importWords(words, false) || !graph->importWords(words, true))
+        return false;
+    graph->buildLookupTable();
+    graph->buildWordCounts();
+    graph->buildWordArray();
+    graph->buildLengthMasks();
+    return !succinct || graph->buildSuccinctReverseDawg();
+}
+
+//---------------------------------------------------------------------------
+//  addEncodingRows
+//
+//! Add a row of benchmark data for each encoding of the reverse DAWG.
+//---------------------------------------------------------------------------
+void
+DawgBench::addEncodingRows() const
+{
+    QTest::addColumn<QString>("encoding");
+    QTest::newRow("packed") << QString("packed");
+    QTest::newRow("succinct") << QString("succinct");
+}
+
+//---------------------------------------------------------------------------
+//  getGraph
+//
+//! Get the word graph with an encoding of the reverse DAWG.
+//
+//! @param encoding the name of the encoding
+//! @return the word graph
+//---------------------------------------------------------------------------
+const WordGraph*
+DawgBench::getGraph(const QString& encoding) const
+{
+    return (encoding == "succinct") ? &succinctGraph : &packedGraph;
+}
+
+//---------------------------------------------------------------------------
+//  benchMemory
+//
+//! Report the memory used by each encoding of the reverse DAWG, and check
+//! that both find the same front hooks for every word.
+//---------------------------------------------------------------------------
+void
+DawgBench::benchMemory()
+{
+    const WordGraph* graphs[] = { &packedGraph, &succinctGraph };
+    for (int i = 0; i < 2; ++i) {
+        QList<WordGraph::MemoryUsage> usage;
+        graphs[i]->getMemoryUsage(&usage);
+        foreach (const WordGraph::MemoryUsage& structure, usage) {
+            if (!structure.structure.startsWith("Reverse DAWG"))
+                continue;
+            qDebug("%s: %lld bytes", structure.structure.toUtf8().constData(),
+                   (long long) structure.bytes);
+        }
+    }
+
+    foreach (const QString& word, words) {
+        quint32 packedFront, packedBack, succinctFront, succinctBack;
+        packedGraph.hooks(word, &packedFront, &packedBack);
+        succinctGraph.hooks(word, &succinctFront, &succinctBack);
+        QCOMPARE(succinctFront, packedFront);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  benchFrontHooks_data
+//
+//! Set up the encodings to benchmark finding front hooks with.
+//---------------------------------------------------------------------------
+void
+DawgBench::benchFrontHooks_data()
+{
+    addEncodingRows();
+}
+
+//---------------------------------------------------------------------------
+//  benchFrontHooks
+//
+//! Benchmark finding the hooks of every word of the lexicon.  Back hooks
+//! are found in the forward DAWG either way.
+//---------------------------------------------------------------------------
+void
+DawgBench::benchFrontHooks()
+{
+    QFETCH(QString, encoding);
+    const WordGraph* graph = getGraph(encoding);
+
+    qint64 nsecs = 0;
+    qint64 numOps = 0;
+    QElapsedTimer timer;
+    QBENCHMARK {
+        timer.start();
+        foreach (const QString& word, words) {
+            quint32 frontHooks, backHooks;
+            graph->hooks(word, &frontHooks, &backHooks);
+        }
+        nsecs += timer.nsecsElapsed();
+        numOps += words.size();
+    }
+    reportNsPerOp(nsecs, numOps);
+}
+
+//---------------------------------------------------------------------------
+//  benchFrontExtensions_data
+//
+//! Set up the encodings to benchmark finding front extensions with.
+//---------------------------------------------------------------------------
+void
+DawgBench::benchFrontExtensions_data()
+{
+    addEncodingRows();
+}
+
+//---------------------------------------------------------------------------
+//  benchFrontExtensions
+//
+//! Benchmark finding the front extensions of words spread through the
+//! lexicon.
+//---------------------------------------------------------------------------
+void
+DawgBench::benchFrontExtensions()
+{
+    QFETCH(QString, encoding);
+    const WordGraph* graph = getGraph(encoding);
+
+    qint64 nsecs = 0;
+    qint64 numOps = 0;
+    QElapsedTimer timer;
+    QBENCHMARK {
+        timer.start();
+        for (int i = 0; i < words.size(); i += EXTENSION_WORD_STEP) {
+            QStringList extensions;
+            graph->getExtensions(words[i], WordGraph::FrontExtensions,
+                                 Defs::MAX_WORD_LEN, &extensions);
+            ++numOps;
+        }
+        nsecs += timer.nsecsElapsed();
+    }
+    reportNsPerOp(nsecs, numOps);
+}
+
+//---------------------------------------------------------------------------
+//  benchSuffixSearch_data
+//
+//! Set up the encodings to benchmark searching for patterns ending in
+//! letters with.
+//---------------------------------------------------------------------------
+void
+DawgBench::benchSuffixSearch_data()
+{
+    addEncodingRows();
+}
+
+//---------------------------------------------------------------------------
+//  benchSuffixSearch
+//
+//! Benchmark searching for a pattern ending in letters, which is matched
+//! against the packed reverse DAWG, or the forward DAWG if the reverse
+//! DAWG is succinct.
+//---------------------------------------------------------------------------
+void
+DawgBench::benchSuffixSearch()
+{
+    QFETCH(QString, encoding);
+    const WordGraph* graph = getGraph(encoding);
+
+    SearchSpec spec;
+    spec.conditions.append(makeCondition(SearchCondition::PatternMatch,
+                                         "*ING"));
+    int numMatches = packedGraph.search(spec).size();
+    QBENCHMARK {
+        QCOMPARE(graph->search(spec).size(), numMatches);
+    }
+}
@@ -0,0 +1,63 @@
+//---------------------------------------------------------------------------
+// DawgBench.h
+//
+// A class for benchmarking the encodings of the reverse DAWG.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_DAWG_BENCH_H
+#define ZYZZYVA_DAWG_BENCH_H
+
+#include "WordEngine.h"
+#include "WordGraph.h"
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class DawgBench : public QObject
+{
+    Q_OBJECT
+    public:
+    DawgBench() { }
+
+    private slots:
+    void initTestCase();
+    void benchMemory();
+    void benchFrontHooks_data();
+    void benchFrontHooks();
+    void benchFrontExtensions_data();
+    void benchFrontExtensions();
+    void benchSuffixSearch_data();
+    void benchSuffixSearch();
+
+    private:
+    bool buildGraph(WordGraph* graph, bool succinct) const;
+    void addEncodingRows() const;
+    const WordGraph* getGraph(const QString& encoding) const;
+
+    private:
+    WordEngine engine;
+    QString lexicon;
+    QStringList words;
+    WordGraph packedGraph;
+    WordGraph succinctGraph;
+};
+
+#endif // ZYZZYVA_DAWG_BENCH_H
@@ -0,0 +1,368 @@
+//---------------------------------------------------------------------------
+// QuizBench.cpp
+//
+// A class for benchmarking quizzes and quiz statistics databases.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "QuizBench.h"
+#include "BenchAuxil.h"
+#include "QuizEngine.h"
+#include "QuizStatsDatabase.h"
+#include "MainSettings.h"
+#include "Auxil.h"
+#include "Defs.h"
+#include <QtTest/QtTest>
+
+using namespace BenchAuxil;
+
+// Number of questions in the synthetic quiz statistics database
+const int NUM_STATS_QUESTIONS = 100000;
+
+// Number of responses recorded by each iteration of the response benchmark
+const int NUM_RECORDED_RESPONSES = 1000;
+
+// Question of the quiz with a large number of answers
+const QString LARGE_ANSWER_QUESTION = "AEINRST";
+
+//---------------------------------------------------------------------------
+//  removeDir
+//
+//! Remove a directory and everything in it.
+//
+//! @param dirName the name of the directory
+//---------------------------------------------------------------------------
+static void
+removeDir(const QString& dirName)
+{
+    QDir dir (dirName);
+    if (!dir.exists())
+        return;
+
+    QStringList entries = dir.entryList(QDir::AllEntries | QDir::Hidden |
+                                        QDir::NoDotAndDotDot);
+    foreach (const QString& entry, entries) {
+        QString path = dir.filePath(entry);
+        if (QFileInfo(path).isDir())
+            removeDir(path);
+        else
+            QFile::remove(path);
+    }
+    dir.rmdir(dirName);
+}
+
+//---------------------------------------------------------------------------
+//  initTestCase
+//
+//! Load the benchmark lexicon, and use a temporary user data directory so
+//! the synthetic quiz statistics do not touch the real ones.  The
+//! questions of the statistics database are the alphagrams of the words
+//! of the lexicon, up to the number of questions wanted.
+//---------------------------------------------------------------------------
+void
+QuizBench::initTestCase()
+{
+    lexicon = getLexicon();
+    QVERIFY2(loadLexicon(&engine, lexicon, &hasDatabase),
+             "Cannot load lexicon");
+
+    userDataDir = MainSettings::getUserDataDir();
+    dataDir = QString("%1/zyzzyva-bench-%2").arg(QDir::tempPath())
+        .arg(Auxil::getPid());
+    removeDir(dataDir);
+    MainSettings::setUserDataDir(dataDir);
+
+    SearchSpec spec;
+    spec.conditions.append(makeCondition(SearchCondition::Length, QString(),
+                                         2, Defs::MAX_WORD_LEN));
+    QSet<QString> alphagrams;
+    foreach (const QString& word, engine.search(lexicon, spec, true)) {
+        QString alphagram = Auxil::getAlphagram(word);
+        if (alphagrams.contains(alphagram))
+            continue;
+        alphagrams.insert(alphagram);
+        questions.append(alphagram);
+        if (questions.size() == NUM_STATS_QUESTIONS)
+            break;
+    }
+    QVERIFY2(!questions.isEmpty(), "Lexicon has no words");
+}
+
+//---------------------------------------------------------------------------
+//  cleanupTestCase
+//
+//! Remove the temporary user data directory.
+//---------------------------------------------------------------------------
+void
+QuizBench::cleanupTestCase()
+{
+    MainSettings::setUserDataDir(userDataDir);
+    removeDir(dataDir);
+}
+
+//---------------------------------------------------------------------------
+//  benchAddToCardbox
+//
+//! Benchmark adding every question to the cardbox at once.
+//---------------------------------------------------------------------------
+void
+QuizBench::benchAddToCardbox()
+{
+    QuizStatsDatabase db (lexicon, Auxil::quizTypeToString(
+        QuizSpec::QuizAnagrams));
+    QVERIFY(db.isValid());
+
+    QBENCHMARK_ONCE {
+        db.addToCardbox(questions, false);
+        db.sync();
+    }
+}
+
+//---------------------------------------------------------------------------
+//  benchRecordResponse
+//
+//! Benchmark recording responses to questions in the cardbox.
+//---------------------------------------------------------------------------
+void
+QuizBench::benchRecordResponse()
+{
+    QuizStatsDatabase db (lexicon, Auxil::quizTypeToString(
+        QuizSpec::QuizAnagrams));
+    QVERIFY(db.isValid());
+
+    Rand rng (Rand::MarsagliaMwc, 1, 1);
+    qint64 nsecs = 0;
+    qint64 numOps = 0;
+    QElapsedTimer timer;
+    QBENCHMARK {
+        timer.start();
+        for (int i = 0; i < NUM_RECORDED_RESPONSES; ++i) {
+            const QString& question =
+                questions[rng.rand(questions.size() - 1)];
+            db.recordResponse(question, rng.rand(1), true);
+        }
+        db.sync();
+        nsecs += timer.nsecsElapsed();
+        numOps += NUM_RECORDED_RESPONSES;
+    }
+    reportNsPerOp(nsecs, numOps);
+}
+
+//---------------------------------------------------------------------------
+//  benchGetReadyQuestions
+//
+//! Benchmark finding the questions in the cardbox that are ready.
+//---------------------------------------------------------------------------
+void
+QuizBench::benchGetReadyQuestions()
+{
+    QuizStatsDatabase db (lexicon, Auxil::quizTypeToString(
+        QuizSpec::QuizAnagrams));
+    QVERIFY(db.isValid());
+
+    QBENCHMARK {
+        db.getReadyQuestions(QStringList(), false);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  benchRescheduleCardbox
+//
+//! Benchmark rescheduling every question in the cardbox.
+//---------------------------------------------------------------------------
+void
+QuizBench::benchRescheduleCardbox()
+{
+    QuizStatsDatabase db (lexicon, Auxil::quizTypeToString(
+        QuizSpec::QuizAnagrams));
+    QVERIFY(db.isValid());
+
+    QBENCHMARK {
+        db.rescheduleCardbox(questions);
+        db.sync();
+    }
+}
+
+//---------------------------------------------------------------------------
+//  benchMergeDatabase
+//
+//! Benchmark merging a database with every question in the cardbox into
+//! the database of another quiz type holding the same questions.
+//---------------------------------------------------------------------------
+void
+QuizBench::benchMergeDatabase()
+{
+    QString filename;
+    {
+        QuizStatsDatabase other (lexicon, Auxil::quizTypeToString(
+            QuizSpec::QuizAnagramsWithHooks));
+        QVERIFY(other.isValid());
+        other.addToCardbox(questions, false);
+        other.sync();
+        filename = other.getDatabase()->databaseName();
+    }
+
+    QuizStatsDatabase db (lexicon, Auxil::quizTypeToString(
+        QuizSpec::QuizAnagrams));
+    QVERIFY(db.isValid());
+
+    int numMerged = 0;
+    QBENCHMARK_ONCE {
+        QVERIFY(db.mergeDatabase(filename, &numMerged));
+    }
+    QCOMPARE(numMerged, questions.size());
+}
+
+//---------------------------------------------------------------------------
+//  benchNewQuiz_data
+//
+//! Set up the question orders to start quizzes with.
+//---------------------------------------------------------------------------
+void
+QuizBench::benchNewQuiz_data()
+{
+    QTest::addColumn<int>("order");
+    QTest::addColumn<bool>("needsDatabase");
+
+    QTest::newRow("random") << int(QuizSpec::RandomOrder) << false;
+    QTest::newRow("probability") << int(QuizSpec::ProbabilityOrder) << true;
+    QTest::newRow("playability") << int(QuizSpec::PlayabilityOrder) << true;
+    QTest::newRow("schedule") << int(QuizSpec::ScheduleOrder) << false;
+}
+
+//---------------------------------------------------------------------------
+//  benchNewQuiz
+//
+//! Benchmark starting a quiz on the seven-letter words, in each question
+//! order.  Schedule order quizzes are started from the cardbox.
+//---------------------------------------------------------------------------
+void
+QuizBench::benchNewQuiz()
+{
+    QFETCH(int, order);
+    QFETCH(bool, needsDatabase);
+    if (needsDatabase && !hasDatabase)
+        QSKIP("Lexicon database has not been built", SkipSingle);
+
+    QuizSpec spec = makeQuizSpec(QuizSpec::QuestionOrder(order));
+    if (order == QuizSpec::ScheduleOrder)
+        spec.setMethod(QuizSpec::CardboxQuizMethod);
+
+    QuizEngine quizEngine (&engine);
+    QBENCHMARK {
+        QVERIFY(quizEngine.newQuiz(spec));
+    }
+}
+
+//---------------------------------------------------------------------------
+//  benchNextQuestion
+//
+//! Benchmark moving to the next question of a quiz, which finds the
+//! answers of the question.  The quiz is started again when it runs out of
+//! questions.
+//---------------------------------------------------------------------------
+void
+QuizBench::benchNextQuestion()
+{
+    QuizSpec spec = makeQuizSpec(QuizSpec::RandomOrder);
+    QuizEngine quizEngine (&engine);
+    QVERIFY(quizEngine.newQuiz(spec));
+
+    qint64 nsecs = 0;
+    qint64 numOps = 0;
+    QElapsedTimer timer;
+    QBENCHMARK {
+        timer.start();
+        if (!quizEngine.nextQuestion())
+            QVERIFY(quizEngine.newQuiz(spec));
+        nsecs += timer.nsecsElapsed();
+        ++numOps;
+    }
+    reportNsPerOp(nsecs, numOps);
+}
+
+//---------------------------------------------------------------------------
+//  benchRespond
+//
+//! Benchmark responding to a subanagram question with a large number of
+//! answers, giving every answer and as many incorrect responses.
+//---------------------------------------------------------------------------
+void
+QuizBench::benchRespond()
+{
+    SearchSpec searchSpec;
+    searchSpec.conditions.append(makeCondition(SearchCondition::AnagramMatch,
+                                               LARGE_ANSWER_QUESTION));
+    SearchSpec answerSpec;
+    answerSpec.conditions.append(makeCondition(
+        SearchCondition::SubanagramMatch, LARGE_ANSWER_QUESTION));
+    QStringList answers = engine.search(lexicon, answerSpec, true);
+    QVERIFY(!answers.isEmpty());
+
+    QStringList responses;
+    foreach (const QString& answer, answers) {
+        responses.append(answer);
+        responses.append(answer + "Q");
+    }
+
+    QuizSpec spec;
+    spec.setLexicon(lexicon);
+    spec.setType(QuizSpec::QuizSubanagrams);
+    spec.setSearchSpec(searchSpec);
+
+    QuizEngine quizEngine (&engine);
+    qint64 nsecs = 0;
+    qint64 numOps = 0;
+    QElapsedTimer timer;
+    QBENCHMARK {
+        QVERIFY(quizEngine.newQuiz(spec));
+        timer.start();
+        foreach (const QString& response, responses)
+            quizEngine.respond(response);
+        nsecs += timer.nsecsElapsed();
+        numOps += responses.size();
+    }
+    reportNsPerOp(nsecs, numOps);
+}
+
+//---------------------------------------------------------------------------
+//  makeQuizSpec
+//
+//! Create the spec of an anagram quiz on the seven-letter words.
+//
+//! @param order the question order
+//! @return the quiz spec
+//---------------------------------------------------------------------------
+QuizSpec
+QuizBench::makeQuizSpec(QuizSpec::QuestionOrder order) const
+{
+    SearchSpec searchSpec;
+    searchSpec.conditions.append(makeCondition(SearchCondition::Length,
+                                               QString(), 7, 7));
+
+    QuizSpec spec;
+    spec.setLexicon(lexicon);
+    spec.setType(QuizSpec::QuizAnagrams);
+    spec.setSearchSpec(searchSpec);
+    spec.setQuestionOrder(order);
+    spec.setRandomSeed(1);
+    spec.setRandomSeed2(1);
+    return spec;
+}
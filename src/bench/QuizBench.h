@@ -0,0 +1,65 @@
+//---------------------------------------------------------------------------
+// QuizBench.h
+//
+// A class for benchmarking quizzes and quiz statistics databases.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_QUIZ_BENCH_H
+#define ZYZZYVA_QUIZ_BENCH_H
+
+#include "QuizSpec.h"
+#include "WordEngine.h"
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QuizBench : public QObject
+{
+    Q_OBJECT
+    public:
+    QuizBench() : hasDatabase(false) { }
+
+    private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchAddToCardbox();
+    void benchRecordResponse();
+    void benchGetReadyQuestions();
+    void benchRescheduleCardbox();
+    void benchMergeDatabase();
+    void benchNewQuiz_data();
+    void benchNewQuiz();
+    void benchNextQuestion();
+    void benchRespond();
+
+    private:
+    QuizSpec makeQuizSpec(QuizSpec::QuestionOrder order) const;
+
+    private:
+    WordEngine engine;
+    QString lexicon;
+    QString userDataDir;
+    QString dataDir;
+    QStringList questions;
+    bool hasDatabase;
+};
+
+#endif // ZYZZYVA_QUIZ_BENCH_H
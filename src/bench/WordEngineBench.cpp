@@ -0,0 +1,243 @@
+//---------------------------------------------------------------------------
+// WordEngineBench.cpp
+//
+// A class for benchmarking the WordEngine class.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "WordEngineBench.h"
+#include "BenchAuxil.h"
+#include "MainSettings.h"
+#include "Auxil.h"
+#include "Defs.h"
+#include <QtTest/QtTest>
+
+using namespace BenchAuxil;
+
+//---------------------------------------------------------------------------
+//  initTestCase
+//
+//! Load the benchmark lexicon, with its stems, and connect to its database
+//! if it has been built.  The search result cache is disabled, so every
+//! search is measured in full.
+//---------------------------------------------------------------------------
+void
+WordEngineBench::initTestCase()
+{
+    lexicon = getLexicon();
+    MainSettings::setSearchCacheSize(0);
+    QVERIFY2(loadLexicon(&engine, lexicon, &hasDatabase),
+             "Cannot load lexicon");
+
+    // Probe every word of the lexicon, and the same number of strings that
+    // are mostly not words
+    SearchSpec allSpec;
+    allSpec.conditions.append(makeCondition(SearchCondition::Length,
+                                            QString(), 2,
+                                            Defs::MAX_WORD_LEN));
+    QStringList words = engine.search(lexicon, allSpec, true);
+    QVERIFY2(!words.isEmpty(), "Lexicon has no words");
+    foreach (const QString& word, words) {
+        probeWords.append(word);
+        probeWords.append(word + "Q");
+    }
+
+    QList<SearchCondition> conditions;
+
+    const char* anagrams[] = { "AEINRST", "AEINRS?", "AEINR??" };
+    for (int i = 0; i < 3; ++i) {
+        conditions.clear();
+        conditions << makeCondition(SearchCondition::AnagramMatch,
+                                    anagrams[i]);
+        addSpec(QString("anagram-%1-blanks").arg(i), conditions);
+
+        conditions.clear();
+        conditions << makeCondition(SearchCondition::SubanagramMatch,
+                                    anagrams[i]);
+        addSpec(QString("subanagram-%1-blanks").arg(i), conditions);
+    }
+
+    // A full rack with two blanks, as in a drill for every playable word
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::SubanagramMatch,
+                                "AEINRST??");
+    addSpec("subanagram-rack-2-blanks", conditions);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::PatternMatch, "UN*");
+    addSpec("prefix-pattern", conditions);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::PatternMatch, "UN*")
+               << makeCondition(SearchCondition::Length, QString(), 12, 15);
+    addSpec("prefix-pattern-long", conditions);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::PatternMatch, "*ING");
+    addSpec("suffix-pattern", conditions);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::PatternMatch, "*QU*");
+    addSpec("infix-pattern", conditions);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::PatternMatch, "???Q???");
+    addSpec("fixed-position-pattern", conditions);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::IncludeLetters, "JX");
+    addSpec("include-letters", conditions);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::Length, QString(), 7, 7);
+    addSpec("length-7", conditions);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::Length, QString(), 2,
+                                Defs::MAX_WORD_LEN);
+    addSpec("length-all", conditions);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::BelongToGroup,
+                                Auxil::searchSetToString(SetHookWords))
+               << makeCondition(SearchCondition::Length, QString(), 7, 7);
+    addSpec("set-hook-words-7", conditions);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::BelongToGroup,
+                                Auxil::searchSetToString(SetTypeOneSevens));
+    addSpec("set-type-one-sevens", conditions);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::Length, QString(), 8, 8)
+               << makeCondition(SearchCondition::LimitByProbabilityOrder,
+                                QString(), 1, 500);
+    addSpec("limit-probability-8", conditions, true);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::Length, QString(), 7, 8)
+               << makeCondition(SearchCondition::LimitByPlayabilityOrder,
+                                QString(), 1, 1000);
+    addSpec("limit-playability-7-8", conditions, true);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::ProbabilityOrder,
+                                QString(), 1001, 2000)
+               << makeCondition(SearchCondition::Length, QString(), 7, 7);
+    addSpec("probability-order-7", conditions, true);
+
+    conditions.clear();
+    conditions << makeCondition(SearchCondition::PatternMatch, "*Z*")
+               << makeCondition(SearchCondition::Length, QString(), 6, 8)
+               << makeCondition(SearchCondition::NumVowels, QString(), 3, 3)
+               << makeCondition(SearchCondition::PointValue, QString(), 15,
+                                40);
+    addSpec("multi-condition", conditions, true);
+}
+
+//---------------------------------------------------------------------------
+//  addSpec
+//
+//! Add a search spec to be benchmarked.
+//
+//! @param name the name of the spec
+//! @param conditions the conditions of the spec
+//! @param needsDatabase whether the spec needs the lexicon database
+//---------------------------------------------------------------------------
+void
+WordEngineBench::addSpec(const QString& name, const QList<SearchCondition>&
+                         conditions, bool needsDatabase)
+{
+    SearchSpec spec;
+    spec.conditions = conditions;
+    specs.insert(name, spec);
+    if (needsDatabase)
+        databaseSpecs.insert(name);
+}
+
+//---------------------------------------------------------------------------
+//  benchContainsWord
+//
+//! Benchmark looking up words in the lexicon.
+//---------------------------------------------------------------------------
+void
+WordEngineBench::benchContainsWord()
+{
+    qint64 nsecs = 0;
+    qint64 numOps = 0;
+    int numFound = 0;
+    QElapsedTimer timer;
+    QBENCHMARK {
+        timer.start();
+        foreach (const QString& word, probeWords) {
+            if (engine.isAcceptable(lexicon, word))
+                ++numFound;
+        }
+        nsecs += timer.nsecsElapsed();
+        numOps += probeWords.size();
+    }
+    QVERIFY(numFound > 0);
+    reportNsPerOp(nsecs, numOps);
+}
+
+//---------------------------------------------------------------------------
+//  benchSearch_data
+//
+//! Set up the search specs to benchmark.
+//---------------------------------------------------------------------------
+void
+WordEngineBench::benchSearch_data()
+{
+    QTest::addColumn<QString>("specName");
+
+    foreach (const QString& name, specs.keys())
+        QTest::newRow(name.toUtf8().constData()) << name;
+}
+
+//---------------------------------------------------------------------------
+//  benchSearch
+//
+//! Benchmark a search, reporting the time per search and per word found.
+//---------------------------------------------------------------------------
+void
+WordEngineBench::benchSearch()
+{
+    QFETCH(QString, specName);
+    if (databaseSpecs.contains(specName) && !hasDatabase)
+        QSKIP("Lexicon database has not been built", SkipSingle);
+
+    const SearchSpec& spec = specs[specName];
+    qint64 nsecs = 0;
+    qint64 numOps = 0;
+    qint64 numWords = 0;
+    QElapsedTimer timer;
+    QBENCHMARK {
+        timer.start();
+        QStringList words = engine.search(lexicon, spec, true);
+        nsecs += timer.nsecsElapsed();
+        numWords += words.size();
+        ++numOps;
+    }
+    reportNsPerOp(nsecs, numOps);
+    if (numWords) {
+        qDebug("%.1f ns/word over %lld words", double(nsecs) / numWords,
+               (long long) numWords);
+    }
+}
@@ -0,0 +1,59 @@
+//---------------------------------------------------------------------------
+// WordEngineBench.h
+//
+// A class for benchmarking the WordEngine class.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_WORD_ENGINE_BENCH_H
+#define ZYZZYVA_WORD_ENGINE_BENCH_H
+
+#include "WordEngine.h"
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+class WordEngineBench : public QObject
+{
+    Q_OBJECT
+    public:
+    WordEngineBench() : hasDatabase(false) { }
+
+    private slots:
+    void initTestCase();
+    void benchContainsWord();
+    void benchSearch_data();
+    void benchSearch();
+
+    private:
+    void addSpec(const QString& name, const QList<SearchCondition>&
+                 conditions, bool needsDatabase = false);
+
+    private:
+    WordEngine engine;
+    QString lexicon;
+    QStringList probeWords;
+    QMap<QString, SearchSpec> specs;
+    QSet<QString> databaseSpecs;
+    bool hasDatabase;
+};
+
+#endif // ZYZZYVA_WORD_ENGINE_BENCH_H
@@ -0,0 +1,63 @@
+//---------------------------------------------------------------------------
+// bench.cpp
+//
+// The main function for the Zyzzyva benchmarks.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "DatabaseBuildBench.h"
+#include "DawgBench.h"
+#include "QuizBench.h"
+#include "WordEngineBench.h"
+#include <QApplication>
+#include <QtTest/QtTest>
+
+const QString DATABASE_MODE_ARG = "--database";
+const QString QUIZ_MODE_ARG = "--quiz";
+const QString DAWG_MODE_ARG = "--dawg";
+
+int main(int argc, char** argv)
+{
+    // No window is shown, so the benchmarks can run headless
+    QApplication app (argc, argv, false);
+
+    // The database build, quiz or DAWG encoding benchmark is run in place of
+    // the search benchmark if asked for by the first argument, which is not
+    // passed on to QtTest
+    QString mode = (argc > 1) ? QString(argv[1]) : QString();
+    if (mode == DATABASE_MODE_ARG) {
+        argv[1] = argv[0];
+        DatabaseBuildBench bench;
+        return QTest::qExec(&bench, argc - 1, argv + 1);
+    }
+    else if (mode == QUIZ_MODE_ARG) {
+        argv[1] = argv[0];
+        QuizBench bench;
+        return QTest::qExec(&bench, argc - 1, argv + 1);
+    }
+    else if (mode == DAWG_MODE_ARG) {
+        argv[1] = argv[0];
+        DawgBench bench;
+        return QTest::qExec(&bench, argc - 1, argv + 1);
+    }
+
+    WordEngineBench bench;
+    return QTest::qExec(&bench, argc, argv);
+}
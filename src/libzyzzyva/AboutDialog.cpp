@@ -23,12 +23,14 @@
 //---------------------------------------------------------------------------
 
 #include "AboutDialog.h"
+#include "WordEngine.h"
 #include "ZPushButton.h"
 #include "Auxil.h"
 #include "Defs.h"
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QTabWidget>
+#include <QTreeWidget>
 #include <QVBoxLayout>
 
 const QString DIALOG_CAPTION = "About Zyzzyva";
@@ -40,11 +42,12 @@ using namespace Defs;
 //
 //! Constructor.
 //
+//! @param e the word engine whose memory use is shown
 //! @param parent the parent widget
 //! @param f widget flags
 //---------------------------------------------------------------------------
-AboutDialog::AboutDialog(QWidget* parent, Qt::WFlags f)
-    : QDialog(parent, f)
+AboutDialog::AboutDialog(WordEngine* e, QWidget* parent, Qt::WFlags f)
+    : QDialog(parent, f), engine(e)
 {
     QVBoxLayout* mainVlay = new QVBoxLayout(this);
     mainVlay->setMargin(MARGIN);
@@ -75,6 +78,14 @@ AboutDialog::AboutDialog(QWidget* parent, Qt::WFlags f)
     thanksLabel->setWordWrap(true);
     tabStack->addTab(thanksLabel, "Thanks");
 
+    memoryTree = new QTreeWidget;
+    QStringList memoryTreeHeaders;
+    memoryTreeHeaders.append("Lexicon Structure");
+    memoryTreeHeaders.append("Memory (KB)");
+    memoryTreeHeaders.append("Mapped");
+    memoryTree->setHeaderLabels(memoryTreeHeaders);
+    tabStack->addTab(memoryTree, "Memory");
+
     QHBoxLayout* buttonHlay = new QHBoxLayout;
     buttonHlay->setSpacing(SPACING);
     mainVlay->addLayout(buttonHlay);
@@ -98,3 +109,50 @@ AboutDialog::AboutDialog(QWidget* parent, Qt::WFlags f)
 AboutDialog::~AboutDialog()
 {
 }
+
+//---------------------------------------------------------------------------
+//  updateMemoryReport
+//
+//! Show the estimated memory used by each structure of each loaded
+//! lexicon.  Mapped structures are read in place from files, and only the
+//! parts that have been read are resident.
+//---------------------------------------------------------------------------
+void
+AboutDialog::updateMemoryReport()
+{
+    memoryTree->clear();
+    if (!engine)
+        return;
+
+    QMap<QString, QList<WordEngine::MemoryUsage> > report =
+        engine->memoryReport();
+    QMapIterator<QString, QList<WordEngine::MemoryUsage> > it (report);
+    while (it.hasNext()) {
+        it.next();
+        QTreeWidgetItem* lexiconItem = new QTreeWidgetItem;
+        qint64 totalBytes = 0;
+        qint64 mappedBytes = 0;
+        foreach (const WordEngine::MemoryUsage& usage, it.value()) {
+            QStringList strings;
+            strings.append(usage.structure);
+            strings.append(QString::number((usage.bytes + 1023) / 1024));
+            strings.append(usage.mapped ? QString("Yes") : QString());
+            lexiconItem->addChild(new QTreeWidgetItem(strings));
+            totalBytes += usage.bytes;
+            if (usage.mapped)
+                mappedBytes += usage.bytes;
+        }
+
+        lexiconItem->setText(0, it.key());
+        lexiconItem->setText(1, QString::number((totalBytes + 1023) / 1024));
+        if (mappedBytes) {
+            lexiconItem->setText(2,
+                QString::number((mappedBytes + 1023) / 1024) + " KB");
+        }
+        memoryTree->addTopLevelItem(lexiconItem);
+    }
+
+    memoryTree->expandAll();
+    for (int i = 0; i < memoryTree->columnCount(); ++i)
+        memoryTree->resizeColumnToContents(i);
+}
@@ -27,12 +27,22 @@
 
 #include <QDialog>
 
+class QTreeWidget;
+class WordEngine;
+
 class AboutDialog : public QDialog
 {
     Q_OBJECT
     public:
-    AboutDialog(QWidget* parent = 0, Qt::WFlags f = 0);
+    AboutDialog(WordEngine* e, QWidget* parent = 0, Qt::WFlags f = 0);
     ~AboutDialog();
+
+    public slots:
+    void updateMemoryReport();
+
+    private:
+    WordEngine* engine;
+    QTreeWidget* memoryTree;
 };
 
 #endif // ZYZZYVA_ABOUT_DIALOG_H
@@ -23,7 +23,9 @@
 //---------------------------------------------------------------------------
 
 #include "AnalyzeQuizDialog.h"
+#include "Auxil.h"
 #include "Defs.h"
+#include "LatencyStats.h"
 #include "MainSettings.h"
 #include "QuizEngine.h"
 #include "QuizSpec.h"
@@ -32,13 +34,17 @@
 #include "WordTableView.h"
 #include "ZPushButton.h"
 #include <QApplication>
+#include <QFileDialog>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QMessageBox>
+#include <QTimer>
 #include <QVBoxLayout>
 
 const QString DIALOG_CAPTION = "Analyze Quiz";
 const QString MISSED_LABEL_PREFIX = "Missed : ";
 const QString INCORRECT_LABEL_PREFIX = "Incorrect : ";
+const QString LATENCY_LABEL_PREFIX = "Response time : ";
 
 using namespace Defs;
 
@@ -52,7 +58,8 @@ using namespace Defs;
 //---------------------------------------------------------------------------
 AnalyzeQuizDialog::AnalyzeQuizDialog(QuizEngine* qe, WordEngine* we, QWidget*
                                      parent, Qt::WFlags f)
-    : QDialog(parent, f), quizEngine(qe), wordEngine(we)
+    : QDialog(parent, f), quizEngine(qe), wordEngine(we),
+    moveScheduled(false), latencyStats(0)
 {
     QVBoxLayout* mainVlay = new QVBoxLayout(this);
     mainVlay->setMargin(MARGIN);
@@ -106,8 +113,18 @@ AnalyzeQuizDialog::AnalyzeQuizDialog(QuizEngine* qe, WordEngine* we, QWidget*
     buttonHlay->setSpacing(SPACING);
     mainVlay->addLayout(buttonHlay);
 
+    latencyLabel = new QLabel;
+    buttonHlay->addWidget(latencyLabel);
+
     buttonHlay->addStretch(1);
 
+    exportLatencyButton = new ZPushButton("&Export Times...", this);
+    exportLatencyButton->setSizePolicy(QSizePolicy::Fixed,
+                                       QSizePolicy::Fixed);
+    connect(exportLatencyButton, SIGNAL(clicked()),
+            SLOT(exportLatencyClicked()));
+    buttonHlay->addWidget(exportLatencyButton);
+
     closeButton = new ZPushButton("&Close", this);
     closeButton->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     closeButton->setAutoDefault(true);
@@ -117,10 +134,26 @@ AnalyzeQuizDialog::AnalyzeQuizDialog(QuizEngine* qe, WordEngine* we, QWidget*
     resize(700, 500);
     setWindowTitle(DIALOG_CAPTION);
     updateStats();
+    updateLatency();
 
     closeButton->setFocus();
 }
 
+//---------------------------------------------------------------------------
+//  setResponseLatency
+//
+//! Set the response times shown by the dialog.  The times are owned by the
+//! caller, which calls updateLatency when they change.
+//
+//! @param stats the response times
+//---------------------------------------------------------------------------
+void
+AnalyzeQuizDialog::setResponseLatency(const LatencyStats* stats)
+{
+    latencyStats = stats;
+    updateLatency();
+}
+
 //---------------------------------------------------------------------------
 //  newQuiz
 //
@@ -129,7 +162,8 @@ AnalyzeQuizDialog::AnalyzeQuizDialog(QuizEngine* qe, WordEngine* we, QWidget*
 void
 AnalyzeQuizDialog::newQuiz(const QuizSpec& spec)
 {
-    questionLabel->setText(spec.asString());
+    quizDescription = spec.asString();
+    questionLabel->setText(quizDescription);
     missedModel->setLexicon(spec.getLexicon());
     incorrectModel->setLexicon(spec.getLexicon());
     clearMissed();
@@ -139,6 +173,7 @@ AnalyzeQuizDialog::newQuiz(const QuizSpec& spec)
     QuizProgress progress = spec.getProgress();
     addMissed(progress.getMissed().keys(), false);
     addIncorrect(progress.getIncorrect().keys(), false);
+    updateLatency();
 }
 
 //---------------------------------------------------------------------------
@@ -152,13 +187,13 @@ AnalyzeQuizDialog::updateStats()
     int correct = quizEngine->getQuizCorrect();
     setRecall(correct, quizEngine->getQuizTotal());
     setPrecision(correct, correct + quizEngine->getQuizIncorrect());
-    int missed = missedModel->rowCount();
+    int missed = missedWords.size();
     QString missedText = MISSED_LABEL_PREFIX + QString::number(missed) +
         " word";
     if (missed != 1)
         missedText += "s";
     missedLabel->setText(missedText);
-    int incorrect = incorrectModel->rowCount();
+    int incorrect = incorrectWords.size();
     QString incorrectText = INCORRECT_LABEL_PREFIX +
         QString::number(incorrect) + " word";
     if (incorrect != 1)
@@ -166,6 +201,42 @@ AnalyzeQuizDialog::updateStats()
     incorrectLabel->setText(incorrectText);
 }
 
+//---------------------------------------------------------------------------
+//  updateLatency
+//
+//! Update the response time percentiles, if the dialog is visible.
+//! Otherwise they are updated when the dialog is shown.
+//---------------------------------------------------------------------------
+void
+AnalyzeQuizDialog::updateLatency()
+{
+    int numSamples = latencyStats ? latencyStats->getNumSamples() : 0;
+    exportLatencyButton->setEnabled(numSamples > 0);
+    if (!isVisible())
+        return;
+
+    if (!numSamples) {
+        latencyLabel->setText(LATENCY_LABEL_PREFIX + "no responses");
+        return;
+    }
+
+    QString text = LATENCY_LABEL_PREFIX;
+    const int percentiles[] = { 50, 90, 99 };
+    for (int i = 0; i < 3; ++i) {
+        qint64 nsecs = latencyStats->getPercentile(LatencyStats::TotalStage,
+                                                   percentiles[i]);
+        if (i)
+            text += ", ";
+        text += "P" + QString::number(percentiles[i]) + " " +
+            QString::number(nsecs / 1000000.0, 'f', 1) + " ms";
+    }
+    text += " (" + QString::number(numSamples) + " response";
+    if (numSamples != 1)
+        text += "s";
+    text += ")";
+    latencyLabel->setText(text);
+}
+
 //---------------------------------------------------------------------------
 //  addMissed
 //
@@ -177,10 +248,11 @@ AnalyzeQuizDialog::updateStats()
 void
 AnalyzeQuizDialog::addMissed(const QString& word, bool update)
 {
-    missedCache.insert(word);
-
-    if (isVisible())
-        moveCache();
+    if (!missedWords.contains(word)) {
+        missedWords.insert(word);
+        missedCache.insert(word);
+        scheduleMoveCache();
+    }
 
     if (update)
         updateStats();
@@ -200,10 +272,13 @@ AnalyzeQuizDialog::addMissed(const QStringList& words, bool update)
     if (words.empty())
         return;
 
-    missedCache += words.toSet();
-
-    if (isVisible())
-        moveCache();
+    foreach (const QString& word, words) {
+        if (missedWords.contains(word))
+            continue;
+        missedWords.insert(word);
+        missedCache.insert(word);
+    }
+    scheduleMoveCache();
 
     if (update)
         updateStats();
@@ -220,7 +295,7 @@ AnalyzeQuizDialog::addMissed(const QStringList& words, bool update)
 void
 AnalyzeQuizDialog::removeMissed(const QString& word, bool update)
 {
-    if (!missedCache.remove(word))
+    if (missedWords.remove(word) && !missedCache.remove(word))
         missedModel->removeWord(word);
 
     if (update)
@@ -238,10 +313,11 @@ AnalyzeQuizDialog::removeMissed(const QString& word, bool update)
 void
 AnalyzeQuizDialog::addIncorrect(const QString& word, bool update)
 {
-    incorrectCache.insert(word);
-
-    if (isVisible())
-        moveCache();
+    if (!incorrectWords.contains(word)) {
+        incorrectWords.insert(word);
+        incorrectCache.insert(word);
+        scheduleMoveCache();
+    }
 
     if (update)
         updateStats();
@@ -261,10 +337,13 @@ AnalyzeQuizDialog::addIncorrect(const QStringList& words, bool update)
     if (words.empty())
         return;
 
-    incorrectCache += words.toSet();
-
-    if (isVisible())
-        moveCache();
+    foreach (const QString& word, words) {
+        if (incorrectWords.contains(word))
+            continue;
+        incorrectWords.insert(word);
+        incorrectCache.insert(word);
+    }
+    scheduleMoveCache();
 
     if (update)
         updateStats();
@@ -281,7 +360,7 @@ AnalyzeQuizDialog::addIncorrect(const QStringList& words, bool update)
 void
 AnalyzeQuizDialog::removeIncorrect(const QString& word, bool update)
 {
-    if (!incorrectCache.remove(word))
+    if (incorrectWords.remove(word) && !incorrectCache.remove(word))
         incorrectModel->removeWord(word);
 
     if (update)
@@ -296,6 +375,7 @@ AnalyzeQuizDialog::removeIncorrect(const QString& word, bool update)
 void
 AnalyzeQuizDialog::clearMissed()
 {
+    missedWords.clear();
     missedCache.clear();
     missedModel->clear();
 }
@@ -308,6 +388,7 @@ AnalyzeQuizDialog::clearMissed()
 void
 AnalyzeQuizDialog::clearIncorrect()
 {
+    incorrectWords.clear();
     incorrectCache.clear();
     incorrectModel->clear();
 }
@@ -322,6 +403,33 @@ AnalyzeQuizDialog::showEvent(QShowEvent*)
 {
     moveCache();
     updateStats();
+    updateLatency();
+}
+
+//---------------------------------------------------------------------------
+//  exportLatencyClicked
+//
+//! Called when the Export Times button is clicked.  Save the response
+//! times of the quiz to a file.
+//---------------------------------------------------------------------------
+void
+AnalyzeQuizDialog::exportLatencyClicked()
+{
+    if (!latencyStats)
+        return;
+
+    QString filename = QFileDialog::getSaveFileName(this,
+        "Export Response Times", Auxil::getUserDir() + "/response-times.txt",
+        "Text Files (*.txt)");
+    if (filename.isEmpty())
+        return;
+
+    QString errString;
+    if (!latencyStats->writeFile(filename, quizDescription, &errString)) {
+        QMessageBox::warning(this, "Cannot Export Response Times",
+                             "Cannot export the response times:\n" +
+                             errString);
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -370,14 +478,37 @@ AnalyzeQuizDialog::percentString(int numerator, int denominator) const
         + " (" + QString::number(pct, 'f', 1) + "%)";
 }
 
+//---------------------------------------------------------------------------
+//  scheduleMoveCache
+//
+//! Move the words in the caches to the word lists once control returns to
+//! the event loop, if the dialog is visible, so the words added by a burst
+//! of changes are added to the lists together.  Otherwise the words are
+//! moved when the dialog is shown.
+//---------------------------------------------------------------------------
+void
+AnalyzeQuizDialog::scheduleMoveCache()
+{
+    if (moveScheduled || !isVisible())
+        return;
+    moveScheduled = true;
+    QTimer::singleShot(0, this, SLOT(moveCache()));
+}
+
 //---------------------------------------------------------------------------
 //  moveCache
 //
 //! Move the words in the incorrect and missed caches to the word lists.
+//! The words are added to each list in one batch, which the list sorts and
+//! merges with the words already in it.
 //---------------------------------------------------------------------------
 void
 AnalyzeQuizDialog::moveCache()
 {
+    moveScheduled = false;
+    if (missedCache.isEmpty() && incorrectCache.isEmpty())
+        return;
+
     // FIXME: Probably not the right way to get alphabetical sorting
     // instead of alphagram sorting
     QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
@@ -386,21 +517,25 @@ AnalyzeQuizDialog::moveCache()
 
     // Move missed cache to word list
     QList<WordTableModel::WordItem> wordItems;
-    foreach (const QString& word, missedCache) {
-        wordItems.append(
-            WordTableModel::WordItem(word, WordTableModel::WordMissed));
+    if (!missedCache.isEmpty()) {
+        foreach (const QString& word, missedCache) {
+            wordItems.append(
+                WordTableModel::WordItem(word, WordTableModel::WordMissed));
+        }
+        missedModel->addWords(wordItems);
+        missedCache.clear();
     }
-    missedModel->addWords(wordItems);
-    missedCache.clear();
 
     // Move incorrect cache to word list
-    wordItems.clear();
-    foreach (const QString& word, incorrectCache) {
-        wordItems.append(
-            WordTableModel::WordItem(word, WordTableModel::WordIncorrect));
+    if (!incorrectCache.isEmpty()) {
+        wordItems.clear();
+        foreach (const QString& word, incorrectCache) {
+            wordItems.append(WordTableModel::WordItem(word,
+                WordTableModel::WordIncorrect));
+        }
+        incorrectModel->addWords(wordItems);
+        incorrectCache.clear();
     }
-    incorrectModel->addWords(wordItems);
-    incorrectCache.clear();
 
     MainSettings::setWordListGroupByAnagrams(origGroupByAnagrams);
     QApplication::restoreOverrideCursor();
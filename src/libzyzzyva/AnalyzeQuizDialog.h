@@ -31,6 +31,7 @@
 #include <QShowEvent>
 #include "MatchType.h"
 
+class LatencyStats;
 class QuizEngine;
 class QuizSpec;
 class WordEngine;
@@ -47,6 +48,8 @@ class AnalyzeQuizDialog : public QDialog
 
     ~AnalyzeQuizDialog() { }
 
+    void setResponseLatency(const LatencyStats* stats);
+
     public slots:
     void newQuiz(const QuizSpec& spec);
     void updateStats();
@@ -58,15 +61,20 @@ class AnalyzeQuizDialog : public QDialog
     void removeIncorrect(const QString& word, bool update = true);
     void clearMissed();
     void clearIncorrect();
+    void updateLatency();
 
     protected slots:
     virtual void showEvent(QShowEvent* event);
 
+    private slots:
+    void moveCache();
+    void exportLatencyClicked();
+
     private:
     void setRecall(int correct, int total);
     void setPrecision(int correct, int total);
     QString percentString(int numerator, int denominator) const;
-    void moveCache();
+    void scheduleMoveCache();
 
     private:
     QuizEngine* quizEngine;
@@ -80,10 +88,21 @@ class AnalyzeQuizDialog : public QDialog
     WordTableModel* missedModel;
     WordTableView*  incorrectView;
     WordTableModel* incorrectModel;
+    QLabel*     latencyLabel;
+    ZPushButton*  exportLatencyButton;
     ZPushButton*  closeButton;
 
+    // Every missed and incorrect word, whether in the models or still in
+    // the caches waiting to be moved to them
+    QSet<QString> missedWords;
+    QSet<QString> incorrectWords;
     QSet<QString> missedCache;
     QSet<QString> incorrectCache;
+    bool moveScheduled;
+
+    // The response times of the quiz, collected by the quiz form
+    const LatencyStats* latencyStats;
+    QString quizDescription;
 };
 
 #endif // ZYZZYVA_ANALYZE_QUIZ_DIALOG_H
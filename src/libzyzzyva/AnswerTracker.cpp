@@ -0,0 +1,138 @@
+//---------------------------------------------------------------------------
+// AnswerTracker.cpp
+//
+// A class for keeping track of the answers given to a quiz question.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "AnswerTracker.h"
+#include <QSet>
+
+//---------------------------------------------------------------------------
+//  setAnswers
+//
+//! Set the answers, none of which have been given.
+//
+//! @param words the answers, which may contain duplicates
+//---------------------------------------------------------------------------
+void
+AnswerTracker::setAnswers(const QStringList& words)
+{
+    answers = words.toSet().toList();
+    qSort(answers);
+
+    ids.clear();
+    ids.reserve(answers.size());
+    for (int i = 0; i < answers.size(); ++i)
+        ids.insert(answers[i], i);
+
+    answered.fill(false, answers.size());
+    numAnswered = 0;
+    missedValid = false;
+}
+
+//---------------------------------------------------------------------------
+//  clear
+//
+//! Remove all answers.
+//---------------------------------------------------------------------------
+void
+AnswerTracker::clear()
+{
+    setAnswers(QStringList());
+}
+
+//---------------------------------------------------------------------------
+//  clearAnswered
+//
+//! Mark every answer as not given.
+//---------------------------------------------------------------------------
+void
+AnswerTracker::clearAnswered()
+{
+    answered.fill(false);
+    numAnswered = 0;
+    missedValid = false;
+}
+
+//---------------------------------------------------------------------------
+//  markAnswered
+//
+//! Mark an answer as given.
+//
+//! @param word the answer
+//! @return true if the word is an answer that had not been given, false
+//! otherwise
+//---------------------------------------------------------------------------
+bool
+AnswerTracker::markAnswered(const QString& word)
+{
+    int id = getId(word);
+    if ((id < 0) || answered.testBit(id))
+        return false;
+
+    answered.setBit(id);
+    ++numAnswered;
+    missedValid = false;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  getAnswered
+//
+//! Get the answers that have been given.
+//
+//! @return the answers given, in alphabetical order
+//---------------------------------------------------------------------------
+QStringList
+AnswerTracker::getAnswered() const
+{
+    QStringList words;
+    if (!numAnswered)
+        return words;
+
+    for (int i = 0; i < answers.size(); ++i) {
+        if (answered.testBit(i))
+            words.append(answers[i]);
+    }
+    return words;
+}
+
+//---------------------------------------------------------------------------
+//  getMissed
+//
+//! Get the answers that have not been given.
+//
+//! @return the answers not given, in alphabetical order
+//---------------------------------------------------------------------------
+QStringList
+AnswerTracker::getMissed() const
+{
+    if (missedValid)
+        return missed;
+
+    missed.clear();
+    for (int i = 0; i < answers.size(); ++i) {
+        if (!answered.testBit(i))
+            missed.append(answers[i]);
+    }
+    missedValid = true;
+    return missed;
+}
@@ -0,0 +1,68 @@
+//---------------------------------------------------------------------------
+// AnswerTracker.h
+//
+// A class for keeping track of the answers given to a quiz question.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_ANSWER_TRACKER_H
+#define ZYZZYVA_ANSWER_TRACKER_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+// The answers to a quiz question, each identified by its index in the
+// sorted list of answers, with a bit for each answer telling whether it
+// has been given.  The list of answers not yet given is only built when it
+// is asked for, and kept until another answer is given, so questions with
+// thousands of answers, such as Word List Recall quizzes, can be answered
+// without touching every answer on every response.
+class AnswerTracker
+{
+    public:
+    AnswerTracker() : numAnswered(0), missedValid(false) { }
+    ~AnswerTracker() { }
+
+    void setAnswers(const QStringList& words);
+    void clear();
+    void clearAnswered();
+    bool markAnswered(const QString& word);
+
+    int getNumAnswers() const { return answers.size(); }
+    int getNumAnswered() const { return numAnswered; }
+    int getId(const QString& word) const { return ids.value(word, -1); }
+    QString getAnswer(int id) const { return answers.at(id); }
+    bool isAnswered(int id) const { return answered.testBit(id); }
+    QStringList getAnswers() const { return answers; }
+    QStringList getAnswered() const;
+    QStringList getMissed() const;
+
+    private:
+    QStringList answers;
+    QHash<QString, int> ids;
+    QBitArray answered;
+    int numAnswered;
+    mutable QStringList missed;
+    mutable bool missedValid;
+};
+
+#endif // ZYZZYVA_ANSWER_TRACKER_H
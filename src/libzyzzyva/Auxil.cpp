@@ -133,9 +133,57 @@ const QString WORD_LIST_FORMAT_ONE_PER_LINE = "One Word Per Line";
 const QString WORD_LIST_FORMAT_QUESTION_ANSWER = "Anagram Question/Answer";
 const QString WORD_LIST_FORMAT_TWO_COLUMN = "Anagram Two Column";
 const QString WORD_LIST_FORMAT_DISTINCT_ALPHAGRAMS = "Distinct Alphagrams";
+const QString WORD_LIST_FORMAT_WORD_IDS = "Word IDs (Binary)";
+
+// Number of letters from A to Z, the number of bits used for each letter of
+// a packed alphagram key, and the most letters a key can hold
+const int NUM_ASCII_LETTERS = 26;
+const int ALPHAGRAM_KEY_LETTER_BITS = 5;
+const int MAX_ALPHAGRAM_KEY_LETTERS = 12;
 
 using namespace Defs;
 
+//---------------------------------------------------------------------------
+//  countAsciiLetters
+//
+//! Count the letters of a word if they are all ASCII letters of the same
+//! case.  These letters sort the same way in every locale, so their
+//! alphagram can be built from the counts without sorting.
+//
+//! @param word the word
+//! @param counts returns the number of each letter, from A to Z
+//! @param base returns the first letter of the case of the word
+//! @return true if the letters were counted, false if the word has other
+//! characters or letters of both cases
+//---------------------------------------------------------------------------
+static bool
+countAsciiLetters(const QString& word, int* counts, ushort* base)
+{
+    int wordLength = word.length();
+    if (!wordLength)
+        return false;
+
+    const QChar* chars = word.unicode();
+    ushort first = chars[0].unicode();
+    if ((first >= 'A') && (first <= 'Z'))
+        *base = 'A';
+    else if ((first >= 'a') && (first <= 'z'))
+        *base = 'a';
+    else
+        return false;
+
+    for (int i = 0; i < NUM_ASCII_LETTERS; ++i)
+        counts[i] = 0;
+
+    for (int i = 0; i < wordLength; ++i) {
+        uint letter = uint(chars[i].unicode()) - *base;
+        if (letter >= uint(NUM_ASCII_LETTERS))
+            return false;
+        ++counts[letter];
+    }
+    return true;
+}
+
 //---------------------------------------------------------------------------
 //  localeAwareLessThanQString
 //
@@ -554,7 +602,10 @@ Auxil::isVowel(QChar c)
 //---------------------------------------------------------------------------
 //  getAlphagram
 //
-//! Transform a string into its alphagram.
+//! Transform a string into its alphagram.  Strings of ASCII letters of the
+//! same case are counted into place, and only other strings, like those
+//! with the digraph symbols of Spanish lexicons, are sorted in a
+//! locale-aware way.
 //
 //! @param word the word
 //! @return the alphagram
@@ -566,6 +617,19 @@ Auxil::getAlphagram(const QString& word)
     if (wordLength <= 1)
         return word;
 
+    int counts[NUM_ASCII_LETTERS];
+    ushort base = 0;
+    if (countAsciiLetters(word, counts, &base)) {
+        QString alphagram;
+        alphagram.resize(wordLength);
+        QChar* out = alphagram.data();
+        for (int i = 0; i < NUM_ASCII_LETTERS; ++i) {
+            for (int j = 0; j < counts[i]; ++j)
+                *out++ = QChar(ushort(base + i));
+        }
+        return alphagram;
+    }
+
     // Get characters
     QString alphagram;
     QList<QChar> chars;
@@ -598,6 +662,40 @@ Auxil::getAlphagram(const QString& word)
     //return QString(chars);
 }
 
+//---------------------------------------------------------------------------
+//  getAlphagramKey
+//
+//! Pack the alphagram of a word into an integer, for use as a hash or sort
+//! key.  Each letter takes five bits, from the most significant bits down,
+//! so keys sort in the same order as the alphagrams themselves.  Only
+//! words of up to twelve upper case letters from A to Z can be packed.
+//
+//! @param word the word
+//! @return the key, or 0 if the word cannot be packed
+//---------------------------------------------------------------------------
+quint64
+Auxil::getAlphagramKey(const QString& word)
+{
+    int wordLength = word.length();
+    if (wordLength > MAX_ALPHAGRAM_KEY_LETTERS)
+        return 0;
+
+    int counts[NUM_ASCII_LETTERS];
+    ushort base = 0;
+    if (!countAsciiLetters(word, counts, &base) || (base != 'A'))
+        return 0;
+
+    quint64 key = 0;
+    int shift = 64;
+    for (int i = 0; i < NUM_ASCII_LETTERS; ++i) {
+        for (int j = 0; j < counts[i]; ++j) {
+            shift -= ALPHAGRAM_KEY_LETTER_BITS;
+            key |= quint64(i + 1) << shift;
+        }
+    }
+    return key;
+}
+
 //---------------------------------------------------------------------------
 //  getCanonicalSearchString
 //
@@ -1256,6 +1354,9 @@ Auxil::wordListFormatToString(WordListFormat format)
         case WordListDistinctAlphagrams:
         return WORD_LIST_FORMAT_DISTINCT_ALPHAGRAMS;
 
+        case WordListWordIds:
+        return WORD_LIST_FORMAT_WORD_IDS;
+
         default: return QString();
     }
 }
@@ -1279,6 +1380,8 @@ Auxil::stringToWordListFormat(const QString& s)
         return WordListAnagramTwoColumn;
     else if (s == WORD_LIST_FORMAT_DISTINCT_ALPHAGRAMS)
         return WordListDistinctAlphagrams;
+    else if (s == WORD_LIST_FORMAT_WORD_IDS)
+        return WordListWordIds;
     else
         return WordListInvalid;
 }
@@ -55,6 +55,7 @@ namespace Auxil {
     QString wordWrap(const QString& str, int wrapLength);
     bool isVowel(QChar c);
     QString getAlphagram(const QString& word);
+    quint64 getAlphagramKey(const QString& word);
     QString getCanonicalSearchString(const QString& str);
     int getNumUniqueLetters(const QString& word);
     int getNumVowels(const QString& word);
@@ -0,0 +1,203 @@
+//---------------------------------------------------------------------------
+// BatchJudge.cpp
+//
+// A class for judging many words at once.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "BatchJudge.h"
+#include "WordEngine.h"
+#include <QByteArray>
+#include <QIODevice>
+
+// Number of words judged at once
+const int JUDGE_CHUNK_WORDS = 65536;
+
+// Number of bytes read from the input at once
+const qint64 JUDGE_READ_BYTES = 1024 * 1024;
+
+const char* VERDICT_ACCEPTABLE = "\tVALID\t";
+const char* VERDICT_UNACCEPTABLE = "\tINVALID\t";
+
+//---------------------------------------------------------------------------
+//  BatchJudge
+//
+//! Constructor.
+//
+//! @param e the word engine
+//! @param lex the lexicon to judge words against
+//! @param styles the lexicon styles whose symbols are given for acceptable
+//! words - styles of other lexicons, or whose compared lexicons are not
+//! loaded, are ignored
+//---------------------------------------------------------------------------
+BatchJudge::BatchJudge(WordEngine* e, const QString& lex, const
+                       QList<LexiconStyle>& styles)
+    : engine(e), lexicon(lex), numWords(0), numAcceptable(0)
+{
+    foreach (const LexiconStyle& style, styles) {
+        if ((style.lexicon != lexicon) ||
+            !engine->lexiconIsLoaded(style.compareLexicon))
+        {
+            continue;
+        }
+
+        lexStyles.append(style);
+        if (!compareLexicons.contains(style.compareLexicon))
+            compareLexicons.append(style.compareLexicon);
+        styleMasks.append(1U << compareLexicons.indexOf(style.compareLexicon));
+    }
+}
+
+//---------------------------------------------------------------------------
+//  judgeWords
+//
+//! Judge a list of words.
+//
+//! @param words the words, in upper case
+//! @param acceptable returns whether each word is acceptable
+//! @param symbols if not null, returns the lexicon symbols of each word,
+//! empty for unacceptable words
+//---------------------------------------------------------------------------
+void
+BatchJudge::judgeWords(const QStringList& words, QBitArray* acceptable,
+                       QStringList* symbols) const
+{
+    *acceptable = engine->areAcceptable(lexicon, words);
+    if (!symbols)
+        return;
+
+    symbols->clear();
+    if (lexStyles.isEmpty()) {
+        for (int i = 0; i < words.size(); ++i)
+            symbols->append(QString());
+        return;
+    }
+
+    QVector<quint32> membership =
+        engine->getLexiconMembership(compareLexicons, words);
+    for (int i = 0; i < words.size(); ++i) {
+        QString wordSymbols;
+        if (acceptable->testBit(i)) {
+            for (int j = 0; j < lexStyles.size(); ++j) {
+                bool inCompare = (membership[i] & styleMasks[j]);
+                if (inCompare == lexStyles[j].inCompareLexicon)
+                    wordSymbols += lexStyles[j].symbol;
+            }
+        }
+        symbols->append(wordSymbols);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  judgeStream
+//
+//! Judge the words read from a device, separated by white space, and write
+//! one line for each word: the word, VALID or INVALID, and the lexicon
+//! symbols of the word, separated by tabs.  Words are judged in upper case.
+//
+//! @param in the device to read words from
+//! @param out the device to write verdicts to
+//! @param errString returns the error string in case of error
+//! @return true if successful, false if the verdicts could not be written
+//---------------------------------------------------------------------------
+bool
+BatchJudge::judgeStream(QIODevice* in, QIODevice* out, QString* errString)
+{
+    QStringList words;
+    QByteArray partial;
+    bool atEnd = false;
+    while (!atEnd) {
+        QByteArray bytes = in->read(JUDGE_READ_BYTES);
+        atEnd = bytes.isEmpty();
+        if (!partial.isEmpty()) {
+            bytes.prepend(partial);
+            partial.clear();
+        }
+
+        // Split the input on white space, keeping a word cut off at the end
+        // of the bytes read for the next read
+        const char* data = bytes.constData();
+        int size = bytes.size();
+        int start = 0;
+        for (int i = 0; i <= size; ++i) {
+            bool space = (i == size) || (data[i] == ' ') ||
+                (data[i] == '\t') || (data[i] == '\n') || (data[i] == '\r');
+            if (!space)
+                continue;
+            if ((i == size) && !atEnd) {
+                partial = bytes.mid(start);
+                break;
+            }
+            if (i > start) {
+                words.append(QString::fromUtf8(data + start,
+                                               i - start).toUpper());
+            }
+            start = i + 1;
+        }
+
+        if ((words.size() >= JUDGE_CHUNK_WORDS) || atEnd) {
+            if (!writeVerdicts(words, out)) {
+                if (errString)
+                    *errString = out->errorString();
+                return false;
+            }
+            words.clear();
+        }
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  writeVerdicts
+//
+//! Judge a chunk of words and write the verdicts.
+//
+//! @param words the words, in upper case
+//! @param out the device to write verdicts to
+//! @return true if successful, false if the verdicts could not be written
+//---------------------------------------------------------------------------
+bool
+BatchJudge::writeVerdicts(const QStringList& words, QIODevice* out)
+{
+    if (words.isEmpty())
+        return true;
+
+    QBitArray acceptable;
+    QStringList symbols;
+    judgeWords(words, &acceptable, &symbols);
+
+    QByteArray verdicts;
+    verdicts.reserve(words.size() * 24);
+    for (int i = 0; i < words.size(); ++i) {
+        bool valid = acceptable.testBit(i);
+        verdicts += words[i].toUtf8();
+        if (valid) {
+            verdicts += VERDICT_ACCEPTABLE;
+            verdicts += symbols[i].toUtf8();
+            ++numAcceptable;
+        }
+        else
+            verdicts += VERDICT_UNACCEPTABLE;
+        verdicts += '\n';
+    }
+    numWords += words.size();
+    return (out->write(verdicts) == verdicts.size());
+}
@@ -0,0 +1,72 @@
+//---------------------------------------------------------------------------
+// BatchJudge.h
+//
+// A class for judging many words at once.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_BATCH_JUDGE_H
+#define ZYZZYVA_BATCH_JUDGE_H
+
+#include "LexiconStyle.h"
+#include <QBitArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QIODevice;
+class WordEngine;
+
+// Verdicts on many words against one lexicon, with the symbols of the
+// lexicon styles that apply to each acceptable word.  Words are judged a
+// chunk at a time, with one lookup of the whole chunk in each lexicon.
+class BatchJudge
+{
+    public:
+    BatchJudge(WordEngine* e, const QString& lex, const QList<LexiconStyle>&
+               styles = QList<LexiconStyle>());
+    ~BatchJudge() { }
+
+    void judgeWords(const QStringList& words, QBitArray* acceptable,
+                    QStringList* symbols = 0) const;
+    bool judgeStream(QIODevice* in, QIODevice* out, QString* errString = 0);
+    qint64 getNumWords() const { return numWords; }
+    qint64 getNumAcceptable() const { return numAcceptable; }
+
+    private:
+    bool writeVerdicts(const QStringList& words, QIODevice* out);
+
+    private:
+    WordEngine* engine;
+    QString lexicon;
+
+    // Lexicon styles of the lexicon whose compared lexicons are loaded, the
+    // compared lexicons, and the bit of each style's compared lexicon in
+    // the lexicon membership of a word
+    QList<LexiconStyle> lexStyles;
+    QStringList compareLexicons;
+    QVector<quint32> styleMasks;
+
+    qint64 numWords;
+    qint64 numAcceptable;
+};
+
+#endif // ZYZZYVA_BATCH_JUDGE_H
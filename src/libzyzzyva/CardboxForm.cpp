@@ -28,8 +28,8 @@
 #include "ZPushButton.h"
 #include "Auxil.h"
 #include "Defs.h"
-#include <QApplication>
 #include <QHBoxLayout>
+#include <QThread>
 #include <QVBoxLayout>
 
 using namespace Defs;
@@ -37,6 +37,40 @@ using namespace Defs;
 const QString TITLE_PREFIX = "Cardbox";
 const int REFRESH_MSECS = 120000;
 
+//---------------------------------------------------------------------------
+//  StatsThread
+//
+//! A thread that reads the cardbox statistics of a lexicon and quiz type
+//! through its own quiz database connection.
+//---------------------------------------------------------------------------
+class CardboxForm::StatsThread : public QThread
+{
+    public:
+    StatsThread(const QString& l, const QString& q)
+        : QThread(), lexicon(l), quizType(q) { }
+    ~StatsThread() { }
+
+    QString getLexicon() const { return lexicon; }
+    QString getQuizType() const { return quizType; }
+    CardboxStats getStats() const { return stats; }
+
+    protected:
+    void run() {
+        QuizStatsDatabase db (lexicon, quizType);
+        if (!db.isValid())
+            return;
+        stats.cardboxCounts = db.getCardboxCounts();
+        stats.dueCounts = db.getCardboxDueCounts();
+        stats.dayCounts = db.getScheduleDayCounts();
+        stats.valid = true;
+    }
+
+    private:
+    QString lexicon;
+    QString quizType;
+    CardboxStats stats;
+};
+
 //---------------------------------------------------------------------------
 //  CardboxForm
 //
@@ -46,7 +80,8 @@ const int REFRESH_MSECS = 120000;
 //! @param f widget flags
 //---------------------------------------------------------------------------
 CardboxForm::CardboxForm(WordEngine* e, QWidget* parent, Qt::WFlags f)
-    : ActionForm(CardboxFormType, parent, f), wordEngine(e)
+    : ActionForm(CardboxFormType, parent, f), wordEngine(e),
+      statsThread(0), refreshPending(false)
     //cardboxCountModel(0), cardboxDaysModel(0), cardboxContentsModel(0)
 {
     QVBoxLayout* mainVlay = new QVBoxLayout(this);
@@ -169,6 +204,19 @@ CardboxForm::CardboxForm(WordEngine* e, QWidget* parent, Qt::WFlags f)
     refreshClicked();
 }
 
+//---------------------------------------------------------------------------
+//  ~CardboxForm
+//
+//! Destructor.  Wait for the statistics thread to finish.
+//---------------------------------------------------------------------------
+CardboxForm::~CardboxForm()
+{
+    if (statsThread) {
+        statsThread->wait();
+        delete statsThread;
+    }
+}
+
 //---------------------------------------------------------------------------
 //  getIcon
 //
@@ -237,25 +285,78 @@ CardboxForm::lexiconActivated(const QString& lexicon)
 //---------------------------------------------------------------------------
 //  refreshClicked
 //
-//! Called when the Refresh button is clicked.
+//! Called when the Refresh button is clicked.  The last statistics read for
+//! the lexicon and quiz type are displayed right away, and fresh statistics
+//! are read in the background.
 //---------------------------------------------------------------------------
 void
 CardboxForm::refreshClicked()
 {
     QString lexicon = lexiconWidget->getCurrentLexicon();
     QString quizType = quizTypeCombo->currentText();
-    QuizStatsDatabase db (lexicon, quizType);
-    if (!db.isValid()) {
-        // FIXME: pop up a warning
+    QString key = lexicon + "/" + quizType;
+    if (lastStats.contains(key))
+        displayStats(lastStats[key]);
+
+    // Only one thread reads statistics at a time, so refresh again when
+    // the current one finishes
+    if (statsThread) {
+        refreshPending = true;
+        return;
+    }
+
+    statsThread = new StatsThread(lexicon, quizType);
+    connect(statsThread, SIGNAL(finished()), SLOT(statsThreadFinished()));
+    statsThread->start();
+}
+
+//---------------------------------------------------------------------------
+//  statsThreadFinished
+//
+//! Called when the statistics thread finishes.  Display the statistics it
+//! read if they are for the current lexicon and quiz type, and keep them
+//! to display the next time they are refreshed.
+//---------------------------------------------------------------------------
+void
+CardboxForm::statsThreadFinished()
+{
+    if (!statsThread)
         return;
+
+    statsThread->wait();
+    CardboxStats stats = statsThread->getStats();
+    QString key = statsThread->getLexicon() + "/" +
+        statsThread->getQuizType();
+    delete statsThread;
+    statsThread = 0;
+
+    if (stats.valid) {
+        lastStats.insert(key, stats);
+        if (key == lexiconWidget->getCurrentLexicon() + "/" +
+            quizTypeCombo->currentText())
+        {
+            displayStats(stats);
+        }
     }
 
-    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    if (refreshPending) {
+        refreshPending = false;
+        refreshClicked();
+    }
+}
 
+//---------------------------------------------------------------------------
+//  displayStats
+//
+//! Display cardbox statistics.
+//
+//! @param stats the statistics
+//---------------------------------------------------------------------------
+void
+CardboxForm::displayStats(const CardboxStats& stats)
+{
     cardboxCountTree->clear();
-    QMap<int, int> cardboxCounts = db.getCardboxCounts();
-    QMap<int, int> cardboxDueCounts = db.getCardboxDueCounts();
-    QMapIterator<int, int> it (cardboxCounts);
+    QMapIterator<int, int> it (stats.cardboxCounts);
     while (it.hasNext()) {
         it.next();
         int cardbox = it.key();
@@ -263,13 +364,12 @@ CardboxForm::refreshClicked()
         QStringList strings;
         strings.append(QString("Cardbox %1").arg(QString::number(cardbox)));
         strings.append(QString::number(it.value()));
-        strings.append(QString::number(cardboxDueCounts.value(cardbox)));
+        strings.append(QString::number(stats.dueCounts.value(cardbox)));
         cardboxCountTree->addTopLevelItem(new QTreeWidgetItem(strings));
     }
 
     cardboxDaysTree->clear();
-    QMap<int, int> dayCounts = db.getScheduleDayCounts();
-    QMapIterator<int, int> jt (dayCounts);
+    QMapIterator<int, int> jt (stats.dayCounts);
     while (jt.hasNext()) {
         jt.next();
 
@@ -345,8 +445,6 @@ CardboxForm::refreshClicked()
     //cardboxContentsModel->setHeaderData(3, Qt::Horizontal, "Incorrect");
     //cardboxContentsModel->setHeaderData(4, Qt::Horizontal, "Streak");
     //cardboxContentsModel->setHeaderData(5, Qt::Horizontal, "Next Scheduled");
-
-    QApplication::restoreOverrideCursor();
 }
 
 //---------------------------------------------------------------------------
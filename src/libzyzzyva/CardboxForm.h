@@ -29,6 +29,7 @@
 #include <QComboBox>
 #include <QLabel>
 #include <QLineEdit>
+#include <QMap>
 #include <QSqlQueryModel>
 #include <QTimer>
 #include <QTreeWidget>
@@ -41,6 +42,7 @@ class CardboxForm : public ActionForm
     Q_OBJECT
     public:
     CardboxForm(WordEngine* e, QWidget* parent = 0, Qt::WFlags f = 0);
+    ~CardboxForm();
     QIcon getIcon() const;
     QString getTitle() const;
     QString getStatusString() const;
@@ -51,6 +53,27 @@ class CardboxForm : public ActionForm
     void refreshClicked();
     void questionDataClicked();
 
+    private slots:
+    void statsThreadFinished();
+
+    private:
+    // Cardbox statistics of a lexicon and quiz type
+    class CardboxStats {
+        public:
+        CardboxStats() : valid(false) { }
+        bool valid;
+        QMap<int, int> cardboxCounts;
+        QMap<int, int> dueCounts;
+        QMap<int, int> dayCounts;
+    };
+
+    // Thread reading cardbox statistics in the background, through its own
+    // quiz database connection
+    class StatsThread;
+
+    private:
+    void displayStats(const CardboxStats& stats);
+
     private:
     WordEngine*     wordEngine;
     //QuizStatsDatabase*   quizDatabase;
@@ -69,6 +92,13 @@ class CardboxForm : public ActionForm
 
     //QTimer refreshTimer;
     QString detailsString;
+
+    StatsThread* statsThread;
+    bool refreshPending;
+
+    // The last statistics read for each lexicon and quiz type, displayed
+    // while fresh statistics are read
+    QMap<QString, CardboxStats> lastStats;
 };
 
 #endif // ZYZZYVA_CARDBOX_FORM_H
@@ -0,0 +1,149 @@
+//---------------------------------------------------------------------------
+// CardboxScheduler.cpp
+//
+// A class for keeping track of the cardbox questions ready for review.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "CardboxScheduler.h"
+#include "QuizStatsDatabase.h"
+
+//---------------------------------------------------------------------------
+//  clear
+//
+//! Remove all questions.
+//---------------------------------------------------------------------------
+void
+CardboxScheduler::clear()
+{
+    selectAll = true;
+    zeroFirst = false;
+    nextSeq = 0;
+    candidates.clear();
+    schedule.clear();
+    questionKeys.clear();
+}
+
+//---------------------------------------------------------------------------
+//  load
+//
+//! Read the schedule of the candidate questions of a quiz from a database.
+//
+//! @param db the database
+//! @param questions the candidate questions, or empty if every question in
+//! the cardbox system is a candidate
+//! @param zeroFirstOrder whether to put cardbox 0 questions before all
+//! others
+//---------------------------------------------------------------------------
+void
+CardboxScheduler::load(QuizStatsDatabase* db, const QStringList& questions,
+                       bool zeroFirstOrder)
+{
+    clear();
+    selectAll = questions.isEmpty();
+    zeroFirst = zeroFirstOrder;
+    if (!selectAll)
+        candidates = questions.toSet();
+
+    QMap<QString, QuizStatsDatabase::QuestionData> scheduled =
+        db->getScheduledQuestions();
+    QMapIterator<QString, QuizStatsDatabase::QuestionData> it (scheduled);
+    while (it.hasNext()) {
+        it.next();
+        setSchedule(it.key(), it.value().cardbox,
+                    it.value().nextScheduled);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  setSchedule
+//
+//! Set the cardbox and next scheduled time of a question, after a response
+//! to it is recorded or it is moved to another cardbox.  Questions that
+//! are not candidates are ignored.
+//
+//! @param question the question
+//! @param cardbox the cardbox, or less than zero if the question is not in
+//! the cardbox system
+//! @param nextScheduled the next scheduled time
+//---------------------------------------------------------------------------
+void
+CardboxScheduler::setSchedule(const QString& question, int cardbox,
+                              unsigned int nextScheduled)
+{
+    if (!selectAll && !candidates.contains(question))
+        return;
+
+    QHash<QString, Key>::iterator found = questionKeys.find(question);
+    if (found != questionKeys.end()) {
+        schedule.remove(found.value());
+        questionKeys.erase(found);
+    }
+
+    if (cardbox < 0)
+        return;
+
+    Key key (zeroFirst && (cardbox == 0), nextScheduled, nextSeq++);
+    schedule.insert(key, question);
+    questionKeys.insert(question, key);
+}
+
+//---------------------------------------------------------------------------
+//  getNextReady
+//
+//! Get the first question in scheduled order that is ready for review.
+//
+//! @param now the current time
+//! @param exclude a question to pass over, such as the current question
+//! @return the question, or a null string if no question is ready
+//---------------------------------------------------------------------------
+QString
+CardboxScheduler::getNextReady(unsigned int now, const QString& exclude)
+    const
+{
+    QMap<Key, QString>::const_iterator it = schedule.begin();
+    if ((it != schedule.end()) && (it.value() == exclude))
+        ++it;
+    if ((it == schedule.end()) || !isReady(it.key(), now))
+        return QString();
+    return it.value();
+}
+
+//---------------------------------------------------------------------------
+//  getNumReady
+//
+//! Count the questions that are ready for review.  Ready questions come
+//! first in scheduled order, so only they are visited.
+//
+//! @param now the current time
+//! @param exclude a question not to count, such as the current question
+//! @return the number of questions
+//---------------------------------------------------------------------------
+int
+CardboxScheduler::getNumReady(unsigned int now, const QString& exclude) const
+{
+    int numReady = 0;
+    QMap<Key, QString>::const_iterator it = schedule.begin();
+    for (; (it != schedule.end()) && isReady(it.key(), now); ++it) {
+        if (it.value() != exclude)
+            ++numReady;
+    }
+    return numReady;
+}
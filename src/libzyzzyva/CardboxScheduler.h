@@ -0,0 +1,88 @@
+//---------------------------------------------------------------------------
+// CardboxScheduler.h
+//
+// A class for keeping track of the cardbox questions ready for review.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_CARDBOX_SCHEDULER_H
+#define ZYZZYVA_CARDBOX_SCHEDULER_H
+
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class QuizStatsDatabase;
+
+// The candidate questions of a cardbox quiz in scheduled order, read from
+// the database once when the quiz starts and updated as each response is
+// recorded.  Questions scheduled later than now stay in the schedule, so
+// they become ready as time passes without reading the database again.
+class CardboxScheduler
+{
+    public:
+    CardboxScheduler() : selectAll(true), zeroFirst(false), nextSeq(0) { }
+    ~CardboxScheduler() { }
+
+    void clear();
+    void load(QuizStatsDatabase* db, const QStringList& questions,
+              bool zeroFirstOrder);
+    void setSchedule(const QString& question, int cardbox,
+                     unsigned int nextScheduled);
+    QString getNextReady(unsigned int now, const QString& exclude) const;
+    int getNumReady(unsigned int now, const QString& exclude) const;
+    bool isEmpty() const { return schedule.isEmpty(); }
+
+    private:
+    // Sort key of a question: cardbox 0 questions first if they come
+    // first, then by next scheduled time, then by the order in which the
+    // questions were scheduled
+    class Key {
+        public:
+        Key(bool z = false, unsigned int t = 0, int s = 0)
+            : zero(z), time(t), seq(s) { }
+        bool operator<(const Key& other) const {
+            if (zero != other.zero)
+                return zero;
+            if (time != other.time)
+                return time < other.time;
+            return seq < other.seq;
+        }
+
+        bool zero;
+        unsigned int time;
+        int seq;
+    };
+
+    bool isReady(const Key& key, unsigned int now) const {
+        return key.zero || (key.time <= now); }
+
+    private:
+    bool selectAll;
+    bool zeroFirst;
+    int nextSeq;
+    QSet<QString> candidates;
+    QMap<Key, QString> schedule;
+    QHash<QString, Key> questionKeys;
+};
+
+#endif // ZYZZYVA_CARDBOX_SCHEDULER_H
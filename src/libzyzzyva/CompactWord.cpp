@@ -0,0 +1,60 @@
+//---------------------------------------------------------------------------
+// CompactWord.cpp
+//
+// A class for holding words compactly, one byte per letter.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "CompactWord.h"
+
+//---------------------------------------------------------------------------
+//  CompactWord
+//
+//! Constructor.  Hold the letters of a string, or make a null word if the
+//! string has a character outside Latin-1.
+//
+//! @param word the string
+//---------------------------------------------------------------------------
+CompactWord::CompactWord(const QString& word)
+{
+    int length = word.length();
+    const QChar* chars = word.unicode();
+    for (int i = 0; i < length; ++i) {
+        if (chars[i].unicode() > 0xFF)
+            return;
+    }
+    bytes = word.toLatin1();
+}
+
+//---------------------------------------------------------------------------
+//  withoutLetter
+//
+//! Get the word with one of its letters removed.
+//
+//! @param index the index of the letter to remove
+//! @return the word without the letter
+//---------------------------------------------------------------------------
+CompactWord
+CompactWord::withoutLetter(int index) const
+{
+    QByteArray removed = bytes;
+    removed.remove(index, 1);
+    return fromBytes(removed);
+}
@@ -0,0 +1,74 @@
+//---------------------------------------------------------------------------
+// CompactWord.h
+//
+// A class for holding words compactly, one byte per letter.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_COMPACT_WORD_H
+#define ZYZZYVA_COMPACT_WORD_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+// A word held as one byte per letter, for containers holding many words.
+// Each letter is held as its Latin-1 code, which covers the letters of
+// every lexicon, including the N with tilde of Spanish lexicons, whose
+// digraphs are spelled with two letters.  Words compare in the same order
+// as the strings they are made from, at half the size.  A string with a
+// character outside Latin-1 cannot be held, and makes a null word.
+class CompactWord
+{
+    public:
+    CompactWord() { }
+    explicit CompactWord(const QString& word);
+    ~CompactWord() { }
+
+    bool isNull() const { return bytes.isNull(); }
+    bool isEmpty() const { return bytes.isEmpty(); }
+    int length() const { return bytes.size(); }
+    const QByteArray& getBytes() const { return bytes; }
+    QString toString() const { return QString::fromLatin1(bytes); }
+    CompactWord withoutLetter(int index) const;
+
+    bool operator==(const CompactWord& other) const {
+        return bytes == other.bytes; }
+    bool operator!=(const CompactWord& other) const {
+        return bytes != other.bytes; }
+    bool operator<(const CompactWord& other) const {
+        return bytes < other.bytes; }
+
+    static CompactWord fromBytes(const QByteArray& b) {
+        CompactWord word;
+        word.bytes = b;
+        return word;
+    }
+
+    private:
+    QByteArray bytes;
+};
+
+inline uint qHash(const CompactWord& word)
+{
+    return qHash(word.getBytes());
+}
+
+#endif // ZYZZYVA_COMPACT_WORD_H
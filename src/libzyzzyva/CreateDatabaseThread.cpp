@@ -23,16 +23,48 @@
 //---------------------------------------------------------------------------
 
 #include "CreateDatabaseThread.h"
+#include "DatabaseIndexSet.h"
 #include "LetterBag.h"
 #include "MainSettings.h"
+#include "PlayabilityTable.h"
+#include "SearchStats.h"
 #include "WordEngine.h"
+#include "WordFeatures.h"
 #include "Auxil.h"
 #include "Defs.h"
 #include <QtSql>
+#include <QDateTime>
+#include <QDir>
+#include <QTextStream>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QSet>
+#include <QWaitCondition>
 
 const int MAX_DEFINITION_LINKS = 3;
 const int PROGRESS_STEP = 1000;
+const int FEATURE_BLOCKS_PER_THREAD = 4;
+const int NUM_HOOK_LETTERS = 26;
+const int NUM_ORDERS = 4;
+const int MAX_UPDATE_CHANGED_PERCENT = 10;
 const QString DB_CONNECTION_NAME = "CreateDatabaseThread";
+const QString SNAPSHOT_CONNECTION_NAME = "CreateDatabaseThread_snapshot";
+const QString BUILD_FILE_SUFFIX = ".build";
+const QString BUILD_LOG_FILENAME = "database-build.log";
+static QMutex buildLogMutex;
+const int BULK_BUILD_CACHE_PAGES = 65536;
+const int MAX_QUERY_VARIABLES = 999;
+const int NUM_INSERT_COLUMNS = 29;
+const int INSERT_ROWS_PER_QUERY = MAX_QUERY_VARIABLES / NUM_INSERT_COLUMNS;
+const QString INSERT_WORDS_PREFIX = "INSERT INTO words (word, length, "
+    "playability, playability_order, min_playability_order, "
+    "max_playability_order, combinations0, probability_order0, "
+    "min_probability_order0, max_probability_order0, combinations1, "
+    "probability_order1, min_probability_order1, max_probability_order1, "
+    "combinations2, probability_order2, min_probability_order2, "
+    "max_probability_order2, alphagram, num_anagrams, num_unique_letters, "
+    "num_vowels, point_value, front_hooks, back_hooks, is_front_hook, "
+    "is_back_hook, lexicon_symbols, definition) ";
 
 using namespace Defs;
 
@@ -55,18 +87,34 @@ CreateDatabaseThread::run()
 void
 CreateDatabaseThread::runPrivate()
 {
+    // Update an existing database in place of creating it, if possible
+    if (!baseFilename.isEmpty() && runIncremental())
+        return;
+
     int numSteps = 0;
 
+    // In bulk build mode, the database is built in a separate file with
+    // journaling and syncing turned off, and only moved into place once it
+    // is complete
+    bool bulkBuild = MainSettings::getUseBulkBuild();
+    QString buildFilename = bulkBuild ? dbFilename + BUILD_FILE_SUFFIX
+                                      : dbFilename;
+    if (bulkBuild && QFile::exists(buildFilename))
+        QFile::remove(buildFilename);
+
     {
         // Create empty database
         QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE",
-                                                    DB_CONNECTION_NAME);
-        db.setDatabaseName(dbFilename);
+            getConnectionName(DB_CONNECTION_NAME));
+        db.setDatabaseName(buildFilename);
         if (!db.open()) {
             error = QString("Unable to open database file '%1':\n%2").arg(
-                dbFilename).arg(db.lastError().text());
+                buildFilename).arg(db.lastError().text());
             cancel();
         }
+        else if (bulkBuild) {
+            setBulkBuildPragmas(db);
+        }
 
         // Start at 1% progress
         emit(steps(100));
@@ -83,19 +131,384 @@ CreateDatabaseThread::runPrivate()
         int stepNum = baseProgress;
         emit progress(stepNum);
 
+        buildMode = bulkBuild ? "bulk" : "full";
+        startStage("tables", "Creating tables");
         createTables(db);
+        finishStage(0);
+
+        // readDefinitions increments stepNum 2 times
+        startStage("definitions", "Reading definitions");
+        QMap<QString, QString> wordDefinitions;
+        readDefinitions(wordDefinitions, stepNum);
+        finishStage(wordDefinitions.size());
+
+        // insertWords increments stepNum 6 times
+        startStage("insert", "Inserting words");
+        insertWords(db, wordDefinitions, stepNum);
+        finishStage(numWords);
+
+        // Indexes are created once the words are in place, since updating
+        // them for each row inserted is slower than building them at once
+        startStage("indexes", "Creating indexes");
         createIndexes(db);
-        // insertWords increments stepNum 2 times
-        insertWords(db, stepNum);
-        // updateProbabilityOrder increments stepNum 4 times for each word
-        // because of 0, 1, 2 blanks and playability
-        updateProbabilityOrder(db, stepNum);
-        updateDefinitions(db, stepNum);
-        updateDefinitionLinks(db, stepNum);
+        finishStage(numWords);
+
+        startStage("stats", "Collecting search statistics");
+        finishStage(saveSearchStats(db));
+
+        startStage("analyze", "Analyzing indexes");
+        analyzeDatabase(db);
+        finishStage(numWords);
+        db.close();
+    }
+
+    cleanup();
+
+    if (bulkBuild)
+        moveBuildFile(buildFilename);
+
+    writeSnapshot();
+    writeStageLog();
+    emit progress(numSteps);
+}
+
+//---------------------------------------------------------------------------
+//  getNumThreads
+//
+//! Get the number of worker threads used for each parallel step of
+//! creating the database.
+//
+//! @return the number of threads set, or one per processor if none is set
+//---------------------------------------------------------------------------
+int
+CreateDatabaseThread::getNumThreads() const
+{
+    return (numThreads > 0) ? numThreads
+                            : qMax(1, QThread::idealThreadCount());
+}
+
+//---------------------------------------------------------------------------
+//  getConnectionName
+//
+//! Get the name of a database connection used by this thread.  Connections
+//! are named after the lexicon, so databases of several lexicons can be
+//! created at the same time.
+//
+//! @param base the base name of the connection
+//! @return the connection name
+//---------------------------------------------------------------------------
+QString
+CreateDatabaseThread::getConnectionName(const QString& base) const
+{
+    return base + "_" + lexiconName;
+}
+
+//---------------------------------------------------------------------------
+//  startStage
+//
+//! Start timing a stage of creating the database.
+//
+//! @param stage the name of the stage, as written to the build log
+//! @param description the description of the stage, as displayed
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::startStage(const QString& stage, const QString&
+                                 description)
+{
+    stageName = stage;
+    stageTimer.start();
+    emit stageStarted(stage);
+    emit status(QString("Creating %1 database: %2...").arg(lexiconName)
+                .arg(description));
+}
+
+//---------------------------------------------------------------------------
+//  finishStage
+//
+//! Finish timing the current stage of creating the database, and record
+//! the rows it processed and the time it took for the build log.
+//
+//! @param rows the number of rows processed by the stage
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::finishStage(int rows)
+{
+    int msecs = stageTimer.elapsed();
+    int rowsPerSec = msecs ? int(qint64(rows) * 1000 / msecs) : 0;
+
+    QStringList fields;
+    fields << QDateTime::currentDateTime().toString(Qt::ISODate)
+        << ZYZZYVA_VERSION << lexiconName << buildMode << stageName
+        << QString::number(rows) << QString::number(msecs)
+        << QString::number(rowsPerSec);
+    stageRecords.append(fields.join("\t"));
+
+    emit stageFinished(stageName, rows, msecs);
+}
+
+//---------------------------------------------------------------------------
+//  writeStageLog
+//
+//! Append the records of the stages of creating the database to the build
+//! log.  Each line of the log is one stage, with tab-separated fields: the
+//! time the stage finished, the program version, the lexicon, the build
+//! mode, the stage, the rows processed, the elapsed milliseconds, and the
+//! rows processed per second.
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::writeStageLog()
+{
+    if (stageRecords.isEmpty())
+        return;
+
+    // Databases of several lexicons may be created at the same time
+    QMutexLocker locker (&buildLogMutex);
+    QString logDirName = Auxil::getUserDir() + "/logs";
+    QDir logDir;
+    if (!logDir.mkpath(logDirName)) {
+        qWarning("Cannot create database build log directory\n");
+        return;
+    }
+
+    QFile file (logDirName + "/" + BUILD_LOG_FILENAME);
+    if (!file.open(QIODevice::Append | QIODevice::Text))
+        return;
+
+    QTextStream stream (&file);
+    foreach (const QString& record, stageRecords) {
+        stream << record;
+        endl(stream);
+    }
+    stageRecords.clear();
+}
+
+//---------------------------------------------------------------------------
+//  runIncremental
+//
+//! Update a copy of the base database, if only a few words of the lexicon
+//! have been added or removed since it was created.  Only the rows of the
+//! changed words and of the words whose hooks they change are recomputed,
+//! and orders are only computed again for lengths with changed words.
+//
+//! @return true if the database was updated, or the update was cancelled
+//! or failed, false if the database must be created instead
+//---------------------------------------------------------------------------
+bool
+CreateDatabaseThread::runIncremental()
+{
+    QString buildFilename = dbFilename + BUILD_FILE_SUFFIX;
+    if (QFile::exists(buildFilename))
+        QFile::remove(buildFilename);
+    if (!QFile::exists(baseFilename) ||
+        !QFile::copy(baseFilename, buildFilename))
+    {
+        return false;
+    }
+
+    int numSteps = 0;
+    bool updated = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE",
+            getConnectionName(DB_CONNECTION_NAME));
+        db.setDatabaseName(buildFilename);
+        if (db.open()) {
+            setBulkBuildPragmas(db);
+            updated = updateWords(db, numSteps);
+            if (updated && !cancelled) {
+                startStage("stats", "Collecting search statistics");
+                finishStage(saveSearchStats(db));
+
+                startStage("analyze", "Analyzing indexes");
+                analyzeDatabase(db);
+                finishStage(wordEngine->getNumWords(lexiconName));
+            }
+            db.close();
+        }
     }
 
     cleanup();
+
+    if (!updated) {
+        QFile::remove(buildFilename);
+        return false;
+    }
+
+    moveBuildFile(buildFilename);
+    writeSnapshot();
+    writeStageLog();
     emit progress(numSteps);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  moveBuildFile
+//
+//! Move a database built in a separate file into place, or remove it if
+//! the build was cancelled or failed.
+//
+//! @param buildFilename the file the database was built in
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::moveBuildFile(const QString& buildFilename)
+{
+    if (cancelled || !error.isEmpty()) {
+        QFile::remove(buildFilename);
+    }
+    else if ((QFile::exists(dbFilename) && !QFile::remove(dbFilename)) ||
+             !QFile::rename(buildFilename, dbFilename))
+    {
+        error = QString("Unable to move database file '%1' to "
+                        "'%2'.").arg(buildFilename).arg(dbFilename);
+        QFile::remove(buildFilename);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  writeSnapshot
+//
+//! Write a binary snapshot of the finished database, so the word attributes
+//! and word information can be read by memory-mapping the snapshot instead
+//! of querying the database.  Any existing snapshot is removed even if a
+//! new one cannot be written, since it no longer matches the database.
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::writeSnapshot()
+{
+    QString snapshotFilename = LexiconSnapshot::getFilename(dbFilename);
+    QString buildFilename = snapshotFilename + BUILD_FILE_SUFFIX;
+    QFile::remove(buildFilename);
+    if (cancelled || !error.isEmpty())
+        return;
+    QFile::remove(snapshotFilename);
+
+    startStage("snapshot", "Writing snapshot");
+    LexiconSnapshot::Columns columns;
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE",
+            getConnectionName(SNAPSHOT_CONNECTION_NAME));
+        db.setDatabaseName(dbFilename);
+        if (db.open()) {
+            ok = readSnapshotColumns(db, columns);
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(getConnectionName(SNAPSHOT_CONNECTION_NAME));
+
+    QString errString = "Unable to read words from database.";
+    ok = ok && LexiconSnapshot::write(buildFilename, columns, dbFilename,
+                                      &errString) &&
+        QFile::rename(buildFilename, snapshotFilename);
+    if (!ok) {
+        QFile::remove(buildFilename);
+        if (!cancelled) {
+            qWarning("Cannot write database snapshot: %s\n",
+                     errString.toUtf8().constData());
+        }
+    }
+    finishStage(ok ? columns.getNumWords() : 0);
+}
+
+//---------------------------------------------------------------------------
+//  readSnapshotColumns
+//
+//! Read the rows of all words from a database, in alphabetical order, for
+//! writing a snapshot.
+//
+//! @param db the database
+//! @param columns returns the rows
+//! @return true if successful, false if the rows cannot be read or the
+//! build was cancelled
+//---------------------------------------------------------------------------
+bool
+CreateDatabaseThread::readSnapshotColumns(QSqlDatabase& db,
+    LexiconSnapshot::Columns& columns) const
+{
+    QSqlQuery query (db);
+    if (!query.exec("SELECT count(*) FROM words") || !query.next())
+        return false;
+    int numWords = query.value(0).toInt();
+    query.finish();
+
+    QString qstr = "SELECT word, num_vowels, num_unique_letters, "
+        "num_anagrams, point_value, is_front_hook, is_back_hook, "
+        "playability, "
+        "playability_order, min_playability_order, max_playability_order, "
+        "probability_order0, min_probability_order0, max_probability_order0, "
+        "probability_order1, min_probability_order1, max_probability_order1, "
+        "probability_order2, min_probability_order2, max_probability_order2, "
+        "combinations0, combinations1, combinations2, "
+        "front_hooks, back_hooks, lexicon_symbols, definition "
+        "FROM words ORDER BY word";
+
+    query.setForwardOnly(true);
+    if (!query.exec(qstr))
+        return false;
+
+    columns.resize(numWords);
+    int id = 0;
+    for (; (id < numWords) && query.next(); ++id) {
+        if (cancelled)
+            return false;
+
+        int placeNum = 0;
+        columns.strings[LexiconSnapshot::WordColumn][id] =
+            query.value(placeNum++).toString();
+        columns.numVowels[id] = query.value(placeNum++).toInt();
+        columns.numUniqueLetters[id] = query.value(placeNum++).toInt();
+        columns.numAnagrams[id] = query.value(placeNum++).toInt();
+        columns.pointValue[id] = query.value(placeNum++).toInt();
+
+        quint8 flags = 0;
+        if (query.value(placeNum++).toBool())
+            flags |= LexiconSnapshot::FrontHookFlag;
+        if (query.value(placeNum++).toBool())
+            flags |= LexiconSnapshot::BackHookFlag;
+        columns.flags[id] = flags;
+
+        columns.playability[id] = query.value(placeNum++).toLongLong();
+        for (int i = 0; i < 3; ++i) {
+            columns.playabilityOrders[3 * id + i] =
+                query.value(placeNum++).toInt();
+        }
+        for (int i = 0; i < 9; ++i) {
+            columns.probabilityOrders[9 * id + i] =
+                query.value(placeNum++).toInt();
+        }
+        for (int i = 0; i < 3; ++i) {
+            columns.combinations[3 * id + i] =
+                query.value(placeNum++).toDouble();
+        }
+
+        columns.strings[LexiconSnapshot::FrontHooksColumn][id] =
+            query.value(placeNum++).toString();
+        columns.strings[LexiconSnapshot::BackHooksColumn][id] =
+            query.value(placeNum++).toString();
+        columns.strings[LexiconSnapshot::LexiconSymbolsColumn][id] =
+            query.value(placeNum++).toString();
+        columns.strings[LexiconSnapshot::DefinitionColumn][id] =
+            query.value(placeNum++).toString();
+    }
+
+    return (id == numWords);
+}
+
+//---------------------------------------------------------------------------
+//  setBulkBuildPragmas
+//
+//! Set up a database connection for building a database as quickly as
+//! possible.  The database is not safe from crashes while being built, so
+//! it must be discarded if the build does not finish.
+//
+//! @param db the database
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::setBulkBuildPragmas(QSqlDatabase& db)
+{
+    QSqlQuery query (db);
+    query.exec("PRAGMA journal_mode=OFF");
+    query.exec("PRAGMA synchronous=OFF");
+    query.exec("PRAGMA cache_size=" + QString::number(BULK_BUILD_CACHE_PAGES));
 }
 
 //---------------------------------------------------------------------------
@@ -141,96 +554,358 @@ CreateDatabaseThread::createTables(QSqlDatabase& db)
     query.exec();
 }
 
+//---------------------------------------------------------------------------
+//  saveSearchStats
+//
+//! Collect the search statistics of the words in the database, and save
+//! them in the database.
+//
+//! @param db the database
+//! @return the number of words counted
+//---------------------------------------------------------------------------
+int
+CreateDatabaseThread::saveSearchStats(QSqlDatabase& db)
+{
+    if (cancelled)
+        return 0;
+
+    SearchStats stats;
+    if (stats.collect(db))
+        stats.save(db);
+    return stats.getNumWords();
+}
+
 //---------------------------------------------------------------------------
 //  createIndexes
 //
-//! Create the database indexes.
+//! Create the database indexes.  Index sets of the lexicon that are
+//! deferred or skipped are not created, and deferred sets are created later
+//! by the word engine when a search first needs them.
 //
 //! @param db the database
-//! @param stepNum the current step number
 //---------------------------------------------------------------------------
 void
 CreateDatabaseThread::createIndexes(QSqlDatabase& db)
 {
     QSqlQuery query (db);
 
-    // Indexes on words table
-    query.exec("CREATE UNIQUE INDEX word_index on words (word)");
-    if (cancelled)
-        return;
+    QStringList queries = DatabaseIndexSet::getRequiredQueries();
+    QList<DatabaseIndexSet> indexSets =
+        DatabaseIndexSet::getIndexSets(lexiconName);
+    foreach (const DatabaseIndexSet& indexSet, indexSets) {
+        if (indexSet.getMode() == DatabaseIndexSet::BuildMode)
+            queries += indexSet.getCreateQueries();
+    }
 
-    query.exec("CREATE INDEX word_length_index on words (length)");
-    if (cancelled)
-        return;
+    foreach (const QString& queryStr, queries) {
+        query.exec(queryStr);
+        if (cancelled)
+            return;
+    }
+}
 
-    query.exec("CREATE UNIQUE INDEX play_index on words "
-               "(length, playability_order)");
+//---------------------------------------------------------------------------
+//  analyzeDatabase
+//
+//! Collect statistics on the tables and indexes of the database, so the
+//! query planner can choose between the length and order indexes when the
+//! database is searched.
+//
+//! @param db the database
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::analyzeDatabase(QSqlDatabase& db)
+{
     if (cancelled)
         return;
 
-    query.exec("CREATE INDEX play_min_max_index on words "
-               "(length, min_playability_order, max_playability_order)");
-    if (cancelled)
-        return;
+    QSqlQuery query (db);
+    query.exec("ANALYZE");
+}
 
-    query.exec("CREATE UNIQUE INDEX prob0_index on words "
-               "(length, probability_order0)");
-    if (cancelled)
-        return;
+//---------------------------------------------------------------------------
+//  WordBlock
+//
+//! A block of words of one length, with the values of each column of their
+//! rows once they have been computed.
+//---------------------------------------------------------------------------
+class CreateDatabaseThread::WordBlock
+{
+    public:
+    WordBlock(const LetterBag& bag, int len, const QStringList& w)
+        : length(len), words(w), features(bag) { }
+    ~WordBlock() { }
 
-    query.exec("CREATE INDEX prob0_min_max_index on words "
-               "(length, min_probability_order0, max_probability_order0)");
-    if (cancelled)
-        return;
+    int length;
+    QStringList words;
+    WordFeatures features;
+    QVariantList playabilityValues;
+    QVariantList frontHookValues;
+    QVariantList backHookValues;
+    QVariantList isFrontHookValues;
+    QVariantList isBackHookValues;
+    QVariantList symbolValues;
+    QVariantList definitionValues;
+
+    void append(const WordBlock& block);
+};
 
-    query.exec("CREATE UNIQUE INDEX prob1_index on words "
-               "(length, probability_order1)");
-    if (cancelled)
-        return;
+//---------------------------------------------------------------------------
+//  WordBlock::append
+//
+//! Append the words of another block of the same length, with their values.
+//
+//! @param block the block to append
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::WordBlock::append(const WordBlock& block)
+{
+    words += block.words;
+    features.combinations0 += block.features.combinations0;
+    features.combinations1 += block.features.combinations1;
+    features.combinations2 += block.features.combinations2;
+    features.alphagrams += block.features.alphagrams;
+    features.numUniqueLetters += block.features.numUniqueLetters;
+    features.numVowels += block.features.numVowels;
+    features.pointValues += block.features.pointValues;
+    playabilityValues += block.playabilityValues;
+    frontHookValues += block.frontHookValues;
+    backHookValues += block.backHookValues;
+    isFrontHookValues += block.isFrontHookValues;
+    isBackHookValues += block.isBackHookValues;
+    symbolValues += block.symbolValues;
+    definitionValues += block.definitionValues;
+}
 
-    query.exec("CREATE INDEX prob1_min_max_index on words "
-               "(length, min_probability_order1, max_probability_order1)");
-    if (cancelled)
-        return;
+//---------------------------------------------------------------------------
+//  WordPipeline
+//
+//! The blocks of words to be inserted, with what is needed to compute their
+//! rows.  Feature threads take blocks in order from a shared counter and
+//! compute them, while the thread creating the database writes the
+//! computed blocks a length at a time, in the same order.  Feature threads
+//! wait before computing a block beyond a limit set by the writing thread,
+//! so only a limited number of computed blocks are held at once.
+//---------------------------------------------------------------------------
+class CreateDatabaseThread::WordPipeline
+{
+    public:
+    WordPipeline(const LetterBag& bag)
+        : letterBag(bag), nextBlock(0), writeLimit(0), cancelled(false) { }
+    ~WordPipeline() { qDeleteAll(blocks); }
+
+    int takeBlock() { return nextBlock.fetchAndAddOrdered(1); }
+    bool waitForRoom(int blockNum);
+    void setWriteLimit(int limit);
+    void setReady(int blockNum);
+    bool waitForBlock(int blockNum);
+    void setWritten(int blockNum);
+    void cancel();
+
+    public:
+    const LetterBag& letterBag;
+    QList<WordBlock*> blocks;
+    PlayabilityTable playability;
+    QList<LexiconStyle> lexStyles;
+    QStringList compareLexicons;
+    QVector<quint32> styleMasks;
+
+    private:
+    QAtomicInt nextBlock;
+    int writeLimit;
+    QSet<int> readyBlocks;
+    bool cancelled;
+    QMutex mutex;
+    QWaitCondition changed;
+};
 
-    query.exec("CREATE UNIQUE INDEX prob2_index on words "
-               "(length, probability_order2)");
-    if (cancelled)
-        return;
+//---------------------------------------------------------------------------
+//  WordPipeline::waitForRoom
+//
+//! Wait until a block is within the limit of blocks that may be computed.
+//
+//! @param blockNum the block number
+//! @return true if the block can be computed, false if cancelled
+//---------------------------------------------------------------------------
+bool
+CreateDatabaseThread::WordPipeline::waitForRoom(int blockNum)
+{
+    QMutexLocker locker (&mutex);
+    while (!cancelled && (blockNum >= writeLimit))
+        changed.wait(&mutex);
+    return !cancelled;
+}
 
-    query.exec("CREATE INDEX prob2_min_max_index on words "
-               "(length, min_probability_order2, max_probability_order2)");
-    if (cancelled)
-        return;
+//---------------------------------------------------------------------------
+//  WordPipeline::setWriteLimit
+//
+//! Set the number of the first block that may not be computed yet.
+//
+//! @param limit the block number
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::WordPipeline::setWriteLimit(int limit)
+{
+    QMutexLocker locker (&mutex);
+    writeLimit = limit;
+    changed.wakeAll();
+}
 
-    query.exec("CREATE INDEX definition_index on words "
-               "(definition)");
-    if (cancelled)
-        return;
+//---------------------------------------------------------------------------
+//  WordPipeline::setReady
+//
+//! Mark a block as computed and ready to be written.
+//
+//! @param blockNum the block number
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::WordPipeline::setReady(int blockNum)
+{
+    QMutexLocker locker (&mutex);
+    readyBlocks.insert(blockNum);
+    changed.wakeAll();
 }
 
 //---------------------------------------------------------------------------
-//  insertWords
+//  WordPipeline::waitForBlock
 //
-//! Insert words into the database.
+//! Wait until a block has been computed.
 //
-//! @param db the database
-//! @param stepNum the current step number
+//! @param blockNum the block number
+//! @return true if the block is ready, false if cancelled
+//---------------------------------------------------------------------------
+bool
+CreateDatabaseThread::WordPipeline::waitForBlock(int blockNum)
+{
+    QMutexLocker locker (&mutex);
+    while (!cancelled && !readyBlocks.contains(blockNum))
+        changed.wait(&mutex);
+    return !cancelled;
+}
+
+//---------------------------------------------------------------------------
+//  WordPipeline::setWritten
+//
+//! Mark a block as written, freeing its values.
+//
+//! @param blockNum the block number
 //---------------------------------------------------------------------------
 void
-CreateDatabaseThread::insertWords(QSqlDatabase& db, int& stepNum)
+CreateDatabaseThread::WordPipeline::setWritten(int blockNum)
 {
-    LetterBag letterBag;
-    QStringList letters;
-    letters << "A" << "B" << "C" << "D" << "E" << "F" << "G" << "H" <<
-        "I" << "J" << "K" << "L" << "M" << "N" << "O" << "P" << "Q" <<
-        "R" << "S" << "T" << "U" << "V" << "W" << "X" << "Y" << "Z";
+    QMutexLocker locker (&mutex);
+    delete blocks[blockNum];
+    blocks[blockNum] = 0;
+    readyBlocks.remove(blockNum);
+}
 
-    SearchCondition searchCondition;
-    searchCondition.type = SearchCondition::Length;
-    SearchSpec searchSpec;
-    searchSpec.conditions.append(searchCondition);
+//---------------------------------------------------------------------------
+//  WordPipeline::cancel
+//
+//! Stop every thread waiting on the pipeline.
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::WordPipeline::cancel()
+{
+    QMutexLocker locker (&mutex);
+    cancelled = true;
+    changed.wakeAll();
+}
+
+//---------------------------------------------------------------------------
+//  FeatureThread
+//
+//! A thread that computes the rows of blocks of words taken from a pipeline
+//! until none are left.
+//---------------------------------------------------------------------------
+class CreateDatabaseThread::FeatureThread : public QThread
+{
+    public:
+    FeatureThread(const CreateDatabaseThread* c, WordPipeline* p)
+        : QThread(), creator(c), pipeline(p) { }
+    ~FeatureThread() { }
+
+    protected:
+    void run() {
+        int numBlocks = pipeline->blocks.size();
+        while (true) {
+            int blockNum = pipeline->takeBlock();
+            if ((blockNum >= numBlocks) || !pipeline->waitForRoom(blockNum))
+                break;
+            creator->computeWordBlock(*pipeline,
+                                      pipeline->blocks.at(blockNum));
+            pipeline->setReady(blockNum);
+        }
+    }
+
+    private:
+    const CreateDatabaseThread* creator;
+    WordPipeline* pipeline;
+};
+
+//---------------------------------------------------------------------------
+//  OrderKey
+//
+//! The key of a word when ordering the words of a length by a value.  Words
+//! are ordered by decreasing value, and words of equal value by alphagram.
+//---------------------------------------------------------------------------
+class OrderKey
+{
+    public:
+    OrderKey(double v = 0, const QString& r = QString(), int i = 0)
+        : value(v), radix(r), index(i) { }
+
+    bool operator<(const OrderKey& other) const {
+        if (value != other.value)
+            return value > other.value;
+        return radix < other.radix;
+    }
+
+    double value;
+    QString radix;
+    int index;
+};
+
+//---------------------------------------------------------------------------
+//  OrderThread
+//
+//! A thread that orders the words of a length by one value.
+//---------------------------------------------------------------------------
+class CreateDatabaseThread::OrderThread : public QThread
+{
+    public:
+    OrderThread(const CreateDatabaseThread* c, const QVariantList* v,
+                const QStringList* r, QVariantList* o, QVariantList* mn,
+                QVariantList* mx)
+        : QThread(), creator(c), values(v), radixes(r), orders(o),
+          minOrders(mn), maxOrders(mx) { }
+    ~OrderThread() { }
+
+    protected:
+    void run() {
+        creator->getOrders(*values, *radixes, orders, minOrders, maxOrders);
+    }
 
+    private:
+    const CreateDatabaseThread* creator;
+    const QVariantList* values;
+    const QStringList* radixes;
+    QVariantList* orders;
+    QVariantList* minOrders;
+    QVariantList* maxOrders;
+};
+
+//---------------------------------------------------------------------------
+//  setUpPipeline
+//
+//! Read the values shared by every block of words in a pipeline: the
+//! lexicon styles, the compared lexicons, and the playability values.
+//
+//! @param pipeline the pipeline
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::setUpPipeline(WordPipeline& pipeline) const
+{
     QList<LexiconStyle> lexStyles = MainSettings::getWordListLexiconStyles();
     QMutableListIterator<LexiconStyle> it (lexStyles);
     while (it.hasNext()) {
@@ -241,325 +916,657 @@ CreateDatabaseThread::insertWords(QSqlDatabase& db, int& stepNum)
             it.remove();
         }
     }
+    pipeline.lexStyles = lexStyles;
+
+    // Check the words against the compared lexicons all at once, and note
+    // the bit of each style's compared lexicon in the results
+    foreach (const LexiconStyle& style, lexStyles) {
+        if (!pipeline.compareLexicons.contains(style.compareLexicon))
+            pipeline.compareLexicons.append(style.compareLexicon);
+        pipeline.styleMasks.append(
+            1U << pipeline.compareLexicons.indexOf(style.compareLexicon));
+    }
 
-    QMap<QString, qint64> playabilityMap;
+    // Playability values are read from a binary file saved the first time
+    // the text file is read, and looked up a block at a time by merging the
+    // words of the block with the sorted values
     QString playabilityFile = Auxil::getWordsDir() +
         Auxil::getLexiconPrefix(lexiconName) + "-Playability.txt";
-    importPlayability(playabilityFile, playabilityMap);
+    pipeline.playability.load(playabilityFile,
+        PlayabilityTable::getSavedFilename(playabilityFile));
+}
 
-    QSqlQuery transactionQuery ("BEGIN TRANSACTION", db);
-    QSqlQuery query (db);
+//---------------------------------------------------------------------------
+//  getLexiconWords
+//
+//! Get the words of a length in the lexicon.
+//
+//! @param length the length
+//! @return the words
+//---------------------------------------------------------------------------
+QStringList
+CreateDatabaseThread::getLexiconWords(int length) const
+{
+    SearchCondition searchCondition;
+    searchCondition.type = SearchCondition::Length;
+    searchCondition.minValue = length;
+    searchCondition.maxValue = length;
+    SearchSpec searchSpec;
+    searchSpec.conditions.append(searchCondition);
 
-    QMap<QString, qint64> numAnagramsMap;
+    // Do a word graph search because we're still building the database!
+    return wordEngine->wordGraphSearch(lexiconName, searchSpec);
+}
+
+//---------------------------------------------------------------------------
+//  insertWords
+//
+//! Insert words into the database.  The rows of blocks of words are
+//! computed by a pool of feature threads, and written by this thread a
+//! length at a time, once the values that depend on every word of a length
+//! are known, so each row is written only once.
+//
+//! @param db the database
+//! @param wordDefinitions the definition of each word
+//! @param stepNum the current step number
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::insertWords(QSqlDatabase& db, const QMap<QString,
+                                  QString>& wordDefinitions, int& stepNum)
+{
+    LetterBag letterBag;
+    int maxPending = FEATURE_BLOCKS_PER_THREAD * getNumThreads();
+    WordPipeline pipeline (letterBag);
+    setUpPipeline(pipeline);
 
+    // Divide the words of each length into blocks, and note the block
+    // following the last block of each length
+    QList<int> lengthEnds;
     for (int length = 1; length <= MAX_WORD_LEN; ++length) {
-        searchSpec.conditions[0].minValue = length;
-        searchSpec.conditions[0].maxValue = length;
-
-        // Do a word graph search because we're still building the database!
-        QStringList words = wordEngine->wordGraphSearch(lexiconName,
-                                                        searchSpec);
-
-        query.prepare("INSERT INTO words (word, length, playability, "
-                      "combinations0, combinations1, combinations2, "
-                      "alphagram, num_unique_letters, num_vowels, "
-                      "point_value, front_hooks, back_hooks, "
-                      "is_front_hook, is_back_hook, lexicon_symbols) "
-                      "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-
-        // Insert words with length, combinations, hooks
-        foreach (const QString& word, words) {
-            qint64 playability = playabilityMap.value(word);
-            double combinations0 = letterBag.getNumCombinations(word, 0);
-            double combinations1 = letterBag.getNumCombinations(word, 1);
-            double combinations2 = letterBag.getNumCombinations(word, 2);
-            int numUniqueLetters = Auxil::getNumUniqueLetters(word);
-            int numVowels = Auxil::getNumVowels(word);
-
-            int pointValue = 0;
-            for (int i = 0; i < word.length(); ++i) {
-                pointValue += letterBag.getLetterValue(word.at(i));
-            }
+        QStringList words = getLexiconWords(length);
+        if (words.isEmpty())
+            continue;
 
-            QString alphagram = Auxil::getAlphagram(word);
-            if (numAnagramsMap.contains(alphagram))
-                ++numAnagramsMap[alphagram];
-            else
-                numAnagramsMap[alphagram] = 1;
-
-            int isFrontHook = wordEngine->isAcceptable(
-                lexiconName, word.right(word.length() - 1)) ? 1 : 0;
-            int isBackHook = wordEngine->isAcceptable(
-                lexiconName, word.left(word.length() - 1)) ? 1 : 0;
-
-            QString front, back;
-            foreach (const QString& letter, letters) {
-                if (wordEngine->isAcceptable(lexiconName, letter + word))
-                    front += letter;
-                if (wordEngine->isAcceptable(lexiconName, word + letter))
-                    back += letter;
-            }
+        for (int start = 0; start < words.size(); start += PROGRESS_STEP) {
+            pipeline.blocks.append(new WordBlock(letterBag, length,
+                words.mid(start, PROGRESS_STEP)));
+        }
+        lengthEnds.append(pipeline.blocks.size());
+    }
 
-            // Populate words and hooks with symbols
-            QString symbolStr;
-            if (!lexStyles.isEmpty()) {
-                QListIterator<LexiconStyle> it (lexStyles);
-                while (it.hasNext()) {
-                    const LexiconStyle& style = it.next();
-                    bool acceptable =
-                        wordEngine->isAcceptable(style.compareLexicon, word);
-                    if (!(acceptable ^ style.inCompareLexicon))
-                        symbolStr += style.symbol;
-                }
-
-                // Populate front hooks with symbols
-                for (int i = 0; i < front.length(); ++i) {
-                    QChar c = front[i];
-                    QString hookWord = c.toUpper() + word;
-
-                    it.toFront();
-                    while (it.hasNext()) {
-                        const LexiconStyle& style = it.next();
-                        bool acceptable = wordEngine->isAcceptable(
-                            style.compareLexicon, hookWord);
-
-                        if (!(acceptable ^ style.inCompareLexicon)) {
-                            front.insert(i + 1, style.symbol);
-                            i += style.symbol.length();
-                        }
-                    }
-                }
-
-                // Populate back hooks with symbols
-                for (int i = 0; i < back.length(); ++i) {
-                    QChar c = back[i];
-                    QString hookWord = word + c.toUpper();
-
-                    it.toFront();
-                    while (it.hasNext()) {
-                        const LexiconStyle& style = it.next();
-                        bool acceptable = wordEngine->isAcceptable(
-                            style.compareLexicon, hookWord);
-
-                        if (!(acceptable ^ style.inCompareLexicon)) {
-                            back.insert(i + 1, style.symbol);
-                            i += style.symbol.length();
-                        }
-                    }
-                }
-            }
+    QList<FeatureThread*> threads;
+    for (int i = 0; i < getNumThreads(); ++i) {
+        FeatureThread* thread = new FeatureThread(this, &pipeline);
+        threads.append(thread);
+        thread->start();
+    }
 
-            int bindNum = 0;
-            query.bindValue(bindNum++, word);
-            query.bindValue(bindNum++, length);
-            query.bindValue(bindNum++, playability);
-            query.bindValue(bindNum++, combinations0);
-            query.bindValue(bindNum++, combinations1);
-            query.bindValue(bindNum++, combinations2);
-            query.bindValue(bindNum++, alphagram);
-            query.bindValue(bindNum++, numUniqueLetters);
-            query.bindValue(bindNum++, numVowels);
-            query.bindValue(bindNum++, pointValue);
-            query.bindValue(bindNum++, front.toLower());
-            query.bindValue(bindNum++, back.toLower());
-            query.bindValue(bindNum++, isFrontHook);
-            query.bindValue(bindNum++, isBackHook);
-            query.bindValue(bindNum++, symbolStr);
-            query.exec();
-
-            if ((stepNum % PROGRESS_STEP) == 0) {
-                if (cancelled) {
-                    transactionQuery.exec("END TRANSACTION");
-                    return;
-                }
-                emit progress(stepNum);
-            }
-            ++stepNum;
+    QSqlQuery transactionQuery ("BEGIN TRANSACTION", db);
+    QSqlQuery insertQuery (db);
+    insertQuery.prepare(getInsertQuery(INSERT_WORDS_PREFIX,
+        NUM_INSERT_COLUMNS, INSERT_ROWS_PER_QUERY));
+
+    int firstBlock = 0;
+    foreach (int endBlock, lengthEnds) {
+        // Let feature threads compute ahead into the following lengths
+        // while the blocks of this length are gathered
+        pipeline.setWriteLimit(endBlock + maxPending);
+
+        WordBlock rows (letterBag, pipeline.blocks.at(firstBlock)->length,
+                        QStringList());
+        for (int blockNum = firstBlock; blockNum < endBlock; ++blockNum) {
+            if (cancelled || !pipeline.waitForBlock(blockNum))
+                break;
+
+            const WordBlock* block = pipeline.blocks.at(blockNum);
+            rows.append(*block);
+            stepNum += block->words.size();
+            pipeline.setWritten(blockNum);
+            emit progress(stepNum);
         }
 
-        // Update number of anagrams
-        query.prepare("UPDATE words SET num_anagrams=? WHERE word=?");
-        foreach (const QString& word, words) {
-            QString alphagram = Auxil::getAlphagram(word);
-            query.bindValue(0, numAnagramsMap[alphagram]);
-            query.bindValue(1, word);
-            query.exec();
-
-            if ((stepNum % PROGRESS_STEP) == 0) {
-                if (cancelled) {
-                    transactionQuery.exec("END TRANSACTION");
-                    return;
-                }
-                emit progress(stepNum);
-            }
-            ++stepNum;
+        if (cancelled)
+            break;
+
+        foreach (const QString& word, rows.words) {
+            QMap<QString, QString>::const_iterator dt =
+                wordDefinitions.find(word);
+            rows.definitionValues.append(dt == wordDefinitions.end() ?
+                QVariant(QVariant::String) : QVariant(dt.value()));
         }
+
+        insertLength(db, insertQuery, rows, stepNum);
+        firstBlock = endBlock;
+    }
+
+    pipeline.cancel();
+    foreach (FeatureThread* thread, threads) {
+        thread->wait();
+        delete thread;
     }
 
     transactionQuery.exec("END TRANSACTION");
 }
 
 //---------------------------------------------------------------------------
-//  updateProbabilityOrder
+//  insertLength
 //
-//! Update probability and playability order of words in the database.
+//! Insert the rows of all the words of a length.  The number of anagrams
+//! and the orders of each word are computed from the words of the length.
 //
 //! @param db the database
+//! @param insertQuery a query prepared to insert INSERT_ROWS_PER_QUERY rows
+//! @param rows the words of the length, with the values of their rows
 //! @param stepNum the current step number
 //---------------------------------------------------------------------------
 void
-CreateDatabaseThread::updateProbabilityOrder(QSqlDatabase& db, int& stepNum)
+CreateDatabaseThread::insertLength(QSqlDatabase& db, QSqlQuery& insertQuery,
+                                   const WordBlock& rows, int& stepNum)
+{
+    const QStringList& words = rows.words;
+    const WordFeatures& features = rows.features;
+
+    // Count the anagrams of each alphagram
+    QStringList alphagrams;
+    QHash<QString, int> numAnagramsHash;
+    foreach (const QVariant& value, features.alphagrams) {
+        QString alphagram = value.toString();
+        alphagrams.append(alphagram);
+        ++numAnagramsHash[alphagram];
+    }
+
+    QVariantList wordValues;
+    QVariantList lengthValues;
+    QVariantList numAnagramsValues;
+    for (int i = 0; i < words.size(); ++i) {
+        wordValues.append(words[i]);
+        lengthValues.append(rows.length);
+        numAnagramsValues.append(numAnagramsHash.value(alphagrams[i]));
+    }
+
+    // Order the words by playability and by combinations with 0, 1, 2
+    // blanks, sorting by each value in a separate thread
+    QStringList radixes;
+    for (int i = 0; i < words.size(); ++i)
+        radixes.append(alphagrams[i] + words[i]);
+
+    const QVariantList* orderColumns[NUM_ORDERS] = {
+        &rows.playabilityValues, &features.combinations0,
+        &features.combinations1, &features.combinations2 };
+    QVariantList orderValues[NUM_ORDERS];
+    QVariantList minOrderValues[NUM_ORDERS];
+    QVariantList maxOrderValues[NUM_ORDERS];
+    QList<OrderThread*> orderThreads;
+    for (int i = 1; i < NUM_ORDERS; ++i) {
+        if (getNumThreads() == 1) {
+            getOrders(*orderColumns[i], radixes, &orderValues[i],
+                      &minOrderValues[i], &maxOrderValues[i]);
+            continue;
+        }
+        OrderThread* thread = new OrderThread(this, orderColumns[i],
+            &radixes, &orderValues[i], &minOrderValues[i],
+            &maxOrderValues[i]);
+        orderThreads.append(thread);
+        thread->start();
+    }
+    getOrders(*orderColumns[0], radixes, &orderValues[0],
+              &minOrderValues[0], &maxOrderValues[0]);
+    foreach (OrderThread* thread, orderThreads) {
+        thread->wait();
+        delete thread;
+    }
+    stepNum += NUM_ORDERS * words.size();
+    emit progress(stepNum);
+
+    QList<QVariantList> columns;
+    columns << wordValues << lengthValues;
+    for (int i = 0; i < NUM_ORDERS; ++i) {
+        columns << *orderColumns[i] << orderValues[i] << minOrderValues[i]
+            << maxOrderValues[i];
+    }
+    columns << features.alphagrams << numAnagramsValues
+        << features.numUniqueLetters << features.numVowels
+        << features.pointValues << rows.frontHookValues
+        << rows.backHookValues << rows.isFrontHookValues
+        << rows.isBackHookValues << rows.symbolValues
+        << rows.definitionValues;
+    insertRows(db, insertQuery, INSERT_WORDS_PREFIX, columns);
+
+    stepNum += words.size();
+    emit progress(stepNum);
+}
+
+//---------------------------------------------------------------------------
+//  updateWords
+//
+//! Update the words of an existing database to match the lexicon.  Rows of
+//! removed words are deleted, rows of added words are inserted, and the
+//! hooks of words next to changed words are computed again.  The lengths
+//! with changed words are written again with new orders and numbers of
+//! anagrams.
+//
+//! @param db the database
+//! @param numSteps returns the number of progress steps
+//! @return true if the database was updated, or the update was cancelled,
+//! false if the database is out of date or too many words have changed to
+//! be worth updating
+//---------------------------------------------------------------------------
+bool
+CreateDatabaseThread::updateWords(QSqlDatabase& db, int& numSteps)
 {
+    buildMode = "incremental";
+    startStage("compare", "Comparing words");
+
+    QSqlQuery query (db);
+    query.exec("SELECT version FROM db_version");
+    if (!query.next() || (query.value(0).toInt() != CURRENT_DATABASE_VERSION))
+        return false;
+
+    // Find the words added to and removed from the lexicon
+    QSet<QString> oldWords;
+    query.exec("SELECT word FROM words");
+    while (query.next())
+        oldWords.insert(query.value(0).toString());
+
+    QSet<QString> newWords;
+    for (int length = 1; length <= MAX_WORD_LEN; ++length)
+        newWords.unite(getLexiconWords(length).toSet());
+
+    QSet<QString> addedWords = newWords;
+    addedWords.subtract(oldWords);
+    QSet<QString> changedWords = oldWords;
+    changedWords.subtract(newWords);
+    changedWords.unite(addedWords);
+
+    int maxChangedWords = newWords.size() * MAX_UPDATE_CHANGED_PERCENT / 100;
+    finishStage(oldWords.size() + newWords.size());
+    if (changedWords.size() > maxChangedWords)
+        return false;
+
+    // The hooks of a word change if it is formed by adding or removing a
+    // letter at either end of a changed word
+    QSet<int> changedLengths;
+    QSet<QString> computeWords = addedWords;
+    foreach (const QString& word, changedWords) {
+        changedLengths.insert(word.length());
+        QStringList neighbors;
+        neighbors << word.mid(1) << word.left(word.length() - 1);
+        for (int i = 0; i < NUM_HOOK_LETTERS; ++i) {
+            QChar letter (ushort('A' + i));
+            neighbors << letter + word << word + letter;
+        }
+        foreach (const QString& neighbor, neighbors) {
+            if (newWords.contains(neighbor))
+                computeWords.insert(neighbor);
+        }
+    }
+
+    QMap<int, QStringList> computeLengthWords;
+    foreach (const QString& word, computeWords)
+        computeLengthWords[word.length()].append(word);
+    QList<int> lengths = (changedLengths + computeLengthWords.keys().toSet())
+        .toList();
+    qSort(lengths);
+
+    // Total number of progress steps is the steps of reading definitions,
+    // plus the words to be computed, plus the words to be written
+    int stepNum = 0;
+    numSteps = 2 * newWords.size() + computeWords.size() + 1;
+    foreach (const QString& word, newWords) {
+        if (changedLengths.contains(word.length()))
+            numSteps += NUM_ORDERS + 1;
+    }
+    foreach (const QString& word, computeWords) {
+        if (!changedLengths.contains(word.length()))
+            ++numSteps;
+    }
+    emit steps(numSteps);
+    emit progress(stepNum);
+
+    startStage("definitions", "Reading definitions");
+    QMap<QString, QString> wordDefinitions;
+    if (!addedWords.isEmpty())
+        readDefinitions(wordDefinitions, stepNum);
+    else
+        stepNum += 2 * newWords.size();
+    finishStage(wordDefinitions.size());
+
+    startStage("update", "Updating words");
+    int numRows = 0;
+
+    LetterBag letterBag;
+    WordPipeline pipeline (letterBag);
+    setUpPipeline(pipeline);
+
     QSqlQuery transactionQuery ("BEGIN TRANSACTION", db);
+    QSqlQuery insertQuery (db);
+    insertQuery.prepare(getInsertQuery(INSERT_WORDS_PREFIX,
+        NUM_INSERT_COLUMNS, INSERT_ROWS_PER_QUERY));
+    QSqlQuery selectQuery (db);
+    selectQuery.prepare("SELECT word, playability, combinations0, "
+        "combinations1, combinations2, alphagram, num_unique_letters, "
+        "num_vowels, point_value, front_hooks, back_hooks, is_front_hook, "
+        "is_back_hook, lexicon_symbols, definition FROM words WHERE "
+        "length=?");
+    QSqlQuery deleteQuery (db);
+    deleteQuery.prepare("DELETE FROM words WHERE length=?");
+    QSqlQuery hookQuery (db);
+    hookQuery.prepare("UPDATE words SET front_hooks=?, back_hooks=?, "
+        "is_front_hook=?, is_back_hook=?, lexicon_symbols=? WHERE word=?");
+
+    foreach (int length, lengths) {
+        if (cancelled)
+            break;
+
+        WordBlock block (letterBag, length, computeLengthWords.value(length));
+        computeWordBlock(pipeline, &block);
+        stepNum += block.words.size();
+        emit progress(stepNum);
 
-    for (int numBlanks = -1; numBlanks <= 2; ++numBlanks) {
-        QString valueCol = (numBlanks < 0 ? "playability"
-            : QString("combinations%1").arg(numBlanks));
-        QString orderCol = (numBlanks < 0 ? "playability_order"
-            : QString("probability_order%1").arg(numBlanks));
-        QString minOrderCol = "min_" + orderCol;
-        QString maxOrderCol = "max_" + orderCol;
-
-        QSqlQuery updateQuery (db);
-        updateQuery.prepare(QString("UPDATE words SET %1=?, %2=?, %3=? "
-            "WHERE word=?").arg(orderCol).arg(minOrderCol).arg(maxOrderCol));
-
-        for (int length = 1; length <= MAX_WORD_LEN; ++length) {
-            QSqlQuery selectQuery (db);
-            selectQuery.prepare(QString("SELECT word, %1 FROM words "
-                "WHERE length=? ORDER BY %1 DESC").arg(valueCol));
-
-            selectQuery.bindValue(0, length);
-            selectQuery.exec();
-
-            QMap<QString, QString> equalWordMap;
-            int order = 1;
-            int minOrder = 1;
-            double prevValue = 0;
-
-            while (selectQuery.next()) {
-                QString word = selectQuery.value(0).toString();
-                double value = selectQuery.value(1).toDouble();
-
-                // Update probability ranges
-                if ((value != prevValue) && !equalWordMap.empty()) {
-                    int maxOrder = minOrder + equalWordMap.size() - 1;
-                    QMapIterator<QString, QString> jt (equalWordMap);
-                    while (jt.hasNext()) {
-                        jt.next();
-                        QString equalWord = jt.value();
-                        updateQuery.bindValue(0, order);
-                        updateQuery.bindValue(1, minOrder);
-                        updateQuery.bindValue(2, maxOrder);
-                        updateQuery.bindValue(3, equalWord);
-                        updateQuery.exec();
-
-                        if ((stepNum % PROGRESS_STEP) == 0) {
-                            if (cancelled) {
-                                transactionQuery.exec("END TRANSACTION");
-                                return;
-                            }
-                            emit progress(stepNum);
-                        }
-
-                        ++order;
-                        ++stepNum;
-                    }
-                    minOrder = order;
-                    equalWordMap.clear();
-                }
-
-                // Sort words by alphagram
-                QString radix = Auxil::getAlphagram(word) + word;
-                equalWordMap.insert(radix, word);
-
-                prevValue = value;
-            }
+        // Only the hooks of words of this length have changed
+        if (!changedLengths.contains(length)) {
+            QVariantList wordValues;
+            foreach (const QString& word, block.words)
+                wordValues.append(word);
+            hookQuery.bindValue(0, block.frontHookValues);
+            hookQuery.bindValue(1, block.backHookValues);
+            hookQuery.bindValue(2, block.isFrontHookValues);
+            hookQuery.bindValue(3, block.isBackHookValues);
+            hookQuery.bindValue(4, block.symbolValues);
+            hookQuery.bindValue(5, wordValues);
+            hookQuery.execBatch();
+
+            numRows += block.words.size();
+            stepNum += block.words.size();
+            emit progress(stepNum);
+            continue;
+        }
 
-            int maxOrder = minOrder + equalWordMap.size() - 1;
-            QMapIterator<QString, QString> jt (equalWordMap);
-            while (jt.hasNext()) {
-                jt.next();
-                QString equalWord = jt.value();
-                updateQuery.bindValue(0, order);
-                updateQuery.bindValue(1, minOrder);
-                updateQuery.bindValue(2, maxOrder);
-                updateQuery.bindValue(3, equalWord);
-                updateQuery.exec();
-                ++order;
-                ++stepNum;
+        // Keep the rows of words that have not changed, and the definitions
+        // of words that have been computed again
+        WordBlock rows (letterBag, length, QStringList());
+        QMap<QString, QVariant> oldDefinitions;
+        selectQuery.bindValue(0, length);
+        selectQuery.exec();
+        while (selectQuery.next()) {
+            QString word = selectQuery.value(0).toString();
+            if (!newWords.contains(word))
+                continue;
+            if (computeWords.contains(word)) {
+                oldDefinitions.insert(word, selectQuery.value(14));
+                continue;
             }
+
+            rows.words.append(word);
+            rows.playabilityValues.append(selectQuery.value(1));
+            rows.features.combinations0.append(selectQuery.value(2));
+            rows.features.combinations1.append(selectQuery.value(3));
+            rows.features.combinations2.append(selectQuery.value(4));
+            rows.features.alphagrams.append(selectQuery.value(5));
+            rows.features.numUniqueLetters.append(selectQuery.value(6));
+            rows.features.numVowels.append(selectQuery.value(7));
+            rows.features.pointValues.append(selectQuery.value(8));
+            rows.frontHookValues.append(selectQuery.value(9));
+            rows.backHookValues.append(selectQuery.value(10));
+            rows.isFrontHookValues.append(selectQuery.value(11));
+            rows.isBackHookValues.append(selectQuery.value(12));
+            rows.symbolValues.append(selectQuery.value(13));
+            rows.definitionValues.append(selectQuery.value(14));
+        }
+
+        foreach (const QString& word, block.words) {
+            QMap<QString, QVariant>::const_iterator ot =
+                oldDefinitions.find(word);
+            QMap<QString, QString>::const_iterator dt =
+                wordDefinitions.find(word);
+            if (ot != oldDefinitions.end())
+                block.definitionValues.append(ot.value());
+            else if (dt != wordDefinitions.end())
+                block.definitionValues.append(dt.value());
+            else
+                block.definitionValues.append(QVariant(QVariant::String));
         }
+        rows.append(block);
+
+        deleteQuery.bindValue(0, length);
+        deleteQuery.exec();
+        insertLength(db, insertQuery, rows, stepNum);
+        numRows += rows.words.size();
     }
 
+    query.prepare("UPDATE lexicon_date SET date=?");
+    query.bindValue(0, Auxil::lexiconToDate(lexiconName));
+    query.exec();
+
+    query.prepare("UPDATE lexicon_file SET file=?");
+    query.bindValue(0, wordEngine->getLexiconFile(lexiconName));
+    query.exec();
+
     transactionQuery.exec("END TRANSACTION");
+    finishStage(numRows);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  getOrders
+//
+//! Get the order of each word of a length by a value.  Words of equal value
+//! are ordered by alphagram, and share the range of orders they occupy.
+//
+//! @param values the value of each word
+//! @param radixes the alphagram of each word followed by the word
+//! @param orders returns the order of each word, starting at 1
+//! @param minOrders returns the first order of words of equal value
+//! @param maxOrders returns the last order of words of equal value
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::getOrders(const QVariantList& values, const
+                                QStringList& radixes, QVariantList* orders,
+                                QVariantList* minOrders, QVariantList*
+                                maxOrders) const
+{
+    int numWords = radixes.size();
+    QVector<OrderKey> keys (numWords);
+    for (int i = 0; i < numWords; ++i)
+        keys[i] = OrderKey(values[i].toDouble(), radixes[i], i);
+    qSort(keys);
+
+    QVector<int> orderVector (numWords);
+    QVector<int> minOrderVector (numWords);
+    QVector<int> maxOrderVector (numWords);
+    for (int start = 0; start < numWords; ) {
+        int end = start + 1;
+        while ((end < numWords) && (keys[end].value == keys[start].value))
+            ++end;
+        for (int i = start; i < end; ++i) {
+            int index = keys[i].index;
+            orderVector[index] = i + 1;
+            minOrderVector[index] = start + 1;
+            maxOrderVector[index] = end;
+        }
+        start = end;
+    }
+
+    for (int i = 0; i < numWords; ++i) {
+        orders->append(orderVector[i]);
+        minOrders->append(minOrderVector[i]);
+        maxOrders->append(maxOrderVector[i]);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  getInsertQuery
+//
+//! Get the text of a query inserting a number of rows at once.  The rows
+//! are combined with UNION ALL, which unlike a list of VALUES is understood
+//! by every version of SQLite.
+//
+//! @param prefix the start of the query, naming the table and columns
+//! @param numColumns the number of columns
+//! @param numRows the number of rows
+//! @return the query text, with a placeholder for each value
+//---------------------------------------------------------------------------
+QString
+CreateDatabaseThread::getInsertQuery(const QString& prefix, int numColumns,
+                                     int numRows) const
+{
+    QStringList placeholders;
+    for (int i = 0; i < numColumns; ++i)
+        placeholders.append("?");
+    QString select = "SELECT " + placeholders.join(", ");
+
+    QStringList selects;
+    for (int i = 0; i < numRows; ++i)
+        selects.append(select);
+    return prefix + selects.join(" UNION ALL ");
 }
 
 //---------------------------------------------------------------------------
-//  updateDefinitions
+//  insertRows
 //
-//! Update definitions of words in the database.
+//! Insert rows into the database, INSERT_ROWS_PER_QUERY rows at a time.
 //
 //! @param db the database
-//! @param stepNum the current step number
+//! @param fullQuery a query prepared to insert INSERT_ROWS_PER_QUERY rows
+//! @param prefix the start of the query, naming the table and columns
+//! @param columns the values of each column, one for each row
 //---------------------------------------------------------------------------
 void
-CreateDatabaseThread::updateDefinitions(QSqlDatabase& db, int& stepNum)
+CreateDatabaseThread::insertRows(QSqlDatabase& db, QSqlQuery& fullQuery,
+                                 const QString& prefix, const
+                                 QList<QVariantList>& columns) const
 {
-    QSqlQuery transactionQuery ("BEGIN TRANSACTION", db);
+    int numColumns = columns.size();
+    int numRows = numColumns ? columns.first().size() : 0;
+    for (int start = 0; start < numRows; start += INSERT_ROWS_PER_QUERY) {
+        int end = qMin(start + INSERT_ROWS_PER_QUERY, numRows);
+        QSqlQuery partQuery (db);
+        QSqlQuery* query = &fullQuery;
+        if (end - start < INSERT_ROWS_PER_QUERY) {
+            partQuery.prepare(getInsertQuery(prefix, numColumns,
+                                             end - start));
+            query = &partQuery;
+        }
 
-    QSqlQuery query (db);
-    query.prepare("UPDATE words SET definition=? WHERE word=?");
+        int bindNum = 0;
+        for (int row = start; row < end; ++row) {
+            for (int column = 0; column < numColumns; ++column)
+                query->bindValue(bindNum++, columns[column][row]);
+        }
+        query->exec();
+    }
+}
 
-    QMap<QString, QString> definitionMap;
-    QFile definitionFile (definitionFilename);
-    if (definitionFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        bool readNewline = true;
-        char* buffer = new char[MAX_INPUT_LINE_LEN * 2 + 1];
-        while (definitionFile.readLine(buffer, MAX_INPUT_LINE_LEN) > 0) {
-            QString line (buffer);
-
-            // If first line didn't contain newline, skip subsequent reads
-            // until we see a newline (effectively truncating long lines)
-            bool skip = !readNewline;
-            readNewline = (line.right(1) == QString("\n"));
-            if (skip)
-                continue;
+//---------------------------------------------------------------------------
+//  computeWordBlock
+//
+//! Compute the values of the rows of a block of words, other than those
+//! known from the block itself.  Called by feature threads, so only reads
+//! the word engine and the pipeline.
+//
+//! @param pipeline the pipeline holding the block
+//! @param block the block
+//---------------------------------------------------------------------------
+void
+CreateDatabaseThread::computeWordBlock(const WordPipeline& pipeline,
+                                       WordBlock* block) const
+{
+    block->features.compute(block->words);
+    QVector<qint64> playability =
+        pipeline.playability.getValues(block->words);
+
+    // The lexicon is looked up once for the whole block
+    WordEngine::Lexicon lexicon = wordEngine->getLexicon(lexiconName);
+
+    int wordNum = 0;
+    const QList<LexiconStyle>& lexStyles = pipeline.lexStyles;
+    foreach (const QString& word, block->words) {
+        // Read the hooks from the word graph, and look up the words formed
+        // by removing a letter at either end
+        QStringList hookWords;
+        hookWords << word.right(word.length() - 1);
+        hookWords << word.left(word.length() - 1);
+        QBitArray hookAcceptable = lexicon.areAcceptable(hookWords);
+
+        int isFrontHook = hookAcceptable.testBit(0) ? 1 : 0;
+        int isBackHook = hookAcceptable.testBit(1) ? 1 : 0;
+
+        quint32 frontHooks = 0;
+        quint32 backHooks = 0;
+        lexicon.getHooks(word, &frontHooks, &backHooks);
+
+        QString front, back;
+        for (int i = 0; i < NUM_HOOK_LETTERS; ++i) {
+            QChar letter (ushort('A' + i));
+            if (frontHooks & (1 << i))
+                front += letter;
+            if (backHooks & (1 << i))
+                back += letter;
+        }
 
-            line = line.simplified();
-            if (!line.length() || (line.at(0) == '#')) {
-                if ((stepNum % PROGRESS_STEP) == 0) {
-                    if (cancelled) {
-                        transactionQuery.exec("END TRANSACTION");
-                        delete buffer;
-                        return;
-                    }
-                    emit progress(stepNum);
-                }
-                ++stepNum;
-                continue;
+        // Populate words and hooks with symbols
+        QString symbolStr;
+        if (!lexStyles.isEmpty()) {
+            QStringList checkWords;
+            checkWords << word;
+            for (int i = 0; i < front.length(); ++i)
+                checkWords << front.at(i) + word;
+            for (int i = 0; i < back.length(); ++i)
+                checkWords << word + back.at(i);
+            QVector<quint32> membership =
+                wordEngine->getLexiconMembership(pipeline.compareLexicons,
+                                                 checkWords);
+
+            symbolStr = getStyleSymbols(lexStyles, pipeline.styleMasks,
+                                        membership[0]);
+
+            QString frontStr;
+            for (int i = 0; i < front.length(); ++i) {
+                frontStr += front.at(i) + getStyleSymbols(lexStyles,
+                    pipeline.styleMasks, membership[1 + i]);
             }
-            QString word = line.section(' ', 0, 0).toUpper();
-            QString definition = line.section(' ', 1);
-
-            query.bindValue(0, definition);
-            query.bindValue(1, word);
-            query.exec();
-
-            if ((stepNum % PROGRESS_STEP) == 0) {
-                if (cancelled) {
-                    transactionQuery.exec("END TRANSACTION");
-                    delete buffer;
-                    return;
-                }
-                emit progress(stepNum);
+
+            QString backStr;
+            for (int i = 0; i < back.length(); ++i) {
+                backStr += back.at(i) + getStyleSymbols(lexStyles,
+                    pipeline.styleMasks, membership[1 + front.length() + i]);
             }
-            ++stepNum;
+
+            front = frontStr;
+            back = backStr;
         }
-        delete buffer;
+
+        block->playabilityValues.append(playability[wordNum++]);
+        block->frontHookValues.append(front.toLower());
+        block->backHookValues.append(back.toLower());
+        block->isFrontHookValues.append(isFrontHook);
+        block->isBackHookValues.append(isBackHook);
+        block->symbolValues.append(symbolStr);
     }
+}
 
-    transactionQuery.exec("END TRANSACTION");
+//---------------------------------------------------------------------------
+//  getStyleSymbols
+//
+//! Get the symbols of the lexicon styles that apply to a word.
+//
+//! @param styles the lexicon styles
+//! @param styleMasks for each style, the bit of its compared lexicon
+//! @param membership the bits of the compared lexicons containing the word
+//! @return the symbol string
+//---------------------------------------------------------------------------
+QString
+CreateDatabaseThread::getStyleSymbols(const QList<LexiconStyle>& styles,
+                                      const QVector<quint32>& styleMasks,
+                                      quint32 membership) const
+{
+    QString symbols;
+    for (int i = 0; i < styles.size(); ++i) {
+        bool acceptable = (membership & styleMasks[i]);
+        if (!(acceptable ^ styles[i].inCompareLexicon))
+            symbols += styles[i].symbol;
+    }
+    return symbols;
 }
 
 //---------------------------------------------------------------------------
@@ -582,104 +1589,168 @@ CreateDatabaseThread::cancel()
 void
 CreateDatabaseThread::cleanup()
 {
-    QSqlDatabase::removeDatabase(DB_CONNECTION_NAME);
+    QSqlDatabase::removeDatabase(getConnectionName(DB_CONNECTION_NAME));
 }
 
 //---------------------------------------------------------------------------
-//  updateDefinitionLinks
+//  readDefinitions
 //
-//! Update links within definitions of words in the database.
+//! Read the definitions of the words in the lexicon from the definition
+//! file, with links within definitions already replaced.  Definitions that
+//! consist of more than part of speech are also put in the definitions map,
+//! so links to them can be followed.
 //
-//! @param db the database
+//! @param wordDefinitions returns the definition of each word
 //! @param stepNum the current step number
 //---------------------------------------------------------------------------
 void
-CreateDatabaseThread::updateDefinitionLinks(QSqlDatabase& db, int& stepNum)
+CreateDatabaseThread::readDefinitions(QMap<QString, QString>&
+                                      wordDefinitions, int& stepNum)
 {
-    getDefinitions(db, stepNum);
-
-    if (cancelled)
+    QFile definitionFile (definitionFilename);
+    if (!definitionFile.open(QIODevice::ReadOnly | QIODevice::Text))
         return;
 
-    QSqlQuery updateQuery (db);
-    updateQuery.prepare("UPDATE words SET definition=? WHERE word=?");
-
-    QSqlQuery transactionQuery ("BEGIN TRANSACTION", db);
-
-    QSet<QString> alreadyReplaced;
-    QMapIterator<QString, QString> it (definitions);
-    while (it.hasNext()) {
-        it.next();
-        QString word = it.key();
-        QString definition = it.value();
-
-        QStringList defs = definition.split(WordEngine::DEF_ORIG_SEP);
-        QString newDefinition;
-        foreach (const QString& def, defs) {
-            if (!newDefinition.isEmpty())
-                newDefinition += WordEngine::DEF_DISPLAY_SEP;
-
-            alreadyReplaced.clear();
-            alreadyReplaced.insert(word.toUpper());
-
-            newDefinition += replaceDefinitionLinks(def, MAX_DEFINITION_LINKS,
-                &alreadyReplaced);
-        }
-
-        if (definition != newDefinition) {
-            updateQuery.bindValue(0, newDefinition);
-            updateQuery.bindValue(1, word);
-            updateQuery.exec();
-        }
+    QStringList fileWords;
+    QStringList fileDefinitions;
+    bool readNewline = true;
+    char* buffer = new char[MAX_INPUT_LINE_LEN * 2 + 1];
+    while (definitionFile.readLine(buffer, MAX_INPUT_LINE_LEN) > 0) {
+        QString line (buffer);
 
-        ++stepNum;
+        // If first line didn't contain newline, skip subsequent reads
+        // until we see a newline (effectively truncating long lines)
+        bool skip = !readNewline;
+        readNewline = (line.right(1) == QString("\n"));
+        if (skip)
+            continue;
 
         if ((stepNum % PROGRESS_STEP) == 0) {
             if (cancelled) {
-                transactionQuery.exec("END TRANSACTION");
+                delete[] buffer;
                 return;
             }
             emit progress(stepNum);
         }
+        ++stepNum;
+
+        line = line.simplified();
+        if (!line.length() || (line.at(0) == '#'))
+            continue;
+
+        fileWords.append(line.section(' ', 0, 0).toUpper());
+        fileDefinitions.append(line.section(' ', 1));
     }
+    delete[] buffer;
 
-    transactionQuery.exec("END TRANSACTION");
+    // Keep only the definitions of words in the lexicon, with later lines
+    // taking the place of earlier ones
+    QBitArray acceptable = wordEngine->areAcceptable(lexiconName, fileWords);
+    for (int i = 0; i < fileWords.size(); ++i) {
+        if (acceptable.testBit(i))
+            wordDefinitions[fileWords[i]] = fileDefinitions[i];
+    }
+
+    QRegExp defRegex (QString("^[^[]|\\s+/\\s+[^[]"));
+    QMapIterator<QString, QString> it (wordDefinitions);
+    while (it.hasNext()) {
+        it.next();
+        if (defRegex.indexIn(it.value(), 0) >= 0)
+            definitions[it.key()] = it.value();
+    }
+
+    // Replace links within definitions, dividing the definitions among
+    // link threads since each can be resolved on its own
+    QStringList linkWords = definitions.keys();
+    QVector<QString> linkResults (linkWords.size());
+    QAtomicInt nextLinkBlock (0);
+    QList<LinkThread*> threads;
+    for (int i = 0; i < getNumThreads(); ++i) {
+        LinkThread* thread = new LinkThread(this, &linkWords,
+            linkResults.data(), &nextLinkBlock);
+        threads.append(thread);
+        thread->start();
+    }
+    foreach (LinkThread* thread, threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    for (int i = 0; i < linkWords.size(); ++i)
+        wordDefinitions[linkWords[i]] = linkResults[i];
+
+    stepNum += linkWords.size();
+    emit progress(stepNum);
 }
 
 //---------------------------------------------------------------------------
-//  getDefinitions
+//  LinkThread
 //
-//! Get word definitions from the database and put them in the definitions
-//! map.  Discard any definitions that consist of only part of speech.
-//
-//! @param db the database
-//! @param stepNum the current step number
+//! A thread that replaces the links within definitions, taking blocks of
+//! words from a shared counter until none are left.  Each thread remembers
+//! the subdefinitions it has looked up, since many definitions link to the
+//! same words.
 //---------------------------------------------------------------------------
-void
-CreateDatabaseThread::getDefinitions(QSqlDatabase& db, int& stepNum)
+class CreateDatabaseThread::LinkThread : public QThread
 {
-    QSqlQuery selectQuery (db);
-    selectQuery.prepare("SELECT word, definition FROM words");
-    selectQuery.exec();
+    public:
+    LinkThread(const CreateDatabaseThread* c, const QStringList* w,
+               QString* r, QAtomicInt* n)
+        : QThread(), creator(c), words(w), results(r), nextBlock(n) { }
+    ~LinkThread() { }
+
+    protected:
+    void run() {
+        QHash<QString, QString> subDefinitions;
+        int numWords = words->size();
+        while (true) {
+            int start = nextBlock->fetchAndAddOrdered(1) * PROGRESS_STEP;
+            if (start >= numWords)
+                break;
+            int end = qMin(start + PROGRESS_STEP, numWords);
+            for (int i = start; i < end; ++i) {
+                results[i] = creator->resolveDefinitionLinks(words->at(i),
+                    &subDefinitions);
+            }
+        }
+    }
 
-    QRegExp defRegex (QString("^[^[]|\\s+/\\s+[^[]"));
+    private:
+    const CreateDatabaseThread* creator;
+    const QStringList* words;
+    QString* results;
+    QAtomicInt* nextBlock;
+};
 
-    while (selectQuery.next()) {
-        QString word = selectQuery.value(0).toString();
-        QString definition = selectQuery.value(1).toString();
+//---------------------------------------------------------------------------
+//  resolveDefinitionLinks
+//
+//! Replace the links within each part of the definition of a word.
+//
+//! @param word the word, which must be in the definitions map
+//! @param subDefinitions the subdefinitions already looked up, keyed by
+//! word and part of speech
+//! @return the definition with links replaced
+//---------------------------------------------------------------------------
+QString
+CreateDatabaseThread::resolveDefinitionLinks(const QString& word,
+    QHash<QString, QString>* subDefinitions) const
+{
+    QSet<QString> alreadyReplaced;
+    QStringList defs = definitions.value(word).split(
+        WordEngine::DEF_ORIG_SEP);
+    QString newDefinition;
+    foreach (const QString& def, defs) {
+        if (!newDefinition.isEmpty())
+            newDefinition += WordEngine::DEF_DISPLAY_SEP;
 
-        if (defRegex.indexIn(definition, 0) < 0) {
-            ++stepNum;
-            if ((stepNum % PROGRESS_STEP) == 0) {
-                if (cancelled)
-                    return;
-                emit progress(stepNum);
-            }
-            continue;
-        }
+        alreadyReplaced.clear();
+        alreadyReplaced.insert(word.toUpper());
 
-        definitions[word] = definition;
+        newDefinition += replaceDefinitionLinks(def, MAX_DEFINITION_LINKS,
+            &alreadyReplaced, false, subDefinitions);
     }
+    return newDefinition;
 }
 
 //---------------------------------------------------------------------------
@@ -692,12 +1763,15 @@ CreateDatabaseThread::getDefinitions(QSqlDatabase& db, int& stepNum)
 //! @param definition the definition with links to be replaced
 //! @param maxDepth the maximum number of recursive links to replace
 //! @param useFollow true if the "follow" replacement should be used
+//! @param subDefinitions if not null, the subdefinitions already looked
+//! up, keyed by word and part of speech
 //
 //! @return a string with links replaced
 //---------------------------------------------------------------------------
 QString
 CreateDatabaseThread::replaceDefinitionLinks(const QString& definition,
-    int maxDepth, QSet<QString>* alreadyReplaced, bool useFollow) const
+    int maxDepth, QSet<QString>* alreadyReplaced, bool useFollow,
+    QHash<QString, QString>* subDefinitions) const
 {
     QRegExp followRegex (QString("\\{(\\w+)=(\\w+)\\}"));
     QRegExp replaceRegex (QString("\\<(\\w+)=(\\w+)\\>"));
@@ -737,7 +1811,7 @@ CreateDatabaseThread::replaceDefinitionLinks(const QString& definition,
         replacement = failReplacement;
     }
     else {
-        QString subdef = getSubDefinition(upper, pos);
+        QString subdef = getSubDefinition(upper, pos, subDefinitions);
         if (subdef.isEmpty()) {
             replacement = failReplacement;
             cutRecursion = true;
@@ -756,7 +1830,7 @@ CreateDatabaseThread::replaceDefinitionLinks(const QString& definition,
     int lowerMaxDepth = useFollow ? maxDepth - 1 : maxDepth;
     QString newDefinition = cutRecursion ? modified
         : replaceDefinitionLinks(modified, lowerMaxDepth, alreadyReplaced,
-            useFollow);
+            useFollow, subDefinitions);
 
     if (createdSet) {
         delete alreadyReplaced;
@@ -768,18 +1842,49 @@ CreateDatabaseThread::replaceDefinitionLinks(const QString& definition,
 //---------------------------------------------------------------------------
 //  getSubDefinition
 //
-//! Return the definition associated with a word and a part of speech.  If
-//! more than one definition is given for a part of speech, pick the first
-//! one.
+//! Return the definition associated with a word and a part of speech,
+//! looking it up only once if the subdefinitions already looked up are
+//! given.
 //
 //! @param word the word
 //! @param pos the part of speech
+//! @param subDefinitions if not null, the subdefinitions already looked
+//! up, keyed by word and part of speech
 //
 //! @return the definition substring
 //---------------------------------------------------------------------------
 QString
 CreateDatabaseThread::getSubDefinition(const QString& word, const QString&
-                                       pos) const
+    pos, QHash<QString, QString>* subDefinitions) const
+{
+    if (!subDefinitions)
+        return findSubDefinition(word, pos);
+
+    QString key = word + "=" + pos;
+    QHash<QString, QString>::const_iterator it = subDefinitions->find(key);
+    if (it != subDefinitions->end())
+        return it.value();
+
+    QString subdef = findSubDefinition(word, pos);
+    subDefinitions->insert(key, subdef);
+    return subdef;
+}
+
+//---------------------------------------------------------------------------
+//  findSubDefinition
+//
+//! Find the definition associated with a word and a part of speech in the
+//! definitions map.  If more than one definition is given for a part of
+//! speech, pick the first one.
+//
+//! @param word the word
+//! @param pos the part of speech
+//
+//! @return the definition substring
+//---------------------------------------------------------------------------
+QString
+CreateDatabaseThread::findSubDefinition(const QString& word, const QString&
+                                        pos) const
 {
     if (!definitions.contains(word))
         return QString();
@@ -799,59 +1904,3 @@ CreateDatabaseThread::getSubDefinition(const QString& word, const QString&
 
     return QString();
 }
-
-//---------------------------------------------------------------------------
-//  importPlayability
-//
-//! Import playability values for a lexicon from a file.  The file is assumed
-//! to be in plain text format, containing one playability value and word per
-//! line.
-//
-//! @param lexicon the name of the lexicon
-//! @param filename the name of the file to import
-//! @param errString returns the error string in case of error
-//! @return the number of playability values imported
-//---------------------------------------------------------------------------
-int
-CreateDatabaseThread::importPlayability(const QString& filename,
-    QMap<QString, qint64>& playabilityMap) const
-{
-    playabilityMap.clear();
-
-    QFile file (filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-        return 0;
-
-    QStringList words;
-    QSet<QString> alphagrams;
-    int imported = 0;
-    bool readNewline = true;
-    char* buffer = new char[MAX_INPUT_LINE_LEN * 2 + 1];
-    while (file.readLine(buffer, MAX_INPUT_LINE_LEN) > 0) {
-        QString line (buffer);
-
-        // If first line didn't contain newline, skip subsequent reads
-        // until we see a newline (effectively truncating long lines)
-        bool skip = !readNewline;
-        readNewline = (line.right(1) == QString("\n"));
-        if (skip)
-            continue;
-
-        line = line.simplified();
-        if (line.isEmpty() || (line.at(0) == '#'))
-            continue;
-        bool ok = false;
-        qint64 playability = line.section(' ', 0, 0).toLongLong(&ok);
-        if (!ok)
-            continue;
-        QString word = line.section(' ', 1, 1);
-        if (word.isEmpty())
-            continue;
-
-        playabilityMap[word] = playability;
-        ++imported;
-    }
-    delete[] buffer;
-
-    return imported;
-}
@@ -25,10 +25,19 @@
 #ifndef ZYZZYVA_CREATE_DATABASE_THREAD_H
 #define ZYZZYVA_CREATE_DATABASE_THREAD_H
 
+#include "LexiconSnapshot.h"
+#include "LexiconStyle.h"
+#include <QHash>
+#include <QList>
 #include <QMap>
 #include <QString>
+#include <QStringList>
 #include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QVariant>
 #include <QThread>
+#include <QTime>
+#include <QVector>
 
 class WordEngine;
 
@@ -39,9 +48,13 @@ class CreateDatabaseThread : public QThread
     CreateDatabaseThread(WordEngine* e, const QString& lex, const QString& db,
                          const QString& def, QObject* parent = 0)
         : QThread(parent), wordEngine(e), lexiconName(lex),
-          dbFilename(db), definitionFilename(def), cancelled(false) { }
+          dbFilename(db), definitionFilename(def), cancelled(false),
+          numThreads(0) { }
     ~CreateDatabaseThread() { }
 
+    void setBaseFilename(const QString& base) { baseFilename = base; }
+    void setNumThreads(int n) { numThreads = n; }
+    int getNumThreads() const;
     bool getCancelled() { return cancelled; }
     QString getError() { return error; }
 
@@ -53,34 +66,83 @@ class CreateDatabaseThread : public QThread
     void steps(int s);
     void progress(int p);
     void done(bool success);
+    void status(const QString& text);
+    void stageStarted(const QString& stage);
+    void stageFinished(const QString& stage, int rows, int msecs);
 
     protected:
     void run();
 
+    private:
+    class WordBlock;
+    class WordPipeline;
+    class FeatureThread;
+    class OrderThread;
+    class LinkThread;
+
     private:
     void runPrivate();
+    bool runIncremental();
+    void moveBuildFile(const QString& buildFilename);
+    void writeSnapshot();
+    bool readSnapshotColumns(QSqlDatabase& db, LexiconSnapshot::Columns&
+                             columns) const;
+    QString getConnectionName(const QString& base) const;
+    void startStage(const QString& stage, const QString& description);
+    void finishStage(int rows);
+    void writeStageLog();
+    void setBulkBuildPragmas(QSqlDatabase& db);
     void createTables(QSqlDatabase& db);
     void createIndexes(QSqlDatabase& db);
+    void analyzeDatabase(QSqlDatabase& db);
+    int saveSearchStats(QSqlDatabase& db);
     void insertVersion(QSqlDatabase& db);
-    void insertWords(QSqlDatabase& db, int& stepNum);
-    void updatePlayabilityOrder(QSqlDatabase& db, int& stepNum);
-    void updateProbabilityOrder(QSqlDatabase& db, int& stepNum);
-    void updateDefinitions(QSqlDatabase& db, int& stepNum);
-    void updateDefinitionLinks(QSqlDatabase& db, int& stepNum);
-
-    void getDefinitions(QSqlDatabase& db, int& stepNum);
+    void readDefinitions(QMap<QString, QString>& wordDefinitions, int&
+                         stepNum);
+    void setUpPipeline(WordPipeline& pipeline) const;
+    QStringList getLexiconWords(int length) const;
+    void insertWords(QSqlDatabase& db, const QMap<QString, QString>&
+                     wordDefinitions, int& stepNum);
+    void insertLength(QSqlDatabase& db, QSqlQuery& insertQuery, const
+                      WordBlock& rows, int& stepNum);
+    bool updateWords(QSqlDatabase& db, int& numSteps);
+    void getOrders(const QVariantList& values, const QStringList& radixes,
+                   QVariantList* orders, QVariantList* minOrders,
+                   QVariantList* maxOrders) const;
+    void computeWordBlock(const WordPipeline& pipeline, WordBlock* block)
+        const;
+    QString getInsertQuery(const QString& prefix, int numColumns, int
+                           numRows) const;
+    void insertRows(QSqlDatabase& db, QSqlQuery& fullQuery, const QString&
+                    prefix, const QList<QVariantList>& columns) const;
+    QString resolveDefinitionLinks(const QString& word, QHash<QString,
+                                   QString>* subDefinitions) const;
     QString replaceDefinitionLinks(const QString& definition, int maxDepth,
-        QSet<QString>* alreadyReplaced = 0, bool useFollow = false) const;
-    QString getSubDefinition(const QString& word, const QString& pos) const;
-    int importPlayability(const QString& filename, QMap<QString, qint64>&
-                          playabilityMap) const;
+        QSet<QString>* alreadyReplaced = 0, bool useFollow = false,
+        QHash<QString, QString>* subDefinitions = 0) const;
+    QString getSubDefinition(const QString& word, const QString& pos,
+        QHash<QString, QString>* subDefinitions = 0) const;
+    QString findSubDefinition(const QString& word, const QString& pos) const;
+    QString getStyleSymbols(const QList<LexiconStyle>& styles, const
+                            QVector<quint32>& styleMasks, quint32 membership)
+                            const;
 
     WordEngine* wordEngine;
     QString lexiconName;
     QString dbFilename;
     QString definitionFilename;
+    QString baseFilename;
     bool cancelled;
     QString error;
+
+    // Number of worker threads, or zero to use one per processor
+    int numThreads;
+
+    // Timing of the stages of creating the database, for the build log
+    QString buildMode;
+    QString stageName;
+    QTime stageTimer;
+    QStringList stageRecords;
     QMap<QString, QString> definitions;
 };
 
@@ -0,0 +1,197 @@
+//---------------------------------------------------------------------------
+// DatabaseIndexSet.cpp
+//
+// A class representing a set of lexicon database indexes.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "DatabaseIndexSet.h"
+#include "MainSettings.h"
+#include "SearchSpec.h"
+#include <QRegExp>
+
+const QString INDEX_SET_PLAYABILITY = "playability";
+const QString INDEX_SET_PROBABILITY = "probability%1";
+const QString INDEX_SET_DEFINITION = "definition";
+const int NUM_PROBABILITY_INDEX_SETS = 3;
+
+//---------------------------------------------------------------------------
+//  getRequiredQueries
+//
+//! Get the queries creating the indexes that every database must have.
+//
+//! @return the queries
+//---------------------------------------------------------------------------
+QStringList
+DatabaseIndexSet::getRequiredQueries()
+{
+    QStringList queries;
+    queries << "CREATE UNIQUE INDEX IF NOT EXISTS word_index on words (word)";
+    queries << "CREATE INDEX IF NOT EXISTS word_length_index on words "
+               "(length)";
+    return queries;
+}
+
+//---------------------------------------------------------------------------
+//  getIndexSets
+//
+//! Get the optional index sets of a lexicon database, with the mode of each
+//! set declared for the lexicon in the settings.  Sets not declared for the
+//! lexicon are built, except that only the probability order set of the
+//! number of blanks used for probability is built and the others are
+//! deferred, and the definition set is skipped since LIKE conditions on
+//! definitions cannot use it.
+//
+//! @param lexicon the name of the lexicon
+//! @return the index sets
+//---------------------------------------------------------------------------
+QList<DatabaseIndexSet>
+DatabaseIndexSet::getIndexSets(const QString& lexicon)
+{
+    QMap<QString, Mode> modes = getModes(lexicon);
+    int numBlanks = MainSettings::getProbabilityNumBlanks();
+
+    QList<DatabaseIndexSet> indexSets;
+    DatabaseIndexSet indexSet;
+    indexSet.name = INDEX_SET_PLAYABILITY;
+    indexSet.mode = modes.value(indexSet.name, BuildMode);
+    indexSet.indexNames << "play_index" << "play_min_max_index";
+    indexSet.createQueries << "CREATE UNIQUE INDEX IF NOT EXISTS play_index "
+        "on words (length, playability_order)";
+    indexSet.createQueries << "CREATE INDEX IF NOT EXISTS play_min_max_index "
+        "on words (length, min_playability_order, max_playability_order)";
+    indexSets.append(indexSet);
+
+    for (int i = 0; i < NUM_PROBABILITY_INDEX_SETS; ++i) {
+        QString col = QString("probability_order%1").arg(i);
+        QString index = QString("prob%1_index").arg(i);
+        QString minMaxIndex = QString("prob%1_min_max_index").arg(i);
+
+        DatabaseIndexSet indexSet;
+        indexSet.name = INDEX_SET_PROBABILITY.arg(i);
+        indexSet.mode = modes.value(indexSet.name,
+                                    (i == numBlanks) ? BuildMode : DeferMode);
+        indexSet.indexNames << index << minMaxIndex;
+        indexSet.createQueries << QString("CREATE UNIQUE INDEX IF NOT EXISTS "
+            "%1 on words (length, %2)").arg(index).arg(col);
+        indexSet.createQueries << QString("CREATE INDEX IF NOT EXISTS %1 on "
+            "words (length, min_%2, max_%2)").arg(minMaxIndex).arg(col);
+        indexSets.append(indexSet);
+    }
+
+    indexSet = DatabaseIndexSet();
+    indexSet.name = INDEX_SET_DEFINITION;
+    indexSet.mode = modes.value(indexSet.name, SkipMode);
+    indexSet.indexNames << "definition_index";
+    indexSet.createQueries << "CREATE INDEX IF NOT EXISTS definition_index "
+        "on words (definition)";
+    indexSets.append(indexSet);
+
+    return indexSets;
+}
+
+//---------------------------------------------------------------------------
+//  getSearchSetNames
+//
+//! Get the names of the index sets that serve the conditions of a search
+//! spec.
+//
+//! @param spec the search spec
+//! @return the names of the index sets
+//---------------------------------------------------------------------------
+QStringList
+DatabaseIndexSet::getSearchSetNames(const SearchSpec& spec)
+{
+    QStringList names;
+    foreach (const SearchCondition& condition, spec.conditions) {
+        QString name;
+        if (condition.type == SearchCondition::PlayabilityOrder)
+            name = INDEX_SET_PLAYABILITY;
+        else if ((condition.type == SearchCondition::ProbabilityOrder) &&
+                 (condition.intValue < NUM_PROBABILITY_INDEX_SETS))
+        {
+            name = INDEX_SET_PROBABILITY.arg(condition.intValue);
+        }
+        if (!name.isEmpty() && !names.contains(name))
+            names.append(name);
+    }
+    return names;
+}
+
+//---------------------------------------------------------------------------
+//  getModes
+//
+//! Get the modes of index sets declared for a lexicon in the settings.
+//! Each line of the setting declares modes for one lexicon, in the form
+//! "LEXICON: set=mode set=mode", where each mode is build, defer or skip.
+//
+//! @param lexicon the name of the lexicon
+//! @return the mode of each declared index set
+//---------------------------------------------------------------------------
+QMap<QString, DatabaseIndexSet::Mode>
+DatabaseIndexSet::getModes(const QString& lexicon)
+{
+    QMap<QString, Mode> modes;
+    QRegExp lineRegex ("^\\s*(\\S+)\\s*:(.*)$");
+    QRegExp modeRegex ("^(\\w+)=(\\w+)$");
+
+    QStringList lines = MainSettings::getDatabaseIndexSets().split("\n");
+    foreach (const QString& line, lines) {
+        if ((lineRegex.indexIn(line) < 0) || (lineRegex.cap(1) != lexicon))
+            continue;
+
+        QStringList tokens = lineRegex.cap(2).simplified().split(" ",
+            QString::SkipEmptyParts);
+        foreach (const QString& token, tokens) {
+            if (modeRegex.indexIn(token) < 0)
+                continue;
+            bool ok = false;
+            Mode mode = stringToMode(modeRegex.cap(2), &ok);
+            if (ok)
+                modes.insert(modeRegex.cap(1).toLower(), mode);
+        }
+    }
+    return modes;
+}
+
+//---------------------------------------------------------------------------
+//  stringToMode
+//
+//! Convert a string representation to an index set mode.
+//
+//! @param string the string representation
+//! @param ok returns true if the string names a mode, false otherwise
+//! @return the mode
+//---------------------------------------------------------------------------
+DatabaseIndexSet::Mode
+DatabaseIndexSet::stringToMode(const QString& string, bool* ok)
+{
+    QString lower = string.toLower();
+    *ok = true;
+    if (lower == "build")
+        return BuildMode;
+    else if (lower == "defer")
+        return DeferMode;
+    else if (lower == "skip")
+        return SkipMode;
+    *ok = false;
+    return BuildMode;
+}
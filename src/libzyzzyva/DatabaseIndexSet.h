@@ -0,0 +1,72 @@
+//---------------------------------------------------------------------------
+// DatabaseIndexSet.h
+//
+// A class representing a set of lexicon database indexes.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_DATABASE_INDEX_SET_H
+#define ZYZZYVA_DATABASE_INDEX_SET_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+class SearchSpec;
+
+// A set of indexes on the words table that serve one kind of search.  Each
+// set is either built with the database, deferred until a search first
+// needs it, or never built.
+class DatabaseIndexSet
+{
+    public:
+    enum Mode {
+        BuildMode,
+        DeferMode,
+        SkipMode
+    };
+
+    public:
+    DatabaseIndexSet() : mode(BuildMode) { }
+    ~DatabaseIndexSet() { }
+
+    QString getName() const { return name; }
+    Mode getMode() const { return mode; }
+    QStringList getIndexNames() const { return indexNames; }
+    QStringList getCreateQueries() const { return createQueries; }
+
+    static QStringList getRequiredQueries();
+    static QList<DatabaseIndexSet> getIndexSets(const QString& lexicon);
+    static QStringList getSearchSetNames(const SearchSpec& spec);
+
+    private:
+    static QMap<QString, Mode> getModes(const QString& lexicon);
+    static Mode stringToMode(const QString& string, bool* ok);
+
+    private:
+    QString name;
+    Mode mode;
+    QStringList indexNames;
+    QStringList createQueries;
+};
+
+#endif // ZYZZYVA_DATABASE_INDEX_SET_H
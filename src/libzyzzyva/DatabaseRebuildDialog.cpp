@@ -24,6 +24,7 @@
 
 #include "DatabaseRebuildDialog.h"
 #include "LexiconSelectWidget.h"
+#include "MainSettings.h"
 #include "Auxil.h"
 #include "Defs.h"
 #include <QDialogButtonBox>
@@ -50,7 +51,7 @@ DatabaseRebuildDialog::DatabaseRebuildDialog(QWidget* parent, Qt::WFlags f)
     mainVlay->setSpacing(SPACING);
 
     QLabel* instructionLabel = new QLabel;
-    QString message = "Please choose the lexicon database to rebuild.\n"
+    QString message = "Please choose the lexicon databases to rebuild.\n"
         "This may take several minutes.";
     message = Auxil::dialogWordWrap(message);
     instructionLabel->setText(message);
@@ -60,17 +61,39 @@ DatabaseRebuildDialog::DatabaseRebuildDialog(QWidget* parent, Qt::WFlags f)
     rebuildAllButton->setText("Rebuild databases for all lexicons");
     rebuildAllButton->setChecked(true);
     connect(rebuildAllButton, SIGNAL(toggled(bool)),
-            SLOT(rebuildAllToggled(bool)));
+            SLOT(rebuildButtonToggled()));
     mainVlay->addWidget(rebuildAllButton);
 
-    QRadioButton* rebuildSingleButton = new QRadioButton;
+    rebuildSingleButton = new QRadioButton;
     rebuildSingleButton->setText("Rebuild database for a single lexicon");
+    connect(rebuildSingleButton, SIGNAL(toggled(bool)),
+            SLOT(rebuildButtonToggled()));
     mainVlay->addWidget(rebuildSingleButton);
 
     lexiconWidget = new LexiconSelectWidget;
     lexiconWidget->setEnabled(false);
     mainVlay->addWidget(lexiconWidget);
 
+    rebuildSelectedButton = new QRadioButton;
+    rebuildSelectedButton->setText("Rebuild databases for selected lexicons "
+                                   "at the same time");
+    connect(rebuildSelectedButton, SIGNAL(toggled(bool)),
+            SLOT(rebuildButtonToggled()));
+    mainVlay->addWidget(rebuildSelectedButton);
+
+    lexiconList = new QListWidget;
+    foreach (const QString& lexicon, MainSettings::getAutoImportLexicons()) {
+        QListWidgetItem* item = new QListWidgetItem(lexicon, lexiconList);
+        item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Unchecked);
+    }
+    lexiconList->setEnabled(false);
+    mainVlay->addWidget(lexiconList);
+
+    incrementalCbox = new QCheckBox;
+    incrementalCbox->setText("Only update words that have changed");
+    mainVlay->addWidget(incrementalCbox);
+
     QDialogButtonBox* buttonBox = new QDialogButtonBox;
     buttonBox->setOrientation(Qt::Horizontal);
     buttonBox->setStandardButtons(QDialogButtonBox::Ok |
@@ -118,14 +141,51 @@ DatabaseRebuildDialog::getLexicon() const
 }
 
 //---------------------------------------------------------------------------
-//  rebuildAllToggled
+//  getLexicons
+//
+//! Return the lexicons whose databases should be rebuilt.
+//
+//! @return the lexicons
+//---------------------------------------------------------------------------
+QStringList
+DatabaseRebuildDialog::getLexicons() const
+{
+    if (rebuildAllButton->isChecked())
+        return MainSettings::getAutoImportLexicons();
+    if (rebuildSingleButton->isChecked())
+        return QStringList(getLexicon());
+
+    QStringList lexicons;
+    for (int i = 0; i < lexiconList->count(); ++i) {
+        QListWidgetItem* item = lexiconList->item(i);
+        if (item->checkState() == Qt::Checked)
+            lexicons.append(item->text());
+    }
+    return lexicons;
+}
+
+//---------------------------------------------------------------------------
+//  getIncremental
+//
+//! Determine whether databases should only be updated with the words that
+//! have changed in each lexicon.
 //
-//! Called when the Rebuild All button is toggled.
+//! @return true if only changed words should be updated, false otherwise
+//---------------------------------------------------------------------------
+bool
+DatabaseRebuildDialog::getIncremental() const
+{
+    return incrementalCbox->isChecked();
+}
+
+//---------------------------------------------------------------------------
+//  rebuildButtonToggled
 //
-//! @param on whether the button is checked
+//! Called when a button choosing the databases to rebuild is toggled.
 //---------------------------------------------------------------------------
 void
-DatabaseRebuildDialog::rebuildAllToggled(bool on)
+DatabaseRebuildDialog::rebuildButtonToggled()
 {
-    lexiconWidget->setEnabled(!on);
+    lexiconWidget->setEnabled(rebuildSingleButton->isChecked());
+    lexiconList->setEnabled(rebuildSelectedButton->isChecked());
 }
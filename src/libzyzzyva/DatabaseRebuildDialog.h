@@ -25,8 +25,11 @@
 #ifndef ZYZZYVA_DATABASE_REBUILD_DIALOG_H
 #define ZYZZYVA_DATABASE_REBUILD_DIALOG_H
 
+#include <QCheckBox>
 #include <QDialog>
+#include <QListWidget>
 #include <QRadioButton>
+#include <QStringList>
 
 class LexiconSelectWidget;
 
@@ -39,13 +42,19 @@ class DatabaseRebuildDialog : public QDialog
 
     bool getRebuildAll() const;
     QString getLexicon() const;
+    QStringList getLexicons() const;
+    bool getIncremental() const;
 
     public slots:
-    void rebuildAllToggled(bool on);
+    void rebuildButtonToggled();
 
     private:
     QRadioButton* rebuildAllButton;
+    QRadioButton* rebuildSingleButton;
+    QRadioButton* rebuildSelectedButton;
     LexiconSelectWidget* lexiconWidget;
+    QListWidget* lexiconList;
+    QCheckBox* incrementalCbox;
 };
 
 #endif // ZYZZYVA_DATABASE_REBUILD_DIALOG_H
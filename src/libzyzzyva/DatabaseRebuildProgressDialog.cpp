@@ -0,0 +1,294 @@
+//---------------------------------------------------------------------------
+// DatabaseRebuildProgressDialog.cpp
+//
+// A dialog for displaying the progress of lexicon databases being rebuilt.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "DatabaseRebuildProgressDialog.h"
+#include "CreateDatabaseThread.h"
+#include "Defs.h"
+#include <QDialogButtonBox>
+#include <QVBoxLayout>
+
+const QString DIALOG_CAPTION = "Creating Lexicon Databases";
+const int LEXICON_PROGRESS_STEPS = 100;
+
+using namespace Defs;
+
+//---------------------------------------------------------------------------
+//  DatabaseRebuildProgressDialog
+//
+//! Constructor.
+//
+//! @param parent the parent widget
+//! @param f widget flags
+//---------------------------------------------------------------------------
+DatabaseRebuildProgressDialog::DatabaseRebuildProgressDialog(QWidget*
+    parent, Qt::WFlags f)
+    : QDialog(parent, f), maxRunning(1), numRunning(0)
+{
+    QVBoxLayout* mainVlay = new QVBoxLayout(this);
+    mainVlay->setMargin(MARGIN);
+    mainVlay->setSpacing(SPACING);
+
+    rebuildGlay = new QGridLayout;
+    rebuildGlay->setSpacing(SPACING);
+    rebuildGlay->setColumnStretch(1, 1);
+    mainVlay->addLayout(rebuildGlay);
+
+    QLabel* totalLabel = new QLabel("Total progress:");
+    mainVlay->addWidget(totalLabel);
+
+    totalProgressBar = new QProgressBar;
+    totalProgressBar->setMaximum(0);
+    mainVlay->addWidget(totalProgressBar);
+
+    QDialogButtonBox* buttonBox = new QDialogButtonBox;
+    buttonBox->setOrientation(Qt::Horizontal);
+    QPushButton* cancelAllButton = buttonBox->addButton("Cancel &All",
+        QDialogButtonBox::RejectRole);
+    cancelAllButton->setAutoDefault(false);
+    connect(buttonBox, SIGNAL(rejected()), SLOT(reject()));
+    mainVlay->addWidget(buttonBox);
+
+    cancelMapper = new QSignalMapper(this);
+    connect(cancelMapper, SIGNAL(mapped(int)), SLOT(cancelClicked(int)));
+
+    setWindowTitle(DIALOG_CAPTION);
+}
+
+//---------------------------------------------------------------------------
+//  ~DatabaseRebuildProgressDialog
+//
+//! Destructor.
+//---------------------------------------------------------------------------
+DatabaseRebuildProgressDialog::~DatabaseRebuildProgressDialog()
+{
+}
+
+//---------------------------------------------------------------------------
+//  addThread
+//
+//! Add a thread rebuilding the database of a lexicon.  The thread is queued
+//! until started by the dialog, and is not owned by the dialog.
+//
+//! @param lexicon the lexicon
+//! @param thread the thread
+//---------------------------------------------------------------------------
+void
+DatabaseRebuildProgressDialog::addThread(const QString& lexicon,
+                                         CreateDatabaseThread* thread)
+{
+    int index = rebuilds.size();
+
+    Rebuild rebuild;
+    rebuild.thread = thread;
+
+    QLabel* lexiconLabel = new QLabel(lexicon);
+    rebuildGlay->addWidget(lexiconLabel, 2 * index, 0);
+
+    rebuild.statusLabel = new QLabel("Waiting...");
+    rebuildGlay->addWidget(rebuild.statusLabel, 2 * index, 1, 1, 2);
+
+    rebuild.progressBar = new QProgressBar;
+    rebuild.progressBar->setMaximum(LEXICON_PROGRESS_STEPS);
+    rebuild.progressBar->setValue(0);
+    rebuildGlay->addWidget(rebuild.progressBar, 2 * index + 1, 0, 1, 2);
+
+    rebuild.cancelButton = new QPushButton("Cancel");
+    rebuild.cancelButton->setAutoDefault(false);
+    connect(rebuild.cancelButton, SIGNAL(clicked()),
+            cancelMapper, SLOT(map()));
+    cancelMapper->setMapping(rebuild.cancelButton, index);
+    rebuildGlay->addWidget(rebuild.cancelButton, 2 * index + 1, 2);
+
+    connect(thread, SIGNAL(steps(int)),
+            rebuild.progressBar, SLOT(setMaximum(int)));
+    connect(thread, SIGNAL(progress(int)),
+            rebuild.progressBar, SLOT(setValue(int)));
+    connect(thread, SIGNAL(status(const QString&)),
+            rebuild.statusLabel, SLOT(setText(const QString&)));
+    connect(thread, SIGNAL(progress(int)), SLOT(updateTotalProgress()));
+    connect(thread, SIGNAL(finished()), SLOT(threadFinished()));
+
+    rebuilds.append(rebuild);
+    totalProgressBar->setMaximum(rebuilds.size() * LEXICON_PROGRESS_STEPS);
+}
+
+//---------------------------------------------------------------------------
+//  startThreads
+//
+//! Start as many of the queued threads as may run at the same time.
+//---------------------------------------------------------------------------
+void
+DatabaseRebuildProgressDialog::startThreads()
+{
+    while (numRunning < maxRunning) {
+        int prevRunning = numRunning;
+        startNext();
+        if (numRunning == prevRunning)
+            break;
+    }
+    updateTotalProgress();
+}
+
+//---------------------------------------------------------------------------
+//  startNext
+//
+//! Start the first queued thread, if any.
+//---------------------------------------------------------------------------
+void
+DatabaseRebuildProgressDialog::startNext()
+{
+    for (int i = 0; i < rebuilds.size(); ++i) {
+        Rebuild& rebuild = rebuilds[i];
+        if (rebuild.started || rebuild.finished)
+            continue;
+
+        rebuild.started = true;
+        rebuild.statusLabel->setText("Starting...");
+        ++numRunning;
+        rebuild.thread->start();
+        return;
+    }
+}
+
+//---------------------------------------------------------------------------
+//  finishRebuild
+//
+//! Mark a rebuild as finished, start the next queued thread in its place,
+//! and accept the dialog once every rebuild is finished.
+//
+//! @param index the index of the rebuild
+//---------------------------------------------------------------------------
+void
+DatabaseRebuildProgressDialog::finishRebuild(int index)
+{
+    Rebuild& rebuild = rebuilds[index];
+    if (rebuild.finished)
+        return;
+
+    rebuild.finished = true;
+    rebuild.cancelButton->setEnabled(false);
+    if (rebuild.started)
+        --numRunning;
+
+    if (rebuild.thread->getCancelled())
+        rebuild.statusLabel->setText("Cancelled.");
+    else if (!rebuild.thread->getError().isEmpty())
+        rebuild.statusLabel->setText("Failed.");
+    else
+        rebuild.statusLabel->setText("Done.");
+    rebuild.progressBar->setValue(rebuild.progressBar->maximum());
+
+    startThreads();
+
+    foreach (const Rebuild& r, rebuilds) {
+        if (!r.finished)
+            return;
+    }
+    accept();
+}
+
+//---------------------------------------------------------------------------
+//  reject
+//
+//! Cancel every rebuild, running or queued, and close the dialog.  Threads
+//! still running must be waited for by the caller.
+//---------------------------------------------------------------------------
+void
+DatabaseRebuildProgressDialog::reject()
+{
+    for (int i = 0; i < rebuilds.size(); ++i) {
+        Rebuild& rebuild = rebuilds[i];
+        if (rebuild.finished)
+            continue;
+
+        rebuild.thread->cancel();
+        if (!rebuild.started)
+            rebuild.finished = true;
+    }
+    QDialog::reject();
+}
+
+//---------------------------------------------------------------------------
+//  cancelClicked
+//
+//! Called when the cancel button of a rebuild is clicked.  A queued rebuild
+//! is finished at once, and a running rebuild once its thread stops.
+//
+//! @param index the index of the rebuild
+//---------------------------------------------------------------------------
+void
+DatabaseRebuildProgressDialog::cancelClicked(int index)
+{
+    Rebuild& rebuild = rebuilds[index];
+    if (rebuild.finished)
+        return;
+
+    rebuild.thread->cancel();
+    rebuild.cancelButton->setEnabled(false);
+    if (rebuild.started)
+        rebuild.statusLabel->setText("Cancelling...");
+    else
+        finishRebuild(index);
+}
+
+//---------------------------------------------------------------------------
+//  threadFinished
+//
+//! Called when a thread finishes.
+//---------------------------------------------------------------------------
+void
+DatabaseRebuildProgressDialog::threadFinished()
+{
+    QObject* object = sender();
+    for (int i = 0; i < rebuilds.size(); ++i) {
+        if (rebuilds[i].thread == object) {
+            finishRebuild(i);
+            break;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//  updateTotalProgress
+//
+//! Update the overall progress bar from the progress of each rebuild, with
+//! each lexicon counted equally however many words it has.
+//---------------------------------------------------------------------------
+void
+DatabaseRebuildProgressDialog::updateTotalProgress()
+{
+    int total = 0;
+    foreach (const Rebuild& rebuild, rebuilds) {
+        if (rebuild.finished) {
+            total += LEXICON_PROGRESS_STEPS;
+            continue;
+        }
+        int maximum = rebuild.progressBar->maximum();
+        if (maximum > 0) {
+            total += int(qint64(rebuild.progressBar->value()) *
+                         LEXICON_PROGRESS_STEPS / maximum);
+        }
+    }
+    totalProgressBar->setValue(total);
+}
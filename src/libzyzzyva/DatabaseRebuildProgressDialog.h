@@ -0,0 +1,85 @@
+//---------------------------------------------------------------------------
+// DatabaseRebuildProgressDialog.h
+//
+// A dialog for displaying the progress of lexicon databases being rebuilt.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_DATABASE_REBUILD_PROGRESS_DIALOG_H
+#define ZYZZYVA_DATABASE_REBUILD_PROGRESS_DIALOG_H
+
+#include <QDialog>
+#include <QGridLayout>
+#include <QLabel>
+#include <QList>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QSignalMapper>
+
+class CreateDatabaseThread;
+
+// Runs the threads rebuilding the databases of several lexicons, at most a
+// given number at a time, with the others queued in the order they were
+// added.  Each lexicon has its own progress bar and cancel button, and an
+// overall progress bar counts each lexicon equally.  The dialog is
+// accepted once every thread has finished or been cancelled.
+class DatabaseRebuildProgressDialog : public QDialog
+{
+    Q_OBJECT
+    public:
+    DatabaseRebuildProgressDialog(QWidget* parent = 0, Qt::WFlags f = 0);
+    ~DatabaseRebuildProgressDialog();
+
+    void addThread(const QString& lexicon, CreateDatabaseThread* thread);
+    void setMaxRunning(int max) { maxRunning = max; }
+    void startThreads();
+
+    public slots:
+    void reject();
+    void cancelClicked(int index);
+    void threadFinished();
+    void updateTotalProgress();
+
+    private:
+    class Rebuild {
+        public:
+        Rebuild() : thread(0), statusLabel(0), progressBar(0),
+                    cancelButton(0), started(false), finished(false) { }
+        CreateDatabaseThread* thread;
+        QLabel* statusLabel;
+        QProgressBar* progressBar;
+        QPushButton* cancelButton;
+        bool started;
+        bool finished;
+    };
+
+    void startNext();
+    void finishRebuild(int index);
+
+    private:
+    QGridLayout* rebuildGlay;
+    QProgressBar* totalProgressBar;
+    QSignalMapper* cancelMapper;
+    QList<Rebuild> rebuilds;
+    int maxRunning;
+    int numRunning;
+};
+
+#endif // ZYZZYVA_DATABASE_REBUILD_PROGRESS_DIALOG_H
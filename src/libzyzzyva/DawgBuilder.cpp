@@ -0,0 +1,253 @@
+//---------------------------------------------------------------------------
+// DawgBuilder.cpp
+//
+// A class for building minimized DAWGs from sorted word lists.
+//
+// Words are added in sorted order, and the nodes of each word that cannot
+// be reached by later words are merged with equivalent nodes as soon as the
+// next word is added, as described in: Daciuk, Mihov, Watson and Watson,
+// "Incremental Construction of Minimal Acyclic Finite-State Automata."
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "DawgBuilder.h"
+
+// Edge layout of packed DAWGs, as read by WordGraph
+const quint32 V_LETTER       = 24;
+const quint32 M_END_OF_WORD  = (1UL << 23);
+const quint32 M_END_OF_NODE  = (1UL << 22);
+const quint32 M_NODE_POINTER = 0x1FFFFFUL;
+
+const qint32 ROOT_NODE = 0;
+const qint32 PACKED_ROOT_NODE = 1;
+
+//---------------------------------------------------------------------------
+//  DawgBuilder
+//
+//! Constructor.
+//---------------------------------------------------------------------------
+DawgBuilder::DawgBuilder()
+    : numWords(0)
+{
+    nodes.append(QVector<Edge>());
+    path.append(ROOT_NODE);
+}
+
+//---------------------------------------------------------------------------
+//  addWord
+//
+//! Add a word to the graph.  Words must be added in increasing order of
+//! their Latin-1 encoding.  A word equal to the last word added is ignored.
+//
+//! @param word the word to add
+//! @return true if successful, false if the word is empty, cannot be
+//! encoded in Latin-1, or is out of order
+//---------------------------------------------------------------------------
+bool
+DawgBuilder::addWord(const QString& word)
+{
+    QByteArray w = word.toLatin1();
+    if (w.isEmpty() || (QString::fromLatin1(w.constData(), w.size()) != word))
+        return false;
+
+    if (numWords) {
+        if (w == lastWord)
+            return true;
+        if (w < lastWord)
+            return false;
+    }
+
+    // Find the prefix shared with the last word
+    int prefixLen = 0;
+    int minLen = qMin(w.size(), lastWord.size());
+    while ((prefixLen < minLen) && (w[prefixLen] == lastWord[prefixLen]))
+        ++prefixLen;
+
+    // The suffix of the last word cannot be reached by later words, so merge
+    // its nodes with equivalent nodes
+    minimize(prefixLen + 1);
+
+    // Add the suffix of the new word
+    int wordLen = w.size();
+    for (int i = prefixLen; i < wordLen; ++i) {
+        if (i >= path.size()) {
+            qint32 node = newNode();
+            nodes[path[i - 1]].last().child = node;
+            path.append(node);
+        }
+        nodes[path[i]].append(Edge(w[i], i == wordLen - 1, 0));
+    }
+
+    lastWord = w;
+    ++numWords;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  finish
+//
+//! Finish building the graph, and pack it into the edge format read by
+//! WordGraph.  Each node is a run of edges in letter order, and the root
+//! node begins at index 1.  No more words can be added afterward.
+//
+//! @param numEdges returns the number of edges
+//! @param errString returns the error string in case of error
+//! @return a newly allocated array of edges, with index 0 unused, or 0 if
+//! error
+//---------------------------------------------------------------------------
+qint32*
+DawgBuilder::finish(qint32* numEdges, QString* errString)
+{
+    *numEdges = 0;
+    minimize(1);
+
+    if (!numWords) {
+        if (errString)
+            *errString = "The word list contains no words.";
+        return 0;
+    }
+
+    // Assign the position of each node breadth first from the root
+    QVector<qint32> positions (nodes.size(), 0);
+    QVector<qint32> order;
+    order.append(ROOT_NODE);
+    positions[ROOT_NODE] = PACKED_ROOT_NODE;
+    qint32 nextPosition = PACKED_ROOT_NODE + nodes[ROOT_NODE].size();
+
+    for (int i = 0; i < order.size(); ++i) {
+        const QVector<Edge>& edges = nodes[order[i]];
+        for (int j = 0; j < edges.size(); ++j) {
+            qint32 child = edges[j].child;
+            if (child && !positions[child]) {
+                positions[child] = nextPosition;
+                nextPosition += nodes[child].size();
+                order.append(child);
+            }
+        }
+    }
+
+    qint32 count = nextPosition - PACKED_ROOT_NODE;
+    if (quint32(count) > M_NODE_POINTER) {
+        if (errString)
+            *errString = "The word list is too large to be stored as a DAWG.";
+        return 0;
+    }
+
+    qint32* packed = new qint32[count + 1];
+    packed[0] = 0;
+    for (int i = 0; i < order.size(); ++i) {
+        const QVector<Edge>& edges = nodes[order[i]];
+        qint32 position = positions[order[i]];
+        for (int j = 0; j < edges.size(); ++j) {
+            const Edge& edge = edges[j];
+            quint32 value = (quint32(uchar(edge.letter)) << V_LETTER) |
+                (edge.child ? quint32(positions[edge.child]) : 0);
+            if (edge.eow)
+                value |= M_END_OF_WORD;
+            if (j == edges.size() - 1)
+                value |= M_END_OF_NODE;
+            packed[position + j] = qint32(value);
+        }
+    }
+
+    nodes.clear();
+    freeNodes.clear();
+    registry.clear();
+
+    *numEdges = count;
+    return packed;
+}
+
+//---------------------------------------------------------------------------
+//  newNode
+//
+//! Create an empty node, reusing a node freed by minimization if possible.
+//
+//! @return the new node
+//---------------------------------------------------------------------------
+qint32
+DawgBuilder::newNode()
+{
+    if (!freeNodes.isEmpty()) {
+        qint32 node = freeNodes.last();
+        freeNodes.pop_back();
+        return node;
+    }
+
+    nodes.append(QVector<Edge>());
+    return nodes.size() - 1;
+}
+
+//---------------------------------------------------------------------------
+//  minimize
+//
+//! Merge the nodes of the last word from a depth onward with equivalent
+//! minimized nodes, starting from the deepest node.  Nodes with no
+//! equivalent become minimized nodes themselves.
+//
+//! @param depth the depth of the first node to minimize
+//---------------------------------------------------------------------------
+void
+DawgBuilder::minimize(int depth)
+{
+    for (int i = path.size() - 1; i >= depth; --i) {
+        qint32 node = path[i];
+        QByteArray key = getNodeKey(node);
+        QHash<QByteArray, qint32>::const_iterator it = registry.find(key);
+        if (it == registry.end()) {
+            registry.insert(key, node);
+        }
+        else {
+            nodes[path[i - 1]].last().child = it.value();
+            nodes[node].clear();
+            freeNodes.append(node);
+        }
+    }
+
+    if (depth < path.size())
+        path.resize(depth);
+}
+
+//---------------------------------------------------------------------------
+//  getNodeKey
+//
+//! Get a key identifying a node by its edges.  Nodes with equal keys are
+//! equivalent, since their children have already been minimized.
+//
+//! @param node the node
+//! @return the key
+//---------------------------------------------------------------------------
+QByteArray
+DawgBuilder::getNodeKey(qint32 node) const
+{
+    const QVector<Edge>& edges = nodes[node];
+    QByteArray key;
+    key.reserve(edges.size() * 6);
+    for (int i = 0; i < edges.size(); ++i) {
+        const Edge& edge = edges[i];
+        key.append(edge.letter);
+        key.append(edge.eow ? '\1' : '\0');
+        key.append(char(edge.child));
+        key.append(char(edge.child >> 8));
+        key.append(char(edge.child >> 16));
+        key.append(char(edge.child >> 24));
+    }
+    return key;
+}
@@ -0,0 +1,73 @@
+//---------------------------------------------------------------------------
+// DawgBuilder.h
+//
+// A class for building minimized DAWGs from sorted word lists.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_DAWG_BUILDER_H
+#define ZYZZYVA_DAWG_BUILDER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+class DawgBuilder
+{
+    public:
+    DawgBuilder();
+    ~DawgBuilder() { }
+
+    bool addWord(const QString& word);
+    qint32* finish(qint32* numEdges, QString* errString = 0);
+    int getNumWords() const { return numWords; }
+
+    private:
+    class Edge {
+      public:
+        Edge(char l = 0, bool e = false, qint32 c = 0)
+            : letter(l), eow(e), child(c) { }
+        char letter;
+        bool eow;
+        qint32 child;
+    };
+
+    private:
+    qint32 newNode();
+    void minimize(int depth);
+    QByteArray getNodeKey(qint32 node) const;
+
+    // Nodes of the graph, each a list of outgoing edges in letter order.
+    // Node 0 is the root, and a child of 0 means an edge has no child.
+    QVector<QVector<Edge> > nodes;
+    QVector<qint32> freeNodes;
+
+    // Minimized nodes, keyed by their edges
+    QHash<QByteArray, qint32> registry;
+
+    // The last word added, and the node reached after each of its letters
+    // that has not been minimized yet
+    QByteArray lastWord;
+    QVector<qint32> path;
+    int numWords;
+};
+
+#endif // ZYZZYVA_DAWG_BUILDER_H
@@ -77,6 +77,7 @@ DefineForm::DefineForm(WordEngine* e, QWidget* parent, Qt::WFlags f)
 
     wordLine = new WordLineEdit;
     wordLine->setValidator(new WordValidator(wordLine));
+    wordLine->setCompletionEngine(engine, lexiconWidget->getCurrentLexicon());
     connect(wordLine, SIGNAL(textChanged(const QString&)),
             SLOT(wordChanged(const QString&)));
     connect(wordLine, SIGNAL(returnPressed()), SLOT(displayDefinition()));
@@ -185,6 +186,7 @@ DefineForm::selectInputArea()
 void
 DefineForm::lexiconActivated(const QString& lexicon)
 {
+    wordLine->setCompletionLexicon(lexicon);
     detailsString = Auxil::lexiconToDetails(lexicon);
     emit detailsChanged(detailsString);
 }
@@ -266,14 +268,31 @@ DefineForm::displayInfo(bool allInfo)
     }
 
     if (allInfo) {
+        // Search for anagrams, and find front, back and double extensions
+        // below the word in the word graph
         SearchSpec spec;
         SearchCondition condition;
-
-        // Get anagrams
         condition.type = SearchCondition::AnagramMatch;
         condition.stringValue = word;
         spec.conditions.append(condition);
-        QStringList anagrams = engine->search(lexicon, spec, true);
+        QList<QStringList> resultLists;
+        resultLists.append(engine->search(lexicon, spec, true));
+        resultLists.append(engine->getExtensions(lexicon, word,
+                                                 WordGraph::FrontExtensions));
+        resultLists.append(engine->getExtensions(lexicon, word,
+                                                 WordGraph::BackExtensions));
+        resultLists.append(engine->getExtensions(lexicon, word,
+                                                 WordGraph::DoubleExtensions));
+        for (int i = 1; i < resultLists.size(); ++i) {
+            QMutableListIterator<QString> it (resultLists[i]);
+            while (it.hasNext()) {
+                QString& extension = it.next();
+                extension = extension.toUpper();
+            }
+        }
+
+        // Get anagrams
+        QStringList anagrams = resultLists[0];
         anagrams.removeAll(word);
         if (showSymbols) {
             QMutableListIterator<QString> it (anagrams);
@@ -303,11 +322,7 @@ DefineForm::displayInfo(bool allInfo)
         resultStr += "<br><b>Back Hooks:</b> " + bHookStr;
 
         // Get front extensions
-        spec.conditions.clear();
-        condition.type = SearchCondition::PatternMatch;
-        condition.stringValue = "*?" + word;
-        spec.conditions.append(condition);
-        QStringList fExts = engine->search(lexicon, spec, true);
+        QStringList fExts = resultLists[1];
         if (showSymbols) {
             QMutableListIterator<QString> it (fExts);
             while (it.hasNext()) {
@@ -322,11 +337,7 @@ DefineForm::displayInfo(bool allInfo)
         resultStr += "<br><b>Front Extensions:</b> " + fExtStr;
 
         // Get back extensions
-        spec.conditions.clear();
-        condition.type = SearchCondition::PatternMatch;
-        condition.stringValue = word + "?*";
-        spec.conditions.append(condition);
-        QStringList bExts = engine->search(lexicon, spec, true);
+        QStringList bExts = resultLists[2];
         if (showSymbols) {
             QMutableListIterator<QString> it (bExts);
             while (it.hasNext()) {
@@ -340,11 +351,7 @@ DefineForm::displayInfo(bool allInfo)
         resultStr += "<br><b>Back Extensions:</b> " + bExtStr;
 
         // Get double extensions
-        spec.conditions.clear();
-        condition.type = SearchCondition::PatternMatch;
-        condition.stringValue = "*?" + word + "?*";
-        spec.conditions.append(condition);
-        QStringList dExts = engine->search(lexicon, spec, true);
+        QStringList dExts = resultLists[3];
         if (showSymbols) {
             QMutableListIterator<QString> it (dExts);
             while (it.hasNext()) {
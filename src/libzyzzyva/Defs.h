@@ -35,7 +35,8 @@ namespace Defs {
     const QString EMPTY_DEFINITION = "(no definition)";
     const int DEFINITION_WRAP_LENGTH = 80;
     const int MAX_WORD_LEN = 15;
-    const int MAX_BLANKS = 2;
+    const int MAX_BLANKS = 4;
+    const int MAX_STORED_BLANKS = 2;
     const int MAX_INPUT_LINE_LEN = 640;
     const int SPACING = 4;
     const int MARGIN = 4;
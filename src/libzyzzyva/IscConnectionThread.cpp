@@ -25,8 +25,14 @@
 #include "IscConnectionThread.h"
 #include "Rand.h"
 #include "Auxil.h"
+#include <cstring>
 
 const int KEEP_ALIVE_INTERVAL = 31000;
+const int STATS_INTERVAL = 1000;
+
+// Smallest number of decoded bytes dropped from the front of the receive
+// buffer at a time
+const int MIN_RECEIVE_COMPACT_BYTES = 4096;
 
 //---------------------------------------------------------------------------
 //  ~IscConnectionThread
@@ -63,6 +69,12 @@ IscConnectionThread::connectToServer(const QString& creds,
                                      QAbstractSocket::SocketError* err)
 {
     credentials = creds;
+    receiveBuffer.clear();
+    receiveIndex = 0;
+    sendLength = 0;
+    stats = Stats();
+    intervalStats = Stats();
+    keepAliveClock.invalidate();
     socket = new QTcpSocket(this);
     connect(socket, SIGNAL(error(QAbstractSocket::SocketError)),
             SIGNAL(socketError(QAbstractSocket::SocketError)));
@@ -98,9 +110,12 @@ IscConnectionThread::disconnectFromServer()
     if (!socket)
         return;
 
-    if (socket->isValid())
+    if (socket->isValid()) {
+        flushMessages();
         socket->disconnectFromHost();
+    }
 
+    statsTimer.stop();
     delete socket;
     socket = 0;
 }
@@ -108,7 +123,9 @@ IscConnectionThread::disconnectFromServer()
 //---------------------------------------------------------------------------
 //  sendMessage
 //
-//! Send a message to the server.
+//! Send a message to the server.  The message is queued, and every message
+//! queued before control returns to the event loop is written to the socket
+//! at once.
 //
 //! @param message the message
 //---------------------------------------------------------------------------
@@ -133,7 +150,34 @@ IscConnectionThread::sendMessage(const QString& message)
         }
     }
 
-    socket->write(encodeMessage(command + " " + args));
+    encodeMessage(command + " " + args);
+    ++stats.totalMessagesOut;
+    if (!flushPending) {
+        flushPending = true;
+        QTimer::singleShot(0, this, SLOT(flushMessages()));
+    }
+}
+
+//---------------------------------------------------------------------------
+//  flushMessages
+//
+//! Write the queued messages to the socket in one write.  Any message
+//! written to the server keeps the connection alive, so the keep-alive timer
+//! is restarted.
+//---------------------------------------------------------------------------
+void
+IscConnectionThread::flushMessages()
+{
+    flushPending = false;
+    if (!socket || !sendLength)
+        return;
+
+    socket->write(sendBuffer.constData(), sendLength);
+    stats.totalBytesOut += sendLength;
+    sendLength = 0;
+
+    if (keepAliveTimer.isActive())
+        keepAliveTimer.start();
 }
 
 //---------------------------------------------------------------------------
@@ -177,6 +221,7 @@ IscConnectionThread::socketStateChanged(QAbstractSocket::SocketState state)
             emit statusChanged("Logging in...");
 
             sendMessage("LOGIN " + credentials);
+            flushMessages();
 
             // Wait for SETALL
             socket->waitForReadyRead(10000);
@@ -185,6 +230,7 @@ IscConnectionThread::socketStateChanged(QAbstractSocket::SocketState state)
             socket->waitForReadyRead(10000);
 
             sendMessage("SOUGHT");
+            flushMessages();
 
             socket->waitForReadyRead(10000);
 
@@ -196,6 +242,11 @@ IscConnectionThread::socketStateChanged(QAbstractSocket::SocketState state)
             connect(&keepAliveTimer, SIGNAL(timeout()),
                     SLOT(keepAliveTimeout()));
             keepAliveTimer.start();
+
+            statsTimer.setInterval(STATS_INTERVAL);
+            connect(&statsTimer, SIGNAL(timeout()), SLOT(statsTimeout()));
+            statsTimer.start();
+            statsClock.start();
         }
         break;
 
@@ -220,13 +271,47 @@ IscConnectionThread::socketStateChanged(QAbstractSocket::SocketState state)
 //---------------------------------------------------------------------------
 //  socketReadyRead
 //
-//! Called when the socket has data ready to read.
+//! Called when the socket has data ready to read.  The data is added to the
+//! receive buffer, and every complete message in the buffer is received.
+//! A message split across reads is kept until the rest of it arrives.
 //---------------------------------------------------------------------------
 void
 IscConnectionThread::socketReadyRead()
 {
-    QByteArray bytes = socket->readAll();
-    QStringList messages = decodeMessage(bytes);
+    qint64 numBytes = socket->bytesAvailable();
+    if (numBytes <= 0)
+        return;
+
+    int oldSize = receiveBuffer.size();
+    receiveBuffer.resize(oldSize + numBytes);
+    qint64 numRead = socket->read(receiveBuffer.data() + oldSize, numBytes);
+    receiveBuffer.resize(oldSize + qMax(numRead, qint64(0)));
+    stats.totalBytesIn += qMax(numRead, qint64(0));
+
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
+    QStringList messages = decodeMessage(receiveBuffer, &receiveIndex);
+    stats.totalDecodeNsecs += decodeTimer.nsecsElapsed();
+    stats.totalMessagesIn += messages.size();
+
+    if (keepAliveClock.isValid() && !messages.isEmpty()) {
+        stats.roundTripMsecs = keepAliveClock.elapsed();
+        keepAliveClock.invalidate();
+    }
+
+    // Drop the decoded bytes only once they make up half the buffer, so the
+    // undecoded tail is not copied again after every read
+    if (receiveIndex == receiveBuffer.size()) {
+        receiveBuffer.truncate(0);
+        receiveIndex = 0;
+    }
+    else if ((receiveIndex >= MIN_RECEIVE_COMPACT_BYTES) &&
+             (receiveIndex >= receiveBuffer.size() / 2))
+    {
+        receiveBuffer.remove(0, receiveIndex);
+        receiveIndex = 0;
+    }
+
     foreach (const QString& message, messages) {
         receiveMessage(message);
     }
@@ -240,31 +325,73 @@ IscConnectionThread::socketReadyRead()
 void
 IscConnectionThread::keepAliveTimeout()
 {
+    // Write the message right away, so the round trip can be timed from it
     sendMessage("ALIVE");
+    flushMessages();
+    keepAliveClock.start();
+}
+
+//---------------------------------------------------------------------------
+//  statsTimeout
+//
+//! Called when the statistics timer goes off.  Calculate the rates over the
+//! interval since the last time, and emit the statistics.
+//---------------------------------------------------------------------------
+void
+IscConnectionThread::statsTimeout()
+{
+    double secs = statsClock.restart() / 1000.0;
+    if (secs <= 0)
+        return;
+
+    stats.bytesInPerSec =
+        (stats.totalBytesIn - intervalStats.totalBytesIn) / secs;
+    stats.bytesOutPerSec =
+        (stats.totalBytesOut - intervalStats.totalBytesOut) / secs;
+
+    qint64 messagesIn = stats.totalMessagesIn - intervalStats.totalMessagesIn;
+    stats.messagesInPerSec = messagesIn / secs;
+    stats.messagesOutPerSec =
+        (stats.totalMessagesOut - intervalStats.totalMessagesOut) / secs;
+    if (messagesIn) {
+        stats.decodeUsecsPerMessage = (stats.totalDecodeNsecs -
+            intervalStats.totalDecodeNsecs) / (1000.0 * messagesIn);
+    }
+
+    stats.receiveQueueBytes = receiveBuffer.size() - receiveIndex;
+    stats.sendQueueBytes = sendLength + (socket ? socket->bytesToWrite() : 0);
+    intervalStats = stats;
+
+    emit statsChanged(stats);
 }
 
 //---------------------------------------------------------------------------
 //  encodeMessage
 //
 //! Encode a message for the server by prepending two bytes indicating message
-//! length, followed by "0 " and the message.
+//! length, followed by "0 " and the message, and add it to the queued
+//! messages in the send buffer.
 //
 //! @param message the message to encode
-//! @return an array of bytes to be sent to the server
 //---------------------------------------------------------------------------
-QByteArray
+void
 IscConnectionThread::encodeMessage(const QString& message)
 {
-    int length = message.length() + 2;
-    unsigned char high = (length & 0xff00) >> 8;
-    unsigned char low  = (length & 0x00ff);
-
-    QByteArray bytes;
-    bytes.append(high);
-    bytes.append(low);
-    bytes.append(QString("0 "));
-    bytes.append(message);
-    return bytes;
+    QByteArray messageBytes = message.toAscii();
+    int length = messageBytes.size() + 2;
+    int frameLength = length + 2;
+
+    if (sendLength + frameLength > sendBuffer.size())
+        sendBuffer.resize(qMax(sendLength + frameLength,
+                               2 * sendBuffer.size()));
+
+    char* data = sendBuffer.data() + sendLength;
+    data[0] = char((length & 0xff00) >> 8);
+    data[1] = char(length & 0x00ff);
+    data[2] = '0';
+    data[3] = ' ';
+    memcpy(data + 4, messageBytes.constData(), messageBytes.size());
+    sendLength += frameLength;
 }
 
 //---------------------------------------------------------------------------
@@ -273,22 +400,32 @@ IscConnectionThread::encodeMessage(const QString& message)
 //! Decode a message from the server by interpreting the first two bytes as
 //! message length, followed by the message itself.  More than one message may
 //! be present in the data stream, so return a list of all messages found.
+//! Only complete messages are decoded, so the last message may be left for
+//! when the rest of it has been received.
 //
 //! @param bytes the bytes to decode
+//! @param index the index of the first byte to decode, returns the index of
+//! the first byte not decoded
 //! @return the decoded messages
 //---------------------------------------------------------------------------
 QStringList
-IscConnectionThread::decodeMessage(const QByteArray& bytes)
+IscConnectionThread::decodeMessage(const QByteArray& bytes, int* index)
 {
-    int index = 0;
     QStringList messages;
-
-    while (index < bytes.size()) {
-        unsigned char high = bytes[index];
-        unsigned char low  = bytes[index + 1];
-        int length = (high << 8) + low - 2;
-        messages.append(QString(bytes.mid(index + 4, length)));
-        index += length + 4;
+    const char* data = bytes.constData();
+
+    while (*index + 2 <= bytes.size()) {
+        unsigned char high = data[*index];
+        unsigned char low  = data[*index + 1];
+        int frameLength = (high << 8) + low;
+        if (*index + 2 + frameLength > bytes.size())
+            break;
+
+        // The message follows the two length bytes and two more bytes
+        int length = frameLength - 2;
+        if (length >= 0)
+            messages.append(QString::fromAscii(data + *index + 4, length));
+        *index += frameLength + 2;
     }
 
     return messages;
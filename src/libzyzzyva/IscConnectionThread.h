@@ -25,6 +25,7 @@
 #ifndef ZYZZYVA_ISC_CONNECTION_THREAD_H
 #define ZYZZYVA_ISC_CONNECTION_THREAD_H
 
+#include <QElapsedTimer>
 #include <QStringList>
 #include <QTcpSocket>
 #include <QThread>
@@ -33,19 +34,51 @@
 class IscConnectionThread : public QThread
 {
     Q_OBJECT
+    public:
+    // Connection statistics, with totals since connecting and rates over
+    // the last statistics interval
+    class Stats {
+        public:
+        Stats() : roundTripMsecs(-1), bytesInPerSec(0), bytesOutPerSec(0),
+            messagesInPerSec(0), messagesOutPerSec(0),
+            decodeUsecsPerMessage(0), receiveQueueBytes(0),
+            sendQueueBytes(0), totalBytesIn(0), totalBytesOut(0),
+            totalMessagesIn(0), totalMessagesOut(0), totalDecodeNsecs(0) { }
+
+        public:
+        // Estimated from the time between sending a keep-alive message and
+        // receiving the next message, or -1 if not measured yet
+        int roundTripMsecs;
+        double bytesInPerSec;
+        double bytesOutPerSec;
+        double messagesInPerSec;
+        double messagesOutPerSec;
+        double decodeUsecsPerMessage;
+        int receiveQueueBytes;
+        int sendQueueBytes;
+        qint64 totalBytesIn;
+        qint64 totalBytesOut;
+        qint64 totalMessagesIn;
+        qint64 totalMessagesOut;
+        qint64 totalDecodeNsecs;
+    };
+
     public:
     IscConnectionThread(QObject* parent = 0)
-        : QThread(parent), socket(0) { }
+        : QThread(parent), socket(0), receiveIndex(0), sendLength(0),
+          flushPending(false) { }
     ~IscConnectionThread();
 
     bool connectToServer(const QString& creds,
                          QAbstractSocket::SocketError* err = 0);
     void disconnectFromServer();
+    const Stats& getStats() const { return stats; }
 
     signals:
     void messageReceived(const QString& message);
     void statusChanged(const QString& status);
     void socketError(QAbstractSocket::SocketError error);
+    void statsChanged(const IscConnectionThread::Stats& stats);
 
     public slots:
     void sendMessage(const QString& message);
@@ -55,8 +88,10 @@ class IscConnectionThread : public QThread
     void socketStateChanged(QAbstractSocket::SocketState state);
     void socketReadyRead();
     void keepAliveTimeout();
-    QByteArray encodeMessage(const QString& message);
-    QStringList decodeMessage(const QByteArray& bytes);
+    void statsTimeout();
+    void flushMessages();
+    void encodeMessage(const QString& message);
+    QStringList decodeMessage(const QByteArray& bytes, int* index);
 
     protected:
     void run();
@@ -66,6 +101,27 @@ class IscConnectionThread : public QThread
     QTimer keepAliveTimer;
     QString credentials;
     bool socketHadError;
+
+    // Bytes received from the server, holding any frame not received in
+    // full yet, and the index of the first byte not decoded
+    QByteArray receiveBuffer;
+    int receiveIndex;
+
+    // Messages encoded since the last write to the socket, all written
+    // together when control returns to the event loop - see sendMessage.
+    // The buffer is reused, so only the first sendLength bytes are queued.
+    QByteArray sendBuffer;
+    int sendLength;
+    bool flushPending;
+
+    // Statistics, the totals at the start of the current statistics
+    // interval, and the time since the last keep-alive message was sent,
+    // until the next message is received
+    Stats stats;
+    Stats intervalStats;
+    QTimer statsTimer;
+    QElapsedTimer statsClock;
+    QElapsedTimer keepAliveClock;
 };
 
 #endif // ZYZZYVA_ISC_CONNECTION_THREAD_H
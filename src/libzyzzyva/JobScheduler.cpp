@@ -0,0 +1,352 @@
+//---------------------------------------------------------------------------
+// JobScheduler.cpp
+//
+// A class for running engine jobs on a shared pool of worker threads.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "JobScheduler.h"
+#include <QMutexLocker>
+#include <QThread>
+
+// The worker that only runs interactive jobs
+const int INTERACTIVE_WORKER = 0;
+
+//---------------------------------------------------------------------------
+//  cancel
+//
+//! Cancel the job.  A job that has not started yet is finished at once; a
+//! running job finishes when it next checks isCancelled.
+//---------------------------------------------------------------------------
+void
+Job::cancel()
+{
+    cancelled.fetchAndStoreOrdered(1);
+
+    QMutexLocker locker (&mutex);
+    if (state == PendingState) {
+        state = FinishedState;
+        finished.wakeAll();
+    }
+}
+
+//---------------------------------------------------------------------------
+//  isFinished
+//
+//! Determine whether the job has finished running or was cancelled before
+//! it started.
+//
+//! @return true if the job is finished, false otherwise
+//---------------------------------------------------------------------------
+bool
+Job::isFinished() const
+{
+    QMutexLocker locker (&mutex);
+    return (state == FinishedState);
+}
+
+//---------------------------------------------------------------------------
+//  wait
+//
+//! Wait for the job to finish.
+//---------------------------------------------------------------------------
+void
+Job::wait() const
+{
+    QMutexLocker locker (&mutex);
+    while (state != FinishedState)
+        finished.wait(&mutex);
+}
+
+//---------------------------------------------------------------------------
+//  begin
+//
+//! Mark the job as running, unless it was cancelled before it started.
+//
+//! @return true if the job is to be run, false otherwise
+//---------------------------------------------------------------------------
+bool
+Job::begin()
+{
+    QMutexLocker locker (&mutex);
+    if (state != PendingState)
+        return false;
+    state = RunningState;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  end
+//
+//! Mark the job as finished, and wake the threads waiting for it.
+//---------------------------------------------------------------------------
+void
+Job::end()
+{
+    QMutexLocker locker (&mutex);
+    state = FinishedState;
+    finished.wakeAll();
+}
+
+//---------------------------------------------------------------------------
+//  Worker
+//
+//! A worker thread of the scheduler, running the jobs it takes until the
+//! scheduler stops.
+//---------------------------------------------------------------------------
+class JobScheduler::Worker : public QThread
+{
+    public:
+    Worker(JobScheduler* s, int i) : QThread(), scheduler(s), index(i) { }
+    ~Worker() { }
+
+    protected:
+    void run() {
+        JobPointer job;
+        while (!(job = scheduler->takeJob(index)).isNull()) {
+            runJob(job.data());
+            job.clear();
+        }
+    }
+
+    private:
+    JobScheduler* scheduler;
+    int index;
+};
+
+//---------------------------------------------------------------------------
+//  getInstance
+//
+//! Get the scheduler shared by the whole program.
+//
+//! @return the scheduler
+//---------------------------------------------------------------------------
+JobScheduler*
+JobScheduler::getInstance()
+{
+    static JobScheduler instance;
+    return &instance;
+}
+
+//---------------------------------------------------------------------------
+//  JobScheduler
+//
+//! Constructor.  Start one worker for each processor, and at least two, so
+//! there is always a worker for background jobs besides the interactive
+//! worker.
+//---------------------------------------------------------------------------
+JobScheduler::JobScheduler()
+    : generation(0), stopping(false), nextWorker(0)
+{
+    int numWorkers = qMax(2, QThread::idealThreadCount());
+    for (int i = 0; i < numWorkers; ++i) {
+        workerQueues.append(new WorkerQueues);
+        workers.append(new Worker(this, i));
+    }
+    foreach (Worker* worker, workers)
+        worker->start();
+}
+
+//---------------------------------------------------------------------------
+//  ~JobScheduler
+//
+//! Destructor.  Cancel the jobs that have not started, and wait for the
+//! running jobs and the workers to finish.
+//---------------------------------------------------------------------------
+JobScheduler::~JobScheduler()
+{
+    foreach (WorkerQueues* wq, workerQueues) {
+        QMutexLocker locker (&wq->mutex);
+        for (int i = 0; i < NumPriorities; ++i) {
+            foreach (const JobPointer& job, wq->queues[i])
+                job->cancel();
+            wq->queues[i].clear();
+        }
+    }
+
+    {
+        QMutexLocker locker (&wakeMutex);
+        stopping = true;
+        wake.wakeAll();
+    }
+
+    foreach (Worker* worker, workers) {
+        worker->wait();
+        delete worker;
+    }
+    qDeleteAll(workerQueues);
+}
+
+//---------------------------------------------------------------------------
+//  submit
+//
+//! Queue a job to be run, taking ownership of it.
+//
+//! @param job the job
+//! @param priority the priority of the job
+//! @return a shared pointer to the job, for waiting for or cancelling it
+//---------------------------------------------------------------------------
+JobPointer
+JobScheduler::submit(Job* job, Priority priority)
+{
+    JobPointer pointer (job);
+    submit(pointer, priority);
+    return pointer;
+}
+
+//---------------------------------------------------------------------------
+//  submit
+//
+//! Queue a job to be run.  A job submitted by a job running on a worker is
+//! queued for that worker, so related work tends to stay on one thread;
+//! other jobs are spread over the workers in turn.
+//
+//! @param job the job
+//! @param priority the priority of the job
+//---------------------------------------------------------------------------
+void
+JobScheduler::submit(const JobPointer& job, Priority priority)
+{
+    if (job.isNull())
+        return;
+
+    int index = getWorkerIndex();
+    if ((index < 0) ||
+        ((index == INTERACTIVE_WORKER) && (priority != InteractivePriority)))
+    {
+        QMutexLocker locker (&wakeMutex);
+        if (priority == InteractivePriority) {
+            index = nextWorker % workers.size();
+        }
+        else {
+            index = INTERACTIVE_WORKER + 1 +
+                nextWorker % (workers.size() - 1);
+        }
+        ++nextWorker;
+    }
+
+    {
+        WorkerQueues* wq = workerQueues[index];
+        QMutexLocker locker (&wq->mutex);
+        wq->queues[priority].append(job);
+    }
+
+    QMutexLocker locker (&wakeMutex);
+    ++generation;
+    wake.wakeAll();
+}
+
+//---------------------------------------------------------------------------
+//  takeJob
+//
+//! Take the next job for a worker to run, waiting until one is queued.
+//
+//! @param workerIndex the index of the worker
+//! @return the job, or a null pointer if the scheduler is stopping
+//---------------------------------------------------------------------------
+JobPointer
+JobScheduler::takeJob(int workerIndex)
+{
+    forever {
+        quint64 seenGeneration;
+        {
+            QMutexLocker locker (&wakeMutex);
+            if (stopping)
+                return JobPointer();
+            seenGeneration = generation;
+        }
+
+        JobPointer job = findJob(workerIndex);
+        if (!job.isNull())
+            return job;
+
+        // A job queued while searching changes the generation, so it is
+        // not missed
+        QMutexLocker locker (&wakeMutex);
+        while (!stopping && (generation == seenGeneration))
+            wake.wait(&wakeMutex);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  findJob
+//
+//! Find a queued job for a worker to run.  For each priority from the
+//! highest, the newest job in the queue of the worker is taken first, then
+//! the oldest job in the queue of another worker.
+//
+//! @param workerIndex the index of the worker
+//! @return the job, or a null pointer if no job is queued
+//---------------------------------------------------------------------------
+JobPointer
+JobScheduler::findJob(int workerIndex)
+{
+    int numWorkers = workers.size();
+    int maxPriority = (workerIndex == INTERACTIVE_WORKER)
+        ? InteractivePriority : NumPriorities - 1;
+
+    for (int priority = 0; priority <= maxPriority; ++priority) {
+        for (int i = 0; i < numWorkers; ++i) {
+            int index = (workerIndex + i) % numWorkers;
+            WorkerQueues* wq = workerQueues[index];
+            QMutexLocker locker (&wq->mutex);
+            QList<JobPointer>& queue = wq->queues[priority];
+            if (queue.isEmpty())
+                continue;
+            return (i == 0) ? queue.takeLast() : queue.takeFirst();
+        }
+    }
+    return JobPointer();
+}
+
+//---------------------------------------------------------------------------
+//  runJob
+//
+//! Run a job on the calling worker, unless it was cancelled before it
+//! started.
+//
+//! @param job the job
+//---------------------------------------------------------------------------
+void
+JobScheduler::runJob(Job* job)
+{
+    if (!job->begin())
+        return;
+    job->run();
+    job->end();
+}
+
+//---------------------------------------------------------------------------
+//  getWorkerIndex
+//
+//! Get the index of the worker the calling thread is.
+//
+//! @return the index, or -1 if the calling thread is not a worker
+//---------------------------------------------------------------------------
+int
+JobScheduler::getWorkerIndex() const
+{
+    QThread* current = QThread::currentThread();
+    for (int i = 0; i < workers.size(); ++i) {
+        if (workers[i] == current)
+            return i;
+    }
+    return -1;
+}
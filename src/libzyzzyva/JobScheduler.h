@@ -0,0 +1,129 @@
+//---------------------------------------------------------------------------
+// JobScheduler.h
+//
+// A class for running engine jobs on a shared pool of worker threads.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_JOB_SCHEDULER_H
+#define ZYZZYVA_JOB_SCHEDULER_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVector>
+#include <QWaitCondition>
+
+// A unit of work run by the job scheduler.  A job checks isCancelled while
+// it runs and returns early once it is set; a job cancelled before it
+// starts is never run.
+class Job
+{
+    friend class JobScheduler;
+
+    public:
+    Job() : state(PendingState), cancelled(0) { }
+    virtual ~Job() { }
+
+    void cancel();
+    bool isCancelled() const { return cancelled != 0; }
+    bool isFinished() const;
+    void wait() const;
+
+    protected:
+    virtual void run() = 0;
+
+    private:
+    enum State {
+        PendingState,
+        RunningState,
+        FinishedState
+    };
+
+    bool begin();
+    void end();
+
+    private:
+    mutable QMutex mutex;
+    mutable QWaitCondition finished;
+    State state;
+    QAtomicInt cancelled;
+};
+
+typedef QSharedPointer<Job> JobPointer;
+
+// A fixed pool of worker threads shared by every part of the program that
+// runs engine work in the background, sized to the machine.  Each worker
+// has its own queue for each priority, takes its newest job of the highest
+// priority first, and steals the oldest job of that priority from the
+// other workers when its own queue is empty.  Jobs of a lower priority are
+// only taken when no job of a higher priority is queued, and one worker
+// only runs interactive jobs, so background work never holds up a search.
+class JobScheduler
+{
+    public:
+    enum Priority {
+        InteractivePriority = 0,
+        PrefetchPriority,
+        CacheWarmingPriority,
+        IndexBuildingPriority,
+        NumPriorities
+    };
+
+    public:
+    static JobScheduler* getInstance();
+
+    JobScheduler();
+    ~JobScheduler();
+
+    int getNumWorkers() const { return workers.size(); }
+    JobPointer submit(Job* job, Priority priority);
+    void submit(const JobPointer& job, Priority priority);
+
+    private:
+    class Worker;
+
+    JobPointer takeJob(int workerIndex);
+    JobPointer findJob(int workerIndex);
+    int getWorkerIndex() const;
+    static void runJob(Job* job);
+
+    private:
+    // The queues of each worker, one for each priority, guarded by its
+    // mutex
+    class WorkerQueues {
+        public:
+        QMutex mutex;
+        QList<JobPointer> queues[NumPriorities];
+    };
+
+    QVector<Worker*> workers;
+    QVector<WorkerQueues*> workerQueues;
+
+    // Idle workers wait on the wake condition until the generation changes
+    QMutex wakeMutex;
+    QWaitCondition wake;
+    quint64 generation;
+    bool stopping;
+    int nextWorker;
+};
+
+#endif // ZYZZYVA_JOB_SCHEDULER_H
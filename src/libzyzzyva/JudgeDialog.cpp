@@ -38,6 +38,7 @@
 #include <QPalette>
 #include <QTextCursor>
 #include <QTextStream>
+#include <QTime>
 #include <QVBoxLayout>
 
 // How many pixels to display for every 20 pixels of screen height
@@ -278,6 +279,12 @@ JudgeDialog::JudgeDialog(WordEngine* e, const QString& lex,
     resultLexiconLabel->setSizePolicy(QSizePolicy::Expanding,
         QSizePolicy::Fixed);
     resultVlay->addWidget(resultLexiconLabel);
+    resultLexiconLabel->setText("<br><br><font color=\"black\">Lexicon: " +
+        lexicon + "</font>");
+
+    // Load the result images once, so judging a play does not decode them
+    acceptablePixmap.load(":/judge-acceptable");
+    unacceptablePixmap.load(":/judge-unacceptable");
 
     QWidget* inputTitleWidget = createTitleWidget();
     inputVlay->addWidget(inputTitleWidget);
@@ -443,16 +450,20 @@ JudgeDialog::clearAltPressed()
 void
 JudgeDialog::judgeWord()
 {
+    QTime timer;
+    timer.start();
     bool acceptable = true;
 
     QString text = inputArea->toPlainText().simplified();
     QStringList words = text.split(QChar(' '));
     QStringList acceptableWords;
     QStringList unacceptableWords;
+    QBitArray wordsAcceptable = engine->areAcceptable(lexicon, words);
     QStringList::iterator it;
     QString wordStr;
-    for (it = words.begin(); it != words.end(); ++it) {
-        bool wordAcceptable = engine->isAcceptable(lexicon, *it);
+    int wordNum = 0;
+    for (it = words.begin(); it != words.end(); ++it, ++wordNum) {
+        bool wordAcceptable = wordsAcceptable.testBit(wordNum);
 
         if (wordAcceptable)
             acceptableWords.append(*it);
@@ -468,18 +479,17 @@ JudgeDialog::judgeWord()
 
     QString resultStr;
     QColor resultColor;
-    QPixmap resultPixmap;
+    const QPixmap& resultPixmap = acceptable ? acceptablePixmap
+                                             : unacceptablePixmap;
     if (acceptable) {
         resultStr = "<font color=\"#00bb00\">YES, the play is "
                     "<b>ACCEPTABLE</b></font>";
         resultColor = QColor(0, 204, 0);
-        resultPixmap.load(":/judge-acceptable");
     }
     else {
         resultStr = "<font color=\"red\">NO, the play is "
                     "<b>UNACCEPTABLE</b></font>";
         resultColor = Qt::red;
-        resultPixmap.load(":/judge-unacceptable");
     }
     resultStr += "<br><br><font color=\"black\">" + wordStr + "</font>";
 
@@ -492,11 +502,10 @@ JudgeDialog::judgeWord()
     ++clearResultsHold;
 
     resultLabel->setText(resultStr);
-    resultLexiconLabel->setText("<br><br><font color=\"black\">Lexicon: " +
-        lexicon + "</font>");
     if (!resultPixmap.isNull())
         resultPixmapLabel->setPixmap(resultPixmap);
     widgetStack->setCurrentWidget(resultWidget);
+    int elapsed = timer.elapsed();
 
     QTimer::singleShot(CLEAR_RESULTS_MIN_DELAY, this,
                        SLOT(clearResultsReleaseHold()));
@@ -544,6 +553,14 @@ JudgeDialog::judgeWord()
         stream << " " << word;
     }
     endl(stream);
+
+    // Log how long the judgment took to display, one line per challenge
+    QFile timingFile (logDirName + "/timing.txt");
+    timingFile.open(QIODevice::Append | QIODevice::Text);
+    QTextStream timingStream (&timingFile);
+    timingStream << QDateTime::currentDateTime().toString(
+        "[yyyy-MM-dd hh:mm:ss] ") << elapsed << " ms";
+    endl(timingStream);
 }
 
 //---------------------------------------------------------------------------
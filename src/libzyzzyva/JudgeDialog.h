@@ -30,6 +30,7 @@
 #include <QFrame>
 #include <QLabel>
 #include <QLineEdit>
+#include <QPixmap>
 #include <QStackedWidget>
 #include <QTimer>
 #include <QWidget>
@@ -92,6 +93,8 @@ class JudgeDialog : public QDialog
     QLabel*         resultPixmapLabel;
     QLabel*         resultLabel;
     QLabel*         resultLexiconLabel;
+    QPixmap         acceptablePixmap;
+    QPixmap         unacceptablePixmap;
     QTimer*         altPressedTimer;
     QTimer*         countTimer;
     QTimer*         passwordTimer;
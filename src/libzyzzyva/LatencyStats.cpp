@@ -0,0 +1,162 @@
+//---------------------------------------------------------------------------
+// LatencyStats.cpp
+//
+// A class for collecting the latencies of quiz responses.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "LatencyStats.h"
+#include "Defs.h"
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QtAlgorithms>
+
+// The percentiles written for each stage
+const int PERCENTILES[] = { 50, 90, 99, 100 };
+const int NUM_PERCENTILES = sizeof(PERCENTILES) / sizeof(PERCENTILES[0]);
+
+//---------------------------------------------------------------------------
+//  formatMsecs
+//
+//! Format a time in nanoseconds as milliseconds.
+//
+//! @param nsecs the time in nanoseconds
+//! @return the formatted time
+//---------------------------------------------------------------------------
+static QString
+formatMsecs(qint64 nsecs)
+{
+    return QString::number(nsecs / 1000000.0, 'f', 3);
+}
+
+//---------------------------------------------------------------------------
+//  getPercentile
+//
+//! Find a percentile of the time taken by a stage over the responses, by
+//! nearest rank.
+//
+//! @param stage the stage
+//! @param percent the percentile, from 1 to 100
+//! @return the time in nanoseconds, or 0 if there are no samples
+//---------------------------------------------------------------------------
+qint64
+LatencyStats::getPercentile(Stage stage, int percent) const
+{
+    int numSamples = samples.size();
+    if (!numSamples)
+        return 0;
+
+    QVector<qint64> times (numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        times[i] = samples[i].nsecs[stage];
+    qSort(times.begin(), times.end());
+
+    int rank = (qMax(1, qMin(percent, 100)) * numSamples + 99) / 100;
+    return times[rank - 1];
+}
+
+//---------------------------------------------------------------------------
+//  writeFile
+//
+//! Write the percentiles of each stage and the time taken by every stage
+//! of every response to a tab-separated text file.  The file also records
+//! the program version and the number of processors, so files written on
+//! different machines can be compared.
+//
+//! @param filename the name of the file
+//! @param description a description of the quiz
+//! @param errString returns an error string on failure
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+LatencyStats::writeFile(const QString& filename, const QString& description,
+                        QString* errString) const
+{
+    QFile file (filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate |
+                   QIODevice::Text))
+    {
+        if (errString)
+            *errString = file.errorString();
+        return false;
+    }
+
+    QTextStream stream (&file);
+    stream << "# Zyzzyva " << Defs::ZYZZYVA_VERSION << " response times\n"
+        << "# Quiz: " << description << "\n"
+        << "# Processors: " << QThread::idealThreadCount() << "\n"
+        << "# Responses: " << samples.size() << "\n"
+        << "# Times are in milliseconds\n\n";
+
+    stream << "Stage";
+    for (int i = 0; i < NUM_PERCENTILES; ++i)
+        stream << "\tP" << PERCENTILES[i];
+    stream << "\n";
+    for (int i = 0; i < NumStages; ++i) {
+        Stage stage = Stage(i);
+        stream << getStageName(stage);
+        for (int j = 0; j < NUM_PERCENTILES; ++j) {
+            stream << "\t"
+                << formatMsecs(getPercentile(stage, PERCENTILES[j]));
+        }
+        stream << "\n";
+    }
+
+    stream << "\nResponse";
+    for (int i = 0; i < NumStages; ++i)
+        stream << "\t" << getStageName(Stage(i));
+    stream << "\n";
+    for (int i = 0; i < samples.size(); ++i) {
+        stream << (i + 1);
+        for (int j = 0; j < NumStages; ++j)
+            stream << "\t" << formatMsecs(samples[i].nsecs[j]);
+        stream << "\n";
+    }
+    stream.flush();
+
+    if (stream.status() != QTextStream::Ok) {
+        if (errString)
+            *errString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  getStageName
+//
+//! Get the name of a stage of handling a response.
+//
+//! @param stage the stage
+//! @return the name of the stage
+//---------------------------------------------------------------------------
+QString
+LatencyStats::getStageName(Stage stage)
+{
+    switch (stage) {
+        case CheckStage: return "Check";
+        case StatsStage: return "Stats";
+        case WordListStage: return "Word list";
+        case DisplayStage: return "Display";
+        case TotalStage: return "Total";
+        default: return QString();
+    }
+}
@@ -0,0 +1,76 @@
+//---------------------------------------------------------------------------
+// LatencyStats.h
+//
+// A class for collecting the latencies of quiz responses.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_LATENCY_STATS_H
+#define ZYZZYVA_LATENCY_STATS_H
+
+#include <QString>
+#include <QVector>
+
+// The time taken to handle each response entered in a quiz, from the
+// response being entered until it is shown, split into the stages of
+// handling it.  Percentiles are found by rank, from the samples of the
+// responses entered so far.
+class LatencyStats
+{
+    public:
+    enum Stage {
+        CheckStage = 0,
+        StatsStage,
+        WordListStage,
+        DisplayStage,
+        TotalStage,
+        NumStages
+    };
+
+    // The time taken by each stage of handling one response, in
+    // nanoseconds
+    class Sample {
+        public:
+        Sample() { clear(); }
+        void clear() {
+            for (int i = 0; i < NumStages; ++i)
+                nsecs[i] = 0;
+        }
+        qint64 nsecs[NumStages];
+    };
+
+    public:
+    LatencyStats() { }
+    ~LatencyStats() { }
+
+    void clear() { samples.clear(); }
+    void addSample(const Sample& sample) { samples.append(sample); }
+    int getNumSamples() const { return samples.size(); }
+    qint64 getPercentile(Stage stage, int percent) const;
+    bool writeFile(const QString& filename, const QString& description,
+                   QString* errString = 0) const;
+
+    static QString getStageName(Stage stage);
+
+    private:
+    QVector<Sample> samples;
+};
+
+#endif // ZYZZYVA_LATENCY_STATS_H
@@ -26,6 +26,7 @@
 #include "MainSettings.h"
 #include "Auxil.h"
 #include "Defs.h"
+#include <QVarLengthArray>
 
 using namespace Defs;
 
@@ -40,7 +41,7 @@ const QChar LetterBag::BLANK_CHAR = '_';
 //! @param distribution the letter distribution to use
 //---------------------------------------------------------------------------
 LetterBag::LetterBag(const QString& distribution)
-    : totalLetters(0)
+    : totalLetters(0), chooseStride(0)
 {
     // Set letter values
     // FIXME: this should be able to be passed in as a parameter
@@ -83,8 +84,7 @@ LetterBag::LetterBag(const QString& distribution)
 //! drawing the number of letters in the word.
 //
 //! @param word the word
-//! @param numBlanks the number of blanks considered to be in the bag - if
-//! greater than 2, then pared back to 2
+//! @param numBlanks the number of blanks considered to be in the bag
 //! @return the probability of drawing letters to form the word, times 1e9
 //---------------------------------------------------------------------------
 double
@@ -101,8 +101,7 @@ LetterBag::getProbability(const QString& word, int numBlanks) const
 //! drawing the number of letters in the word.
 //
 //! @param word the word
-//! @param numBlanks the number of blanks considered to be in the bag - if
-//! greater than 2, then pared back to 2
+//! @param numBlanks the number of blanks considered to be in the bag
 //! @return the number of ways of drawing letters to form the word
 //---------------------------------------------------------------------------
 double
@@ -110,14 +109,18 @@ LetterBag::getNumCombinations(const QString& word, int numBlanks) const
 {
     if (numBlanks < 0)
         numBlanks = 0;
-    else if (numBlanks > 2)
-        numBlanks = 2;
-
-    // Build parallel arrays of letters with their counts, and the
-    // precalculated combinations based on the letter frequency
-    QList<QChar> letters;
-    QList<int> counts;
-    QList<const QList<double>*> combos;
+
+    QVarLengthArray<double, MAX_WORD_LEN + 1> combinations (numBlanks + 1);
+    int plainCounts[NUM_PLAIN_LETTERS];
+    if (countPlainLetters(word, plainCounts)) {
+        getNumCombinations(plainCounts, numBlanks, combinations.data());
+        return combinations[numBlanks];
+    }
+
+    // Count each distinct character of the word
+    QVarLengthArray<QChar, MAX_WORD_LEN> letters;
+    QVarLengthArray<int, MAX_WORD_LEN> counts;
+    QVarLengthArray<int, MAX_WORD_LEN> frequencies;
     for (int i = 0; i < word.length(); ++i) {
         QChar c = word.at(i);
 
@@ -133,60 +136,180 @@ LetterBag::getNumCombinations(const QString& word, int numBlanks) const
         if (!foundLetter) {
             letters.append(c);
             counts.append(1);
-            combos.append(&subChooseCombos[ letterFrequencies[c] ]);
+            frequencies.append(letterFrequencies.value(c));
         }
     }
 
-    // XXX: Generalize the following code to handle arbitrary number of blanks
-    double totalCombos = 0.0;
-    int numLetters = letters.size();
+    countCombinations(counts.constData(), frequencies.constData(),
+                      counts.size(), numBlanks, combinations.data());
+    return combinations[numBlanks];
+}
 
-    // Calculate the combinations with no blanks
-    double thisCombo = 1.0;
-    for (int i = 0; i < numLetters; ++i) {
-        thisCombo *= (*combos[i])[ counts[i] ];
+//---------------------------------------------------------------------------
+//  getNumCombinations
+//
+//! Calculate the unique ways of drawing a word from a full bag of letters
+//! when drawing the number of letters in the word, for each number of blanks
+//! up to a maximum.  The word is given by the counts of its letters, so
+//! callers that have already counted the letters need not count them again.
+//
+//! @param letterCounts the number of each letter from A to Z in the word
+//! @param maxBlanks the maximum number of blanks considered to be in the bag
+//! @param combinations returns the number of ways of drawing letters to form
+//! the word with each number of blanks from 0 to maxBlanks
+//---------------------------------------------------------------------------
+void
+LetterBag::getNumCombinations(const int* letterCounts, int maxBlanks,
+                              double* combinations) const
+{
+    if (maxBlanks < 0)
+        maxBlanks = 0;
+
+    int counts[NUM_PLAIN_LETTERS];
+    int frequencies[NUM_PLAIN_LETTERS];
+    int numLetters = 0;
+    for (int i = 0; i < NUM_PLAIN_LETTERS; ++i) {
+        if (!letterCounts[i])
+            continue;
+        counts[numLetters] = letterCounts[i];
+        frequencies[numLetters] = plainFrequencies[i];
+        ++numLetters;
     }
-    totalCombos += thisCombo;
 
-    if (numBlanks == 0)
-        return totalCombos;
+    countCombinations(counts, frequencies, numLetters, maxBlanks,
+                      combinations);
+}
 
-    // Calculate the combinations with one blank
-    for (int i = 0; i < numLetters; ++i) {
-        --counts[i];
-        thisCombo = subChooseCombos[ letterFrequencies[BLANK_CHAR] ][1];
-        for (int j = 0; j < numLetters; ++j) {
-            thisCombo *= (*combos[j])[ counts[j] ];
+//---------------------------------------------------------------------------
+//  getNumCombinations
+//
+//! Calculate the unique ways of drawing each of a list of words from a full
+//! bag of letters when drawing the number of letters in the word.
+//
+//! @param words the words
+//! @param numBlanks the number of blanks considered to be in the bag
+//! @param combinations returns the number of ways of drawing letters to form
+//! each word, in the order of the words
+//---------------------------------------------------------------------------
+void
+LetterBag::getNumCombinations(const QStringList& words, int numBlanks,
+                              QVector<double>* combinations) const
+{
+    if (numBlanks < 0)
+        numBlanks = 0;
+
+    combinations->clear();
+    combinations->reserve(words.size());
+
+    QVarLengthArray<double, MAX_WORD_LEN + 1> wordCombinations
+        (numBlanks + 1);
+    int counts[NUM_PLAIN_LETTERS];
+    foreach (const QString& word, words) {
+        if (countPlainLetters(word, counts)) {
+            getNumCombinations(counts, numBlanks, wordCombinations.data());
+            combinations->append(wordCombinations[numBlanks]);
         }
-        totalCombos += thisCombo;
-        ++counts[i];
+        else
+            combinations->append(getNumCombinations(word, numBlanks));
     }
+}
 
-    if (numBlanks == 1)
-        return totalCombos;
+//---------------------------------------------------------------------------
+//  countPlainLetters
+//
+//! Count the letters of a word consisting only of the letters A to Z.
+//
+//! @param word the word
+//! @param counts returns the number of each letter from A to Z
+//! @return true if successful, false if the word contains other characters
+//---------------------------------------------------------------------------
+bool
+LetterBag::countPlainLetters(const QString& word, int* counts)
+{
+    for (int i = 0; i < NUM_PLAIN_LETTERS; ++i)
+        counts[i] = 0;
+
+    const QChar* letters = word.unicode();
+    int length = word.length();
+    for (int i = 0; i < length; ++i) {
+        uint index = uint(letters[i].unicode()) - 'A';
+        if (index >= uint(NUM_PLAIN_LETTERS))
+            return false;
+        ++counts[index];
+    }
+    return true;
+}
 
-    // Calculate the combinations with two blanks
-    for (int i = 0; i < numLetters; ++i) {
-        --counts[i];
-        for (int j = i; j < numLetters; ++j) {
-            if (!counts[j])
-                continue;
-            --counts[j];
-            thisCombo = subChooseCombos[ letterFrequencies[BLANK_CHAR] ][2];
+//---------------------------------------------------------------------------
+//  countCombinations
+//
+//! Calculate the unique ways of drawing a set of letters for each number of
+//! blanks up to a maximum.
+//
+//! The ways of drawing the letters with exactly B blanks is the sum, over
+//! every way of letting blanks stand for B of the letters, of the product of
+//! the ways of drawing the rest of each letter, times the ways of drawing B
+//! blanks.  Those sums are the coefficients of a polynomial with a factor
+//! for each distinct letter, which are built up one letter at a time.
+//
+//! @param counts the count of each distinct letter
+//! @param frequencies the frequency in the bag of each distinct letter
+//! @param numLetters the number of distinct letters
+//! @param maxBlanks the maximum number of blanks
+//! @param combinations returns the number of ways of drawing the letters with
+//! each number of blanks from 0 to maxBlanks
+//---------------------------------------------------------------------------
+void
+LetterBag::countCombinations(const int* counts, const int* frequencies,
+                             int numLetters, int maxBlanks,
+                             double* combinations) const
+{
+    // The ways of drawing the letters seen so far with each number of them
+    // replaced by blanks
+    QVarLengthArray<double, MAX_WORD_LEN + 1> ways (maxBlanks + 1);
+    ways[0] = 1.0;
+    for (int b = 1; b <= maxBlanks; ++b)
+        ways[b] = 0.0;
 
-            for (int k = 0; k < numLetters; ++k) {
-                thisCombo *= (*combos[k])[ counts[k] ];
-            }
-            totalCombos += thisCombo;
-            ++counts[j];
+    for (int i = 0; i < numLetters; ++i) {
+        const double* letterCombos = getChooseCombos(frequencies[i]);
+        int count = counts[i];
+
+        // Going down keeps the entries for fewer blanks intact while they
+        // are still needed
+        for (int b = maxBlanks; b >= 0; --b) {
+            int maxReplaced = qMin(b, count);
+            double sum = 0.0;
+            for (int r = 0; r <= maxReplaced; ++r)
+                sum += ways[b - r] * letterCombos[count - r];
+            ways[b] = sum;
         }
-        ++counts[i];
     }
 
-    //if (numBlanks == 2)
-    //    return totalCombos;
+    const double* blankCombos = getChooseCombos(plainFrequencies[BLANK_INDEX]);
+    double totalCombos = 0.0;
+    for (int b = 0; b <= maxBlanks; ++b) {
+        if (b < chooseStride)
+            totalCombos += ways[b] * blankCombos[b];
+        combinations[b] = totalCombos;
+    }
+}
 
-    return totalCombos;
+//---------------------------------------------------------------------------
+//  getChooseCombos
+//
+//! Get the precalculated combinations of drawing each number of a letter
+//! with a given frequency.  Frequencies outside the precalculated range are
+//! pared back to it.
+//
+//! @param frequency the frequency of the letter in the bag
+//! @return the combinations, indexed by the number drawn
+//---------------------------------------------------------------------------
+const double*
+LetterBag::getChooseCombos(int frequency) const
+{
+    frequency = qBound(0, frequency, chooseStride - 1);
+    return chooseCombos.constData() + frequency * chooseStride;
 }
 
 //---------------------------------------------------------------------------
@@ -247,29 +370,30 @@ LetterBag::resetContents(const QString& distribution)
             maxFrequency = frequency;
     }
 
+    for (int i = 0; i < NUM_PLAIN_LETTERS; ++i)
+        plainFrequencies[i] = letterFrequencies.value(QChar(ushort('A' + i)));
+    plainFrequencies[BLANK_INDEX] = letterFrequencies.value(BLANK_CHAR);
+
     // Precalculate M choose N combinations - use doubles because the numbers
-    // get very large
+    // get very large.  The combinations of drawing N of a letter with
+    // frequency F are stored in a row at index F * chooseStride + N.
+    fullChooseCombos.clear();
+    chooseStride = maxFrequency + 1;
+    chooseCombos.fill(0.0, chooseStride * chooseStride);
     double a = 1;
     double r = 1;
     for (int i = 0; i <= maxFrequency; ++i, ++r) {
         fullChooseCombos.append(a);
         a *= (totalLetters + 1.0 - r) / r;
 
-        QList<double> subList;
-        for (int j = 0; j <= maxFrequency; ++j) {
-            if ((i == j) || (j == 0))
-                subList.append(1.0);
-            else if (i == 0)
-                subList.append(0.0);
-            else {
-                // XXX: For some reason this crashes on Linux when referencing
-                // the first value as subChooseCombos[i-1][j-1], so value() is
-                // used instead.  Weeeeird.
-                subList.append(subChooseCombos.value(i-1).value(j-1) +
-                               subChooseCombos.value(i-1).value(j));
-            }
+        int row = i * chooseStride;
+        int prevRow = row - chooseStride;
+        chooseCombos[row] = 1.0;
+        for (int j = 1; j < i; ++j) {
+            chooseCombos[row + j] = chooseCombos[prevRow + j - 1] +
+                                    chooseCombos[prevRow + j];
         }
-        subChooseCombos.append(subList);
+        chooseCombos[row + i] = 1.0;
     }
 }
 
@@ -289,6 +413,7 @@ LetterBag::insertLetter(const QChar& letter)
     else
         letterFrequencies[c] = 1;
     ++totalLetters;
+    updatePlainFrequency(c);
 }
 
 //---------------------------------------------------------------------------
@@ -310,9 +435,28 @@ LetterBag::drawLetter(const QChar& letter)
     QChar c = letter.toUpper();
     --letterFrequencies[c];
     --totalLetters;
+    updatePlainFrequency(c);
     return true;
 }
 
+//---------------------------------------------------------------------------
+//  updatePlainFrequency
+//
+//! Update the frequency of a letter in the table of plain letter
+//! frequencies, if it is a plain letter or a blank.
+//
+//! @param letter the letter
+//---------------------------------------------------------------------------
+void
+LetterBag::updatePlainFrequency(const QChar& letter)
+{
+    uint index = uint(letter.unicode()) - 'A';
+    if (index < uint(NUM_PLAIN_LETTERS))
+        plainFrequencies[index] = letterFrequencies.value(letter);
+    else if (letter == BLANK_CHAR)
+        plainFrequencies[BLANK_INDEX] = letterFrequencies.value(letter);
+}
+
 //---------------------------------------------------------------------------
 //  lookRandomLetters
 //
@@ -30,6 +30,8 @@
 #include <QMap>
 #include <QList>
 #include <QString>
+#include <QStringList>
+#include <QVector>
 
 class LetterBag
 {
@@ -39,6 +41,10 @@ class LetterBag
 
     double getProbability(const QString& word, int numBlanks) const;
     double getNumCombinations(const QString& word, int numBlanks) const;
+    void getNumCombinations(const int* letterCounts, int maxBlanks,
+                            double* combinations) const;
+    void getNumCombinations(const QStringList& words, int numBlanks,
+                            QVector<double>* combinations) const;
 
     int getLetterValue(const QChar& letter) const;
     void setLetterValue(const QChar& letter, int value);
@@ -52,13 +58,29 @@ class LetterBag
     QString getLetters() const;
     int getNumLetters() const;
 
+    private:
+    static bool countPlainLetters(const QString& word, int* counts);
+    void countCombinations(const int* counts, const int* frequencies,
+                           int numLetters, int maxBlanks,
+                           double* combinations) const;
+    const double* getChooseCombos(int frequency) const;
+    void updatePlainFrequency(const QChar& letter);
+
+    private:
+    static const int NUM_PLAIN_LETTERS = 26;
+    static const int BLANK_INDEX = NUM_PLAIN_LETTERS;
+
     private:
     int totalLetters;
     QMap<QChar, int> letterFrequencies;
     QMap<QChar, int> letterValues;
 
+    // Frequencies of the letters A to Z, followed by the blank
+    int plainFrequencies[NUM_PLAIN_LETTERS + 1];
+
     QList<double> fullChooseCombos;
-    QList<QList<double> > subChooseCombos;
+    QVector<double> chooseCombos;
+    int chooseStride;
     Rand rng;
 
     public:
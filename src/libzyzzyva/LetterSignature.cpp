@@ -0,0 +1,122 @@
+//---------------------------------------------------------------------------
+// LetterSignature.cpp
+//
+// A class for comparing the multisets of letters in words.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "LetterSignature.h"
+
+//---------------------------------------------------------------------------
+//  LetterSignature
+//
+//! Constructor.  Count the letters and blanks of a string.  The signature
+//! is invalid if the string has any other characters, or more than
+//! MAX_COUNT of any letter.
+//
+//! @param letters the string of letters
+//---------------------------------------------------------------------------
+LetterSignature::LetterSignature(const QString& letters)
+    : low(0), high(0), numBlanks(0), valid(true)
+{
+    int length = letters.length();
+    const QChar* chars = letters.unicode();
+    for (int i = 0; i < length; ++i) {
+        ushort c = chars[i].unicode();
+        if (c == '?') {
+            ++numBlanks;
+            continue;
+        }
+
+        uint letter = uint(c) - 'A';
+        if (letter >= uint(NUM_LETTERS)) {
+            invalidate();
+            return;
+        }
+
+        addLetter(letter);
+        if (!valid)
+            return;
+    }
+}
+
+//---------------------------------------------------------------------------
+//  addLetter
+//
+//! Add a letter to the signature.  The signature becomes invalid if it
+//! already has MAX_COUNT of the letter.
+//
+//! @param letter the letter, from 0 for A to 25 for Z
+//---------------------------------------------------------------------------
+void
+LetterSignature::addLetter(int letter)
+{
+    if (!valid)
+        return;
+
+    if (getCount(letter) == MAX_COUNT) {
+        invalidate();
+        return;
+    }
+
+    if (letter < 16)
+        low += quint64(1) << (4 * letter);
+    else
+        high += quint64(1) << (4 * (letter - 16));
+}
+
+//---------------------------------------------------------------------------
+//  getLetters
+//
+//! Get the letters of the signature in alphabetical order, followed by a
+//! '?' for each blank.
+//
+//! @return the letters, or an empty string if the signature is invalid
+//---------------------------------------------------------------------------
+QString
+LetterSignature::getLetters() const
+{
+    if (!valid)
+        return QString();
+
+    QString letters;
+    letters.reserve(getNumLetters() + numBlanks);
+    for (int i = 0; i < NUM_LETTERS; ++i) {
+        QChar c (ushort('A' + i));
+        for (int count = getCount(i); count > 0; --count)
+            letters += c;
+    }
+    for (int i = 0; i < numBlanks; ++i)
+        letters += QChar('?');
+    return letters;
+}
+
+//---------------------------------------------------------------------------
+//  invalidate
+//
+//! Make the signature invalid, removing all letters and blanks.
+//---------------------------------------------------------------------------
+void
+LetterSignature::invalidate()
+{
+    low = high = 0;
+    numBlanks = 0;
+    valid = false;
+}
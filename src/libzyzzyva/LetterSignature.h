@@ -0,0 +1,132 @@
+//---------------------------------------------------------------------------
+// LetterSignature.h
+//
+// A class for comparing the multisets of letters in words.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_LETTER_SIGNATURE_H
+#define ZYZZYVA_LETTER_SIGNATURE_H
+
+#include <QString>
+
+// The number of each letter from A to Z in a string, held as 4-bit counts
+// packed into two 64-bit integers, with the number of blanks.  Letters are
+// compared a byte at a time across each integer, so comparisons do not
+// loop over letters.  Only strings of upper case letters and '?' blanks,
+// with at most 15 of each letter, have valid signatures.
+class LetterSignature
+{
+    public:
+    static const int NUM_LETTERS = 26;
+    static const int MAX_COUNT = 15;
+
+    public:
+    LetterSignature() : low(0), high(0), numBlanks(0), valid(true) { }
+    explicit LetterSignature(const QString& letters);
+    ~LetterSignature() { }
+
+    bool isValid() const { return valid; }
+    bool isEmpty() const { return !low && !high && !numBlanks; }
+    int getNumBlanks() const { return numBlanks; }
+    int getNumLetters() const { return sumCounts(low) + sumCounts(high); }
+    int getCount(int letter) const {
+        return (letter < 16) ? int((low >> (4 * letter)) & 0xF)
+                             : int((high >> (4 * (letter - 16))) & 0xF); }
+
+    void addLetter(int letter);
+    void addBlank() { if (valid) ++numBlanks; }
+    QString getLetters() const;
+
+    // True if this signature has at least as many of each letter as
+    // another, ignoring blanks
+    bool contains(const LetterSignature& other) const {
+        return atLeast(low, other.low) && atLeast(high, other.high); }
+
+    // True if this signature and another have any letter in common
+    bool intersects(const LetterSignature& other) const {
+        return ((nonZero(low) & nonZero(other.low)) |
+                (nonZero(high) & nonZero(other.high))) != 0; }
+
+    // The letters of this signature that are not in another, without
+    // blanks
+    LetterSignature minus(const LetterSignature& other) const {
+        LetterSignature result;
+        result.low = difference(low, other.low);
+        result.high = difference(high, other.high);
+        result.valid = valid && other.valid;
+        return result;
+    }
+
+    // The number of letters of another signature that are not in this one,
+    // which is the number of blanks needed to make the other from this
+    int getNumMissing(const LetterSignature& other) const {
+        return sumCounts(difference(other.low, low)) +
+               sumCounts(difference(other.high, high)); }
+
+    bool operator==(const LetterSignature& other) const {
+        return (low == other.low) && (high == other.high) &&
+               (numBlanks == other.numBlanks) && (valid == other.valid); }
+    bool operator!=(const LetterSignature& other) const {
+        return !(*this == other); }
+
+    private:
+    void invalidate();
+
+    static const quint64 NIBBLES = Q_UINT64_C(0x0F0F0F0F0F0F0F0F);
+    static const quint64 GUARDS = Q_UINT64_C(0x1010101010101010);
+    static const quint64 BYTES = Q_UINT64_C(0x0101010101010101);
+    static const quint64 ONES = Q_UINT64_C(0x1111111111111111);
+
+    // Each half of the counts is spread out to one count per byte, with a
+    // guard bit above each count that is cleared by subtraction if the count
+    // being subtracted is larger
+    static bool atLeast(quint64 a, quint64 b) {
+        quint64 even = ((a & NIBBLES) | GUARDS) - (b & NIBBLES);
+        quint64 odd = (((a >> 4) & NIBBLES) | GUARDS) - ((b >> 4) & NIBBLES);
+        return (even & odd & GUARDS) == GUARDS;
+    }
+    static quint64 differenceHalf(quint64 a, quint64 b) {
+        quint64 d = (a | GUARDS) - b;
+        quint64 keep = ((d & GUARDS) >> 4) * 0xF;
+        return d & keep & NIBBLES;
+    }
+    static quint64 difference(quint64 a, quint64 b) {
+        return differenceHalf(a & NIBBLES, b & NIBBLES) |
+            (differenceHalf((a >> 4) & NIBBLES, (b >> 4) & NIBBLES) << 4);
+    }
+    static quint64 nonZero(quint64 a) {
+        quint64 t = a | (a >> 1);
+        t |= t >> 2;
+        return t & ONES;
+    }
+    static int sumCounts(quint64 a) {
+        quint64 s = (a & NIBBLES) + ((a >> 4) & NIBBLES);
+        return int((s * BYTES) >> 56);
+    }
+
+    // Counts of A through P, and Q through Z in the low 40 bits
+    quint64 low;
+    quint64 high;
+    int numBlanks;
+    bool valid;
+};
+
+#endif // ZYZZYVA_LETTER_SIGNATURE_H
@@ -0,0 +1,148 @@
+//---------------------------------------------------------------------------
+// LexiconChecksumThread.cpp
+//
+// A class for verifying lexicon checksums in the background.
+//
+// Each line of a lexicon checksum file holds the checksum of one DAWG file,
+// either as a 16-bit CRC of the first bytes of the edges, as computed by
+// qChecksum for the original lexicon files, or as "fletcher64:" followed by
+// a Fletcher checksum of all the edges taken as 32-bit words, which is much
+// faster to compute.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "LexiconChecksumThread.h"
+#include <QFile>
+
+const QString WORD_CHECKSUM_PREFIX = "fletcher64:";
+
+// Number of words summed between reductions, small enough that neither sum
+// can overflow 64 bits
+const int WORD_CHECKSUM_BLOCK = 65536;
+
+//---------------------------------------------------------------------------
+//  addFile
+//
+//! Add a DAWG file to be verified.
+//
+//! @param filename the name of the file
+//! @param expectedChecksum the expected checksum, as read from a lexicon
+//! checksum file
+//---------------------------------------------------------------------------
+void
+LexiconChecksumThread::addFile(const QString& filename, const QString&
+                               expectedChecksum)
+{
+    filenames.append(filename);
+    expectedChecksums.append(expectedChecksum);
+}
+
+//---------------------------------------------------------------------------
+//  run
+//
+//! Verify the checksum of each file, and signal each file that does not
+//! match its expected checksum.
+//---------------------------------------------------------------------------
+void
+LexiconChecksumThread::run()
+{
+    for (int i = 0; i < filenames.size(); ++i) {
+        if (!verifyFile(filenames[i], expectedChecksums[i]))
+            emit checksumMismatch(lexiconName, filenames[i]);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  verifyFile
+//
+//! Determine whether a DAWG file matches its expected checksum.  The file is
+//! read in the byte order it is stored in, regardless of the host.
+//
+//! @param filename the name of the file
+//! @param expectedChecksum the expected checksum
+//! @return true if the checksum matches, false otherwise
+//---------------------------------------------------------------------------
+bool
+LexiconChecksumThread::verifyFile(const QString& filename, const QString&
+                                  expectedChecksum) const
+{
+    QFile file (filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QByteArray header = file.read(sizeof(qint32));
+    if (header.size() != int(sizeof(qint32)))
+        return false;
+
+    const uchar* h = reinterpret_cast<const uchar*>(header.constData());
+    qint32 numEdges = qint32(h[0] | (h[1] << 8) | (h[2] << 16) |
+                             (quint32(h[3]) << 24));
+    if (numEdges < 0)
+        return false;
+
+    QByteArray edges = file.read(qint64(numEdges) * sizeof(qint32));
+    if (edges.size() != int(numEdges * sizeof(qint32)))
+        return false;
+
+    QString expected = expectedChecksum.trimmed();
+    if (expected.startsWith(WORD_CHECKSUM_PREFIX)) {
+        bool ok = false;
+        quint64 value =
+            expected.mid(WORD_CHECKSUM_PREFIX.length()).toULongLong(&ok);
+        return ok && (getWordChecksum(edges) == value);
+    }
+
+    // The original checksum covers the first numEdges bytes of the edges
+    bool ok = false;
+    quint16 value = expected.toUShort(&ok);
+    return ok && (qChecksum(edges.constData(), numEdges) == value);
+}
+
+//---------------------------------------------------------------------------
+//  getWordChecksum
+//
+//! Compute a Fletcher checksum of an array of edges, taken as little-endian
+//! 32-bit words.
+//
+//! @param edges the edges
+//! @return the checksum
+//---------------------------------------------------------------------------
+quint64
+LexiconChecksumThread::getWordChecksum(const QByteArray& edges) const
+{
+    const quint64 MODULUS = 0xFFFFFFFFULL;
+    const uchar* data = reinterpret_cast<const uchar*>(edges.constData());
+    int numWords = edges.size() / sizeof(qint32);
+
+    quint64 sum1 = 0;
+    quint64 sum2 = 0;
+    for (int i = 0; i < numWords; ) {
+        int blockEnd = qMin(numWords, i + WORD_CHECKSUM_BLOCK);
+        for (; i < blockEnd; ++i, data += sizeof(qint32)) {
+            sum1 += quint32(data[0] | (data[1] << 8) | (data[2] << 16) |
+                            (quint32(data[3]) << 24));
+            sum2 += sum1;
+        }
+        sum1 %= MODULUS;
+        sum2 %= MODULUS;
+    }
+
+    return (sum2 << 32) | sum1;
+}
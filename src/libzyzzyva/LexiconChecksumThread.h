@@ -0,0 +1,59 @@
+//---------------------------------------------------------------------------
+// LexiconChecksumThread.h
+//
+// A class for verifying lexicon checksums in the background.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_LEXICON_CHECKSUM_THREAD_H
+#define ZYZZYVA_LEXICON_CHECKSUM_THREAD_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+class LexiconChecksumThread : public QThread
+{
+    Q_OBJECT
+    public:
+    LexiconChecksumThread(const QString& lex, QObject* parent = 0)
+        : QThread(parent), lexiconName(lex) { }
+    ~LexiconChecksumThread() { wait(); }
+
+    void addFile(const QString& filename, const QString& expectedChecksum);
+
+    signals:
+    void checksumMismatch(const QString& lexicon, const QString& filename);
+
+    protected:
+    void run();
+
+    private:
+    bool verifyFile(const QString& filename, const QString& expectedChecksum)
+        const;
+    quint64 getWordChecksum(const QByteArray& edges) const;
+
+    QString lexiconName;
+    QStringList filenames;
+    QStringList expectedChecksums;
+};
+
+#endif // ZYZZYVA_LEXICON_CHECKSUM_THREAD_H
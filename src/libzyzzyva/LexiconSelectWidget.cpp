@@ -24,6 +24,7 @@
 
 #include "LexiconSelectWidget.h"
 #include "MainSettings.h"
+#include "MainWindow.h"
 #include "Defs.h"
 #include <QHBoxLayout>
 #include <QLabel>
@@ -52,6 +53,8 @@ LexiconSelectWidget::LexiconSelectWidget(QWidget* parent, Qt::WFlags f)
     mainHlay->addWidget(lexiconLabel);
 
     lexiconCombo = new QComboBox;
+    connect(lexiconCombo, SIGNAL(activated(const QString&)),
+            SLOT(lexiconActivated(const QString&)));
     mainHlay->addWidget(lexiconCombo);
 
     updateLexicons();
@@ -108,6 +111,7 @@ LexiconSelectWidget::setCurrentLexicon(const QString& lexicon)
         return false;
 
     lexiconCombo->setCurrentIndex(index);
+    lexiconActivated(lexicon);
     return true;
 }
 
@@ -149,3 +153,19 @@ LexiconSelectWidget::updateLexicons()
 
     lexiconCombo->setCurrentIndex((selectIndex < 0) ? 0 : selectIndex);
 }
+
+//---------------------------------------------------------------------------
+//  lexiconActivated
+//
+//! Called when a lexicon is selected.  Make sure the lexicon is loaded
+//! before it is used, since its import may have been deferred.
+//
+//! @param lexicon the selected lexicon
+//---------------------------------------------------------------------------
+void
+LexiconSelectWidget::lexiconActivated(const QString& lexicon)
+{
+    MainWindow* window = MainWindow::getInstance();
+    if (window)
+        window->requireLexicon(lexicon);
+}
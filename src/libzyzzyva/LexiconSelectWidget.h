@@ -46,6 +46,9 @@ class LexiconSelectWidget : public QWidget
     public slots:
     void updateLexicons();
 
+    private slots:
+    void lexiconActivated(const QString& lexicon);
+
     private:
     QLabel* lexiconLabel;
     QComboBox* lexiconCombo;
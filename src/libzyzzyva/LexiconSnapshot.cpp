@@ -0,0 +1,430 @@
+//---------------------------------------------------------------------------
+// LexiconSnapshot.cpp
+//
+// A class for reading and writing binary snapshots of lexicon databases.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "LexiconSnapshot.h"
+#include <QByteArray>
+#include <QDateTime>
+#include <QFileInfo>
+#include <cstring>
+
+// The header is an array of 64-bit fields in native byte order: the magic
+// number, the format version, a byte order mark, the number of words, the
+// size and modification time of the database the snapshot was made from,
+// then the file offset of each column and of each string column.  Each
+// string column is an array of numWords + 1 32-bit offsets into the UTF-8
+// blob that follows it, so the string of word i runs from offset i to
+// offset i + 1.  Every section starts on an 8-byte boundary.
+const quint64 SNAPSHOT_MAGIC = 0x5a59534e41505348ULL;
+const quint64 SNAPSHOT_VERSION = 1;
+const quint64 SNAPSHOT_BYTE_ORDER = 0x0102030405060708ULL;
+const int NUM_HEADER_FIELDS = 6;
+const int HEADER_SIZE = (NUM_HEADER_FIELDS + LexiconSnapshot::NumColumns +
+                         LexiconSnapshot::NumStringColumns) * 8;
+const int SECTION_ALIGNMENT = 8;
+const QString SNAPSHOT_SUFFIX = ".snapshot";
+
+// Bytes taken by each word in each column
+const int COLUMN_WIDTHS[LexiconSnapshot::NumColumns] = {
+    1, 1, 1, 1, 1, 8, 3 * 4, 9 * 4, 3 * 8
+};
+
+//---------------------------------------------------------------------------
+//  alignSize
+//
+//! Round a size up to the alignment of snapshot sections.
+//
+//! @param size the size
+//! @return the aligned size
+//---------------------------------------------------------------------------
+static quint64
+alignSize(quint64 size)
+{
+    return (size + SECTION_ALIGNMENT - 1) & ~quint64(SECTION_ALIGNMENT - 1);
+}
+
+//---------------------------------------------------------------------------
+//  appendSection
+//
+//! Append a section to the data of a snapshot, padded to the alignment of
+//! snapshot sections.
+//
+//! @param bytes the snapshot data
+//! @param section the section data
+//! @param size the size of the section data
+//! @return the offset of the section
+//---------------------------------------------------------------------------
+static quint64
+appendSection(QByteArray& bytes, const void* section, int size)
+{
+    quint64 offset = bytes.size();
+    bytes.append(static_cast<const char*>(section), size);
+    bytes.append(QByteArray(alignSize(bytes.size()) - bytes.size(), '\0'));
+    return offset;
+}
+
+//---------------------------------------------------------------------------
+//  Columns::resize
+//
+//! Make room for the rows of a number of words.
+//
+//! @param numWords the number of words
+//---------------------------------------------------------------------------
+void
+LexiconSnapshot::Columns::resize(int numWords)
+{
+    flags.fill(0, numWords);
+    numVowels.fill(0, numWords);
+    numUniqueLetters.fill(0, numWords);
+    numAnagrams.fill(0, numWords);
+    pointValue.fill(0, numWords);
+    playability.fill(0, numWords);
+    playabilityOrders.fill(0, 3 * numWords);
+    probabilityOrders.fill(0, 9 * numWords);
+    combinations.fill(0, 3 * numWords);
+    for (int i = 0; i < NumStringColumns; ++i) {
+        strings[i].clear();
+        for (int j = 0; j < numWords; ++j)
+            strings[i].append(QString());
+    }
+}
+
+//---------------------------------------------------------------------------
+//  open
+//
+//! Open a snapshot file, mapping it into memory.
+//
+//! @param filename the name of the snapshot file
+//! @param errString returns the error string in case of error
+//! @return true if successful, false if the file cannot be mapped or is not
+//! a valid snapshot
+//---------------------------------------------------------------------------
+bool
+LexiconSnapshot::open(const QString& filename, QString* errString)
+{
+    close();
+
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errString) {
+            *errString = QString("Unable to open snapshot file '%1': %2")
+                .arg(filename).arg(file.errorString());
+        }
+        return false;
+    }
+
+    qint64 size = file.size();
+    const uchar* map = (size >= HEADER_SIZE) ? file.map(0, size) : 0;
+    const quint64* header = reinterpret_cast<const quint64*>(map);
+    bool ok = map && (header[0] == SNAPSHOT_MAGIC) &&
+        (header[1] == SNAPSHOT_VERSION) &&
+        (header[2] == SNAPSHOT_BYTE_ORDER) && (header[3] < 0x7fffffffULL);
+
+    if (ok) {
+        numWords = int(header[3]);
+        dbSize = header[4];
+        dbModified = header[5];
+        const quint64* offsets = header + NUM_HEADER_FIELDS;
+        for (int i = 0; ok && (i < NumColumns); ++i) {
+            columnOffsets[i] = offsets[i];
+            ok = (offsets[i] % SECTION_ALIGNMENT == 0) &&
+                (offsets[i] + quint64(numWords) * COLUMN_WIDTHS[i] <=
+                 quint64(size));
+        }
+
+        offsets += NumColumns;
+        for (int i = 0; ok && (i < NumStringColumns); ++i) {
+            stringOffsets[i] = offsets[i];
+            quint64 blobOffset = offsets[i] +
+                alignSize(quint64(numWords + 1) * 4);
+            ok = (offsets[i] % SECTION_ALIGNMENT == 0) &&
+                (blobOffset <= quint64(size));
+            if (ok) {
+                const quint32* stringEnds =
+                    reinterpret_cast<const quint32*>(map + offsets[i]);
+                ok = (stringEnds[0] == 0) &&
+                    (blobOffset + stringEnds[numWords] <= quint64(size));
+            }
+        }
+    }
+
+    if (!ok) {
+        if (errString) {
+            *errString = QString("The snapshot file '%1' is not valid.")
+                .arg(filename);
+        }
+        if (map)
+            file.unmap(const_cast<uchar*>(map));
+        file.close();
+        numWords = 0;
+        return false;
+    }
+
+    data = map;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  close
+//
+//! Close the snapshot file, if it is open.
+//---------------------------------------------------------------------------
+void
+LexiconSnapshot::close()
+{
+    if (data)
+        file.unmap(const_cast<uchar*>(data));
+    if (file.isOpen())
+        file.close();
+    data = 0;
+    numWords = 0;
+}
+
+//---------------------------------------------------------------------------
+//  matchesDatabase
+//
+//! Determine whether the snapshot was made from the current contents of a
+//! database file, by comparing the size and modification time of the file
+//! with those recorded when the snapshot was written.
+//
+//! @param dbFilename the name of the database file
+//! @return true if the snapshot matches the database, false otherwise
+//---------------------------------------------------------------------------
+bool
+LexiconSnapshot::matchesDatabase(const QString& dbFilename) const
+{
+    QFileInfo info (dbFilename);
+    return data && info.exists() && (quint64(info.size()) == dbSize) &&
+        (quint64(info.lastModified().toTime_t()) == dbModified);
+}
+
+//---------------------------------------------------------------------------
+//  getByteColumn
+//
+//! Get the values of a column holding one byte for each word.
+//
+//! @param column the column, from FlagsColumn to PointValueColumn
+//! @return the values indexed by word, or 0 if the snapshot is not open
+//---------------------------------------------------------------------------
+const quint8*
+LexiconSnapshot::getByteColumn(Column column) const
+{
+    if (column > PointValueColumn)
+        return 0;
+    return getColumnData(column);
+}
+
+//---------------------------------------------------------------------------
+//  getPlayability
+//
+//! Get the playability values of the words.
+//
+//! @return the values indexed by word, or 0 if the snapshot is not open
+//---------------------------------------------------------------------------
+const qint64*
+LexiconSnapshot::getPlayability() const
+{
+    return reinterpret_cast<const qint64*>(
+        getColumnData(PlayabilityColumn));
+}
+
+//---------------------------------------------------------------------------
+//  getPlayabilityOrders
+//
+//! Get the playability orders of the words, in groups of three.
+//
+//! @return the orders, or 0 if the snapshot is not open
+//---------------------------------------------------------------------------
+const qint32*
+LexiconSnapshot::getPlayabilityOrders() const
+{
+    return reinterpret_cast<const qint32*>(
+        getColumnData(PlayabilityOrdersColumn));
+}
+
+//---------------------------------------------------------------------------
+//  getProbabilityOrders
+//
+//! Get the probability orders of the words, in groups of nine.
+//
+//! @return the orders, or 0 if the snapshot is not open
+//---------------------------------------------------------------------------
+const qint32*
+LexiconSnapshot::getProbabilityOrders() const
+{
+    return reinterpret_cast<const qint32*>(
+        getColumnData(ProbabilityOrdersColumn));
+}
+
+//---------------------------------------------------------------------------
+//  getCombinations
+//
+//! Get the combinations of the words with 0 to 2 blanks, in groups of
+//! three.
+//
+//! @return the combinations, or 0 if the snapshot is not open
+//---------------------------------------------------------------------------
+const double*
+LexiconSnapshot::getCombinations() const
+{
+    return reinterpret_cast<const double*>(
+        getColumnData(CombinationsColumn));
+}
+
+//---------------------------------------------------------------------------
+//  getString
+//
+//! Get a string value of a word.
+//
+//! @param column the string column
+//! @param id the alphabetical index of the word
+//! @return the string, or a null string if the snapshot is not open or the
+//! index is out of range
+//---------------------------------------------------------------------------
+QString
+LexiconSnapshot::getString(StringColumn column, int id) const
+{
+    if (!data || (id < 0) || (id >= numWords))
+        return QString();
+
+    const uchar* section = data + stringOffsets[column];
+    const quint32* stringEnds = reinterpret_cast<const quint32*>(section);
+    const char* blob = reinterpret_cast<const char*>(
+        section + alignSize(quint64(numWords + 1) * 4));
+    quint32 start = stringEnds[id];
+    quint32 end = stringEnds[id + 1];
+    if ((end <= start) || (end > stringEnds[numWords]))
+        return QString();
+    return QString::fromUtf8(blob + start, end - start);
+}
+
+//---------------------------------------------------------------------------
+//  getFilename
+//
+//! Get the name of the snapshot file of a database.
+//
+//! @param dbFilename the name of the database file
+//! @return the name of the snapshot file
+//---------------------------------------------------------------------------
+QString
+LexiconSnapshot::getFilename(const QString& dbFilename)
+{
+    return dbFilename + SNAPSHOT_SUFFIX;
+}
+
+//---------------------------------------------------------------------------
+//  write
+//
+//! Write a snapshot file.  The rows must be in the alphabetical order of
+//! the words.
+//
+//! @param filename the name of the snapshot file
+//! @param columns the rows of the words
+//! @param dbFilename the name of the database file the rows were read from
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+LexiconSnapshot::write(const QString& filename, const Columns& columns,
+                       const QString& dbFilename, QString* errString)
+{
+    int n = columns.getNumWords();
+    QFileInfo dbInfo (dbFilename);
+
+    QByteArray bytes (HEADER_SIZE, '\0');
+    quint64 header[HEADER_SIZE / 8];
+    header[0] = SNAPSHOT_MAGIC;
+    header[1] = SNAPSHOT_VERSION;
+    header[2] = SNAPSHOT_BYTE_ORDER;
+    header[3] = n;
+    header[4] = dbInfo.size();
+    header[5] = dbInfo.lastModified().toTime_t();
+
+    quint64* offsets = header + NUM_HEADER_FIELDS;
+    offsets[FlagsColumn] =
+        appendSection(bytes, columns.flags.constData(), n);
+    offsets[NumVowelsColumn] =
+        appendSection(bytes, columns.numVowels.constData(), n);
+    offsets[NumUniqueLettersColumn] =
+        appendSection(bytes, columns.numUniqueLetters.constData(), n);
+    offsets[NumAnagramsColumn] =
+        appendSection(bytes, columns.numAnagrams.constData(), n);
+    offsets[PointValueColumn] =
+        appendSection(bytes, columns.pointValue.constData(), n);
+    offsets[PlayabilityColumn] =
+        appendSection(bytes, columns.playability.constData(), 8 * n);
+    offsets[PlayabilityOrdersColumn] =
+        appendSection(bytes, columns.playabilityOrders.constData(), 12 * n);
+    offsets[ProbabilityOrdersColumn] =
+        appendSection(bytes, columns.probabilityOrders.constData(), 36 * n);
+    offsets[CombinationsColumn] =
+        appendSection(bytes, columns.combinations.constData(), 24 * n);
+
+    offsets += NumColumns;
+    for (int i = 0; i < NumStringColumns; ++i) {
+        const QStringList& strings = columns.strings[i];
+        QVector<quint32> stringEnds (n + 1, 0);
+        QByteArray blob;
+        for (int j = 0; j < n; ++j) {
+            if (j < strings.size())
+                blob.append(strings[j].toUtf8());
+            stringEnds[j + 1] = blob.size();
+        }
+        offsets[i] = appendSection(bytes, stringEnds.constData(),
+                                   4 * (n + 1));
+        appendSection(bytes, blob.constData(), blob.size());
+    }
+
+    memcpy(bytes.data(), header, HEADER_SIZE);
+
+    QFile file (filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        (file.write(bytes) != bytes.size()))
+    {
+        if (errString) {
+            *errString = QString("Unable to write snapshot file '%1': %2")
+                .arg(filename).arg(file.errorString());
+        }
+        file.close();
+        QFile::remove(filename);
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  getColumnData
+//
+//! Get the data of a column.
+//
+//! @param column the column
+//! @return the data, or 0 if the snapshot is not open
+//---------------------------------------------------------------------------
+const uchar*
+LexiconSnapshot::getColumnData(Column column) const
+{
+    if (!data)
+        return 0;
+    return data + columnOffsets[column];
+}
@@ -0,0 +1,126 @@
+//---------------------------------------------------------------------------
+// LexiconSnapshot.h
+//
+// A class for reading and writing binary snapshots of lexicon databases.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_LEXICON_SNAPSHOT_H
+#define ZYZZYVA_LEXICON_SNAPSHOT_H
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// A snapshot holds the word rows of a lexicon database in alphabetical
+// order, so the row of a word is found at the alphabetical index of the
+// word in the word graph.  Numeric attributes are held in fixed-width
+// columns, and strings in UTF-8 blobs indexed by offset, so the snapshot
+// can be read in place from a memory-mapped file.  Playability orders are
+// held in groups of three, probability orders in groups of nine, and
+// combinations in groups of three, as in WordEngine::WordAttributes.
+class LexiconSnapshot
+{
+    public:
+    enum Column {
+        FlagsColumn = 0,
+        NumVowelsColumn,
+        NumUniqueLettersColumn,
+        NumAnagramsColumn,
+        PointValueColumn,
+        PlayabilityColumn,
+        PlayabilityOrdersColumn,
+        ProbabilityOrdersColumn,
+        CombinationsColumn,
+        NumColumns
+    };
+
+    enum StringColumn {
+        WordColumn = 0,
+        FrontHooksColumn,
+        BackHooksColumn,
+        LexiconSymbolsColumn,
+        DefinitionColumn,
+        NumStringColumns
+    };
+
+    enum Flag {
+        FrontHookFlag = 1,
+        BackHookFlag = 2
+    };
+
+    // Rows of a snapshot being written
+    class Columns {
+        public:
+        Columns() { }
+        ~Columns() { }
+
+        int getNumWords() const { return flags.size(); }
+        void resize(int numWords);
+
+        QVector<quint8> flags;
+        QVector<quint8> numVowels;
+        QVector<quint8> numUniqueLetters;
+        QVector<quint8> numAnagrams;
+        QVector<quint8> pointValue;
+        QVector<qint64> playability;
+        QVector<qint32> playabilityOrders;
+        QVector<qint32> probabilityOrders;
+        QVector<double> combinations;
+        QStringList strings[NumStringColumns];
+    };
+
+    public:
+    LexiconSnapshot() : data(0), numWords(0) { }
+    ~LexiconSnapshot() { close(); }
+
+    bool open(const QString& filename, QString* errString = 0);
+    void close();
+    bool isOpen() const { return data != 0; }
+    bool matchesDatabase(const QString& dbFilename) const;
+    int getNumWords() const { return numWords; }
+    qint64 getNumBytes() const { return data ? file.size() : 0; }
+
+    const quint8* getByteColumn(Column column) const;
+    const qint64* getPlayability() const;
+    const qint32* getPlayabilityOrders() const;
+    const qint32* getProbabilityOrders() const;
+    const double* getCombinations() const;
+    QString getString(StringColumn column, int id) const;
+
+    static QString getFilename(const QString& dbFilename);
+    static bool write(const QString& filename, const Columns& columns,
+                      const QString& dbFilename, QString* errString = 0);
+
+    private:
+    const uchar* getColumnData(Column column) const;
+
+    private:
+    QFile file;
+    const uchar* data;
+    int numWords;
+    quint64 dbSize;
+    quint64 dbModified;
+    quint64 columnOffsets[NumColumns];
+    quint64 stringOffsets[NumStringColumns];
+};
+
+#endif // ZYZZYVA_LEXICON_SNAPSHOT_H
@@ -51,8 +51,17 @@ const QString SETTINGS_IMPORT_LEXICON = "autoimport_lexicon";
 const QString SETTINGS_IMPORT_LEXICONS = "autoimport_lexicons";
 const QString SETTINGS_DEFAULT_LEXICON = "default_lexicon";
 const QString SETTINGS_IMPORT_FILE = "autoimport_file";
+const QString SETTINGS_IMPORT_LAZY = "autoimport_lazy";
+const QString SETTINGS_IMPORT_BULK_BUILD = "autoimport_bulk_build";
+const QString SETTINGS_IMPORT_INDEX_SETS = "autoimport_index_sets";
 const QString SETTINGS_DISPLAY_WELCOME = "display_welcome";
 const QString SETTINGS_USER_DATA_DIR = "user_data_dir";
+const QString SETTINGS_WORD_CACHE_SIZE = "word_cache_size";
+const QString SETTINGS_SEARCH_CACHE_SIZE = "search_cache_size";
+const QString SETTINGS_DATABASE_CACHE_SIZE = "database_cache_size";
+const QString SETTINGS_DATABASE_MAP_SIZE = "database_map_size";
+const QString SETTINGS_SAVE_WORD_CACHE = "save_word_cache";
+const QString SETTINGS_SAVE_SEARCH_RESULTS = "save_search_results";
 const QString SETTINGS_FONT_MAIN = "font";
 const QString SETTINGS_FONT_WORD_LISTS = "font_word_lists";
 const QString SETTINGS_FONT_QUIZ_LABEL = "font_quiz_label";
@@ -75,6 +84,11 @@ const QString SETTINGS_LEXICON_STYLES = "wordlist_lexicon_styles";
 const QString SETTINGS_USE_TILE_THEME = "use_tile_theme";
 const QString SETTINGS_TILE_THEME = "tile_theme";
 const QString SETTINGS_SEARCH_SELECT_INPUT = "search_select_input";
+const QString SETTINGS_SEARCH_NUM_THREADS = "search_num_threads";
+const QString SETTINGS_SEARCH_USE_INFIX_INDEX = "search_use_infix_index";
+const QString SETTINGS_SEARCH_SUCCINCT_REVERSE_DAWG
+    = "search_succinct_reverse_dawg";
+const QString SETTINGS_SEARCH_PROFILE = "search_profile";
 const QString SETTINGS_QUIZ_LETTER_ORDER = "quiz_letter_order";
 const QString SETTINGS_QUIZ_BACKGROUND_COLOR = "quiz_background_color";
 const QString SETTINGS_QUIZ_USE_FLASHCARD_MODE = "quiz_use_flashcard_mode";
@@ -95,6 +109,7 @@ const QString SETTINGS_QUIZ_TIMEOUT_DISABLE_INPUT = "quiz_timeout_disable_input"
 const QString SETTINGS_QUIZ_TIMEOUT_DISABLE_INPUT_MSECS
     = "quiz_timeout_disable_input_msecs";
 const QString SETTINGS_QUIZ_RECORD_STATS = "quiz_record_stats";
+const QString SETTINGS_QUIZ_COMPACT_STATS = "quiz_compact_stats";
 const QString SETTINGS_PROBABILITY_NUM_BLANKS = "probability_num_blanks";
 const QString SETTINGS_CARDBOX_SCHEDULES = "cardbox_schedules";
 const QString SETTINGS_CARDBOX_WINDOWS = "cardbox_windows";
@@ -102,12 +117,25 @@ const QString SETTINGS_LETTER_DISTRIBUTION = "letter_distribution";
 const QString SETTINGS_JUDGE_SAVE_LOG = "judge_save_log";
 
 const bool    DEFAULT_AUTO_IMPORT = true;
+const bool    DEFAULT_AUTO_IMPORT_LAZY = false;
+const bool    DEFAULT_AUTO_IMPORT_BULK_BUILD = true;
+const QString DEFAULT_AUTO_IMPORT_INDEX_SETS = QString();
 const QString DEFAULT_DEFAULT_LEXICON = Defs::LEXICON_OWL2;
 const bool    DEFAULT_DISPLAY_WELCOME = true;
 const QString DEFAULT_USER_DATA_DIR = Auxil::getHomeDir() + "/Zyzzyva";
+const int     DEFAULT_WORD_CACHE_SIZE = 64;
+const int     DEFAULT_SEARCH_CACHE_SIZE = 16;
+const int     DEFAULT_DATABASE_CACHE_SIZE = 32;
+const int     DEFAULT_DATABASE_MAP_SIZE = 256;
+const bool    DEFAULT_SAVE_WORD_CACHE = true;
+const bool    DEFAULT_SAVE_SEARCH_RESULTS = true;
 const bool    DEFAULT_USE_TILE_THEME = true;
 const QString DEFAULT_TILE_THEME = "tan-with-border";
 const bool    DEFAULT_SEARCH_SELECT_INPUT = true;
+const int     DEFAULT_SEARCH_NUM_THREADS = 1;
+const bool    DEFAULT_SEARCH_USE_INFIX_INDEX = false;
+const bool    DEFAULT_SEARCH_SUCCINCT_REVERSE_DAWG = false;
+const bool    DEFAULT_SEARCH_PROFILE = false;
 const QString DEFAULT_QUIZ_LETTER_ORDER = Defs::QUIZ_LETTERS_ALPHA;
 const QRgb    DEFAULT_QUIZ_BACKGROUND_COLOR = qRgb(0, 0, 127);
 const bool    DEFAULT_QUIZ_USE_FLASHCARD_MODE = false;
@@ -123,6 +151,7 @@ const bool    DEFAULT_QUIZ_CYCLE_ANSWERS = true;
 const bool    DEFAULT_QUIZ_TIMEOUT_DISABLE_INPUT = true;
 const int     DEFAULT_QUIZ_TIMEOUT_DISABLE_INPUT_MSECS = 750;
 const bool    DEFAULT_QUIZ_RECORD_STATS = true;
+const bool    DEFAULT_QUIZ_COMPACT_STATS = false;
 const int     DEFAULT_PROBABILITY_NUM_BLANKS = 2;
 const QString DEFAULT_CARDBOX_SCHEDULES = "1 4 7 12 20 30 60 90 150 270 480";
 const QString DEFAULT_CARDBOX_WINDOWS = "0 1 2 3 5 7 10 15 20 30 50";
@@ -166,6 +195,8 @@ const QString DEFAULT_LETTER_DISTRIBUTION = "A:9 B:2 C:2 D:4 E:12 F:2 G:3 "
 void
 MainSettings::readSettings()
 {
+    ++instance->version;
+
     QSettings settings;
     settings.beginGroup(SETTINGS_MAIN);
 
@@ -201,6 +232,13 @@ MainSettings::readSettings()
 
     instance->useAutoImport =
         settings.value(SETTINGS_IMPORT, DEFAULT_AUTO_IMPORT).toBool();
+    instance->useLazyImport =
+        settings.value(SETTINGS_IMPORT_LAZY, DEFAULT_AUTO_IMPORT_LAZY).toBool();
+    instance->useBulkBuild = settings.value(SETTINGS_IMPORT_BULK_BUILD,
+                                            DEFAULT_AUTO_IMPORT_BULK_BUILD)
+        .toBool();
+    instance->databaseIndexSets = settings.value(SETTINGS_IMPORT_INDEX_SETS,
+        DEFAULT_AUTO_IMPORT_INDEX_SETS).toString();
 
     // Get default lexicon, either from current setting or old one
     instance->defaultLexicon
@@ -237,6 +275,25 @@ MainSettings::readSettings()
         settings.value(SETTINGS_USER_DATA_DIR,
                        DEFAULT_USER_DATA_DIR).toString());
 
+    instance->wordCacheSize
+        = settings.value(SETTINGS_WORD_CACHE_SIZE,
+                         DEFAULT_WORD_CACHE_SIZE).toInt();
+    instance->searchCacheSize
+        = settings.value(SETTINGS_SEARCH_CACHE_SIZE,
+                         DEFAULT_SEARCH_CACHE_SIZE).toInt();
+    instance->databaseCacheSize
+        = settings.value(SETTINGS_DATABASE_CACHE_SIZE,
+                         DEFAULT_DATABASE_CACHE_SIZE).toInt();
+    instance->databaseMapSize
+        = settings.value(SETTINGS_DATABASE_MAP_SIZE,
+                         DEFAULT_DATABASE_MAP_SIZE).toInt();
+    instance->saveWordCache
+        = settings.value(SETTINGS_SAVE_WORD_CACHE,
+                         DEFAULT_SAVE_WORD_CACHE).toBool();
+    instance->saveSearchResults
+        = settings.value(SETTINGS_SAVE_SEARCH_RESULTS,
+                         DEFAULT_SAVE_SEARCH_RESULTS).toBool();
+
     instance->useTileTheme
         = settings.value(SETTINGS_USE_TILE_THEME,
                          DEFAULT_USE_TILE_THEME).toBool();
@@ -246,6 +303,18 @@ MainSettings::readSettings()
     instance->searchSelectInput
         = settings.value(SETTINGS_SEARCH_SELECT_INPUT,
                          DEFAULT_SEARCH_SELECT_INPUT).toBool();
+    instance->searchNumThreads
+        = settings.value(SETTINGS_SEARCH_NUM_THREADS,
+                         DEFAULT_SEARCH_NUM_THREADS).toInt();
+    instance->searchUseInfixIndex
+        = settings.value(SETTINGS_SEARCH_USE_INFIX_INDEX,
+                         DEFAULT_SEARCH_USE_INFIX_INDEX).toBool();
+    instance->searchSuccinctReverseDawg
+        = settings.value(SETTINGS_SEARCH_SUCCINCT_REVERSE_DAWG,
+                         DEFAULT_SEARCH_SUCCINCT_REVERSE_DAWG).toBool();
+    instance->searchProfile
+        = settings.value(SETTINGS_SEARCH_PROFILE,
+                         DEFAULT_SEARCH_PROFILE).toBool();
 
     instance->quizLetterOrder
         = settings.value(SETTINGS_QUIZ_LETTER_ORDER,
@@ -295,6 +364,9 @@ MainSettings::readSettings()
     instance->quizRecordStats
         = settings.value(SETTINGS_QUIZ_RECORD_STATS,
                          DEFAULT_QUIZ_RECORD_STATS).toBool();
+    instance->quizCompactStats
+        = settings.value(SETTINGS_QUIZ_COMPACT_STATS,
+                         DEFAULT_QUIZ_COMPACT_STATS).toBool();
 
     instance->probabilityNumBlanks
         = settings.value(SETTINGS_PROBABILITY_NUM_BLANKS,
@@ -372,6 +444,8 @@ MainSettings::readSettings()
 void
 MainSettings::writeSettings()
 {
+    ++instance->version;
+
     QSettings settings;
     settings.beginGroup(SETTINGS_MAIN);
     settings.setValue(SETTINGS_MAIN_WINDOW_POS, instance->mainWindowPos);
@@ -379,15 +453,34 @@ MainSettings::writeSettings()
 
     settings.setValue(SETTINGS_PROGRAM_VERSION, instance->programVersion);
     settings.setValue(SETTINGS_IMPORT, instance->useAutoImport);
+    settings.setValue(SETTINGS_IMPORT_LAZY, instance->useLazyImport);
+    settings.setValue(SETTINGS_IMPORT_BULK_BUILD, instance->useBulkBuild);
+    settings.setValue(SETTINGS_IMPORT_INDEX_SETS,
+                      instance->databaseIndexSets);
     settings.setValue(SETTINGS_IMPORT_LEXICONS, instance->autoImportLexicons);
     settings.setValue(SETTINGS_DEFAULT_LEXICON, instance->defaultLexicon);
     settings.setValue(SETTINGS_IMPORT_FILE, instance->autoImportFile);
     settings.setValue(SETTINGS_DISPLAY_WELCOME, instance->displayWelcome);
     settings.setValue(SETTINGS_USER_DATA_DIR, instance->userDataDir);
+    settings.setValue(SETTINGS_WORD_CACHE_SIZE, instance->wordCacheSize);
+    settings.setValue(SETTINGS_SEARCH_CACHE_SIZE, instance->searchCacheSize);
+    settings.setValue(SETTINGS_DATABASE_CACHE_SIZE,
+                      instance->databaseCacheSize);
+    settings.setValue(SETTINGS_DATABASE_MAP_SIZE, instance->databaseMapSize);
+    settings.setValue(SETTINGS_SAVE_WORD_CACHE, instance->saveWordCache);
+    settings.setValue(SETTINGS_SAVE_SEARCH_RESULTS,
+                      instance->saveSearchResults);
     settings.setValue(SETTINGS_USE_TILE_THEME, instance->useTileTheme);
     settings.setValue(SETTINGS_TILE_THEME, instance->tileTheme);
     settings.setValue(SETTINGS_SEARCH_SELECT_INPUT,
                       instance->searchSelectInput);
+    settings.setValue(SETTINGS_SEARCH_NUM_THREADS,
+                      instance->searchNumThreads);
+    settings.setValue(SETTINGS_SEARCH_USE_INFIX_INDEX,
+                      instance->searchUseInfixIndex);
+    settings.setValue(SETTINGS_SEARCH_SUCCINCT_REVERSE_DAWG,
+                      instance->searchSuccinctReverseDawg);
+    settings.setValue(SETTINGS_SEARCH_PROFILE, instance->searchProfile);
     settings.setValue(SETTINGS_QUIZ_LETTER_ORDER,
                       instance->quizLetterOrder);
     settings.setValue(SETTINGS_QUIZ_BACKGROUND_COLOR,
@@ -417,6 +510,8 @@ MainSettings::writeSettings()
                       instance->quizTimeoutDisableInputMillisecs);
     settings.setValue(SETTINGS_QUIZ_RECORD_STATS,
                       instance->quizRecordStats);
+    settings.setValue(SETTINGS_QUIZ_COMPACT_STATS,
+                      instance->quizCompactStats);
 
     settings.setValue(SETTINGS_PROBABILITY_NUM_BLANKS,
                       instance->probabilityNumBlanks);
@@ -490,17 +585,33 @@ MainSettings::writeSettings()
 void
 MainSettings::restoreDefaults(const QString& group)
 {
+    ++instance->version;
+
     if (group.isEmpty() || (group == GENERAL_PREFS_GROUP)) {
         instance->useAutoImport = DEFAULT_AUTO_IMPORT;
+        instance->useLazyImport = DEFAULT_AUTO_IMPORT_LAZY;
+        instance->useBulkBuild = DEFAULT_AUTO_IMPORT_BULK_BUILD;
+        instance->databaseIndexSets = DEFAULT_AUTO_IMPORT_INDEX_SETS;
         instance->defaultLexicon = DEFAULT_DEFAULT_LEXICON;
         instance->autoImportLexicons = QStringList(DEFAULT_DEFAULT_LEXICON);
         instance->autoImportFile = QString();
         instance->displayWelcome = DEFAULT_DISPLAY_WELCOME;
         instance->userDataDir = DEFAULT_USER_DATA_DIR;
+        instance->wordCacheSize = DEFAULT_WORD_CACHE_SIZE;
+        instance->searchCacheSize = DEFAULT_SEARCH_CACHE_SIZE;
+        instance->databaseCacheSize = DEFAULT_DATABASE_CACHE_SIZE;
+        instance->databaseMapSize = DEFAULT_DATABASE_MAP_SIZE;
+        instance->saveWordCache = DEFAULT_SAVE_WORD_CACHE;
+        instance->saveSearchResults = DEFAULT_SAVE_SEARCH_RESULTS;
     }
 
     if (group.isEmpty() || (group == SEARCH_PREFS_GROUP)) {
         instance->searchSelectInput = DEFAULT_SEARCH_SELECT_INPUT;
+        instance->searchNumThreads = DEFAULT_SEARCH_NUM_THREADS;
+        instance->searchUseInfixIndex = DEFAULT_SEARCH_USE_INFIX_INDEX;
+        instance->searchSuccinctReverseDawg =
+            DEFAULT_SEARCH_SUCCINCT_REVERSE_DAWG;
+        instance->searchProfile = DEFAULT_SEARCH_PROFILE;
     }
 
     if (group.isEmpty() || (group == QUIZ_PREFS_GROUP)) {
@@ -527,6 +638,7 @@ MainSettings::restoreDefaults(const QString& group)
         instance->quizTimeoutDisableInputMillisecs =
             DEFAULT_QUIZ_TIMEOUT_DISABLE_INPUT_MSECS;
         instance->quizRecordStats = DEFAULT_QUIZ_RECORD_STATS;
+        instance->quizCompactStats = DEFAULT_QUIZ_COMPACT_STATS;
     }
 
     if (group.isEmpty() || (group == PROBABILITY_PREFS_GROUP)) {
@@ -48,6 +48,7 @@ class MainSettings
     static void readSettings();
     static void writeSettings();
     static void restoreDefaults(const QString& group);
+    static int getVersion() { return instance->version; }
 
     static QString getProgramVersion() {
         return instance->programVersion; }
@@ -59,6 +60,14 @@ class MainSettings
     static void setMainWindowSize(QSize s) { instance->mainWindowSize = s; }
     static bool getUseAutoImport() { return instance->useAutoImport; }
     static void setUseAutoImport(bool b) { instance->useAutoImport = b; }
+    static bool getUseLazyImport() { return instance->useLazyImport; }
+    static void setUseLazyImport(bool b) { instance->useLazyImport = b; }
+    static bool getUseBulkBuild() { return instance->useBulkBuild; }
+    static void setUseBulkBuild(bool b) { instance->useBulkBuild = b; }
+    static QString getDatabaseIndexSets() {
+        return instance->databaseIndexSets; }
+    static void setDatabaseIndexSets(const QString& str) {
+        instance->databaseIndexSets = str; }
     static QStringList getAutoImportLexicons() {
         return instance->autoImportLexicons; }
     static void setAutoImportLexicons(const QStringList& slist) {
@@ -76,6 +85,21 @@ class MainSettings
     static QString getUserDataDir() { return instance->userDataDir; }
     static void setUserDataDir(const QString& str) {
         instance->userDataDir = str; }
+    static int getWordCacheSize() { return instance->wordCacheSize; }
+    static void setWordCacheSize(int i) { instance->wordCacheSize = i; }
+    static int getSearchCacheSize() { return instance->searchCacheSize; }
+    static void setSearchCacheSize(int i) { instance->searchCacheSize = i; }
+    static int getDatabaseCacheSize() { return instance->databaseCacheSize; }
+    static void setDatabaseCacheSize(int i) {
+        instance->databaseCacheSize = i; }
+    static int getDatabaseMapSize() { return instance->databaseMapSize; }
+    static void setDatabaseMapSize(int i) { instance->databaseMapSize = i; }
+    static bool getSaveWordCache() { return instance->saveWordCache; }
+    static void setSaveWordCache(bool b) { instance->saveWordCache = b; }
+    static bool getSaveSearchResults() {
+        return instance->saveSearchResults; }
+    static void setSaveSearchResults(bool b) {
+        instance->saveSearchResults = b; }
     static bool getUseTileTheme() { return instance->useTileTheme; }
     static void setUseTileTheme(bool b) { instance->useTileTheme = b; }
     static QString getTileTheme() { return instance->tileTheme; }
@@ -84,6 +108,19 @@ class MainSettings
     static bool getSearchSelectInput() { return instance->searchSelectInput; }
     static void setSearchSelectInput(bool b) {
         instance->searchSelectInput = b; }
+    static int getSearchNumThreads() { return instance->searchNumThreads; }
+    static void setSearchNumThreads(int i) {
+        instance->searchNumThreads = i; }
+    static bool getSearchUseInfixIndex() {
+        return instance->searchUseInfixIndex; }
+    static void setSearchUseInfixIndex(bool b) {
+        instance->searchUseInfixIndex = b; }
+    static bool getSearchSuccinctReverseDawg() {
+        return instance->searchSuccinctReverseDawg; }
+    static void setSearchSuccinctReverseDawg(bool b) {
+        instance->searchSuccinctReverseDawg = b; }
+    static bool getSearchProfile() { return instance->searchProfile; }
+    static void setSearchProfile(bool b) { instance->searchProfile = b; }
     static QString getQuizLetterOrder() { return instance->quizLetterOrder; }
     static void setQuizLetterOrder(const QString& str) {
         instance->quizLetterOrder = str; }
@@ -139,6 +176,10 @@ class MainSettings
         return instance->quizRecordStats; }
     static void setQuizRecordStats(bool b) {
         instance->quizRecordStats = b; }
+    static bool getQuizCompactStats() {
+        return instance->quizCompactStats; }
+    static void setQuizCompactStats(bool b) {
+        instance->quizCompactStats = b; }
     static int getProbabilityNumBlanks() {
         return instance->probabilityNumBlanks; }
     static void setProbabilityNumBlanks(int i) {
@@ -229,7 +270,15 @@ class MainSettings
     static void setJudgeSaveLog(bool b) { instance->judgeSaveLog = b; }
 
     private:
-    MainSettings() : useAutoImport(false), useTileTheme(false),
+    MainSettings() : version(0), useAutoImport(false), useLazyImport(false),
+                     useBulkBuild(false),
+                     wordCacheSize(64),
+                     searchCacheSize(16), databaseCacheSize(32),
+                     databaseMapSize(256), saveWordCache(true),
+                     saveSearchResults(true),
+                     useTileTheme(false),
+                     searchNumThreads(1), searchUseInfixIndex(false),
+                     searchSuccinctReverseDawg(false), searchProfile(false),
                      wordListSortByLength(false),
                      wordListSortByReverseLength(false),
                      wordListSortByProbabilityOrder(false),
@@ -251,18 +300,34 @@ class MainSettings
 
     static MainSettings* instance;
 
+    // Incremented whenever settings are read, written or restored to their
+    // defaults, so copies of settings can tell whether they are current
+    int version;
     QString programVersion;
     QPoint mainWindowPos;
     QSize mainWindowSize;
     bool useAutoImport;
+    bool useLazyImport;
+    bool useBulkBuild;
+    QString databaseIndexSets;
     QStringList autoImportLexicons;
     QString autoImportFile;
     QString defaultLexicon;
     bool displayWelcome;
     QString userDataDir;
+    int wordCacheSize;
+    int searchCacheSize;
+    int databaseCacheSize;
+    int databaseMapSize;
+    bool saveWordCache;
+    bool saveSearchResults;
     bool useTileTheme;
     QString tileTheme;
     bool searchSelectInput;
+    int searchNumThreads;
+    bool searchUseInfixIndex;
+    bool searchSuccinctReverseDawg;
+    bool searchProfile;
     QString quizLetterOrder;
     QColor quizBackgroundColor;
     bool quizUseFlashcardMode;
@@ -278,6 +343,7 @@ class MainSettings
     bool quizTimeoutDisableInput;
     int quizTimeoutDisableInputMillisecs;
     bool quizRecordStats;
+    bool quizCompactStats;
     int probabilityNumBlanks;
     QList<int> cardboxScheduleList;
     QList<int> cardboxWindowList;
@@ -304,4 +370,50 @@ class MainSettings
     bool judgeSaveLog;
 };
 
+// The word list settings, read once so code that uses them many times in
+// one operation reads plain fields instead.  A copy is current as long as
+// its version is the version of the main settings.
+class WordListSettings
+{
+    public:
+    WordListSettings() { refresh(); }
+    ~WordListSettings() { }
+
+    bool isCurrent() const { return version == MainSettings::getVersion(); }
+    void refresh() {
+        version = MainSettings::getVersion();
+        sortByLength = MainSettings::getWordListSortByLength();
+        sortByReverseLength = MainSettings::getWordListSortByReverseLength();
+        sortByProbabilityOrder =
+            MainSettings::getWordListSortByProbabilityOrder();
+        sortByPlayabilityOrder =
+            MainSettings::getWordListSortByPlayabilityOrder();
+        groupByAnagrams = MainSettings::getWordListGroupByAnagrams();
+        showProbabilityOrder =
+            MainSettings::getWordListShowProbabilityOrder();
+        showPlayabilityOrder =
+            MainSettings::getWordListShowPlayabilityOrder();
+        showHooks = MainSettings::getWordListShowHooks();
+        showHookParents = MainSettings::getWordListShowHookParents();
+        useHookParentHyphens =
+            MainSettings::getWordListUseHookParentHyphens();
+        showDefinitions = MainSettings::getWordListShowDefinitions();
+        useLexiconStyles = MainSettings::getWordListUseLexiconStyles();
+    }
+
+    int version;
+    bool sortByLength;
+    bool sortByReverseLength;
+    bool sortByProbabilityOrder;
+    bool sortByPlayabilityOrder;
+    bool groupByAnagrams;
+    bool showProbabilityOrder;
+    bool showPlayabilityOrder;
+    bool showHooks;
+    bool showHookParents;
+    bool useHookParentHyphens;
+    bool showDefinitions;
+    bool useLexiconStyles;
+};
+
 #endif // ZYZZYVA_MAIN_SETTINGS_H
@@ -28,11 +28,13 @@
 #include "CardboxRescheduleDialog.h"
 #include "CreateDatabaseThread.h"
 #include "DatabaseRebuildDialog.h"
+#include "DatabaseRebuildProgressDialog.h"
 #include "DefinitionDialog.h"
 #include "DefineForm.h"
 #include "IntroForm.h"
 #include "JudgeDialog.h"
 #include "JudgeSelectDialog.h"
+#include "LexiconChecksumThread.h"
 #include "LexiconSelectDialog.h"
 #include "MainSettings.h"
 #include "NewQuizDialog.h"
@@ -40,6 +42,7 @@
 #include "QuizForm.h"
 #include "SearchForm.h"
 #include "SettingsDialog.h"
+#include "Trace.h"
 #include "WordEngine.h"
 #include "WordEntryDialog.h"
 #include "WordVariationDialog.h"
@@ -48,17 +51,22 @@
 #include "Defs.h"
 #include <QAction>
 #include <QApplication>
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QLabel>
 #include <QMenuBar>
 #include <QMessageBox>
-#include <QProgressDialog>
+#include <QPair>
 #include <QSignalMapper>
 #include <QStatusBar>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QTextStream>
+#include <QThread>
 #include <QToolBar>
 
 #include "LetterBag.h"
@@ -78,9 +86,56 @@ const QString SETTINGS_GEOMETRY_WIDTH = "/width";
 const QString SETTINGS_GEOMETRY_HEIGHT = "/height";
 
 const int DETAILS_FONT_MIN_POINTS = 6;
+const int PRELOAD_DELAY_MSECS = 1000;
+const int PRELOAD_INTERVAL_MSECS = 100;
+
+const QString EXIT_AFTER_STARTUP_ARG = "--exit-after-startup";
+const QString STARTUP_BUDGET_ARG = "--startup-budget=";
+
+// The startup trace: the monotonic time in milliseconds since the start of
+// main at which each startup phase finished - see markStartupPhase
+static QElapsedTimer startupTimer;
+static QList<QPair<QString, qint64> > startupPhases;
 
 using namespace Defs;
 
+//---------------------------------------------------------------------------
+//  GraphLoadThread
+//
+//! A thread that reads the word graph of a lexicon from its forward and
+//! reverse DAWG files.  A graph read with warnings is thrown away, so the
+//! lexicon is imported the usual way and the warnings are reported.
+//---------------------------------------------------------------------------
+class MainWindow::GraphLoadThread : public QThread
+{
+    public:
+    GraphLoadThread(const QString& f, const QString& r)
+        : QThread(), filename(f), reverseFilename(r), graph(0) { }
+    ~GraphLoadThread() { delete graph; }
+
+    WordGraph* takeGraph() {
+        WordGraph* g = graph;
+        graph = 0;
+        return g;
+    }
+
+    protected:
+    void run() {
+        QString errString;
+        graph = WordEngine::loadDawgGraph(filename, reverseFilename,
+                                          &errString);
+        if (graph && !errString.isEmpty()) {
+            delete graph;
+            graph = 0;
+        }
+    }
+
+    private:
+    QString filename;
+    QString reverseFilename;
+    WordGraph* graph;
+};
+
 //---------------------------------------------------------------------------
 //  MainWindow
 //
@@ -92,7 +147,8 @@ using namespace Defs;
 MainWindow::MainWindow(QWidget* parent, QSplashScreen* splash, Qt::WFlags f)
     : QMainWindow(parent, f), splashScreen(splash),
       wordEngine(new WordEngine()), settingsDialog(new SettingsDialog(this)),
-      aboutDialog(new AboutDialog(this))
+      aboutDialog(new AboutDialog(wordEngine, this)), exitAfterStartup(false),
+      startupBudget(0)
 {
     setSplashMessage("Creating interface...");
 
@@ -262,6 +318,18 @@ MainWindow::MainWindow(QWidget* parent, QSplashScreen* splash, Qt::WFlags f)
             SLOT(rescheduleCardboxRequested()));
     toolsMenu->addAction(rescheduleCardboxAction);
 
+    QAction* mergeQuizStatsAction = new QAction("&Merge Quiz Stats...", this);
+    connect(mergeQuizStatsAction, SIGNAL(triggered()),
+            SLOT(mergeQuizStatsRequested()));
+    toolsMenu->addAction(mergeQuizStatsAction);
+
+#if defined Z_TRACE
+    QAction* saveTraceAction = new QAction("Save &Trace...", this);
+    connect(saveTraceAction, SIGNAL(triggered()),
+            SLOT(saveTraceRequested()));
+    toolsMenu->addAction(saveTraceAction);
+#endif
+
     // Help Menu
     QMenu* helpMenu = menuBar()->addMenu("&Help");
 
@@ -370,8 +438,63 @@ MainWindow::fileOpenRequested(const QString& filename)
 void
 MainWindow::processArguments(const QStringList& args)
 {
-    foreach (const QString& arg, args)
-        fileOpenRequested(arg);
+    foreach (const QString& arg, args) {
+        if (arg == EXIT_AFTER_STARTUP_ARG)
+            exitAfterStartup = true;
+        else if (arg.startsWith(STARTUP_BUDGET_ARG))
+            startupBudget = arg.mid(STARTUP_BUDGET_ARG.length()).toInt();
+        else
+            fileOpenRequested(arg);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  markStartupPhase
+//
+//! Record the time at which a startup phase finished.  The first call
+//! starts the startup clock, so it should be made at the start of main.
+//
+//! @param phase the name of the phase
+//---------------------------------------------------------------------------
+void
+MainWindow::markStartupPhase(const QString& phase)
+{
+    if (!startupTimer.isValid())
+        startupTimer.start();
+    startupPhases.append(qMakePair(phase, startupTimer.elapsed()));
+}
+
+//---------------------------------------------------------------------------
+//  startupFinished
+//
+//! Called once the event loop has started.  Paint the window, append the
+//! startup trace to the startup log in the user data directory, and exit
+//! if requested on the command line, with a nonzero status if startup took
+//! longer than the startup budget.
+//---------------------------------------------------------------------------
+void
+MainWindow::startupFinished()
+{
+    repaint();
+    markStartupPhase("first paint");
+
+    qint64 total = startupPhases.last().second;
+    bool overBudget = (startupBudget > 0) && (total > startupBudget);
+
+    QFile file (Auxil::getUserDir() + "/startup.log");
+    file.open(QIODevice::Append | QIODevice::Text);
+    QTextStream stream (&file);
+    stream << QDateTime::currentDateTime().toString("[yyyy-MM-dd hh:mm:ss]");
+    for (int i = 0; i < startupPhases.size(); ++i) {
+        stream << (i ? ", " : " ") << startupPhases[i].first << " "
+            << startupPhases[i].second << " ms";
+    }
+    if (overBudget)
+        stream << " - over budget of " << startupBudget << " ms";
+    endl(stream);
+
+    if (exitAfterStartup)
+        qApp->exit(overBudget ? 1 : 0);
 }
 
 //---------------------------------------------------------------------------
@@ -433,12 +556,57 @@ MainWindow::tryAutoImport()
         delete dialog;
     }
 
+    // When importing lazily, only the default lexicon is imported now.  The
+    // others are imported on first use, or preloaded once the window is up.
+    if (MainSettings::getUseLazyImport() && (lexicons.size() > 1)) {
+        QString defaultLexicon = MainSettings::getDefaultLexicon();
+        if (!lexicons.contains(defaultLexicon))
+            defaultLexicon = lexicons.first();
+
+        pendingLexicons = lexicons;
+        pendingLexicons.removeAll(defaultLexicon);
+        lexicons = QStringList(defaultLexicon);
+        QTimer::singleShot(PRELOAD_DELAY_MSECS, this,
+                           SLOT(preloadLexicons()));
+    }
+
+    // Read the word graphs of DAWG lexicons in background threads, a few at
+    // a time, and add each lexicon in turn once its graph has been read
+    QList<GraphLoadThread*> threads;
+    foreach (const QString& lexicon, lexicons) {
+        QString prefix = Auxil::getLexiconPrefix(lexicon);
+        GraphLoadThread* thread = 0;
+        if ((lexicon != LEXICON_CUSTOM) && !prefix.isEmpty() &&
+            !wordEngine->lexiconIsLoaded(lexicon))
+        {
+            prefix = Auxil::getWordsDir() + prefix;
+            thread = new GraphLoadThread(prefix + ".dwg", prefix + "-R.dwg");
+        }
+        threads.append(thread);
+    }
+
     // FIXME: This should not be part of the MainWindow class.  Lexicons (and
     // mapping lexicons to actual files) should be handled by someone else.
-    QStringListIterator it (lexicons);
-    while (it.hasNext()) {
-        const QString& lexicon = it.next();
-        importLexicon(lexicon);
+    int maxThreads = qMax(1, QThread::idealThreadCount());
+    int numStarted = 0;
+    for (int i = 0; i < lexicons.size(); ++i) {
+        for (; (numStarted < threads.size()) &&
+             (numStarted < i + maxThreads); ++numStarted)
+        {
+            if (threads[numStarted])
+                threads[numStarted]->start();
+        }
+
+        const QString& lexicon = lexicons[i];
+        setSplashMessage(QString("Loading %1 lexicon (%2 of %3)...").arg(
+            lexicon).arg(i + 1).arg(lexicons.size()));
+        WordGraph* graph = 0;
+        if (threads[i]) {
+            threads[i]->wait();
+            graph = threads[i]->takeGraph();
+            delete threads[i];
+        }
+        importLexicon(lexicon, graph);
     }
 }
 
@@ -458,6 +626,8 @@ MainWindow::tryConnectToDatabases()
     QStringListIterator it (lexicons);
     while (it.hasNext()) {
         const QString& lexicon = it.next();
+        if (pendingLexicons.contains(lexicon))
+            continue;
         int error = tryConnectToDatabase(lexicon);
         if (error != DbNoError)
             dbErrors.insert(lexicon, error);
@@ -501,6 +671,10 @@ MainWindow::processDatabaseErrors()
         actionText += lexicon + " - " + errorActions.value(error) + "\n";
     }
 
+    // Do not prompt again for the same errors
+    QStringList lexicons = dbErrors.keys();
+    dbErrors.clear();
+
     message = Auxil::dialogWordWrap(message.arg(actionText));
 
     int code = QMessageBox::question(this, caption, message,
@@ -509,7 +683,94 @@ MainWindow::processDatabaseErrors()
     if (code != QMessageBox::Yes)
         return;
 
-    rebuildDatabases(dbErrors.keys());
+    rebuildDatabases(lexicons);
+}
+
+//---------------------------------------------------------------------------
+//  loadLexicon
+//
+//! Load a lexicon whose import was deferred by lazy importing, and connect
+//! to its database.  Database errors are saved for processDatabaseErrors.
+//! Nothing is done if the lexicon is already loaded.
+//
+//! @param lexicon the name of the lexicon
+//! @return true if successful or already loaded, false otherwise
+//---------------------------------------------------------------------------
+bool
+MainWindow::loadLexicon(const QString& lexicon)
+{
+    if (!pendingLexicons.contains(lexicon))
+        return true;
+
+    // Messages are displayed in the status bar after startup
+    QString status = messageLabel->text();
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool ok = importLexicon(lexicon);
+    if (ok) {
+        int error = tryConnectToDatabase(lexicon);
+        if (error != DbNoError)
+            dbErrors.insert(lexicon, error);
+    }
+    QApplication::restoreOverrideCursor();
+
+    messageLabel->setText(status);
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+//  requireLexicon
+//
+//! Make sure a lexicon is loaded before it is used, loading it now if its
+//! import was deferred, and prompting the user about any lexicon or
+//! database errors.
+//
+//! @param lexicon the name of the lexicon
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+MainWindow::requireLexicon(const QString& lexicon)
+{
+    if (!pendingLexicons.contains(lexicon))
+        return true;
+
+    bool ok = loadLexicon(lexicon);
+    displayLexiconError();
+    processDatabaseErrors();
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+//  preloadLexicons
+//
+//! Load the next lexicon whose import was deferred by lazy importing, and
+//! schedule loading the one after it.  Lexicons are loaded one at a time so
+//! the interface stays responsive between them.  Database errors are
+//! processed after the last lexicon is loaded.
+//---------------------------------------------------------------------------
+void
+MainWindow::preloadLexicons()
+{
+    if (pendingLexicons.isEmpty())
+        return;
+
+    // Wait while the user is busy with a modal dialog
+    if (QApplication::activeModalWidget()) {
+        QTimer::singleShot(PRELOAD_DELAY_MSECS, this,
+                           SLOT(preloadLexicons()));
+        return;
+    }
+
+    loadLexicon(pendingLexicons.first());
+
+    if (pendingLexicons.isEmpty()) {
+        displayLexiconError();
+        processDatabaseErrors();
+    }
+    else {
+        QTimer::singleShot(PRELOAD_INTERVAL_MSECS, this,
+                           SLOT(preloadLexicons()));
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -579,6 +840,8 @@ MainWindow::newQuizFormInteractive(const QuizSpec& quizSpec)
 void
 MainWindow::newQuizForm(const QuizSpec& quizSpec)
 {
+    requireLexicon(quizSpec.getLexicon());
+
     QuizForm* form = new QuizForm(wordEngine);
     form->setTileTheme(MainSettings::getTileTheme());
     bool ok = form->newQuiz(quizSpec);
@@ -690,6 +953,9 @@ MainWindow::doJudgeAction()
     QString password = selectDialog->getPassword();
     delete selectDialog;
 
+    if (!requireLexicon(lexicon))
+        return;
+
     QApplication::setOverrideCursor(Qt::BlankCursor);
     JudgeDialog* dialog = new JudgeDialog(wordEngine, lexicon, password, this);
     dialog->exec();
@@ -803,7 +1069,7 @@ MainWindow::editSettings()
 void
 MainWindow::viewDefinition()
 {
-    WordEntryDialog* entryDialog = new WordEntryDialog(this);
+    WordEntryDialog* entryDialog = new WordEntryDialog(wordEngine, this);
     entryDialog->setWindowTitle("Word Definition");
     entryDialog->resize(entryDialog->minimumSizeHint().width() * 2,
                         entryDialog->minimumSizeHint().height());
@@ -842,7 +1108,7 @@ MainWindow::viewVariation(int variation)
         default: break;
     }
 
-    WordEntryDialog* entryDialog = new WordEntryDialog(this);
+    WordEntryDialog* entryDialog = new WordEntryDialog(wordEngine, this);
     entryDialog->setWindowTitle(caption);
     entryDialog->resize(entryDialog->minimumSizeHint().width() * 2,
                         entryDialog->minimumSizeHint().height());
@@ -872,17 +1138,34 @@ MainWindow::rebuildDatabaseRequested()
 
     int code = dialog->exec();
     if (code == QDialog::Accepted) {
-        QStringList lexicons;
-        if (dialog->getRebuildAll())
-            lexicons = MainSettings::getAutoImportLexicons();
-        else
-            lexicons.append(dialog->getLexicon());
-
-        rebuildDatabases(lexicons);
+        QStringList lexicons = dialog->getLexicons();
+        if (!lexicons.isEmpty())
+            rebuildDatabases(lexicons, dialog->getIncremental());
     }
     delete dialog;
 }
 
+//---------------------------------------------------------------------------
+//  saveTraceRequested
+//
+//! Called when the user requests to save the trace events recorded so
+//! far.
+//---------------------------------------------------------------------------
+void
+MainWindow::saveTraceRequested()
+{
+    QString filename = QFileDialog::getSaveFileName(this, "Save Trace",
+        Trace::getDefaultFilename(), "Trace Files (*.json)");
+    if (filename.isEmpty())
+        return;
+
+    QString errString;
+    if (!Trace::writeFile(filename, &errString)) {
+        QMessageBox::warning(this, "Cannot Save Trace",
+                             "Cannot save the trace:\n" + errString);
+    }
+}
+
 //---------------------------------------------------------------------------
 //  rescheduleCardboxRequested
 //
@@ -931,6 +1214,64 @@ MainWindow::rescheduleCardboxRequested()
     delete dialog;
 }
 
+//---------------------------------------------------------------------------
+//  mergeQuizStatsRequested
+//
+//! Called when the user requests to merge a quiz stats database from
+//! another computer into the local quiz stats.  The lexicon and quiz type
+//! are taken from the location of the file, which is named for the quiz
+//! type in a directory named for the lexicon, as in the quiz directory.
+//---------------------------------------------------------------------------
+void
+MainWindow::mergeQuizStatsRequested()
+{
+    QString filename = QFileDialog::getOpenFileName(this, "Merge Quiz Stats",
+        Auxil::getQuizDir() + "/data", "Quiz Stats Files (*.db)");
+    if (filename.isEmpty())
+        return;
+
+    QFileInfo fileInfo (filename);
+    QString quizType = fileInfo.completeBaseName();
+    QString lexicon = fileInfo.absoluteDir().dirName();
+    if ((Auxil::stringToQuizType(quizType) == QuizSpec::UnknownQuizType) ||
+        !wordEngine->lexiconIsLoaded(lexicon))
+    {
+        QString message = "Cannot merge quiz stats from '" + filename +
+            "': the file must be named for a quiz type, in a directory "
+            "named for a loaded lexicon.";
+        QMessageBox::warning(this, "Cannot Merge Quiz Stats",
+                             Auxil::dialogWordWrap(message));
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    int numMerged = 0;
+    QString errString;
+    bool ok = false;
+    {
+        QuizStatsDatabase db (lexicon, quizType);
+        if (db.isValid())
+            ok = db.mergeDatabase(filename, &numMerged, &errString);
+        else
+            errString = "Cannot open the " + lexicon + " " + quizType +
+                " quiz stats.";
+    }
+    QApplication::restoreOverrideCursor();
+
+    if (!ok) {
+        QMessageBox::warning(this, "Cannot Merge Quiz Stats",
+                             "Cannot merge the quiz stats:\n" + errString);
+        return;
+    }
+
+    QString questionStr = numMerged == 1 ? QString("question")
+                                         : QString("questions");
+    QString message = QString::number(numMerged) + " " + questionStr +
+        " merged into the " + lexicon + " " + quizType + " quiz stats.";
+    QMessageBox::information(this, "Quiz Stats Merged",
+                             Auxil::dialogWordWrap(message));
+}
+
 //---------------------------------------------------------------------------
 //  displayAbout
 //
@@ -939,6 +1280,7 @@ MainWindow::rescheduleCardboxRequested()
 void
 MainWindow::displayAbout()
 {
+    aboutDialog->updateMemoryReport();
     aboutDialog->exec();
 }
 
@@ -975,6 +1317,32 @@ MainWindow::displayLexiconError()
         qApp->quit();
 }
 
+//---------------------------------------------------------------------------
+//  lexiconChecksumMismatch
+//
+//! Called when a lexicon file does not match its expected checksum.  Warn
+//! the user, and give the option of quitting.
+//
+//! @param lexicon the name of the lexicon
+//! @param filename the name of the lexicon file
+//---------------------------------------------------------------------------
+void
+MainWindow::lexiconChecksumMismatch(const QString& lexicon, const QString&
+                                    filename)
+{
+    QString caption = "Lexicon Warning";
+    QString message = "The '" + lexicon + "' lexicon was loaded, but the "
+        "checksum of the lexicon file '" + filename + "' does not match the "
+        "expected checksum.  It is possible the lexicon has been "
+        "corrupted.\n\nProceed anyway?";
+    message = Auxil::dialogWordWrap(message);
+    int code = QMessageBox::warning(this, caption, message,
+                                    QMessageBox::Yes | QMessageBox::No,
+                                    QMessageBox::No);
+    if (code != QMessageBox::Yes)
+        qApp->quit();
+}
+
 //---------------------------------------------------------------------------
 //  helpDialogError
 //
@@ -1246,17 +1614,60 @@ MainWindow::connectToDatabase(const QString& lexicon)
 //  rebuildDatabases
 //
 //! Rebuild the databases for a list of lexicons.  Also display a progress
-//! dialog.
+//! dialog.  The databases are rebuilt at the same time, each by its own
+//! thread, with as many running at once as there are processors, and the
+//! processors shared among the threads running.
 //
 //! @param lexicons the list of lexicons
+//! @param incremental whether to only update the words that have changed
 //---------------------------------------------------------------------------
 void
-MainWindow::rebuildDatabases(const QStringList& lexicons)
+MainWindow::rebuildDatabases(const QStringList& lexicons, bool incremental)
 {
     QStringList successes;
     QStringList failures;
+    QStringList rebuildLexicons;
+    QList<CreateDatabaseThread*> threads;
     foreach (const QString& lexicon, lexicons) {
-        bool ok = rebuildDatabase(lexicon);
+        CreateDatabaseThread* thread = startDatabaseRebuild(lexicon,
+                                                            incremental);
+        if (!thread) {
+            failures.append(lexicon);
+            continue;
+        }
+        rebuildLexicons.append(lexicon);
+        threads.append(thread);
+    }
+
+    if (!threads.isEmpty()) {
+        int numProcessors = qMax(1, QThread::idealThreadCount());
+        int maxRunning = qMin(numProcessors, threads.size());
+
+        DatabaseRebuildProgressDialog* dialog =
+            new DatabaseRebuildProgressDialog(this);
+        dialog->setMaxRunning(maxRunning);
+        for (int i = 0; i < threads.size(); ++i) {
+            if (maxRunning > 1)
+                threads[i]->setNumThreads(qMax(1, numProcessors / maxRunning));
+            dialog->addThread(rebuildLexicons[i], threads[i]);
+        }
+
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+
+        dialog->startThreads();
+        dialog->exec();
+        foreach (CreateDatabaseThread* thread, threads)
+            thread->wait();
+
+        QApplication::restoreOverrideCursor();
+        delete dialog;
+    }
+
+    for (int i = 0; i < threads.size(); ++i) {
+        const QString& lexicon = rebuildLexicons[i];
+        bool ok = finishDatabaseRebuild(lexicon, threads[i]);
+        delete threads[i];
+
         // FIXME: do something if DB creation fails!
         if (!ok) {
             failures.append(lexicon);
@@ -1289,10 +1700,51 @@ MainWindow::rebuildDatabases(const QStringList& lexicons)
 //! Rebuild the database for a lexicon.  Also display a progress dialog.
 //
 //! @param lexicon the lexicon name
+//! @param incremental whether to only update the words that have changed,
+//! if the existing database is up to date otherwise
 //! @return true if successful, false otherwise
 //---------------------------------------------------------------------------
 bool
-MainWindow::rebuildDatabase(const QString& lexicon)
+MainWindow::rebuildDatabase(const QString& lexicon, bool incremental)
+{
+    CreateDatabaseThread* thread = startDatabaseRebuild(lexicon,
+                                                        incremental);
+    if (!thread)
+        return false;
+
+    DatabaseRebuildProgressDialog* dialog =
+        new DatabaseRebuildProgressDialog(this);
+    dialog->addThread(lexicon, thread);
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    dialog->startThreads();
+    dialog->exec();
+    thread->wait();
+
+    QApplication::restoreOverrideCursor();
+
+    bool success = finishDatabaseRebuild(lexicon, thread);
+    delete thread;
+    delete dialog;
+    return success;
+}
+
+//---------------------------------------------------------------------------
+//  startDatabaseRebuild
+//
+//! Prepare to rebuild the database for a lexicon, by disconnecting from the
+//! database and moving it aside, and create the thread to rebuild it.  The
+//! thread is not started.
+//
+//! @param lexicon the lexicon name
+//! @param incremental whether to only update the words that have changed,
+//! if the existing database is up to date otherwise
+//! @return the thread, to be deleted by the caller, or 0 if the database
+//! cannot be moved aside
+//---------------------------------------------------------------------------
+CreateDatabaseThread*
+MainWindow::startDatabaseRebuild(const QString& lexicon, bool incremental)
 {
     QString dbFilename = Auxil::getDatabaseFilename(lexicon);
     QString definitionFilename;
@@ -1304,10 +1756,7 @@ MainWindow::rebuildDatabase(const QString& lexicon)
             Auxil::getLexiconPrefix(lexicon) + ".txt";
     }
 
-    QFileInfo fileInfo (dbFilename);
-    QString file = fileInfo.fileName();
-    QString path = fileInfo.path();
-    QString tmpDbFilename = path + "/orig-" + file;
+    QString tmpDbFilename = getDatabaseBackupFilename(dbFilename);
 
     wordEngine->disconnectFromDatabase(lexicon);
     QFile dbFile (dbFilename);
@@ -1321,7 +1770,7 @@ MainWindow::rebuildDatabase(const QString& lexicon)
             "file, then restart Zyzzyva.";
         message = Auxil::dialogWordWrap(message);
         QMessageBox::warning(this, caption, message);
-        return false;
+        return 0;
     }
 
     ok = (!dbFile.exists() || dbFile.rename(tmpDbFilename));
@@ -1333,31 +1782,34 @@ MainWindow::rebuildDatabase(const QString& lexicon)
         message = Auxil::dialogWordWrap(message);
         QMessageBox::warning(this, caption, message);
         tmpDbFile.rename(dbFilename);
-        return false;
+        return 0;
     }
 
-    QProgressDialog* dialog = new QProgressDialog(this);
-
-    QLabel* dialogLabel = new QLabel("Creating " + lexicon + " database...");
-    dialog->setWindowTitle("Creating " + lexicon + " Database");
-    dialog->setLabel(dialogLabel);
-
     CreateDatabaseThread* thread = new CreateDatabaseThread(wordEngine,
         lexicon, dbFilename, definitionFilename, this);
-    connect(thread, SIGNAL(steps(int)),
-            dialog, SLOT(setMaximum(int)));
-    connect(thread, SIGNAL(progress(int)),
-            dialog, SLOT(setValue(int)));
-    connect(dialog, SIGNAL(canceled()), thread, SLOT(cancel()));
-
-    QApplication::setOverrideCursor(Qt::WaitCursor);
-
-    thread->start();
-    dialog->exec();
-    thread->quit();
-    thread->wait();
+    if (incremental && tmpDbFile.exists())
+        thread->setBaseFilename(tmpDbFilename);
+    return thread;
+}
 
-    QApplication::restoreOverrideCursor();
+//---------------------------------------------------------------------------
+//  finishDatabaseRebuild
+//
+//! Finish rebuilding the database for a lexicon, once its thread has
+//! stopped.  Report any error, and restore the original database if the
+//! rebuild failed or was cancelled.
+//
+//! @param lexicon the lexicon name
+//! @param thread the thread that rebuilt the database
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+MainWindow::finishDatabaseRebuild(const QString& lexicon,
+                                  CreateDatabaseThread* thread)
+{
+    QString dbFilename = Auxil::getDatabaseFilename(lexicon);
+    QFile dbFile (dbFilename);
+    QFile tmpDbFile (getDatabaseBackupFilename(dbFilename));
 
     bool success = true;
     if (!thread->getError().isEmpty()) {
@@ -1368,7 +1820,7 @@ MainWindow::rebuildDatabase(const QString& lexicon)
 
     else if (thread->getCancelled()) {
         QMessageBox::information(this, "Database Not Created",
-            "Database creation cancelled.");
+            "Creation of " + lexicon + " database cancelled.");
         success = false;
     }
 
@@ -1379,11 +1831,25 @@ MainWindow::rebuildDatabase(const QString& lexicon)
             tmpDbFile.rename(dbFilename);
     }
 
-    delete thread;
-    delete dialog;
     return success;
 }
 
+//---------------------------------------------------------------------------
+//  getDatabaseBackupFilename
+//
+//! Get the name of the file an existing database is moved to while it is
+//! being rebuilt.
+//
+//! @param dbFilename the database filename
+//! @return the backup filename
+//---------------------------------------------------------------------------
+QString
+MainWindow::getDatabaseBackupFilename(const QString& dbFilename) const
+{
+    QFileInfo fileInfo (dbFilename);
+    return fileInfo.path() + "/orig-" + fileInfo.fileName();
+}
+
 //---------------------------------------------------------------------------
 //  rescheduleCardbox
 //
@@ -1476,6 +1942,9 @@ MainWindow::closeEvent(QCloseEvent* event)
     }
 
     writeSettings();
+    wordEngine->saveWordCaches();
+    if (Trace::isEnabled())
+        Trace::writeFile(Trace::getDefaultFilename());
     event->accept();
 }
 
@@ -1740,15 +2209,16 @@ MainWindow::importDawg(const QString& lexicon, const QString& file, bool
 //---------------------------------------------------------------------------
 //  importChecksums
 //
-//! Import words from a text file.
+//! Import lexicon checksums from a text file, one checksum per line.  See
+//! LexiconChecksumThread for the checksum formats.
 //
-//! @param filename the file to import words from
-//! @return the number of imported words
+//! @param filename the file to import checksums from
+//! @return the list of checksums
 //---------------------------------------------------------------------------
-QList<quint16>
+QStringList
 MainWindow::importChecksums(const QString& filename)
 {
-    QList<quint16> checksums;
+    QStringList checksums;
     QFile file (filename);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
         return checksums;
@@ -1756,8 +2226,9 @@ MainWindow::importChecksums(const QString& filename)
     char* buffer = new char[MAX_INPUT_LINE_LEN];
     while (file.readLine(buffer, MAX_INPUT_LINE_LEN) > 0) {
         QString line (buffer);
-        checksums.append(line.toUShort());
+        checksums.append(line.trimmed());
     }
+    delete[] buffer;
     return checksums;
 }
 
@@ -1994,10 +2465,12 @@ MainWindow::renameLexicon(const QString& oldName, const QString& newName)
 //! Import a lexicon.
 //
 //! @param lexicon the name of the lexicon
+//! @param graph if not null, the word graph of the lexicon, already read
+//! from its DAWG files, which the lexicon takes over or which is deleted
 //! @return true if successful, false otherwise
 //---------------------------------------------------------------------------
 bool
-MainWindow::importLexicon(const QString& lexicon)
+MainWindow::importLexicon(const QString& lexicon, WordGraph* graph)
 {
     QString importFile;
     QString reverseImportFile;
@@ -2016,8 +2489,10 @@ MainWindow::importLexicon(const QString& lexicon)
         }
     }
     else {
-        if (wordEngine->lexiconIsLoaded(lexicon))
+        if (wordEngine->lexiconIsLoaded(lexicon)) {
+            delete graph;
             return true;
+        }
 
         QMap<QString, QString> prefixMap;
         prefixMap[LEXICON_OWL] = "/North-American/OWL";
@@ -2043,22 +2518,19 @@ MainWindow::importLexicon(const QString& lexicon)
         }
     }
 
-    if (importFile.isEmpty())
+    if (importFile.isEmpty()) {
+        delete graph;
         return false;
+    }
+
+    pendingLexicons.removeAll(lexicon);
 
     QString splashMessage = "Loading " + lexicon + " lexicon...";
     setSplashMessage(splashMessage);
 
     if (dawg) {
-        quint16 expectedForwardChecksum = 0;
-        quint16 expectedReverseChecksum = 0;
-
-        QList<quint16> checksums = importChecksums(checksumFile);
-        if (checksums.size() >= 2) {
-            expectedForwardChecksum = checksums[0];
-            expectedReverseChecksum = checksums[1];
-        }
-        else {
+        QStringList checksums = importChecksums(checksumFile);
+        if (checksums.size() < 2) {
             QString message = "Cannot find checksum information for the '" +
                 lexicon + "' lexicon.  The lexicon will be loaded, but it is "
                 "possible the lexicon has been corrupted.";
@@ -2071,14 +2543,33 @@ MainWindow::importLexicon(const QString& lexicon)
 
         lexiconError = QString();
 
-        ok = ok && importDawg(lexicon, importFile, false, &lexiconError,
-                              &expectedForwardChecksum);
+        if (ok && graph) {
+            wordEngine->addGraph(lexicon, graph);
+            graph = 0;
+        }
+        else {
+            ok = ok && importDawg(lexicon, importFile, false, &lexiconError);
+            ok = ok && importDawg(lexicon, reverseImportFile, true,
+                                  &lexiconError);
+        }
 
-        ok = ok && importDawg(lexicon, reverseImportFile, true, &lexiconError,
-                              &expectedReverseChecksum);
+        // The lexicon can be used while its checksums are verified
+        if (ok) {
+            LexiconChecksumThread* thread =
+                new LexiconChecksumThread(lexicon, this);
+            thread->addFile(importFile, checksums[0]);
+            thread->addFile(reverseImportFile, checksums[1]);
+            connect(thread,
+                    SIGNAL(checksumMismatch(const QString&, const QString&)),
+                    SLOT(lexiconChecksumMismatch(const QString&,
+                                                 const QString&)));
+            connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+            thread->start(QThread::LowPriority);
+        }
     }
     else
         ok = importText(lexicon, importFile);
+    delete graph;
 
     importStems(lexicon);
 
@@ -37,10 +37,12 @@
 
 class AboutDialog;
 class ActionForm;
+class CreateDatabaseThread;
 class HelpDialog;
 class QuizSpec;
 class QuizEngine;
 class WordEngine;
+class WordGraph;
 class SettingsDialog;
 
 class MainWindow : public QMainWindow
@@ -52,14 +54,17 @@ class MainWindow : public QMainWindow
     ~MainWindow() { }
 
     static MainWindow* getInstance() { return instance; }
+    static void markStartupPhase(const QString& phase);
 
     public slots:
     void fileOpenRequested(const QString& filename);
     void processArguments(const QStringList& args);
+    void startupFinished();
     void tryUpdateUserDataDir();
     void tryAutoImport();
     void tryConnectToDatabases();
     void processDatabaseErrors();
+    void preloadLexicons();
     void importInteractive();
     void newQuizFormInteractive();
     void newQuizFormInteractive(const QuizSpec& quizSpec);
@@ -76,9 +81,13 @@ class MainWindow : public QMainWindow
     void viewVariation(int variation);
     void rebuildDatabaseRequested();
     void rescheduleCardboxRequested();
+    void mergeQuizStatsRequested();
+    void saveTraceRequested();
     void displayAbout();
     void displayHelp();
     void displayLexiconError();
+    void lexiconChecksumMismatch(const QString& lexicon, const QString&
+                                 filename);
     void helpDialogError(const QString& message);
     void closeCurrentTab();
     void currentTabChanged(int index);
@@ -92,13 +101,21 @@ class MainWindow : public QMainWindow
     public:
     QString getLexiconPrefix(const QString& lexicon);
     QString getDatabaseFilename(const QString& lexicon);
+    bool loadLexicon(const QString& lexicon);
+    bool requireLexicon(const QString& lexicon);
     int tryConnectToDatabase(const QString& lexicon);
     bool connectToDatabase(const QString& lexicon);
     // FIXME: these probably belong with WordTableView::addToCardbox in a
     // separate class for manipulating quiz databases.  Hm, how about the
     // QuizStatsDatabase class?
-    void rebuildDatabases(const QStringList& lexicons);
-    bool rebuildDatabase(const QString& lexicon);
+    void rebuildDatabases(const QStringList& lexicons, bool incremental =
+                          false);
+    bool rebuildDatabase(const QString& lexicon, bool incremental = false);
+    CreateDatabaseThread* startDatabaseRebuild(const QString& lexicon, bool
+                                               incremental);
+    bool finishDatabaseRebuild(const QString& lexicon, CreateDatabaseThread*
+                               thread);
+    QString getDatabaseBackupFilename(const QString& dbFilename) const;
     int rescheduleCardbox(const QStringList& words, const QString& lexicon,
         const QString& quizType, CardboxRescheduleType rescheduleType,
         int rescheduleValue = 0) const;
@@ -112,12 +129,12 @@ class MainWindow : public QMainWindow
     void updateSettings();
     void makeUserDirs();
     void renameLexicon(const QString& oldName, const QString& newName);
-    bool importLexicon(const QString& lexicon);
+    bool importLexicon(const QString& lexicon, WordGraph* graph = 0);
     int importText(const QString& lexicon, const QString& file);
     bool importDawg(const QString& lexicon, const QString& file,
                     bool reverse = false, QString* errString = 0,
                     quint16* expectedChecksum = 0);
-    QList<quint16> importChecksums(const QString& file);
+    QStringList importChecksums(const QString& file);
     int importStems(const QString& lexicon);
     void readSettings(bool useGeometry);
     void writeSettings();
@@ -125,6 +142,11 @@ class MainWindow : public QMainWindow
     void newQuizFromQuizFile(const QString& filename);
     void newQuizFromWordFile(const QString& filename);
 
+    private:
+    // Thread reading the word graph of a lexicon at startup - see
+    // tryAutoImport
+    class GraphLoadThread;
+
     private:
     enum LexiconDatabaseError {
         DbNoError = 0,
@@ -153,6 +175,14 @@ class MainWindow : public QMainWindow
     QString lexiconError;
     QMap<QString, int> dbErrors;
 
+    // Lexicons whose import was deferred by lazy importing
+    QStringList pendingLexicons;
+
+    // Whether to exit once started, and the longest startup in milliseconds
+    // allowed before exiting with an error, set on the command line
+    bool exitAfterStartup;
+    int startupBudget;
+
     static MainWindow*  instance;
 };
 
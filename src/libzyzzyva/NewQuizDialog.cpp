@@ -36,7 +36,6 @@
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QMessageBox>
-#include <QTextStream>
 #include <QVBoxLayout>
 
 const QString DIALOG_CAPTION = "New Quiz";
@@ -614,8 +613,7 @@ NewQuizDialog::saveQuiz()
         return;
     }
 
-    QTextStream stream (&file);
-    stream << getQuizSpec().asXml();
+    getQuizSpec().writeXmlFile(&file);
 }
 
 //---------------------------------------------------------------------------
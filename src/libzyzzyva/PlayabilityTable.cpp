@@ -0,0 +1,406 @@
+//---------------------------------------------------------------------------
+// PlayabilityTable.cpp
+//
+// A class for looking up the playability values of words.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "PlayabilityTable.h"
+#include "Auxil.h"
+#include "Defs.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QPair>
+#include <cstring>
+
+// A binary playability file holds, in native byte order, a header of four
+// 32-bit fields - the magic number, the format version, the number of
+// entries and the size of the word blob - followed by the 64-bit values of
+// the entries, the numEntries + 1 32-bit offsets of the words of the
+// entries in the word blob, and the word blob, holding the words in
+// Latin-1.
+const quint32 PLAYABILITY_MAGIC = 0x5a595042;
+const quint32 PLAYABILITY_VERSION = 1;
+const int HEADER_FIELDS = 4;
+const int HEADER_SIZE = HEADER_FIELDS * 4;
+
+using namespace Defs;
+
+typedef QPair<QByteArray, qint64> PlayabilityEntry;
+
+//---------------------------------------------------------------------------
+//  compareWords
+//
+//! Compare two words in the order of playability entries: by length, and
+//! then alphabetically.
+//
+//! @param a the first word
+//! @param aLen the length of the first word
+//! @param b the second word
+//! @param bLen the length of the second word
+//! @return less than zero if the first word comes first, greater than zero
+//! if the second word comes first, or zero if they are equal
+//---------------------------------------------------------------------------
+static int
+compareWords(const char* a, int aLen, const char* b, int bLen)
+{
+    if (aLen != bLen)
+        return aLen - bLen;
+    return memcmp(a, b, aLen);
+}
+
+//---------------------------------------------------------------------------
+//  entryLessThan
+//
+//! Determine whether one playability entry comes before another.
+//
+//! @param a the first entry
+//! @param b the second entry
+//! @return true if the first entry comes first
+//---------------------------------------------------------------------------
+static bool
+entryLessThan(const PlayabilityEntry& a, const PlayabilityEntry& b)
+{
+    return compareWords(a.first.constData(), a.first.size(),
+                        b.first.constData(), b.first.size()) < 0;
+}
+
+//---------------------------------------------------------------------------
+//  load
+//
+//! Load playability values, from a binary file saved from a text file if
+//! it is up to date, or else from the text file, saving the binary file
+//! for next time.
+//
+//! @param filename the name of the text file
+//! @param savedFilename the name of the binary file
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+PlayabilityTable::load(const QString& filename, const QString& savedFilename)
+{
+    QFileInfo textInfo (filename);
+    QFileInfo savedInfo (savedFilename);
+    bool saved = savedInfo.exists() && (!textInfo.exists() ||
+        (savedInfo.lastModified() >= textInfo.lastModified()));
+    if (saved && readBinaryFile(savedFilename))
+        return true;
+
+    if (!importTextFile(filename))
+        return false;
+
+    writeBinaryFile(savedFilename);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  importTextFile
+//
+//! Import playability values from a text file.  The file is assumed to be
+//! in plain text format, containing one playability value and word per
+//! line.  If a word appears more than once, its last value is used.
+//
+//! @param filename the name of the file to import
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+PlayabilityTable::importTextFile(const QString& filename)
+{
+    setData(QByteArray());
+
+    QFile file (filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    QList<PlayabilityEntry> entries;
+    char* buffer = new char[MAX_INPUT_LINE_LEN + 1];
+    bool readNewline = true;
+    while (file.readLine(buffer, MAX_INPUT_LINE_LEN) > 0) {
+        QString line (buffer);
+
+        // If first line didn't contain newline, skip subsequent reads
+        // until we see a newline (effectively truncating long lines)
+        bool skip = !readNewline;
+        readNewline = (line.right(1) == QString("\n"));
+        if (skip)
+            continue;
+
+        line = line.simplified();
+        if (line.isEmpty() || (line.at(0) == '#'))
+            continue;
+        bool ok = false;
+        qint64 playability = line.section(' ', 0, 0).toLongLong(&ok);
+        if (!ok)
+            continue;
+        QString word = line.section(' ', 1, 1);
+        if (word.isEmpty())
+            continue;
+
+        entries.append(PlayabilityEntry(word.toLatin1(), playability));
+    }
+    delete[] buffer;
+
+    // Sort the entries, keeping only the last of each word
+    qStableSort(entries.begin(), entries.end(), entryLessThan);
+    QList<PlayabilityEntry> uniqueEntries;
+    for (int i = 0; i < entries.size(); ++i) {
+        if ((i + 1 < entries.size()) &&
+            (entries[i + 1].first == entries[i].first))
+        {
+            continue;
+        }
+        uniqueEntries.append(entries[i]);
+    }
+
+    int n = uniqueEntries.size();
+    QByteArray entryWords;
+    QVector<qint64> entryValues (n);
+    QVector<quint32> entryOffsets (n + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        entryWords.append(uniqueEntries[i].first);
+        entryValues[i] = uniqueEntries[i].second;
+        entryOffsets[i + 1] = entryWords.size();
+    }
+
+    quint32 header[HEADER_FIELDS] = {
+        PLAYABILITY_MAGIC, PLAYABILITY_VERSION, quint32(n),
+        quint32(entryWords.size())
+    };
+
+    QByteArray bytes;
+    bytes.append(reinterpret_cast<const char*>(header), HEADER_SIZE);
+    bytes.append(reinterpret_cast<const char*>(entryValues.constData()),
+                 n * sizeof(qint64));
+    bytes.append(reinterpret_cast<const char*>(entryOffsets.constData()),
+                 (n + 1) * sizeof(quint32));
+    bytes.append(entryWords);
+    return setData(bytes);
+}
+
+//---------------------------------------------------------------------------
+//  readBinaryFile
+//
+//! Read playability values from a binary file, in one read.
+//
+//! @param filename the name of the file
+//! @return true if successful, false if the file cannot be read or is not
+//! a valid playability file
+//---------------------------------------------------------------------------
+bool
+PlayabilityTable::readBinaryFile(const QString& filename)
+{
+    QFile file (filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setData(QByteArray());
+        return false;
+    }
+
+    return setData(file.readAll());
+}
+
+//---------------------------------------------------------------------------
+//  writeBinaryFile
+//
+//! Write the playability values to a binary file.
+//
+//! @param filename the name of the file
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+PlayabilityTable::writeBinaryFile(const QString& filename) const
+{
+    QDir dir;
+    dir.mkpath(QFileInfo(filename).absolutePath());
+
+    QFile file (filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    if (file.write(data) != data.size()) {
+        file.close();
+        QFile::remove(filename);
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  getValues
+//
+//! Get the playability values of a list of words.  The entries are only
+//! searched for the first word and for any word that comes before the
+//! previous word, so the values of words in the order of the entries are
+//! found in one pass.
+//
+//! @param words the words
+//! @return the playability value of each word, or zero for words with no
+//! playability value
+//---------------------------------------------------------------------------
+QVector<qint64>
+PlayabilityTable::getValues(const QStringList& words) const
+{
+    QVector<qint64> result (words.size(), 0);
+    if (!numEntries)
+        return result;
+
+    int entry = 0;
+    QByteArray lastWord;
+    for (int i = 0; i < words.size(); ++i) {
+        QByteArray word = words[i].toLatin1();
+        bool inOrder = (i > 0) && (compareWords(lastWord.constData(),
+            lastWord.size(), word.constData(), word.size()) <= 0);
+
+        if (inOrder) {
+            while ((entry < numEntries) && (compareEntry(entry, word) < 0))
+                ++entry;
+        }
+        else {
+            entry = findEntry(word);
+        }
+
+        if ((entry < numEntries) && (compareEntry(entry, word) == 0))
+            result[i] = values[entry];
+        lastWord = word;
+    }
+
+    return result;
+}
+
+//---------------------------------------------------------------------------
+//  getSavedFilename
+//
+//! Determine the name of the binary file playability values read from a
+//! text file are saved to.
+//
+//! @param filename the name of the text file
+//! @return the name of the binary file
+//---------------------------------------------------------------------------
+QString
+PlayabilityTable::getSavedFilename(const QString& filename)
+{
+    QFileInfo info (filename);
+    return Auxil::getUserDir() + "/lexicons/" + info.fileName() + ".pbl";
+}
+
+//---------------------------------------------------------------------------
+//  setData
+//
+//! Use the contents of a binary playability file as the playability values.
+//
+//! @param bytes the contents of the file
+//! @return true if successful, false if the contents are not valid, in
+//! which case the table is left empty
+//---------------------------------------------------------------------------
+bool
+PlayabilityTable::setData(const QByteArray& bytes)
+{
+    data.clear();
+    numEntries = 0;
+    values.clear();
+    offsets.clear();
+    wordBlob = 0;
+
+    if (bytes.size() < HEADER_SIZE)
+        return false;
+
+    quint32 header[HEADER_FIELDS];
+    memcpy(header, bytes.constData(), HEADER_SIZE);
+    if ((header[0] != PLAYABILITY_MAGIC) ||
+        (header[1] != PLAYABILITY_VERSION))
+    {
+        return false;
+    }
+
+    quint64 n = header[2];
+    quint64 valuesSize = n * sizeof(qint64);
+    quint64 offsetsSize = (n + 1) * sizeof(quint32);
+    if (quint64(bytes.size()) != HEADER_SIZE + valuesSize + offsetsSize +
+        header[3])
+    {
+        return false;
+    }
+
+    // Copy the values and offsets, since the contents of a byte array are
+    // not guaranteed to be aligned for them
+    const char* start = bytes.constData() + HEADER_SIZE;
+    values.resize(n);
+    memcpy(values.data(), start, valuesSize);
+    offsets.resize(n + 1);
+    memcpy(offsets.data(), start + valuesSize, offsetsSize);
+    if ((offsets[0] != 0) || (offsets[n] != header[3])) {
+        values.clear();
+        offsets.clear();
+        return false;
+    }
+
+    data = bytes;
+    wordBlob = data.constData() + HEADER_SIZE + valuesSize + offsetsSize;
+    numEntries = int(n);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  compareEntry
+//
+//! Compare the word of an entry with a word.
+//
+//! @param entry the index of the entry
+//! @param word the word, in Latin-1
+//! @return less than zero if the entry comes before the word, greater than
+//! zero if it comes after the word, or zero if it is the word
+//---------------------------------------------------------------------------
+int
+PlayabilityTable::compareEntry(int entry, const QByteArray& word) const
+{
+    quint32 start = offsets[entry];
+    quint32 end = offsets[entry + 1];
+    if (end < start)
+        return -1;
+    return compareWords(wordBlob + start, end - start, word.constData(),
+                        word.size());
+}
+
+//---------------------------------------------------------------------------
+//  findEntry
+//
+//! Find the first entry that does not come before a word.
+//
+//! @param word the word, in Latin-1
+//! @return the index of the entry, or the number of entries if every entry
+//! comes before the word
+//---------------------------------------------------------------------------
+int
+PlayabilityTable::findEntry(const QByteArray& word) const
+{
+    int low = 0;
+    int high = numEntries;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (compareEntry(mid, word) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
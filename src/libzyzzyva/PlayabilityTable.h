@@ -0,0 +1,67 @@
+//---------------------------------------------------------------------------
+// PlayabilityTable.h
+//
+// A class for looking up the playability values of words.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_PLAYABILITY_TABLE_H
+#define ZYZZYVA_PLAYABILITY_TABLE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Playability values held in the layout of a binary playability file:
+// entries sorted by word length and then alphabetically, so the values of
+// the words of a lexicon, visited a length at a time in alphabetical
+// order, are found by merging the words with the entries in one pass.
+class PlayabilityTable
+{
+    public:
+    PlayabilityTable() : numEntries(0), wordBlob(0) { }
+    ~PlayabilityTable() { }
+
+    bool load(const QString& filename, const QString& savedFilename);
+    bool importTextFile(const QString& filename);
+    bool readBinaryFile(const QString& filename);
+    bool writeBinaryFile(const QString& filename) const;
+    int getNumEntries() const { return numEntries; }
+    QVector<qint64> getValues(const QStringList& words) const;
+
+    static QString getSavedFilename(const QString& filename);
+
+    private:
+    bool setData(const QByteArray& bytes);
+    int compareEntry(int entry, const QByteArray& word) const;
+    int findEntry(const QByteArray& word) const;
+
+    private:
+    // The contents of the binary file, with the value of each entry and the
+    // offset of the word of each entry in the word blob
+    QByteArray data;
+    int numEntries;
+    QVector<qint64> values;
+    QVector<quint32> offsets;
+    const char* wordBlob;
+};
+
+#endif // ZYZZYVA_PLAYABILITY_TABLE_H
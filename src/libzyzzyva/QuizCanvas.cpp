@@ -24,6 +24,7 @@
 
 #include "QuizCanvas.h"
 #include "MainSettings.h"
+#include "Trace.h"
 #include "Auxil.h"
 #include "Defs.h"
 #include <QtGui>
@@ -31,22 +32,6 @@
 using namespace Defs;
 
 const QString QUIZ_TILE_MIME_TYPE = "application/x-zyzzyva-quiz-tile";
-const QString LABEL_SHOW_STRING = "show";
-
-//---------------------------------------------------------------------------
-//  xLessThan
-//
-//! A comparison function that compares QLabels by X position.
-//
-//! @param a the first label to compare
-//! @param b the second label to compare
-//! @return true if a is to the left of b
-//---------------------------------------------------------------------------
-bool
-xLessThan(const QLabel* a, const QLabel* b)
-{
-    return (a->x() < b->x());
-}
 
 //---------------------------------------------------------------------------
 //  QuizCanvas
@@ -58,7 +43,7 @@ xLessThan(const QLabel* a, const QLabel* b)
 QuizCanvas::QuizCanvas(QWidget* parent)
     : QWidget(parent), numCanvasTiles(0), minCanvasTiles(7),
       minCanvasWidth(300), widthHint(minCanvasWidth), heightHint(100),
-      dragDropEnabled(true)
+      dragDropEnabled(true), dragIndex(-1), dragMoved(false)
 {
     setAcceptDrops(true);
     setAutoFillBackground(true);
@@ -88,15 +73,8 @@ QuizCanvas::setText(const QString& text)
     question = text;
     setNumCanvasTiles(question.length());
 
-    // Remove existing labels
-    QList<QLabel*> labels = findChildren<QLabel*>();
-    QListIterator<QLabel*> it (labels);
-    while (it.hasNext()) {
-        QLabel* label = it.next();
-        label->setObjectName(QString());
-        label->close();
-    }
-
+    tiles.clear();
+    dragIndex = -1;
     QMap<QString, QPixmap>::iterator pixmap;
     for (int i = 0; (i < numCanvasTiles) &&
                     (i < int(question.length())); ++i)
@@ -110,15 +88,11 @@ QuizCanvas::setText(const QString& text)
             //         "' in tiles map!");
         }
         else {
-            QLabel* label = new QLabel(this);
-            label->setObjectName(LABEL_SHOW_STRING);
-            label->setPixmap(*pixmap);
-            label->move(i, QUIZ_TILE_MARGIN);
-            label->setAttribute(Qt::WA_DeleteOnClose);
+            tiles.append(*pixmap);
         }
     }
 
-    squeezeTileImages();
+    update();
 }
 
 //---------------------------------------------------------------------------
@@ -286,9 +260,6 @@ QuizCanvas::dropEvent(QDropEvent* event)
         QPoint offset;
         dataStream >> pixmap >> sourcePos >> offset;
 
-        QLabel* label = new QLabel(this);
-        label->setObjectName(LABEL_SHOW_STRING);
-        label->setPixmap(pixmap);
         QPoint dropPos = event->pos() - offset;
 
         // Move the tile an extra half tile width in the direction of the
@@ -296,9 +267,24 @@ QuizCanvas::dropEvent(QDropEvent* event)
         // more than halfway onto the spot.
         int extraMove = (sourcePos.x() < dropPos.x() ? maxTileWidth / 2
                                                      : -maxTileWidth / 2);
-        dropPos.setX(dropPos.x() + extraMove);
-        label->move(dropPos);
-        label->setAttribute(Qt::WA_DeleteOnClose);
+        int dropX = dropPos.x() + extraMove;
+
+        // Place the tile after the other tiles to the left of the drop
+        // position
+        bool moving = (event->source() == this) && (dragIndex >= 0);
+        int index = 0;
+        for (int i = 0; i < tiles.size(); ++i) {
+            if ((!moving || (i != dragIndex)) && (getTileX(i) < dropX))
+                ++index;
+        }
+
+        if (moving) {
+            tiles.removeAt(dragIndex);
+            dragIndex = -1;
+            dragMoved = true;
+        }
+        tiles.insert(index, pixmap);
+        update();
 
         if (event->source() == this) {
             event->setDropAction(Qt::MoveAction);
@@ -325,16 +311,17 @@ QuizCanvas::mousePressEvent(QMouseEvent* event)
     if (!dragDropEnabled)
         return;
 
-    QLabel* child = static_cast<QLabel*>(childAt(event->pos()));
-    if (!child)
+    int index = getTileAt(event->pos());
+    if (index < 0)
         return;
 
-    QPixmap pixmap = *(child->pixmap());
+    QPixmap pixmap = tiles[index];
+    QPoint tilePos (getTileX(index), QUIZ_TILE_MARGIN);
 
     QByteArray itemData;
     QDataStream dataStream (&itemData, QIODevice::WriteOnly);
     dataStream << pixmap << QPoint(event->pos())
-               << QPoint(event->pos() - child->pos());
+               << QPoint(event->pos() - tilePos);
 
     QMimeData* mimeData = new QMimeData;
     mimeData->setData(QUIZ_TILE_MIME_TYPE, itemData);
@@ -342,55 +329,83 @@ QuizCanvas::mousePressEvent(QMouseEvent* event)
     QDrag* drag = new QDrag(this);
     drag->setMimeData(mimeData);
     drag->setPixmap(pixmap);
-    drag->setHotSpot(event->pos() - child->pos());
-
-    QColor bgColor = palette().color(QPalette::Window);
+    drag->setHotSpot(event->pos() - tilePos);
 
-    QPixmap tempPixmap = pixmap;
-    QPainter painter;
-    painter.begin(&tempPixmap);
-    painter.fillRect(pixmap.rect(), QColor(bgColor.red(), bgColor.green(),
-                                           bgColor.blue(), 127));
-    painter.end();
+    // The tile being dragged is drawn faded until the drag is over
+    dragIndex = index;
+    dragMoved = false;
+    update();
 
-    child->setPixmap(tempPixmap);
-
-    if (drag->start(Qt::CopyAction | Qt::MoveAction) == Qt::MoveAction) {
-        child->setObjectName(QString());
-        child->close();
-    }
-    else {
-        child->show();
-        child->setPixmap(pixmap);
+    if ((drag->start(Qt::CopyAction | Qt::MoveAction) == Qt::MoveAction) &&
+        !dragMoved && (dragIndex >= 0))
+    {
+        tiles.removeAt(dragIndex);
     }
 
-    squeezeTileImages();
+    dragIndex = -1;
+    update();
 }
 
 //---------------------------------------------------------------------------
-//  squeezeTileImages
+//  paintEvent
 //
-//! Squeeze and center tile images without reordering them.
+//! The event handler that receives paint events.  Draw every tile in one
+//! pass.
+//
+//! @param event the paint event
 //---------------------------------------------------------------------------
 void
-QuizCanvas::squeezeTileImages()
+QuizCanvas::paintEvent(QPaintEvent*)
 {
-    QList<QLabel*> labels = findChildren<QLabel*>(LABEL_SHOW_STRING);
-    qSort(labels.begin(), labels.end(), xLessThan);
+    Z_TRACE_SCOPE("QuizCanvas::paintEvent");
+    if (tiles.isEmpty())
+        return;
 
-    int x = QUIZ_TILE_MARGIN + ((numCanvasTiles - labels.size()) *
+    QColor bgColor = palette().color(QPalette::Window);
+    QColor fadeColor (bgColor.red(), bgColor.green(), bgColor.blue(), 127);
+
+    QPainter painter (this);
+    for (int i = 0; i < tiles.size(); ++i) {
+        const QPixmap& pixmap = tiles[i];
+        QRect rect (QPoint(getTileX(i), QUIZ_TILE_MARGIN), pixmap.size());
+        painter.drawPixmap(rect.topLeft(), pixmap);
+        if (i == dragIndex)
+            painter.fillRect(rect, fadeColor);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  getTileX
+//
+//! Determine the X position of a tile, with the tiles squeezed together and
+//! centered on the canvas.
+//
+//! @param index the index of the tile
+//! @return the X position
+//---------------------------------------------------------------------------
+int
+QuizCanvas::getTileX(int index) const
+{
+    int x = QUIZ_TILE_MARGIN + ((numCanvasTiles - tiles.size()) *
             (maxTileWidth + QUIZ_TILE_SPACING)) / 2;
+    return x + index * (maxTileWidth + QUIZ_TILE_SPACING);
+}
 
-    // Move the tiles
-    QListIterator<QLabel*> it (labels);
-    while (it.hasNext()) {
-        QLabel* label = it.next();
-        label->move(x, QUIZ_TILE_MARGIN);
-        x += maxTileWidth + QUIZ_TILE_SPACING;
+//---------------------------------------------------------------------------
+//  getTileAt
+//
+//! Find the tile at a position on the canvas.
+//
+//! @param pos the position
+//! @return the index of the tile, or -1 if there is no tile at the position
+//---------------------------------------------------------------------------
+int
+QuizCanvas::getTileAt(const QPoint& pos) const
+{
+    for (int i = 0; i < tiles.size(); ++i) {
+        QRect rect (QPoint(getTileX(i), QUIZ_TILE_MARGIN), tiles[i].size());
+        if (rect.contains(pos))
+            return i;
     }
-
-    // Show the tiles
-    it.toFront();
-    while (it.hasNext())
-        it.next()->show();
+    return -1;
 }
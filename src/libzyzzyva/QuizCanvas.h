@@ -26,7 +26,7 @@
 #define ZYZZYVA_QUIZ_CANVAS_H
 
 #include <QBrush>
-#include <QLabel>
+#include <QList>
 #include <QMap>
 #include <QPen>
 #include <QPixmap>
@@ -54,17 +54,22 @@ class QuizCanvas : public QWidget
     void dragEnterEvent(QDragEnterEvent* event);
     void dropEvent(QDropEvent* event);
     void mousePressEvent(QMouseEvent* event);
+    void paintEvent(QPaintEvent* event);
 
-    private slots:
-    void squeezeTileImages();
+    private:
+    int getTileX(int index) const;
+    int getTileAt(const QPoint& pos) const;
 
     private:
     QMap<QString, QPixmap> tileImages;
+    QList<QPixmap> tiles;
     QString question;
     int maxTileWidth, maxTileHeight;
     int numCanvasTiles, minCanvasTiles, minCanvasWidth;
     int widthHint, heightHint;
     bool dragDropEnabled;
+    int dragIndex;
+    bool dragMoved;
 };
 
 #endif // ZYZZYVA_QUIZ_CANVAS_H
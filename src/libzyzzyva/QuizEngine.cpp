@@ -24,13 +24,25 @@
 //---------------------------------------------------------------------------
 
 #include "QuizEngine.h"
+#include "JobScheduler.h"
 #include "LetterBag.h"
+#include "LetterSignature.h"
 #include "MainSettings.h"
 #include "QuizStatsDatabase.h"
+#include "RackSampler.h"
+#include "Shuffle.h"
+#include "Trace.h"
 #include "WordEngine.h"
+#include "WordGraph.h"
 #include "Auxil.h"
+#include <QSet>
+#include <QThread>
+#include <QWaitCondition>
 #include <cstdlib>
 
+// Number of upcoming questions whose answers are found in the background
+const int PREFETCH_QUESTIONS = 5;
+
 //---------------------------------------------------------------------------
 //  probabilityCmp
 //
@@ -51,6 +63,221 @@ probabilityCmp(const QPair<QString, double>& a, const QPair<QString, double>& b)
         return (a.first < b.first);
 }
 
+//---------------------------------------------------------------------------
+//  OrderKey
+//
+//! The sort key of a quiz question when ordering questions by a stored
+//! playability or probability order.  Questions with lower orders come
+//! first, and questions of equal order are sorted alphabetically.
+//---------------------------------------------------------------------------
+class OrderKey
+{
+    public:
+    OrderKey(int o = 0, const QString& q = QString())
+        : order(o), question(q) { }
+
+    bool operator<(const OrderKey& other) const {
+        if (order != other.order)
+            return order < other.order;
+        return question < other.question;
+    }
+
+    int order;
+    QString question;
+};
+
+//---------------------------------------------------------------------------
+//  AlphagramVisitor
+//
+//! A word visitor that groups the words it visits by alphagram.
+//---------------------------------------------------------------------------
+class AlphagramVisitor : public WordVisitor
+{
+    public:
+    AlphagramVisitor() { }
+    bool visitWord(const QString& word) {
+        alphaWords[Auxil::getAlphagram(word)].append(word);
+        return true;
+    }
+
+    // Return the alphagrams in the same order as WordEngine::alphagrams
+    QStringList getAlphagrams() const {
+        QStringList alphaList = alphaWords.keys();
+        qSort(alphaList.begin(), alphaList.end(),
+              Auxil::localeAwareLessThanQString);
+        return alphaList;
+    }
+
+    // Return the words visited, keyed by alphagram
+    const QHash<QString, QStringList>& getAlphagramWords() const {
+        return alphaWords;
+    }
+
+    private:
+    QHash<QString, QStringList> alphaWords;
+};
+
+//---------------------------------------------------------------------------
+//  PrefetchThread
+//
+//! A thread that finds the answers to upcoming quiz questions and adds
+//! them to the word cache, so they are ready when the questions are asked.
+//! The thread waits for questions until it is stopped, so it keeps using
+//! the same database connection.
+//---------------------------------------------------------------------------
+class QuizEngine::PrefetchThread : public QThread
+{
+    public:
+    PrefetchThread(QuizEngine* e)
+        : QThread(), engine(e), busy(false), stopping(false) { }
+    ~PrefetchThread() { }
+
+    void setQuestions(const QuizSpec& s, const QStringList& q) {
+        QMutexLocker locker (&mutex);
+        spec = s;
+        questions = q;
+        changed.wakeAll();
+    }
+
+    // Drop the remaining questions, and wait until the answers to the
+    // question being prefetched have been found
+    void cancel() {
+        QMutexLocker locker (&mutex);
+        questions.clear();
+        while (busy)
+            idle.wait(&mutex);
+    }
+
+    void stop() {
+        QMutexLocker locker (&mutex);
+        stopping = true;
+        questions.clear();
+        changed.wakeAll();
+    }
+
+    protected:
+    void run() {
+        QMutexLocker locker (&mutex);
+        while (!stopping) {
+            if (questions.isEmpty()) {
+                changed.wait(&mutex);
+                continue;
+            }
+
+            QString question = questions.takeFirst();
+            QuizSpec questionSpec = spec;
+            busy = true;
+            locker.unlock();
+
+            if (!engine->hasPrefetchedAnswers(question)) {
+                QStringList answers =
+                    engine->getAnswers(questionSpec, question);
+                engine->wordEngine->addToCache(questionSpec.getLexicon(),
+                                               answers);
+                engine->addPrefetchedAnswers(question, answers);
+            }
+
+            locker.relock();
+            busy = false;
+            idle.wakeAll();
+        }
+    }
+
+    private:
+    QuizEngine* engine;
+    QuizSpec spec;
+    QStringList questions;
+    bool busy;
+    bool stopping;
+    QMutex mutex;
+    QWaitCondition changed;
+    QWaitCondition idle;
+};
+
+//---------------------------------------------------------------------------
+//  HookMaskJob
+//
+//! A job that finds the hooks of the answers to a quiz with one pass
+//! through the word graph for each answer, so the hooks are ready as the
+//! questions are asked.  The answers are taken in the order of their
+//! questions, and the masks of each question's answers can be read as soon
+//! as they are found.
+//---------------------------------------------------------------------------
+class QuizEngine::HookMaskJob : public Job
+{
+    public:
+    HookMaskJob(const WordEngine::Lexicon& l, const QList<QStringList>& a)
+        : Job(), lexicon(l), answers(a) { }
+    ~HookMaskJob() { }
+
+    bool getMasks(const QString& word, quint32* frontHooks, quint32*
+                  backHooks) const {
+        QMutexLocker locker (&mutex);
+        QHash<QString, QPair<quint32, quint32> >::const_iterator it =
+            masks.find(word);
+        if (it == masks.end())
+            return false;
+        *frontHooks = it.value().first;
+        *backHooks = it.value().second;
+        return true;
+    }
+
+    protected:
+    void run() {
+        Z_TRACE_SCOPE("QuizEngine::HookMaskJob");
+        foreach (const QStringList& words, answers) {
+            if (isCancelled())
+                return;
+
+            QList<QPair<quint32, quint32> > wordMasks;
+            foreach (const QString& word, words) {
+                quint32 frontHooks = 0;
+                quint32 backHooks = 0;
+                lexicon.getHooks(word, &frontHooks, &backHooks);
+                wordMasks.append(qMakePair(frontHooks, backHooks));
+            }
+
+            QMutexLocker locker (&mutex);
+            for (int i = 0; i < words.size(); ++i)
+                masks.insert(words[i], wordMasks[i]);
+        }
+    }
+
+    private:
+    WordEngine::Lexicon lexicon;
+    QList<QStringList> answers;
+    QHash<QString, QPair<quint32, quint32> > masks;
+    mutable QMutex mutex;
+};
+
+//---------------------------------------------------------------------------
+//  getHookMask
+//
+//! Find the mask of the hook letters of a response.  The mask of a response
+//! that repeats a letter has WordGraph::INCOMPLETE_HOOKS set, so it matches
+//! no answer whose hooks are all known.
+//
+//! @param letters the hook letters of the response
+//! @param mask returns the mask of letters, with bit 0 standing for A
+//! @return true if the letters are all A to Z, false otherwise
+//---------------------------------------------------------------------------
+static bool
+getHookMask(const QString& letters, quint32* mask)
+{
+    *mask = 0;
+    int length = letters.length();
+    for (int i = 0; i < length; ++i) {
+        ushort letter = letters.at(i).unicode();
+        if ((letter < 'A') || (letter > 'Z'))
+            return false;
+        quint32 bit = (1 << (letter - 'A'));
+        if (*mask & bit)
+            *mask |= WordGraph::INCOMPLETE_HOOKS;
+        *mask |= bit;
+    }
+    return true;
+}
+
 //---------------------------------------------------------------------------
 //  QuizEngine
 //
@@ -58,8 +285,23 @@ probabilityCmp(const QPair<QString, double>& a, const QPair<QString, double>& b)
 //---------------------------------------------------------------------------
 QuizEngine::QuizEngine(WordEngine* e)
     : wordEngine(e), quizTotal(0), quizCorrect(0), quizIncorrect(0),
-    questionIndex(0)
+    questionIndex(0), prefetchThread(0)
+{
+}
+
+//---------------------------------------------------------------------------
+//  ~QuizEngine
+//
+//! Destructor.
+//---------------------------------------------------------------------------
+QuizEngine::~QuizEngine()
 {
+    stopHookMaskJob();
+    if (prefetchThread) {
+        prefetchThread->stop();
+        prefetchThread->wait();
+        delete prefetchThread;
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -73,16 +315,34 @@ QuizEngine::QuizEngine(WordEngine* e)
 bool
 QuizEngine::newQuiz(const QuizSpec& spec)
 {
+    stopPrefetch();
+    stopHookMaskJob();
+    prefetchedAnswers.clear();
+    quizAnswers.clear();
+
+    // A random sample of search results is seeded once, so the quiz finds
+    // the same sample whenever it searches, and again when it is reloaded
+    SearchSpec searchSpec = spec.getSearchSpec();
+    if ((searchSpec.sampleSize > 0) && !searchSpec.sampleSeed) {
+        searchSpec.sampleSeed = QDateTime::currentDateTime().toTime_t();
+        QuizSpec seededSpec = spec;
+        seededSpec.setSearchSpec(searchSpec);
+        return newQuiz(seededSpec);
+    }
+
     QStringList questions;
     QString lexicon = spec.getLexicon();
 
     if (spec.getQuizSourceType() == QuizSpec::RandomLettersSource) {
-        LetterBag bag;
+        RackSampler sampler;
 
         // FIXME: get rid of all this hard-coded junk!
 
-        for (int i = 0; i < 1000; ++i) {
-            QString question = Auxil::getAlphagram(bag.lookRandomLetters(7));
+        QVector<LetterSignature> racks;
+        sampler.drawRacks(1000, 7, &racks);
+        foreach (const LetterSignature& rack, racks) {
+            QString question = rack.getLetters();
+            question.replace(QChar('?'), LetterBag::BLANK_CHAR);
             quizQuestions.append(question);
         }
 
@@ -98,7 +358,13 @@ QuizEngine::newQuiz(const QuizSpec& spec)
         }
         bool zeroFirst = (spec.getQuestionOrder() ==
                           QuizSpec::ScheduleZeroFirstOrder);
-        quizQuestions = db->getReadyQuestions(QStringList(), zeroFirst);
+        if (spec.getMethod() == QuizSpec::CardboxQuizMethod) {
+            scheduler.load(db, QStringList(), zeroFirst);
+            quizQuestions = getFirstReadyQuestion();
+        }
+        else {
+            quizQuestions = db->getReadyQuestions(QStringList(), zeroFirst);
+        }
         delete db;
         if (quizQuestions.isEmpty())
             return false;
@@ -110,13 +376,32 @@ QuizEngine::newQuiz(const QuizSpec& spec)
         // Their alphagrams are used as quiz questions, and their anagrams are
         // used as quiz answers.
         QStringList questionWords;
+        QHash<QString, QStringList> alphagramWords;
         QuizSpec::QuizType quizType = spec.getType();
-        if ((quizType == QuizSpec::QuizAnagrams) ||
-            (quizType == QuizSpec::QuizAnagramsWithHooks))
+        if (((quizType == QuizSpec::QuizAnagrams) ||
+             (quizType == QuizSpec::QuizAnagramsWithHooks)) &&
+            (spec.getQuestionOrder() != QuizSpec::PlayabilityOrder))
+        {
+            // Only the alphagrams are needed, so collect them as the words
+            // are found instead of building the list of words
+            AlphagramVisitor visitor;
+            wordEngine->search(lexicon, spec.getSearchSpec(), true, &visitor);
+            questions = visitor.getAlphagrams();
+            alphagramWords = visitor.getAlphagramWords();
+            setAnagramAnswers(lexicon, alphagramWords);
+        }
+
+        else if ((quizType == QuizSpec::QuizAnagrams) ||
+                 (quizType == QuizSpec::QuizAnagramsWithHooks))
         {
             questionWords =
                 wordEngine->search(lexicon, spec.getSearchSpec(), true);
-            questions = wordEngine->alphagrams(questionWords);
+            AlphagramVisitor visitor;
+            foreach (const QString& word, questionWords)
+                visitor.visitWord(word);
+            questions = visitor.getAlphagrams();
+            alphagramWords = visitor.getAlphagramWords();
+            setAnagramAnswers(lexicon, alphagramWords);
         }
 
         else if (quizType == QuizSpec::QuizHooks) {
@@ -152,31 +437,25 @@ QuizEngine::newQuiz(const QuizSpec& spec)
                 quizSpec.setRandomSeed(seed);
                 quizSpec.setRandomSeed2(seed2);
 
-                // XXX: We need a Shuffle class to handle shuffling using various
-                // algorithms!
-                QString tmp;
-                int num = quizQuestions.size();
-                for (int i = 0; i < num - 1; ++i) {
-                    unsigned int randnum = rng.rand(num - i - 1);
-                    int rnum = i + randnum;
-                    if (rnum == i)
-                        continue;
-                    tmp = quizQuestions[rnum];
-                    quizQuestions[rnum] = quizQuestions[i];
-                    quizQuestions[i] = tmp;
-                }
+                Shuffle shuffle (&rng);
+                shuffle.shuffle(quizQuestions);
             }
             break;
 
             case QuizSpec::ProbabilityOrder: {
-                LetterBag letterBag;
-                QList<QPair<QString, double> > questionPairs;
-
                 int probNumBlanks = quizSpec.getProbabilityNumBlanks();
-                foreach (const QString& question, quizQuestions) {
-                    double combos =
-                        letterBag.getNumCombinations(question, probNumBlanks);
-                    questionPairs.append(qMakePair(question, combos));
+                if (sortByStoredOrder(lexicon, alphagramWords, true,
+                                      probNumBlanks))
+                {
+                    break;
+                }
+
+                QList<QPair<QString, double> > questionPairs;
+                QVector<double> combos = wordEngine->getNumCombinations(
+                    lexicon, quizQuestions, probNumBlanks);
+                for (int i = 0; i < quizQuestions.size(); ++i) {
+                    questionPairs.append(qMakePair(quizQuestions[i],
+                                                   combos[i]));
                 }
 
                 qSort(questionPairs.begin(), questionPairs.end(),
@@ -192,6 +471,9 @@ QuizEngine::newQuiz(const QuizSpec& spec)
             break;
 
             case QuizSpec::PlayabilityOrder: {
+                if (sortByStoredOrder(lexicon, alphagramWords, false, 0))
+                    break;
+
                 wordEngine->addToCache(lexicon, questionWords);
 
                 // Order alphagram quiz questions by the best playability
@@ -247,7 +529,14 @@ QuizEngine::newQuiz(const QuizSpec& spec)
 
                 bool zeroFirst = (quizSpec.getQuestionOrder() ==
                                   QuizSpec::ScheduleZeroFirstOrder);
-                quizQuestions = db->getReadyQuestions(quizQuestions, zeroFirst);
+                if (spec.getMethod() == QuizSpec::CardboxQuizMethod) {
+                    scheduler.load(db, quizQuestions, zeroFirst);
+                    quizQuestions = getFirstReadyQuestion();
+                }
+                else {
+                    quizQuestions = db->getReadyQuestions(quizQuestions,
+                                                          zeroFirst);
+                }
                 delete db;
 
                 if (quizQuestions.isEmpty())
@@ -269,16 +558,86 @@ QuizEngine::newQuiz(const QuizSpec& spec)
     quizIncorrect = progress.getNumIncorrect();
     quizTotal = quizCorrect + progress.getNumMissed();
 
+    startHookMaskJob();
     prepareQuestion();
 
     // Add correct user responses from saved quiz state, and adjust the total
     // number of quiz answers by subtracting that number of responses.  This
     // is necessary because we used the quizCorrect total (including these
     // correct responses) as a base for the quizTotal calculation earlier.
-    correctUserResponses = progress.getQuestionCorrect();
-    if (!correctUserResponses.empty())
-        quizTotal -= correctUserResponses.size();
+    QSet<QString> questionCorrect = progress.getQuestionCorrect();
+    foreach (const QString& word, questionCorrect)
+        answerTracker.markAnswered(word);
+    quizTotal -= questionCorrect.size();
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  sortByStoredOrder
+//
+//! Sort the quiz questions by the playability or probability orders stored
+//! in the lexicon database.  The stored orders rank the words of each
+//! length, and words of equal value share a minimum order, so sorting by
+//! the minimum order of the words of each question and then alphabetically
+//! gives the same order as sorting by value.  Questions are only sorted if
+//! they are all of the same length and every word has a stored order.
+//
+//! @param lexicon the name of the lexicon
+//! @param alphagramWords the words of each alphagram question, or empty if
+//! the questions are words
+//! @param probability whether to sort by probability instead of
+//! playability
+//! @param numBlanks the number of blanks to consider for probability
+//! @return true if the questions were sorted, false otherwise
+//---------------------------------------------------------------------------
+bool
+QuizEngine::sortByStoredOrder(const QString& lexicon, const QHash<QString,
+                              QStringList>& alphagramWords, bool
+                              probability, int numBlanks)
+{
+    if (quizQuestions.isEmpty())
+        return true;
+
+    int length = quizQuestions.first().length();
+    QStringList words;
+    QVector<int> questionStarts;
+    foreach (const QString& question, quizQuestions) {
+        if (question.length() != length)
+            return false;
+        questionStarts.append(words.size());
+        if (alphagramWords.isEmpty())
+            words.append(question);
+        else
+            words += alphagramWords.value(question);
+    }
+    questionStarts.append(words.size());
+
+    QVector<int> orders = probability ?
+        wordEngine->getMinProbabilityOrders(lexicon, words, numBlanks) :
+        wordEngine->getMinPlayabilityOrders(lexicon, words);
+
+    // The best order of any word of a question is the order of the question
+    int numQuestions = quizQuestions.size();
+    QVector<OrderKey> keys (numQuestions);
+    for (int i = 0; i < numQuestions; ++i) {
+        int start = questionStarts[i];
+        int end = questionStarts[i + 1];
+        if (start == end)
+            return false;
+        int bestOrder = 0;
+        for (int j = start; j < end; ++j) {
+            if (!orders[j])
+                return false;
+            if (!bestOrder || (orders[j] < bestOrder))
+                bestOrder = orders[j];
+        }
+        keys[i] = OrderKey(bestOrder, quizQuestions[i]);
+    }
 
+    qSort(keys);
+    for (int i = 0; i < numQuestions; ++i)
+        quizQuestions[i] = keys[i].question;
     return true;
 }
 
@@ -292,17 +651,17 @@ QuizEngine::newQuiz(const QuizSpec& spec)
 bool
 QuizEngine::nextQuestion()
 {
-    // FIXME: For now, start a new quiz every time the user advances to the
-    // next question during a cardbox quiz.  This works, but can be very slow
-    // when the user has limited the quiz with a search specification.  Do
-    // something smarter here!
-    //if (quizSpec.getMethod() == QuizSpec::CardboxQuizMethod) {
-    //    return newQuiz(quizSpec);
-    //}
-
     if (onLastQuestion())
         return false;
 
+    // Cardbox quizzes ask the next question ready for review in the
+    // schedule kept by the scheduler, which also picks up questions that
+    // have become ready since the quiz started
+    if (quizSpec.getMethod() == QuizSpec::CardboxQuizMethod) {
+        unsigned int now = QDateTime::currentDateTime().toTime_t();
+        quizQuestions.append(scheduler.getNextReady(now, getQuestion()));
+    }
+
     ++questionIndex;
 
     // Update progress
@@ -352,6 +711,9 @@ QuizEngine::completeQuestion()
 QuizEngine::ResponseStatus
 QuizEngine::respond(const QString& response, bool lexiconSymbols)
 {
+    static const QRegExp symbolRe ("[\\W_\\d]+");
+    static const QRegExp wordRe ("(?:([^\\W_\\d]+)([\\W_\\d]*))");
+
     QString word (response);
     bool ok = true;
 
@@ -366,51 +728,79 @@ QuizEngine::respond(const QString& response, bool lexiconSymbols)
         QString frontHooks = sections.at(0);
         word = sections.at(1);
         QString baseWord = word;
-        baseWord.replace(QRegExp("[\\W_\\d]+"), QString());
+        baseWord.replace(symbolRe, QString());
         QString backHooks = sections.at(2);
 
-        QString lexicon = quizSpec.getLexicon();
-        QString frontAnswers =
-            wordEngine->getFrontHookLetters(lexicon, baseWord).toUpper();
-        QString backAnswers =
-            wordEngine->getBackHookLetters(lexicon, baseWord).toUpper();
+        int id = answerTracker.getId(baseWord);
+        if (id < 0) {
+            addQuestionIncorrect(response);
+            return Incorrect;
+        }
+        AnswerInfo& info = answerInfo[id];
+        quint32 frontMask = 0;
+        quint32 backMask = 0;
 
         if (lexiconSymbols) {
-            QMap<QChar, QString> frontAnsMap = parseHookSymbols(frontAnswers);
-            QMap<QChar, QString> backAnsMap = parseHookSymbols(backAnswers);
+            setHookLetters(baseWord, &info);
             QMap<QChar, QString> frontMap = parseHookSymbols(frontHooks);
             QMap<QChar, QString> backMap = parseHookSymbols(backHooks);
-            ok = ((frontMap == frontAnsMap) && (backMap == backAnsMap));
+            ok = ((frontMap == info.frontHookSymbols) &&
+                  (backMap == info.backHookSymbols));
+        }
+        else if (!((info.frontHookMask | info.backHookMask) &
+                   WordGraph::INCOMPLETE_HOOKS) &&
+                 getHookMask(frontHooks, &frontMask) &&
+                 getHookMask(backHooks, &backMask))
+        {
+            // Compare hook letters as masks if every hook is a letter from
+            // A to Z
+            ok = ((frontMask == info.frontHookMask) &&
+                  (backMask == info.backHookMask));
         }
         else {
-            frontHooks = Auxil::getAlphagram(frontHooks);
-            backHooks = Auxil::getAlphagram(backHooks);
-            frontAnswers.replace(QRegExp("[\\W_\\d]+"), QString());
-            backAnswers.replace(QRegExp("[\\W_\\d]+"), QString());
-            ok = ((frontHooks == frontAnswers) && (backHooks == backAnswers));
+            setHookLetters(baseWord, &info);
+            const QString& frontAnswers = info.frontHooks;
+            const QString& backAnswers = info.backHooks;
+
+            // Compare hook letters as multisets if they are plain letters
+            LetterSignature frontLetters (frontHooks);
+            LetterSignature backLetters (backHooks);
+            LetterSignature frontAnswerLetters (frontAnswers);
+            LetterSignature backAnswerLetters (backAnswers);
+            if (frontLetters.isValid() && backLetters.isValid() &&
+                frontAnswerLetters.isValid() && backAnswerLetters.isValid())
+            {
+                ok = ((frontLetters == frontAnswerLetters) &&
+                      (backLetters == backAnswerLetters));
+            }
+            else {
+                frontHooks = Auxil::getAlphagram(frontHooks);
+                backHooks = Auxil::getAlphagram(backHooks);
+                ok = ((frontHooks == frontAnswers) &&
+                      (backHooks == backAnswers));
+            }
         }
     }
 
     // Check lexicon symbols
     if (ok && lexiconSymbols) {
-        QRegExp re ("(?:([^\\W_\\d]+)([\\W_\\d]*))");
         QString symbols;
-        if (re.indexIn(word) >= 0) {
-            word = re.cap(1);
-            symbols = Auxil::getAlphagram(re.cap(2));
+        if (wordRe.indexIn(word) >= 0) {
+            word = wordRe.cap(1);
+            symbols = Auxil::getAlphagram(wordRe.cap(2));
         }
-        QString symbolAnswers = Auxil::getAlphagram(
-            wordEngine->getLexiconSymbols(quizSpec.getLexicon(), word));
-        ok = (symbols == symbolAnswers);
+        int id = answerTracker.getId(word);
+        ok = (id >= 0) && (symbols == answerInfo[id].symbols);
     }
 
     // Check the word itself
-    if (!ok || !correctResponses.contains(word)) {
+    int id = answerTracker.getId(word);
+    if (!ok || (id < 0)) {
         addQuestionIncorrect(response);
         return Incorrect;
     }
 
-    if (correctUserResponses.contains(word))
+    if (answerTracker.isAnswered(id))
         return Duplicate;
 
     addQuestionCorrect(word);
@@ -440,7 +830,7 @@ QuizEngine::markQuestionAsCorrect()
     QStringListIterator jt (missed);
     while (jt.hasNext()) {
         QString word = jt.next();
-        correctUserResponses.insert(word);
+        answerTracker.markAnswered(word);
         progress.addQuestionCorrect(word);
         if (progress.getQuestionComplete()) {
             progress.removeMissed(word);
@@ -459,10 +849,10 @@ void
 QuizEngine::markQuestionAsMissed()
 {
     // Remove any correct answers the user may have already had
-    int numCorrect = correctUserResponses.count();
+    int numCorrect = answerTracker.getNumAnswered();
     quizCorrect -= numCorrect;
 
-    correctUserResponses.clear();
+    answerTracker.clearAnswered();
 
     QuizProgress progress = quizSpec.getProgress();
     progress.clearQuestionCorrect();
@@ -494,14 +884,7 @@ QuizEngine::getQuestion() const
 QStringList
 QuizEngine::getMissed() const
 {
-    QStringList missedWords;
-    QSetIterator<QString> it (correctResponses);
-    while (it.hasNext()) {
-        QString word = it.next();
-        if (!correctUserResponses.contains(word))
-            missedWords.append(word);
-    }
-    return missedWords;
+    return answerTracker.getMissed();
 }
 
 //---------------------------------------------------------------------------
@@ -514,9 +897,72 @@ QuizEngine::getMissed() const
 bool
 QuizEngine::onLastQuestion() const
 {
+    if (quizSpec.getMethod() == QuizSpec::CardboxQuizMethod) {
+        unsigned int now = QDateTime::currentDateTime().toTime_t();
+        return scheduler.getNextReady(now, getQuestion()).isEmpty();
+    }
+
     return (questionIndex == int(quizQuestions.size() - 1));
 }
 
+//---------------------------------------------------------------------------
+//  numQuestions
+//
+//! Get the number of questions in the quiz.  For cardbox quizzes, this is
+//! the number of questions asked so far, plus the number of other questions
+//! ready for review.
+//
+//! @return the number of questions
+//---------------------------------------------------------------------------
+int
+QuizEngine::numQuestions() const
+{
+    if (quizSpec.getMethod() == QuizSpec::CardboxQuizMethod) {
+        unsigned int now = QDateTime::currentDateTime().toTime_t();
+        return quizQuestions.size() +
+            scheduler.getNumReady(now, getQuestion());
+    }
+
+    return quizQuestions.size();
+}
+
+//---------------------------------------------------------------------------
+//  setQuestionSchedule
+//
+//! Update the cardbox and next scheduled time of a question in a cardbox
+//! quiz, after a response to it has been recorded.
+//
+//! @param question the question
+//! @param cardbox the cardbox, or less than zero if the question is not in
+//! the cardbox system
+//! @param nextScheduled the next scheduled time
+//---------------------------------------------------------------------------
+void
+QuizEngine::setQuestionSchedule(const QString& question, int cardbox,
+                                unsigned int nextScheduled)
+{
+    if (quizSpec.getMethod() != QuizSpec::CardboxQuizMethod)
+        return;
+    scheduler.setSchedule(question, cardbox, nextScheduled);
+}
+
+//---------------------------------------------------------------------------
+//  getFirstReadyQuestion
+//
+//! Get the first cardbox question ready for review, as the list of
+//! questions of a new cardbox quiz.
+//
+//! @return a list containing the question, or an empty list if no question
+//! is ready
+//---------------------------------------------------------------------------
+QStringList
+QuizEngine::getFirstReadyQuestion() const
+{
+    unsigned int now = QDateTime::currentDateTime().toTime_t();
+    QString question = scheduler.getNextReady(now, QString());
+    return question.isEmpty() ? QStringList() : QStringList(question);
+}
+
 //---------------------------------------------------------------------------
 //  clearQuestion
 //
@@ -525,31 +971,134 @@ QuizEngine::onLastQuestion() const
 void
 QuizEngine::clearQuestion()
 {
-    correctResponses.clear();
-    correctUserResponses.clear();
+    answerTracker.clear();
+    answerInfo.clear();
     incorrectUserResponses.clear();
 }
 
 //---------------------------------------------------------------------------
 //  prepareQuestion
 //
-//! Get the answers to the current question.
+//! Get the answers to the current question, and start finding the answers
+//! to the next few questions in the background.
 //---------------------------------------------------------------------------
 void
 QuizEngine::prepareQuestion()
 {
+    Z_TRACE_SCOPE("QuizEngine::prepareQuestion");
     clearQuestion();
-    QString question = getQuestion().replace("_", "?");
+    QString question = getQuestion();
 
+    // The answers may already have been found in the background
+    stopPrefetch();
     QStringList answers;
-    QuizSpec::QuizType type = quizSpec.getType();
+    if (!takePrefetchedAnswers(question, &answers))
+        answers = getAnswers(quizSpec, question);
+
+    answerTracker.setAnswers(answers);
+    quizTotal += answerTracker.getNumAnswers();
+    setAnswerInfo();
+
+    startPrefetch();
+}
+
+//---------------------------------------------------------------------------
+//  setAnswerInfo
+//
+//! Look up the hooks and lexicon symbols of the answers to the current
+//! question, so responses can be checked against them with one lookup no
+//! matter how many answers there are.  Hook masks found by the hook mask
+//! job are used if they are ready.
+//---------------------------------------------------------------------------
+void
+QuizEngine::setAnswerInfo()
+{
+    QString lexicon = quizSpec.getLexicon();
+    bool hooks = (quizSpec.getType() == QuizSpec::QuizAnagramsWithHooks);
+    QStringList answers = answerTracker.getAnswers();
+    wordEngine->addToCache(lexicon, answers);
+
+    WordEngine::Lexicon lexiconHandle;
+    if (hooks)
+        lexiconHandle = wordEngine->getLexicon(lexicon);
+
+    answerInfo.resize(answers.size());
+    for (int i = 0; i < answers.size(); ++i) {
+        const QString& answer = answers[i];
+        AnswerInfo& info = answerInfo[i];
+        info.symbols = Auxil::getAlphagram(
+            wordEngine->getLexiconSymbols(lexicon, answer));
+
+        if (hooks && (hookMaskJob.isNull() ||
+            !hookMaskJob->getMasks(answer, &info.frontHookMask,
+                                   &info.backHookMask)))
+        {
+            lexiconHandle.getHooks(answer, &info.frontHookMask,
+                                   &info.backHookMask);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//  setHookLetters
+//
+//! Look up the hook letters and hook symbols of an answer, if they have not
+//! been looked up yet, for checking responses that can't be checked
+//! against the hook masks.
+//
+//! @param answer the answer
+//! @param info the information about the answer
+//---------------------------------------------------------------------------
+void
+QuizEngine::setHookLetters(const QString& answer, AnswerInfo* info)
+{
+    if (info->hookLettersSet)
+        return;
+
     QString lexicon = quizSpec.getLexicon();
+    QString frontAnswers =
+        wordEngine->getFrontHookLetters(lexicon, answer).toUpper();
+    QString backAnswers =
+        wordEngine->getBackHookLetters(lexicon, answer).toUpper();
+    info->frontHookSymbols = parseHookSymbols(frontAnswers);
+    info->backHookSymbols = parseHookSymbols(backAnswers);
+    info->frontHooks =
+        frontAnswers.replace(QRegExp("[\\W_\\d]+"), QString());
+    info->backHooks =
+        backAnswers.replace(QRegExp("[\\W_\\d]+"), QString());
+    info->hookLettersSet = true;
+}
+
+//---------------------------------------------------------------------------
+//  getAnswers
+//
+//! Get the answers to a question.  Only reads the word engine, so it can be
+//! called from the prefetch thread.
+//
+//! @param spec the quiz specification
+//! @param q the question
+//! @return the answers
+//---------------------------------------------------------------------------
+QStringList
+QuizEngine::getAnswers(const QuizSpec& spec, const QString& q) const
+{
+    // Anagram quiz answers may have been found by the quiz search
+    QHash<QString, QStringList>::const_iterator it = quizAnswers.find(q);
+    if (it != quizAnswers.end())
+        return it.value();
+
+    QString question = q;
+    question.replace("_", "?");
+
+    QStringList answers;
+    QuizSpec::QuizType type = spec.getType();
+    QString lexicon = spec.getLexicon();
 
     if (type == QuizSpec::QuizWordListRecall)
-        answers = wordEngine->search(lexicon, quizSpec.getSearchSpec(), true);
+        answers = wordEngine->search(lexicon, spec.getSearchSpec(), true);
     else if (type == QuizSpec::QuizBuild) {
-        int min = quizSpec.getResponseMinLength();
-        int max = quizSpec.getResponseMaxLength();
+        int min = spec.getResponseMinLength();
+        int max = spec.getResponseMaxLength();
         int qlen = question.length();
 
         if (min <= qlen) {
@@ -604,8 +1153,204 @@ QuizEngine::prepareQuestion()
         answers += wordEngine->search(lexicon, spec, true);
     }
 
-    correctResponses += answers.toSet();
-    quizTotal += correctResponses.count();
+    return answers;
+}
+
+//---------------------------------------------------------------------------
+//  setAnagramAnswers
+//
+//! Keep the words found by the search for an anagram quiz as the answers to
+//! the quiz questions, so the questions need not be searched for one at a
+//! time.  Only alphagrams whose anagrams were all found are kept, since a
+//! search may match some anagrams of an alphagram but not others.
+//
+//! @param lexicon the name of the lexicon
+//! @param alphagramWords the words found by the search, keyed by alphagram
+//---------------------------------------------------------------------------
+void
+QuizEngine::setAnagramAnswers(const QString& lexicon, const QHash<QString,
+                              QStringList>& alphagramWords)
+{
+    QStringList firstWords;
+    QHashIterator<QString, QStringList> it (alphagramWords);
+    while (it.hasNext()) {
+        it.next();
+        firstWords.append(it.value().first());
+    }
+    wordEngine->addToCache(lexicon, firstWords);
+
+    it.toFront();
+    while (it.hasNext()) {
+        it.next();
+        const QStringList& words = it.value();
+        WordEngine::WordInfo info =
+            wordEngine->getWordInfo(lexicon, words.first());
+        if (info.isValid() && (info.numAnagrams == words.size()))
+            quizAnswers.insert(it.key(), words);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  startPrefetch
+//
+//! Start finding the answers to the next few questions in the background.
+//! For cardbox quizzes, only the next question ready for review is known.
+//---------------------------------------------------------------------------
+void
+QuizEngine::startPrefetch()
+{
+    QStringList upcoming;
+    if (quizSpec.getMethod() == QuizSpec::CardboxQuizMethod) {
+        unsigned int now = QDateTime::currentDateTime().toTime_t();
+        QString next = scheduler.getNextReady(now, getQuestion());
+        if (!next.isEmpty())
+            upcoming.append(next);
+    }
+    else {
+        int end = qMin(questionIndex + 1 + PREFETCH_QUESTIONS,
+                       quizQuestions.size());
+        for (int i = questionIndex + 1; i < end; ++i)
+            upcoming.append(quizQuestions[i]);
+    }
+
+    if (upcoming.isEmpty())
+        return;
+
+    if (!prefetchThread) {
+        prefetchThread = new PrefetchThread(this);
+        prefetchThread->start();
+    }
+    prefetchThread->setQuestions(quizSpec, upcoming);
+}
+
+//---------------------------------------------------------------------------
+//  startHookMaskJob
+//
+//! Start finding the hooks of the answers found by the quiz search for an
+//! Anagrams With Hooks quiz in the background, beginning with the current
+//! question.
+//---------------------------------------------------------------------------
+void
+QuizEngine::startHookMaskJob()
+{
+    if ((quizSpec.getType() != QuizSpec::QuizAnagramsWithHooks) ||
+        quizAnswers.isEmpty())
+    {
+        return;
+    }
+
+    // Take the answers in question order, then the answers to questions
+    // not in the list, such as the questions of a cardbox quiz that are
+    // not ready yet
+    QList<QStringList> answers;
+    QSet<QString> seenQuestions;
+    for (int i = qMax(questionIndex, 0); i < quizQuestions.size(); ++i) {
+        const QString& question = quizQuestions[i];
+        QHash<QString, QStringList>::const_iterator it =
+            quizAnswers.find(question);
+        if ((it == quizAnswers.end()) || seenQuestions.contains(question))
+            continue;
+        answers.append(it.value());
+        seenQuestions.insert(question);
+    }
+    QHashIterator<QString, QStringList> it (quizAnswers);
+    while (it.hasNext()) {
+        it.next();
+        if (!seenQuestions.contains(it.key()))
+            answers.append(it.value());
+    }
+
+    hookMaskJob = QSharedPointer<HookMaskJob>(new HookMaskJob(
+        wordEngine->getLexicon(quizSpec.getLexicon()), answers));
+    JobScheduler::getInstance()->submit(hookMaskJob,
+                                        JobScheduler::PrefetchPriority);
+}
+
+//---------------------------------------------------------------------------
+//  stopHookMaskJob
+//
+//! Stop finding the hooks of the answers to the quiz, waiting for the job
+//! if it has already started, and release it.
+//---------------------------------------------------------------------------
+void
+QuizEngine::stopHookMaskJob()
+{
+    if (hookMaskJob.isNull())
+        return;
+
+    hookMaskJob->cancel();
+    hookMaskJob->wait();
+    hookMaskJob.clear();
+}
+
+//---------------------------------------------------------------------------
+//  stopPrefetch
+//
+//! Stop finding answers in the background, once the question being
+//! prefetched is done.
+//---------------------------------------------------------------------------
+void
+QuizEngine::stopPrefetch()
+{
+    if (prefetchThread)
+        prefetchThread->cancel();
+}
+
+//---------------------------------------------------------------------------
+//  hasPrefetchedAnswers
+//
+//! Determine whether the answers to a question have been found in the
+//! background.
+//
+//! @param question the question
+//! @return true if the answers have been found, false otherwise
+//---------------------------------------------------------------------------
+bool
+QuizEngine::hasPrefetchedAnswers(const QString& question) const
+{
+    QMutexLocker locker (&prefetchMutex);
+    return prefetchedAnswers.contains(question);
+}
+
+//---------------------------------------------------------------------------
+//  addPrefetchedAnswers
+//
+//! Hold the answers to a question found in the background until the
+//! question is asked.
+//
+//! @param question the question
+//! @param answers the answers
+//---------------------------------------------------------------------------
+void
+QuizEngine::addPrefetchedAnswers(const QString& question, const QStringList&
+                                 answers)
+{
+    QMutexLocker locker (&prefetchMutex);
+    prefetchedAnswers.insert(question, answers);
+}
+
+//---------------------------------------------------------------------------
+//  takePrefetchedAnswers
+//
+//! Take the answers to a question found in the background, if they have
+//! been found.
+//
+//! @param question the question
+//! @param answers returns the answers
+//! @return true if the answers had been found, false otherwise
+//---------------------------------------------------------------------------
+bool
+QuizEngine::takePrefetchedAnswers(const QString& question, QStringList*
+                                  answers)
+{
+    QMutexLocker locker (&prefetchMutex);
+    QHash<QString, QStringList>::iterator it =
+        prefetchedAnswers.find(question);
+    if (it == prefetchedAnswers.end())
+        return false;
+    *answers = it.value();
+    prefetchedAnswers.erase(it);
+    return true;
 }
 
 //---------------------------------------------------------------------------
@@ -618,12 +1363,13 @@ QuizEngine::prepareQuestion()
 void
 QuizEngine::addQuestionCorrect(const QString& response)
 {
-    correctUserResponses.insert(response);
+    answerTracker.markAnswered(response);
     ++quizCorrect;
-    QuizProgress progress = quizSpec.getProgress();
-    progress.addQuestionCorrect(response);
-    progress.setCorrect(progress.getNumCorrect() + 1);
-    quizSpec.setProgress(progress);
+
+    // Update the progress in place, since copying it would copy the
+    // correct responses to the question
+    quizSpec.addQuestionCorrect(response);
+    quizSpec.setNumCorrect(quizSpec.getProgress().getNumCorrect() + 1);
 }
 
 //---------------------------------------------------------------------------
@@ -638,9 +1384,7 @@ QuizEngine::addQuestionIncorrect(const QString& response)
 {
     incorrectUserResponses << response;
     ++quizIncorrect;
-    QuizProgress progress = quizSpec.getProgress();
-    progress.addIncorrect(response);
-    quizSpec.setProgress(progress);
+    quizSpec.addIncorrect(response);
 }
 
 //---------------------------------------------------------------------------
@@ -655,7 +1399,7 @@ QuizEngine::addQuestionIncorrect(const QString& response)
 QMap<QChar, QString>
 QuizEngine::parseHookSymbols(const QString& str)
 {
-    QRegExp re ("(?:([^\\W_\\d])([\\W_\\d]*))");
+    static const QRegExp re ("(?:([^\\W_\\d])([\\W_\\d]*))");
     QMap<QChar, QString> hookSymbols;
     for (int index = 0; ((index = re.indexIn(str, index)) >= 0);
          index += re.cap(0).length())
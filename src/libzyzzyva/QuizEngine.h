@@ -26,11 +26,17 @@
 #ifndef ZYZZYVA_QUIZ_ENGINE_H
 #define ZYZZYVA_QUIZ_ENGINE_H
 
+#include "AnswerTracker.h"
+#include "CardboxScheduler.h"
 #include "QuizSpec.h"
 #include "Rand.h"
+#include <QHash>
+#include <QMutex>
 #include <QSet>
+#include <QSharedPointer>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
 class WordEngine;
 
@@ -45,7 +51,7 @@ class QuizEngine
 
     public:
     QuizEngine(WordEngine* e);
-    ~QuizEngine() { }
+    ~QuizEngine();
 
     bool newQuiz(const QuizSpec& spec);
     bool nextQuestion();
@@ -59,36 +65,87 @@ class QuizEngine
     QStringList getMissed() const;
     QuizSpec getQuizSpec() const { return quizSpec; }
     int getQuestionIndex() const { return questionIndex; }
-    int numQuestions() const { return quizQuestions.size(); }
-    int getQuestionTotal() const { return correctResponses.size(); }
-    int getQuestionCorrect() const { return correctUserResponses.size(); }
+    int numQuestions() const;
+    int getQuestionTotal() const { return answerTracker.getNumAnswers(); }
+    int getQuestionCorrect() const {
+        return answerTracker.getNumAnswered(); }
     int getQuestionIncorrect() const { return incorrectUserResponses.size(); }
     int getQuizTotal() const { return quizTotal; }
     int getQuizCorrect() const { return quizCorrect; }
     int getQuizIncorrect() const { return quizIncorrect; }
-    QSet<QString> getQuestionCorrectResponses() const {
-        return correctUserResponses; }
+    QStringList getQuestionCorrectResponses() const {
+        return answerTracker.getAnswered(); }
     QStringList getQuestionIncorrectResponses() const {
         return incorrectUserResponses; }
 
     bool getQuestionComplete() const {
         return quizSpec.getProgress().getQuestionComplete(); }
     bool onLastQuestion() const;
+    void setQuestionSchedule(const QString& question, int cardbox,
+                             unsigned int nextScheduled);
     void setQuizSpecFilename(const QString& filename) {
         quizSpec.setFilename(filename);
     }
 
+    private:
+    // The hooks and lexicon symbols of an answer, normalized as responses
+    // are compared with them.  Hook letters are held as masks of the
+    // letters A to Z, and as strings without symbols, which are only found
+    // when a response can't be checked against the masks.  Held for each
+    // answer by its index in the answer tracker.
+    class AnswerInfo {
+        public:
+        AnswerInfo() : frontHookMask(0), backHookMask(0),
+            hookLettersSet(false) { }
+        ~AnswerInfo() { }
+
+        quint32 frontHookMask;
+        quint32 backHookMask;
+        bool hookLettersSet;
+        QString frontHooks;
+        QString backHooks;
+        QMap<QChar, QString> frontHookSymbols;
+        QMap<QChar, QString> backHookSymbols;
+        QString symbols;
+    };
+
+    private:
+    // Thread finding the answers to upcoming questions - see startPrefetch
+    class PrefetchThread;
+    friend class PrefetchThread;
+
+    // Job finding the hooks of the answers to a quiz - see startHookMaskJob
+    class HookMaskJob;
+
     private:
     void clearQuestion();
     void prepareQuestion();
+    void setAnswerInfo();
+    void setHookLetters(const QString& answer, AnswerInfo* info);
+    void startHookMaskJob();
+    void stopHookMaskJob();
+    QStringList getAnswers(const QuizSpec& spec, const QString& q) const;
+    bool sortByStoredOrder(const QString& lexicon, const QHash<QString,
+                           QStringList>& alphagramWords, bool probability,
+                           int numBlanks);
+    void setAnagramAnswers(const QString& lexicon, const QHash<QString,
+                           QStringList>& alphagramWords);
+    void startPrefetch();
+    void stopPrefetch();
+    bool hasPrefetchedAnswers(const QString& question) const;
+    void addPrefetchedAnswers(const QString& question, const QStringList&
+                              answers);
+    bool takePrefetchedAnswers(const QString& question, QStringList*
+                               answers);
     void addQuestionCorrect(const QString& response);
     void addQuestionIncorrect(const QString& response);
     QMap<QChar, QString> parseHookSymbols(const QString& str);
+    QStringList getFirstReadyQuestion() const;
 
     private:
     WordEngine*   wordEngine;
-    QSet<QString> correctResponses;
-    QSet<QString> correctUserResponses;
+    AnswerTracker answerTracker;
+    QVector<AnswerInfo> answerInfo;
     QStringList   incorrectUserResponses;
 
     int quizTotal;
@@ -96,9 +153,24 @@ class QuizEngine
     int quizIncorrect;
 
     Rand        rng;
+    CardboxScheduler scheduler;
     QuizSpec    quizSpec;
     QStringList quizQuestions;
     int         questionIndex;
+
+    // Answers to anagram quiz questions found by the quiz search, which
+    // only change in newQuiz while nothing is being prefetched
+    QHash<QString, QStringList> quizAnswers;
+
+    // Job finding the hooks of the answers in quizAnswers, whose masks are
+    // only read once it has finished
+    QSharedPointer<HookMaskJob> hookMaskJob;
+
+    // Answers to upcoming questions found in the background, guarded by
+    // the mutex since they are added by the prefetch thread
+    PrefetchThread* prefetchThread;
+    QHash<QString, QStringList> prefetchedAnswers;
+    mutable QMutex prefetchMutex;
 };
 
 #endif // ZYZZYVA_QUIZ_ENGINE_H
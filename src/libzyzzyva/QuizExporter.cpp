@@ -0,0 +1,425 @@
+//---------------------------------------------------------------------------
+// QuizExporter.cpp
+//
+// A class for exporting quizzes to the quiz files read by the mobile quiz
+// app.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "QuizExporter.h"
+#include "JobScheduler.h"
+#include "SearchSpec.h"
+#include "Trace.h"
+#include "WordEngine.h"
+#include "Auxil.h"
+#include <QBitArray>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+
+const QString EXPORT_CONNECTION_NAME = "QuizExporter";
+
+// Questions formatted and written at once, and formatted by each job at a
+// time
+const int BATCH_QUESTIONS = 8192;
+const int CHUNK_QUESTIONS = 128;
+
+// The quiz settings of an exported quiz, as the mobile quiz app numbers
+// them: an anagram quiz in random order, with every answer required
+const int MOBILE_QUIZ_TYPE = 2;
+const int MOBILE_QUIZ_METHOD = 1;
+const int MOBILE_QUIZ_ORDER = 1;
+
+// The statuses of questions and responses
+const int MOBILE_STATUS_UNANSWERED = 0;
+const int MOBILE_STATUS_CURRENT = 1;
+
+const char* const CREATE_TABLES_SQL[] = {
+    "CREATE TABLE questions (question_index integer, status integer, "
+        "name text)",
+    "CREATE UNIQUE INDEX question_index_index ON questions (question_index)",
+    "CREATE INDEX question_status_index ON questions (status)",
+    "CREATE TABLE quiz (lexicon text, type integer, current_question "
+        "integer, num_words integer, method integer, question_order integer)",
+    "CREATE TABLE responses (question_index integer, status integer, "
+        "name text)",
+    "CREATE INDEX question_response_index ON responses (question_index)",
+    "CREATE UNIQUE INDEX question_response_response_index ON responses "
+        "(question_index, name)",
+    "CREATE TABLE words (question_index integer, name text, front_hooks "
+        "text, back_hooks text, definition text)",
+    "CREATE INDEX question_word_index ON words (question_index)"
+};
+const int NUM_CREATE_TABLES_SQL =
+    sizeof(CREATE_TABLES_SQL) / sizeof(CREATE_TABLES_SQL[0]);
+
+//---------------------------------------------------------------------------
+//  setQueryError
+//
+//! Report the error of a failed query.
+//
+//! @param query the query
+//! @param errString returns the error string
+//---------------------------------------------------------------------------
+static void
+setQueryError(const QSqlQuery& query, QString* errString)
+{
+    if (errString)
+        *errString = query.lastError().text();
+}
+
+//---------------------------------------------------------------------------
+//  FormatJob
+//
+//! A job that formats chunks of questions taken in turn from a shared
+//! list, until none are left.  The thread that submits the jobs can take
+//! part by calling formatAll.
+//---------------------------------------------------------------------------
+class QuizExporter::FormatJob : public Job
+{
+    public:
+    FormatJob(const QuizExporter* e, QVector<Chunk>* c, int* n, QMutex* m)
+        : Job(), exporter(e), chunks(c), nextChunk(n), mutex(m) { }
+    ~FormatJob() { }
+
+    void formatAll() {
+        forever {
+            int i;
+            {
+                QMutexLocker locker (mutex);
+                i = (*nextChunk)++;
+            }
+            if (i >= chunks->size())
+                break;
+            exporter->formatChunk(&(*chunks)[i]);
+        }
+    }
+
+    protected:
+    void run() { formatAll(); }
+
+    private:
+    const QuizExporter* exporter;
+    QVector<Chunk>* chunks;
+    int* nextChunk;
+    QMutex* mutex;
+};
+
+//---------------------------------------------------------------------------
+//  exportQuiz
+//
+//! Export an anagram quiz of the alphagrams of a list of words to a quiz
+//! file, replacing the file if it exists.  The questions are in the order
+//! their first words are given, and words not in the lexicon are skipped.
+//
+//! @param words the words
+//! @param filename the name of the quiz file
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+QuizExporter::exportQuiz(const QStringList& words, const QString& filename,
+                         QString* errString)
+{
+    Z_TRACE_SCOPE("QuizExporter::exportQuiz");
+    numQuestions = 0;
+    numWords = 0;
+
+    QStringList alphagrams;
+    QSet<QString> alphagramSet;
+    QBitArray acceptable = engine->areAcceptable(lexicon, words);
+    for (int i = 0; i < words.size(); ++i) {
+        if (!acceptable.testBit(i))
+            continue;
+        QString alphagram = Auxil::getAlphagram(words[i].toUpper());
+        if (alphagramSet.contains(alphagram))
+            continue;
+        alphagramSet.insert(alphagram);
+        alphagrams.append(alphagram);
+    }
+
+    if (alphagrams.isEmpty()) {
+        if (errString)
+            *errString = "None of the words are in the lexicon.";
+        return false;
+    }
+
+    if (QFile::exists(filename) && !QFile::remove(filename)) {
+        if (errString)
+            *errString = "Cannot replace the file '" + filename + "'.";
+        return false;
+    }
+
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE",
+                                                    EXPORT_CONNECTION_NAME);
+        db.setDatabaseName(filename);
+        if (!db.open()) {
+            if (errString)
+                *errString = db.lastError().text();
+        }
+        else {
+            // The file is removed if the export does not finish, so it
+            // need not be safe from crashes while it is written
+            QSqlQuery query (db);
+            query.exec("PRAGMA journal_mode=OFF");
+            query.exec("PRAGMA synchronous=OFF");
+            query.exec("BEGIN TRANSACTION");
+
+            ok = createTables(db, errString);
+            for (int first = 0; ok && (first < alphagrams.size());
+                 first += BATCH_QUESTIONS)
+            {
+                QVector<Chunk> chunks = formatBatch(
+                    alphagrams.mid(first, BATCH_QUESTIONS), first);
+                foreach (const Chunk& chunk, chunks) {
+                    ok = writeChunk(db, chunk, errString);
+                    if (!ok)
+                        break;
+                }
+            }
+            if (ok)
+                ok = writeQuiz(db, errString);
+
+            query.exec(ok ? "COMMIT TRANSACTION" : "ROLLBACK TRANSACTION");
+            query.clear();
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(EXPORT_CONNECTION_NAME);
+
+    if (!ok)
+        QFile::remove(filename);
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+//  formatBatch
+//
+//! Format a batch of questions, split into chunks formatted in parallel by
+//! jobs on the job scheduler and by the calling thread.
+//
+//! @param alphagrams the alphagrams of the questions
+//! @param firstIndex the index of the first question in the quiz
+//! @return the chunks of the batch, in order
+//---------------------------------------------------------------------------
+QVector<QuizExporter::Chunk>
+QuizExporter::formatBatch(const QStringList& alphagrams, int firstIndex)
+    const
+{
+    Z_TRACE_SCOPE("QuizExporter::formatBatch");
+    QVector<Chunk> chunks;
+    for (int i = 0; i < alphagrams.size(); i += CHUNK_QUESTIONS) {
+        Chunk chunk;
+        chunk.firstIndex = firstIndex + i;
+        chunk.alphagrams = alphagrams.mid(i, CHUNK_QUESTIONS);
+        chunks.append(chunk);
+    }
+
+    int nextChunk = 0;
+    QMutex mutex;
+    FormatJob job (this, &chunks, &nextChunk, &mutex);
+    QList<JobPointer> jobs;
+    JobScheduler* scheduler = JobScheduler::getInstance();
+    int numJobs = qMin(scheduler->getNumWorkers(), chunks.size());
+    for (int i = 1; i < numJobs; ++i) {
+        jobs.append(scheduler->submit(
+            new FormatJob(this, &chunks, &nextChunk, &mutex),
+            JobScheduler::PrefetchPriority));
+    }
+    job.formatAll();
+
+    // Jobs that have not started by now have nothing left to format
+    foreach (const JobPointer& otherJob, jobs) {
+        otherJob->cancel();
+        otherJob->wait();
+    }
+
+    return chunks;
+}
+
+//---------------------------------------------------------------------------
+//  formatChunk
+//
+//! Find the words of the questions of a chunk, and read their hooks and
+//! definitions.  The words of the whole chunk are added to the word cache
+//! at once, rather than read one at a time.
+//
+//! @param chunk the chunk
+//---------------------------------------------------------------------------
+void
+QuizExporter::formatChunk(Chunk* chunk) const
+{
+    Z_TRACE_SCOPE("QuizExporter::formatChunk");
+    QList<QStringList> questionWords;
+    QStringList chunkWords;
+    foreach (const QString& alphagram, chunk->alphagrams) {
+        SearchSpec spec;
+        SearchCondition condition;
+        condition.type = SearchCondition::AnagramMatch;
+        condition.stringValue = alphagram;
+        spec.conditions.append(condition);
+
+        QStringList anagrams = engine->search(lexicon, spec, true);
+        anagrams.sort();
+        questionWords.append(anagrams);
+        chunkWords += anagrams;
+    }
+
+    engine->addToCache(lexicon, chunkWords);
+
+    for (int i = 0; i < questionWords.size(); ++i) {
+        foreach (const QString& word, questionWords[i]) {
+            chunk->questionIndexes.append(chunk->firstIndex + i);
+            chunk->words.append(word);
+            chunk->frontHooks.append(
+                engine->getFrontHookLetters(lexicon, word));
+            chunk->backHooks.append(
+                engine->getBackHookLetters(lexicon, word));
+            chunk->definitions.append(engine->getDefinition(lexicon, word));
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//  createTables
+//
+//! Create the tables of a quiz file.
+//
+//! @param db the database of the quiz file
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+QuizExporter::createTables(QSqlDatabase& db, QString* errString) const
+{
+    QSqlQuery query (db);
+    for (int i = 0; i < NUM_CREATE_TABLES_SQL; ++i) {
+        if (!query.exec(CREATE_TABLES_SQL[i])) {
+            setQueryError(query, errString);
+            return false;
+        }
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  writeChunk
+//
+//! Write the questions and words of a chunk to a quiz file.  The first
+//! question of the quiz is the current question, and its words are written
+//! as responses not yet given.
+//
+//! @param db the database of the quiz file
+//! @param chunk the chunk
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+QuizExporter::writeChunk(QSqlDatabase& db, const Chunk& chunk, QString*
+                         errString)
+{
+    Z_TRACE_SCOPE("QuizExporter::writeChunk");
+    QVariantList indexes;
+    QVariantList statuses;
+    QVariantList names;
+    for (int i = 0; i < chunk.alphagrams.size(); ++i) {
+        int index = chunk.firstIndex + i;
+        indexes.append(index);
+        statuses.append(index ? MOBILE_STATUS_UNANSWERED
+                              : MOBILE_STATUS_CURRENT);
+        names.append(chunk.alphagrams[i]);
+    }
+
+    QSqlQuery query (db);
+    query.prepare("INSERT INTO questions (question_index, status, name) "
+                  "VALUES (?, ?, ?)");
+    query.addBindValue(indexes);
+    query.addBindValue(statuses);
+    query.addBindValue(names);
+    if (!query.execBatch()) {
+        setQueryError(query, errString);
+        return false;
+    }
+
+    query.prepare("INSERT INTO words (question_index, name, front_hooks, "
+                  "back_hooks, definition) VALUES (?, ?, ?, ?, ?)");
+    query.addBindValue(chunk.questionIndexes);
+    query.addBindValue(chunk.words);
+    query.addBindValue(chunk.frontHooks);
+    query.addBindValue(chunk.backHooks);
+    query.addBindValue(chunk.definitions);
+    if (!query.execBatch()) {
+        setQueryError(query, errString);
+        return false;
+    }
+
+    if (chunk.firstIndex == 0) {
+        query.prepare("INSERT INTO responses (question_index, status, name) "
+                      "VALUES (0, ?, ?)");
+        for (int i = 0; i < chunk.words.size(); ++i) {
+            if (chunk.questionIndexes[i].toInt())
+                break;
+            query.bindValue(0, MOBILE_STATUS_UNANSWERED);
+            query.bindValue(1, chunk.words[i]);
+            if (!query.exec()) {
+                setQueryError(query, errString);
+                return false;
+            }
+        }
+    }
+
+    numQuestions += chunk.alphagrams.size();
+    numWords += chunk.words.size();
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  writeQuiz
+//
+//! Write the settings and progress of the quiz to a quiz file, once all
+//! questions have been written.
+//
+//! @param db the database of the quiz file
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+QuizExporter::writeQuiz(QSqlDatabase& db, QString* errString) const
+{
+    QSqlQuery query (db);
+    query.prepare("INSERT INTO quiz (lexicon, type, current_question, "
+                  "num_words, method, question_order) "
+                  "VALUES (?, ?, 0, ?, ?, ?)");
+    query.addBindValue(lexicon);
+    query.addBindValue(MOBILE_QUIZ_TYPE);
+    query.addBindValue(numWords);
+    query.addBindValue(MOBILE_QUIZ_METHOD);
+    query.addBindValue(MOBILE_QUIZ_ORDER);
+    if (!query.exec()) {
+        setQueryError(query, errString);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+//---------------------------------------------------------------------------
+// QuizExporter.h
+//
+// A class for exporting quizzes to the quiz files read by the mobile quiz
+// app.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_QUIZ_EXPORTER_H
+#define ZYZZYVA_QUIZ_EXPORTER_H
+
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+class WordEngine;
+
+// Exports anagram quizzes to quiz files, each an SQLite database holding
+// the alphagram questions in order, the words of the first question as
+// responses not yet given, and the words of every question with their
+// hooks and definitions.  Questions are read from the word engine and
+// formatted in batches, each formatted in parallel on the job scheduler
+// and written before the next is read, so a quiz of any size is exported
+// in bounded memory.
+class QuizExporter
+{
+    public:
+    QuizExporter(WordEngine* e, const QString& lex)
+        : engine(e), lexicon(lex), numQuestions(0), numWords(0) { }
+    ~QuizExporter() { }
+
+    bool exportQuiz(const QStringList& words, const QString& filename,
+                    QString* errString = 0);
+    int getNumQuestions() const { return numQuestions; }
+    int getNumWords() const { return numWords; }
+
+    private:
+    // The rows of a run of consecutive questions, ready to be inserted
+    class Chunk {
+        public:
+        Chunk() : firstIndex(0) { }
+        int firstIndex;
+        QStringList alphagrams;
+        QVariantList questionIndexes;
+        QVariantList words;
+        QVariantList frontHooks;
+        QVariantList backHooks;
+        QVariantList definitions;
+    };
+
+    class FormatJob;
+    friend class FormatJob;
+
+    QVector<Chunk> formatBatch(const QStringList& alphagrams, int firstIndex)
+        const;
+    void formatChunk(Chunk* chunk) const;
+    bool createTables(QSqlDatabase& db, QString* errString) const;
+    bool writeChunk(QSqlDatabase& db, const Chunk& chunk, QString*
+                    errString);
+    bool writeQuiz(QSqlDatabase& db, QString* errString) const;
+
+    private:
+    WordEngine* engine;
+    QString lexicon;
+    int numQuestions;
+    int numWords;
+};
+
+#endif // ZYZZYVA_QUIZ_EXPORTER_H
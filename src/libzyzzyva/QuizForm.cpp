@@ -47,7 +47,6 @@
 #include <QMessageBox>
 #include <QTimerEvent>
 #include <QGridLayout>
-#include <QTextStream>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -60,6 +59,7 @@ const QString UNPAUSE_BUTTON = "Un&pause";
 const QString MARK_MISSED_BUTTON = "&Mark as Missed";
 const QString MARK_CORRECT_BUTTON = "&Mark as Correct";
 const int TITLE_FONT_PIXEL_SIZE = 20;
+const int STATS_FLUSH_MSECS = 5000;
 
 //---------------------------------------------------------------------------
 //  alphabeticalCmp
@@ -133,7 +133,8 @@ QuizForm::QuizForm(WordEngine* we, QWidget* parent, Qt::WFlags f)
     questionMarkedStatus(QuestionNotMarked), quizStatsDatabase(0),
     // FIXME: This dialog should be nonmodal!
     analyzeDialog(new AnalyzeQuizDialog(quizEngine, we, this,
-                                        Qt::WindowMinMaxButtonsHint))
+                                        Qt::WindowMinMaxButtonsHint)),
+    measuringResponse(false), latencyPending(false)
 {
     QFont titleFont = qApp->font();
     titleFont.setPixelSize(TITLE_FONT_PIXEL_SIZE);
@@ -354,6 +355,13 @@ QuizForm::QuizForm(WordEngine* we, QWidget* parent, Qt::WFlags f)
     displayAnswerTimer = new QTimer(this);
     connect(displayAnswerTimer, SIGNAL(timeout()),
             SLOT(displayNextCorrectAnswer()));
+
+    statsFlushTimer = new QTimer(this);
+    statsFlushTimer->setSingleShot(true);
+    statsFlushTimer->setInterval(STATS_FLUSH_MSECS);
+    connect(statsFlushTimer, SIGNAL(timeout()), SLOT(flushQuestionStats()));
+
+    analyzeDialog->setResponseLatency(&responseLatency);
 }
 
 //---------------------------------------------------------------------------
@@ -439,11 +447,14 @@ QuizForm::isSaveEnabled() const
 //---------------------------------------------------------------------------
 //  responseEntered
 //
-//! Called when a response is entered into the input line.
+//! Called when a response is entered into the input line.  The time taken
+//! to check the response, record its stats, add it to the response list
+//! and display it is added to the response times of the quiz.
 //---------------------------------------------------------------------------
 void
 QuizForm::responseEntered()
 {
+    responseTimer.start();
     QString response = inputLine->text();
     if (response.isEmpty() && checkResponseButton->isEnabled()) {
         checkResponseClicked();
@@ -460,8 +471,14 @@ QuizForm::responseEntered()
         return;
     }
 
+    pendingLatency.clear();
+    latencyPending = false;
+    measuringResponse = true;
+
     QuizEngine::ResponseStatus status = quizEngine->respond(response,
         (lexiconSymbolCbox->checkState() == Qt::Checked));
+    pendingLatency.nsecs[LatencyStats::CheckStage] =
+        responseTimer.nsecsElapsed();
     QString displayResponse = response;
     QString statusStr;
 
@@ -475,6 +492,7 @@ QuizForm::responseEntered()
 
         // FIXME: Probably not the right way to get alphabetical sorting
         // instead of alphagram sorting
+        qint64 wordListStart = responseTimer.nsecsElapsed();
         bool origGroupByAnagrams = MainSettings::getWordListGroupByAnagrams();
         MainSettings::setWordListGroupByAnagrams(false);
         responseModel->addWord(
@@ -484,6 +502,8 @@ QuizForm::responseEntered()
 
         responseView->scrollTo(responseModel->sibling(
             responseModel->getLastAddedIndex(), 0, QModelIndex()));
+        pendingLatency.nsecs[LatencyStats::WordListStage] =
+            responseTimer.nsecsElapsed() - wordListStart;
         statusStr = "<font color=\"blue\">Correct</font>";
         analyzeDialog->updateStats();
         inputLine->clear();
@@ -532,6 +552,37 @@ QuizForm::responseEntered()
     {
         checkResponseClicked();
     }
+
+    // The response is displayed once the repaints it caused are done.
+    // Those are handled before a zero timer fires, so the display time is
+    // measured to the timer.  Until then the display stage holds the time
+    // the response was handled at.
+    measuringResponse = false;
+    pendingLatency.nsecs[LatencyStats::DisplayStage] =
+        responseTimer.nsecsElapsed();
+    latencyPending = true;
+    QTimer::singleShot(0, this, SLOT(responseDisplayed()));
+}
+
+//---------------------------------------------------------------------------
+//  responseDisplayed
+//
+//! Called once a response has been displayed.  Add the time taken to
+//! handle it to the response times of the quiz.
+//---------------------------------------------------------------------------
+void
+QuizForm::responseDisplayed()
+{
+    if (!latencyPending)
+        return;
+    latencyPending = false;
+
+    qint64 total = responseTimer.nsecsElapsed();
+    pendingLatency.nsecs[LatencyStats::DisplayStage] =
+        total - pendingLatency.nsecs[LatencyStats::DisplayStage];
+    pendingLatency.nsecs[LatencyStats::TotalStage] = total;
+    responseLatency.addSample(pendingLatency);
+    analyzeDialog->updateLatency();
 }
 
 
@@ -585,6 +636,8 @@ QuizForm::newQuiz(const QuizSpec& spec)
         cardboxStatusLabel->hide();
 
     // Restore incorrect and missed words from quiz progress
+    responseLatency.clear();
+    latencyPending = false;
     analyzeDialog->newQuiz(spec);
 
     // Connect to database before starting the first question
@@ -702,17 +755,7 @@ QuizForm::saveRequested(bool saveAs)
         return;
     }
 
-    QDomImplementation implementation;
-    QDomDocument document (implementation.createDocumentType("zyzzyva-quiz",
-        QString(), "http://boshvark.com/dtd/zyzzyva-quiz.dtd"));
-
-    document.appendChild(quizEngine->getQuizSpec().asDomElement());
-
-    //// XXX: There should be a programmatic way to write the <?xml?> header
-    //// based on the QDomImplementation, shouldn't there?
-    QTextStream stream (&file);
-    stream << "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n"
-        << document.toString();
+    quizEngine->getQuizSpec().writeXmlFile(&file);
 
     quizEngine->setQuizSpecFilename(filename);
     setQuizNameFromFilename(filename);
@@ -774,7 +817,7 @@ QuizForm::newQuizClicked()
     NewQuizDialog* dialog = new NewQuizDialog(this);
     QuizSpec spec = quizEngine->getQuizSpec();
     spec.setProgress(QuizProgress());
-    spec.setRandomAlgorithm(Rand::MarsagliaMwc);
+    spec.setRandomAlgorithm(Rand::Xoshiro128PlusPlus);
     spec.setRandomSeed(0);
     spec.setRandomSeed2(0);
     dialog->setQuizSpec(spec);
@@ -832,6 +875,7 @@ QuizForm::markMissed()
     checkBringsJudgment = true;
     questionMarkedStatus = QuestionMarkedMissed;
     quizStatsDatabase->undoLastResponse(quizEngine->getQuestion());
+    updateQuestionSchedule();
     checkResponseClicked();
     checkBringsJudgment = old;
 }
@@ -859,6 +903,7 @@ QuizForm::markCorrect()
     checkBringsJudgment = false;
     questionMarkedStatus = QuestionMarkedCorrect;
     quizStatsDatabase->undoLastResponse(quizEngine->getQuestion());
+    updateQuestionSchedule();
     checkResponseClicked();
     checkBringsJudgment = old;
     quizEngine->markQuestionAsCorrect();
@@ -879,6 +924,7 @@ QuizForm::moveToCardbox(int cardbox)
         markCorrect();
 
     quizStatsDatabase->setCardbox(quizEngine->getQuestion(), cardbox);
+    updateQuestionSchedule();
     updateQuestionStatus();
 }
 
@@ -931,6 +977,7 @@ QuizForm::checkResponseClicked()
     // responses to the quiz engine
     if (!checkBringsJudgment) {
         QStringList unanswered = quizEngine->getMissed();
+        QList<WordTableModel::WordItem> wordItems;
         QStringListIterator it (unanswered);
         while (it.hasNext()) {
             QString word = it.next();
@@ -956,18 +1003,20 @@ QuizForm::checkResponseClicked()
             }
 
             quizEngine->respond(response, lexiconSymbols);
-
-            // FIXME: Probably not the right way to get alphabetical sorting
-            // instead of alphagram sorting
-            bool origGroupByAnagrams
-                = MainSettings::getWordListGroupByAnagrams();
-            MainSettings::setWordListGroupByAnagrams(false);
-            responseModel->removeWord(word);
-            responseModel->addWord(
-                WordTableModel::WordItem(word, WordTableModel::WordCorrect),
-                true);
-            MainSettings::setWordListGroupByAnagrams(origGroupByAnagrams);
+            wordItems.append(
+                WordTableModel::WordItem(word, WordTableModel::WordCorrect));
         }
+
+        // Replace any missed answers shown with correct answers all at
+        // once, rather than sorting the answer list for each one
+        // FIXME: Probably not the right way to get alphabetical sorting
+        // instead of alphagram sorting
+        bool origGroupByAnagrams = MainSettings::getWordListGroupByAnagrams();
+        MainSettings::setWordListGroupByAnagrams(false);
+        responseModel->removeWords(unanswered);
+        if (!wordItems.isEmpty())
+            responseModel->addWords(wordItems);
+        MainSettings::setWordListGroupByAnagrams(origGroupByAnagrams);
     }
 
     killActiveTimer();
@@ -1173,12 +1222,10 @@ QuizForm::startQuestion()
     QString question = quizEngine->getQuestion();
     origQuestionData = quizStatsDatabase->getQuestionData(question);
 
-    QSet<QString> correct = quizEngine->getQuestionCorrectResponses();
+    QStringList correct = quizEngine->getQuestionCorrectResponses();
     if (!correct.isEmpty()) {
         QList<WordTableModel::WordItem> wordItems;
-        QSetIterator<QString> it (correct);
-        while (it.hasNext()) {
-            QString word = it.next();
+        foreach (const QString& word, correct) {
             wordItems.append(
                 WordTableModel::WordItem(word, WordTableModel::WordCorrect));
         }
@@ -1937,6 +1984,7 @@ QuizForm::connectToDatabase(const QString& lexicon, const QString& quizType)
 void
 QuizForm::disconnectDatabase()
 {
+    statsFlushTimer->stop();
     delete quizStatsDatabase;
     quizStatsDatabase = 0;
 }
@@ -1957,10 +2005,52 @@ QuizForm::recordQuestionStats(bool correct)
     if (quizEngine->getQuizSpec().getMethod() != QuizSpec::CardboxQuizMethod)
         setUnsavedChanges(true);
 
+    qint64 statsStart = measuringResponse ? responseTimer.nsecsElapsed() : 0;
     QuizSpec::QuizMethod method = quizEngine->getQuizSpec().getMethod();
     bool updateCardbox = (method == QuizSpec::CardboxQuizMethod);
     quizStatsDatabase->recordResponse(quizEngine->getQuestion(), correct,
         updateCardbox);
+    if (updateCardbox)
+        updateQuestionSchedule();
+    if (measuringResponse) {
+        pendingLatency.nsecs[LatencyStats::StatsStage] +=
+            responseTimer.nsecsElapsed() - statsStart;
+    }
+
+    // Responses are written to the database a few at a time
+    if (!statsFlushTimer->isActive())
+        statsFlushTimer->start();
+}
+
+//---------------------------------------------------------------------------
+//  flushQuestionStats
+//
+//! Write the responses recorded since the last flush to the database.
+//---------------------------------------------------------------------------
+void
+QuizForm::flushQuestionStats()
+{
+    if (quizStatsDatabase && quizStatsDatabase->isValid())
+        quizStatsDatabase->flush();
+}
+
+//---------------------------------------------------------------------------
+//  updateQuestionSchedule
+//
+//! Tell the quiz engine the cardbox and next scheduled time of the current
+//! question, after they have been changed in the database.
+//---------------------------------------------------------------------------
+void
+QuizForm::updateQuestionSchedule()
+{
+    if (!quizStatsDatabase || !quizStatsDatabase->isValid())
+        return;
+
+    QString question = quizEngine->getQuestion();
+    QuizStatsDatabase::QuestionData data =
+        quizStatsDatabase->getQuestionData(question);
+    quizEngine->setQuestionSchedule(question, data.valid ? data.cardbox : -1,
+                                    data.nextScheduled);
 }
 
 //---------------------------------------------------------------------------
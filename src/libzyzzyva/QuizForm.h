@@ -26,11 +26,13 @@
 #define ZYZZYVA_QUIZ_FORM_H
 
 #include "ActionForm.h"
+#include "LatencyStats.h"
 #include "QuizTimerSpec.h"
 #include "QuizStatsDatabase.h"
 #include "QuizSpec.h"
 #include <QCheckBox>
 #include <QComboBox>
+#include <QElapsedTimer>
 #include <QImage>
 #include <QKeyEvent>
 #include <QLabel>
@@ -93,8 +95,12 @@ class QuizForm : public ActionForm
     void stopDisplayingCorrectAnswers();
     void displayNextCorrectAnswer();
     void enableAndSelectInputArea();
+    void flushQuestionStats();
     bool promptToSaveChanges();
 
+    private slots:
+    void responseDisplayed();
+
     protected:
     void keyPressEvent(QKeyEvent* event);
 
@@ -129,6 +135,7 @@ class QuizForm : public ActionForm
     void connectToDatabase(const QString& lexicon, const QString& quizType);
     void disconnectDatabase();
     void recordQuestionStats(bool correct);
+    void updateQuestionSchedule();
     bool customLetterOrderAllowed(QuizSpec::QuizType quizType) const;
     void updateValidatorOptions();
 
@@ -184,10 +191,19 @@ class QuizForm : public ActionForm
     QuizStatsDatabase::QuestionData origQuestionData;
 
     QTimer* displayAnswerTimer;
+    QTimer* statsFlushTimer;
     int currentDisplayAnswer;
 
     AnalyzeQuizDialog* analyzeDialog;
 
+    // The time taken to handle each response of the quiz, timed from the
+    // response being entered until it is displayed - see responseEntered
+    LatencyStats responseLatency;
+    LatencyStats::Sample pendingLatency;
+    QElapsedTimer responseTimer;
+    bool measuringResponse;
+    bool latencyPending;
+
     enum {
         QuestionNotMarked = 0,
         QuestionMarkedMissed = 1,
@@ -23,6 +23,7 @@
 //---------------------------------------------------------------------------
 
 #include "QuizProgress.h"
+#include <QStringList>
 
 const QString XML_TOP_ELEMENT = "progress";
 const QString XML_QUESTION_ATTR = "question";
@@ -35,9 +36,86 @@ const QString XML_MISSED_RESPONSES_ELEMENT = "missed-responses";
 const QString XML_RESPONSE_ELEMENT = "response";
 const QString XML_RESPONSE_WORD_ATTR = "word";
 const QString XML_RESPONSE_COUNT_ATTR = "count";
+const QString XML_RESPONSES_WORDS_ATTR = "words";
 
 using namespace std;
 
+//---------------------------------------------------------------------------
+//  encodeWords
+//
+//! Encode a set of response words in a single string, with the words
+//! separated by spaces.
+//
+//! @param words the words
+//! @return the encoded string
+//---------------------------------------------------------------------------
+static QString
+encodeWords(const QSet<QString>& words)
+{
+    QStringList list = words.toList();
+    list.sort();
+    return list.join(" ");
+}
+
+//---------------------------------------------------------------------------
+//  encodeCounts
+//
+//! Encode response words and the number of times each response was made in
+//! a single string, as WORD:COUNT items separated by spaces.
+//
+//! @param counts the number of times each word was given
+//! @return the encoded string
+//---------------------------------------------------------------------------
+static QString
+encodeCounts(const QMap<QString, int>& counts)
+{
+    QString str;
+    QMap<QString, int>::const_iterator it;
+    for (it = counts.begin(); it != counts.end(); ++it) {
+        if (!str.isEmpty())
+            str += QChar(' ');
+        str += it.key() + QChar(':') + QString::number(*it);
+    }
+    return str;
+}
+
+//---------------------------------------------------------------------------
+//  decodeResponses
+//
+//! Add the responses of an encoded string to quiz progress.
+//
+//! @param progress the quiz progress
+//! @param element the name of the responses element the string is from
+//! @param str the encoded string
+//! @return true if successful, false if the string is not valid
+//---------------------------------------------------------------------------
+static bool
+decodeResponses(QuizProgress* progress, const QString& element, const
+                QString& str)
+{
+    QStringList items = str.split(QChar(' '), QString::SkipEmptyParts);
+    foreach (const QString& item, items) {
+        if (element == XML_QUESTION_CORRECT_RESPONSES_ELEMENT) {
+            progress->addQuestionCorrect(item);
+            continue;
+        }
+
+        int colon = item.lastIndexOf(QChar(':'));
+        if (colon <= 0)
+            return false;
+        bool ok = false;
+        int count = item.mid(colon + 1).toInt(&ok);
+        if (!ok)
+            return false;
+        QString word = item.left(colon);
+        if (element == XML_MISSED_RESPONSES_ELEMENT)
+            progress->addMissed(word, count);
+        else
+            progress->addIncorrect(word, count);
+    }
+    return true;
+}
+
 //---------------------------------------------------------------------------
 //  isEmpty
 //
@@ -183,44 +261,30 @@ QuizProgress::asDomElement() const
     topElement.setAttribute(XML_QUESTION_COMPLETE_ATTR,
         (questionComplete ? QString("true") : QString("false")));
 
+    // Responses are written in one attribute of each responses element
+    // rather than as one element each, which older versions wrote
     if (!questionCorrectWords.isEmpty()) {
         QDomElement questionCorrectElement = doc.createElement(
             XML_QUESTION_CORRECT_RESPONSES_ELEMENT);
+        questionCorrectElement.setAttribute(XML_RESPONSES_WORDS_ATTR,
+                                            encodeWords(questionCorrectWords));
         topElement.appendChild(questionCorrectElement);
-
-        QSetIterator<QString> it (questionCorrectWords);
-        while (it.hasNext()) {
-            QString word = it.next();
-            QDomElement elem = doc.createElement(XML_RESPONSE_ELEMENT);
-            elem.setAttribute(XML_RESPONSE_WORD_ATTR, word);
-            questionCorrectElement.appendChild(elem);
-        }
     }
 
     if (!incorrectWords.empty()) {
         QDomElement incorrectElement = doc.createElement(
             XML_INCORRECT_RESPONSES_ELEMENT);
+        incorrectElement.setAttribute(XML_RESPONSES_WORDS_ATTR,
+                                      encodeCounts(incorrectWords));
         topElement.appendChild(incorrectElement);
-        QMap<QString, int>::const_iterator it;
-        for (it = incorrectWords.begin(); it != incorrectWords.end(); ++it) {
-            QDomElement elem = doc.createElement(XML_RESPONSE_ELEMENT);
-            elem.setAttribute(XML_RESPONSE_WORD_ATTR, it.key());
-            elem.setAttribute(XML_RESPONSE_COUNT_ATTR, *it);
-            incorrectElement.appendChild(elem);
-        }
     }
 
     if (!missedWords.empty()) {
         QDomElement missedElement = doc.createElement(
             XML_MISSED_RESPONSES_ELEMENT);
+        missedElement.setAttribute(XML_RESPONSES_WORDS_ATTR,
+                                   encodeCounts(missedWords));
         topElement.appendChild(missedElement);
-        QMap<QString, int>::const_iterator it;
-        for (it = missedWords.begin(); it != missedWords.end(); ++it) {
-            QDomElement elem = doc.createElement(XML_RESPONSE_ELEMENT);
-            elem.setAttribute(XML_RESPONSE_WORD_ATTR, it.key());
-            elem.setAttribute(XML_RESPONSE_COUNT_ATTR, *it);
-            missedElement.appendChild(elem);
-        }
     }
 
     return topElement;
@@ -230,7 +294,7 @@ QuizProgress::asDomElement() const
 //  fromDomElement
 //
 //! Reset the object based on the contents of a DOM element representing quiz
-//! progress.
+//! progress, with responses in the compact form or one element each.
 //
 //! @return true if successful, false otherwise
 //---------------------------------------------------------------------------
@@ -274,6 +338,13 @@ QuizProgress::fromDomElement(const QDomElement& element)
             return false;
         }
 
+        if (elem.hasAttribute(XML_RESPONSES_WORDS_ATTR) &&
+            !decodeResponses(&tmpProgress, elem.tagName(),
+                             elem.attribute(XML_RESPONSES_WORDS_ATTR)))
+        {
+            return false;
+        }
+
         QDomElement responseElem = elem.firstChild().toElement();
         for (; !responseElem.isNull();
              responseElem = responseElem.nextSibling().toElement())
@@ -307,3 +378,141 @@ QuizProgress::fromDomElement(const QDomElement& element)
     *this = tmpProgress;
     return true;
 }
+
+//---------------------------------------------------------------------------
+//  writeXml
+//
+//! Write the quiz progress as XML to a stream writer, in the same form as
+//! asDomElement, without building a DOM element.
+//
+//! @param writer the XML stream writer
+//---------------------------------------------------------------------------
+void
+QuizProgress::writeXml(QXmlStreamWriter& writer) const
+{
+    writer.writeStartElement(XML_TOP_ELEMENT);
+    writer.writeAttribute(XML_QUESTION_ATTR, QString::number(question));
+    writer.writeAttribute(XML_CORRECT_ATTR, QString::number(correct));
+    writer.writeAttribute(XML_QUESTION_COMPLETE_ATTR,
+        (questionComplete ? QString("true") : QString("false")));
+
+    if (!questionCorrectWords.isEmpty()) {
+        writer.writeEmptyElement(XML_QUESTION_CORRECT_RESPONSES_ELEMENT);
+        writer.writeAttribute(XML_RESPONSES_WORDS_ATTR,
+                              encodeWords(questionCorrectWords));
+    }
+
+    if (!incorrectWords.empty()) {
+        writer.writeEmptyElement(XML_INCORRECT_RESPONSES_ELEMENT);
+        writer.writeAttribute(XML_RESPONSES_WORDS_ATTR,
+                              encodeCounts(incorrectWords));
+    }
+
+    if (!missedWords.empty()) {
+        writer.writeEmptyElement(XML_MISSED_RESPONSES_ELEMENT);
+        writer.writeAttribute(XML_RESPONSES_WORDS_ATTR,
+                              encodeCounts(missedWords));
+    }
+
+    writer.writeEndElement();
+}
+
+//---------------------------------------------------------------------------
+//  readXml
+//
+//! Reset the object based on quiz progress read from a stream reader, with
+//! responses in the compact form or one element each.  The reader must be
+//! at the start of the progress element, and is left at its end.
+//
+//! @param reader the XML stream reader
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+QuizProgress::readXml(QXmlStreamReader& reader)
+{
+    if (!reader.isStartElement() || (reader.name() != XML_TOP_ELEMENT))
+        return false;
+
+    QuizProgress tmpProgress;
+    QXmlStreamAttributes attributes = reader.attributes();
+
+    if (attributes.hasAttribute(XML_QUESTION_ATTR)) {
+        bool ok = false;
+        int tmpQuestion =
+            attributes.value(XML_QUESTION_ATTR).toString().toInt(&ok);
+        if (!ok)
+            return false;
+        tmpProgress.setQuestion(tmpQuestion);
+    }
+
+    if (attributes.hasAttribute(XML_CORRECT_ATTR)) {
+        bool ok = false;
+        int tmpCorrect =
+            attributes.value(XML_CORRECT_ATTR).toString().toInt(&ok);
+        if (!ok)
+            return false;
+        tmpProgress.setCorrect(tmpCorrect);
+    }
+
+    if (attributes.hasAttribute(XML_QUESTION_COMPLETE_ATTR)) {
+        tmpProgress.setQuestionComplete(
+            attributes.value(XML_QUESTION_COMPLETE_ATTR).toString() ==
+            "true");
+    }
+
+    while (reader.readNextStartElement()) {
+        QString tag = reader.name().toString();
+        if ((tag != XML_MISSED_RESPONSES_ELEMENT) &&
+            (tag != XML_INCORRECT_RESPONSES_ELEMENT) &&
+            (tag != XML_QUESTION_CORRECT_RESPONSES_ELEMENT))
+        {
+            return false;
+        }
+
+        QXmlStreamAttributes elemAttributes = reader.attributes();
+        if (elemAttributes.hasAttribute(XML_RESPONSES_WORDS_ATTR) &&
+            !decodeResponses(&tmpProgress, tag,
+                elemAttributes.value(XML_RESPONSES_WORDS_ATTR).toString()))
+        {
+            return false;
+        }
+
+        while (reader.readNextStartElement()) {
+            QXmlStreamAttributes responseAttributes = reader.attributes();
+            if ((reader.name() != XML_RESPONSE_ELEMENT) ||
+                !responseAttributes.hasAttribute(XML_RESPONSE_WORD_ATTR))
+            {
+                return false;
+            }
+
+            int count = 0;
+            if ((tag == XML_MISSED_RESPONSES_ELEMENT) ||
+                (tag == XML_INCORRECT_RESPONSES_ELEMENT))
+            {
+                if (!responseAttributes.hasAttribute(XML_RESPONSE_COUNT_ATTR))
+                    return false;
+                bool ok = false;
+                count = responseAttributes.value(
+                    XML_RESPONSE_COUNT_ATTR).toString().toInt(&ok);
+                if (!ok)
+                    return false;
+            }
+
+            QString word = responseAttributes.value(
+                XML_RESPONSE_WORD_ATTR).toString();
+            if (tag == XML_MISSED_RESPONSES_ELEMENT)
+                tmpProgress.addMissed(word, count);
+            else if (tag == XML_INCORRECT_RESPONSES_ELEMENT)
+                tmpProgress.addIncorrect(word, count);
+            else
+                tmpProgress.addQuestionCorrect(word);
+            reader.skipCurrentElement();
+        }
+    }
+
+    if (reader.hasError())
+        return false;
+
+    *this = tmpProgress;
+    return true;
+}
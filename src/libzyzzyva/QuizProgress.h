@@ -28,6 +28,8 @@
 #include <QDomElement>
 #include <QMap>
 #include <QSet>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 class QuizProgress
 {
@@ -62,6 +64,8 @@ class QuizProgress
 
     QDomElement asDomElement() const;
     bool fromDomElement(const QDomElement& element);
+    void writeXml(QXmlStreamWriter& writer) const;
+    bool readXml(QXmlStreamReader& reader);
 
     private:
     int question;
@@ -25,6 +25,8 @@
 #include "QuizSpec.h"
 #include "Auxil.h"
 #include "Defs.h"
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 using namespace Defs;
 
@@ -51,6 +53,70 @@ const QString XML_TIMER_ELEMENT = "timer";
 const QString XML_TIMER_TIMEOUT_ATTR = "timeout";
 const QString XML_TIMER_PERIOD_ATTR = "period";
 const QString XML_PROGRESS_ELEMENT = "progress";
+const QString XML_DOCTYPE = "<!DOCTYPE zyzzyva-quiz SYSTEM "
+    "\"http://boshvark.com/dtd/zyzzyva-quiz.dtd\">";
+
+//---------------------------------------------------------------------------
+//  writeDomElement
+//
+//! Write a DOM element and its children to an XML stream writer.
+//
+//! @param writer the XML stream writer
+//! @param element the DOM element
+//---------------------------------------------------------------------------
+static void
+writeDomElement(QXmlStreamWriter& writer, const QDomElement& element)
+{
+    writer.writeStartElement(element.tagName());
+    QDomNamedNodeMap attributes = element.attributes();
+    for (int i = 0; i < int(attributes.count()); ++i) {
+        QDomAttr attr = attributes.item(i).toAttr();
+        writer.writeAttribute(attr.name(), attr.value());
+    }
+
+    QDomNode node = element.firstChild();
+    for (; !node.isNull(); node = node.nextSibling()) {
+        if (node.isElement())
+            writeDomElement(writer, node.toElement());
+        else if (node.isText())
+            writer.writeCharacters(node.toText().data());
+    }
+    writer.writeEndElement();
+}
+
+//---------------------------------------------------------------------------
+//  readDomElement
+//
+//! Read an element and its children from an XML stream reader into a DOM
+//! element.  The reader must be at the start of the element, and is left at
+//! its end.
+//
+//! @param reader the XML stream reader
+//! @param document the document to create the element in
+//! @return the DOM element
+//---------------------------------------------------------------------------
+static QDomElement
+readDomElement(QXmlStreamReader& reader, QDomDocument& document)
+{
+    QDomElement element = document.createElement(reader.name().toString());
+    foreach (const QXmlStreamAttribute& attr, reader.attributes())
+        element.setAttribute(attr.name().toString(), attr.value().toString());
+
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement()) {
+            element.appendChild(readDomElement(reader, document));
+        }
+        else if (reader.isCharacters() && !reader.isWhitespace()) {
+            element.appendChild(document.createTextNode(
+                reader.text().toString()));
+        }
+        else if (reader.isEndElement()) {
+            break;
+        }
+    }
+    return element;
+}
 
 //---------------------------------------------------------------------------
 //  asString
@@ -97,6 +163,21 @@ QuizSpec::asXml() const
 //---------------------------------------------------------------------------
 QDomElement
 QuizSpec::asDomElement() const
+{
+    return asDomElement(true);
+}
+
+//---------------------------------------------------------------------------
+//  asDomElement
+//
+//! Return a DOM element representing the quiz spec, with or without the quiz
+//! progress.
+//
+//! @param withProgress whether to include the progress
+//! @return the DOM element
+//---------------------------------------------------------------------------
+QDomElement
+QuizSpec::asDomElement(bool withProgress) const
 {
     QDomDocument doc;
     QDomElement topElement = doc.createElement(XML_TOP_ELEMENT);
@@ -144,7 +225,7 @@ QuizSpec::asDomElement() const
     if (timerSpec.getType() != NoTimer)
         topElement.appendChild(timerSpec.asDomElement());
 
-    if (method != CardboxQuizMethod)
+    if (withProgress && (method != CardboxQuizMethod))
         topElement.appendChild(progress.asDomElement());
 
     return topElement;
@@ -194,7 +275,7 @@ QuizSpec::fromDomElement(const QDomElement& element, QString*)
 
         if (order == ProbabilityOrder) {
             // Default to 2 blanks for backward compatibility
-            int numBlanks = Defs::MAX_BLANKS;
+            int numBlanks = Defs::MAX_STORED_BLANKS;
             if (element.hasAttribute(XML_TOP_PROB_NUM_BLANKS_ATTR)) {
                 bool ok = false;
                 numBlanks = element.attribute(
@@ -323,7 +404,9 @@ QuizSpec::fromDomElement(const QDomElement& element, QString*)
 //  fromXmlFile
 //
 //! Reset the object based on the contents of a file containing an XML
-//! string representing a quiz spec.
+//! string representing a quiz spec.  The file is read with a stream reader,
+//! and the quiz progress, which is most of a saved quiz, is read without
+//! building a DOM for it.
 //
 //! @param file the XML file
 //! @param errStr return an error string
@@ -332,27 +415,83 @@ QuizSpec::fromDomElement(const QDomElement& element, QString*)
 bool
 QuizSpec::fromXmlFile(QFile& file, QString* errStr)
 {
-    QString errorMsg;
-    int errorLine = 0;
-    int errorColumn = 0;
-
+    QXmlStreamReader reader (&file);
     QDomDocument document;
-    bool success = document.setContent(&file, false, &errorMsg, &errorLine,
-                                       &errorColumn);
+    QDomElement topElement;
+    QuizProgress tmpProgress;
+    bool progressOk = true;
+
+    while (!reader.atEnd() && progressOk) {
+        reader.readNext();
+        if (!reader.isStartElement())
+            continue;
+
+        if (topElement.isNull()) {
+            topElement = document.createElement(reader.name().toString());
+            foreach (const QXmlStreamAttribute& attr, reader.attributes()) {
+                topElement.setAttribute(attr.name().toString(),
+                                        attr.value().toString());
+            }
+            document.appendChild(topElement);
+        }
+        else if (reader.name() == XML_PROGRESS_ELEMENT) {
+            progressOk = tmpProgress.readXml(reader);
+        }
+        else {
+            topElement.appendChild(readDomElement(reader, document));
+        }
+    }
 
-    if (!success) {
+    if (reader.hasError()) {
         if (errStr) {
             *errStr = "Error in quiz file, line " +
-                      QString::number(errorLine) + ", column " +
-                      QString::number(errorColumn) + ": " +
-                      errorMsg;
+                      QString::number(reader.lineNumber()) + ", column " +
+                      QString::number(reader.columnNumber()) + ": " +
+                      reader.errorString();
         }
         return false;
     }
 
-    if (!fromDomElement(document.documentElement(), errStr))
+    if (!progressOk || !fromDomElement(topElement, errStr))
         return false;
 
+    progress = tmpProgress;
     filename = file.fileName();
     return true;
 }
+
+//---------------------------------------------------------------------------
+//  writeXmlFile
+//
+//! Write an XML string representing the quiz spec to a device, with a
+//! stream writer, so the quiz progress is written without building a DOM
+//! for it.
+//
+//! @param device the device
+//---------------------------------------------------------------------------
+void
+QuizSpec::writeXmlFile(QIODevice* device) const
+{
+    QXmlStreamWriter writer (device);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeDTD(XML_DOCTYPE);
+
+    QDomElement topElement = asDomElement(false);
+    writer.writeStartElement(topElement.tagName());
+    QDomNamedNodeMap attributes = topElement.attributes();
+    for (int i = 0; i < int(attributes.count()); ++i) {
+        QDomAttr attr = attributes.item(i).toAttr();
+        writer.writeAttribute(attr.name(), attr.value());
+    }
+
+    QDomElement elem = topElement.firstChild().toElement();
+    for (; !elem.isNull(); elem = elem.nextSibling().toElement())
+        writeDomElement(writer, elem);
+
+    if (method != CardboxQuizMethod)
+        progress.writeXml(writer);
+
+    writer.writeEndElement();
+    writer.writeEndDocument();
+}
@@ -77,7 +77,7 @@ class QuizSpec
     QuizSpec() : type(QuizAnagrams), method(StandardQuizMethod),
                  sourceType(SearchSource), questionOrder(RandomOrder),
                  probNumBlanks(0), randomSeed(0), randomSeed2(0),
-                 randomAlgorithm(Rand::MarsagliaMwc),
+                 randomAlgorithm(Rand::Xoshiro128PlusPlus),
                  responseMinLength(0), responseMaxLength(0) { }
     ~QuizSpec() { }
 
@@ -86,6 +86,7 @@ class QuizSpec
     QDomElement asDomElement() const;
     bool fromDomElement(const QDomElement& element, QString* errStr = 0);
     bool fromXmlFile(QFile& file, QString* errStr = 0);
+    void writeXmlFile(QIODevice* device) const;
 
     void setLexicon(const QString& lex) { lexicon = lex; }
     void setType(QuizType t) { type = t; }
@@ -105,6 +106,9 @@ class QuizSpec
 
     void addIncorrect(const QString& word) { progress.addIncorrect(word); }
     void addMissed(const QString& word) { progress.addMissed(word); }
+    void addQuestionCorrect(const QString& word) {
+        progress.addQuestionCorrect(word); }
+    void setNumCorrect(int c) { progress.setCorrect(c); }
 
     QString getLexicon() const { return lexicon; }
     QuizType getType() const { return type; }
@@ -122,6 +126,9 @@ class QuizSpec
     int getResponseMaxLength() const { return responseMaxLength; }
     QString getFilename() const { return filename; }
 
+    private:
+    QDomElement asDomElement(bool withProgress) const;
+
     private:
     QString lexicon;
     QuizType type;
@@ -25,10 +25,18 @@
 #include "QuizStatsDatabase.h"
 #include "MainSettings.h"
 #include "Rand.h"
+#include "Trace.h"
 #include "Auxil.h"
 #include <QDir>
+#include <QFileInfo>
+#include <QMutex>
 #include <QSqlQuery>
+#include <QThread>
 #include <QVariant>
+#include <QWaitCondition>
+#include <QPair>
+#include <QSet>
+#include <QtAlgorithms>
 #include <ctime>
 
 #include <QSqlError>
@@ -43,6 +51,345 @@ const QString SQL_CREATE_QUESTIONS_TABLE_CURRENT =
     "incorrect integer, streak integer, last_correct integer, "
     "difficulty integer, cardbox integer, next_scheduled integer)";
 
+// The compact schema keeps each question once, in a dictionary of question
+// names, and keys the statistics of the questions by their integer IDs.
+// The IDs are the row IDs of the statistics, so the rows are stored in ID
+// order, and the schedule index covers the scheduling queries.
+const char* const SQL_CREATE_COMPACT_TABLES[] = {
+    "CREATE TABLE question_names (id integer PRIMARY KEY, question text)",
+    "CREATE UNIQUE INDEX question_name_index ON question_names (question)",
+    "CREATE TABLE question_stats (id integer PRIMARY KEY, correct integer, "
+        "incorrect integer, streak integer, last_correct integer, "
+        "difficulty integer, cardbox integer, next_scheduled integer)",
+    "CREATE INDEX question_schedule_index ON question_stats "
+        "(cardbox, next_scheduled)"
+};
+const int NUM_CREATE_COMPACT_TABLES =
+    sizeof(SQL_CREATE_COMPACT_TABLES) / sizeof(SQL_CREATE_COMPACT_TABLES[0]);
+
+// The columns of the questions of a compact database, as in the questions
+// table, with %1 replaced by the name of the database
+const QString SQL_COMPACT_QUESTIONS =
+    "(SELECT n.question AS question, s.correct AS correct, "
+    "s.incorrect AS incorrect, s.streak AS streak, "
+    "s.last_correct AS last_correct, s.difficulty AS difficulty, "
+    "s.cardbox AS cardbox, s.next_scheduled AS next_scheduled "
+    "FROM %1.question_stats s JOIN %1.question_names n ON n.id = s.id)";
+
+// The merged columns of a question found in the other database as o and
+// possibly in this database as m.  Counts are summed, the streak is taken
+// from the side answered correctly most recently, and the cardbox and
+// schedule are taken from the side scheduled earliest, or from the side
+// that is scheduled at all.
+const QString SQL_MERGE_COLUMNS =
+    "IFNULL(m.correct, 0) + IFNULL(o.correct, 0), "
+    "IFNULL(m.incorrect, 0) + IFNULL(o.incorrect, 0), "
+    "CASE WHEN m.streak IS NULL OR "
+    "IFNULL(o.last_correct, 0) > IFNULL(m.last_correct, 0) "
+    "THEN o.streak ELSE m.streak END, "
+    "MAX(IFNULL(m.last_correct, 0), IFNULL(o.last_correct, 0)), "
+    "IFNULL(m.difficulty, o.difficulty), "
+    "CASE WHEN m.next_scheduled IS NULL OR "
+    "o.next_scheduled < m.next_scheduled "
+    "THEN o.cardbox ELSE m.cardbox END, "
+    "CASE WHEN m.next_scheduled IS NULL OR "
+    "o.next_scheduled < m.next_scheduled "
+    "THEN o.next_scheduled ELSE m.next_scheduled END ";
+
+// Merge the questions of another database, given as %1, into the tables of
+// this database in one pass
+const QString SQL_MERGE_QUESTIONS =
+    "INSERT OR REPLACE INTO main.questions (question, correct, incorrect, "
+    "streak, last_correct, difficulty, cardbox, next_scheduled) "
+    "SELECT o.question, " + SQL_MERGE_COLUMNS +
+    "FROM %1 o LEFT JOIN main.questions m ON m.question = o.question";
+const QString SQL_MERGE_COMPACT_NAMES =
+    "INSERT OR IGNORE INTO main.question_names (question) "
+    "SELECT question FROM %1";
+const QString SQL_MERGE_COMPACT_QUESTIONS =
+    "INSERT OR REPLACE INTO main.question_stats (id, correct, incorrect, "
+    "streak, last_correct, difficulty, cardbox, next_scheduled) "
+    "SELECT n.id, " + SQL_MERGE_COLUMNS +
+    "FROM %1 o JOIN main.question_names n ON n.question = o.question "
+    "LEFT JOIN main.question_stats m ON m.id = n.id";
+
+const QString MERGE_DB_NAME = "merged";
+
+// Number of free pages a compact database gives back to the file system
+// after each write by the writer thread
+const int INCREMENTAL_VACUUM_PAGES = 64;
+
+// Number of questions whose data is held before it is written to the
+// database even if the database is not flushed
+const int MAX_PENDING_QUESTIONS = 100;
+
+// The SQL of the statements kept prepared on each connection, in the order
+// of QuizStatsDatabase::Statements::Statement
+const char* const STATEMENT_SQL[] = {
+    "UPDATE questions SET correct=?, incorrect=?, streak=?, "
+        "last_correct=?, difficulty=? WHERE question=?",
+    "UPDATE questions SET correct=?, incorrect=?, streak=?, "
+        "last_correct=?, difficulty=?, cardbox=?, next_scheduled=? "
+        "WHERE question=?",
+    "INSERT INTO questions (question, correct, incorrect, streak, "
+        "last_correct, difficulty) VALUES (?, ?, ?, ?, ?, ?)",
+    "INSERT INTO questions (question, correct, incorrect, streak, "
+        "last_correct, difficulty, cardbox, next_scheduled) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
+    "UPDATE questions SET cardbox=?, next_scheduled=? WHERE question=?",
+    "INSERT INTO questions (question, correct, incorrect, streak, "
+        "last_correct, difficulty, cardbox, next_scheduled) "
+        "VALUES (?, 0, 0, 0, 0, 0, ?, ?)",
+    "UPDATE questions SET cardbox=NULL, next_scheduled=NULL "
+        "WHERE question=?",
+    "UPDATE questions SET next_scheduled=? WHERE question=?",
+    "UPDATE questions SET next_scheduled=next_scheduled+? "
+        "WHERE cardbox NOT NULL",
+    0
+};
+
+// The statements of STATEMENT_SQL for the compact schema.  A question is
+// added to the dictionary of question names before its statistics are
+// inserted, and every statement finds the question by name as before.
+const char* const COMPACT_STATEMENT_SQL[] = {
+    "UPDATE question_stats SET correct=?, incorrect=?, streak=?, "
+        "last_correct=?, difficulty=? "
+        "WHERE id=(SELECT id FROM question_names WHERE question=?)",
+    "UPDATE question_stats SET correct=?, incorrect=?, streak=?, "
+        "last_correct=?, difficulty=?, cardbox=?, next_scheduled=? "
+        "WHERE id=(SELECT id FROM question_names WHERE question=?)",
+    "INSERT INTO question_stats (id, correct, incorrect, streak, "
+        "last_correct, difficulty) "
+        "VALUES ((SELECT id FROM question_names WHERE question=?), "
+        "?, ?, ?, ?, ?)",
+    "INSERT INTO question_stats (id, correct, incorrect, streak, "
+        "last_correct, difficulty, cardbox, next_scheduled) "
+        "VALUES ((SELECT id FROM question_names WHERE question=?), "
+        "?, ?, ?, ?, ?, ?, ?)",
+    "UPDATE question_stats SET cardbox=?, next_scheduled=? "
+        "WHERE id=(SELECT id FROM question_names WHERE question=?)",
+    "INSERT INTO question_stats (id, correct, incorrect, streak, "
+        "last_correct, difficulty, cardbox, next_scheduled) "
+        "VALUES ((SELECT id FROM question_names WHERE question=?), "
+        "0, 0, 0, 0, 0, ?, ?)",
+    "UPDATE question_stats SET cardbox=NULL, next_scheduled=NULL "
+        "WHERE id=(SELECT id FROM question_names WHERE question=?)",
+    "UPDATE question_stats SET next_scheduled=? "
+        "WHERE id=(SELECT id FROM question_names WHERE question=?)",
+    "UPDATE question_stats SET next_scheduled=next_scheduled+? "
+        "WHERE cardbox NOT NULL",
+    "INSERT OR IGNORE INTO question_names (question) VALUES (?)"
+};
+
+//---------------------------------------------------------------------------
+//  scheduleDay
+//
+//! Determine the number of days from now a question is scheduled for, as
+//! the SQL expression round((next_scheduled - 43200.0 - now) / 86400)
+//! computes it, rounding halves away from zero.
+//
+//! @param nextScheduled the scheduled time of the question
+//! @param now the current time
+//! @return the number of days
+//---------------------------------------------------------------------------
+static int
+scheduleDay(qint32 nextScheduled, unsigned int now)
+{
+    double days = (nextScheduled - 43200.0 - now) / 86400;
+    return int(days + ((days < 0) ? -0.5 : 0.5));
+}
+
+// Orders scheduled times by the day they fall on, for finding the range of
+// sorted times that fall on one day
+class ScheduleDayLessThan
+{
+    public:
+    ScheduleDayLessThan(unsigned int n) : now(n) { }
+    bool operator()(qint32 a, qint32 b) const {
+        return scheduleDay(a, now) < scheduleDay(b, now); }
+
+    private:
+    unsigned int now;
+};
+
+//---------------------------------------------------------------------------
+//  Statements
+//
+//! The prepared statements used on one database connection.  Each
+//! statement is prepared the first time it is used and kept until the
+//! statements are destroyed, which must happen before the connection is
+//! closed.
+//---------------------------------------------------------------------------
+class QuizStatsDatabase::Statements
+{
+    public:
+    enum Statement {
+        UpdateStatsStatement = 0,
+        UpdateStatsCardboxStatement,
+        InsertStatsStatement,
+        InsertStatsCardboxStatement,
+        UpdateCardboxStatement,
+        InsertCardboxStatement,
+        RemoveCardboxStatement,
+        UpdateNextScheduledStatement,
+        ShiftNextScheduledStatement,
+        InsertNameStatement,
+        NumStatements
+    };
+
+    Statements(const QSqlDatabase& d, bool c = false)
+        : database(d), compact(c) {
+        for (int i = 0; i < NumStatements; ++i)
+            queries[i] = 0;
+    }
+    ~Statements() {
+        for (int i = 0; i < NumStatements; ++i)
+            delete queries[i];
+    }
+
+    // Choose the schema the statements are for, before any is prepared
+    void setCompact(bool c) { compact = c; }
+    bool isCompact() const { return compact; }
+
+    QSqlQuery* get(Statement statement) {
+        QSqlQuery*& query = queries[statement];
+        if (!query) {
+            query = new QSqlQuery(database);
+            query->prepare(compact ? COMPACT_STATEMENT_SQL[statement]
+                                   : STATEMENT_SQL[statement]);
+        }
+        return query;
+    }
+
+    // Add a question to the dictionary of question names of a compact
+    // database, so its statistics can be inserted
+    void insertName(const QString& question) {
+        if (!compact)
+            return;
+        QSqlQuery* query = get(InsertNameStatement);
+        query->bindValue(0, question);
+        query->exec();
+    }
+
+    private:
+    QSqlDatabase database;
+    bool compact;
+    QSqlQuery* queries[NumStatements];
+};
+
+//---------------------------------------------------------------------------
+//  WriterThread
+//
+//! A thread that writes question data to the database with its own
+//! connection, so responses are saved without waiting for the disk.  The
+//! thread waits for data until it is stopped, and writes all data it has
+//! been given before stopping.  The free pages of a compact database are
+//! given back a few at a time after each write, so the file shrinks
+//! without a full vacuum.
+//---------------------------------------------------------------------------
+class QuizStatsDatabase::WriterThread : public QThread
+{
+    public:
+    WriterThread(const QString& f, const QString& c, bool cs)
+        : QThread(), filename(f), connectionName(c), compact(cs),
+          busy(false), stopping(false) { }
+    ~WriterThread() { }
+
+    // Add question data to be written, replacing any data for the same
+    // questions that has not been written yet
+    void write(const QHash<QString, PendingData>& data) {
+        QMutexLocker locker (&mutex);
+        QHashIterator<QString, PendingData> it (data);
+        while (it.hasNext()) {
+            it.next();
+            PendingData& pending = pendingData[it.key()];
+            pending.data = it.value().data;
+            pending.updateCardbox = pending.updateCardbox ||
+                it.value().updateCardbox;
+        }
+        changed.wakeAll();
+    }
+
+    // Wait until all question data given to the thread has been written
+    void waitForWrites() {
+        QMutexLocker locker (&mutex);
+        while (busy || !pendingData.isEmpty())
+            idle.wait(&mutex);
+    }
+
+    void stop() {
+        QMutexLocker locker (&mutex);
+        stopping = true;
+        changed.wakeAll();
+    }
+
+    protected:
+    void run() {
+        {
+            QSqlDatabase writerDb =
+                QSqlDatabase::addDatabase("QSQLITE", connectionName);
+            writerDb.setDatabaseName(filename);
+            bool ok = writerDb.open();
+
+            // The statements are destroyed before the connection is closed
+            {
+                Statements statements (writerDb, compact);
+                QMutexLocker locker (&mutex);
+                forever {
+                    if (pendingData.isEmpty()) {
+                        if (stopping)
+                            break;
+                        changed.wait(&mutex);
+                        continue;
+                    }
+
+                    QHash<QString, PendingData> data = pendingData;
+                    pendingData.clear();
+                    busy = true;
+                    locker.unlock();
+
+                    if (ok) {
+                        Z_TRACE_SCOPE(
+                            "QuizStatsDatabase::WriterThread write");
+                        QSqlQuery query (writerDb);
+                        query.exec("BEGIN TRANSACTION");
+                        QHashIterator<QString, PendingData> it (data);
+                        while (it.hasNext()) {
+                            it.next();
+                            writeQuestionData(statements, it.key(),
+                                              it.value().data,
+                                              it.value().updateCardbox);
+                        }
+                        query.exec("COMMIT TRANSACTION");
+                        if (compact) {
+                            query.exec("PRAGMA incremental_vacuum(" +
+                                QString::number(INCREMENTAL_VACUUM_PAGES) +
+                                ")");
+                        }
+                    }
+
+                    locker.relock();
+                    busy = false;
+                    idle.wakeAll();
+                }
+            }
+            writerDb.close();
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+
+    private:
+    QString filename;
+    QString connectionName;
+    bool compact;
+    QHash<QString, PendingData> pendingData;
+    bool busy;
+    bool stopping;
+    QMutex mutex;
+    QWaitCondition changed;
+    QWaitCondition idle;
+};
+
 //---------------------------------------------------------------------------
 //  QuizStatsDatabase
 //
@@ -54,7 +401,7 @@ const QString SQL_CREATE_QUESTIONS_TABLE_CURRENT =
 //---------------------------------------------------------------------------
 QuizStatsDatabase::QuizStatsDatabase(const QString& lexicon,
     const QString& quizType)
-    : db(0)
+    : db(0), statements(0), writerThread(0), questionsLoaded(false)
 {
     QString dirName = Auxil::getQuizDir() + "/data/" + lexicon;
     QDir dir (dirName);
@@ -65,16 +412,25 @@ QuizStatsDatabase::QuizStatsDatabase(const QString& lexicon,
 
     QString dbFilename = dirName + "/" + quizType + ".db";
 
-    // Get random connection name
+    // Get random connection name, made unique by the address of the
+    // database, since databases opened in the same second get the same
+    // random number
     rng.srand(QDateTime::currentDateTime().toTime_t(), Auxil::getPid());
     unsigned int r = rng.rand();
-    dbConnectionName = "quiz" + QString::number(r);
+    dbConnectionName = "quiz" + QString::number(r) + "_" +
+        QString::number(quintptr(this));
     db = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE",
                                                     dbConnectionName));
     db->setDatabaseName(dbFilename);
+    statements = new Statements(*db);
     if (!db->open())
         return;
 
+    // Write-ahead logging lets questions be read while the writer thread
+    // is writing
+    QSqlQuery query (*db);
+    query.exec("PRAGMA journal_mode=WAL");
+
     updateSchema();
 }
 
@@ -85,6 +441,16 @@ QuizStatsDatabase::QuizStatsDatabase(const QString& lexicon,
 //---------------------------------------------------------------------------
 QuizStatsDatabase::~QuizStatsDatabase()
 {
+    sync();
+    if (writerThread) {
+        writerThread->stop();
+        writerThread->wait();
+        delete writerThread;
+    }
+
+    delete statements;
+    statements = 0;
+
     if (db) {
         if (db->isOpen())
             db->close();
@@ -117,11 +483,15 @@ QuizStatsDatabase::isValid() const
 bool
 QuizStatsDatabase::updateSchema()
 {
+    // A compact database has the latest schema, and is never converted back
+    if (hasTable("main", "question_stats")) {
+        statements->setCompact(true);
+        return true;
+    }
+
     // Create table if it doesn't already exist
     QSqlQuery query (*db);
-    query.exec("SELECT name FROM sqlite_master WHERE type='table' "
-               "AND name='questions'");
-    if (!query.next()) {
+    if (!hasTable("main", "questions")) {
         query.exec(SQL_CREATE_QUESTIONS_TABLE_CURRENT);
     }
 
@@ -149,13 +519,95 @@ QuizStatsDatabase::updateSchema()
                    "(question)");
     }
 
+    // Create index on the schedule columns of questions table
+    query.exec("SELECT name FROM sqlite_master WHERE type='index' "
+               "AND name='schedule_index' AND tbl_name='questions'");
+    if (!query.next()) {
+        query.exec("CREATE INDEX schedule_index ON questions "
+                   "(next_scheduled, cardbox)");
+    }
+
+    // A database that cannot be converted keeps the questions table
+    if (MainSettings::getQuizCompactStats())
+        compactQuestions();
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  hasTable
+//
+//! Determine whether a database attached to the connection has a table.
+//
+//! @param dbName the name of the attached database
+//! @param table the name of the table
+//! @return true if the table exists, false otherwise
+//---------------------------------------------------------------------------
+bool
+QuizStatsDatabase::hasTable(const QString& dbName, const QString& table)
+    const
+{
+    QSqlQuery query (*db);
+    query.prepare("SELECT name FROM " + dbName + ".sqlite_master "
+                  "WHERE type='table' AND name=?");
+    query.bindValue(0, table);
+    query.exec();
+    return query.next();
+}
+
+//---------------------------------------------------------------------------
+//  compactQuestions
+//
+//! Convert the questions table to the compact schema.  The question names
+//! and statistics keep the row IDs of the questions, so the order of the
+//! questions is unchanged.  The file is then rebuilt without the free
+//! pages of the old table, and with incremental vacuuming turned on so the
+//! writer thread can give back the pages freed later.
+//
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+QuizStatsDatabase::compactQuestions()
+{
+    Z_TRACE_SCOPE("QuizStatsDatabase::compactQuestions");
+    QSqlQuery query (*db);
+    query.exec("BEGIN TRANSACTION");
+    bool ok = true;
+    for (int i = 0; ok && (i < NUM_CREATE_COMPACT_TABLES); ++i)
+        ok = query.exec(SQL_CREATE_COMPACT_TABLES[i]);
+    ok = ok && query.exec("INSERT INTO question_names (id, question) "
+                          "SELECT rowid, question FROM questions");
+    ok = ok && query.exec("INSERT INTO question_stats (id, correct, "
+                          "incorrect, streak, last_correct, difficulty, "
+                          "cardbox, next_scheduled) "
+                          "SELECT rowid, correct, incorrect, streak, "
+                          "last_correct, difficulty, cardbox, "
+                          "next_scheduled FROM questions");
+    ok = ok && query.exec("DROP TABLE questions");
+    if (!ok) {
+        qDebug("Cannot compact quiz stats: %s",
+               query.lastError().text().toUtf8().constData());
+        query.exec("ROLLBACK TRANSACTION");
+        return false;
+    }
+    query.exec("COMMIT TRANSACTION");
+
+    // Auto-vacuuming can only be turned on by a vacuum, which cannot run in
+    // write-ahead logging mode
+    query.exec("PRAGMA journal_mode=DELETE");
+    query.exec("PRAGMA auto_vacuum=INCREMENTAL");
+    query.exec("VACUUM");
+    query.exec("PRAGMA journal_mode=WAL");
+
+    statements->setCompact(true);
     return true;
 }
 
 //---------------------------------------------------------------------------
 //  recordResponse
 //
-//! Record a correct or incorrect question response.
+//! Record a correct or incorrect question response.  The response is
+//! written to the database when the database is next flushed.
 //
 //! @param question the question
 //! @param correct whether the response was correct
@@ -165,6 +617,7 @@ void
 QuizStatsDatabase::recordResponse(const QString& question, bool correct,
                              bool updateCardbox)
 {
+    Z_TRACE_SCOPE("QuizStatsDatabase::recordResponse");
     QuestionData data = getQuestionData(question);
     undoQuestion = question;
     undoData = data;
@@ -207,7 +660,7 @@ QuizStatsDatabase::recordResponse(const QString& question, bool correct,
         }
     }
 
-    setQuestionData(question, data, updateCardbox);
+    queueQuestionData(question, data, updateCardbox);
 }
 
 //---------------------------------------------------------------------------
@@ -218,10 +671,11 @@ QuizStatsDatabase::recordResponse(const QString& question, bool correct,
 void
 QuizStatsDatabase::undoLastResponse(const QString& question)
 {
+    Z_TRACE_SCOPE("QuizStatsDatabase::undoLastResponse");
     if (undoQuestion != question)
         return;
 
-    setQuestionData(question, undoData, true);
+    queueQuestionData(question, undoData, true);
 }
 
 //---------------------------------------------------------------------------
@@ -240,13 +694,60 @@ void
 QuizStatsDatabase::addToCardbox(const QStringList& questions,
     bool estimateCardbox, int cardbox)
 {
-    QSqlQuery query (*db);
-    query.exec("BEGIN TRANSACTION");
-    QStringListIterator it (questions);
-    while (it.hasNext()) {
-        addToCardbox(it.next(), estimateCardbox, cardbox);
+    Z_TRACE_SCOPE("QuizStatsDatabase::addToCardbox");
+    sync();
+    loadQuestions();
+
+    // Only the cardbox columns of questions already in the table change, so
+    // every question is written with one of two prepared statements
+    QSqlQuery* updateQuery =
+        statements->get(Statements::UpdateCardboxStatement);
+    QSqlQuery* insertQuery =
+        statements->get(Statements::InsertCardboxStatement);
+
+    QSqlQuery transactionQuery ("BEGIN TRANSACTION", *db);
+
+    foreach (const QString& question, questions) {
+        CachedQuestion* cached = findCachedQuestion(question);
+
+        // Question is already in the cardbox system, so leave it alone
+        if (cached && (cached->cardbox >= 0))
+            continue;
+
+        int questionCardbox = cardbox;
+        if (cached && estimateCardbox && (cached->streak > 0))
+            questionCardbox = cached->streak;
+
+        // Move scheduled time back by 16 hours, so questions in cardbox 0
+        // will be available immediately
+        int nextScheduled = calculateNextScheduled(questionCardbox);
+        if (!questionCardbox)
+            nextScheduled -= 60 * 60 * 16;
+
+        if (cached) {
+            updateQuery->bindValue(0, questionCardbox);
+            updateQuery->bindValue(1, nextScheduled);
+            updateQuery->bindValue(2, question);
+            updateQuery->exec();
+
+            setCachedSchedule(*cached, questionCardbox, true, nextScheduled);
+        }
+        else {
+            statements->insertName(question);
+            insertQuery->bindValue(0, question);
+            insertQuery->bindValue(1, questionCardbox);
+            insertQuery->bindValue(2, nextScheduled);
+            insertQuery->exec();
+
+            QuestionData data;
+            data.valid = true;
+            data.cardbox = questionCardbox;
+            data.nextScheduled = nextScheduled;
+            cacheQuestionData(question, data, true);
+        }
     }
-    query.exec("COMMIT TRANSACTION");
+
+    transactionQuery.exec("END TRANSACTION");
 }
 
 //---------------------------------------------------------------------------
@@ -265,6 +766,7 @@ void
 QuizStatsDatabase::addToCardbox(const QString& question, bool estimateCardbox,
     int cardbox)
 {
+    sync();
     QuestionData data = getQuestionData(question);
 
     if (data.valid) {
@@ -304,18 +806,23 @@ QuizStatsDatabase::addToCardbox(const QString& question, bool estimateCardbox,
 void
 QuizStatsDatabase::removeFromCardbox(const QStringList& questions)
 {
-    QStringList qlist;
-    QStringListIterator it (questions);
-    while (it.hasNext()) {
-        qlist.append("'" + it.next() + "'");
+    Z_TRACE_SCOPE("QuizStatsDatabase::removeFromCardbox");
+    sync();
+
+    QSqlQuery* removeQuery =
+        statements->get(Statements::RemoveCardboxStatement);
+    QSqlQuery transactionQuery ("BEGIN TRANSACTION", *db);
+
+    foreach (const QString& question, questions) {
+        removeQuery->bindValue(0, question);
+        removeQuery->exec();
+
+        CachedQuestion* cached = findCachedQuestion(question);
+        if (cached)
+            setCachedSchedule(*cached, -1, false, 0);
     }
-    QString queryStr = "UPDATE questions SET cardbox=NULL, "
-        "next_scheduled=NULL WHERE question IN (" +
-        qlist.join(", ") + ")";
 
-    QSqlQuery query (*db);
-    query.prepare(queryStr);
-    query.exec();
+    transactionQuery.exec("END TRANSACTION");
 }
 
 //---------------------------------------------------------------------------
@@ -349,7 +856,7 @@ QuizStatsDatabase::setCardbox(const QString& question, int cardbox)
     data.valid = true;
     data.cardbox = cardbox;
     data.nextScheduled = calculateNextScheduled(data.cardbox);
-    setQuestionData(question, data, true);
+    queueQuestionData(question, data, true);
 }
 
 //---------------------------------------------------------------------------
@@ -363,57 +870,22 @@ QuizStatsDatabase::setCardbox(const QString& question, int cardbox)
 int
 QuizStatsDatabase::rescheduleCardbox(const QStringList& questions)
 {
-    QString queryStr = "SELECT question, cardbox, next_scheduled "
-        "FROM questions WHERE cardbox NOT NULL";
-
-    if (!questions.isEmpty()) {
-        queryStr += " AND question IN (";
-        QStringListIterator it (questions);
-        bool firstItem = true;
-        while (it.hasNext()) {
-            QString question = it.next();
-            if (!firstItem)
-                queryStr += ", ";
-            queryStr += "'" + question + "'";
-            firstItem = false;
-        }
-        queryStr += ")";
-    }
-
-    QSqlQuery query (*db);
-    query.prepare(queryStr);
-    query.exec();
-
-    QList<QString> selectedQuestions;
-    QList<int> selectedCardboxes;
+    Z_TRACE_SCOPE("QuizStatsDatabase::rescheduleCardbox");
+    sync();
 
-    while (query.next()) {
-        selectedQuestions.append(query.value(0).toString());
-        selectedCardboxes.append(query.value(1).toInt());
-    }
-
-    QSqlQuery updateQuery (*db);
-    updateQuery.prepare("UPDATE questions SET next_scheduled=? "
-                        "WHERE question=?");
-
-    QSqlQuery transactionQuery ("BEGIN TRANSACTION", *db);
-
-    QListIterator<QString> it (selectedQuestions);
-    QListIterator<int> jt (selectedCardboxes);
-    while (it.hasNext()) {
-        QString question = it.next();
-        int cardbox = jt.next();
-        int nextScheduled = calculateNextScheduled(cardbox);
-        nextScheduled -= 60 * 60 * 16;
-
-        updateQuery.bindValue(0, nextScheduled);
-        updateQuery.bindValue(1, question);
-        updateQuery.exec();
+    QVector<int> ids;
+    foreach (int id, findCachedIds(questions)) {
+        CachedQuestion& cached = cachedQuestions[id];
+        if (cached.cardbox < 0)
+            continue;
+        int nextScheduled = calculateNextScheduled(cached.cardbox) -
+            60 * 60 * 16;
+        setCachedSchedule(cached, cached.cardbox, true, nextScheduled);
+        ids.append(id);
     }
 
-    transactionQuery.exec("END TRANSACTION");
-
-    return selectedQuestions.size();
+    writeNextScheduled(ids);
+    return ids.size();
 }
 
 //---------------------------------------------------------------------------
@@ -431,66 +903,43 @@ int
 QuizStatsDatabase::shiftCardboxByBacklog(const QStringList& questions,
     int desiredBacklog)
 {
-    QString queryStr = "SELECT question, next_scheduled "
-        "FROM questions WHERE cardbox NOT NULL";
-
-    if (!questions.isEmpty()) {
-        queryStr += " AND question IN (";
-        QStringListIterator it (questions);
-        bool firstItem = true;
-        while (it.hasNext()) {
-            QString question = it.next();
-            if (!firstItem)
-                queryStr += ", ";
-            queryStr += "'" + question + "'";
-            firstItem = false;
-        }
-        queryStr += ")";
+    Z_TRACE_SCOPE("QuizStatsDatabase::shiftCardboxByBacklog");
+    sync();
+
+    // Order the questions by scheduled time, as the query "SELECT question
+    // FROM questions WHERE cardbox NOT NULL ORDER BY next_scheduled" would
+    QVector<QPair<qint64, int> > selected;
+    foreach (int id, findCachedIds(questions)) {
+        const CachedQuestion& cached = cachedQuestions[id];
+        if (cached.cardbox < 0)
+            continue;
+        qint64 key = cached.scheduled ? qint64(cached.nextScheduled)
+                                      : Q_INT64_C(-0x100000000);
+        selected.append(qMakePair(key, id));
     }
+    qSort(selected);
 
-    queryStr += " ORDER BY next_scheduled";
-
-    QSqlQuery query (*db);
-    query.prepare(queryStr);
-    query.exec();
-
-    QList<QString> selectedQuestions;
-    QList<int> selectedNextScheduled;
-
-    int index = 1;
+    // Peg the last question of the desired backlog to the current time
     int pegNextScheduled = 0;
-    while (query.next()) {
-        QString question = query.value(0).toString();
-        int nextScheduled = query.value(1).toInt();
-        selectedQuestions.append(question);
-        selectedNextScheduled.append(nextScheduled);
-        if (index <= desiredBacklog)
-            pegNextScheduled = nextScheduled;
-        ++index;
+    int pegIndex = qMin(desiredBacklog, selected.size()) - 1;
+    if (pegIndex >= 0) {
+        int pegId = selected[pegIndex].second;
+        pegNextScheduled = cachedQuestions[pegId].nextScheduled;
     }
 
     unsigned int now = QDateTime::currentDateTime().toTime_t();
     int shiftSeconds = now - pegNextScheduled;
 
-    QSqlQuery updateQuery (*db);
-    updateQuery.prepare("UPDATE questions SET next_scheduled=? "
-                        "WHERE question=?");
-
-    QSqlQuery transactionQuery ("BEGIN TRANSACTION", *db);
-
-    QListIterator<QString> it (selectedQuestions);
-    QListIterator<int> jt (selectedNextScheduled);
-    while (it.hasNext()) {
-        QString question = it.next();
-        int nextScheduled = jt.next() + shiftSeconds;
-        updateQuery.bindValue(0, nextScheduled);
-        updateQuery.bindValue(1, question);
-        updateQuery.exec();
+    QVector<int> ids (selected.size());
+    for (int i = 0; i < selected.size(); ++i) {
+        CachedQuestion& cached = cachedQuestions[selected[i].second];
+        setCachedSchedule(cached, cached.cardbox, true,
+                          cached.nextScheduled + shiftSeconds);
+        ids[i] = selected[i].second;
     }
 
-    transactionQuery.exec("END TRANSACTION");
-
-    return selectedQuestions.size();
+    writeNextScheduled(ids);
+    return ids.size();
 }
 
 //---------------------------------------------------------------------------
@@ -507,29 +956,33 @@ int
 QuizStatsDatabase::shiftCardboxByDays(const QStringList& questions,
     int numDays)
 {
-    QString questionClause;
-    if (!questions.isEmpty()) {
-        questionClause = " AND question IN (";
-        bool firstItem = true;
-        foreach (const QString& question, questions) {
-            if (!firstItem)
-                questionClause += ", ";
-            questionClause += "'" + question + "'";
-            firstItem = false;
-        }
-        questionClause += ")";
-    }
-
+    Z_TRACE_SCOPE("QuizStatsDatabase::shiftCardboxByDays");
     int shiftSeconds = 86400 * numDays;
 
-    QSqlQuery updateQuery (*db);
-    updateQuery.prepare(QString("UPDATE questions set next_scheduled="
-        "next_scheduled+? WHERE cardbox NOT NULL%1").arg(questionClause));
-    updateQuery.bindValue(0, shiftSeconds);
-    if (!updateQuery.exec())
-        return 0;
+    sync();
+
+    QVector<int> ids;
+    foreach (int id, findCachedIds(questions)) {
+        CachedQuestion& cached = cachedQuestions[id];
+        if ((cached.cardbox < 0) || !cached.scheduled)
+            continue;
+        setCachedSchedule(cached, cached.cardbox, true,
+                          cached.nextScheduled + shiftSeconds);
+        ids.append(id);
+    }
+
+    // All questions are shifted with a single update
+    if (questions.isEmpty()) {
+        QSqlQuery* shiftQuery =
+            statements->get(Statements::ShiftNextScheduledStatement);
+        shiftQuery->bindValue(0, shiftSeconds);
+        if (!shiftQuery->exec())
+            return 0;
+        return shiftQuery->numRowsAffected();
+    }
 
-    return updateQuery.numRowsAffected();
+    writeNextScheduled(ids);
+    return ids.size();
 }
 
 //---------------------------------------------------------------------------
@@ -549,29 +1002,30 @@ QuizStatsDatabase::getReadyQuestions(const QStringList& questions,
 {
     unsigned int now = QDateTime::currentDateTime().toTime_t();
 
-    bool selectAll = questions.isEmpty();
-    QSet<QString> questionSet = questions.toSet();
-
-    QString zQueryStr = zeroFirst ? QString(" OR cardbox = 0") : QString();
-    QString queryStr = "SELECT question, cardbox FROM questions WHERE "
-        "next_scheduled <= " + QString::number(now) + zQueryStr +
-        " ORDER BY next_scheduled";
+    // Select questions as the query "SELECT question FROM questions WHERE
+    // next_scheduled <= now [OR cardbox = 0] ORDER BY next_scheduled" would,
+    // with NULL times first and questions of equal time in table order.
+    // Only the rows of the parameter questions are examined, if any.
+    QVector<int> ids = findCachedIds(questions);
+    QVector<QPair<qint64, int> > ready;
+    foreach (int i, ids) {
+        const CachedQuestion& cached = cachedQuestions[i];
+        bool due = cached.scheduled && (cached.nextScheduled <= qint64(now));
+        if (!due && !(zeroFirst && (cached.cardbox == 0)))
+            continue;
 
-    QSqlQuery query (*db);
-    query.prepare(queryStr);
-    query.exec();
+        qint64 key = cached.scheduled ? qint64(cached.nextScheduled)
+                                      : Q_INT64_C(-0x100000000);
+        ready.append(qMakePair(key, i));
+    }
+    qSort(ready);
 
     QStringList zeroQuestions;
     QStringList readyQuestions;
-    while (query.next()) {
-        const QString& question = query.value(0).toString();
-
-        // Skip questions that weren't in the parameter question list
-        if (!selectAll && !questionSet.contains(question))
-            continue;
-
-        int cardbox = query.value(1).toInt();
-        if (zeroFirst && (cardbox == 0))
+    for (int i = 0; i < ready.size(); ++i) {
+        int id = ready[i].second;
+        const QString& question = cachedNames[id];
+        if (zeroFirst && (cachedQuestions[id].cardbox == 0))
             zeroQuestions.append(question);
         else
             readyQuestions.append(question);
@@ -580,10 +1034,41 @@ QuizStatsDatabase::getReadyQuestions(const QStringList& questions,
     return zeroFirst ? zeroQuestions + readyQuestions : readyQuestions;
 }
 
+//---------------------------------------------------------------------------
+//  getScheduledQuestions
+//
+//! Get the cardbox and next scheduled time of every question in the
+//! cardbox system, whether or not it is ready for review.
+//
+//! @return the data of each question, with only the cardbox and next
+//! scheduled time filled in
+//---------------------------------------------------------------------------
+QMap<QString, QuizStatsDatabase::QuestionData>
+QuizStatsDatabase::getScheduledQuestions()
+{
+    QMap<QString, QuestionData> scheduled;
+
+    loadQuestions();
+    for (int i = 0; i < cachedQuestions.size(); ++i) {
+        const CachedQuestion& cached = cachedQuestions[i];
+        if ((cached.cardbox < 0) || !cached.scheduled)
+            continue;
+
+        QuestionData data;
+        data.valid = true;
+        data.cardbox = cached.cardbox;
+        data.nextScheduled = cached.nextScheduled;
+        scheduled.insert(cachedNames[i], data);
+    }
+
+    return scheduled;
+}
+
 //---------------------------------------------------------------------------
 //  getQuestionData
 //
-//! Retrieve information about a question from the database.
+//! Retrieve information about a question from the database, including
+//! responses not yet written to the database.
 //
 //! @param question the question
 //! @return the associated data
@@ -591,44 +1076,22 @@ QuizStatsDatabase::getReadyQuestions(const QStringList& questions,
 QuizStatsDatabase::QuestionData
 QuizStatsDatabase::getQuestionData(const QString& question)
 {
-    QuestionData data;
-
-    QSqlQuery query (*db);
-    query.prepare("SELECT correct, incorrect, streak, last_correct, "
-                  "difficulty, cardbox, next_scheduled "
-                  "FROM questions WHERE question=?");
-    query.bindValue(0, question);
-    query.exec();
-
-    if (query.next()) {
-        QVariant variant = query.value(0);
-        if (!variant.isNull())
-            data.numCorrect = variant.toInt();
-
-        variant = query.value(1);
-        if (!variant.isNull())
-            data.numIncorrect = variant.toInt();
-
-        variant = query.value(2);
-        if (!variant.isNull())
-            data.streak = variant.toInt();
-
-        variant = query.value(3);
-        if (!variant.isNull())
-            data.lastCorrect = variant.toInt();
-
-        variant = query.value(4);
-        if (!variant.isNull())
-            data.difficulty = variant.toInt();
-
-        variant = query.value(5);
-        if (!variant.isNull())
-            data.cardbox = variant.toInt();
-
-        variant = query.value(6);
-        if (!variant.isNull())
-            data.nextScheduled = variant.toInt();
+    QHash<QString, PendingData>::const_iterator it =
+        pendingData.find(question);
+    if (it != pendingData.end())
+        return it->data;
 
+    QuestionData data;
+    loadQuestions();
+    const CachedQuestion* cached = findCachedQuestion(question);
+    if (cached) {
+        data.numCorrect = cached->numCorrect;
+        data.numIncorrect = cached->numIncorrect;
+        data.streak = cached->streak;
+        data.lastCorrect = cached->lastCorrect;
+        data.difficulty = cached->difficulty;
+        data.cardbox = cached->cardbox;
+        data.nextScheduled = cached->scheduled ? cached->nextScheduled : 0;
         data.valid = true;
     }
 
@@ -645,31 +1108,10 @@ QuizStatsDatabase::getQuestionData(const QString& question)
 QMap<int, int>
 QuizStatsDatabase::getCardboxCounts()
 {
-    QMap<int, int> cardboxCounts;
-
-    QSqlQuery query (*db);
-    query.prepare("SELECT cardbox, count(*) FROM questions "
-        "WHERE cardbox NOT NULL GROUP BY cardbox");
-    query.exec();
-
-    while (query.next()) {
-        QVariant variant = query.value(0);
-        if (variant.isNull())
-            continue;
-        int cardbox = variant.toInt();
-
-        variant = query.value(1);
-        if (variant.isNull())
-            continue;
-        int count = variant.toInt();
-
-        cardboxCounts[cardbox] = count;
-    }
-
+    loadQuestions();
     return cardboxCounts;
 }
 
-
 //---------------------------------------------------------------------------
 //  getCardboxDueCounts
 //
@@ -682,28 +1124,16 @@ QuizStatsDatabase::getCardboxDueCounts()
 {
     QMap<int, int> cardboxDueCounts;
 
-    QSqlQuery query (*db);
-    query.prepare(
-        "SELECT cardbox, count(*) as count FROM questions "
-        "WHERE cardbox NOT NULL AND next_scheduled <= ? "
-        "GROUP by cardbox");
-
     unsigned int now = QDateTime::currentDateTime().toTime_t();
-    query.bindValue(0, now);
-    query.exec();
-
-    while (query.next()) {
-        QVariant variant = query.value(0);
-        if (variant.isNull())
-            continue;
-        int cardbox = variant.toInt();
-
-        variant = query.value(1);
-        if (variant.isNull())
-            continue;
-        int count = variant.toInt();
-
-        cardboxDueCounts[cardbox] = count;
+    loadQuestions();
+    QMapIterator<int, QVector<qint32> > it (cardboxSchedules);
+    while (it.hasNext()) {
+        it.next();
+        const QVector<qint32>& times = it.value();
+        int count = qUpperBound(times.begin(), times.end(), qint64(now)) -
+            times.begin();
+        if (count)
+            cardboxDueCounts[it.key()] = count;
     }
 
     return cardboxDueCounts;
@@ -712,38 +1142,151 @@ QuizStatsDatabase::getCardboxDueCounts()
 //---------------------------------------------------------------------------
 //  getScheduleDayCounts
 //
-//! Retrieve a pointer to the database connection.
+//! Return a map of days from now to the number of questions scheduled for
+//! each day.
 //
-//! @return the database connection pointer
+//! @return the schedule day count map
 //---------------------------------------------------------------------------
 QMap<int, int>
 QuizStatsDatabase::getScheduleDayCounts()
 {
     QMap<int, int> dayCounts;
 
+    // The scheduled times of each cardbox are sorted, so the questions of
+    // each day are found with one search per day
     unsigned int now = QDateTime::currentDateTime().toTime_t();
-    QString queryStr =
-        "SELECT round((next_scheduled - 43200.0 - %1) / 86400) AS days, "
-        "count(*) FROM questions WHERE cardbox NOT NULL GROUP BY days";
-    QSqlQuery query (*db);
-    query.prepare(queryStr.arg(now));
-    query.exec();
+    ScheduleDayLessThan dayLessThan (now);
+    loadQuestions();
+    foreach (const QVector<qint32>& times, cardboxSchedules) {
+        QVector<qint32>::const_iterator it = times.begin();
+        while (it != times.end()) {
+            QVector<qint32>::const_iterator end =
+                qUpperBound(it, times.end(), *it, dayLessThan);
+            dayCounts[scheduleDay(*it, now)] += end - it;
+            it = end;
+        }
+    }
 
-    while (query.next()) {
-        QVariant variant = query.value(0);
-        if (variant.isNull())
-            continue;
-        int days = variant.toInt();
+    return dayCounts;
+}
 
-        variant = query.value(1);
-        if (variant.isNull())
-            continue;
-        int count = variant.toInt();
+//---------------------------------------------------------------------------
+//  flush
+//
+//! Hand the question data recorded since the last flush to the writer
+//! thread, which writes it to the database in one transaction.  Does not
+//! wait for the data to be written.
+//---------------------------------------------------------------------------
+void
+QuizStatsDatabase::flush()
+{
+    if (pendingData.isEmpty() || !db || !db->isOpen())
+        return;
 
-        dayCounts[days] = count;
+    if (!writerThread) {
+        writerThread = new WriterThread(db->databaseName(),
+                                        dbConnectionName + "_writer",
+                                        statements->isCompact());
+        writerThread->start();
     }
 
-    return dayCounts;
+    writerThread->write(pendingData);
+    pendingData.clear();
+}
+
+//---------------------------------------------------------------------------
+//  sync
+//
+//! Write the question data recorded since the last flush to the database,
+//! and wait until all question data has been written.
+//---------------------------------------------------------------------------
+void
+QuizStatsDatabase::sync()
+{
+    Z_TRACE_SCOPE("QuizStatsDatabase::sync");
+    flush();
+    if (writerThread)
+        writerThread->waitForWrites();
+}
+
+//---------------------------------------------------------------------------
+//  mergeDatabase
+//
+//! Merge the questions of another quiz stats database, such as one kept on
+//! another computer, into this database.  The number of correct and
+//! incorrect responses are added together, the streak of the database with
+//! the latest correct response is kept, and the earliest scheduled time is
+//! kept along with its cardbox.  The other database is not changed.
+//
+//! @param filename the name of the other database file
+//! @param numMerged returns the number of questions merged
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+QuizStatsDatabase::mergeDatabase(const QString& filename, int* numMerged,
+                                 QString* errString)
+{
+    Z_TRACE_SCOPE("QuizStatsDatabase::mergeDatabase");
+    if (!db || !db->isOpen()) {
+        if (errString)
+            *errString = "The quiz stats database is not open.";
+        return false;
+    }
+
+    // Attaching a file that does not exist would create an empty database
+    QFileInfo fileInfo (filename);
+    if (!fileInfo.exists()) {
+        if (errString)
+            *errString = "The file '" + filename + "' does not exist.";
+        return false;
+    }
+    if (fileInfo.canonicalFilePath() ==
+        QFileInfo(db->databaseName()).canonicalFilePath())
+    {
+        if (errString)
+            *errString = "A quiz stats database cannot be merged into itself.";
+        return false;
+    }
+
+    // Data handed to the writer thread must be in the table before it is
+    // merged
+    sync();
+
+    QSqlQuery query (*db);
+    query.prepare("ATTACH DATABASE ? AS " + MERGE_DB_NAME);
+    query.bindValue(0, filename);
+    if (!query.exec()) {
+        if (errString)
+            *errString = query.lastError().text();
+        return false;
+    }
+
+    // Either database may have the compact schema
+    QString source = hasTable(MERGE_DB_NAME, "question_stats")
+        ? SQL_COMPACT_QUESTIONS.arg(MERGE_DB_NAME)
+        : MERGE_DB_NAME + ".questions";
+
+    query.exec("BEGIN TRANSACTION");
+    bool ok = statements->isCompact()
+        ? (query.exec(SQL_MERGE_COMPACT_NAMES.arg(source)) &&
+           query.exec(SQL_MERGE_COMPACT_QUESTIONS.arg(source)))
+        : query.exec(SQL_MERGE_QUESTIONS.arg(source));
+    if (ok) {
+        if (numMerged)
+            *numMerged = query.numRowsAffected();
+        query.exec("COMMIT TRANSACTION");
+    }
+    else {
+        if (errString)
+            *errString = query.lastError().text();
+        query.exec("ROLLBACK TRANSACTION");
+    }
+    query.exec("DETACH DATABASE " + MERGE_DB_NAME);
+
+    // The cached questions are read again when they are next needed
+    questionsLoaded = false;
+    return ok;
 }
 
 //---------------------------------------------------------------------------
@@ -817,88 +1360,368 @@ QuizStatsDatabase::calculateNextScheduled(int cardbox)
 }
 
 //---------------------------------------------------------------------------
-//  setQuestionData
+//  queueQuestionData
 //
-//! Update information about a question in the database.
+//! Hold new information about a question until the database is flushed.
+//! The database is flushed if too many questions are waiting.
 //
 //! @param question the question
 //! @param data the new data
 //! @param updateCardbox whether to update the cardbox information
 //---------------------------------------------------------------------------
 void
-QuizStatsDatabase::setQuestionData(const QString& question,
+QuizStatsDatabase::queueQuestionData(const QString& question,
     const QuestionData& data, bool updateCardbox)
 {
+    // The cardbox information is written if any queued update changed it.
+    // The question has a row once the data is written, so the data reads
+    // back as valid.
+    PendingData& pending = pendingData[question];
+    pending.data = data;
+    pending.data.valid = true;
+    pending.updateCardbox = pending.updateCardbox || updateCardbox;
+    cacheQuestionData(question, data, updateCardbox);
+
+    if (pendingData.size() >= MAX_PENDING_QUESTIONS)
+        flush();
+}
+
+//---------------------------------------------------------------------------
+//  loadQuestions
+//
+//! Read the questions table into memory, if it has not been read already.
+//---------------------------------------------------------------------------
+void
+QuizStatsDatabase::loadQuestions()
+{
+    if (questionsLoaded || !db || !db->isOpen())
+        return;
+
+    // Data handed to the writer thread may not be in the table yet
+    sync();
+
+    questionsLoaded = true;
+    cachedNames.clear();
+    cachedQuestions.clear();
+    cachedIds.clear();
+    cardboxCounts.clear();
+    cardboxSchedules.clear();
+
     QSqlQuery query (*db);
-    query.prepare("SELECT question FROM questions WHERE question=?");
-    query.bindValue(0, question);
+    query.setForwardOnly(true);
+    if (statements->isCompact()) {
+        query.prepare("SELECT n.question, s.correct, s.incorrect, s.streak, "
+                      "s.last_correct, s.difficulty, s.cardbox, "
+                      "s.next_scheduled FROM question_stats s "
+                      "JOIN question_names n ON n.id = s.id ORDER BY s.id");
+    }
+    else {
+        query.prepare("SELECT question, correct, incorrect, streak, "
+                      "last_correct, difficulty, cardbox, next_scheduled "
+                      "FROM questions ORDER BY rowid");
+    }
     query.exec();
 
-    // Question data already exists, so update it
-    if (query.next()) {
-        int questionBindNum = 5;
-        QString queryStr = "UPDATE questions SET correct=?, incorrect=?, "
-            "streak=?, last_correct=?, difficulty=? ";
-        if (updateCardbox) {
-            queryStr += ", cardbox=?, next_scheduled=? ";
-            questionBindNum = 7;
+    while (query.next()) {
+        CachedQuestion cached;
+        cached.numCorrect = query.value(1).toInt();
+        cached.numIncorrect = query.value(2).toInt();
+        cached.streak = query.value(3).toInt();
+        cached.lastCorrect = query.value(4).toInt();
+        cached.difficulty = query.value(5).toInt();
+
+        QVariant variant = query.value(6);
+        if (!variant.isNull())
+            cached.cardbox = variant.toInt();
+
+        variant = query.value(7);
+        if (!variant.isNull()) {
+            cached.nextScheduled = variant.toInt();
+            cached.scheduled = true;
         }
-        queryStr += "WHERE question=?";
 
-        query.prepare(queryStr);
-        query.bindValue(0, data.numCorrect);
-        query.bindValue(1, data.numIncorrect);
-        query.bindValue(2, data.streak);
-        query.bindValue(3, data.lastCorrect);
-        // XXX: Fix difficulty ratings!
-        query.bindValue(4, data.difficulty);
+        QString question = query.value(0).toString();
+        cachedIds.insert(question, cachedQuestions.size());
+        cachedNames.append(question);
+        cachedQuestions.append(cached);
+        addToCounts(cached);
+    }
+}
 
-        if (updateCardbox) {
-            if (data.cardbox >= 0) {
-                query.bindValue(5, data.cardbox);
-                query.bindValue(6, data.nextScheduled);
-            }
-            else {
-                query.bindValue(5, QVariant());
-                query.bindValue(6, QVariant());
-            }
-            questionBindNum = 7;
-        }
+//---------------------------------------------------------------------------
+//  findCachedQuestion
+//
+//! Find the cached row of a question.
+//
+//! @param question the question
+//! @return the row, or 0 if the questions table has not been read or the
+//! question is not in it
+//---------------------------------------------------------------------------
+QuizStatsDatabase::CachedQuestion*
+QuizStatsDatabase::findCachedQuestion(const QString& question)
+{
+    QHash<QString, int>::const_iterator it = cachedIds.find(question);
+    if (it == cachedIds.end())
+        return 0;
+    return &cachedQuestions[it.value()];
+}
 
-        query.bindValue(questionBindNum, question);
-        bool ok = query.exec();
-        if (!ok) {
-            qDebug("Update query failed: %s",
-                   query.lastError().text().toUtf8().constData());
-        }
+//---------------------------------------------------------------------------
+//  findCachedIds
+//
+//! Find the cached rows of a list of questions, reading the questions table
+//! if necessary.
+//
+//! @param questions the questions, or empty for all questions
+//! @return the indexes of the rows of the questions that are in the table,
+//! each appearing once
+//---------------------------------------------------------------------------
+QVector<int>
+QuizStatsDatabase::findCachedIds(const QStringList& questions)
+{
+    loadQuestions();
+    QVector<int> ids;
+
+    if (questions.isEmpty()) {
+        ids.resize(cachedQuestions.size());
+        for (int i = 0; i < ids.size(); ++i)
+            ids[i] = i;
+        return ids;
     }
 
-    // Question data does not exist, so insert it
-    else {
-        QString queryStr = "INSERT INTO questions (question, correct, "
-                           "incorrect, streak, last_correct, difficulty";
-        if (updateCardbox) {
-            queryStr += ", cardbox, next_scheduled";
-        }
-        queryStr += ") VALUES (?, ?, ?, ?, ?, ?";
-        if (updateCardbox) {
-            queryStr += ", ?, ?";
-        }
-        queryStr += ")";
+    QSet<int> seen;
+    foreach (const QString& question, questions) {
+        QHash<QString, int>::const_iterator it = cachedIds.find(question);
+        if ((it == cachedIds.end()) || seen.contains(it.value()))
+            continue;
+        seen.insert(it.value());
+        ids.append(it.value());
+    }
+    return ids;
+}
+
+//---------------------------------------------------------------------------
+//  cacheQuestionData
+//
+//! Update the cached row of a question the way setQuestionData updates the
+//! database, adding a row if necessary.  Does nothing if the questions
+//! table has not been read.
+//
+//! @param question the question
+//! @param data the new data
+//! @param updateCardbox whether to update the cardbox information
+//---------------------------------------------------------------------------
+void
+QuizStatsDatabase::cacheQuestionData(const QString& question,
+    const QuestionData& data, bool updateCardbox)
+{
+    if (!questionsLoaded)
+        return;
 
-        query.prepare(queryStr);
-        query.bindValue(0, question);
-        query.bindValue(1, data.numCorrect);
-        query.bindValue(2, data.numIncorrect);
-        query.bindValue(3, data.streak);
-        query.bindValue(4, data.lastCorrect);
-        query.bindValue(5, data.difficulty);
+    CachedQuestion* cached = findCachedQuestion(question);
+    if (!cached) {
+        cachedIds.insert(question, cachedQuestions.size());
+        cachedNames.append(question);
+        cachedQuestions.append(CachedQuestion());
+        cached = &cachedQuestions.last();
+    }
 
-        if (updateCardbox) {
-            query.bindValue(6, data.cardbox);
-            query.bindValue(7, data.nextScheduled);
-        }
+    cached->numCorrect = data.numCorrect;
+    cached->numIncorrect = data.numIncorrect;
+    cached->streak = data.streak;
+    cached->lastCorrect = data.lastCorrect;
+    cached->difficulty = data.difficulty;
+    if (updateCardbox) {
+        bool inCardbox = (data.cardbox >= 0);
+        setCachedSchedule(*cached, inCardbox ? data.cardbox : -1, inCardbox,
+                          inCardbox ? data.nextScheduled : 0);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  setCachedSchedule
+//
+//! Change the cardbox and scheduled time of a cached question, keeping the
+//! cardbox counts and schedules up to date.
+//
+//! @param cached the cached question
+//! @param cardbox the new cardbox, or -1 if not in the cardbox system
+//! @param scheduled whether the question has a scheduled time
+//! @param nextScheduled the new scheduled time
+//---------------------------------------------------------------------------
+void
+QuizStatsDatabase::setCachedSchedule(CachedQuestion& cached, int cardbox,
+    bool scheduled, qint32 nextScheduled)
+{
+    removeFromCounts(cached);
+    cached.cardbox = cardbox;
+    cached.scheduled = scheduled;
+    cached.nextScheduled = nextScheduled;
+    addToCounts(cached);
+}
+
+//---------------------------------------------------------------------------
+//  addToCounts
+//
+//! Count a cached question in the cardbox counts and schedules.
+//
+//! @param cached the cached question
+//---------------------------------------------------------------------------
+void
+QuizStatsDatabase::addToCounts(const CachedQuestion& cached)
+{
+    if (cached.cardbox < 0)
+        return;
+
+    ++cardboxCounts[cached.cardbox];
+    if (cached.scheduled) {
+        QVector<qint32>& times = cardboxSchedules[cached.cardbox];
+        times.insert(qUpperBound(times.begin(), times.end(),
+                                 cached.nextScheduled), cached.nextScheduled);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  removeFromCounts
+//
+//! Stop counting a cached question in the cardbox counts and schedules.
+//
+//! @param cached the cached question
+//---------------------------------------------------------------------------
+void
+QuizStatsDatabase::removeFromCounts(const CachedQuestion& cached)
+{
+    if (cached.cardbox < 0)
+        return;
+
+    QMap<int, int>::iterator it = cardboxCounts.find(cached.cardbox);
+    if ((it != cardboxCounts.end()) && !--it.value())
+        cardboxCounts.erase(it);
 
-        query.exec();
+    if (cached.scheduled) {
+        QMap<int, QVector<qint32> >::iterator jt =
+            cardboxSchedules.find(cached.cardbox);
+        if (jt == cardboxSchedules.end())
+            return;
+        QVector<qint32>& times = jt.value();
+        QVector<qint32>::iterator time = qLowerBound(times.begin(),
+            times.end(), cached.nextScheduled);
+        if ((time != times.end()) && (*time == cached.nextScheduled))
+            times.erase(time);
+        if (times.isEmpty())
+            cardboxSchedules.erase(jt);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  writeNextScheduled
+//
+//! Write the cached scheduled times of a list of questions to the database,
+//! in one transaction.
+//
+//! @param ids the indexes of the cached rows of the questions
+//---------------------------------------------------------------------------
+void
+QuizStatsDatabase::writeNextScheduled(const QVector<int>& ids)
+{
+    Z_TRACE_SCOPE("QuizStatsDatabase::writeNextScheduled");
+    if (ids.isEmpty())
+        return;
+
+    QSqlQuery* updateQuery =
+        statements->get(Statements::UpdateNextScheduledStatement);
+    QSqlQuery transactionQuery ("BEGIN TRANSACTION", *db);
+
+    foreach (int id, ids) {
+        updateQuery->bindValue(0, cachedQuestions[id].nextScheduled);
+        updateQuery->bindValue(1, cachedNames[id]);
+        updateQuery->exec();
+    }
+
+    transactionQuery.exec("END TRANSACTION");
+}
+
+//---------------------------------------------------------------------------
+//  setQuestionData
+//
+//! Update information about a question in the database.
+//
+//! @param question the question
+//! @param data the new data
+//! @param updateCardbox whether to update the cardbox information
+//---------------------------------------------------------------------------
+void
+QuizStatsDatabase::setQuestionData(const QString& question,
+    const QuestionData& data, bool updateCardbox)
+{
+    Z_TRACE_SCOPE("QuizStatsDatabase::setQuestionData");
+    cacheQuestionData(question, data, updateCardbox);
+    writeQuestionData(*statements, question, data, updateCardbox);
+}
+
+//---------------------------------------------------------------------------
+//  writeQuestionData
+//
+//! Write information about a question to a database.  The question is
+//! updated if it is in the questions table, and inserted otherwise.
+//
+//! @param statements the prepared statements of the database connection
+//! @param question the question
+//! @param data the new data
+//! @param updateCardbox whether to update the cardbox information
+//---------------------------------------------------------------------------
+void
+QuizStatsDatabase::writeQuestionData(Statements& statements,
+    const QString& question, const QuestionData& data, bool updateCardbox)
+{
+    QVariant cardbox;
+    QVariant nextScheduled;
+    if (updateCardbox && (data.cardbox >= 0)) {
+        cardbox = data.cardbox;
+        nextScheduled = data.nextScheduled;
+    }
+
+    // Question data already exists if the update changes a row
+    QSqlQuery* query = statements.get(updateCardbox
+        ? Statements::UpdateStatsCardboxStatement
+        : Statements::UpdateStatsStatement);
+    query->bindValue(0, data.numCorrect);
+    query->bindValue(1, data.numIncorrect);
+    query->bindValue(2, data.streak);
+    query->bindValue(3, data.lastCorrect);
+    // XXX: Fix difficulty ratings!
+    query->bindValue(4, data.difficulty);
+    int questionBindNum = 5;
+    if (updateCardbox) {
+        query->bindValue(5, cardbox);
+        query->bindValue(6, nextScheduled);
+        questionBindNum = 7;
+    }
+    query->bindValue(questionBindNum, question);
+
+    bool ok = query->exec();
+    if (!ok) {
+        qDebug("Update query failed: %s",
+               query->lastError().text().toUtf8().constData());
+        return;
+    }
+    if (query->numRowsAffected() > 0)
+        return;
+
+    // Question data does not exist, so insert it
+    statements.insertName(question);
+    query = statements.get(updateCardbox
+        ? Statements::InsertStatsCardboxStatement
+        : Statements::InsertStatsStatement);
+    query->bindValue(0, question);
+    query->bindValue(1, data.numCorrect);
+    query->bindValue(2, data.numIncorrect);
+    query->bindValue(3, data.streak);
+    query->bindValue(4, data.lastCorrect);
+    query->bindValue(5, data.difficulty);
+    if (updateCardbox) {
+        query->bindValue(6, cardbox);
+        query->bindValue(7, nextScheduled);
     }
+    query->exec();
 }
@@ -26,10 +26,13 @@
 #define ZYZZYVA_QUIZ_DATABASE_H
 
 #include "Rand.h"
+#include <QHash>
 #include <QMap>
 #include <QSqlDatabase>
 #include <QSqlQueryModel>
 #include <QString>
+#include <QStringList>
+#include <QVector>
 
 class QuizStatsDatabase
 {
@@ -68,25 +71,96 @@ class QuizStatsDatabase
     int shiftCardboxByBacklog(const QStringList& questions, int desiredBacklog);
     int shiftCardboxByDays(const QStringList& questions, int numDays);
     QStringList getReadyQuestions(const QStringList& questions, bool zeroFirst);
+    QMap<QString, QuestionData> getScheduledQuestions();
     QuestionData getQuestionData(const QString& question);
     QMap<int, int> getCardboxCounts();
     QMap<int, int> getCardboxDueCounts();
     QMap<int, int> getScheduleDayCounts();
 
+    bool mergeDatabase(const QString& filename, int* numMerged = 0,
+                       QString* errString = 0);
+
+    void flush();
+    void sync();
+    int getNumPendingQuestions() const { return pendingData.size(); }
+
     const QSqlDatabase* getDatabase() const;
 
     private:
+    // A row of the questions table, held compactly in memory.  A cardbox
+    // of -1 stands for NULL, as in QuestionData.
+    class CachedQuestion {
+        public:
+        CachedQuestion() : numCorrect(0), numIncorrect(0), streak(0),
+                           lastCorrect(0), nextScheduled(0), difficulty(0),
+                           cardbox(-1), scheduled(false) { }
+        qint32 numCorrect;
+        qint32 numIncorrect;
+        qint32 streak;
+        qint32 lastCorrect;
+        qint32 nextScheduled;
+        qint16 difficulty;
+        qint16 cardbox;
+        bool scheduled;
+    };
+
+    // Question data waiting to be written to the database
+    class PendingData {
+        public:
+        PendingData() : updateCardbox(false) { }
+        QuestionData data;
+        bool updateCardbox;
+    };
+
+    class Statements;
+    class WriterThread;
+    friend class WriterThread;
+
+    private:
+    bool hasTable(const QString& dbName, const QString& table) const;
+    bool compactQuestions();
     int calculateNextScheduled(int cardbox);
+    void loadQuestions();
+    CachedQuestion* findCachedQuestion(const QString& question);
+    QVector<int> findCachedIds(const QStringList& questions);
+    void writeNextScheduled(const QVector<int>& ids);
+    void setCachedSchedule(CachedQuestion& cached, int cardbox,
+                           bool scheduled, qint32 nextScheduled);
+    void addToCounts(const CachedQuestion& cached);
+    void removeFromCounts(const CachedQuestion& cached);
+    void cacheQuestionData(const QString& question, const QuestionData& data,
+                           bool updateCardbox);
+    void queueQuestionData(const QString& question, const QuestionData& data,
+                           bool updateCardbox);
     void setQuestionData(const QString& question, const QuestionData& data,
                          bool updateCardbox);
+    static void writeQuestionData(Statements& statements,
+                                  const QString& question,
+                                  const QuestionData& data,
+                                  bool updateCardbox);
 
     private:
     QString dbConnectionName;
     QSqlDatabase* db;
+    Statements* statements;
+    WriterThread* writerThread;
     Rand rng;
 
     QString undoQuestion;
     QuestionData undoData;
+    QHash<QString, PendingData> pendingData;
+
+    // The questions table, read when it is first needed and kept up to date
+    // with every change made through this object
+    bool questionsLoaded;
+    QStringList cachedNames;
+    QVector<CachedQuestion> cachedQuestions;
+    QHash<QString, int> cachedIds;
+
+    // The number of cached questions in each cardbox, and the sorted
+    // scheduled times of the scheduled questions in each cardbox
+    QMap<int, int> cardboxCounts;
+    QMap<int, QVector<qint32> > cardboxSchedules;
 };
 
 #endif // ZYZZYVA_QUIZ_DATABASE_H
@@ -0,0 +1,108 @@
+//---------------------------------------------------------------------------
+// RackSampler.cpp
+//
+// A class for drawing random racks of letters from a full bag.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "RackSampler.h"
+#include "LetterBag.h"
+#include "Auxil.h"
+#include <QDateTime>
+
+//---------------------------------------------------------------------------
+//  RackSampler
+//
+//! Constructor.  Build the table of tiles in a full bag.  Tiles other than
+//! the letters A to Z and the blank are left out.
+//
+//! @param distribution the letter distribution to use, or the default
+//! distribution if empty
+//---------------------------------------------------------------------------
+RackSampler::RackSampler(const QString& distribution)
+{
+    LetterBag bag (distribution);
+    QString letters = bag.getLetters();
+    tiles.reserve(letters.length());
+    for (int i = 0; i < letters.length(); ++i) {
+        QChar c = letters.at(i);
+        uint letter = uint(c.unicode()) - 'A';
+        if (letter < uint(LetterSignature::NUM_LETTERS))
+            tiles.append(quint8(letter));
+        else if (c == LetterBag::BLANK_CHAR)
+            tiles.append(BLANK_TILE);
+    }
+
+    rng.srand(QDateTime::currentDateTime().toTime_t(), Auxil::getPid());
+}
+
+//---------------------------------------------------------------------------
+//  drawRack
+//
+//! Draw a random rack from a full bag.
+//
+//! @param numLetters the number of letters in the rack
+//! @return the rack, or an empty signature if the bag has fewer tiles
+//---------------------------------------------------------------------------
+LetterSignature
+RackSampler::drawRack(int numLetters)
+{
+    LetterSignature rack;
+    int numTiles = tiles.size();
+    if ((numLetters <= 0) || (numLetters > numTiles))
+        return rack;
+
+    quint8* tileData = tiles.data();
+    for (int i = 0; i < numLetters; ++i) {
+        int remaining = numTiles - i;
+        int j = i + ((remaining > 1) ? int(rng.rand(remaining - 1)) : 0);
+        quint8 tile = tileData[j];
+        tileData[j] = tileData[i];
+        tileData[i] = tile;
+
+        if (tile == BLANK_TILE)
+            rack.addBlank();
+        else
+            rack.addLetter(tile);
+    }
+    return rack;
+}
+
+//---------------------------------------------------------------------------
+//  drawRacks
+//
+//! Draw a number of random racks, each from a full bag.
+//
+//! @param numRacks the number of racks
+//! @param numLetters the number of letters in each rack
+//! @param racks returns the racks
+//---------------------------------------------------------------------------
+void
+RackSampler::drawRacks(int numRacks, int numLetters,
+                       QVector<LetterSignature>* racks)
+{
+    racks->clear();
+    if ((numLetters <= 0) || (numLetters > tiles.size()))
+        return;
+
+    racks->reserve(numRacks);
+    for (int i = 0; i < numRacks; ++i)
+        racks->append(drawRack(numLetters));
+}
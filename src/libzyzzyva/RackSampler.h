@@ -0,0 +1,55 @@
+//---------------------------------------------------------------------------
+// RackSampler.h
+//
+// A class for drawing random racks of letters from a full bag.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_RACK_SAMPLER_H
+#define ZYZZYVA_RACK_SAMPLER_H
+
+#include "LetterSignature.h"
+#include "Rand.h"
+#include <QString>
+#include <QVector>
+
+// Racks are drawn without replacement from a table of every tile in a full
+// bag.  Each rack is a partial shuffle of the table, which leaves the table
+// in an order that is still fit to draw the next rack from, so drawing a
+// rack of N letters takes N random numbers and no rebuilding of the bag.
+class RackSampler
+{
+    public:
+    RackSampler(const QString& distribution = QString());
+    ~RackSampler() { }
+
+    int getNumTiles() const { return tiles.size(); }
+    LetterSignature drawRack(int numLetters);
+    void drawRacks(int numRacks, int numLetters,
+                   QVector<LetterSignature>* racks);
+
+    private:
+    static const quint8 BLANK_TILE = LetterSignature::NUM_LETTERS;
+
+    QVector<quint8> tiles;
+    Rand rng;
+};
+
+#endif // ZYZZYVA_RACK_SAMPLER_H
@@ -27,6 +27,24 @@
 
 #include <QString>
 
+//---------------------------------------------------------------------------
+//  splitMix
+//
+//! Advance a SplitMix64 state and return its next output, used to expand
+//! the seeds into the state of the larger generators.
+//
+//! @param state the state
+//! @return the next output
+//---------------------------------------------------------------------------
+static quint64
+splitMix(quint64& state)
+{
+    quint64 x = (state += Q_UINT64_C(0x9e3779b97f4a7c15));
+    x = (x ^ (x >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+    x = (x ^ (x >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+    return x ^ (x >> 31);
+}
+
 //---------------------------------------------------------------------------
 //  rand
 //
@@ -38,19 +56,89 @@
 unsigned int
 Rand::rand(unsigned int max)
 {
-    unsigned int randnum = 0;
+    unsigned int randnum = next();
+    if ((max == 0) || (max == 4294967295U))
+        return randnum;
+
     switch (algorithm) {
-        case SystemRand:   randnum = std::rand(); break;
-        case MarsagliaMwc: randnum = mwc(); break;
+        case SystemRand: return randnum % (max + 1);
+        case MarsagliaMwc: return (randnum / ((4294967295U / (max + 1)) + 1));
         default: break;
     }
 
-    if ((max == 0) || (max == 4294967295U))
-        return randnum;
+    // Map the number to the range without bias by multiplying, rejecting
+    // the few numbers that would make some values more likely (Lemire,
+    // "Fast Random Integer Generation in an Interval")
+    quint32 range = max + 1;
+    quint64 m = quint64(randnum) * range;
+    quint32 low = quint32(m);
+    if (low < range) {
+        quint32 threshold = quint32(-range) % range;
+        while (low < threshold) {
+            m = quint64(next()) * range;
+            low = quint32(m);
+        }
+    }
+    return quint32(m >> 32);
+}
 
+//---------------------------------------------------------------------------
+//  randUnit
+//
+//! Return a random number greater than zero and less than one.
+//
+//! @return a random number
+//---------------------------------------------------------------------------
+double
+Rand::randUnit()
+{
+    if (algorithm == SystemRand)
+        return (double(std::rand()) + 0.5) / (double(RAND_MAX) + 1.0);
+    return (double(next()) + 0.5) / 4294967296.0;
+}
+
+//---------------------------------------------------------------------------
+//  seed
+//
+//! Seed the state of the xoshiro128++ and PCG32 generators.
+//
+//! @param z0 the first seed
+//! @param w0 the second seed
+//---------------------------------------------------------------------------
+void
+Rand::seed(unsigned int z0, unsigned int w0)
+{
+    quint64 state = (quint64(z0) << 32) | w0;
+    quint64 a = splitMix(state);
+    quint64 b = splitMix(state);
+    xoshiroState[0] = quint32(a);
+    xoshiroState[1] = quint32(a >> 32);
+    xoshiroState[2] = quint32(b);
+    xoshiroState[3] = quint32(b >> 32);
+
+    pcgIncrement = (splitMix(state) << 1) | 1;
+    pcgState = 0;
+    pcg();
+    pcgState += splitMix(state);
+    pcg();
+}
+
+//---------------------------------------------------------------------------
+//  next
+//
+//! Return the next random number of the current algorithm.
+//
+//! @return a random number
+//---------------------------------------------------------------------------
+unsigned int
+Rand::next()
+{
     switch (algorithm) {
-        case SystemRand: return randnum % (max + 1);
-        default: return (randnum / ((4294967295U / (max + 1)) + 1));
+        case SystemRand:         return std::rand();
+        case MarsagliaMwc:       return mwc();
+        case Xoshiro128PlusPlus: return xoshiro();
+        case Pcg32:              return pcg();
+        default:                 return 0;
     }
 }
 
@@ -95,3 +183,45 @@ Rand::wnew()
     w = 18000 * (w & 65535) + (w >> 16);
     return w;
 }
+
+//---------------------------------------------------------------------------
+//  xoshiro
+//
+//! Return a random number using the xoshiro128++ algorithm.
+//
+//! @return a random number
+//---------------------------------------------------------------------------
+unsigned int
+Rand::xoshiro()
+{
+    quint32* s = xoshiroState;
+    quint32 sum = s[0] + s[3];
+    quint32 result = ((sum << 7) | (sum >> 25)) + s[0];
+    quint32 t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 11) | (s[3] >> 21);
+
+    return result;
+}
+
+//---------------------------------------------------------------------------
+//  pcg
+//
+//! Return a random number using the PCG32 (XSH RR) algorithm.
+//
+//! @return a random number
+//---------------------------------------------------------------------------
+unsigned int
+Rand::pcg()
+{
+    quint64 old = pcgState;
+    pcgState = old * Q_UINT64_C(6364136223846793005) + pcgIncrement;
+    quint32 xorShifted = quint32(((old >> 18) ^ old) >> 27);
+    quint32 rot = quint32(old >> 59);
+    return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+}
@@ -3,6 +3,8 @@
 //
 // A random number generator based on George Marsaglia's algorithms found
 // on this web page:  http://www.ciphersbyritter.com/NEWS4/RANDC.HTM
+// Also provides the xoshiro128++ generator of David Blackman and Sebastiano
+// Vigna, and the PCG32 generator of Melissa O'Neill.
 //
 // Copyright 2005-2012 Boshvark Software, LLC.
 //
@@ -26,38 +28,52 @@
 #ifndef ZYZZYVA_RAND_H
 #define ZYZZYVA_RAND_H
 
+#include <QtGlobal>
 #include <cstdlib>
 
 class Rand
 {
     public:
+    // Algorithms are saved with quizzes so their questions can be shuffled
+    // again in the same order, so existing values must never change
     enum Algorithm {
         SystemRand = 0,
-        MarsagliaMwc = 1
+        MarsagliaMwc = 1,
+        Xoshiro128PlusPlus = 2,
+        Pcg32 = 3
     };
 
     public:
     Rand(int a = MarsagliaMwc, unsigned int z0 = 362436069,
          unsigned int w0 = 521288629)
-        : algorithm(Algorithm(a)), z(z0), w(w0) { }
+        : algorithm(Algorithm(a)), z(z0), w(w0) { seed(z0, w0); }
     ~Rand() { }
 
     void setAlgorithm(int a) { algorithm = Algorithm(a); }
     void srand(unsigned int z0, unsigned int w0 = 0) {
         if (algorithm == SystemRand) std::srand(z0);
         z = z0; w = w0;
+        seed(z0, w0);
     }
     unsigned int rand(unsigned int max = 4294967295U);
+    double randUnit();
 
     private:
+    void seed(unsigned int z0, unsigned int w0);
+    unsigned int next();
     unsigned int mwc();
     unsigned int znew();
     unsigned int wnew();
+    unsigned int xoshiro();
+    unsigned int pcg();
 
     private:
     Algorithm algorithm;
     unsigned int z;
     unsigned int w;
+    quint32 xoshiroState[4];
+    quint64 pcgState;
+    quint64 pcgIncrement;
 };
 
 #endif // ZYZZYVA_RAND_H
@@ -39,6 +39,73 @@ const QString XML_NEGATED_ATTR = "negated";
 const QString XML_OLD_NUMBER_ATTR = "number";
 const QString XML_OLD_PERCENT_ATTR = "percent";
 
+// The string of an In Word List condition whose words are read from a file
+// is the name of the file after this prefix, which cannot start a word
+const QString WORD_LIST_FILE_PREFIX = "@";
+
+//---------------------------------------------------------------------------
+//  operator==
+//
+//! Determine whether this search condition is equal to another.
+//
+//! @param other the other search condition
+//! @return true if every field is equal, false otherwise
+//---------------------------------------------------------------------------
+bool
+SearchCondition::operator==(const SearchCondition& other) const
+{
+    return ((type == other.type) && (stringValue == other.stringValue) &&
+            (minValue == other.minValue) && (maxValue == other.maxValue) &&
+            (intValue == other.intValue) && (negated == other.negated) &&
+            (boolValue == other.boolValue) && (legacy == other.legacy));
+}
+
+//---------------------------------------------------------------------------
+//  isWordListFile
+//
+//! Determine whether this is an In Word List condition whose words are
+//! read from a file.
+//
+//! @return true if the words are read from a file, false otherwise
+//---------------------------------------------------------------------------
+bool
+SearchCondition::isWordListFile() const
+{
+    return (type == InWordList) &&
+        stringValue.startsWith(WORD_LIST_FILE_PREFIX);
+}
+
+//---------------------------------------------------------------------------
+//  getWordListFile
+//
+//! Get the name of the file the words of an In Word List condition are read
+//! from.
+//
+//! @return the file name, or an empty string if the words are not read
+//! from a file
+//---------------------------------------------------------------------------
+QString
+SearchCondition::getWordListFile() const
+{
+    if (!isWordListFile())
+        return QString();
+    return stringValue.mid(WORD_LIST_FILE_PREFIX.length());
+}
+
+//---------------------------------------------------------------------------
+//  setWordListFile
+//
+//! Make this an In Word List condition whose words are read from a file.
+//
+//! @param filename the file name
+//---------------------------------------------------------------------------
+void
+SearchCondition::setWordListFile(const QString& filename)
+{
+    type = InWordList;
+    stringValue = WORD_LIST_FILE_PREFIX + filename;
+}
+
 //---------------------------------------------------------------------------
 //  asString
 //
@@ -73,7 +140,7 @@ SearchCondition::asString() const
         break;
 
         case InWordList:
-        str += "...";
+        str += isWordListFile() ? getWordListFile() : QString("...");
         break;
 
         case Length:
@@ -76,6 +76,10 @@ class SearchCondition
     QString asString() const;
     QDomElement asDomElement() const;
     bool fromDomElement(const QDomElement& element);
+    bool operator==(const SearchCondition& other) const;
+    bool isWordListFile() const;
+    QString getWordListFile() const;
+    void setWordListFile(const QString& filename);
 
     SearchType type;
     QString stringValue;
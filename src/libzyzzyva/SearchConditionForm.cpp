@@ -792,6 +792,16 @@ void
 SearchConditionForm::setWordListString(const QString& string)
 {
     paramWordListString = string;
+
+    SearchCondition condition;
+    condition.type = SearchCondition::InWordList;
+    condition.stringValue = string;
+    if (condition.isWordListFile()) {
+        paramWordListLine->setText("File: " + condition.getWordListFile());
+        paramWordListLine->home(false);
+        return;
+    }
+
     int numWords = 0;
     if (!string.isEmpty()) {
         QStringList wordList = string.split(QChar(' '));
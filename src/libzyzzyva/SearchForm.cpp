@@ -26,6 +26,7 @@
 #include "LexiconSelectWidget.h"
 #include "MainSettings.h"
 #include "SearchSpecForm.h"
+#include "SearchThread.h"
 #include "WordEngine.h"
 #include "WordTableModel.h"
 #include "WordTableView.h"
@@ -54,7 +55,8 @@ const QString TITLE_PREFIX = "Search";
 //! @param f widget flags
 //---------------------------------------------------------------------------
 SearchForm::SearchForm(WordEngine* e, QWidget* parent, Qt::WFlags f)
-    : ActionForm(SearchFormType, parent, f), wordEngine(e)
+    : ActionForm(SearchFormType, parent, f), wordEngine(e), searchThread(0),
+      numResults(0), resultsComplete(false)
 {
     QHBoxLayout* mainHlay = new QHBoxLayout(this);
     mainHlay->setMargin(MARGIN);
@@ -105,6 +107,16 @@ SearchForm::SearchForm(WordEngine* e, QWidget* parent, Qt::WFlags f)
     QTimer::singleShot(0, this, SLOT(selectInputArea()));
 }
 
+//---------------------------------------------------------------------------
+//  ~SearchForm
+//
+//! Destructor.  Cancel any search in progress.
+//---------------------------------------------------------------------------
+SearchForm::~SearchForm()
+{
+    delete searchThread;
+}
+
 //---------------------------------------------------------------------------
 //  getIcon
 //
@@ -197,142 +209,111 @@ SearchForm::selectInputArea()
 //---------------------------------------------------------------------------
 //  search
 //
-//! Search for the word or pattern in the edit area, and display the results
-//! in the list box.
+//! Start searching for words in the background, using the current search
+//! specification.  If a search is already running, cancel it instead.
 //---------------------------------------------------------------------------
 void
 SearchForm::search()
 {
+    // The search button cancels a search in progress
+    if (searchThread) {
+        searchThread->cancel();
+        return;
+    }
+
     SearchSpec spec = specForm->getSearchSpec();
     if (spec.conditions.empty())
         return;
 
     QString lexicon = lexiconWidget->getCurrentLexicon();
 
-    searchButton->setEnabled(false);
+    // Only check the previous results if the new search narrows it
+    bool refining = resultsComplete && (lexicon == searchLexicon) &&
+        spec.isRefinementOf(searchSpec);
+    SearchSpec previousSpec = searchSpec;
+    QStringList previousWords = resultWords;
+
     resultModel->removeRows(0, resultModel->rowCount());
     resultModel->setLexicon(lexicon);
+    searchSpec = spec;
+    searchLexicon = lexicon;
+    numResults = 0;
+    resultWords.clear();
+    resultsComplete = false;
+    emit saveEnabledChanged(false);
 
     statusString = "Searching...";
     emit statusChanged(statusString);
-    qApp->processEvents();
-
-    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-
-    QStringList wordList =
-        wordEngine->search(lexicon, specForm->getSearchSpec(), false);
-
-    if (!wordList.empty()) {
-
-        // Check for Anagram or Subanagram conditions, and only group by
-        // alphagrams if one of them is present
-        bool hasAnagramCondition = false;
-        bool hasSubanagramCondition = false;
-        bool hasProbabilityCondition = false;
-        bool hasPlayabilityCondition = false;
-        int probNumBlanks = MainSettings::getProbabilityNumBlanks();
-        QListIterator<SearchCondition> it (spec.conditions);
-        while (it.hasNext()) {
-            const SearchCondition& condition = it.next();
-            SearchCondition::SearchType type = condition.type;
-            if (!condition.negated &&
-                ((type == SearchCondition::AnagramMatch) ||
-                (type == SearchCondition::SubanagramMatch) ||
-                (type == SearchCondition::NumAnagrams)))
-            {
-                hasAnagramCondition = true;
-                if (type == SearchCondition::SubanagramMatch)
-                    hasSubanagramCondition = true;
-            }
 
-            else if ((type == SearchCondition::ProbabilityOrder) ||
-                (type == SearchCondition::LimitByProbabilityOrder))
-            {
-                // Set number of blanks based on the first probability search
-                // condition
-                if (!hasProbabilityCondition)
-                    probNumBlanks = condition.intValue;
-                hasProbabilityCondition = true;
-            }
+    searchButton->setText("&Cancel");
+    QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
 
-            else if ((type == SearchCondition::PlayabilityOrder) ||
-                (type == SearchCondition::LimitByPlayabilityOrder))
-            {
-                hasPlayabilityCondition = true;
-            }
-        }
-
-        // Create a list of WordItem objects from the words
-        QList<WordTableModel::WordItem> wordItems;
-        foreach (const QString& word, wordList) {
-            QString wildcard;
-            if (hasAnagramCondition) {
-                // Get wildcard characters
-                QList<QChar> wildcardChars;
-                for (int i = 0; i < word.length(); ++i) {
-                    QChar c = word[i];
-                    if (c.isLower())
-                        wildcardChars.append(c);
-                }
-                if (!wildcardChars.isEmpty()) {
-                    qSort(wildcardChars.begin(), wildcardChars.end(),
-                          Auxil::localeAwareLessThanQChar);
-                    foreach (const QChar& c, wildcardChars)
-                        wildcard.append(c.toUpper());
-                }
-            }
-
-            QString displayWord = word;
-            QString wordUpper = word.toUpper();
+    searchThread = new SearchThread(wordEngine, lexicon, spec, this);
+    if (refining)
+        searchThread->setRefinement(previousSpec, previousWords);
+    connect(searchThread, SIGNAL(wordsFound(const QStringList&)),
+            SLOT(searchWordsFound(const QStringList&)));
+    connect(searchThread, SIGNAL(finished()), SLOT(searchFinished()));
+    searchThread->start();
+}
 
-            // Convert to all caps if necessary
-            if (!MainSettings::getWordListLowerCaseWildcards())
-                displayWord = wordUpper;
+//---------------------------------------------------------------------------
+//  searchWordsFound
+//
+//! Called when the search thread finds a batch of words.  Add the words to
+//! the search results.
+//
+//! @param words the words
+//---------------------------------------------------------------------------
+void
+SearchForm::searchWordsFound(const QStringList& words)
+{
+    if (!searchThread || (sender() != searchThread) ||
+        searchThread->getCancelled())
+    {
+        return;
+    }
 
-            WordTableModel::WordItem wordItem
-                (displayWord, WordTableModel::WordNormal, wildcard);
+    addResultWords(words);
+    resultWords += words;
+    numResults += words.size();
 
-            // Set probability/playability order for correct sorting
-            if (hasProbabilityCondition) {
-                int probOrder = wordEngine->getProbabilityOrder(
-                    lexicon, wordUpper, probNumBlanks);
-                wordItem.setProbabilityOrder(probOrder);
-            }
-            else if (hasPlayabilityCondition) {
-                qint64 playValue = wordEngine->getPlayabilityValue(
-                    lexicon, wordUpper);
-                int playOrder = wordEngine->getPlayabilityOrder(
-                    lexicon, wordUpper);
-                wordItem.setPlayabilityValue(playValue);
-                wordItem.setPlayabilityOrder(playOrder);
-            }
+    QString wordStr = QString::number(numResults) + " word";
+    if (numResults != 1)
+        wordStr += "s";
+    statusString = "Searching... found " + wordStr;
+    emit statusChanged(statusString);
+}
 
-            wordItems.append(wordItem);
-        }
+//---------------------------------------------------------------------------
+//  searchFinished
+//
+//! Called when the search thread finishes or is cancelled.  Display the
+//! number of words found and the time taken.
+//---------------------------------------------------------------------------
+void
+SearchForm::searchFinished()
+{
+    if (!searchThread || (sender() != searchThread))
+        return;
 
-        // FIXME: Probably not the right way to get alphabetical sorting instead
-        // of alphagram sorting
-        bool origGroupByAnagrams = MainSettings::getWordListGroupByAnagrams();
-        if (!hasAnagramCondition)
-            MainSettings::setWordListGroupByAnagrams(false);
-        if (hasSubanagramCondition)
-            MainSettings::setWordListSortByReverseLength(true);
-        if (hasProbabilityCondition)
-            MainSettings::setWordListSortByProbabilityOrder(true);
-        else if (hasPlayabilityCondition)
-            MainSettings::setWordListSortByPlayabilityOrder(true);
-        resultModel->setProbabilityNumBlanks(probNumBlanks);
-        resultModel->addWords(wordItems);
-        MainSettings::setWordListSortByPlayabilityOrder(false);
-        MainSettings::setWordListSortByProbabilityOrder(false);
-        if (hasSubanagramCondition)
-            MainSettings::setWordListSortByReverseLength(false);
-        if (!hasAnagramCondition)
-            MainSettings::setWordListGroupByAnagrams(origGroupByAnagrams);
-    }
+    bool cancelled = searchThread->getCancelled();
+    int elapsed = searchThread->getElapsed();
+    WordEngine::SearchProfile profile = searchThread->getProfile();
+    searchThread->deleteLater();
+    searchThread = 0;
+    resultsComplete = !cancelled;
 
-    updateResultTotal(wordList.size());
-    emit saveEnabledChanged(!wordList.empty());
+    QString wordStr = QString::number(numResults) + " word";
+    if (numResults != 1)
+        wordStr += "s";
+    statusString = (cancelled ? QString("Search cancelled after finding ")
+                              : QString("Search found ")) + wordStr +
+        QString(" in %1 seconds").arg(elapsed / 1000.0, 0, 'f', 2);
+    if (!profile.isEmpty())
+        statusString += " [" + profile.toString() + "]";
+    emit statusChanged(statusString);
+    emit saveEnabledChanged(numResults > 0);
 
     QWidget* focusWidget = QApplication::focusWidget();
     QLineEdit* lineEdit = dynamic_cast<QLineEdit*>(focusWidget);
@@ -343,10 +324,128 @@ SearchForm::search()
         selectInputArea();
     }
 
-    searchButton->setEnabled(true);
+    searchButton->setText("&Search");
+    specChanged();
     QApplication::restoreOverrideCursor();
 }
 
+//---------------------------------------------------------------------------
+//  addResultWords
+//
+//! Add words found by the current search to the search results.
+//
+//! @param words the words
+//---------------------------------------------------------------------------
+void
+SearchForm::addResultWords(const QStringList& words)
+{
+    // Check for Anagram or Subanagram conditions, and only group by
+    // alphagrams if one of them is present
+    bool hasAnagramCondition = false;
+    bool hasSubanagramCondition = false;
+    bool hasProbabilityCondition = false;
+    bool hasPlayabilityCondition = false;
+    int probNumBlanks = MainSettings::getProbabilityNumBlanks();
+    QListIterator<SearchCondition> it (searchSpec.conditions);
+    while (it.hasNext()) {
+        const SearchCondition& condition = it.next();
+        SearchCondition::SearchType type = condition.type;
+        if (!condition.negated &&
+            ((type == SearchCondition::AnagramMatch) ||
+            (type == SearchCondition::SubanagramMatch) ||
+            (type == SearchCondition::NumAnagrams)))
+        {
+            hasAnagramCondition = true;
+            if (type == SearchCondition::SubanagramMatch)
+                hasSubanagramCondition = true;
+        }
+
+        else if ((type == SearchCondition::ProbabilityOrder) ||
+            (type == SearchCondition::LimitByProbabilityOrder))
+        {
+            // Set number of blanks based on the first probability search
+            // condition
+            if (!hasProbabilityCondition)
+                probNumBlanks = condition.intValue;
+            hasProbabilityCondition = true;
+        }
+
+        else if ((type == SearchCondition::PlayabilityOrder) ||
+            (type == SearchCondition::LimitByPlayabilityOrder))
+        {
+            hasPlayabilityCondition = true;
+        }
+    }
+
+    // Create a list of WordItem objects from the words
+    QList<WordTableModel::WordItem> wordItems;
+    foreach (const QString& word, words) {
+        QString wildcard;
+        if (hasAnagramCondition) {
+            // Get wildcard characters
+            QList<QChar> wildcardChars;
+            for (int i = 0; i < word.length(); ++i) {
+                QChar c = word[i];
+                if (c.isLower())
+                    wildcardChars.append(c);
+            }
+            if (!wildcardChars.isEmpty()) {
+                qSort(wildcardChars.begin(), wildcardChars.end(),
+                      Auxil::localeAwareLessThanQChar);
+                foreach (const QChar& c, wildcardChars)
+                    wildcard.append(c.toUpper());
+            }
+        }
+
+        QString displayWord = word;
+        QString wordUpper = word.toUpper();
+
+        // Convert to all caps if necessary
+        if (!MainSettings::getWordListLowerCaseWildcards())
+            displayWord = wordUpper;
+
+        WordTableModel::WordItem wordItem
+            (displayWord, WordTableModel::WordNormal, wildcard);
+
+        // Set probability/playability order for correct sorting
+        if (hasProbabilityCondition) {
+            int probOrder = wordEngine->getProbabilityOrder(
+                searchLexicon, wordUpper, probNumBlanks);
+            wordItem.setProbabilityOrder(probOrder);
+        }
+        else if (hasPlayabilityCondition) {
+            qint64 playValue = wordEngine->getPlayabilityValue(
+                searchLexicon, wordUpper);
+            int playOrder = wordEngine->getPlayabilityOrder(
+                searchLexicon, wordUpper);
+            wordItem.setPlayabilityValue(playValue);
+            wordItem.setPlayabilityOrder(playOrder);
+        }
+
+        wordItems.append(wordItem);
+    }
+
+    // FIXME: Probably not the right way to get alphabetical sorting instead
+    // of alphagram sorting
+    bool origGroupByAnagrams = MainSettings::getWordListGroupByAnagrams();
+    if (!hasAnagramCondition)
+        MainSettings::setWordListGroupByAnagrams(false);
+    if (hasSubanagramCondition)
+        MainSettings::setWordListSortByReverseLength(true);
+    if (hasProbabilityCondition)
+        MainSettings::setWordListSortByProbabilityOrder(true);
+    else if (hasPlayabilityCondition)
+        MainSettings::setWordListSortByPlayabilityOrder(true);
+    resultModel->setProbabilityNumBlanks(probNumBlanks);
+    resultModel->addWords(wordItems);
+    MainSettings::setWordListSortByPlayabilityOrder(false);
+    MainSettings::setWordListSortByProbabilityOrder(false);
+    if (hasSubanagramCondition)
+        MainSettings::setWordListSortByReverseLength(false);
+    if (!hasAnagramCondition)
+        MainSettings::setWordListGroupByAnagrams(origGroupByAnagrams);
+}
+
 //---------------------------------------------------------------------------
 //  specChanged
 //
@@ -356,7 +455,7 @@ SearchForm::search()
 void
 SearchForm::specChanged()
 {
-    searchButton->setEnabled(specForm->isValid());
+    searchButton->setEnabled(searchThread || specForm->isValid());
 }
 
 //---------------------------------------------------------------------------
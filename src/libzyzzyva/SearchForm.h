@@ -26,12 +26,14 @@
 #define ZYZZYVA_SEARCH_FORM_H
 
 #include "ActionForm.h"
+#include "SearchSpec.h"
 #include <QCheckBox>
 #include <QComboBox>
 #include <QLabel>
 
 class LexiconSelectWidget;
 class SearchSpecForm;
+class SearchThread;
 class WordEngine;
 class WordTableModel;
 class WordTableView;
@@ -42,6 +44,7 @@ class SearchForm : public ActionForm
     Q_OBJECT
     public:
     SearchForm(WordEngine* e, QWidget* parent = 0, Qt::WFlags f = 0);
+    ~SearchForm();
     QIcon getIcon() const;
     QString getTitle() const;
     QString getStatusString() const;
@@ -59,6 +62,11 @@ class SearchForm : public ActionForm
     void updateResultTotal(int num);
     void lexiconActivated(const QString& lexicon);
     void specChanged();
+    void searchWordsFound(const QStringList& words);
+    void searchFinished();
+
+    private:
+    void addResultWords(const QStringList& words);
 
     private:
     WordEngine*     wordEngine;
@@ -69,6 +77,16 @@ class SearchForm : public ActionForm
     ZPushButton*    searchButton;
     QString         statusString;
     QString         detailsString;
+
+    SearchThread*   searchThread;
+    SearchSpec      searchSpec;
+    QString         searchLexicon;
+    int             numResults;
+
+    // Complete results of the last search, which a narrower search can be
+    // limited to
+    QStringList     resultWords;
+    bool            resultsComplete;
 };
 
 #endif // ZYZZYVA_SEARCH_FORM_H
@@ -23,6 +23,7 @@
 //---------------------------------------------------------------------------
 
 #include "SearchSpec.h"
+#include "SearchStats.h"
 #include "Auxil.h"
 #include "Defs.h"
 
@@ -31,9 +32,12 @@ using namespace Defs;
 const int CURRENT_VERSION = 1;
 const QString XML_TOP_ELEMENT = "zyzzyva-search";
 const QString XML_VERSION_ATTR = "version";
+const QString XML_SAMPLE_SIZE_ATTR = "sample-size";
+const QString XML_SAMPLE_SEED_ATTR = "sample-seed";
 const QString XML_CONDITIONS_ELEMENT = "conditions";
 const QString XML_CONJUNCTION_ELEMENT = "and";
 const QString XML_DISJUNCTION_ELEMENT = "or";
+const int NUM_LETTERS = 26;
 
 //---------------------------------------------------------------------------
 //  asString
@@ -52,9 +56,98 @@ SearchSpec::asString() const
             str += (conjunction ? QString(" AND ") : QString(" OR "));
         str += it.next().asString();
     }
+    if (sampleSize > 0)
+        str += QString(" (random sample of %1)").arg(sampleSize);
     return str;
 }
 
+//---------------------------------------------------------------------------
+//  asCanonicalString
+//
+//! Return a string holding every field of the search spec, so that two
+//! search specs have equal strings exactly when they are equal.  Unlike
+//! asString, the string is not meant to be read.
+//
+//! @return the canonical string representation
+//---------------------------------------------------------------------------
+QString
+SearchSpec::asCanonicalString() const
+{
+    // Built by appending rather than with arg, since every search builds
+    // the strings of its spec
+    QString str = conjunction ? QString("&") : QString("|");
+    QListIterator<SearchCondition> it (conditions);
+    while (it.hasNext()) {
+        const SearchCondition& condition = it.next();
+        str += QChar('(');
+        str += QString::number(int(condition.type));
+        str += QChar(' ');
+        str += QString::number(condition.minValue);
+        str += QChar(' ');
+        str += QString::number(condition.maxValue);
+        str += QChar(' ');
+        str += QString::number(condition.intValue);
+        str += QChar(' ');
+        str += QChar(condition.negated ? '1' : '0');
+        str += QChar(condition.boolValue ? '1' : '0');
+        str += QChar(condition.legacy ? '1' : '0');
+        str += QChar(' ');
+        str += QString::number(condition.stringValue.length());
+        str += QChar(':');
+        str += condition.stringValue;
+        str += QChar(')');
+    }
+
+    // Appended only to sampled specs, so the strings and hashes of other
+    // specs are the same as before samples could be drawn
+    if (sampleSize > 0) {
+        str += QChar('#');
+        str += QString::number(sampleSize);
+        str += QChar(' ');
+        str += QString::number(sampleSeed);
+    }
+    return str;
+}
+
+//---------------------------------------------------------------------------
+//  getCanonicalHash
+//
+//! Return a 64-bit hash of the canonical string representation of the
+//! search spec.  The hash is the same in every session and on every
+//! platform.
+//
+//! @return the hash
+//---------------------------------------------------------------------------
+quint64
+SearchSpec::getCanonicalHash() const
+{
+    return hashCanonicalString(asCanonicalString());
+}
+
+//---------------------------------------------------------------------------
+//  hashCanonicalString
+//
+//! Return a 64-bit FNV-1a hash of a canonical string representation of a
+//! search spec, over the bytes of its UTF-16 characters.
+//
+//! @param str the canonical string representation
+//! @return the hash
+//---------------------------------------------------------------------------
+quint64
+SearchSpec::hashCanonicalString(const QString& str)
+{
+    quint64 hash = Q_UINT64_C(14695981039346656037);
+    const quint64 prime = Q_UINT64_C(1099511628211);
+    const QChar* data = str.constData();
+    int length = str.length();
+    for (int i = 0; i < length; ++i) {
+        ushort c = data[i].unicode();
+        hash = (hash ^ (c & 0xff)) * prime;
+        hash = (hash ^ (c >> 8)) * prime;
+    }
+    return hash;
+}
+
 //---------------------------------------------------------------------------
 //  asXml
 //
@@ -91,6 +184,11 @@ SearchSpec::asDomElement() const
     QDomDocument doc;
     QDomElement topElement = doc.createElement(XML_TOP_ELEMENT);
     topElement.setAttribute(XML_VERSION_ATTR, CURRENT_VERSION);
+    if (sampleSize > 0) {
+        topElement.setAttribute(XML_SAMPLE_SIZE_ATTR, sampleSize);
+        if (sampleSeed)
+            topElement.setAttribute(XML_SAMPLE_SEED_ATTR, sampleSeed);
+    }
 
     if (conditions.empty())
         return topElement;
@@ -133,6 +231,22 @@ SearchSpec::fromDomElement(const QDomElement& element)
             return false;
     }
 
+    if (element.hasAttribute(XML_SAMPLE_SIZE_ATTR)) {
+        bool ok;
+        tmpSpec.sampleSize =
+            element.attribute(XML_SAMPLE_SIZE_ATTR).toInt(&ok);
+        if (!ok || (tmpSpec.sampleSize < 0))
+            return false;
+    }
+
+    if (element.hasAttribute(XML_SAMPLE_SEED_ATTR)) {
+        bool ok;
+        tmpSpec.sampleSeed =
+            element.attribute(XML_SAMPLE_SEED_ATTR).toUInt(&ok);
+        if (!ok)
+            return false;
+    }
+
     QDomElement elem = element.firstChild().toElement();
     if (elem.isNull() || (elem.tagName() != XML_CONDITIONS_ELEMENT))
         return false;
@@ -171,12 +285,17 @@ SearchSpec::fromDomElement(const QDomElement& element)
 //! semantic changes.  Detect conflicts in certain specifications (e.g.
 //! minimum length greater than maximum length), and detect constraints
 //! implicit in certain specifications (e.g. Type I Sevens must have a length
-//! of exactly 7 letters).
+//! of exactly 7 letters).  If statistics of the lexicon are given, ranges
+//! of values that no word of the lexicon has are also detected.  The letters
+//! matches must contain and may contain are derived from the Include
+//! Letters and Consist Of conditions, so word graph searches can skip
+//! subtrees that cannot lead to a match.
 //
 //! @param lexicon the lexicon for which this search is to be used
+//! @param stats if not null, the search statistics of the lexicon
 //---------------------------------------------------------------------------
 void
-SearchSpec::optimize(const QString& lexicon)
+SearchSpec::optimize(const QString& lexicon, const SearchStats* stats)
 {
     QList<SearchCondition> newConditions;
     QList<SearchCondition> wildcardConditions;
@@ -194,9 +313,16 @@ SearchSpec::optimize(const QString& lexicon)
     int maxNumUniqueLetters = MAX_WORD_LEN + 1;
     int minPointValue = 0;
     int maxPointValue = 10 * MAX_WORD_LEN + 1;
+    const quint32 ALL_LETTERS = (1U << NUM_LETTERS) - 1;
+    int requiredCounts[NUM_LETTERS];
+    for (int i = 0; i < NUM_LETTERS; ++i)
+        requiredCounts[i] = 0;
+    quint32 allowedMask = ALL_LETTERS;
     QMap<QString, bool> inLexicons;
     QMap<QString, bool> pos;
     inLexicons[lexicon] = true;
+    requiredLetters.clear();
+    allowedLetters.clear();
 
     QMutableListIterator<SearchCondition> it (conditions);
     while (it.hasNext()) {
@@ -306,7 +432,36 @@ SearchSpec::optimize(const QString& lexicon)
                 }
                 mustInclude += stringValue;
                 newConditions.append(condition);
+
+                // Each condition is checked on its own, so a letter is only
+                // required as many times as any one condition requires it
+                int counts[NUM_LETTERS];
+                for (int i = 0; i < NUM_LETTERS; ++i)
+                    counts[i] = 0;
+                for (int i = 0; i < int(stringValue.length()); ++i) {
+                    int c = stringValue.at(i).unicode() - 'A';
+                    if ((c >= 0) && (c < NUM_LETTERS))
+                        ++counts[c];
+                }
+                for (int i = 0; i < NUM_LETTERS; ++i)
+                    requiredCounts[i] = qMax(requiredCounts[i], counts[i]);
+            }
+            break;
+
+            // Words consisting entirely of the letters can only contain
+            // those letters
+            case SearchCondition::ConsistOf:
+            if (!negated && (minValue >= 100)) {
+                QString letters = stringValue.toUpper();
+                quint32 letterMask = 0;
+                for (int i = 0; i < int(letters.length()); ++i) {
+                    int c = letters.at(i).unicode() - 'A';
+                    if ((c >= 0) && (c < NUM_LETTERS))
+                        letterMask |= (1U << c);
+                }
+                allowedMask &= letterMask;
             }
+            newConditions.append(condition);
             break;
 
             case SearchCondition::BelongToGroup: {
@@ -432,6 +587,28 @@ SearchSpec::optimize(const QString& lexicon)
         }
     }
 
+    // Letters every match must contain, which must be allowed and must fit
+    // in the longest match.  A disjunction of conditions implies neither.
+    if (conjunction) {
+        for (int i = 0; i < NUM_LETTERS; ++i) {
+            if (requiredCounts[i] && !(allowedMask & (1U << i))) {
+                conditions.clear();
+                return;
+            }
+            requiredLetters += QString(requiredCounts[i], QChar('A' + i));
+        }
+        if (!allowedMask || (requiredLetters.length() > maxLength)) {
+            conditions.clear();
+            return;
+        }
+        if (allowedMask != ALL_LETTERS) {
+            for (int i = 0; i < NUM_LETTERS; ++i) {
+                if (allowedMask & (1U << i))
+                    allowedLetters += QChar('A' + i);
+            }
+        }
+    }
+
     // Sanity checks for impossible conditions
     if ((minNumVowels > maxLength) || (minNumUniqueLetters > maxLength) ||
         (minPointValue > (10 * maxLength)) || (maxPointValue < minLength))
@@ -440,6 +617,24 @@ SearchSpec::optimize(const QString& lexicon)
         return;
     }
 
+    // Ranges no word of the lexicon falls in
+    if (stats && !stats->isEmpty() &&
+        (!stats->getLengthCount(minLength, maxLength) ||
+         (((minAnagrams > 0) || (maxAnagrams < MAX_ANAGRAMS)) &&
+          !stats->getCount(SearchStats::NumAnagramsHistogram, minAnagrams,
+                           maxAnagrams)) ||
+         (((minNumVowels > 0) || (maxNumVowels < (MAX_WORD_LEN + 1))) &&
+          !stats->getCount(SearchStats::NumVowelsHistogram, minNumVowels,
+                           maxNumVowels)) ||
+         (((minPointValue > 0) ||
+           (maxPointValue < (10 * MAX_WORD_LEN + 1))) &&
+          !stats->getCount(SearchStats::PointValueHistogram, minPointValue,
+                           maxPointValue))))
+    {
+        conditions.clear();
+        return;
+    }
+
     SearchCondition condition;
 
     // Add Number of Anagrams conditions
@@ -513,3 +708,50 @@ SearchSpec::update()
         ++version;
     }
 }
+
+//---------------------------------------------------------------------------
+//  isRefinementOf
+//
+//! Determine whether this search spec narrows another search spec by adding
+//! conditions to it, so that its matches are exactly the matches of the
+//! other spec that also match the added conditions.  Both specs must be
+//! conjunctions, and the other spec must not limit its matches by
+//! probability or playability order, since such limits depend on the rest
+//! of the matches.  Neither spec may draw a random sample of its matches.
+//
+//! @param spec the other search spec
+//! @param addedConditions returns the conditions added to the other spec
+//! @return true if this spec is a refinement of the other spec, false
+//! otherwise
+//---------------------------------------------------------------------------
+bool
+SearchSpec::isRefinementOf(const SearchSpec& spec, QList<SearchCondition>*
+                           addedConditions) const
+{
+    if (!conjunction || !spec.conjunction || spec.conditions.isEmpty() ||
+        (conditions.size() <= spec.conditions.size()) || (sampleSize > 0) ||
+        (spec.sampleSize > 0))
+    {
+        return false;
+    }
+
+    QList<SearchCondition> added = conditions;
+    QListIterator<SearchCondition> it (spec.conditions);
+    while (it.hasNext()) {
+        const SearchCondition& condition = it.next();
+        if ((condition.type == SearchCondition::LimitByProbabilityOrder) ||
+            (condition.type == SearchCondition::LimitByPlayabilityOrder))
+        {
+            return false;
+        }
+
+        int index = added.indexOf(condition);
+        if (index < 0)
+            return false;
+        added.removeAt(index);
+    }
+
+    if (addedConditions)
+        *addedConditions = added;
+    return true;
+}
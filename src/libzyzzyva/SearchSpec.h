@@ -31,22 +31,44 @@
 #include <QDomElement>
 #include <QList>
 
+class SearchStats;
+
 class SearchSpec
 {
     public:
-    SearchSpec() : version(0), conjunction(true) { }
+    SearchSpec() : version(0), conjunction(true), sampleSize(0),
+                   sampleSeed(0) { }
     ~SearchSpec() { }
 
     QString asString() const;
+    QString asCanonicalString() const;
+    quint64 getCanonicalHash() const;
     QString asXml() const;
     QDomElement asDomElement() const;
     bool fromDomElement(const QDomElement& element);
-    void optimize(const QString& lexicon);
+    void optimize(const QString& lexicon, const SearchStats* stats = 0);
     void update();
+    bool isRefinementOf(const SearchSpec& spec, QList<SearchCondition>*
+                        addedConditions = 0) const;
+
+    static quint64 hashCanonicalString(const QString& str);
 
     int version;
     bool conjunction;
     QList<SearchCondition> conditions;
+
+    // The number of matches to draw at random, or zero for every match, and
+    // the seed to draw them with, or zero to seed from the time
+    int sampleSize;
+    unsigned int sampleSeed;
+
+    // The letters every match must contain, with repeats, and the letters
+    // matches may contain, or empty for any letter.  These are derived from
+    // the Include Letters and Consist Of conditions by optimize, so word
+    // graph traversals can skip letters and subtrees that cannot lead to a
+    // match, and are not saved.
+    QString requiredLetters;
+    QString allowedLetters;
 };
 
 #endif // ZYZZYVA_SEARCH_SPEC_H
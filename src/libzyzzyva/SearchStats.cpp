@@ -0,0 +1,379 @@
+//---------------------------------------------------------------------------
+// SearchStats.cpp
+//
+// A class for estimating how many words of a lexicon match search
+// conditions.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "SearchStats.h"
+#include "Defs.h"
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+
+using namespace Defs;
+
+//---------------------------------------------------------------------------
+//  clear
+//
+//! Remove every count from the histograms.
+//---------------------------------------------------------------------------
+void
+SearchStats::clear()
+{
+    histograms.fill(QMap<int, int>());
+    numWords = 0;
+}
+
+//---------------------------------------------------------------------------
+//  collect
+//
+//! Collect the histograms from the words table of a lexicon database, in
+//! one pass over the table.
+//
+//! @param db the database
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+SearchStats::collect(const QSqlDatabase& db)
+{
+    clear();
+
+    QSqlQuery query (db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT word, num_anagrams, num_vowels, point_value "
+                    "FROM words"))
+    {
+        return false;
+    }
+
+    while (query.next()) {
+        addWord(query.value(0).toString(), query.value(1).toInt(),
+                query.value(2).toInt(), query.value(3).toInt());
+    }
+    return !isEmpty();
+}
+
+//---------------------------------------------------------------------------
+//  load
+//
+//! Load the histograms saved in a lexicon database.
+//
+//! @param db the database
+//! @return true if successful, false if the database has no histograms
+//---------------------------------------------------------------------------
+bool
+SearchStats::load(const QSqlDatabase& db)
+{
+    clear();
+
+    QSqlQuery query (db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT histogram, key, count FROM search_stats"))
+        return false;
+
+    while (query.next()) {
+        int histogram = query.value(0).toInt();
+        if ((histogram < 0) || (histogram >= NumHistograms))
+            continue;
+        int count = query.value(2).toInt();
+        histograms[histogram].insert(query.value(1).toInt(), count);
+        if (histogram == LengthHistogram)
+            numWords += count;
+    }
+    return !isEmpty();
+}
+
+//---------------------------------------------------------------------------
+//  save
+//
+//! Save the histograms in a lexicon database, replacing any already saved.
+//
+//! @param db the database
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+SearchStats::save(const QSqlDatabase& db) const
+{
+    QSqlQuery query (db);
+    if (!query.exec("CREATE TABLE IF NOT EXISTS search_stats "
+                    "(histogram integer, key integer, count integer)"))
+    {
+        return false;
+    }
+
+    QVariantList histogramValues;
+    QVariantList keyValues;
+    QVariantList countValues;
+    for (int i = 0; i < NumHistograms; ++i) {
+        QMapIterator<int, int> it (histograms[i]);
+        while (it.hasNext()) {
+            it.next();
+            histogramValues.append(i);
+            keyValues.append(it.key());
+            countValues.append(it.value());
+        }
+    }
+
+    QSqlQuery transactionQuery ("BEGIN TRANSACTION", db);
+    query.exec("DELETE FROM search_stats");
+    query.prepare("INSERT INTO search_stats (histogram, key, count) "
+                  "VALUES (?, ?, ?)");
+    query.addBindValue(histogramValues);
+    query.addBindValue(keyValues);
+    query.addBindValue(countValues);
+    bool ok = query.execBatch();
+    transactionQuery.exec(ok ? "END TRANSACTION" : "ROLLBACK");
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+//  getCount
+//
+//! Get the number of words counted in a histogram with keys in a range.
+//
+//! @param histogram the histogram
+//! @param minKey the minimum key
+//! @param maxKey the maximum key
+//! @return the number of words
+//---------------------------------------------------------------------------
+int
+SearchStats::getCount(Histogram histogram, int minKey, int maxKey) const
+{
+    const QMap<int, int>& counts = histograms[histogram];
+    int count = 0;
+    QMap<int, int>::const_iterator it = counts.lowerBound(minKey);
+    for (; (it != counts.end()) && (it.key() <= maxKey); ++it)
+        count += it.value();
+    return count;
+}
+
+//---------------------------------------------------------------------------
+//  getCount
+//
+//! Get the number of words counted in a histogram with a key.
+//
+//! @param histogram the histogram
+//! @param key the key
+//! @return the number of words
+//---------------------------------------------------------------------------
+int
+SearchStats::getCount(Histogram histogram, int key) const
+{
+    return histograms[histogram].value(key);
+}
+
+//---------------------------------------------------------------------------
+//  getLengthCount
+//
+//! Get the number of words with lengths in a range.
+//
+//! @param minLength the minimum length
+//! @param maxLength the maximum length
+//! @return the number of words
+//---------------------------------------------------------------------------
+int
+SearchStats::getLengthCount(int minLength, int maxLength) const
+{
+    return getCount(LengthHistogram, minLength, maxLength);
+}
+
+//---------------------------------------------------------------------------
+//  getOrderCount
+//
+//! Get the number of words with lengths in a range and probability or
+//! playability orders in a range.  Orders are ranked from 1 within each
+//! length, so the number of words of a length is also its highest order.
+//
+//! @param minLength the minimum length
+//! @param maxLength the maximum length
+//! @param minOrder the minimum order
+//! @param maxOrder the maximum order
+//! @return the number of words
+//---------------------------------------------------------------------------
+int
+SearchStats::getOrderCount(int minLength, int maxLength, int minOrder, int
+                           maxOrder) const
+{
+    const QMap<int, int>& counts = histograms[LengthHistogram];
+    int count = 0;
+    QMap<int, int>::const_iterator it = counts.lowerBound(minLength);
+    for (; (it != counts.end()) && (it.key() <= maxLength); ++it) {
+        int span = qMin(maxOrder, it.value()) - qMax(minOrder, 1) + 1;
+        if (span > 0)
+            count += span;
+    }
+    return count;
+}
+
+//---------------------------------------------------------------------------
+//  getLetterCount
+//
+//! Get an upper bound on the number of words containing a letter: the
+//! number of times the letter appears in any position.
+//
+//! @param letter the letter
+//! @return the number of words
+//---------------------------------------------------------------------------
+int
+SearchStats::getLetterCount(const QChar& letter) const
+{
+    int count = 0;
+    for (int i = 0; i < MAX_WORD_LEN; ++i)
+        count += getCount(PositionLetterHistogram, getPositionKey(i, letter));
+    return qMin(count, numWords);
+}
+
+//---------------------------------------------------------------------------
+//  estimateMatches
+//
+//! Estimate an upper bound on the number of words with lengths in a range
+//! that match a search condition.
+//
+//! @param condition the search condition
+//! @param minLength the minimum length
+//! @param maxLength the maximum length
+//! @return the estimated number of words
+//---------------------------------------------------------------------------
+int
+SearchStats::estimateMatches(const SearchCondition& condition, int
+                             minLength, int maxLength) const
+{
+    int estimate = getLengthCount(minLength, maxLength);
+    if (condition.negated)
+        return estimate;
+
+    switch (condition.type) {
+        case SearchCondition::NumAnagrams:
+        estimate = qMin(estimate, getCount(NumAnagramsHistogram,
+            condition.minValue, condition.maxValue));
+        break;
+
+        case SearchCondition::NumVowels:
+        estimate = qMin(estimate, getCount(NumVowelsHistogram,
+            condition.minValue, condition.maxValue));
+        break;
+
+        case SearchCondition::PointValue:
+        estimate = qMin(estimate, getCount(PointValueHistogram,
+            condition.minValue, condition.maxValue));
+        break;
+
+        case SearchCondition::ProbabilityOrder:
+        case SearchCondition::PlayabilityOrder:
+        estimate = qMin(estimate, getOrderCount(minLength, maxLength,
+            condition.minValue, condition.maxValue));
+        break;
+
+        case SearchCondition::IncludeLetters: {
+            const QString& letters = condition.stringValue;
+            for (int i = 0; i < letters.length(); ++i) {
+                if (letters.at(i).isLetter())
+                    estimate = qMin(estimate, getLetterCount(letters.at(i)));
+            }
+        }
+        break;
+
+        // Letters before the first wildcard are at known positions, and a
+        // letter at the end is the last letter
+        case SearchCondition::PatternMatch: {
+            const QString& pattern = condition.stringValue;
+            for (int i = 0; (i < pattern.length()) && (i < MAX_WORD_LEN);
+                 ++i)
+            {
+                if (!pattern.at(i).isLetter())
+                    break;
+                estimate = qMin(estimate, getCount(PositionLetterHistogram,
+                    getPositionKey(i, pattern.at(i))));
+            }
+            if (!pattern.isEmpty() && pattern.at(0).isLetter()) {
+                estimate = qMin(estimate, getCount(FirstLetterHistogram,
+                    pattern.at(0).toUpper().unicode()));
+            }
+            if (!pattern.isEmpty() && pattern.at(pattern.length() - 1)
+                .isLetter())
+            {
+                estimate = qMin(estimate, getCount(LastLetterHistogram,
+                    pattern.at(pattern.length() - 1).toUpper().unicode()));
+            }
+        }
+        break;
+
+        // The words of word list files are not known here
+        case SearchCondition::InWordList:
+        if (!condition.isWordListFile()) {
+            estimate = qMin(estimate, condition.stringValue.split(QChar(' '),
+                QString::SkipEmptyParts).size());
+        }
+        break;
+
+        default:
+        break;
+    }
+
+    return estimate;
+}
+
+//---------------------------------------------------------------------------
+//  getPositionKey
+//
+//! Get the key of a letter at a position in the position letter histogram.
+//
+//! @param position the position, starting from zero
+//! @param letter the letter
+//! @return the key
+//---------------------------------------------------------------------------
+int
+SearchStats::getPositionKey(int position, const QChar& letter)
+{
+    return (position << 16) | letter.toUpper().unicode();
+}
+
+//---------------------------------------------------------------------------
+//  addWord
+//
+//! Count a word in the histograms.
+//
+//! @param word the word
+//! @param numAnagrams the number of anagrams of the word
+//! @param numVowels the number of vowels in the word
+//! @param pointValue the point value of the word
+//---------------------------------------------------------------------------
+void
+SearchStats::addWord(const QString& word, int numAnagrams, int numVowels,
+                     int pointValue)
+{
+    if (word.isEmpty())
+        return;
+
+    QString wordUpper = word.toUpper();
+    int length = wordUpper.length();
+    ++histograms[LengthHistogram][length];
+    ++histograms[FirstLetterHistogram][wordUpper.at(0).unicode()];
+    ++histograms[LastLetterHistogram][wordUpper.at(length - 1).unicode()];
+    for (int i = 0; (i < length) && (i < MAX_WORD_LEN); ++i)
+        ++histograms[PositionLetterHistogram][getPositionKey(i,
+            wordUpper.at(i))];
+    ++histograms[NumAnagramsHistogram][numAnagrams];
+    ++histograms[NumVowelsHistogram][numVowels];
+    ++histograms[PointValueHistogram][pointValue];
+    ++numWords;
+}
@@ -0,0 +1,84 @@
+//---------------------------------------------------------------------------
+// SearchStats.h
+//
+// A class for estimating how many words of a lexicon match search
+// conditions.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_SEARCH_STATS_H
+#define ZYZZYVA_SEARCH_STATS_H
+
+#include "SearchCondition.h"
+#include <QChar>
+#include <QMap>
+#include <QSqlDatabase>
+#include <QVector>
+
+// Histograms of the words of a lexicon database, collected when the
+// database is built and saved in its search_stats table.  Probability and
+// playability orders are ranked within each length, so the number of words
+// of each length is also their distribution.
+class SearchStats
+{
+    public:
+    enum Histogram {
+        LengthHistogram = 0,
+        FirstLetterHistogram,
+        LastLetterHistogram,
+        PositionLetterHistogram,
+        NumAnagramsHistogram,
+        NumVowelsHistogram,
+        PointValueHistogram,
+        NumHistograms
+    };
+
+    public:
+    SearchStats() : histograms(NumHistograms), numWords(0) { }
+    ~SearchStats() { }
+
+    void clear();
+    bool isEmpty() const { return !numWords; }
+    bool collect(const QSqlDatabase& db);
+    bool load(const QSqlDatabase& db);
+    bool save(const QSqlDatabase& db) const;
+
+    int getNumWords() const { return numWords; }
+    int getCount(Histogram histogram, int minKey, int maxKey) const;
+    int getCount(Histogram histogram, int key) const;
+    int getLengthCount(int minLength, int maxLength) const;
+    int getOrderCount(int minLength, int maxLength, int minOrder, int
+                      maxOrder) const;
+    int getLetterCount(const QChar& letter) const;
+    int estimateMatches(const SearchCondition& condition, int minLength, int
+                        maxLength) const;
+
+    static int getPositionKey(int position, const QChar& letter);
+
+    private:
+    void addWord(const QString& word, int numAnagrams, int numVowels, int
+                 pointValue);
+
+    private:
+    QVector<QMap<int, int> > histograms;
+    int numWords;
+};
+
+#endif // ZYZZYVA_SEARCH_STATS_H
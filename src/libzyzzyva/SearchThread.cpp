@@ -0,0 +1,120 @@
+//---------------------------------------------------------------------------
+// SearchThread.cpp
+//
+// A class for searching for words in the background.
+//
+// Words are passed on in batches as they are found, so a form can display
+// them while the search continues.  Searches that only need the word graph
+// find words progressively; other searches pass on all their words once
+// the database and post conditions have been applied.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "SearchThread.h"
+#include "WordEngine.h"
+
+// Largest number of words passed on in one batch, and the longest time in
+// milliseconds that found words are held before being passed on
+const int MAX_BATCH_WORDS = 1000;
+const int MAX_BATCH_MSECS = 100;
+
+//---------------------------------------------------------------------------
+//  cancel
+//
+//! Cancel the search.  Words already passed on are kept, and no more words
+//! are passed on.
+//---------------------------------------------------------------------------
+void
+SearchThread::cancel()
+{
+    cancelled = true;
+}
+
+//---------------------------------------------------------------------------
+//  run
+//
+//! Run the thread.  If a previous search has been given, only the words
+//! found by that search are checked.
+//---------------------------------------------------------------------------
+void
+SearchThread::run()
+{
+    QTime timer;
+    timer.start();
+    flushTime.start();
+
+    // Words found by refining a previous search are only known at the end
+    if (refining) {
+        QStringList words = wordEngine->refineSearch(lexiconName, spec, false,
+            previousSpec, previousWords, this, &profile);
+        foreach (const QString& word, words) {
+            if (!visitWord(word))
+                break;
+        }
+    }
+    else {
+        wordEngine->search(lexiconName, spec, false, this, &profile);
+    }
+    if (!cancelled)
+        flushWords();
+
+    elapsed = timer.elapsed();
+}
+
+//---------------------------------------------------------------------------
+//  visitWord
+//
+//! Receive a word found by the search, and pass on the words found so far
+//! if enough words have been found or enough time has passed.
+//
+//! @param word the word
+//! @return false if the search has been cancelled, true otherwise
+//---------------------------------------------------------------------------
+bool
+SearchThread::visitWord(const QString& word)
+{
+    if (cancelled)
+        return false;
+
+    pendingWords.append(word);
+    ++numWords;
+    if ((pendingWords.size() >= MAX_BATCH_WORDS) ||
+        (flushTime.elapsed() >= MAX_BATCH_MSECS))
+    {
+        flushWords();
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  flushWords
+//
+//! Pass on the words found since the last batch was passed on.
+//---------------------------------------------------------------------------
+void
+SearchThread::flushWords()
+{
+    flushTime.restart();
+    if (pendingWords.isEmpty())
+        return;
+
+    emit wordsFound(pendingWords);
+    pendingWords.clear();
+}
@@ -0,0 +1,83 @@
+//---------------------------------------------------------------------------
+// SearchThread.h
+//
+// A class for searching for words in the background.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_SEARCH_THREAD_H
+#define ZYZZYVA_SEARCH_THREAD_H
+
+#include "SearchSpec.h"
+#include "WordEngine.h"
+#include "WordVisitor.h"
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QTime>
+
+class SearchThread : public QThread, public WordVisitor
+{
+    Q_OBJECT
+    public:
+    SearchThread(WordEngine* e, const QString& lex, const SearchSpec& s,
+                 QObject* parent = 0)
+        : QThread(parent), wordEngine(e), lexiconName(lex), spec(s),
+          refining(false), cancelled(false), numWords(0), elapsed(0) { }
+    ~SearchThread() { cancel(); wait(); }
+
+    void setRefinement(const SearchSpec& s, const QStringList& words) {
+        refining = true; previousSpec = s; previousWords = words; }
+
+    bool getCancelled() const { return cancelled; }
+    int getNumWords() const { return numWords; }
+    int getElapsed() const { return elapsed; }
+    WordEngine::SearchProfile getProfile() const { return profile; }
+
+    bool visitWord(const QString& word);
+    bool isCancelled() const { return cancelled; }
+
+    public slots:
+    void cancel();
+
+    signals:
+    void wordsFound(const QStringList& words);
+
+    protected:
+    void run();
+
+    private:
+    void flushWords();
+
+    WordEngine* wordEngine;
+    QString lexiconName;
+    SearchSpec spec;
+    bool refining;
+    SearchSpec previousSpec;
+    QStringList previousWords;
+    volatile bool cancelled;
+    int numWords;
+    int elapsed;
+    WordEngine::SearchProfile profile;
+    QStringList pendingWords;
+    QTime flushTime;
+};
+
+#endif // ZYZZYVA_SEARCH_THREAD_H
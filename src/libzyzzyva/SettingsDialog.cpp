@@ -41,6 +41,7 @@
 #include <QLabel>
 #include <QRegExp>
 #include <QSignalMapper>
+#include <QThread>
 #include <QVBoxLayout>
 
 const QString DIALOG_CAPTION = "Preferences";
@@ -213,6 +214,29 @@ SettingsDialog::SettingsDialog(QWidget* parent, Qt::WFlags f)
     searchSelectInputCbox = new QCheckBox("Highlight input after search");
     searchPrefVlay->addWidget(searchSelectInputCbox);
 
+    QHBoxLayout* searchNumThreadsHlay = new QHBoxLayout;
+    searchNumThreadsHlay->setMargin(0);
+    searchPrefVlay->addLayout(searchNumThreadsHlay);
+
+    QLabel* searchNumThreadsLabel =
+        new QLabel("Number of threads to use for each search:");
+    searchNumThreadsHlay->addWidget(searchNumThreadsLabel);
+
+    searchNumThreadsSbox = new QSpinBox;
+    searchNumThreadsSbox->setMinimum(1);
+    searchNumThreadsSbox->setMaximum(qMax(1, QThread::idealThreadCount()));
+    searchNumThreadsHlay->addWidget(searchNumThreadsSbox);
+
+    searchUseInfixIndexCbox = new QCheckBox("Index lexicons for patterns "
+        "anchored in the middle, such as *QU* (uses more memory, takes "
+        "effect when lexicons are loaded)");
+    searchPrefVlay->addWidget(searchUseInfixIndexCbox);
+
+    searchSuccinctReverseDawgCbox = new QCheckBox("Store reversed lexicons "
+        "compactly (uses less memory, but finds front hooks and patterns "
+        "such as *ING more slowly, takes effect when lexicons are loaded)");
+    searchPrefVlay->addWidget(searchSuccinctReverseDawgCbox);
+
     searchPrefVlay->addStretch(2);
 
     // Quiz Prefs
@@ -768,6 +792,11 @@ SettingsDialog::refreshSettings()
 
     // Search
     searchSelectInputCbox->setChecked(MainSettings::getSearchSelectInput());
+    searchNumThreadsSbox->setValue(MainSettings::getSearchNumThreads());
+    searchUseInfixIndexCbox->setChecked(
+        MainSettings::getSearchUseInfixIndex());
+    searchSuccinctReverseDawgCbox->setChecked(
+        MainSettings::getSearchSuccinctReverseDawg());
 
     // Quiz letter order
     int letterOrderIndex =
@@ -902,6 +931,11 @@ SettingsDialog::writeSettings()
     MainSettings::setUseTileTheme(themeCbox->isChecked());
     MainSettings::setTileTheme(themeCombo->currentText());
     MainSettings::setSearchSelectInput(searchSelectInputCbox->isChecked());
+    MainSettings::setSearchNumThreads(searchNumThreadsSbox->value());
+    MainSettings::setSearchUseInfixIndex(
+        searchUseInfixIndexCbox->isChecked());
+    MainSettings::setSearchSuccinctReverseDawg(
+        searchSuccinctReverseDawgCbox->isChecked());
     MainSettings::setQuizLetterOrder(letterOrderCombo->currentText());
     MainSettings::setQuizBackgroundColor(quizBackgroundColor);
     MainSettings::setQuizUseFlashcardMode(
@@ -104,6 +104,9 @@ class SettingsDialog : public QDialog
     QComboBox*   themeCombo;
     QComboBox*   letterOrderCombo;
     QCheckBox*   searchSelectInputCbox;
+    QSpinBox*    searchNumThreadsSbox;
+    QCheckBox*   searchUseInfixIndexCbox;
+    QCheckBox*   searchSuccinctReverseDawgCbox;
     QLineEdit*   quizBackgroundColorLine;
     QCheckBox*   quizUseFlashcardModeCbox;
     QCheckBox*   quizShowNumResponsesCbox;
@@ -0,0 +1,156 @@
+//---------------------------------------------------------------------------
+// Shuffle.cpp
+//
+// A class for shuffling lists in random order.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "Shuffle.h"
+#include <QtAlgorithms>
+#include <cmath>
+
+// Sort key of an item in a weighted shuffle.  Items with positive weights
+// come first, ordered by decreasing key, then items with no weight in
+// random order.
+class WeightedKey
+{
+    public:
+    WeightedKey(bool w = false, double k = 0, int i = 0)
+        : weighted(w), key(k), index(i) { }
+    bool operator<(const WeightedKey& other) const {
+        if (weighted != other.weighted)
+            return weighted;
+        if (key != other.key)
+            return key > other.key;
+        return index < other.index;
+    }
+
+    bool weighted;
+    double key;
+    int index;
+};
+
+//---------------------------------------------------------------------------
+//  getOrder
+//
+//! Get a random order of a number of items, using the Fisher-Yates
+//! shuffle.
+//
+//! @param num the number of items
+//! @return the index of the item at each position
+//---------------------------------------------------------------------------
+QVector<int>
+Shuffle::getOrder(int num)
+{
+    QVector<int> order (num);
+    for (int i = 0; i < num; ++i)
+        order[i] = i;
+
+    for (int i = 0; i < num - 1; ++i) {
+        int j = i + rng->rand(num - i - 1);
+        if (j == i)
+            continue;
+        int tmp = order[j];
+        order[j] = order[i];
+        order[i] = tmp;
+    }
+
+    return order;
+}
+
+//---------------------------------------------------------------------------
+//  getWeightedOrder
+//
+//! Get a random order of items, in which items with greater weights tend to
+//! come first.  The chance of an item coming before the remaining items is
+//! proportional to its weight, as described in: Efraimidis and Spirakis,
+//! "Weighted Random Sampling with a Reservoir."  Items with weights of zero
+//! or less come last, in random order.
+//
+//! @param weights the weight of each item
+//! @return the index of the item at each position
+//---------------------------------------------------------------------------
+QVector<int>
+Shuffle::getWeightedOrder(const QVector<double>& weights)
+{
+    int num = weights.size();
+    QVector<WeightedKey> keys (num);
+    for (int i = 0; i < num; ++i) {
+        double u = rng->randUnit();
+        double weight = weights[i];
+        keys[i] = (weight > 0) ? WeightedKey(true, std::log(u) / weight, i)
+                               : WeightedKey(false, u, i);
+    }
+
+    qSort(keys.begin(), keys.end());
+
+    QVector<int> order (num);
+    for (int i = 0; i < num; ++i)
+        order[i] = keys[i].index;
+    return order;
+}
+
+//---------------------------------------------------------------------------
+//  shuffle
+//
+//! Shuffle a list of items in random order.
+//
+//! @param items the items
+//---------------------------------------------------------------------------
+void
+Shuffle::shuffle(QStringList& items)
+{
+    items = reorder(items, getOrder(items.size()));
+}
+
+//---------------------------------------------------------------------------
+//  weightedShuffle
+//
+//! Shuffle a list of items in random order, in which items with greater
+//! weights tend to come first.  See getWeightedOrder.
+//
+//! @param items the items
+//! @param weights the weight of each item
+//---------------------------------------------------------------------------
+void
+Shuffle::weightedShuffle(QStringList& items, const QVector<double>& weights)
+{
+    if (weights.size() != items.size())
+        return;
+    items = reorder(items, getWeightedOrder(weights));
+}
+
+//---------------------------------------------------------------------------
+//  reorder
+//
+//! Put a list of items in an order.
+//
+//! @param items the items
+//! @param order the index of the item at each position
+//! @return the items in the order
+//---------------------------------------------------------------------------
+QStringList
+Shuffle::reorder(const QStringList& items, const QVector<int>& order)
+{
+    QStringList orderedItems;
+    foreach (int index, order)
+        orderedItems.append(items[index]);
+    return orderedItems;
+}
@@ -0,0 +1,54 @@
+//---------------------------------------------------------------------------
+// Shuffle.h
+//
+// A class for shuffling lists in random order.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_SHUFFLE_H
+#define ZYZZYVA_SHUFFLE_H
+
+#include "Rand.h"
+#include <QStringList>
+#include <QVector>
+
+// Shuffles are computed as orders of indexes, and only then applied to the
+// items, so items are moved once rather than swapped repeatedly.  An
+// unweighted shuffle draws the same random numbers as swapping the items
+// in place, so quizzes saved with a seed are shuffled the same way.
+class Shuffle
+{
+    public:
+    Shuffle(Rand* r) : rng(r) { }
+    ~Shuffle() { }
+
+    QVector<int> getOrder(int num);
+    QVector<int> getWeightedOrder(const QVector<double>& weights);
+    void shuffle(QStringList& items);
+    void weightedShuffle(QStringList& items, const QVector<double>& weights);
+
+    static QStringList reorder(const QStringList& items, const QVector<int>&
+                               order);
+
+    private:
+    Rand* rng;
+};
+
+#endif // ZYZZYVA_SHUFFLE_H
@@ -0,0 +1,328 @@
+//---------------------------------------------------------------------------
+// SuccinctDawg.cpp
+//
+// A class for holding a DAWG in a compact encoding.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "SuccinctDawg.h"
+#include "Defs.h"
+
+using namespace Defs;
+
+const qint32 ROOT_NODE = 1;
+
+//---------------------------------------------------------------------------
+//  countBits
+//
+//! Count the number of bits set in a 32-bit value.
+//
+//! @param value the value
+//! @return the number of bits set
+//---------------------------------------------------------------------------
+static inline quint32
+countBits(quint32 value)
+{
+    value = value - ((value >> 1) & 0x55555555);
+    value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+    return (((value + (value >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+//---------------------------------------------------------------------------
+//  clear
+//
+//! Remove all edges.
+//---------------------------------------------------------------------------
+void
+SuccinctDawg::clear()
+{
+    numEdges = 0;
+    pointerBits = 0;
+    labels.clear();
+    childBits.clear();
+    childRanks.clear();
+    pointers.clear();
+    letters.clear();
+    children.clear();
+    for (int i = 0; i < 256; ++i)
+        codes[i] = -1;
+}
+
+//---------------------------------------------------------------------------
+//  addEdge
+//
+//! Add the next edge, in the order of the edges of the packed DAWG.  Edges
+//! are added until finish is called.
+//
+//! @param letter the letter of the edge
+//! @param endsWord whether the edge ends a word
+//! @param endsNode whether the edge is the last edge of its node
+//! @param child the node the edge leads to, or 0 if none
+//! @return true if successful, false if the letter cannot be encoded
+//---------------------------------------------------------------------------
+bool
+SuccinctDawg::addEdge(ushort letter, bool endsWord, bool endsNode, qint32
+                      child)
+{
+    if (letter >= 256)
+        return false;
+    if (codes[letter] < 0) {
+        if (letters.size() == NUM_CODES)
+            return false;
+        codes[letter] = qint8(letters.size());
+        letters.append(letter);
+    }
+
+    quint8 label = quint8(codes[letter]);
+    if (endsWord)
+        label |= END_OF_WORD;
+    if (endsNode)
+        label |= END_OF_NODE;
+
+    if ((numEdges & 31) == 0)
+        childBits.append(0);
+    if (child) {
+        label |= HAS_CHILD;
+        childBits.last() |= (1U << (numEdges & 31));
+        children.append(child);
+    }
+
+    labels.append(label);
+    ++numEdges;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  finish
+//
+//! Pack the node pointers of the edges added, and count the has-child bits
+//! of each block, after the last edge is added.
+//---------------------------------------------------------------------------
+void
+SuccinctDawg::finish()
+{
+    qint32 maxChild = 0;
+    foreach (qint32 child, children)
+        maxChild = qMax(maxChild, child);
+    pointerBits = 1;
+    while ((pointerBits < 31) && (maxChild >> pointerBits))
+        ++pointerBits;
+
+    pointers.fill(0, int((qint64(children.size()) * pointerBits + 63) / 64) +
+                 1);
+    for (int i = 0; i < children.size(); ++i) {
+        qint64 bitPos = qint64(i) * pointerBits;
+        int word = int(bitPos >> 6);
+        int offset = int(bitPos & 63);
+        quint64 value = quint64(children[i]);
+        pointers[word] |= (value << offset);
+        if (offset + pointerBits > 64)
+            pointers[word + 1] |= (value >> (64 - offset));
+    }
+
+    const int blockWords = RANK_BLOCK_EDGES / 32;
+    childRanks.clear();
+    quint32 rank = 0;
+    for (int i = 0; i < childBits.size(); ++i) {
+        if (i % blockWords == 0)
+            childRanks.append(rank);
+        rank += countBits(childBits[i]);
+    }
+
+    children.clear();
+    children.squeeze();
+    labels.squeeze();
+    childBits.squeeze();
+    childRanks.squeeze();
+    pointers.squeeze();
+}
+
+//---------------------------------------------------------------------------
+//  getChild
+//
+//! Get the node an edge leads to.
+//
+//! @param edge the edge
+//! @return the node, or 0 if the edge leads to no node
+//---------------------------------------------------------------------------
+qint32
+SuccinctDawg::getChild(qint32 edge) const
+{
+    if (!(labels[edge] & HAS_CHILD))
+        return 0;
+
+    // Rank the has-child bit of the edge to find its pointer
+    const int blockWords = RANK_BLOCK_EDGES / 32;
+    int word = edge >> 5;
+    quint32 rank = childRanks[word / blockWords];
+    for (int i = word - (word % blockWords); i < word; ++i)
+        rank += countBits(childBits[i]);
+    rank += countBits(childBits[word] & ((1U << (edge & 31)) - 1));
+
+    qint64 bitPos = qint64(rank) * pointerBits;
+    int pointerWord = int(bitPos >> 6);
+    int offset = int(bitPos & 63);
+    quint64 value = pointers[pointerWord] >> offset;
+    if (offset + pointerBits > 64)
+        value |= (pointers[pointerWord + 1] << (64 - offset));
+    return qint32(value & ((Q_UINT64_C(1) << pointerBits) - 1));
+}
+
+//---------------------------------------------------------------------------
+//  findEdge
+//
+//! Find the edge for a letter leaving a node.
+//
+//! @param node the node
+//! @param letter the letter
+//! @return the edge, or -1 if the node has no edge for the letter
+//---------------------------------------------------------------------------
+qint32
+SuccinctDawg::findEdge(qint32 node, ushort letter) const
+{
+    if (!node || (letter >= 256) || (codes[letter] < 0))
+        return -1;
+
+    quint8 code = quint8(codes[letter]);
+    for (qint32 edge = node; ; ++edge) {
+        quint8 label = labels[edge];
+        if ((label & CODE_MASK) == code)
+            return edge;
+        if (label & END_OF_NODE)
+            return -1;
+    }
+}
+
+//---------------------------------------------------------------------------
+//  findNode
+//
+//! Follow a sequence of letters from the root of the DAWG.
+//
+//! @param path the letters
+//! @return the node reached by the letters, or 0 if the letters are not
+//! all followed or no edges leave the node
+//---------------------------------------------------------------------------
+qint32
+SuccinctDawg::findNode(const QString& path) const
+{
+    if (!numEdges)
+        return 0;
+
+    qint32 node = ROOT_NODE;
+    int length = path.length();
+    for (int i = 0; (i < length) && node; ++i) {
+        qint32 edge = findEdge(node, path.at(i).unicode());
+        if (edge < 0)
+            return 0;
+        node = getChild(edge);
+    }
+    return node;
+}
+
+//---------------------------------------------------------------------------
+//  containsWord
+//
+//! Determine whether the DAWG contains a word.
+//
+//! @param word the word
+//! @return true if the DAWG contains the word, false otherwise
+//---------------------------------------------------------------------------
+bool
+SuccinctDawg::containsWord(const QString& word) const
+{
+    if (!numEdges || word.isEmpty())
+        return false;
+
+    qint32 node = ROOT_NODE;
+    bool eow = false;
+    int length = word.length();
+    for (int i = 0; i < length; ++i) {
+        qint32 edge = findEdge(node, word.at(i).unicode());
+        if (edge < 0)
+            return false;
+        eow = endsWord(edge);
+        node = getChild(edge);
+    }
+    return eow;
+}
+
+//---------------------------------------------------------------------------
+//  getSubtreePaths
+//
+//! Find the paths ending words below a node, by a depth-first traversal of
+//! the subtree below the node, so the paths come out in alphabetical order.
+//
+//! @param node the node
+//! @param maxLength the maximum length of paths to find
+//! @return the letters of each path below the node
+//---------------------------------------------------------------------------
+QStringList
+SuccinctDawg::getSubtreePaths(qint32 node, int maxLength) const
+{
+    QStringList paths;
+    if (!node || (maxLength < 1))
+        return paths;
+    if (maxLength > MAX_WORD_LEN + 1)
+        maxLength = MAX_WORD_LEN + 1;
+
+    // Hold the current edge at each depth
+    qint32 stack[MAX_WORD_LEN + 1];
+    QString path;
+    int depth = 0;
+    stack[depth++] = node;
+    while (depth) {
+        qint32 edge = stack[depth - 1];
+        path.truncate(depth - 1);
+        path.append(QChar(getLetter(edge)));
+        if (endsWord(edge))
+            paths.append(path);
+
+        qint32 child = getChild(edge);
+        if (child && (depth < maxLength)) {
+            stack[depth++] = child;
+            continue;
+        }
+
+        // Move to the next edge, leaving the nodes whose edges are done
+        while (depth && endsNode(stack[depth - 1]))
+            --depth;
+        if (depth)
+            ++stack[depth - 1];
+    }
+
+    return paths;
+}
+
+//---------------------------------------------------------------------------
+//  getMemoryUsage
+//
+//! Estimate the memory used by the encoded edges.
+//
+//! @return the number of bytes
+//---------------------------------------------------------------------------
+qint64
+SuccinctDawg::getMemoryUsage() const
+{
+    return qint64(labels.capacity()) +
+        qint64(childBits.capacity()) * sizeof(quint32) +
+        qint64(childRanks.capacity()) * sizeof(quint32) +
+        qint64(pointers.capacity()) * sizeof(quint64) +
+        qint64(letters.capacity()) * sizeof(ushort) + sizeof(codes);
+}
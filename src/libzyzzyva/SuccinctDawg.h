@@ -0,0 +1,88 @@
+//---------------------------------------------------------------------------
+// SuccinctDawg.h
+//
+// A class for holding a DAWG in a compact encoding.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_SUCCINCT_DAWG_H
+#define ZYZZYVA_SUCCINCT_DAWG_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// The edges of a DAWG, numbered as in the packed 32-bit format, with each
+// edge in one byte holding the code of its letter and its end-of-word,
+// end-of-node and has-child bits.  Only edges with a child have a node
+// pointer, packed in as few bits as the largest pointer needs, and the
+// pointer of an edge is found by ranking its has-child bit.  The rank of a
+// bit is the count stored for its block of bits plus the bits set before it
+// in the block.
+class SuccinctDawg
+{
+    public:
+    SuccinctDawg() { clear(); }
+    ~SuccinctDawg() { }
+
+    void clear();
+    bool addEdge(ushort letter, bool endsWord, bool endsNode, qint32 child);
+    void finish();
+
+    qint32 getNumEdges() const { return numEdges; }
+    ushort getLetter(qint32 edge) const {
+        return letters[labels[edge] & CODE_MASK]; }
+    bool endsWord(qint32 edge) const {
+        return (labels[edge] & END_OF_WORD) != 0; }
+    bool endsNode(qint32 edge) const {
+        return (labels[edge] & END_OF_NODE) != 0; }
+    qint32 getChild(qint32 edge) const;
+    qint32 findEdge(qint32 node, ushort letter) const;
+    qint32 findNode(const QString& path) const;
+    bool containsWord(const QString& word) const;
+    QStringList getSubtreePaths(qint32 node, int maxLength) const;
+    qint64 getMemoryUsage() const;
+
+    private:
+    static const quint8 CODE_MASK = 0x1F;
+    static const quint8 END_OF_WORD = 0x20;
+    static const quint8 END_OF_NODE = 0x40;
+    static const quint8 HAS_CHILD = 0x80;
+    static const int NUM_CODES = 32;
+
+    // Edges counted by each stored rank, a multiple of 32
+    static const int RANK_BLOCK_EDGES = 256;
+
+    qint32 numEdges;
+    int pointerBits;
+    QVector<quint8> labels;
+    QVector<quint32> childBits;
+    QVector<quint32> childRanks;
+    QVector<quint64> pointers;
+
+    // The letter of each code, and the code of each letter, or -1
+    QVector<ushort> letters;
+    qint8 codes[256];
+
+    // The child of each edge with a child, until packed by finish
+    QVector<qint32> children;
+};
+
+#endif // ZYZZYVA_SUCCINCT_DAWG_H
@@ -0,0 +1,260 @@
+//---------------------------------------------------------------------------
+// Trace.cpp
+//
+// Macros and classes for recording timed trace events in hot paths.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "Trace.h"
+#include "Auxil.h"
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThreadStorage>
+
+// The number of events kept for each thread
+const int TRACE_BUFFER_EVENTS = 16384;
+
+class TraceEvent {
+    public:
+    const char* name;
+    qint64 start;
+    qint64 duration;
+    int threadId;
+};
+
+// The events of one thread.  Only the owning thread writes events, and it
+// publishes each one by advancing the count, so readers need no lock.  A
+// buffer released by a thread that exits keeps its events and is reused
+// by the next thread that records one.
+class TraceBuffer {
+    public:
+    TraceBuffer() : events(new TraceEvent[TRACE_BUFFER_EVENTS]), count(0),
+                    threadId(0), inUse(false) { }
+    ~TraceBuffer() { delete[] events; }
+
+    TraceEvent* events;
+    QAtomicInt count;
+    int threadId;
+    bool inUse;
+};
+
+// A reference to the buffer of a thread, deleted by the thread storage
+// when the thread exits
+class TraceBufferRef {
+    public:
+    TraceBufferRef(TraceBuffer* b) : buffer(b) { }
+    ~TraceBufferRef();
+
+    TraceBuffer* buffer;
+};
+
+// The clock every event is timed by, started when the library is loaded
+class TraceClock {
+    public:
+    TraceClock() { timer.start(); }
+    QElapsedTimer timer;
+};
+
+static TraceClock traceClock;
+static QThreadStorage<TraceBufferRef*> threadBuffers;
+
+// Guards the list of buffers and their owners, not their events
+static QMutex bufferMutex;
+static QList<TraceBuffer*> buffers;
+static int nextThreadId = 1;
+
+//---------------------------------------------------------------------------
+//  ~TraceBufferRef
+//
+//! Destructor.  Release the buffer for reuse by another thread.
+//---------------------------------------------------------------------------
+TraceBufferRef::~TraceBufferRef()
+{
+    QMutexLocker locker (&bufferMutex);
+    buffer->inUse = false;
+}
+
+//---------------------------------------------------------------------------
+//  getThreadBuffer
+//
+//! Get the buffer of the calling thread, taking a released buffer or
+//! creating one the first time the thread records an event.
+//
+//! @return the buffer
+//---------------------------------------------------------------------------
+static TraceBuffer*
+getThreadBuffer()
+{
+    if (threadBuffers.hasLocalData())
+        return threadBuffers.localData()->buffer;
+
+    QMutexLocker locker (&bufferMutex);
+    TraceBuffer* buffer = 0;
+    foreach (TraceBuffer* b, buffers) {
+        if (!b->inUse) {
+            buffer = b;
+            break;
+        }
+    }
+    if (!buffer) {
+        buffer = new TraceBuffer;
+        buffers.append(buffer);
+    }
+    buffer->inUse = true;
+    buffer->threadId = nextThreadId++;
+    threadBuffers.setLocalData(new TraceBufferRef(buffer));
+    return buffer;
+}
+
+//---------------------------------------------------------------------------
+//  isEnabled
+//
+//! Determine whether tracing is compiled in.
+//
+//! @return true if tracing is enabled, false otherwise
+//---------------------------------------------------------------------------
+bool
+Trace::isEnabled()
+{
+#if defined Z_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------
+//  getTime
+//
+//! Get the time on the trace clock.
+//
+//! @return the time in nanoseconds since the library was loaded
+//---------------------------------------------------------------------------
+qint64
+Trace::getTime()
+{
+    return traceClock.timer.nsecsElapsed();
+}
+
+//---------------------------------------------------------------------------
+//  addEvent
+//
+//! Record an event in the buffer of the calling thread.
+//
+//! @param name the name of the event, which must outlive the program
+//! @param start the start time of the event in nanoseconds
+//! @param duration the duration of the event in nanoseconds
+//---------------------------------------------------------------------------
+void
+Trace::addEvent(const char* name, qint64 start, qint64 duration)
+{
+    TraceBuffer* buffer = getThreadBuffer();
+    int count = buffer->count;
+    TraceEvent& event = buffer->events[count % TRACE_BUFFER_EVENTS];
+    event.name = name;
+    event.start = start;
+    event.duration = duration;
+    event.threadId = buffer->threadId;
+    buffer->count.fetchAndStoreRelease(count + 1);
+}
+
+//---------------------------------------------------------------------------
+//  getDefaultFilename
+//
+//! Get the name of the file traces are written to on exit.
+//
+//! @return the name of the file
+//---------------------------------------------------------------------------
+QString
+Trace::getDefaultFilename()
+{
+    return Auxil::getUserDir() + "/trace.json";
+}
+
+//---------------------------------------------------------------------------
+//  writeFile
+//
+//! Write the recorded events of every thread to a file in the Chrome
+//! trace event format, which chrome://tracing and other trace viewers can
+//! load.
+//
+//! @param filename the name of the file
+//! @param errString returns an error string on failure
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+Trace::writeFile(const QString& filename, QString* errString)
+{
+    QFile file (filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate |
+                   QIODevice::Text))
+    {
+        if (errString)
+            *errString = file.errorString();
+        return false;
+    }
+
+    QList<TraceEvent> events;
+    {
+        QMutexLocker locker (&bufferMutex);
+        foreach (TraceBuffer* buffer, buffers) {
+            int count = buffer->count.fetchAndAddAcquire(0);
+            int first = qMax(0, count - TRACE_BUFFER_EVENTS);
+            QList<TraceEvent> bufferEvents;
+            for (int i = first; i < count; ++i)
+                bufferEvents.append(buffer->events[i % TRACE_BUFFER_EVENTS]);
+
+            // Drop the events the owning thread may have overwritten while
+            // they were copied
+            int newCount = buffer->count.fetchAndAddAcquire(0);
+            int skip = qMax(0, newCount - TRACE_BUFFER_EVENTS - first);
+            events += bufferEvents.mid(qMin(skip, bufferEvents.size()));
+        }
+    }
+
+    QTextStream stream (&file);
+    stream << "{\"traceEvents\":[";
+    for (int i = 0; i < events.size(); ++i) {
+        const TraceEvent& event = events[i];
+        QString name = QString::fromLatin1(event.name);
+        name.replace("\\", "\\\\");
+        name.replace("\"", "\\\"");
+        if (i)
+            stream << ",";
+        stream << "\n{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,"
+            << "\"tid\":" << event.threadId << ",\"ts\":"
+            << QString::number(event.start / 1000.0, 'f', 3) << ",\"dur\":"
+            << QString::number(event.duration / 1000.0, 'f', 3) << "}";
+    }
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    stream.flush();
+
+    if (stream.status() != QTextStream::Ok) {
+        if (errString)
+            *errString = file.errorString();
+        return false;
+    }
+    return true;
+}
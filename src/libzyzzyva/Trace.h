@@ -0,0 +1,72 @@
+//---------------------------------------------------------------------------
+// Trace.h
+//
+// Macros and classes for recording timed trace events in hot paths.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_TRACE_H
+#define ZYZZYVA_TRACE_H
+
+#include <QString>
+#include <QtGlobal>
+
+// Tracing is compiled in only when Z_TRACE is defined, by building with
+// BUILD=trace.  Otherwise the macros expand to nothing, and the file
+// written by Trace::writeFile has no events.
+#if defined Z_TRACE
+#define Z_TRACE_CONCAT_(a, b) a ## b
+#define Z_TRACE_CONCAT(a, b) Z_TRACE_CONCAT_(a, b)
+
+// Record an event lasting from here to the end of the enclosing scope.
+// The name must be a string literal.
+#define Z_TRACE_SCOPE(name) \
+    TraceScope Z_TRACE_CONCAT(traceScope_, __LINE__) (name)
+#else
+#define Z_TRACE_SCOPE(name) ((void) 0)
+#endif
+
+// Events are kept in a fixed buffer for each thread, written only by that
+// thread, so recording an event takes no lock.  When a buffer is full the
+// oldest events of the thread are overwritten.
+class Trace
+{
+    public:
+    static bool isEnabled();
+    static qint64 getTime();
+    static void addEvent(const char* name, qint64 start, qint64 duration);
+    static QString getDefaultFilename();
+    static bool writeFile(const QString& filename, QString* errString = 0);
+};
+
+// An event lasting for the lifetime of the object - see Z_TRACE_SCOPE
+class TraceScope
+{
+    public:
+    TraceScope(const char* n) : name(n), start(Trace::getTime()) { }
+    ~TraceScope() {
+        Trace::addEvent(name, start, Trace::getTime() - start); }
+
+    private:
+    const char* name;
+    qint64 start;
+};
+
+#endif // ZYZZYVA_TRACE_H
@@ -23,16 +23,26 @@
 //---------------------------------------------------------------------------
 
 #include "WordEngine.h"
+#include "DatabaseIndexSet.h"
 #include "LetterBag.h"
+#include "LetterSignature.h"
+#include "LexiconSnapshot.h"
+#include "MainSettings.h"
+#include "Trace.h"
 #include "Auxil.h"
 #include "Defs.h"
 #include <QApplication>
+#include <QDataStream>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QRegExp>
 #include <QSqlError>
 #include <QSqlQuery>
+#include <QThread>
 #include <QVariant>
 #include <QVector>
+#include <algorithm>
 
 using namespace Defs;
 
@@ -44,6 +54,135 @@ const QString WordEngine::DEF_DISPLAY_SEP = " / ";
 
 const int LIMIT_RANGE_MAX = 999999;
 
+// Lexicon databases are only read once built, except for deferred indexes,
+// which are created through connections of their own.  The connections of
+// every thread share one page cache.
+const QString DB_CONNECT_OPTIONS =
+    "QSQLITE_OPEN_READONLY;QSQLITE_ENABLE_SHARED_CACHE";
+
+// Approximate sizes of the allocations behind a cached word, beyond the
+// characters of its strings
+const int CACHE_ENTRY_BYTES = 64;
+const int CACHE_STRING_BYTES = 24;
+const int CACHE_MAP_NODE_BYTES = 32;
+
+// Estimated memory used by each search result cache entry and each word
+// in it, apart from its characters
+const int SEARCH_CACHE_ENTRY_BYTES = 64;
+const int SEARCH_CACHE_WORD_BYTES = 32;
+
+// Estimated memory used by each definition cache entry, apart from its
+// characters
+const int DEFINITION_CACHE_ENTRY_BYTES = 64;
+
+// Approximate sizes of the allocations behind each container and each map
+// or hash node of a lexicon, apart from their contents - see memoryReport
+const int CONTAINER_BYTES = 32;
+const int NODE_BYTES = 32;
+
+// Largest number of words checked against Definition or Part of Speech
+// conditions after being found in the definition index
+const int MAX_DEFINITION_CANDIDATES = 5000;
+
+// Number of words looked up by each statement when filling the word cache
+const int CACHE_QUERY_CHUNK_SIZE = 256;
+
+// Searches taking at least this long have their results saved for later
+// sessions
+const int SAVED_RESULTS_MIN_MSECS = 200;
+
+// A saved word cache file holds a 32-bit magic number and format version,
+// the database build the words were read from, the number of words and the
+// information for each word, in QDataStream format
+const quint32 WORD_CACHE_MAGIC = 0x5a595743;
+const quint32 WORD_CACHE_VERSION = 1;
+
+// Largest estimated number of candidate words for which a search is driven
+// from the database or a word list instead of the word graph
+const int MAX_PLANNED_CANDIDATES = 2000;
+
+// Number of intervals between the words of a snapshot checked against the
+// word graph before the snapshot is used
+const int SNAPSHOT_SAMPLE_WORDS = 16;
+
+//---------------------------------------------------------------------------
+//  getStringBytes
+//
+//! Estimate the memory used by a string held in a container.  Strings that
+//! share their characters are counted separately.
+//
+//! @param str the string
+//! @return the estimated number of bytes
+//---------------------------------------------------------------------------
+static inline qint64
+getStringBytes(const QString& str)
+{
+    return CACHE_STRING_BYTES + str.capacity() * sizeof(QChar);
+}
+
+//---------------------------------------------------------------------------
+//  getWordBytes
+//
+//! Estimate the memory used by a compact word held in a container.
+//
+//! @param word the word
+//! @return the estimated number of bytes
+//---------------------------------------------------------------------------
+static inline qint64
+getWordBytes(const CompactWord& word)
+{
+    return CACHE_STRING_BYTES + word.getBytes().capacity();
+}
+
+//---------------------------------------------------------------------------
+//  getResultHash
+//
+//! Determine the search result cache hash of an optimized search, which
+//! also depends on whether the results are all caps.
+//
+//! @param spec the optimized search specification
+//! @param allCaps whether the words in the results are all caps
+//! @return the hash
+//---------------------------------------------------------------------------
+static inline quint64
+getResultHash(const WordEngine::OptimizedSpec& spec, bool allCaps)
+{
+    return (spec.hash << 1) | (allCaps ? 1 : 0);
+}
+
+//---------------------------------------------------------------------------
+//  getVectorBytes
+//
+//! Estimate the memory used by a vector.
+//
+//! @param vector the vector
+//! @return the estimated number of bytes
+//---------------------------------------------------------------------------
+template <typename T>
+static inline qint64
+getVectorBytes(const QVector<T>& vector)
+{
+    return vector.capacity() * sizeof(T);
+}
+
+//---------------------------------------------------------------------------
+//  addMemoryUsage
+//
+//! Add the estimated memory used by a structure to a memory report, unless
+//! the structure is empty.
+//
+//! @param usage the list of structures of a lexicon
+//! @param structure the name of the structure
+//! @param bytes the estimated number of bytes
+//---------------------------------------------------------------------------
+static void
+addMemoryUsage(QList<WordEngine::MemoryUsage>* usage, const QString&
+               structure, qint64 bytes)
+{
+    if (bytes > 0)
+        usage->append(WordEngine::MemoryUsage(structure, bytes));
+}
+
 //---------------------------------------------------------------------------
 //  clearCache
 //
@@ -61,2019 +200,7503 @@ WordEngine::clearCache(const QString& lexicon) const
 }
 
 //---------------------------------------------------------------------------
-//  connectToDatabase
-//
-//! Initialize the database connection for a lexicon.
+//  clearSearchCaches
 //
-//! @param lexicon the name of the lexicon
-//! @param filename the name of the database file
-//! @param errString returns the error string in case of error
-//! @return true if successful, false otherwise
+//! Clear the optimized spec, search result and definition caches of all
+//! lexicons.
+//! Searches in one lexicon may depend on another lexicon, so every cache is
+//! cleared whenever any lexicon or lexicon database changes.
 //---------------------------------------------------------------------------
-bool
-WordEngine::connectToDatabase(const QString& lexicon, const QString& filename,
-                              QString* errString)
+void
+WordEngine::clearSearchCaches() const
 {
-    if (!lexiconData.contains(lexicon))
-        return false;
-
-    Rand rng;
-    rng.srand(QDateTime::currentDateTime().toTime_t(), Auxil::getPid());
-    unsigned int r = rng.rand();
-    QString dbConnectionName = "WordEngine_" + lexicon + "_" +
-        QString::number(r);
-
-    QSqlDatabase* db = new QSqlDatabase(
-        QSqlDatabase::addDatabase("QSQLITE", dbConnectionName));
-    db->setDatabaseName(filename);
-    bool ok = db->open();
-
-    if (!ok) {
-        dbConnectionName = QString();
-        if (errString)
-            *errString = db->lastError().text();
-        // delete db?
-        return false;
+    QMapIterator<QString, LexiconData*> it (lexiconData);
+    while (it.hasNext()) {
+        it.next();
+        it.value()->specCache.clear();
+        it.value()->searchCache.clear();
+        it.value()->definitionCache.clear();
     }
-
-    LexiconData* data = lexiconData[lexicon];
-    data->db = db;
-    data->dbConnectionName = dbConnectionName;
-    return true;
 }
 
 //---------------------------------------------------------------------------
-//  disconnectFromDatabase
+//  initLexiconData
 //
-//! Remove the database connection for a lexicon.
+//! Create the data for a lexicon if it does not exist, with caches limited
+//! to the sizes in the settings.
 //
 //! @param lexicon the name of the lexicon
-//! @return true if successful, false otherwise
 //---------------------------------------------------------------------------
-bool
-WordEngine::disconnectFromDatabase(const QString& lexicon)
+void
+WordEngine::initLexiconData(const QString& lexicon)
 {
-    if (!lexiconData.contains(lexicon))
-        return true;
-
-    QSqlDatabase* db = lexiconData[lexicon]->db;
-    QString dbConnectionName = lexiconData[lexicon]->dbConnectionName;
-    if (!db || !db->isOpen() || dbConnectionName.isEmpty())
-        return true;
+    if (lexiconData.contains(lexicon))
+        return;
 
-    delete db;
-    lexiconData[lexicon]->db = 0;
-    QSqlDatabase::removeDatabase(dbConnectionName);
-    lexiconData[lexicon]->dbConnectionName.clear();
-    return true;
+    LexiconData* data = new LexiconData;
+    data->wordCache.setMaxBytes(
+        MainSettings::getWordCacheSize() * 1024 * 1024);
+    data->searchCache.setMaxBytes(
+        MainSettings::getSearchCacheSize() * 1024 * 1024);
+    lexiconData[lexicon] = data;
 }
 
 //---------------------------------------------------------------------------
-//  databaseIsConnected
+//  loadSnapshot
 //
-//! Determine whether a lexicon database is connected.
+//! Open the snapshot of a lexicon database, if it exists and was made from
+//! the current contents of the database file.  Otherwise the database is
+//! read instead.
 //
 //! @param lexicon the name of the lexicon
-//! @return true if the database is connected, false otherwise
+//! @param filename the name of the database file
 //---------------------------------------------------------------------------
-bool
-WordEngine::databaseIsConnected(const QString& lexicon) const
+void
+WordEngine::loadSnapshot(const QString& lexicon, const QString& filename)
 {
-    return (lexiconData.contains(lexicon) && lexiconData[lexicon]->db);
+    if (!lexiconData.contains(lexicon))
+        return;
+
+    LexiconData* data = lexiconData[lexicon];
+    delete data->snapshot;
+    data->snapshot = 0;
+
+    LexiconSnapshot* snapshot = new LexiconSnapshot;
+    if (snapshot->open(LexiconSnapshot::getFilename(filename)) &&
+        snapshot->matchesDatabase(filename))
+    {
+        data->snapshot = snapshot;
+    }
+    else {
+        delete snapshot;
+    }
 }
 
 //---------------------------------------------------------------------------
-//  importTextFile
+//  loadWordAttributes
 //
-//! Import words from a text file.  The file is assumed to be in plain text
-//! format, containing one word per line.
+//! Load the numeric word attributes of a lexicon from its database into
+//! arrays indexed by word, so they can be read without querying the
+//! database.  The attributes can only be loaded if the word graph can find
+//! the alphabetical index of each word.  The combinations of each alphagram
+//! are also loaded into the combination cache.
 //
 //! @param lexicon the name of the lexicon
-//! @param filename the name of the file to import
-//! @param loadDefinitions whether to load word definitions
-//! @param errString returns the error string in case of error
-//! @return the number of words imported
 //---------------------------------------------------------------------------
-int
-WordEngine::importTextFile(const QString& lexicon, const QString& filename,
-                           bool loadDefinitions, QString* errString)
+void
+WordEngine::loadWordAttributes(const QString& lexicon)
 {
-    // Delete old word graph if it exists
-    if (lexiconData.contains(lexicon))
-        delete lexiconData[lexicon]->graph;
-    else
-        lexiconData[lexicon] = new LexiconData;
+    if (!lexiconData.contains(lexicon))
+        return;
 
-    WordGraph* graph = new WordGraph;
-    lexiconData[lexicon]->graph = graph;
-    lexiconData[lexicon]->lexiconFile = filename;
+    LexiconData* data = lexiconData[lexicon];
+    data->attributes.clear();
+    data->combinationCache.clear();
 
-    QFile file (filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        if (errString) {
-            *errString = "Can't open file '" + filename + "': " +
-                file.errorString();
-        }
-        return 0;
-    }
+    WordGraph* graph = data->graph;
+    QSqlDatabase* db = data->db;
+    if (!graph || !graph->hasWordCounts() || !db || !db->isOpen())
+        return;
 
-    int imported = 0;
-    char* buffer = new char[MAX_INPUT_LINE_LEN];
-    while (file.readLine(buffer, MAX_INPUT_LINE_LEN) > 0) {
-        QString line (buffer);
-        line = line.simplified();
-        if (!line.length() || (line.at(0) == '#'))
+    if (data->snapshot && loadSnapshotAttributes(data))
+        return;
+
+    QString qstr = "SELECT word, num_vowels, num_unique_letters, "
+        "num_anagrams, point_value, is_front_hook, is_back_hook, "
+        "playability, "
+        "playability_order, min_playability_order, max_playability_order, "
+        "probability_order0, min_probability_order0, max_probability_order0, "
+        "probability_order1, min_probability_order1, max_probability_order1, "
+        "probability_order2, min_probability_order2, max_probability_order2, "
+        "combinations0, combinations1, combinations2 "
+        "FROM words";
+
+    QSqlQuery query (*db);
+    query.setForwardOnly(true);
+    if (!query.exec(qstr))
+        return;
+
+    WordAttributes attributes;
+    attributes.resize(graph->getNumWords());
+    int numWords = attributes.flags.size();
+
+    while (query.next()) {
+        QString word = query.value(0).toString();
+        int id = graph->indexOf(word);
+        if ((id < 0) || (id >= numWords))
             continue;
-        QString word = line.section(' ', 0, 0).toUpper();
 
-        if (!graph->containsWord(word)) {
-            QString alpha = Auxil::getAlphagram(word);
-            ++lexiconData[lexicon]->numAnagramsMap[alpha];
+        int placeNum = 1;
+        attributes.numVowels[id] = query.value(placeNum++).toInt();
+        attributes.numUniqueLetters[id] = query.value(placeNum++).toInt();
+        attributes.numAnagrams[id] = query.value(placeNum++).toInt();
+        attributes.pointValue[id] = query.value(placeNum++).toInt();
+
+        quint8 flags = WordAttributes::ValidFlag;
+        if (query.value(placeNum++).toBool())
+            flags |= WordAttributes::FrontHookFlag;
+        if (query.value(placeNum++).toBool())
+            flags |= WordAttributes::BackHookFlag;
+        attributes.flags[id] = flags;
+
+        attributes.playability[id] = query.value(placeNum++).toLongLong();
+        for (int i = 0; i < 3; ++i) {
+            attributes.playabilityOrders[3 * id + i] =
+                query.value(placeNum++).toInt();
+        }
+        for (int i = 0; i < 9; ++i) {
+            attributes.probabilityOrders[9 * id + i] =
+                query.value(placeNum++).toInt();
         }
 
-        graph->addWord(word);
-        if (loadDefinitions) {
-            QString definition = line.section(' ', 1);
-            addDefinition(lexicon, word, definition);
+        quint64 alphagramKey = Auxil::getAlphagramKey(word);
+        for (int i = 0; i <= MAX_STORED_BLANKS; ++i, ++placeNum) {
+            if (CombinationCache::canCache(alphagramKey, i)) {
+                data->combinationCache.insert(alphagramKey, i,
+                    query.value(placeNum).toDouble());
+            }
         }
-        ++imported;
     }
 
-    delete[] buffer;
-    return imported;
+    data->attributes = attributes;
 }
 
 //---------------------------------------------------------------------------
-//  importDawgFile
+//  loadSnapshotAttributes
 //
-//! Import words from a DAWG file as generated by Graham Toal's dawgutils
-//! programs: http://www.gtoal.com/wordgames/dawgutils/
+//! Load the numeric word attributes of a lexicon from its snapshot, by
+//! copying the snapshot columns.  The snapshot is only used if its words
+//! are in the same order as the words of the word graph, which is checked
+//! for a sample of words.
 //
-//! @param lexicon the name of the lexicon
-//! @param filename the name of the DAWG file to import
-//! @param reverse whether the DAWG contains reversed words
-//! @param errString returns the error string in case of error
-//! @return true if successful, false otherwise
+//! @param data the lexicon data
+//! @return true if successful, false if the snapshot does not match the
+//! word graph
 //---------------------------------------------------------------------------
 bool
-WordEngine::importDawgFile(const QString& lexicon, const QString& filename,
-                           bool reverse, QString* errString, quint16*
-                           expectedChecksum)
+WordEngine::loadSnapshotAttributes(LexiconData* data)
 {
-    if (!lexiconData.contains(lexicon)) {
-        lexiconData[lexicon] = new LexiconData;
-        lexiconData[lexicon]->graph = new WordGraph;
+    const LexiconSnapshot* snapshot = data->snapshot;
+    WordGraph* graph = data->graph;
+    int numWords = graph->getNumWords();
+    if (!numWords || (snapshot->getNumWords() != numWords))
+        return false;
+
+    for (int i = 0; i <= SNAPSHOT_SAMPLE_WORDS; ++i) {
+        int id = int(qint64(numWords - 1) * i / SNAPSHOT_SAMPLE_WORDS);
+        QString word = snapshot->getString(LexiconSnapshot::WordColumn, id);
+        if (graph->indexOf(word) != id)
+            return false;
     }
 
-    WordGraph* graph = lexiconData[lexicon]->graph;
-    bool ok = graph->importDawgFile(filename, reverse, errString,
-                                    expectedChecksum);
-    return ok;
+    WordAttributes attributes;
+    attributes.resize(numWords);
+
+    const quint8* flags =
+        snapshot->getByteColumn(LexiconSnapshot::FlagsColumn);
+    for (int id = 0; id < numWords; ++id) {
+        quint8 f = WordAttributes::ValidFlag;
+        if (flags[id] & LexiconSnapshot::FrontHookFlag)
+            f |= WordAttributes::FrontHookFlag;
+        if (flags[id] & LexiconSnapshot::BackHookFlag)
+            f |= WordAttributes::BackHookFlag;
+        attributes.flags[id] = f;
+    }
+
+    qMemCopy(attributes.numVowels.data(),
+        snapshot->getByteColumn(LexiconSnapshot::NumVowelsColumn), numWords);
+    qMemCopy(attributes.numUniqueLetters.data(),
+        snapshot->getByteColumn(LexiconSnapshot::NumUniqueLettersColumn),
+        numWords);
+    qMemCopy(attributes.numAnagrams.data(),
+        snapshot->getByteColumn(LexiconSnapshot::NumAnagramsColumn),
+        numWords);
+    qMemCopy(attributes.pointValue.data(),
+        snapshot->getByteColumn(LexiconSnapshot::PointValueColumn),
+        numWords);
+    qMemCopy(attributes.playability.data(), snapshot->getPlayability(),
+             numWords * sizeof(qint64));
+    qMemCopy(attributes.playabilityOrders.data(),
+             snapshot->getPlayabilityOrders(), 3 * numWords * sizeof(qint32));
+    qMemCopy(attributes.probabilityOrders.data(),
+             snapshot->getProbabilityOrders(), 9 * numWords * sizeof(qint32));
+
+    const double* combinations = snapshot->getCombinations();
+    for (int id = 0; id < numWords; ++id) {
+        quint64 alphagramKey = Auxil::getAlphagramKey(
+            snapshot->getString(LexiconSnapshot::WordColumn, id));
+        for (int i = 0; i <= MAX_STORED_BLANKS; ++i) {
+            if (CombinationCache::canCache(alphagramKey, i)) {
+                data->combinationCache.insert(alphagramKey, i,
+                    combinations[3 * id + i]);
+            }
+        }
+    }
+
+    data->attributes = attributes;
+    return true;
 }
 
 //---------------------------------------------------------------------------
-//  importStems
+//  loadAnagramIndex
 //
-//! Import stems for a lexicon from a file.  The file is assumed to be in
-//! plain text format, containing one stem per line.  The file is also assumed
-//! to contain stems of equal length.  All stems of different length than the
-//! first stem will be discarded.
+//! Group the words of a lexicon by alphagram.  The words can only be
+//! grouped if the word graph can find the alphabetical index of each word.
 //
 //! @param lexicon the name of the lexicon
-//! @param filename the name of the file to import
-//! @param errString returns the error string in case of error
-//! @return the number of stems imported
 //---------------------------------------------------------------------------
-int
-WordEngine::importStems(const QString& lexicon, const QString& filename,
-                        QString* errString)
+void
+WordEngine::loadAnagramIndex(const QString& lexicon)
 {
     if (!lexiconData.contains(lexicon))
-        return 0;
+        return;
 
-    QFile file (filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        if (errString) {
-            *errString = "Can't open file '" + filename + "': " +
-                file.errorString();
-        }
-        return -1;
-    }
+    LexiconData* data = lexiconData[lexicon];
+    AnagramIndex& index = data->anagramIndex;
+    index.clear();
+    data->stemIndexes.clear();
 
-    // XXX: At some point, may want to consider allowing words of varying
-    // lengths to be in the same file?
-    QStringList words;
-    QSet<QString> alphagrams;
-    int imported = 0;
-    int length = 0;
-    char* buffer = new char[MAX_INPUT_LINE_LEN];
-    while (file.readLine(buffer, MAX_INPUT_LINE_LEN) > 0) {
-        QString line (buffer);
-        line = line.simplified();
-        if (!line.length() || (line.at(0) == '#'))
+    WordGraph* graph = data->graph;
+    if (!graph || !graph->hasWordCounts())
+        return;
+
+    SearchCondition condition;
+    condition.type = SearchCondition::PatternMatch;
+    condition.stringValue = "*";
+    SearchSpec spec;
+    spec.conditions.append(condition);
+    QStringList words = graph->search(spec);
+
+    // Count the words of each alphagram, and collect the letters they use
+    QVector<QString> alphagrams;
+    QVector<qint32> ids;
+    QSet<QChar> letters;
+    alphagrams.reserve(words.size());
+    ids.reserve(words.size());
+    foreach (const QString& word, words) {
+        QString wordUpper = word.toUpper();
+        qint32 id = graph->indexOf(wordUpper);
+        if (id < 0)
             continue;
-        QString word = line.section(' ', 0, 0);
+        QString alphagram = Auxil::getAlphagram(wordUpper);
+        alphagrams.append(alphagram);
+        ids.append(id);
+        ++index.groups[alphagram].second;
+        for (int i = 0; i < wordUpper.length(); ++i)
+            letters.insert(wordUpper.at(i));
+    }
 
-        if (!length)
-            length = word.length();
+    QList<QChar> letterList = letters.toList();
+    qSort(letterList.begin(), letterList.end(),
+          Auxil::localeAwareLessThanQChar);
+    foreach (const QChar& letter, letterList)
+        index.letters.append(letter);
 
-        if (length != int(word.length()))
-            continue;
+    // Place the groups one after another, then fill each group in word
+    // order, leaving each group's pair as its start and end
+    qint32 offset = 0;
+    QMutableHashIterator<QString, QPair<qint32, qint32> > it (index.groups);
+    while (it.hasNext()) {
+        it.next();
+        qint32 count = it.value().second;
+        it.value() = qMakePair(offset, offset);
+        offset += count;
+    }
 
-        words << word;
-        alphagrams.insert(Auxil::getAlphagram(word));
-        ++imported;
+    index.wordIds.resize(offset);
+    for (int i = 0; i < ids.size(); ++i) {
+        QPair<qint32, qint32>& group = index.groups[alphagrams[i]];
+        index.wordIds[group.second++] = ids[i];
     }
-    delete[] buffer;
 
-    // Insert the stem list into the map, or append to an existing stem list
-    LexiconData* data = lexiconData[lexicon];
-    data->stems[length] += words;
-    data->stemAlphagrams[length].unite(alphagrams);
-    return imported;
+    loadStemIndexes(lexicon);
 }
 
 //---------------------------------------------------------------------------
-//  databaseSearch
+//  loadStemIndexes
 //
-//! Search the database for words matching the conditions in a search spec.
-//! If a word list is provided, also ensure that result words are in that
-//! list.
+//! Find the words formed by adding one letter to each imported stem of a
+//! lexicon, using the anagram index.  Each stem alphagram has at most 26
+//! longer alphagrams to look up, so the indexes are rebuilt whenever stems
+//! are imported or the anagram index is loaded.
 //
 //! @param lexicon the name of the lexicon
-//! @param optimizedSpec the search spec
-//! @param wordList optional list of words that results must be in
-//! @return a list of words matching the search spec
 //---------------------------------------------------------------------------
-QStringList
-WordEngine::databaseSearch(const QString& lexicon, const SearchSpec&
-                           optimizedSpec, const QStringList* wordList) const
+void
+WordEngine::loadStemIndexes(const QString& lexicon)
 {
-    if (!lexiconData.contains(lexicon) || !lexiconData[lexicon]->db)
-        return QStringList();
+    if (!lexiconData.contains(lexicon))
+        return;
 
-    // Build SQL query string
-    QSet<QString> tables;
+    LexiconData* data = lexiconData[lexicon];
+    data->stemIndexes.clear();
+    const AnagramIndex& anagramIndex = data->anagramIndex;
+    if (anagramIndex.isEmpty())
+        return;
+
+    QMapIterator<int, QSet<CompactWord> > it (data->stemAlphagrams);
+    while (it.hasNext()) {
+        it.next();
+        StemIndex& index = data->stemIndexes[it.key()];
+        foreach (const CompactWord& compactAlphagram, it.value()) {
+            QString alphagram = compactAlphagram.toString();
+            QVector<qint32> ids = findStemWords(anagramIndex, alphagram);
+            if (ids.isEmpty())
+                continue;
+            index.stemWords.insert(alphagram, ids);
+            foreach (qint32 id, ids)
+                index.wordStems[id].append(alphagram);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//  findStemWords
+//
+//! Find the words formed by adding one letter to the letters of a stem.
+//
+//! @param index the anagram index of the lexicon
+//! @param stemAlphagram the alphagram of the stem
+//! @return the alphabetical indexes of the words, in ascending order
+//---------------------------------------------------------------------------
+QVector<qint32>
+WordEngine::findStemWords(const AnagramIndex& index, const QString&
+                          stemAlphagram) const
+{
+    QVector<qint32> ids;
+    for (char c = 'A'; c <= 'Z'; ++c) {
+        QString alphagram = Auxil::getAlphagram(stemAlphagram + QChar(c));
+        QPair<qint32, qint32> group = index.groups.value(alphagram);
+        for (qint32 i = group.first; i < group.second; ++i)
+            ids.append(index.wordIds[i]);
+    }
+    WordIdList::normalize(&ids);
+    return ids;
+}
+
+//---------------------------------------------------------------------------
+//  loadSearchStats
+//
+//! Load the statistics used to estimate how many words a search will match
+//! from the database of a lexicon.  Databases built before the statistics
+//! were saved have them collected and saved the first time they are opened.
+//
+//! @param lexicon the name of the lexicon
+//---------------------------------------------------------------------------
+void
+WordEngine::loadSearchStats(const QString& lexicon)
+{
+    if (!lexiconData.contains(lexicon))
+        return;
+
+    LexiconData* data = lexiconData[lexicon];
+    data->searchStats.clear();
+
+    QSqlDatabase* db = data->db;
+    if (!db || !db->isOpen())
+        return;
+
+    if (!data->searchStats.load(*db) && data->searchStats.collect(*db))
+        data->searchStats.save(*db);
+}
+
+//---------------------------------------------------------------------------
+//  IndexJob
+//
+//! A job that runs queries creating indexes on a database file through its
+//! own connection, stopping between queries if it is cancelled.
+//---------------------------------------------------------------------------
+class WordEngine::IndexJob : public Job
+{
+    public:
+    IndexJob(const QString& f, const QStringList& q)
+        : Job(), filename(f), queries(q) { }
+    ~IndexJob() { }
+
+    protected:
+    void run() {
+        QString connectionName = "WordEngine_index_" +
+            QString::number(quintptr(this));
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE",
+                                                        connectionName);
+            db.setDatabaseName(filename);
+            if (db.open()) {
+                QSqlQuery query (db);
+                foreach (const QString& queryStr, queries) {
+                    if (isCancelled())
+                        break;
+                    query.exec(queryStr);
+                }
+                db.close();
+            }
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+
+    private:
+    QString filename;
+    QStringList queries;
+};
+
+//---------------------------------------------------------------------------
+//  loadIndexSets
+//
+//! Find the index sets that exist in the database of a lexicon, and the
+//! sets that are not to be created.
+//
+//! @param lexicon the name of the lexicon
+//---------------------------------------------------------------------------
+void
+WordEngine::loadIndexSets(const QString& lexicon)
+{
+    if (!lexiconData.contains(lexicon))
+        return;
+
+    LexiconData* data = lexiconData[lexicon];
+    QMutexLocker locker (&data->indexMutex);
+    data->indexSets.clear();
+
+    QSqlDatabase* db = data->db;
+    if (!db || !db->isOpen())
+        return;
+
+    QSet<QString> indexNames;
+    QSqlQuery query (*db);
+    query.setForwardOnly(true);
+    if (query.exec("SELECT name FROM sqlite_master WHERE type='index'")) {
+        while (query.next())
+            indexNames.insert(query.value(0).toString());
+    }
+
+    QList<DatabaseIndexSet> indexSets =
+        DatabaseIndexSet::getIndexSets(lexicon);
+    foreach (const DatabaseIndexSet& indexSet, indexSets) {
+        if ((indexSet.getMode() == DatabaseIndexSet::SkipMode) ||
+            indexNames.contains(indexSet.getIndexNames().toSet()))
+        {
+            data->indexSets.insert(indexSet.getName());
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//  requireIndexSets
+//
+//! Start creating the deferred index sets of a lexicon database that serve
+//! the conditions of a search spec, if they have not been created yet.
+//! The indexes are created in the background, so the search itself does
+//! not wait for them.
+//
+//! @param lexicon the name of the lexicon
+//! @param optimizedSpec the search spec
+//---------------------------------------------------------------------------
+void
+WordEngine::requireIndexSets(const QString& lexicon, const SearchSpec&
+                             optimizedSpec) const
+{
+    if (!lexiconData.contains(lexicon))
+        return;
+
+    QStringList names = DatabaseIndexSet::getSearchSetNames(optimizedSpec);
+    if (names.isEmpty())
+        return;
+
+    LexiconData* data = lexiconData[lexicon];
+    QMutexLocker locker (&data->indexMutex);
+    if (!data->db || data->indexSets.contains(names.toSet()))
+        return;
+
+    QStringList queries;
+    QList<DatabaseIndexSet> indexSets =
+        DatabaseIndexSet::getIndexSets(lexicon);
+    foreach (const DatabaseIndexSet& indexSet, indexSets) {
+        QString name = indexSet.getName();
+        if (!names.contains(name) || data->indexSets.contains(name))
+            continue;
+
+        // Sets to be built with the database are assumed to be missing
+        // only from databases built before they were declared, so they are
+        // also created here
+        data->indexSets.insert(name);
+        if (indexSet.getMode() != DatabaseIndexSet::SkipMode)
+            queries += indexSet.getCreateQueries();
+    }
+
+    if (queries.isEmpty())
+        return;
+
+    data->indexJobs.append(JobScheduler::getInstance()->submit(
+        new IndexJob(data->db->databaseName(), queries),
+        JobScheduler::IndexBuildingPriority));
+}
+
+//---------------------------------------------------------------------------
+//  waitForIndexJobs
+//
+//! Wait for the jobs creating indexes on the database of a lexicon to
+//! finish, and release them.
+//
+//! @param data the lexicon data
+//---------------------------------------------------------------------------
+void
+WordEngine::waitForIndexJobs(LexiconData* data)
+{
+    QMutexLocker locker (&data->indexMutex);
+    foreach (const JobPointer& job, data->indexJobs)
+        job->wait();
+    data->indexJobs.clear();
+    data->indexSets.clear();
+}
+
+//---------------------------------------------------------------------------
+//  getWordCacheFilename
+//
+//! Determine the name of the file the word cache of a lexicon is saved to.
+//
+//! @param lexicon the name of the lexicon
+//! @return the name of the file
+//---------------------------------------------------------------------------
+static QString
+getWordCacheFilename(const QString& lexicon)
+{
+    return Auxil::getUserDir() + "/lexicons/" + lexicon + ".wcache";
+}
+
+//---------------------------------------------------------------------------
+//  WordCacheJob
+//
+//! A job that reads the word cache of a lexicon saved in an earlier
+//! session, adding the words that are not in the cache yet.
+//---------------------------------------------------------------------------
+class WordEngine::WordCacheJob : public Job
+{
+    public:
+    WordCacheJob(WordInfoCache* c, const QString& f, const QString& b)
+        : Job(), cache(c), filename(f), build(b) { }
+    ~WordCacheJob() { }
+
+    protected:
+    void run() {
+        cache->load(filename, build);
+    }
+
+    private:
+    WordInfoCache* cache;
+    QString filename;
+    QString build;
+};
+
+//---------------------------------------------------------------------------
+//  startWordCacheJob
+//
+//! Start reading the word cache of a lexicon saved in an earlier session in
+//! the background, if saving word caches is enabled.
+//
+//! @param lexicon the name of the lexicon
+//---------------------------------------------------------------------------
+void
+WordEngine::startWordCacheJob(const QString& lexicon)
+{
+    LexiconData* data = lexiconData[lexicon];
+    waitForWordCacheJob(data);
+    if (!MainSettings::getSaveWordCache() || !data->db)
+        return;
+
+    data->wordCacheJob = JobScheduler::getInstance()->submit(
+        new WordCacheJob(&data->wordCache, getWordCacheFilename(lexicon),
+                         getDatabaseBuild(data)),
+        JobScheduler::CacheWarmingPriority);
+}
+
+//---------------------------------------------------------------------------
+//  waitForWordCacheJob
+//
+//! Stop the job reading the saved word cache of a lexicon, waiting for it
+//! if it has already started, and release it.  The cache only warms up
+//! lookups, so a job that has not started is cancelled.
+//
+//! @param data the lexicon data
+//---------------------------------------------------------------------------
+void
+WordEngine::waitForWordCacheJob(LexiconData* data)
+{
+    if (data->wordCacheJob.isNull())
+        return;
+
+    data->wordCacheJob->cancel();
+    data->wordCacheJob->wait();
+    data->wordCacheJob.clear();
+}
+
+//---------------------------------------------------------------------------
+//  getSavedResultsDir
+//
+//! Determine the name of the directory the search results of a lexicon are
+//! saved in.
+//
+//! @param lexicon the name of the lexicon
+//! @return the name of the directory
+//---------------------------------------------------------------------------
+static QString
+getSavedResultsDir(const QString& lexicon)
+{
+    return Auxil::getUserDir() + "/lexicons/" + lexicon + ".results";
+}
+
+//---------------------------------------------------------------------------
+//  getSavedResultsFilename
+//
+//! Determine the name of the file the results of a search are saved to.
+//
+//! @param lexicon the name of the lexicon
+//! @param hash the search result cache hash of the search
+//! @return the name of the file
+//---------------------------------------------------------------------------
+static QString
+getSavedResultsFilename(const QString& lexicon, quint64 hash)
+{
+    return getSavedResultsDir(lexicon) + "/" +
+        QString::number(hash, 16).rightJustified(16, QChar('0')) + ".zzi";
+}
+
+//---------------------------------------------------------------------------
+//  loadSavedResults
+//
+//! Prepare the search results of a lexicon saved in earlier sessions to be
+//! used, if saving search results is enabled.  The results are saved for
+//! one build of the database, recorded in the directory they are saved in,
+//! so the results saved for any other build are removed.
+//
+//! @param lexicon the name of the lexicon
+//---------------------------------------------------------------------------
+void
+WordEngine::loadSavedResults(const QString& lexicon)
+{
+    LexiconData* data = lexiconData[lexicon];
+    data->savedResultsBuild.clear();
+    if (!MainSettings::getSaveSearchResults() || !data->db || !data->graph ||
+        !data->graph->hasWordCounts())
+    {
+        return;
+    }
+
+    QString build = getDatabaseBuild(data);
+    QDir dir (getSavedResultsDir(lexicon));
+    if (!dir.exists() && !dir.mkpath(dir.absolutePath()))
+        return;
+
+    QFile buildFile (dir.absoluteFilePath("build"));
+    QString savedBuild;
+    if (buildFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        savedBuild = QString::fromUtf8(buildFile.readAll());
+        buildFile.close();
+    }
+
+    if (savedBuild != build) {
+        QStringList filenames = dir.entryList(QStringList("*.zzi"),
+                                              QDir::Files);
+        foreach (const QString& filename, filenames)
+            dir.remove(filename);
+        if (!buildFile.open(QIODevice::WriteOnly | QIODevice::Truncate |
+                            QIODevice::Text))
+        {
+            return;
+        }
+        buildFile.write(build.toUtf8());
+        buildFile.close();
+    }
+
+    data->savedResultsBuild = build;
+}
+
+//---------------------------------------------------------------------------
+//  findSavedResults
+//
+//! Find the results of a search saved in an earlier session.
+//
+//! @param lexicon the name of the lexicon
+//! @param hash the search result cache hash of the search
+//! @param resultList returns the results
+//! @return true if the results were found, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::findSavedResults(const QString& lexicon, quint64 hash,
+                             QStringList* resultList) const
+{
+    const LexiconData* data = lexiconData.value(lexicon);
+    if (!data || data->savedResultsBuild.isEmpty())
+        return false;
+
+    QString filename = getSavedResultsFilename(lexicon, hash);
+    if (!QFile::exists(filename))
+        return false;
+
+    WordIdList idList;
+    const WordGraph* graph = data->graph;
+    if (!idList.readFile(filename) || (idList.getLexicon() != lexicon) ||
+        (idList.getBuild() != graph->getFingerprint()))
+    {
+        return false;
+    }
+
+    QVector<qint32> ids = idList.getIds();
+    int numWords = graph->getNumWords();
+    resultList->clear();
+    foreach (qint32 id, ids) {
+        if (id >= numWords)
+            return false;
+        resultList->append(graph->wordAt(id));
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  saveResults
+//
+//! Save the results of a search for later sessions, as the IDs of the
+//! words.  Results are only saved if they can be restored exactly from
+//! their IDs: all caps and in alphabetical order.  Results depending on
+//! word list files are not saved.
+//
+//! @param lexicon the name of the lexicon
+//! @param optimized the optimized search
+//! @param hash the search result cache hash of the search
+//! @param resultList the results
+//---------------------------------------------------------------------------
+void
+WordEngine::saveResults(const QString& lexicon, const OptimizedSpec&
+                        optimized, quint64 hash, const QStringList&
+                        resultList) const
+{
+    const LexiconData* data = lexiconData.value(lexicon);
+    if (!data || data->savedResultsBuild.isEmpty())
+        return;
+
+    foreach (const SearchCondition& condition, optimized.spec.conditions) {
+        if (condition.isWordListFile())
+            return;
+    }
+
+    const WordGraph* graph = data->graph;
+    WordIdList idList;
+    idList.setLexicon(lexicon);
+    idList.setBuild(graph->getFingerprint());
+    qint32 previousId = -1;
+    foreach (const QString& word, resultList) {
+        qint32 id = graph->indexOf(word);
+        if ((id <= previousId) || (word != word.toUpper()))
+            return;
+        idList.addWord(id);
+        previousId = id;
+    }
+
+    idList.writeFile(getSavedResultsFilename(lexicon, hash));
+}
+
+//---------------------------------------------------------------------------
+//  getDatabaseBuild
+//
+//! Get a string identifying the build of the database of a lexicon, from
+//! its version, lexicon date and lexicon file, and the size and
+//! modification time of the database file, so a rebuild or update of the
+//! database changes it.
+//
+//! @param data the lexicon data
+//! @return the build string, or an empty string if the database is not
+//! connected
+//---------------------------------------------------------------------------
+QString
+WordEngine::getDatabaseBuild(const LexiconData* data) const
+{
+    if (!data->db || !data->db->isOpen())
+        return QString();
+
+    QStringList build;
+    QSqlQuery query (*data->db);
+    query.exec("SELECT version FROM db_version");
+    build.append(query.next() ? query.value(0).toString() : QString());
+    query.exec("SELECT date FROM lexicon_date");
+    build.append(query.next() ? query.value(0).toString() : QString());
+    query.exec("SELECT file FROM lexicon_file");
+    build.append(query.next() ? query.value(0).toString() : QString());
+
+    QFileInfo info (data->db->databaseName());
+    build.append(QString::number(info.size()));
+    build.append(QString::number(info.lastModified().toTime_t()));
+    return build.join("|");
+}
+
+//---------------------------------------------------------------------------
+//  getWordId
+//
+//! Get the index of a word in the word attribute arrays of a lexicon.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word, in upper case
+//! @return the index, or -1 if the attributes of the word are not loaded
+//---------------------------------------------------------------------------
+int
+WordEngine::getWordId(const QString& lexicon, const QString& word) const
+{
+    return getWordId(lexiconData.value(lexicon), word);
+}
+
+//---------------------------------------------------------------------------
+//  getWordId
+//
+//! Get the index of a word in the word attribute arrays of a lexicon.
+//
+//! @param data the data of the lexicon, or 0 if it is not loaded
+//! @param word the word, in upper case
+//! @return the index, or -1 if the attributes of the word are not loaded
+//---------------------------------------------------------------------------
+int
+WordEngine::getWordId(const LexiconData* data, const QString& word) const
+{
+    if (!data || data->attributes.isEmpty())
+        return -1;
+
+    int id = data->graph->indexOf(word);
+    if ((id < 0) || (id >= data->attributes.flags.size()) ||
+        !(data->attributes.flags[id] & WordAttributes::ValidFlag))
+    {
+        return -1;
+    }
+
+    return id;
+}
+
+//---------------------------------------------------------------------------
+//  setReadPragmas
+//
+//! Set up a read-only connection to a lexicon database, sizing its page
+//! cache and memory map from the database memory settings.  Readers do not
+//! take table locks on the shared cache, so a deferred index being created
+//! does not hold up searches.
+//
+//! @param db the database
+//---------------------------------------------------------------------------
+static void
+setReadPragmas(QSqlDatabase& db)
+{
+    // A negative cache size is a number of kibibytes rather than pages
+    qint64 cacheKib = qint64(MainSettings::getDatabaseCacheSize()) * 1024;
+    qint64 mapBytes = qint64(MainSettings::getDatabaseMapSize()) * 1024 *
+        1024;
+
+    QSqlQuery query (db);
+    query.exec("PRAGMA read_uncommitted=1");
+    query.exec("PRAGMA cache_size=" + QString::number(-cacheKib));
+    query.exec("PRAGMA mmap_size=" + QString::number(mapBytes));
+}
+
+//---------------------------------------------------------------------------
+//  connectToDatabase
+//
+//! Initialize the database connection for a lexicon.
+//
+//! @param lexicon the name of the lexicon
+//! @param filename the name of the database file
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::connectToDatabase(const QString& lexicon, const QString& filename,
+                              QString* errString)
+{
+    QWriteLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return false;
+
+    Rand rng;
+    rng.srand(QDateTime::currentDateTime().toTime_t(), Auxil::getPid());
+    unsigned int r = rng.rand();
+    QString dbConnectionName = "WordEngine_" + lexicon + "_" +
+        QString::number(r);
+
+    QSqlDatabase* db = new QSqlDatabase(
+        QSqlDatabase::addDatabase("QSQLITE", dbConnectionName));
+    db->setConnectOptions(DB_CONNECT_OPTIONS);
+    db->setDatabaseName(filename);
+    bool ok = db->open();
+
+    if (!ok) {
+        dbConnectionName = QString();
+        if (errString)
+            *errString = db->lastError().text();
+        // delete db?
+        return false;
+    }
+
+    setReadPragmas(*db);
+
+    LexiconData* data = lexiconData[lexicon];
+    data->db = db;
+    data->dbConnectionName = dbConnectionName;
+    data->dbThread = QThread::currentThreadId();
+    data->definitionIndex.clear();
+    loadSnapshot(lexicon, filename);
+    loadWordAttributes(lexicon);
+    loadSearchStats(lexicon);
+    loadIndexSets(lexicon);
+    clearSearchCaches();
+    startWordCacheJob(lexicon);
+    loadSavedResults(lexicon);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  disconnectFromDatabase
+//
+//! Remove the database connection for a lexicon.
+//
+//! @param lexicon the name of the lexicon
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::disconnectFromDatabase(const QString& lexicon)
+{
+    QWriteLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return true;
+
+    QSqlDatabase* db = lexiconData[lexicon]->db;
+    QString dbConnectionName = lexiconData[lexicon]->dbConnectionName;
+    if (!db || !db->isOpen() || dbConnectionName.isEmpty())
+        return true;
+
+    closeConnections(lexiconData[lexicon]);
+    waitForIndexJobs(lexiconData[lexicon]);
+    waitForWordCacheJob(lexiconData[lexicon]);
+    lexiconData[lexicon]->savedResultsBuild.clear();
+
+    delete db;
+    lexiconData[lexicon]->db = 0;
+    delete lexiconData[lexicon]->snapshot;
+    lexiconData[lexicon]->snapshot = 0;
+    lexiconData[lexicon]->attributes.clear();
+    lexiconData[lexicon]->combinationCache.clear();
+    lexiconData[lexicon]->searchStats.clear();
+    lexiconData[lexicon]->definitionIndex.clear();
+    QSqlDatabase::removeDatabase(dbConnectionName);
+    lexiconData[lexicon]->dbConnectionName.clear();
+    clearSearchCaches();
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  databaseIsConnected
+//
+//! Determine whether a lexicon database is connected.
+//
+//! @param lexicon the name of the lexicon
+//! @return true if the database is connected, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::databaseIsConnected(const QString& lexicon) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    return (lexiconData.contains(lexicon) && lexiconData[lexicon]->db);
+}
+
+//---------------------------------------------------------------------------
+//  saveWordCaches
+//
+//! Save the word cache of each lexicon with a connected database, tagged
+//! with the build of the database, if saving word caches is enabled.  The
+//! caches are read back in the background when the databases are connected
+//! in a later session.
+//---------------------------------------------------------------------------
+void
+WordEngine::saveWordCaches() const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!MainSettings::getSaveWordCache())
+        return;
+
+    QMapIterator<QString, LexiconData*> it (lexiconData);
+    while (it.hasNext()) {
+        it.next();
+        LexiconData* data = it.value();
+        if (!data->db)
+            continue;
+
+        // Index creation changes the database file, so the build is taken
+        // after it finishes
+        if (!data->wordCacheJob.isNull())
+            data->wordCacheJob->wait();
+        QMutexLocker indexLocker (&data->indexMutex);
+        foreach (const JobPointer& job, data->indexJobs)
+            job->wait();
+
+        data->wordCache.save(getWordCacheFilename(it.key()),
+                             getDatabaseBuild(data));
+    }
+}
+
+//---------------------------------------------------------------------------
+//  importTextFile
+//
+//! Import words from a text file.  The file is assumed to be in plain text
+//! format, containing one word per line.  The words are stored in minimized
+//! forward and reverse DAWGs, which are also saved in the user lexicon
+//! directory and loaded from there on later imports, as long as they are
+//! newer than the text file.  Only the offsets of the lines holding
+//! definitions are kept, and each definition is read from the file when it
+//! is first shown.
+//
+//! @param lexicon the name of the lexicon
+//! @param filename the name of the file to import
+//! @param loadDefinitions whether to load word definitions
+//! @param errString returns the error string in case of error
+//! @return the number of words imported
+//---------------------------------------------------------------------------
+int
+WordEngine::importTextFile(const QString& lexicon, const QString& filename,
+                           bool loadDefinitions, QString* errString)
+{
+    QWriteLocker locker (&lexiconLock);
+
+    // Delete old word graph if it exists
+    if (lexiconData.contains(lexicon))
+        delete lexiconData[lexicon]->graph;
+    else
+        initLexiconData(lexicon);
+    clearSearchCaches();
+
+    WordGraph* graph = new WordGraph;
+    lexiconData[lexicon]->graph = graph;
+    lexiconData[lexicon]->lexiconFile = filename;
+    lexiconData[lexicon]->definitionOffsets.clear();
+
+    QFile file (filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errString) {
+            *errString = "Can't open file '" + filename + "': " +
+                file.errorString();
+        }
+        return 0;
+    }
+
+    int imported = 0;
+    QStringList words;
+    QHash<CompactWord, qint64>& definitionOffsets =
+        lexiconData[lexicon]->definitionOffsets;
+    char* buffer = new char[MAX_INPUT_LINE_LEN];
+    qint64 lineStart = file.pos();
+    while (file.readLine(buffer, MAX_INPUT_LINE_LEN) > 0) {
+        qint64 offset = lineStart;
+        lineStart = file.pos();
+        QString line (buffer);
+        line = line.simplified();
+        if (!line.length() || (line.at(0) == '#'))
+            continue;
+        QString word = line.section(' ', 0, 0).toUpper();
+
+        words.append(word);
+        if (loadDefinitions && !line.section(' ', 1).isEmpty())
+            definitionOffsets.insert(CompactWord(word), offset);
+        ++imported;
+    }
+
+    delete[] buffer;
+
+    // Count the anagrams of each distinct word
+    words.sort();
+    QString prevWord;
+    foreach (const QString& word, words) {
+        if (word == prevWord)
+            continue;
+        ++lexiconData[lexicon]->numAnagramsMap[
+            CompactWord(Auxil::getAlphagram(word))];
+        prevWord = word;
+    }
+
+    // Load the saved DAWGs if they are up to date, otherwise build them.  If
+    // the words cannot be stored in a DAWG, fall back to the old-style graph.
+    QString dawgFilename = getSavedDawgFilename(filename, false);
+    QString rdawgFilename = getSavedDawgFilename(filename, true);
+    QDateTime textModified = QFileInfo(filename).lastModified();
+    QFileInfo dawgInfo (dawgFilename);
+    QFileInfo rdawgInfo (rdawgFilename);
+    bool saved = dawgInfo.exists() && rdawgInfo.exists() &&
+        (dawgInfo.lastModified() >= textModified) &&
+        (rdawgInfo.lastModified() >= textModified);
+
+    bool ok = saved && graph->importDawgFile(dawgFilename, false, 0, 0) &&
+        graph->importDawgFile(rdawgFilename, true, 0, 0);
+    if (!ok) {
+        ok = graph->importWords(words, false, 0, dawgFilename) &&
+            graph->importWords(words, true, 0, rdawgFilename);
+    }
+
+    if (ok) {
+        graph->buildLookupTable();
+        graph->buildWordCounts();
+        graph->buildWordArray();
+        graph->buildLengthMasks();
+        if (MainSettings::getSearchSuccinctReverseDawg())
+            graph->buildSuccinctReverseDawg();
+        loadWordAttributes(lexicon);
+        loadAnagramIndex(lexicon);
+        if (MainSettings::getSearchUseInfixIndex())
+            graph->buildGaddag();
+    }
+    else {
+        graph->clear();
+        foreach (const QString& word, words)
+            graph->addWord(word);
+    }
+
+    return imported;
+}
+
+//---------------------------------------------------------------------------
+//  getSavedDawgFilename
+//
+//! Determine the name of the file a DAWG built from a text file is saved to.
+//
+//! @param filename the name of the text file
+//! @param reverse whether the DAWG contains reversed words
+//! @return the name of the saved DAWG file
+//---------------------------------------------------------------------------
+QString
+WordEngine::getSavedDawgFilename(const QString& filename, bool reverse) const
+{
+    QFileInfo info (filename);
+    return Auxil::getUserDir() + "/lexicons/" + info.fileName() +
+        (reverse ? "-R.dwg" : ".dwg");
+}
+
+//---------------------------------------------------------------------------
+//  importDawgFile
+//
+//! Import words from a DAWG file as generated by Graham Toal's dawgutils
+//! programs: http://www.gtoal.com/wordgames/dawgutils/
+//
+//! @param lexicon the name of the lexicon
+//! @param filename the name of the DAWG file to import
+//! @param reverse whether the DAWG contains reversed words
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::importDawgFile(const QString& lexicon, const QString& filename,
+                           bool reverse, QString* errString, quint16*
+                           expectedChecksum)
+{
+    QWriteLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon)) {
+        initLexiconData(lexicon);
+        lexiconData[lexicon]->graph = new WordGraph;
+    }
+    clearSearchCaches();
+
+    WordGraph* graph = lexiconData[lexicon]->graph;
+    bool ok = graph->importDawgFile(filename, reverse, errString,
+                                    expectedChecksum);
+
+    // Compile the forward DAWG for fast word lookups, count the words below
+    // each edge, and pack the words into an array for scanning.  Lookups
+    // fall back to scanning the DAWG if the table cannot be built, and
+    // searches fall back to the DAWGs if the word array or infix index cannot
+    // be built.
+    if (ok && !reverse) {
+        graph->buildLookupTable();
+        graph->buildWordCounts();
+        graph->buildWordArray();
+        graph->buildLengthMasks();
+        loadWordAttributes(lexicon);
+        loadAnagramIndex(lexicon);
+        if (MainSettings::getSearchUseInfixIndex())
+            graph->buildGaddag();
+    }
+    else if (ok) {
+        // The length masks of the reverse DAWG are built with those of the
+        // forward DAWG, unless the reverse DAWG is held in the succinct
+        // encoding, which has none
+        graph->buildLengthMasks();
+        if (MainSettings::getSearchSuccinctReverseDawg())
+            graph->buildSuccinctReverseDawg();
+    }
+
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+//  loadDawgGraph
+//
+//! Read a word graph from forward and reverse DAWG files, and build the
+//! tables used to look up and search its words, without adding it to any
+//! lexicon.  Word graphs of several lexicons can be read in parallel this
+//! way, and added to their lexicons with addGraph.
+//
+//! @param filename the name of the forward DAWG file
+//! @param reverseFilename the name of the reverse DAWG file
+//! @param errString returns the error string in case of error
+//! @return the word graph, or 0 if either file cannot be read
+//---------------------------------------------------------------------------
+WordGraph*
+WordEngine::loadDawgGraph(const QString& filename, const QString&
+                          reverseFilename, QString* errString)
+{
+    WordGraph* graph = new WordGraph;
+    if (!graph->importDawgFile(filename, false, errString, 0) ||
+        !graph->importDawgFile(reverseFilename, true, errString, 0))
+    {
+        delete graph;
+        return 0;
+    }
+
+    graph->buildLookupTable();
+    graph->buildWordCounts();
+    graph->buildWordArray();
+    graph->buildLengthMasks();
+    if (MainSettings::getSearchSuccinctReverseDawg())
+        graph->buildSuccinctReverseDawg();
+    if (MainSettings::getSearchUseInfixIndex())
+        graph->buildGaddag();
+    return graph;
+}
+
+//---------------------------------------------------------------------------
+//  addGraph
+//
+//! Use a word graph read by loadDawgGraph as the word graph of a lexicon.
+//
+//! @param lexicon the name of the lexicon
+//! @param graph the word graph, which the lexicon takes over
+//---------------------------------------------------------------------------
+void
+WordEngine::addGraph(const QString& lexicon, WordGraph* graph)
+{
+    QWriteLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        initLexiconData(lexicon);
+    clearSearchCaches();
+
+    delete lexiconData[lexicon]->graph;
+    lexiconData[lexicon]->graph = graph;
+    loadWordAttributes(lexicon);
+    loadAnagramIndex(lexicon);
+}
+
+//---------------------------------------------------------------------------
+//  importStems
+//
+//! Import stems for a lexicon from a file.  The file is assumed to be in
+//! plain text format, containing one stem per line.  The file is also assumed
+//! to contain stems of equal length.  All stems of different length than the
+//! first stem will be discarded.
+//
+//! @param lexicon the name of the lexicon
+//! @param filename the name of the file to import
+//! @param errString returns the error string in case of error
+//! @return the number of stems imported
+//---------------------------------------------------------------------------
+int
+WordEngine::importStems(const QString& lexicon, const QString& filename,
+                        QString* errString)
+{
+    QWriteLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    clearSearchCaches();
+
+    QFile file (filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errString) {
+            *errString = "Can't open file '" + filename + "': " +
+                file.errorString();
+        }
+        return -1;
+    }
+
+    // XXX: At some point, may want to consider allowing words of varying
+    // lengths to be in the same file?
+    QList<CompactWord> words;
+    QSet<CompactWord> alphagrams;
+    int imported = 0;
+    int length = 0;
+    char* buffer = new char[MAX_INPUT_LINE_LEN];
+    while (file.readLine(buffer, MAX_INPUT_LINE_LEN) > 0) {
+        QString line (buffer);
+        line = line.simplified();
+        if (!line.length() || (line.at(0) == '#'))
+            continue;
+        QString word = line.section(' ', 0, 0);
+
+        if (!length)
+            length = word.length();
+
+        if (length != int(word.length()))
+            continue;
+
+        CompactWord compactWord (word);
+        if (compactWord.isNull())
+            continue;
+
+        words << compactWord;
+        alphagrams.insert(CompactWord(Auxil::getAlphagram(word)));
+        ++imported;
+    }
+    delete[] buffer;
+
+    // Insert the stem list into the map, or append to an existing stem list
+    LexiconData* data = lexiconData[lexicon];
+    data->stems[length] += words;
+    data->stemAlphagrams[length].unite(alphagrams);
+    data->setMembers.clear();
+    loadStemIndexes(lexicon);
+    return imported;
+}
+
+//---------------------------------------------------------------------------
+//  loadLexicon
+//
+//! Load a lexicon from its standard files, without asking the user
+//! anything: the word graph files of a built-in lexicon or the import file
+//! of the custom lexicon, and the stems.  Also connect to the database of
+//! the lexicon if it has been built.  Used by programs without a main
+//! window.
+//
+//! @param lexicon the name of the lexicon
+//! @param useDatabase whether to connect to the database
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::loadLexicon(const QString& lexicon, bool useDatabase, QString*
+                        errString)
+{
+    QString wordsDir = Auxil::getWordsDir();
+    if (lexicon == LEXICON_CUSTOM) {
+        QString importFile = MainSettings::getAutoImportFile();
+        if (!importTextFile(lexicon, importFile, true, errString))
+            return false;
+    }
+    else {
+        QString prefix = Auxil::getLexiconPrefix(lexicon);
+        if (prefix.isEmpty()) {
+            if (errString)
+                *errString = "Unknown lexicon '" + lexicon + "'.";
+            return false;
+        }
+
+        if (!importDawgFile(lexicon, wordsDir + prefix + ".dwg", false,
+                            errString) ||
+            !importDawgFile(lexicon, wordsDir + prefix + "-R.dwg", true,
+                            errString))
+        {
+            return false;
+        }
+    }
+
+    importStems(lexicon, wordsDir + "/North-American/6-letter-stems.txt");
+    importStems(lexicon, wordsDir + "/North-American/7-letter-stems.txt");
+
+    // Searches needing the database fail without it, but others still run
+    QString dbFilename = Auxil::getDatabaseFilename(lexicon);
+    if (useDatabase && QFile::exists(dbFilename))
+        connectToDatabase(lexicon, dbFilename);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  databaseSearch
+//
+//! Search the database for words matching the conditions in a search spec.
+//! If a word list is provided, also ensure that result words are in that
+//! list.  Definition and Part of Speech conditions are first checked
+//! against the definition index if few words can match them.
+//
+//! @param lexicon the name of the lexicon
+//! @param optimizedSpec the search spec
+//! @param wordList optional list of words that results must be in
+//! @param queryText if not null, returns the SQL query used
+//! @return a list of words matching the search spec
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::databaseSearch(const QString& lexicon, const SearchSpec&
+                           optimizedSpec, const QStringList* wordList, QString*
+                           queryText) const
+{
+    Z_TRACE_SCOPE("WordEngine::search database");
+    QSqlDatabase* db = getDatabase(lexicon);
+    if (!db)
+        return QStringList();
+
+    requireIndexSets(lexicon, optimizedSpec);
+
+    // Limit definition searches to words whose definitions have the right
+    // tokens, since LIKE conditions on definitions scan every definition
+    QStringList candidates;
+    if (getDefinitionCandidates(lexicon, optimizedSpec, wordList,
+                                &candidates))
+    {
+        if (candidates.isEmpty())
+            return QStringList();
+        wordList = &candidates;
+    }
+
+    QMap<QString, QString> upperToLower;
+    QString queryStr = getDatabaseQuery(optimizedSpec, wordList, false,
+                                        &upperToLower);
+
+    //qDebug("Query str: |%s|", queryStr.toUtf8().constData());
+    if (queryText)
+        *queryText = queryStr;
+
+    // Query the database
+    QStringList resultList;
+    QSqlQuery query (queryStr, *db);
+    while (query.next()) {
+        QString word = query.value(0).toString();
+        if (!upperToLower.isEmpty() && upperToLower.contains(word)) {
+            word = upperToLower[word];
+        }
+        resultList.append(word);
+    }
+
+    return resultList;
+}
+
+//---------------------------------------------------------------------------
+//  getDefinitionCandidates
+//
+//! Find the words whose definitions can match the Definition and Part of
+//! Speech conditions of a search spec, using the definition index.  A
+//! definition can only contain a search string if each run of letters and
+//! digits in the string is part of a token in the definition.  The
+//! candidates must still be checked against the conditions.
+//
+//! @param lexicon the name of the lexicon
+//! @param optimizedSpec the search spec
+//! @param wordList optional list of words that candidates must be in
+//! @param candidates returns the candidate words, in the form given in the
+//! word list if one is provided
+//! @return true if the candidates were found, false if the search spec has
+//! no conditions that can use the index, the index cannot be loaded, or
+//! too many words can match
+//---------------------------------------------------------------------------
+bool
+WordEngine::getDefinitionCandidates(const QString& lexicon, const SearchSpec&
+                                    optimizedSpec, const QStringList*
+                                    wordList, QStringList* candidates) const
+{
+    QStringList runs;
+    QListIterator<SearchCondition> cit (optimizedSpec.conditions);
+    while (cit.hasNext()) {
+        const SearchCondition& condition = cit.next();
+        if (((condition.type != SearchCondition::Definition) &&
+             (condition.type != SearchCondition::PartOfSpeech)) ||
+            condition.negated)
+        {
+            continue;
+        }
+        runs += condition.stringValue.toLower().split(
+            QRegExp("[^a-z0-9]+"), QString::SkipEmptyParts);
+    }
+    if (runs.isEmpty() || !lexiconData.contains(lexicon))
+        return false;
+
+    LexiconData* data = lexiconData[lexicon];
+    const WordGraph* graph = data->graph;
+    if (!graph || !graph->hasWordCounts())
+        return false;
+
+    QVector<qint32> ids;
+    {
+        QMutexLocker locker (&data->definitionIndexMutex);
+        if (!data->definitionIndex.loaded)
+            loadDefinitionIndex(lexicon);
+        const DefinitionIndex& index = data->definitionIndex;
+        if (index.tokenWords.isEmpty())
+            return false;
+
+        // Take the words with a token containing each run, starting from
+        // the longest run, which usually has the fewest words
+        int longest = 0;
+        for (int i = 1; i < runs.size(); ++i) {
+            if (runs[i].length() > runs[longest].length())
+                longest = i;
+        }
+        runs.swap(0, longest);
+
+        // The IDs of the tokens are gathered unsorted, and only sorted
+        // when there are enough of them that there may be too many words
+        for (int i = 0; i < runs.size(); ++i) {
+            const QString& run = runs[i];
+            QVector<qint32> runIds;
+            QHashIterator<QString, QVector<qint32> > it (index.tokenWords);
+            while (it.hasNext()) {
+                it.next();
+                if (!it.key().contains(run))
+                    continue;
+                runIds += i ? WordIdList::intersect(it.value(), ids)
+                            : it.value();
+                if (runIds.size() > 2 * MAX_DEFINITION_CANDIDATES) {
+                    WordIdList::normalize(&runIds);
+                    if (runIds.size() > MAX_DEFINITION_CANDIDATES)
+                        return false;
+                }
+            }
+            WordIdList::normalize(&runIds);
+            if (runIds.size() > MAX_DEFINITION_CANDIDATES)
+                return false;
+            ids = runIds;
+            if (ids.isEmpty())
+                break;
+        }
+    }
+
+    candidates->clear();
+    if (wordList) {
+        foreach (const QString& word, *wordList) {
+            if (WordIdList::contains(ids, graph->indexOf(word.toUpper())))
+                candidates->append(word);
+        }
+    }
+    else {
+        foreach (qint32 id, ids)
+            candidates->append(graph->wordAt(id));
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  loadDefinitionIndex
+//
+//! Index the tokens of every definition in the database of a lexicon.
+//! Tokens are runs of letters and digits, in lower case.
+//
+//! @param lexicon the name of the lexicon
+//---------------------------------------------------------------------------
+void
+WordEngine::loadDefinitionIndex(const QString& lexicon) const
+{
+    LexiconData* data = lexiconData[lexicon];
+    DefinitionIndex& index = data->definitionIndex;
+    index.clear();
+    index.loaded = true;
+
+    QSqlDatabase* db = getDatabase(lexicon);
+    if (!db)
+        return;
+
+    QSqlQuery query (*db);
+    query.setForwardOnly(true);
+    if (!query.exec("SELECT word, definition FROM words "
+                    "WHERE definition IS NOT NULL"))
+    {
+        return;
+    }
+
+    QRegExp separator ("[^a-z0-9]+");
+    while (query.next()) {
+        qint32 id = data->graph->indexOf(query.value(0).toString());
+        if (id < 0)
+            continue;
+        QStringList tokens = query.value(1).toString().toLower().split(
+            separator, QString::SkipEmptyParts);
+        foreach (const QString& token, tokens) {
+            QVector<qint32>& words = index.tokenWords[token];
+            if (words.isEmpty() || (words.last() != id))
+                words.append(id);
+        }
+    }
+
+    // Keep the words of each token sorted for the ID array operations
+    QMutableHashIterator<QString, QVector<qint32> > it (index.tokenWords);
+    while (it.hasNext())
+        WordIdList::normalize(&it.next().value());
+    index.tokenWords.squeeze();
+}
+
+//---------------------------------------------------------------------------
+//  getDatabaseQuery
+//
+//! Build an SQL query selecting words matching the database conditions in a
+//! search spec.  If a word list is provided, also ensure that result words
+//! are in that list.
+//
+//! @param optimizedSpec the search spec
+//! @param wordList optional list of words that results must be in
+//! @param countOnly whether to select only the number of matching words
+//! @param upperToLower if not null, returns the word list form of each
+//! upper case word in the word list
+//! @return the query string
+//---------------------------------------------------------------------------
+QString
+WordEngine::getDatabaseQuery(const SearchSpec& optimizedSpec, const
+                             QStringList* wordList, bool countOnly,
+                             QMap<QString, QString>* upperToLower) const
+{
+    // Build SQL query string
+    QSet<QString> tables;
     QString whereStr;
     bool foundCondition = false;
     QListIterator<SearchCondition> cit (optimizedSpec.conditions);
     while (cit.hasNext()) {
         SearchCondition condition = cit.next();
-        if (getConditionPhase(condition) != DatabasePhase)
+        if (getConditionPhase(condition) != DatabasePhase)
+            continue;
+
+        if (foundCondition)
+            whereStr += " AND";
+        foundCondition = true;
+        whereStr += " (";
+
+        switch (condition.type) {
+            case SearchCondition::PatternMatch: {
+                tables.insert("words");
+                QString str =
+                    condition.stringValue.replace("?", "_").replace("*", "%");
+                whereStr += " words.word";
+                if (condition.negated)
+                    whereStr += " NOT";
+                whereStr += " LIKE '" + str + "'";
+            }
+            break;
+
+            case SearchCondition::PartOfSpeech:
+            case SearchCondition::Definition: {
+                tables.insert("words");
+
+                // Escape % and _ characters when preceded by an even number
+                // of backslashes
+                QString str = condition.stringValue.replace(
+                    QRegExp("((?:\\\\\\\\)*)([%%_'\\\\])"), "\\1\\\\2");
+
+                // ### replace * with % and ? with _ for more flexible search
+                // tricky to get right
+
+                str.replace("'", "''");
+                str.replace(";", "\\;");
+
+                QString notStr;
+                QString conjStr = " OR";
+                if (condition.negated) {
+                    conjStr = " AND";
+                    notStr = " NOT";
+                }
+
+                QString whereSecondStr;
+                if (condition.type == SearchCondition::PartOfSpeech) {
+                    whereSecondStr = conjStr +
+                        " words.definition" + notStr +
+                        " LIKE '\%[" + str + "]\%' ESCAPE '\\'";
+                    str = "[" + str + " ";
+                }
+
+                whereStr +=
+                    " words.definition" + notStr +
+                    " LIKE '\%" + str + "\%' ESCAPE '\\'" + whereSecondStr;
+            }
+            break;
+
+            case SearchCondition::ProbabilityOrder:
+            case SearchCondition::PlayabilityOrder: {
+                tables.insert("words");
+                QString col;
+                if (condition.type == SearchCondition::ProbabilityOrder) {
+                    col = QString("probability_order%1").arg(
+                        condition.intValue);
+                }
+                else if (condition.type == SearchCondition::PlayabilityOrder) {
+                    col = "playability_order";
+                }
+
+                // Lax boundaries
+                if (condition.boolValue) {
+                    whereStr += QString(" words.max_%1>=").arg(col) +
+                        QString::number(condition.minValue) +
+                        QString(" AND words.min_%1<=").arg(col) +
+                        QString::number(condition.maxValue);
+                }
+                // Strict boundaries
+                else {
+                    whereStr += QString(" words.%1").arg(col);
+                    if (condition.minValue == condition.maxValue) {
+                        whereStr += "=" + QString::number(condition.minValue);
+                    }
+                    else {
+                        whereStr += ">=" +
+                            QString::number(condition.minValue) +
+                            QString(" AND words.%1<=").arg(col) +
+                            QString::number(condition.maxValue);
+                    }
+                }
+            }
+            break;
+
+            case SearchCondition::Length:
+            case SearchCondition::NumVowels:
+            case SearchCondition::NumUniqueLetters:
+            case SearchCondition::PointValue:
+            case SearchCondition::NumAnagrams: {
+                tables.insert("words");
+                QString column;
+                if (condition.type == SearchCondition::Length)
+                    column = "words.length";
+                if (condition.type == SearchCondition::NumVowels)
+                    column = "words.num_vowels";
+                if (condition.type == SearchCondition::NumUniqueLetters)
+                    column = "words.num_unique_letters";
+                if (condition.type == SearchCondition::PointValue)
+                    column = "words.point_value";
+                if (condition.type == SearchCondition::NumAnagrams)
+                    column = "words.num_anagrams";
+
+                whereStr += " " + column;
+                if (condition.minValue == condition.maxValue) {
+                    whereStr += "=" + QString::number(condition.minValue);
+                }
+                else {
+                    whereStr += ">=" + QString::number(condition.minValue) +
+                        " AND " + column + "<=" +
+                        QString::number(condition.maxValue);
+                }
+            }
+            break;
+
+            case SearchCondition::IncludeLetters: {
+                tables.insert("words");
+                QString str = condition.stringValue;
+                QMap<QChar, int> letters;
+                for (int i = 0; i < str.length(); ++i) {
+                    ++letters[str.at(i)];
+                }
+
+                QMapIterator<QChar, int> it (letters);
+                for (int i = 0; it.hasNext(); ++i) {
+                    it.next();
+                    QChar c = it.key();
+                    if (i)
+                        whereStr += " AND";
+                    whereStr += " word";
+                    if (condition.negated)
+                        whereStr += " NOT";
+                    whereStr += " LIKE '%";
+                    int count = condition.negated ? 1 : it.value();
+                    for (int j = 0; j < count; ++j) {
+                        whereStr += QString(c) + "%";
+                    }
+                    whereStr += "'";
+                }
+            }
+            break;
+
+            case SearchCondition::BelongToGroup: {
+                tables.insert("words");
+                SearchSet searchSet =
+                    Auxil::stringToSearchSet(condition.stringValue);
+                int target = condition.negated ? 0 : 1;
+                switch (searchSet) {
+                    case SetFrontHooks:
+                    whereStr += " words.is_front_hook=" +
+                        QString::number(target);
+                    break;
+
+                    case SetBackHooks:
+                    whereStr += " words.is_back_hook=" +
+                        QString::number(target);
+                    break;
+
+                    case SetHookWords:
+                    if (condition.negated) {
+                        whereStr += " (words.is_front_hook=0 AND "
+                            "words.is_back_hook=0)";
+                    }
+                    else {
+                        whereStr += " (words.is_front_hook=1 OR "
+                            "words.is_back_hook=1)";
+                    }
+                    break;
+
+                    default:
+                    break;
+                }
+            }
+            break;
+
+            case SearchCondition::InWordList: {
+                tables.insert("words");
+                whereStr += " words.word";
+                if (condition.negated)
+                    whereStr += " NOT";
+                whereStr += " IN (";
+                QStringList words = getWordListWords(condition);
+                QStringListIterator it (words);
+                bool firstWord = true;
+                while (it.hasNext()) {
+                    QString word = it.next();
+                    if (!firstWord)
+                        whereStr += ",";
+                    firstWord = false;
+                    whereStr += "'" + word.replace("'", "''") + "'";
+                }
+                whereStr += ")";
+            }
+            break;
+
+            default:
+            break;
+        }
+
+        whereStr += ")";
+    }
+
+    // Make sure results are in the provided word list
+    if (wordList) {
+        tables.insert("words");
+        whereStr += " AND words.word IN (";
+        QStringListIterator it (*wordList);
+        bool firstWord = true;
+        while (it.hasNext()) {
+            QString word = it.next();
+            QString wordUpper = word.toUpper();
+            if (upperToLower)
+                upperToLower->insert(wordUpper, word);
+            if (!firstWord)
+                whereStr += ",";
+            firstWord = false;
+            whereStr += "'" + wordUpper + "'";
+        }
+        whereStr += ")";
+    }
+
+    QStringList tablesList = tables.toList();
+    QString tableStr = " " + tablesList.join(", ");
+    QString selectColStr = "word";
+    if (countOnly) {
+        selectColStr = " count(*)";
+    }
+    else if (tables.contains("words")) {
+        selectColStr = " words.word";
+    }
+
+    return "SELECT" + selectColStr + " FROM" + tableStr + " WHERE" +
+        whereStr;
+}
+
+//---------------------------------------------------------------------------
+//  applyPostConditions
+//
+//! Limit search results by search conditions that cannot be easily used to
+//! limit word graph or database searches.
+//
+//! @param optimizedSpec the search spec
+//! @param wordList optional list of words that results must be in
+//! @return a list of words matching the search spec
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::applyPostConditions(const QString& lexicon,
+    const SearchSpec& optimizedSpec, const QStringList& wordList) const
+{
+    Z_TRACE_SCOPE("WordEngine::search post conditions");
+    QStringList returnList = wordList;
+
+    // Check special postconditions, compiled once for all the words
+    QVector<PostConditionOp> ops =
+        compilePostConditions(lexicon, optimizedSpec.conditions);
+    if (!ops.isEmpty()) {
+        Lexicon handle = getLexicon(lexicon);
+        QStringList::iterator wit;
+        for (wit = returnList.begin(); wit != returnList.end();) {
+            if (matchesPostConditions(handle, (*wit).toUpper(), ops))
+                ++wit;
+            else
+                wit = returnList.erase(wit);
+        }
+    }
+    if (returnList.isEmpty())
+        return returnList;
+
+    // Handle Limit by Probability/Playability Order conditions
+    bool legacyProbCondition = false;
+    const int MIN_INDEX = 0;
+    const int MAX_INDEX = 1;
+    const int MIN_LAX_INDEX = 2;
+    const int MAX_LAX_INDEX = 3;
+    QMap<QPair<SearchCondition::SearchType, int>, QVector<int> > limits;
+    QListIterator<SearchCondition> cit (optimizedSpec.conditions);
+    while (cit.hasNext()) {
+        SearchCondition condition = cit.next();
+        if ((condition.type == SearchCondition::LimitByProbabilityOrder) ||
+            (condition.type == SearchCondition::LimitByPlayabilityOrder))
+        {
+            int probNumBlanks = 0;
+            if (condition.type == SearchCondition::LimitByProbabilityOrder) {
+                probNumBlanks = condition.intValue;
+                if (condition.legacy)
+                    legacyProbCondition = true;
+            }
+
+            QPair<SearchCondition::SearchType, int> typePair =
+                qMakePair(condition.type, probNumBlanks);
+
+            // Initialize limits
+            if (!limits.contains(typePair)) {
+                limits[typePair] = (QVector<int>() << 0 <<
+                    LIMIT_RANGE_MAX << 0 << LIMIT_RANGE_MAX);
+            }
+
+            if (condition.boolValue) {
+                if (condition.minValue > limits[typePair][MIN_LAX_INDEX])
+                    limits[typePair][MIN_LAX_INDEX] = condition.minValue;
+                if (condition.maxValue < limits[typePair][MAX_LAX_INDEX])
+                    limits[typePair][MAX_LAX_INDEX] = condition.maxValue;
+            }
+            else {
+                if (condition.minValue > limits[typePair][MIN_INDEX])
+                    limits[typePair][MIN_INDEX] = condition.minValue;
+                if (condition.maxValue < limits[typePair][MAX_INDEX])
+                    limits[typePair][MAX_INDEX] = condition.maxValue;
+            }
+        }
+    }
+
+    // Keep only words in the limit ranges
+    if (!limits.isEmpty()) {
+        QSet<QString> returnSet = returnList.toSet();
+        QMap<int, QVector<LimitKey> > probKeyMap;
+        QVector<LimitKey> playKeys;
+
+        QMapIterator<QPair<SearchCondition::SearchType, int>, QVector<int> >
+            it (limits);
+        while (it.hasNext()) {
+            it.next();
+            SearchCondition::SearchType searchType = it.key().first;
+            int probNumBlanks = it.key().second;
+            const QVector<int> limitValues = it.value();
+            bool probCondition =
+                (searchType == SearchCondition::LimitByProbabilityOrder);
+
+            // Find the sort key of each word according to probability or
+            // playability order.  Legacy probability order limits are
+            // sorted alphabetically, not by alphagram.
+            QVector<LimitKey>& keys = probCondition ?
+                probKeyMap[probNumBlanks] : playKeys;
+            if (keys.isEmpty() &&
+                !getLimitKeys(lexicon, returnList, probCondition,
+                              probNumBlanks, legacyProbCondition, &keys))
+            {
+                return returnList;
+            }
+            int numKeys = keys.size();
+
+            if (!numKeys ||
+                (limitValues[MIN_INDEX] > limitValues[MAX_INDEX]) ||
+                (limitValues[MIN_INDEX] > numKeys) ||
+                (limitValues[MIN_LAX_INDEX] > numKeys))
+            {
+                return QStringList();
+            }
+
+            // Convert from 1-based to 0-based offset
+            int limitMin = limitValues[MIN_INDEX] - 1;
+            int limitMax = limitValues[MAX_INDEX] - 1;
+            int limitMinLax = limitValues[MIN_LAX_INDEX] - 1;
+            int limitMaxLax = limitValues[MAX_LAX_INDEX] - 1;
+
+            // Snap limits to endpoints
+            if (limitMin < 0)
+                limitMin = 0;
+            if (limitMinLax < 0)
+                limitMinLax = 0;
+            if (limitMax > numKeys - 1)
+                limitMax = numKeys - 1;
+            if (limitMaxLax > numKeys - 1)
+                limitMaxLax = numKeys - 1;
+
+            // Use the higher of the min values as working min
+            int min = (limitMin > limitMinLax) ? limitMin : limitMinLax;
+
+            // Use the lower of the max values as working max
+            int max = (limitMax < limitMaxLax) ? limitMax : limitMaxLax;
+
+            if (max < 0)
+                return QStringList();
+
+            // Find the values at the working min and max without sorting
+            // every word
+            QVector<LimitKey>::iterator begin = keys.begin();
+            QVector<LimitKey>::iterator end = keys.end();
+            std::nth_element(begin, begin + min, end);
+            qint64 minValue = keys[min].value;
+            std::nth_element(begin, begin + max, end);
+            qint64 maxValue = keys[max].value;
+
+            int numAboveMin = 0;
+            int numThroughMax = 0;
+            foreach (const LimitKey& key, keys) {
+                if (key.value > minValue)
+                    ++numAboveMin;
+                if (key.value >= maxValue)
+                    ++numThroughMax;
+            }
+
+            // Allow Lax matches only up to hard Min limit, and only for words
+            // with the same value as the word at the working min
+            min = qMax(limitMin, numAboveMin);
+
+            // Allow Lax matches only up to hard Max limit, and only for words
+            // with the same value as the word at the working max
+            max = qMin(limitMax, numThroughMax - 1);
+
+            if (min > max)
+                return QStringList();
+
+            // Only keep candidates that matched constraints
+            std::nth_element(begin, begin + min, end);
+            std::nth_element(begin + min, begin + max, end);
+            QSet<QString> limitSet;
+            for (int i = min; i <= max; ++i)
+                limitSet.insert(returnList[keys[i].index]);
+            returnSet &= limitSet;
+        }
+
+        returnList = returnSet.toList();
+    }
+
+    return returnList;
+}
+
+//---------------------------------------------------------------------------
+//  lexiconIsLoaded
+//
+//! Determine whether a lexicon is loaded.
+//
+//! @param lexicon the name of the lexicon
+//! @return true if the lexicon is loaded, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::lexiconIsLoaded(const QString& lexicon) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    return lexiconData.contains(lexicon);
+}
+
+//---------------------------------------------------------------------------
+//  getLexicon
+//
+//! Look up a lexicon by name, for making many queries on it.
+//
+//! @param lexicon the name of the lexicon
+//! @return the lexicon, or a null lexicon if it is not loaded
+//---------------------------------------------------------------------------
+WordEngine::Lexicon
+WordEngine::getLexicon(const QString& lexicon) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    const LexiconData* data = lexiconData.value(lexicon);
+    return data ? Lexicon(this, lexicon, data) : Lexicon();
+}
+
+//---------------------------------------------------------------------------
+//  isAcceptable
+//
+//! Determine whether a word is acceptable in a lexicon.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word to look up
+//! @return true if acceptable, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::isAcceptable(const QString& lexicon, const QString& word) const
+{
+    return getLexicon(lexicon).isAcceptable(word);
+}
+
+//---------------------------------------------------------------------------
+//  areAcceptable
+//
+//! Determine whether each of a list of words is acceptable in a lexicon.
+//! Words sharing prefixes are looked up faster if they are next to each
+//! other in the list.
+//
+//! @param lexicon the name of the lexicon
+//! @param words the words to look up
+//! @return a bit for each word, set if the word is acceptable
+//---------------------------------------------------------------------------
+QBitArray
+WordEngine::areAcceptable(const QString& lexicon, const QStringList& words)
+    const
+{
+    return getLexicon(lexicon).areAcceptable(words);
+}
+
+//---------------------------------------------------------------------------
+//  getLexiconMembership
+//
+//! Determine which of several lexicons contain each of a list of words.
+//! Each lexicon is checked once for the whole list, so comparing words
+//! across lexicons comes down to bit operations on the results.
+//
+//! @param lexicons the names of the lexicons, at most 32
+//! @param words the words, in upper case
+//! @return for each word, a mask with bit i set if the word is in lexicon i
+//---------------------------------------------------------------------------
+QVector<quint32>
+WordEngine::getLexiconMembership(const QStringList& lexicons, const
+                                 QStringList& words) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    QVector<quint32> membership (words.size(), 0);
+    int numLexicons = qMin(lexicons.size(), 32);
+    for (int i = 0; i < numLexicons; ++i) {
+        if (!lexiconData.contains(lexicons[i]))
+            continue;
+
+        QBitArray acceptable =
+            lexiconData[lexicons[i]]->graph->containsWords(words);
+        for (int j = 0; j < words.size(); ++j) {
+            if (acceptable.testBit(j))
+                membership[j] |= (1U << i);
+        }
+    }
+    return membership;
+}
+
+//---------------------------------------------------------------------------
+//  getHooks
+//
+//! Find the letters A to Z that form acceptable words when added to the
+//! front or back of a word.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word, in upper case
+//! @param frontHooks returns the mask of front hook letters, with bit 0
+//! standing for A
+//! @param backHooks returns the mask of back hook letters
+//---------------------------------------------------------------------------
+void
+WordEngine::getHooks(const QString& lexicon, const QString& word, quint32*
+                     frontHooks, quint32* backHooks) const
+{
+    getLexicon(lexicon).getHooks(word, frontHooks, backHooks);
+}
+
+//---------------------------------------------------------------------------
+//  getBlankVariations
+//
+//! Find the acceptable words that differ from a word by one letter played
+//! as a blank.  The letter played as a blank in each word is in lower
+//! case.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @param anagram whether to find anagrams of the word with one letter
+//! replaced by a blank, or else words matching the word with one letter
+//! replaced by a blank
+//! @return a list of acceptable words
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::getBlankVariations(const QString& lexicon, const QString& word,
+                               bool anagram) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return QStringList();
+
+    return lexiconData[lexicon]->graph->blankVariations(word, anagram);
+}
+
+//---------------------------------------------------------------------------
+//  getEditNeighbors
+//
+//! Find the acceptable words within an edit distance of a word.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @param maxDistance the maximum number of edits
+//! @param operations the edit operations allowed - see
+//! WordGraph::EditOperation
+//! @return a list of acceptable words, including the word itself if it is
+//! acceptable
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::getEditNeighbors(const QString& lexicon, const QString& word,
+                             int maxDistance, int operations) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return QStringList();
+
+    return lexiconData[lexicon]->graph->editNeighbors(word, maxDistance,
+                                                      operations);
+}
+
+//---------------------------------------------------------------------------
+//  getExtensions
+//
+//! Find the words formed by adding one or more letters to the front, the
+//! back, or both ends of a word, by traversing the subtree below the word
+//! in the word graph.  A graph without the structure needed is searched
+//! with a Pattern match instead.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @param type the kind of extensions
+//! @param maxLength the maximum length of extensions to find
+//! @return a list of acceptable words, with the added letters in lower case
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::getExtensions(const QString& lexicon, const QString& word,
+                          WordGraph::ExtensionType type, int maxLength) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon) || word.isEmpty())
+        return QStringList();
+
+    QString upper = word.toUpper();
+    QStringList words;
+    if (lexiconData[lexicon]->graph->getExtensions(upper, type, maxLength,
+                                                   &words))
+    {
+        return words;
+    }
+
+    SearchCondition condition;
+    condition.type = SearchCondition::PatternMatch;
+    condition.stringValue = (type == WordGraph::BackExtensions) ?
+        upper + "?*" : (type == WordGraph::FrontExtensions) ?
+        "*?" + upper : "*?" + upper + "?*";
+    SearchSpec spec;
+    spec.conditions.append(condition);
+    if (maxLength < MAX_WORD_LEN) {
+        condition = SearchCondition();
+        condition.type = SearchCondition::Length;
+        condition.minValue = 0;
+        condition.maxValue = maxLength;
+        spec.conditions.append(condition);
+    }
+    return search(lexicon, spec, false);
+}
+
+//---------------------------------------------------------------------------
+//  search
+//
+//! Search for acceptable words matching a search specification.  The
+//! results are cached by the optimized form of the search specification,
+//! so repeating a search does not search the lexicon again.
+//
+//! @param lexicon the name of the lexicon
+//! @param spec the search specification
+//! @param allCaps whether to ensure the words in the list are all caps
+//! @return a list of acceptable words
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::search(const QString& lexicon, const SearchSpec& spec, bool
+                   allCaps) const
+{
+    Z_TRACE_SCOPE("WordEngine::search");
+    QReadLocker locker (&lexiconLock);
+
+    QTime timer;
+    timer.start();
+    SearchProfile profile;
+    bool profiling = MainSettings::getSearchProfile();
+
+    QStringList resultList = cachedSearch(lexicon, spec, allCaps, 0,
+                                          profiling ? &profile : 0);
+    if (profiling)
+        saveSearchProfile(&profile, lexicon, spec, timer.elapsed());
+    return resultList;
+}
+
+//---------------------------------------------------------------------------
+//  GraphSearchJob
+//
+//! A job that searches a word graph for search specifications taken in
+//! turn from a shared list, until none are left.  The thread that submits
+//! the jobs can take part by calling searchAll.
+//---------------------------------------------------------------------------
+class GraphSearchJob : public Job
+{
+    public:
+    GraphSearchJob(const WordGraph* g, const QList<SearchSpec>* s,
+                   QVector<QStringList>* r, int* n, QMutex* m)
+        : Job(), graph(g), specs(s), results(r), nextSpec(n), mutex(m) { }
+    ~GraphSearchJob() { }
+
+    void searchAll() {
+        forever {
+            int i;
+            {
+                QMutexLocker locker (mutex);
+                i = (*nextSpec)++;
+            }
+            if (i >= specs->size())
+                break;
+            (*results)[i] = graph->search(specs->at(i));
+        }
+    }
+
+    protected:
+    void run() { searchAll(); }
+
+    private:
+    const WordGraph* graph;
+    const QList<SearchSpec>* specs;
+    QVector<QStringList>* results;
+    int* nextSpec;
+    QMutex* mutex;
+};
+
+//---------------------------------------------------------------------------
+//  searchMany
+//
+//! Search for acceptable words matching several search specifications at
+//! once.  A specification repeated in the list is only searched once, and
+//! specifications only needing separate traversals of the word graph are
+//! searched in parallel, each traversal in one job on the shared worker
+//! pool or in the calling thread.  The results are
+//! cached as with single searches.
+//
+//! @param lexicon the name of the lexicon
+//! @param specs the search specifications
+//! @param allCaps whether to ensure the words in the lists are all caps
+//! @return a list of acceptable words for each search specification, in
+//! the order of the specifications
+//---------------------------------------------------------------------------
+QList<QStringList>
+WordEngine::searchMany(const QString& lexicon, const QList<SearchSpec>&
+                       specs, bool allCaps) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    QList<QStringList> resultLists;
+    if (!lexiconData.contains(lexicon)) {
+        for (int i = 0; i < specs.size(); ++i)
+            resultLists.append(QStringList());
+        return resultLists;
+    }
+
+    // Find the distinct searches, by the canonical string of each optimized
+    // specification
+    LexiconData* data = lexiconData[lexicon];
+    QHash<QString, int> keyIndexes;
+    QList<SearchSpec> distinctSpecs;
+    QVector<int> distinctIndexes (specs.size());
+    QList<SearchSpec> graphSpecs;
+    QList<OptimizedSpec> graphKeys;
+    for (int i = 0; i < specs.size(); ++i) {
+        OptimizedSpec optimized = optimizeSpec(lexicon, specs[i]);
+        const SearchSpec& optimizedSpec = optimized.spec;
+        if (keyIndexes.contains(optimized.key)) {
+            distinctIndexes[i] = keyIndexes[optimized.key];
+            continue;
+        }
+        distinctIndexes[i] = distinctSpecs.size();
+        keyIndexes.insert(optimized.key, distinctSpecs.size());
+        distinctSpecs.append(specs[i]);
+
+        // Samples are drawn without finding every match
+        if (specs[i].sampleSize > 0)
+            continue;
+
+        // Searches not already cached that only traverse the word graph
+        // can be done in parallel
+        QStringList cachedList;
+        if (data->searchCache.find(getResultHash(optimized, allCaps),
+                                   optimized.key, &cachedList))
+        {
+            continue;
+        }
+        QString letters;
+        if (isExactAnagramSearch(optimizedSpec, &letters) &&
+            !data->anagramIndex.isEmpty())
+        {
+            continue;
+        }
+        QMap<ConditionPhase, int> phaseCounts =
+            getPhaseCounts(optimizedSpec);
+        if (!phaseCounts.value(DatabasePhase) &&
+            !phaseCounts.value(PostConditionPhase) &&
+            (planSearch(lexicon, optimizedSpec, phaseCounts) ==
+             DriveFromGraph))
+        {
+            graphSpecs.append(optimizedSpec);
+            graphKeys.append(optimized);
+        }
+    }
+
+    // Traverse the word graph for each of those searches in parallel, and
+    // cache the results so the searches below find them
+    if (graphSpecs.size() > 1) {
+        QVector<QStringList> graphResults (graphSpecs.size());
+        int nextSpec = 0;
+        QMutex mutex;
+        int numThreads = qMin(MainSettings::getSearchNumThreads(),
+                              graphSpecs.size());
+        GraphSearchJob job (data->graph, &graphSpecs, &graphResults,
+                            &nextSpec, &mutex);
+        QList<JobPointer> jobs;
+        for (int i = 1; i < numThreads; ++i) {
+            jobs.append(JobScheduler::getInstance()->submit(
+                new GraphSearchJob(data->graph, &graphSpecs, &graphResults,
+                                   &nextSpec, &mutex),
+                JobScheduler::InteractivePriority));
+        }
+        job.searchAll();
+
+        // Jobs that have not started by now have nothing left to search
+        foreach (const JobPointer& otherJob, jobs) {
+            otherJob->cancel();
+            otherJob->wait();
+        }
+
+        for (int i = 0; i < graphSpecs.size(); ++i) {
+            QStringList& resultList = graphResults[i];
+            if (allCaps) {
+                QStringList::iterator it;
+                for (it = resultList.begin(); it != resultList.end(); ++it)
+                    *it = (*it).toUpper();
+            }
+            data->searchCache.insert(getResultHash(graphKeys[i], allCaps),
+                                     graphKeys[i].key, resultList);
+        }
+    }
+
+    QList<QStringList> distinctResults;
+    foreach (const SearchSpec& spec, distinctSpecs)
+        distinctResults.append(cachedSearch(lexicon, spec, allCaps, 0));
+
+    for (int i = 0; i < specs.size(); ++i)
+        resultLists.append(distinctResults[distinctIndexes[i]]);
+    return resultLists;
+}
+
+//---------------------------------------------------------------------------
+//  optimizeSpec
+//
+//! Optimize a search specification with the search statistics of the
+//! lexicon, using and updating the optimized spec cache of the lexicon.  The
+//! canonical string of the optimized spec and its hash are computed once,
+//! when the spec is optimized, and include the size and modification time
+//! of any word list files the spec reads.
+//
+//! @param lexicon the name of the lexicon
+//! @param spec the search specification
+//! @return the optimized specification
+//---------------------------------------------------------------------------
+WordEngine::OptimizedSpec
+WordEngine::optimizeSpec(const QString& lexicon, const SearchSpec& spec) const
+{
+    Z_TRACE_SCOPE("WordEngine::search optimize");
+    OptimizedSpec optimized;
+    QString specKey = spec.asCanonicalString();
+    OptimizedSpecCache* specCache = 0;
+    const SearchStats* stats = 0;
+    bool found = false;
+    if (lexiconData.contains(lexicon)) {
+        specCache = &lexiconData[lexicon]->specCache;
+        found = specCache->find(specKey, &optimized);
+        stats = &lexiconData[lexicon]->searchStats;
+    }
+
+    if (!found) {
+        optimized.spec = spec;
+        optimized.spec.optimize(lexicon, stats);
+        optimized.key = optimized.spec.asCanonicalString();
+        optimized.hash = SearchSpec::hashCanonicalString(optimized.key);
+        if (specCache)
+            specCache->insert(specKey, optimized);
+    }
+
+    // Results of searches in word list files are only the same while the
+    // files are unchanged
+    QString stamps;
+    foreach (const SearchCondition& condition, optimized.spec.conditions) {
+        if (condition.isWordListFile())
+            stamps += wordListFiles.getStamp(condition.getWordListFile());
+    }
+    if (!stamps.isEmpty()) {
+        optimized.key += stamps;
+        optimized.hash = SearchSpec::hashCanonicalString(optimized.key);
+    }
+    return optimized;
+}
+
+//---------------------------------------------------------------------------
+//  cachedSearch
+//
+//! Search for acceptable words matching a search specification, using and
+//! updating the search result cache.  Cancelled searches are not cached.
+//
+//! @param lexicon the name of the lexicon
+//! @param spec the search specification
+//! @param allCaps whether to ensure the words in the list are all caps
+//! @param canceller if not null, a visitor checked between search phases
+//! that can cancel the search
+//! @param profile if not null, records the phases of the search
+//! @return a list of acceptable words, or an empty list if the search is
+//! cancelled
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::cachedSearch(const QString& lexicon, const SearchSpec& spec, bool
+                         allCaps, const WordVisitor* canceller, SearchProfile*
+                         profile) const
+{
+    if (!lexiconData.contains(lexicon))
+        return QStringList();
+
+    if (spec.sampleSize > 0)
+        return sampleSearch(lexicon, spec, allCaps, canceller, profile);
+
+    QTime timer;
+    timer.start();
+    OptimizedSpec optimized = optimizeSpec(lexicon, spec);
+    const SearchSpec& optimizedSpec = optimized.spec;
+    addProfilePhase(profile, &timer, "optimize", -1, -1);
+
+    // Return cached results if the same search has been done.  Words that
+    // are still in the word cache do not need to be added again.
+    SearchResultCache& searchCache = lexiconData[lexicon]->searchCache;
+    quint64 cacheHash = getResultHash(optimized, allCaps);
+    QStringList resultList;
+    if (searchCache.find(cacheHash, optimized.key, &resultList)) {
+        addToCache(lexicon, resultList);
+        addProfilePhase(profile, &timer, "search cache", -1,
+                        resultList.size());
+        return resultList;
+    }
+
+    // Results saved in an earlier session are cached as if just found
+    if (findSavedResults(lexicon, cacheHash, &resultList)) {
+        addProfilePhase(profile, &timer, "saved results", -1,
+                        resultList.size());
+    }
+    else {
+        QTime searchTimer;
+        searchTimer.start();
+        resultList = getSearchResults(lexicon, optimizedSpec, allCaps,
+                                      canceller, profile);
+        if (canceller && canceller->isCancelled())
+            return QStringList();
+        if (searchTimer.elapsed() >= SAVED_RESULTS_MIN_MSECS)
+            saveResults(lexicon, optimized, cacheHash, resultList);
+    }
+
+    timer.restart();
+    searchCache.insert(cacheHash, optimized.key, resultList);
+    if (!resultList.isEmpty()) {
+        clearCache(lexicon);
+        addToCache(lexicon, resultList);
+    }
+    addProfilePhase(profile, &timer, "word cache", resultList.size(),
+                    resultList.size());
+
+    return resultList;
+}
+
+//---------------------------------------------------------------------------
+//  ReservoirVisitor
+//
+//! A visitor that keeps a uniform random sample of a fixed number of the
+//! words passed to it, holding no more words than the sample size.
+//---------------------------------------------------------------------------
+class ReservoirVisitor : public WordVisitor
+{
+    public:
+    ReservoirVisitor(int n, Rand* r, const WordVisitor* c = 0)
+        : sampleSize(n), rng(r), canceller(c), numVisited(0) { }
+    ~ReservoirVisitor() { }
+
+    bool visitWord(const QString& word) {
+        ++numVisited;
+        if (words.size() < sampleSize) {
+            words.append(word);
+            return true;
+        }
+        unsigned int i = rng->rand(numVisited - 1);
+        if (i < (unsigned int) sampleSize)
+            words[i] = word;
+        return true;
+    }
+
+    bool isCancelled() const {
+        return canceller && canceller->isCancelled(); }
+
+    // The sample, in random order
+    QStringList getWords() {
+        for (int i = words.size() - 1; i > 0; --i)
+            words.swap(i, rng->rand(i));
+        return words;
+    }
+
+    int getNumVisited() const { return int(numVisited); }
+
+    private:
+    int sampleSize;
+    Rand* rng;
+    const WordVisitor* canceller;
+    unsigned int numVisited;
+    QStringList words;
+};
+
+//---------------------------------------------------------------------------
+//  sampleSearch
+//
+//! Search for a random sample of the acceptable words matching a search
+//! specification, as many as its sample size.  Searches only needing the
+//! word graph draw words from it by index when they can, and otherwise keep
+//! a reservoir sample of the words as they are found, so the words held
+//! never number more than the sample size.  Other searches sample the full
+//! results, which are cached as usual.  Samples are not cached, since each
+//! unseeded search draws a different one.  Assumes the lexicon lock is
+//! held.
+//
+//! @param lexicon the name of the lexicon
+//! @param spec the search specification
+//! @param allCaps whether to ensure the words in the list are all caps
+//! @param canceller if not null, a visitor checked between search phases
+//! that can cancel the search
+//! @param profile if not null, records the phases of the search
+//! @return the sample in random order, or an empty list if the search is
+//! cancelled
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::sampleSearch(const QString& lexicon, const SearchSpec& spec, bool
+                         allCaps, const WordVisitor* canceller, SearchProfile*
+                         profile) const
+{
+    Z_TRACE_SCOPE("WordEngine::search sample");
+    SearchSpec fullSpec = spec;
+    fullSpec.sampleSize = 0;
+    fullSpec.sampleSeed = 0;
+
+    Rand rng (Rand::Xoshiro128PlusPlus);
+    if (spec.sampleSeed)
+        rng.srand(spec.sampleSeed);
+    else
+        rng.srand(QDateTime::currentDateTime().toTime_t(), Auxil::getPid());
+
+    QTime timer;
+    timer.start();
+    SearchSpec optimizedSpec = optimizeSpec(lexicon, fullSpec).spec;
+    QMap<ConditionPhase, int> phaseCounts = getPhaseCounts(optimizedSpec);
+    addProfilePhase(profile, &timer, "optimize", -1, -1);
+    if (optimizedSpec.conditions.isEmpty())
+        return QStringList();
+
+    ReservoirVisitor reservoir (spec.sampleSize, &rng, canceller);
+    if (!phaseCounts.value(DatabasePhase) &&
+        !phaseCounts.value(PostConditionPhase))
+    {
+        const WordGraph* graph = lexiconData[lexicon]->graph;
+        QStringList sample;
+        if (allCaps &&
+            graph->sampleWords(optimizedSpec, spec.sampleSize, &rng, &sample))
+        {
+            addProfilePhase(profile, &timer, "word graph sample", -1,
+                            sample.size());
+            return sample;
+        }
+
+        UpperCaseVisitor upperVisitor (&reservoir);
+        WordVisitor* graphVisitor = &reservoir;
+        if (allCaps)
+            graphVisitor = &upperVisitor;
+        if (!graph->search(optimizedSpec, graphVisitor, 1))
+            return QStringList();
+        sample = reservoir.getWords();
+        addProfilePhase(profile, &timer, "word graph sample",
+                        reservoir.getNumVisited(), sample.size());
+        return sample;
+    }
+
+    QStringList resultList = cachedSearch(lexicon, fullSpec, allCaps,
+                                          canceller, profile);
+    if (canceller && canceller->isCancelled())
+        return QStringList();
+    timer.restart();
+    foreach (const QString& word, resultList)
+        reservoir.visitWord(word);
+    QStringList sample = reservoir.getWords();
+    addProfilePhase(profile, &timer, "sample", resultList.size(),
+                    sample.size());
+    return sample;
+}
+
+//---------------------------------------------------------------------------
+//  refineSearch
+//
+//! Search for acceptable words matching a search specification that may be
+//! a refinement of a previous search specification.  If so, only the
+//! conditions added to the previous specification are checked, against the
+//! results of the previous search instead of the whole lexicon.  Otherwise
+//! the search is done as usual.
+//
+//! @param lexicon the name of the lexicon
+//! @param spec the search specification
+//! @param allCaps whether to ensure the words in the list are all caps
+//! @param previousSpec the previous search specification
+//! @param previousResults the complete results of the previous search,
+//! found with the same value of allCaps
+//! @param canceller if not null, a visitor checked between search phases
+//! that can cancel the search
+//! @param profile if not null and search profiling is enabled, returns the
+//! phases of the search
+//! @return a list of acceptable words, or an empty list if the search is
+//! cancelled
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::refineSearch(const QString& lexicon, const SearchSpec& spec, bool
+                         allCaps, const SearchSpec& previousSpec, const
+                         QStringList& previousResults, const WordVisitor*
+                         canceller, SearchProfile* profile) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    QTime totalTimer;
+    totalTimer.start();
+    SearchProfile localProfile;
+    if (!MainSettings::getSearchProfile())
+        profile = 0;
+    else if (!profile)
+        profile = &localProfile;
+    if (profile)
+        *profile = SearchProfile();
+
+    // Previous results of searches in word list files may be out of date
+    bool readsFiles = false;
+    foreach (const SearchCondition& condition, spec.conditions)
+        readsFiles = readsFiles || condition.isWordListFile();
+
+    SearchSpec addedSpec;
+    if (readsFiles ||
+        !spec.isRefinementOf(previousSpec, &addedSpec.conditions))
+    {
+        QStringList resultList = cachedSearch(lexicon, spec, allCaps,
+                                              canceller, profile);
+        saveSearchProfile(profile, lexicon, spec, totalTimer.elapsed());
+        return resultList;
+    }
+
+    if (!lexiconData.contains(lexicon))
+        return QStringList();
+
+    QTime timer;
+    timer.start();
+    OptimizedSpec optimized = optimizeSpec(lexicon, spec);
+    const SearchSpec& optimizedSpec = optimized.spec;
+    addProfilePhase(profile, &timer, "optimize", -1, -1);
+    if (optimizedSpec.conditions.isEmpty() || previousResults.isEmpty())
+        return QStringList();
+
+    SearchResultCache& searchCache = lexiconData[lexicon]->searchCache;
+    quint64 cacheHash = getResultHash(optimized, allCaps);
+    QStringList resultList;
+    if (searchCache.find(cacheHash, optimized.key, &resultList)) {
+        addToCache(lexicon, resultList);
+        addProfilePhase(profile, &timer, "search cache", -1,
+                        resultList.size());
+        saveSearchProfile(profile, lexicon, spec, totalTimer.elapsed());
+        return resultList;
+    }
+
+    // Added conditions that are always true leave nothing to check
+    addedSpec.optimize(lexicon);
+    resultList = previousResults;
+    QMap<ConditionPhase, int> phaseCounts = getPhaseCounts(addedSpec);
+    timer.restart();
+
+    // Which letters of a word graph match are shown in lower case depends on
+    // every word graph condition, so search a word graph built from the
+    // previous results with all of them
+    if (phaseCounts.value(WordGraphPhase)) {
+        int numIn = resultList.size();
+        QStringList upperList;
+        foreach (const QString& word, resultList)
+            upperList.append(word.toUpper());
+        resultList = wordGraphSearch(lexicon, optimizedSpec, &upperList);
+        addProfilePhase(profile, &timer, "word graph", numIn,
+                        resultList.size());
+    }
+    if (canceller && canceller->isCancelled())
+        return QStringList();
+
+    if (phaseCounts.value(DatabasePhase) && !resultList.isEmpty()) {
+        int numIn = resultList.size();
+        QString queryStr;
+        resultList = databaseSearch(lexicon, addedSpec, &resultList,
+                                    &queryStr);
+        addProfilePhase(profile, &timer, "database", numIn,
+                        resultList.size(), queryStr);
+    }
+    if (canceller && canceller->isCancelled())
+        return QStringList();
+
+    if (phaseCounts.value(PostConditionPhase) && !resultList.isEmpty()) {
+        int numIn = resultList.size();
+        resultList = applyPostConditions(lexicon, addedSpec, resultList);
+        addProfilePhase(profile, &timer, "post conditions", numIn,
+                        resultList.size());
+    }
+
+    if (allCaps) {
+        QStringList::iterator it;
+        for (it = resultList.begin(); it != resultList.end(); ++it)
+            *it = (*it).toUpper();
+    }
+
+    timer.restart();
+    searchCache.insert(cacheHash, optimized.key, resultList);
+    if (!resultList.isEmpty()) {
+        clearCache(lexicon);
+        addToCache(lexicon, resultList);
+    }
+    addProfilePhase(profile, &timer, "word cache", resultList.size(),
+                    resultList.size());
+
+    saveSearchProfile(profile, lexicon, spec, totalTimer.elapsed());
+    return resultList;
+}
+
+//---------------------------------------------------------------------------
+//  getSearchResults
+//
+//! Search for acceptable words matching an optimized search specification,
+//! without using or updating any cache.
+//
+//! @param lexicon the name of the lexicon
+//! @param optimizedSpec the optimized search spec
+//! @param allCaps whether to ensure the words in the list are all caps
+//! @param canceller if not null, a visitor checked between search phases
+//! that can cancel the search
+//! @param profile if not null, records the phases of the search
+//! @return a list of acceptable words, or an empty list if the search is
+//! cancelled
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::getSearchResults(const QString& lexicon, const SearchSpec&
+                             optimizedSpec, bool allCaps, const WordVisitor*
+                             canceller, SearchProfile* profile) const
+{
+    QTime timer;
+    timer.start();
+
+    // Exact anagrams are found in the anagram index without searching
+    QString letters;
+    if (isExactAnagramSearch(optimizedSpec, &letters) &&
+        !lexiconData[lexicon]->anagramIndex.isEmpty())
+    {
+        QStringList resultList = getIndexedAnagrams(lexicon, letters);
+        addProfilePhase(profile, &timer, "anagram index", -1,
+                        resultList.size());
+        return resultList;
+    }
+
+    QMap<ConditionPhase, int> phaseCounts = getPhaseCounts(optimizedSpec);
+    SearchDriver driver = planSearch(lexicon, optimizedSpec, phaseCounts);
+    bool graphPhase = phaseCounts.value(WordGraphPhase) ||
+        !phaseCounts.value(DatabasePhase);
+    bool databasePhase = phaseCounts.value(DatabasePhase);
+    addProfilePhase(profile, &timer, "plan", -1, -1);
+
+    // Find the candidate words if the search is not driven from the word
+    // graph.  Candidates from the database already match every database
+    // condition.
+    QStringList resultList;
+    if (driver == DriveFromDatabase) {
+        QString queryStr;
+        resultList = databaseSearch(lexicon, optimizedSpec, 0, &queryStr);
+        addProfilePhase(profile, &timer, "database", -1, resultList.size(),
+                        queryStr);
+        if (resultList.isEmpty())
+            return resultList;
+        databasePhase = false;
+    }
+    else if (driver == DriveFromWordList) {
+        resultList = getWordListCandidates(lexicon, optimizedSpec);
+        addProfilePhase(profile, &timer, "word list", -1, resultList.size());
+        if (resultList.isEmpty())
+            return resultList;
+    }
+    else if (driver == DriveFromLexicon) {
+        resultList = getLexiconJoinCandidates(lexicon, optimizedSpec);
+        addProfilePhase(profile, &timer, "lexicon join", -1,
+                        resultList.size());
+        if (resultList.isEmpty())
+            return resultList;
+
+        // The join finds acceptable words matching the Length conditions,
+        // the only conditions before the post conditions
+        graphPhase = false;
+        databasePhase = false;
+    }
+    bool candidates = (driver != DriveFromGraph);
+    if (canceller && canceller->isCancelled())
+        return QStringList();
+
+    // Search the word graph if necessary, limited to any candidates
+    if (graphPhase) {
+        int numIn = candidates ? resultList.size() : -1;
+        resultList = wordGraphSearch(lexicon, optimizedSpec,
+                                     candidates ? &resultList : 0);
+        addProfilePhase(profile, &timer, "word graph", numIn,
+                        resultList.size());
+        if (resultList.isEmpty())
+            return resultList;
+    }
+    if (canceller && canceller->isCancelled())
+        return QStringList();
+
+    // Search the database if necessary, passing word graph results
+    if (databasePhase) {
+        bool passList = phaseCounts.contains(WordGraphPhase) || candidates;
+        int numIn = passList ? resultList.size() : -1;
+        QString queryStr;
+        resultList = databaseSearch(lexicon, optimizedSpec,
+                                    passList ? &resultList : 0, &queryStr);
+        addProfilePhase(profile, &timer, "database", numIn,
+                        resultList.size(), queryStr);
+        if (resultList.isEmpty())
+            return resultList;
+    }
+    if (canceller && canceller->isCancelled())
+        return QStringList();
+
+    // Check post conditions if necessary
+    if (phaseCounts.value(PostConditionPhase)) {
+        int numIn = resultList.size();
+        resultList = applyPostConditions(lexicon, optimizedSpec, resultList);
+        addProfilePhase(profile, &timer, "post conditions", numIn,
+                        resultList.size());
+    }
+
+    // Convert to all caps if necessary
+    if (allCaps) {
+        QStringList::iterator it;
+        for (it = resultList.begin(); it != resultList.end(); ++it)
+            *it = (*it).toUpper();
+    }
+
+    return resultList;
+}
+
+//---------------------------------------------------------------------------
+//  search
+//
+//! Search for acceptable words matching a search specification, passing
+//! each word to a visitor instead of returning a list.  If the search only
+//! needs the word graph, words are passed to the visitor as they are found
+//! without building a list of all results, and the word cache is not
+//! updated.
+//
+//! @param lexicon the name of the lexicon
+//! @param spec the search specification
+//! @param allCaps whether to ensure the words passed are all caps
+//! @param visitor the visitor to receive each acceptable word, which can
+//! also cancel the search between phases and during word graph traversals
+//! @param profile if not null and search profiling is enabled, returns the
+//! phases of the search
+//! @return false if the visitor stopped or cancelled the search, true
+//! otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::search(const QString& lexicon, const SearchSpec& spec, bool
+                   allCaps, WordVisitor* visitor, SearchProfile* profile) const
+{
+    Z_TRACE_SCOPE("WordEngine::search");
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return true;
+
+    QTime totalTimer;
+    totalTimer.start();
+    SearchProfile localProfile;
+    if (!MainSettings::getSearchProfile())
+        profile = 0;
+    else if (!profile)
+        profile = &localProfile;
+    if (profile)
+        *profile = SearchProfile();
+
+    SearchSpec optimizedSpec = optimizeSpec(lexicon, spec).spec;
+    QMap<ConditionPhase, int> phaseCounts = getPhaseCounts(optimizedSpec);
+
+    if ((spec.sampleSize > 0) || phaseCounts.value(DatabasePhase) ||
+        phaseCounts.value(PostConditionPhase))
+    {
+        QStringList resultList = cachedSearch(lexicon, spec, allCaps,
+                                              visitor, profile);
+        saveSearchProfile(profile, lexicon, spec, totalTimer.elapsed());
+        if (visitor->isCancelled())
+            return false;
+        foreach (const QString& word, resultList) {
+            if (!visitor->visitWord(word))
+                return false;
+        }
+        return true;
+    }
+
+    QTime timer;
+    timer.start();
+    addProfilePhase(profile, &timer, "optimize", -1, -1);
+
+    // Words are passed on as they are found, so count them on the way
+    CountingVisitor countingVisitor (visitor);
+    UpperCaseVisitor upperVisitor (&countingVisitor);
+    WordVisitor* graphVisitor = &countingVisitor;
+    if (allCaps)
+        graphVisitor = &upperVisitor;
+
+    bool ok = lexiconData[lexicon]->graph->search(optimizedSpec,
+        graphVisitor, MainSettings::getSearchNumThreads());
+
+    addProfilePhase(profile, &timer, "word graph", -1,
+                    countingVisitor.getNumWords());
+    saveSearchProfile(profile, lexicon, spec, totalTimer.elapsed());
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+//  getLastSearchProfile
+//
+//! Get the profile of the last search done while search profiling was
+//! enabled, from any thread.
+//
+//! @return the search profile, or an empty profile if no search has been
+//! profiled
+//---------------------------------------------------------------------------
+WordEngine::SearchProfile
+WordEngine::getLastSearchProfile() const
+{
+    QMutexLocker locker (&profileMutex);
+    return lastSearchProfile;
+}
+
+//---------------------------------------------------------------------------
+//  addProfilePhase
+//
+//! Record a phase of a search in a search profile, and restart the timer
+//! of the phase.
+//
+//! @param profile the search profile, or null if the search is not being
+//! profiled
+//! @param timer the timer started at the beginning of the phase
+//! @param name the name of the phase
+//! @param numIn the number of candidates entering the phase, or -1
+//! @param numOut the number of words leaving the phase, or -1
+//! @param query the SQL query run by the phase, if any
+//---------------------------------------------------------------------------
+void
+WordEngine::addProfilePhase(SearchProfile* profile, QTime* timer, const
+                            QString& name, int numIn, int numOut, const
+                            QString& query) const
+{
+    if (!profile)
+        return;
+
+    profile->phases.append(SearchProfile::Phase(name, timer->restart(),
+                                                numIn, numOut, query));
+}
+
+//---------------------------------------------------------------------------
+//  saveSearchProfile
+//
+//! Finish a search profile and save it as the last search profile.
+//
+//! @param profile the search profile, or null if the search is not being
+//! profiled
+//! @param lexicon the name of the lexicon searched
+//! @param spec the search specification
+//! @param msecs the total time of the search
+//---------------------------------------------------------------------------
+void
+WordEngine::saveSearchProfile(SearchProfile* profile, const QString& lexicon,
+                              const SearchSpec& spec, int msecs) const
+{
+    if (!profile)
+        return;
+
+    profile->lexicon = lexicon;
+    profile->spec = spec.asString();
+    profile->msecs = msecs;
+
+    QMutexLocker locker (&profileMutex);
+    lastSearchProfile = *profile;
+}
+
+//---------------------------------------------------------------------------
+//  isExactAnagramSearch
+//
+//! Determine whether an optimized search spec only searches for the exact
+//! anagrams of some letters, without wildcards.
+//
+//! @param optimizedSpec the optimized search spec
+//! @param letters returns the letters
+//! @return true if the spec is an exact anagram search, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::isExactAnagramSearch(const SearchSpec& optimizedSpec, QString*
+                                 letters) const
+{
+    if (!optimizedSpec.conjunction)
+        return false;
+
+    QString anagram;
+    QList<SearchCondition> lengthConditions;
+    QListIterator<SearchCondition> it (optimizedSpec.conditions);
+    while (it.hasNext()) {
+        const SearchCondition& condition = it.next();
+        switch (condition.type) {
+            case SearchCondition::AnagramMatch:
+            if (condition.negated || !anagram.isEmpty() ||
+                condition.stringValue.isEmpty())
+            {
+                return false;
+            }
+            anagram = condition.stringValue;
+            break;
+
+            case SearchCondition::Length:
+            lengthConditions.append(condition);
+            break;
+
+            default:
+            return false;
+        }
+    }
+
+    if (anagram.isEmpty())
+        return false;
+    for (int i = 0; i < anagram.length(); ++i) {
+        QChar c = anagram.at(i);
+        if (!c.isLetter() || !c.isUpper())
+            return false;
+    }
+
+    int length = anagram.length();
+    foreach (const SearchCondition& condition, lengthConditions) {
+        if ((length < condition.minValue) || (length > condition.maxValue))
+            return false;
+    }
+
+    *letters = anagram;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  getIndexedAnagrams
+//
+//! Find the exact anagrams of some letters in the anagram index.
+//
+//! @param lexicon the name of the lexicon
+//! @param letters the letters, in upper case
+//! @return the anagrams in alphabetical order
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::getIndexedAnagrams(const QString& lexicon, const QString& letters)
+    const
+{
+    Z_TRACE_SCOPE("WordEngine::search anagram index");
+    QStringList anagrams;
+    if (!lexiconData.contains(lexicon))
+        return anagrams;
+
+    const LexiconData* data = lexiconData[lexicon];
+    const AnagramIndex& index = data->anagramIndex;
+    QHash<QString, QPair<qint32, qint32> >::const_iterator it =
+        index.groups.find(Auxil::getAlphagram(letters));
+    if (it == index.groups.end())
+        return anagrams;
+
+    for (qint32 i = it.value().first; i < it.value().second; ++i)
+        anagrams.append(data->graph->wordAt(index.wordIds[i]));
+    return anagrams;
+}
+
+//---------------------------------------------------------------------------
+//  getPhaseCounts
+//
+//! Determine how many conditions of an optimized search specification are
+//! handled in each phase of a search.
+//
+//! @param optimizedSpec the optimized search spec
+//! @return the number of conditions in each phase
+//---------------------------------------------------------------------------
+QMap<WordEngine::ConditionPhase, int>
+WordEngine::getPhaseCounts(const SearchSpec& optimizedSpec) const
+{
+    // Discover which kinds of search conditions are present
+    QMap<ConditionPhase, int> phaseCounts;
+    int lengthConditions = 0;
+    QListIterator<SearchCondition> cit (optimizedSpec.conditions);
+    while (cit.hasNext()) {
+        SearchCondition condition = cit.next();
+        ConditionPhase phase = getConditionPhase(condition);
+        ++phaseCounts[phase];
+        if (condition.type == SearchCondition::Length)
+            ++lengthConditions;
+    }
+
+    // Do not search the database based on Length conditions that were only
+    // added by SearchSpec::optimize to optimize word graph searches
+    if ((phaseCounts.contains(WordGraphPhase)) && lengthConditions &&
+        (lengthConditions == phaseCounts.value(DatabasePhase)))
+    {
+        --phaseCounts[DatabasePhase];
+    }
+
+    return phaseCounts;
+}
+
+//---------------------------------------------------------------------------
+//  countMatches
+//
+//! Count the acceptable words matching a search specification without
+//! building a list of them where possible.  Database conditions are counted
+//! by the database, and word graph conditions by the word graph.  A search
+//! drawing a random sample counts the words it would draw.
+//
+//! @param lexicon the name of the lexicon
+//! @param spec the search specification
+//! @return the number of acceptable words
+//---------------------------------------------------------------------------
+int
+WordEngine::countMatches(const QString& lexicon, const SearchSpec& spec) const
+{
+    if (spec.sampleSize > 0) {
+        SearchSpec fullSpec = spec;
+        fullSpec.sampleSize = 0;
+        fullSpec.sampleSeed = 0;
+        return qMin(spec.sampleSize, countMatches(lexicon, fullSpec));
+    }
+
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    SearchSpec optimizedSpec = optimizeSpec(lexicon, spec).spec;
+    QMap<ConditionPhase, int> phaseCounts = getPhaseCounts(optimizedSpec);
+
+    // Post conditions are applied to lists of words
+    if (phaseCounts.value(PostConditionPhase))
+        return search(lexicon, spec, false).size();
+
+    bool graphPhase = phaseCounts.value(WordGraphPhase) ||
+        !phaseCounts.value(DatabasePhase);
+    if (!phaseCounts.value(DatabasePhase)) {
+        return lexiconData[lexicon]->graph->countMatches(optimizedSpec,
+            MainSettings::getSearchNumThreads());
+    }
+
+    // Searches driven by candidate words are cheaper than counting the
+    // words matched by the word graph
+    if (planSearch(lexicon, optimizedSpec, phaseCounts) != DriveFromGraph)
+        return search(lexicon, spec, false).size();
+
+    // Count database results, limited by any word graph results
+    QStringList wordList;
+    if (graphPhase) {
+        wordList = wordGraphSearch(lexicon, optimizedSpec);
+        if (wordList.isEmpty())
+            return 0;
+    }
+
+    QSqlDatabase* db = getDatabase(lexicon);
+    if (!db)
+        return 0;
+
+    QString queryStr = getDatabaseQuery(optimizedSpec,
+        phaseCounts.contains(WordGraphPhase) ? &wordList : 0, true);
+    QSqlQuery query (queryStr, *db);
+    return query.next() ? query.value(0).toInt() : 0;
+}
+
+//---------------------------------------------------------------------------
+//  planSearch
+//
+//! Choose where to find the first candidate words of a search.  A search
+//! with both word graph and database conditions is driven from the database
+//! or from a word list if they are estimated to match few enough words,
+//! since the word graph search may have to scan most of the graph.  A
+//! search with only Length conditions besides its post conditions, and an
+//! In Lexicon condition, is driven from a join of the word graphs of the
+//! two lexicons instead of looking up every word in the other lexicon.
+//
+//! @param lexicon the name of the lexicon
+//! @param optimizedSpec the optimized search spec
+//! @param phaseCounts the number of conditions in each phase
+//! @return where to find the candidate words
+//---------------------------------------------------------------------------
+WordEngine::SearchDriver
+WordEngine::planSearch(const QString& lexicon, const SearchSpec&
+                       optimizedSpec, const QMap<ConditionPhase, int>&
+                       phaseCounts) const
+{
+    Z_TRACE_SCOPE("WordEngine::search plan");
+    if (optimizedSpec.conjunction && !phaseCounts.value(WordGraphPhase) &&
+        lexiconData.contains(lexicon))
+    {
+        int lengthConditions = 0;
+        QListIterator<SearchCondition> cit (optimizedSpec.conditions);
+        while (cit.hasNext()) {
+            if (cit.next().type == SearchCondition::Length)
+                ++lengthConditions;
+        }
+        if ((phaseCounts.value(DatabasePhase) == lengthConditions) &&
+            getLexiconJoin(lexicon, optimizedSpec))
+        {
+            return DriveFromLexicon;
+        }
+    }
+
+    if (!optimizedSpec.conjunction || !phaseCounts.value(WordGraphPhase) ||
+        !phaseCounts.value(DatabasePhase) || !lexiconData.contains(lexicon))
+    {
+        return DriveFromGraph;
+    }
+
+    const LexiconData* data = lexiconData[lexicon];
+    if (!data->db || data->searchStats.isEmpty())
+        return DriveFromGraph;
+
+    // Anagrams without wildcards are found directly in the word graph
+    QListIterator<SearchCondition> cit (optimizedSpec.conditions);
+    while (cit.hasNext()) {
+        const SearchCondition& condition = cit.next();
+        if ((condition.type == SearchCondition::AnagramMatch) &&
+            !condition.negated && !condition.stringValue.contains("*"))
+        {
+            return DriveFromGraph;
+        }
+    }
+
+    int wordListSize = -1;
+    int estimate = estimateDatabaseMatches(lexicon, optimizedSpec,
+                                           &wordListSize);
+    if (estimate > MAX_PLANNED_CANDIDATES)
+        return DriveFromGraph;
+
+    return ((wordListSize >= 0) && (wordListSize <= estimate))
+        ? DriveFromWordList : DriveFromDatabase;
+}
+
+//---------------------------------------------------------------------------
+//  estimateDatabaseMatches
+//
+//! Estimate an upper bound on the number of words matching the database
+//! conditions of a search spec, from the search statistics of the lexicon.
+//! The estimate is the number of words matching the most selective
+//! condition.
+//
+//! @param lexicon the name of the lexicon
+//! @param optimizedSpec the optimized search spec
+//! @param wordListSize returns the number of words in the smallest word list
+//! the words must be in, or -1 if there is none
+//! @return the estimated number of words
+//---------------------------------------------------------------------------
+int
+WordEngine::estimateDatabaseMatches(const QString& lexicon, const SearchSpec&
+                                    optimizedSpec, int* wordListSize) const
+{
+    *wordListSize = -1;
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    // Find the range of word lengths
+    int minLength = 0;
+    int maxLength = MAX_WORD_LEN;
+    QListIterator<SearchCondition> cit (optimizedSpec.conditions);
+    while (cit.hasNext()) {
+        const SearchCondition& condition = cit.next();
+        if ((condition.type != SearchCondition::Length) || condition.negated)
+            continue;
+        minLength = qMax(minLength, condition.minValue);
+        maxLength = qMin(maxLength, condition.maxValue);
+    }
+
+    // Narrow the estimate using the most selective condition
+    const SearchStats& stats = lexiconData[lexicon]->searchStats;
+    int estimate = stats.getLengthCount(minLength, maxLength);
+    cit.toFront();
+    while (cit.hasNext()) {
+        const SearchCondition& condition = cit.next();
+        if (condition.negated ||
+            (getConditionPhase(condition) != DatabasePhase))
+        {
+            continue;
+        }
+
+        if (condition.type == SearchCondition::InWordList) {
+            int size = getWordListWords(condition).size();
+            if ((*wordListSize < 0) || (size < *wordListSize))
+                *wordListSize = size;
+            estimate = qMin(estimate, size);
+            continue;
+        }
+        estimate = qMin(estimate, stats.estimateMatches(condition, minLength,
+                                                        maxLength));
+    }
+
+    return estimate;
+}
+
+//---------------------------------------------------------------------------
+//  getWordListWords
+//
+//! Get the words of an In Word List condition, in upper case.  Words read
+//! from a file are read once and kept until the file changes.  The words of
+//! a word ID list file are found by index in the word graph of its lexicon,
+//! which must be loaded and have the build the IDs were saved from.
+//
+//! @param condition the condition
+//! @param lexicon the name of the lexicon being searched
+//! @param acceptable if not null, returns whether every word is known to
+//! be acceptable in the lexicon being searched, because the words are from
+//! a word ID list of that lexicon
+//! @return the words, or an empty list if they cannot be read
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::getWordListWords(const SearchCondition& condition, const
+                             QString& lexicon, bool* acceptable) const
+{
+    if (acceptable)
+        *acceptable = false;
+
+    QStringList words;
+    if (!condition.isWordListFile()) {
+        return condition.stringValue.toUpper().split(QChar(' '),
+                                                     QString::SkipEmptyParts);
+    }
+
+    QString filename = condition.getWordListFile();
+    if (wordListFiles.getWords(filename, &words))
+        return words;
+
+    WordIdList idList;
+    if (!wordListFiles.getWordIds(filename, &idList)) {
+        qWarning("Cannot read word list file %s",
+                 filename.toLocal8Bit().constData());
+        return words;
+    }
+
+    const LexiconData* data = lexiconData.value(idList.getLexicon());
+    const WordGraph* graph = data ? data->graph : 0;
+    if (!graph || !graph->hasWordCounts() ||
+        (graph->getFingerprint() != idList.getBuild()))
+    {
+        qWarning("Word list file %s does not match lexicon %s",
+                 filename.toLocal8Bit().constData(),
+                 idList.getLexicon().toLocal8Bit().constData());
+        return words;
+    }
+
+    QVector<qint32> ids = idList.getIds();
+    words.reserve(ids.size());
+    for (int i = 0; i < ids.size(); ++i) {
+        QString word = graph->wordAt(ids[i]);
+        if (!word.isEmpty())
+            words.append(word);
+    }
+    if (acceptable)
+        *acceptable = (idList.getLexicon() == lexicon);
+    return words;
+}
+
+//---------------------------------------------------------------------------
+//  getLexiconJoin
+//
+//! Find the In Lexicon condition of a search spec whose lexicon can be
+//! joined with the lexicon being searched.  Conditions requiring words to be
+//! in a lexicon are preferred, since their joins find fewer words.
+//
+//! @param lexicon the name of the lexicon being searched
+//! @param optimizedSpec the optimized search spec
+//! @param other returns the word graph of the lexicon of the condition
+//! @param difference returns whether words must not be in that lexicon
+//! @return true if a condition was found, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::getLexiconJoin(const QString& lexicon, const SearchSpec&
+                           optimizedSpec, const WordGraph** other, bool*
+                           difference) const
+{
+    const LexiconData* data = lexiconData.value(lexicon);
+    if (!data || !data->graph || !data->graph->hasWordCounts())
+        return false;
+
+    const WordGraph* joinGraph = 0;
+    bool joinDifference = false;
+    QListIterator<SearchCondition> cit (optimizedSpec.conditions);
+    while (cit.hasNext()) {
+        const SearchCondition& condition = cit.next();
+        if (condition.type != SearchCondition::InLexicon)
+            continue;
+
+        const LexiconData* otherData =
+            lexiconData.value(condition.stringValue);
+        const WordGraph* graph = otherData ? otherData->graph : 0;
+        if (!graph || !graph->hasWordCounts())
+            continue;
+
+        if (!joinGraph || (joinDifference && !condition.negated)) {
+            joinGraph = graph;
+            joinDifference = condition.negated;
+        }
+    }
+
+    if (!joinGraph)
+        return false;
+    if (other)
+        *other = joinGraph;
+    if (difference)
+        *difference = joinDifference;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  getLexiconJoinCandidates
+//
+//! Get the words of a lexicon that are in, or not in, the lexicon of an In
+//! Lexicon condition of a search spec, and that match its Length
+//! conditions, by joining the word graphs of the lexicons.  The In Lexicon
+//! condition is still checked as a post condition.
+//
+//! @param lexicon the name of the lexicon
+//! @param optimizedSpec the optimized search spec
+//! @return the words, in upper case and alphabetical order
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::getLexiconJoinCandidates(const QString& lexicon, const
+                                     SearchSpec& optimizedSpec) const
+{
+    Z_TRACE_SCOPE("WordEngine::search lexicon join");
+    const WordGraph* other = 0;
+    bool difference = false;
+    if (!getLexiconJoin(lexicon, optimizedSpec, &other, &difference))
+        return QStringList();
+
+    int minLength = 0;
+    int maxLength = MAX_WORD_LEN;
+    QListIterator<SearchCondition> cit (optimizedSpec.conditions);
+    while (cit.hasNext()) {
+        const SearchCondition& condition = cit.next();
+        if (condition.type != SearchCondition::Length)
+            continue;
+        minLength = qMax(minLength, condition.minValue);
+        maxLength = qMin(maxLength, condition.maxValue);
+    }
+
+    return lexiconData[lexicon]->graph->joinWords(*other, difference,
+                                                  minLength, maxLength);
+}
+
+//---------------------------------------------------------------------------
+//  getWordListCandidates
+//
+//! Get the acceptable words in the smallest word list of a search spec that
+//! words must be in.
+//
+//! @param lexicon the name of the lexicon
+//! @param optimizedSpec the optimized search spec
+//! @return the acceptable words in the word list
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::getWordListCandidates(const QString& lexicon, const SearchSpec&
+                                  optimizedSpec) const
+{
+    Z_TRACE_SCOPE("WordEngine::search word list");
+    QStringList wordList;
+    bool found = false;
+    bool allAcceptable = false;
+    QListIterator<SearchCondition> cit (optimizedSpec.conditions);
+    while (cit.hasNext()) {
+        const SearchCondition& condition = cit.next();
+        if ((condition.type != SearchCondition::InWordList) ||
+            condition.negated)
+        {
+            continue;
+        }
+
+        bool listAcceptable = false;
+        QStringList words = getWordListWords(condition, lexicon,
+                                             &listAcceptable);
+        if (!found || (words.size() < wordList.size())) {
+            wordList = words;
+            allAcceptable = listAcceptable;
+        }
+        found = true;
+    }
+
+    // The words of a word ID list of the lexicon need no checking
+    QStringList candidates;
+    if (wordList.isEmpty() || allAcceptable)
+        return wordList;
+
+    QBitArray acceptable = lexiconData[lexicon]->graph->containsWords(
+        wordList);
+    for (int i = 0; i < wordList.size(); ++i) {
+        if (acceptable.testBit(i))
+            candidates.append(wordList[i]);
+    }
+    return candidates;
+}
+
+//---------------------------------------------------------------------------
+//  wordGraphSearch
+//
+//! Search the word graph for words matching the conditions in a search spec.
+//! If a word list is provided, search a word graph built from that list
+//! instead.
+//
+//! @param lexicon the name of the lexicon
+//! @param optimizedSpec the search spec
+//! @param wordList optional list of upper case words that results must be in
+//! @return a list of words
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::wordGraphSearch(const QString& lexicon, const SearchSpec&
+                            optimizedSpec, const QStringList* wordList) const
+{
+    Z_TRACE_SCOPE("WordEngine::search word graph");
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return QStringList();
+
+    if (!wordList) {
+        return lexiconData[lexicon]->graph->search(optimizedSpec,
+            MainSettings::getSearchNumThreads());
+    }
+
+    WordGraph listGraph;
+    if (!listGraph.importWords(*wordList, false) ||
+        !listGraph.importWords(*wordList, true))
+    {
+        return QStringList();
+    }
+    return listGraph.search(optimizedSpec);
+}
+
+//---------------------------------------------------------------------------
+//  alphagrams
+//
+//! Transform a list of strings into a list of alphagrams of those strings.
+//! The created list may be shorter than the original list.
+//
+//! @param list the list of strings
+//! @return a list of alphagrams
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::alphagrams(const QStringList& strList) const
+{
+    // Insert into a set to remove duplicates
+    QSet<QString> alphaSet;
+    foreach (const QString& str, strList) {
+        alphaSet.insert(Auxil::getAlphagram(str));
+    }
+
+    QStringList alphaList = alphaSet.toList();
+    qSort(alphaList.begin(), alphaList.end(),
+          Auxil::localeAwareLessThanQString);
+    return alphaList;
+}
+
+//---------------------------------------------------------------------------
+//  getWordInfo
+//
+//! Get information about a word from the database.  Also cache the
+//! information for future queries.  Fail if the information is not in the
+//! cache and the database is not open.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @return information about the word from the database
+//---------------------------------------------------------------------------
+WordEngine::WordInfo
+WordEngine::getWordInfo(const QString& lexicon, const QString& word) const
+{
+    return getLexicon(lexicon).getWordInfo(word);
+}
+
+//---------------------------------------------------------------------------
+//  getNumWords
+//
+//! Return a word count for the current lexicon.
+//
+//! @param lexicon the name of the lexicon
+//! @return the word count
+//---------------------------------------------------------------------------
+int
+WordEngine::getNumWords(const QString& lexicon) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    QSqlDatabase* db = getDatabase(lexicon);
+    if (db) {
+        QString qstr = "SELECT count(*) FROM words";
+        QSqlQuery query (qstr, *db);
+        if (query.next())
+            return query.value(0).toInt();
+    }
+    else
+        return lexiconData[lexicon]->graph->getNumWords();
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+//  getLexiconFile
+//
+//! Get the text file associated with a lexicon, if applicable.  This is
+//! normally only meaningful for custom lexicons.
+//
+//! @param lexicon the name of the lexicon
+//! @return the lexicon file
+//---------------------------------------------------------------------------
+QString
+WordEngine::getLexiconFile(const QString& lexicon) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return QString();
+
+    return lexiconData[lexicon]->lexiconFile;
+}
+
+//---------------------------------------------------------------------------
+//  getLexiconBuild
+//
+//! Get a number identifying the build of the word graph of a lexicon, which
+//! word IDs belong to.
+//
+//! @param lexicon the name of the lexicon
+//! @return the build, or zero if the lexicon is not loaded
+//---------------------------------------------------------------------------
+quint64
+WordEngine::getLexiconBuild(const QString& lexicon) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    const WordGraph* graph = lexiconData[lexicon]->graph;
+    return graph ? graph->getFingerprint() : 0;
+}
+
+//---------------------------------------------------------------------------
+//  getWordIds
+//
+//! Get the IDs of words in a lexicon: their indexes in the alphabetical
+//! list of words of its word graph.
+//
+//! @param lexicon the name of the lexicon
+//! @param words the words
+//! @return the ID of each word, or -1 for words that are not acceptable
+//---------------------------------------------------------------------------
+QVector<qint32>
+WordEngine::getWordIds(const QString& lexicon, const QStringList& words)
+    const
+{
+    QReadLocker locker (&lexiconLock);
+
+    QVector<qint32> ids (words.size(), -1);
+    if (!lexiconData.contains(lexicon))
+        return ids;
+
+    const WordGraph* graph = lexiconData[lexicon]->graph;
+    if (!graph || !graph->hasWordCounts())
+        return ids;
+
+    for (int i = 0; i < words.size(); ++i)
+        ids[i] = graph->indexOf(words[i].toUpper());
+    return ids;
+}
+
+//---------------------------------------------------------------------------
+//  searchIds
+//
+//! Search for acceptable words matching a search specification, returning
+//! the IDs of the words instead of the words, so results can be combined
+//! with the ID array operations of WordIdList and only turned into words
+//! when they are shown or saved.
+//
+//! @param lexicon the name of the lexicon
+//! @param spec the search specification
+//! @return the IDs of the acceptable words, in ascending order
+//---------------------------------------------------------------------------
+QVector<qint32>
+WordEngine::searchIds(const QString& lexicon, const SearchSpec& spec) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    QVector<qint32> ids;
+    if (!lexiconData.contains(lexicon))
+        return ids;
+
+    const WordGraph* graph = lexiconData[lexicon]->graph;
+    if (!graph || !graph->hasWordCounts())
+        return ids;
+
+    WordIdVisitor visitor (graph, &ids);
+    search(lexicon, spec, true, &visitor);
+    WordIdList::normalize(&ids);
+    return ids;
+}
+
+//---------------------------------------------------------------------------
+//  getWordById
+//
+//! Get the word with an ID in a lexicon.
+//
+//! @param lexicon the name of the lexicon
+//! @param id the ID of the word
+//! @return the word, or an empty string if the ID is not valid
+//---------------------------------------------------------------------------
+QString
+WordEngine::getWordById(const QString& lexicon, qint32 id) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return QString();
+
+    const WordGraph* graph = lexiconData[lexicon]->graph;
+    if (!graph || !graph->hasWordCounts() || (id < 0) ||
+        (id >= graph->getNumWords()))
+    {
+        return QString();
+    }
+    return graph->wordAt(id);
+}
+
+//---------------------------------------------------------------------------
+//  getWordsById
+//
+//! Get the words with IDs in a lexicon.
+//
+//! @param lexicon the name of the lexicon
+//! @param ids the IDs of the words
+//! @return the words, in the order of the IDs, leaving out IDs that are not
+//! valid
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::getWordsById(const QString& lexicon, const QVector<qint32>& ids)
+    const
+{
+    QReadLocker locker (&lexiconLock);
+
+    QStringList words;
+    if (!lexiconData.contains(lexicon))
+        return words;
+
+    const WordGraph* graph = lexiconData[lexicon]->graph;
+    if (!graph || !graph->hasWordCounts())
+        return words;
+
+    int numWords = graph->getNumWords();
+    foreach (qint32 id, ids) {
+        if ((id >= 0) && (id < numWords))
+            words.append(graph->wordAt(id));
+    }
+    return words;
+}
+
+//---------------------------------------------------------------------------
+//  CompletionLessThan
+//
+//! Orders word IDs for completions: higher playability values first, then
+//! alphabetically.
+//---------------------------------------------------------------------------
+class CompletionLessThan
+{
+    public:
+    CompletionLessThan(const qint64* p) : playability(p) { }
+    bool operator()(qint32 a, qint32 b) const {
+        if (playability[a] != playability[b])
+            return (playability[a] > playability[b]);
+        return (a < b);
+    }
+
+    private:
+    const qint64* playability;
+};
+
+//---------------------------------------------------------------------------
+//  getCompletions
+//
+//! Get the most playable words of a lexicon that begin with a prefix, for
+//! completing words as they are typed.  The words beginning with a prefix
+//! have consecutive IDs, so their range is found from the word counts of
+//! the word graph, and the best words of the range are kept in a bounded
+//! heap while their playability values are scanned.  Without playability
+//! values the first words in alphabetical order are found instead.
+//
+//! @param lexicon the name of the lexicon
+//! @param prefix the prefix
+//! @param maxWords the maximum number of words to find
+//! @return the words, most playable first
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::getCompletions(const QString& lexicon, const QString& prefix, int
+                           maxWords) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon) || prefix.isEmpty() || (maxWords <= 0))
+        return QStringList();
+
+    LexiconData* data = lexiconData[lexicon];
+    const WordGraph* graph = data->graph;
+    if (!graph)
+        return QStringList();
+
+    QString upper = prefix.toUpper();
+    const QVector<qint64>& playability = data->attributes.playability;
+    int first = 0;
+    int count = 0;
+    if (playability.isEmpty() || !graph->hasWordCounts() ||
+        !graph->getPrefixRange(upper, &first, &count) ||
+        (first + count > playability.size()))
+    {
+        return graph->getPrefixWords(upper, maxWords);
+    }
+
+    // The front of the heap is the worst word kept so far
+    CompletionLessThan lessThan (playability.constData());
+    std::vector<qint32> heap;
+    heap.reserve(qMin(count, maxWords));
+    for (qint32 id = first; id < first + count; ++id) {
+        if (int(heap.size()) < maxWords) {
+            heap.push_back(id);
+            std::push_heap(heap.begin(), heap.end(), lessThan);
+        }
+        else if (lessThan(id, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), lessThan);
+            heap.back() = id;
+            std::push_heap(heap.begin(), heap.end(), lessThan);
+        }
+    }
+    std::sort_heap(heap.begin(), heap.end(), lessThan);
+
+    QStringList words;
+    for (size_t i = 0; i < heap.size(); ++i)
+        words.append(graph->wordAt(heap[i]));
+    return words;
+}
+
+//---------------------------------------------------------------------------
+//  getDefinition
+//
+//! Return the definition associated with a word, keeping the processed
+//! definition in the definition cache.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word whose definition to look up
+//! @param replaceLinks whether to resolve links to other definitions
+//! @return the definition, or empty String if no definition
+//---------------------------------------------------------------------------
+QString
+WordEngine::getDefinition(const QString& lexicon, const QString& word,
+                          bool replaceLinks) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return QString();
+
+    DefinitionCache& definitionCache = lexiconData[lexicon]->definitionCache;
+    QString definition;
+    if (definitionCache.find(word, replaceLinks, &definition))
+        return definition;
+
+    WordInfo info = getWordInfo(lexicon, word);
+    //qDebug("WordEngine::getDefinition: lexicon: |%s|, word: |%s|",
+    //       lexicon.toUtf8().constData(), word.toUtf8().constData());
+    //qDebug("info.isValid: %d, info.word: |%s|, "
+    //       "info.numVowels: %d, info.numUniqueLetters: %d, "
+    //       "info.numAnagrams: %d, info.pointValue: %d, "
+    //       "info.frontHooks: |%s|, info.backHooks: |%s|, "
+    //       "info.isFrontHook: %d, info.isBackHook: %d, "
+    //       "info.lexiconSymbols: |%s|, info.definition: |%s|",
+    //       info.isValid(), info.word.toUtf8().constData(),
+    //       info.numVowels, info.numUniqueLetters, info.numAnagrams,
+    //       info.pointValue, info.frontHooks.toUtf8().constData(),
+    //       info.backHooks.toUtf8().constData(), info.isFrontHook,
+    //       info.isBackHook, info.lexiconSymbols.toUtf8().constData(),
+    //       info.definition.toUtf8().constData());
+    //QMapIterator<int, ProbabilityOrder> it (info.blankProbability);
+    //while (it.hasNext()) {
+    //    it.next();
+    //    int numBlanks = it.key();
+    //    const ProbabilityOrder& probOrder = it.value();
+    //    qDebug("numBlanks: %d, prob order: %d, min prob order: %d, "
+    //           "max prob order: %d", numBlanks, probOrder.probabilityOrder,
+    //           probOrder.minProbabilityOrder, probOrder.maxProbabilityOrder);
+    //}
+
+    if (info.isValid()) {
+        if (replaceLinks) {
+            QStringList defs = info.definition.split(DEF_ORIG_SEP);
+            foreach (const QString& def, defs) {
+                if (!definition.isEmpty())
+                    definition += DEF_DISPLAY_SEP;
+                definition += def;
+            }
+        }
+        else {
+            definition = info.definition;
+        }
+        definitionCache.insert(word, replaceLinks, definition);
+        return definition;
+    }
+
+    else {
+        QStringList defs = getFileDefinitions(lexiconData[lexicon], word);
+        if (defs.isEmpty())
+            return QString();
+
+        definition = defs.join(replaceLinks ? DEF_DISPLAY_SEP
+                                            : DEF_ORIG_SEP);
+        definitionCache.insert(word, replaceLinks, definition);
+        return definition;
+    }
+}
+
+//---------------------------------------------------------------------------
+//  getFrontHookLetters
+//
+//! Get a string of letters that can be added to the front of a word to make
+//! other valid words.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word, assumed to be upper case
+//! @return a string containing lower case letters representing front hooks
+//---------------------------------------------------------------------------
+QString
+WordEngine::getFrontHookLetters(const QString& lexicon, const QString& word)
+    const
+{
+    QReadLocker locker (&lexiconLock);
+
+    QString ret;
+
+    WordInfo info = getWordInfo(lexicon, word);
+    if (info.isValid()) {
+        ret = info.frontHooks;
+    }
+
+    else {
+        quint32 frontHooks = 0;
+        quint32 backHooks = 0;
+        getHooks(lexicon, word.toUpper(), &frontHooks, &backHooks);
+        for (int i = 0; i < 26; ++i) {
+            if (frontHooks & (1 << i))
+                ret += QChar('a' + i);
+        }
+    }
+
+    return ret;
+}
+
+//---------------------------------------------------------------------------
+//  getBackHookLetters
+//
+//! Get a string of letters that can be added to the back of a word to make
+//! other valid words.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word, assumed to be upper case
+//! @return a string containing lower case letters representing back hooks
+//---------------------------------------------------------------------------
+QString
+WordEngine::getBackHookLetters(const QString& lexicon, const QString& word) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    QString ret;
+
+    WordInfo info = getWordInfo(lexicon, word);
+    if (info.isValid()) {
+        ret = info.backHooks;
+    }
+
+    else {
+        quint32 frontHooks = 0;
+        quint32 backHooks = 0;
+        getHooks(lexicon, word.toUpper(), &frontHooks, &backHooks);
+        for (int i = 0; i < 26; ++i) {
+            if (backHooks & (1 << i))
+                ret += QChar('a' + i);
+        }
+    }
+
+    return ret;
+}
+
+//---------------------------------------------------------------------------
+//  addToCache
+//
+//! Add information about a list of words to the cache.
+//
+//! @param lexicon the name of the lexicon
+//! @param words the list of words
+//---------------------------------------------------------------------------
+void
+WordEngine::addToCache(const QString& lexicon, const QStringList& words) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (words.isEmpty() || !lexiconData.contains(lexicon))
+        return;
+
+    LexiconData* lexData = lexiconData[lexicon];
+    const LexiconSnapshot* snapshot = lexData->snapshot;
+
+    // Throw out words that are already in the cache, and read words from
+    // the snapshot if possible
+    QStringList needWords;
+    foreach (const QString& word, words) {
+        if (lexData->wordCache.contains(word))
+            continue;
+        if (snapshot) {
+            QString wordUpper = word.toUpper();
+            int id = getWordId(lexicon, wordUpper);
+            if ((id >= 0) && (snapshot->getString(
+                    LexiconSnapshot::WordColumn, id) == wordUpper))
+            {
+                lexData->wordCache.insert(getSnapshotWordInfo(snapshot, id));
+                continue;
+            }
+        }
+        needWords.append(word);
+    }
+    if (needWords.isEmpty())
+        return;
+
+    DatabaseConnection* connection = getConnection(lexData);
+    if (!connection)
+        return;
+
+    // Look the words up in chunks with the same prepared statement, padding
+    // the last chunk with null values that match no words
+    int numWords = needWords.size();
+    for (int start = 0; start < numWords; start += CACHE_QUERY_CHUNK_SIZE) {
+        int chunkWords = qMin(numWords - start, CACHE_QUERY_CHUNK_SIZE);
+        QSqlQuery* query = getCacheQuery(connection, chunkWords > 1);
+        if (!query)
+            return;
+
+        int numPlaceholders = (chunkWords > 1) ? CACHE_QUERY_CHUNK_SIZE : 1;
+        for (int i = 0; i < numPlaceholders; ++i) {
+            query->bindValue(i, (i < chunkWords)
+                             ? QVariant(needWords[start + i].toUpper())
+                             : QVariant(QVariant::String));
+        }
+        query->exec();
+        while (query->next()) {
+            WordInfo info = getQueryWordInfo(*query);
+            lexData->wordCache.insert(info);
+        }
+        query->finish();
+    }
+}
+
+//---------------------------------------------------------------------------
+//  getQueryWordInfo
+//
+//! Get information about a word from the current row of a word cache query.
+//
+//! @param query the query
+//! @return the information
+//---------------------------------------------------------------------------
+WordEngine::WordInfo
+WordEngine::getQueryWordInfo(const QSqlQuery& query) const
+{
+    int placeNum = 0;
+    WordInfo info;
+    info.word                 = query.value(placeNum++).toString();
+    info.numVowels            = query.value(placeNum++).toInt();
+    info.numUniqueLetters     = query.value(placeNum++).toInt();
+    info.numAnagrams          = query.value(placeNum++).toInt();
+    info.pointValue           = query.value(placeNum++).toInt();
+    info.frontHooks           = query.value(placeNum++).toString();
+    info.backHooks            = query.value(placeNum++).toString();
+    info.isFrontHook          = query.value(placeNum++).toBool();
+    info.isBackHook           = query.value(placeNum++).toBool();
+    info.lexiconSymbols       = query.value(placeNum++).toString();
+    info.definition           = query.value(placeNum++).toString();
+    info.playability          = query.value(placeNum++).toLongLong();
+
+    ValueOrder playOrder;
+    playOrder.valueOrder    = query.value(placeNum++).toInt();
+    playOrder.minValueOrder = query.value(placeNum++).toInt();
+    playOrder.maxValueOrder = query.value(placeNum++).toInt();
+    info.playabilityOrder = playOrder;
+
+    for (int numBlanks = 0; numBlanks <= 2; ++numBlanks) {
+        ValueOrder probOrder;
+        probOrder.valueOrder    = query.value(placeNum++).toInt();
+        probOrder.minValueOrder = query.value(placeNum++).toInt();
+        probOrder.maxValueOrder = query.value(placeNum++).toInt();
+        info.blankProbabilityOrder[numBlanks] = probOrder;
+    }
+
+    return info;
+}
+
+//---------------------------------------------------------------------------
+//  getSnapshotWordInfo
+//
+//! Get information about a word from a database snapshot.
+//
+//! @param snapshot the snapshot
+//! @param id the alphabetical index of the word
+//! @return the information
+//---------------------------------------------------------------------------
+WordEngine::WordInfo
+WordEngine::getSnapshotWordInfo(const LexiconSnapshot* snapshot, int id)
+    const
+{
+    WordInfo info;
+    info.word = snapshot->getString(LexiconSnapshot::WordColumn, id);
+    info.numVowels = snapshot->getByteColumn(
+        LexiconSnapshot::NumVowelsColumn)[id];
+    info.numUniqueLetters = snapshot->getByteColumn(
+        LexiconSnapshot::NumUniqueLettersColumn)[id];
+    info.numAnagrams = snapshot->getByteColumn(
+        LexiconSnapshot::NumAnagramsColumn)[id];
+    info.pointValue = snapshot->getByteColumn(
+        LexiconSnapshot::PointValueColumn)[id];
+    info.frontHooks = snapshot->getString(
+        LexiconSnapshot::FrontHooksColumn, id);
+    info.backHooks = snapshot->getString(
+        LexiconSnapshot::BackHooksColumn, id);
+
+    quint8 flags = snapshot->getByteColumn(LexiconSnapshot::FlagsColumn)[id];
+    info.isFrontHook = flags & LexiconSnapshot::FrontHookFlag;
+    info.isBackHook = flags & LexiconSnapshot::BackHookFlag;
+
+    info.lexiconSymbols = snapshot->getString(
+        LexiconSnapshot::LexiconSymbolsColumn, id);
+    info.definition = snapshot->getString(
+        LexiconSnapshot::DefinitionColumn, id);
+    info.playability = snapshot->getPlayability()[id];
+
+    const qint32* playOrders = snapshot->getPlayabilityOrders() + 3 * id;
+    ValueOrder playOrder;
+    playOrder.valueOrder    = playOrders[0];
+    playOrder.minValueOrder = playOrders[1];
+    playOrder.maxValueOrder = playOrders[2];
+    info.playabilityOrder = playOrder;
+
+    const qint32* probOrders = snapshot->getProbabilityOrders() + 9 * id;
+    for (int numBlanks = 0; numBlanks <= 2; ++numBlanks) {
+        ValueOrder probOrder;
+        probOrder.valueOrder    = probOrders[3 * numBlanks];
+        probOrder.minValueOrder = probOrders[3 * numBlanks + 1];
+        probOrder.maxValueOrder = probOrders[3 * numBlanks + 2];
+        info.blankProbabilityOrder[numBlanks] = probOrder;
+    }
+
+    return info;
+}
+
+//---------------------------------------------------------------------------
+//  getConnection
+//
+//! Get the database connection of a lexicon for the current thread.  The
+//! thread that connected to the database uses that connection, and other
+//! threads use connections cloned from it the first time they need one.
+//
+//! @param data the lexicon data
+//! @return the connection, or 0 if the database is not connected or cannot
+//! be opened from the current thread
+//---------------------------------------------------------------------------
+WordEngine::DatabaseConnection*
+WordEngine::getConnection(LexiconData* data) const
+{
+    if (!data->db || !data->db->isOpen())
+        return 0;
+
+    Qt::HANDLE thread = QThread::currentThreadId();
+    QMutexLocker locker (&data->connectionMutex);
+    DatabaseConnection* connection = data->connections.value(thread);
+    if (connection)
+        return connection;
+
+    connection = new DatabaseConnection;
+    if (thread == data->dbThread) {
+        connection->db = data->db;
+        connection->name = data->dbConnectionName;
+    }
+    else {
+        QString name = data->dbConnectionName + "_" +
+            QString::number(quintptr(thread));
+        QSqlDatabase* db = new QSqlDatabase(
+            QSqlDatabase::cloneDatabase(*data->db, name));
+        if (!db->open()) {
+            delete db;
+            QSqlDatabase::removeDatabase(name);
+            delete connection;
+            return 0;
+        }
+        setReadPragmas(*db);
+        connection->db = db;
+        connection->name = name;
+        connection->cloned = true;
+    }
+
+    data->connections.insert(thread, connection);
+    return connection;
+}
+
+//---------------------------------------------------------------------------
+//  getDatabase
+//
+//! Get the database of a lexicon for the current thread.
+//
+//! @param lexicon the name of the lexicon
+//! @return the database, or 0 if the database is not connected
+//---------------------------------------------------------------------------
+QSqlDatabase*
+WordEngine::getDatabase(const QString& lexicon) const
+{
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    DatabaseConnection* connection = getConnection(lexiconData[lexicon]);
+    return connection ? connection->db : 0;
+}
+
+//---------------------------------------------------------------------------
+//  closeConnections
+//
+//! Close the database connections of a lexicon used by each thread, and
+//! free their prepared statements.  The connection opened by
+//! connectToDatabase is left open.
+//
+//! @param data the lexicon data
+//---------------------------------------------------------------------------
+void
+WordEngine::closeConnections(LexiconData* data)
+{
+    QMutexLocker locker (&data->connectionMutex);
+    foreach (DatabaseConnection* connection, data->connections) {
+        delete connection->cacheWordQuery;
+        delete connection->cacheChunkQuery;
+        delete connection->playabilityQuery;
+        if (connection->cloned) {
+            delete connection->db;
+            QSqlDatabase::removeDatabase(connection->name);
+        }
+        delete connection;
+    }
+    data->connections.clear();
+}
+
+//---------------------------------------------------------------------------
+//  getCacheQuery
+//
+//! Get the prepared statement used to look up words for the word cache
+//! through a database connection, preparing it the first time it is used.
+//
+//! @param connection the database connection
+//! @param chunk whether to get the statement looking up a chunk of words
+//! instead of a single word
+//! @return the prepared statement, or 0 if it cannot be prepared
+//---------------------------------------------------------------------------
+QSqlQuery*
+WordEngine::getCacheQuery(DatabaseConnection* connection, bool chunk) const
+{
+    QSqlQuery*& query = chunk ? connection->cacheChunkQuery
+                              : connection->cacheWordQuery;
+    if (query)
+        return query;
+
+    QString qstr = "SELECT word, num_vowels, "
+        "num_unique_letters, num_anagrams, point_value, "
+        "front_hooks, back_hooks, is_front_hook, "
+        "is_back_hook, lexicon_symbols, definition, playability, "
+        "playability_order, min_playability_order, max_playability_order, "
+        "probability_order0, min_probability_order0, max_probability_order0, "
+        "probability_order1, min_probability_order1, max_probability_order1, "
+        "probability_order2, min_probability_order2, max_probability_order2 "
+        "FROM words WHERE words.word";
+
+    if (chunk) {
+        qstr += " IN (?";
+        for (int i = 1; i < CACHE_QUERY_CHUNK_SIZE; ++i)
+            qstr += ", ?";
+        qstr += ")";
+    }
+    else
+        qstr += "=?";
+
+    query = new QSqlQuery(*connection->db);
+    query->setForwardOnly(true);
+    if (!query->prepare(qstr)) {
+        delete query;
+        query = 0;
+    }
+    return query;
+}
+
+//---------------------------------------------------------------------------
+//  getPlayabilityQuery
+//
+//! Get the prepared statement used to look up the playability values of a
+//! chunk of words through a database connection, preparing it the first
+//! time it is used.
+//
+//! @param connection the database connection
+//! @return the prepared statement, or 0 if it cannot be prepared
+//---------------------------------------------------------------------------
+QSqlQuery*
+WordEngine::getPlayabilityQuery(DatabaseConnection* connection) const
+{
+    QSqlQuery*& query = connection->playabilityQuery;
+    if (query)
+        return query;
+
+    QString qstr = "SELECT word, playability FROM words WHERE word IN (?";
+    for (int i = 1; i < CACHE_QUERY_CHUNK_SIZE; ++i)
+        qstr += ", ?";
+    qstr += ")";
+
+    query = new QSqlQuery(*connection->db);
+    query->setForwardOnly(true);
+    if (!query->prepare(qstr)) {
+        delete query;
+        query = 0;
+    }
+    return query;
+}
+
+//---------------------------------------------------------------------------
+//  getWordCache
+//
+//! Get the word information cache for a lexicon, so its size and hit, miss
+//! and eviction counts can be inspected.
+//
+//! @param lexicon the name of the lexicon
+//! @return the cache, or 0 if the lexicon is not loaded
+//---------------------------------------------------------------------------
+const WordEngine::WordInfoCache*
+WordEngine::getWordCache(const QString& lexicon) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    return &lexiconData[lexicon]->wordCache;
+}
+
+//---------------------------------------------------------------------------
+//  getSearchCache
+//
+//! Get the search result cache for a lexicon, so its size and hit, miss and
+//! eviction counts can be inspected.
+//
+//! @param lexicon the name of the lexicon
+//! @return the cache, or 0 if the lexicon is not loaded
+//---------------------------------------------------------------------------
+const WordEngine::SearchResultCache*
+WordEngine::getSearchCache(const QString& lexicon) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    return &lexiconData[lexicon]->searchCache;
+}
+
+//---------------------------------------------------------------------------
+//  memoryReport
+//
+//! Estimate the memory used by each structure of each loaded lexicon, so
+//! the largest structures can be found.  The sizes of containers are
+//! estimates from their contents and capacities, and ignore the overhead
+//! of the memory allocator.
+//
+//! @return the estimated memory used by each structure, keyed by lexicon
+//---------------------------------------------------------------------------
+QMap<QString, QList<WordEngine::MemoryUsage> >
+WordEngine::memoryReport() const
+{
+    QReadLocker locker (&lexiconLock);
+
+    QMap<QString, QList<MemoryUsage> > report;
+    QMapIterator<QString, LexiconData*> it (lexiconData);
+    while (it.hasNext()) {
+        it.next();
+        LexiconData* data = it.value();
+        QList<MemoryUsage>& usage = report[it.key()];
+
+        if (data->graph)
+            data->graph->getMemoryUsage(&usage);
+
+        if (data->snapshot && data->snapshot->isOpen()) {
+            usage.append(MemoryUsage("Database snapshot",
+                                     data->snapshot->getNumBytes(), true));
+        }
+
+        qint64 bytes = 0;
+        QHashIterator<CompactWord, qint64> dit (data->definitionOffsets);
+        while (dit.hasNext()) {
+            dit.next();
+            bytes += NODE_BYTES + getWordBytes(dit.key());
+        }
+        addMemoryUsage(&usage, "Definition offsets", bytes);
+
+        bytes = 0;
+        QMapIterator<int, QList<CompactWord> > sit (data->stems);
+        while (sit.hasNext()) {
+            sit.next();
+            bytes += NODE_BYTES + CONTAINER_BYTES;
+            foreach (const CompactWord& stem, sit.value())
+                bytes += sizeof(void*) + getWordBytes(stem);
+        }
+        addMemoryUsage(&usage, "Stems", bytes);
+
+        bytes = 0;
+        QMapIterator<int, QSet<CompactWord> > ait (data->stemAlphagrams);
+        while (ait.hasNext()) {
+            ait.next();
+            bytes += NODE_BYTES + CONTAINER_BYTES;
+            foreach (const CompactWord& alphagram, ait.value())
+                bytes += NODE_BYTES + getWordBytes(alphagram);
+        }
+        addMemoryUsage(&usage, "Stem alphagrams", bytes);
+
+        bytes = 0;
+        QMapIterator<int, StemIndex> siit (data->stemIndexes);
+        while (siit.hasNext()) {
+            siit.next();
+            bytes += NODE_BYTES + 2 * CONTAINER_BYTES;
+            QHashIterator<QString, QVector<qint32> > swit
+                (siit.value().stemWords);
+            while (swit.hasNext()) {
+                swit.next();
+                bytes += NODE_BYTES + getStringBytes(swit.key()) +
+                    getVectorBytes(swit.value());
+            }
+            bytes += siit.value().wordStems.size() *
+                (NODE_BYTES + CONTAINER_BYTES + sizeof(void*));
+        }
+        addMemoryUsage(&usage, "Stem index", bytes);
+
+        bytes = 0;
+        QHashIterator<CompactWord, int> nit (data->numAnagramsMap);
+        while (nit.hasNext()) {
+            nit.next();
+            bytes += NODE_BYTES + getWordBytes(nit.key());
+        }
+        addMemoryUsage(&usage, "Anagram counts", bytes);
+
+        bytes = 0;
+        QHashIterator<CompactWord, qint64> plit (data->playabilityMap);
+        while (plit.hasNext()) {
+            plit.next();
+            bytes += NODE_BYTES + getWordBytes(plit.key());
+        }
+        addMemoryUsage(&usage, "Playability values", bytes);
+
+        const WordAttributes& attributes = data->attributes;
+        addMemoryUsage(&usage, "Word attributes",
+                       getVectorBytes(attributes.flags) +
+                       getVectorBytes(attributes.numVowels) +
+                       getVectorBytes(attributes.numUniqueLetters) +
+                       getVectorBytes(attributes.numAnagrams) +
+                       getVectorBytes(attributes.pointValue) +
+                       getVectorBytes(attributes.playability) +
+                       getVectorBytes(attributes.playabilityOrders) +
+                       getVectorBytes(attributes.probabilityOrders));
+
+        bytes = getVectorBytes(data->anagramIndex.wordIds);
+        QHashIterator<QString, QPair<qint32, qint32> > git
+            (data->anagramIndex.groups);
+        while (git.hasNext()) {
+            git.next();
+            bytes += NODE_BYTES + getStringBytes(git.key());
+        }
+        addMemoryUsage(&usage, "Anagram index", bytes);
+
+        bytes = 0;
+        {
+            QMutexLocker setLocker (&data->setMemberMutex);
+            foreach (const QBitArray& members, data->setMembers)
+                bytes += NODE_BYTES + CONTAINER_BYTES + members.size() / 8;
+        }
+        addMemoryUsage(&usage, "Search set members", bytes);
+
+        bytes = 0;
+        {
+            QMutexLocker orderLocker (&data->probabilityOrderMutex);
+            QHashIterator<QString, QVector<qint32> > oit
+                (data->probabilityOrders);
+            while (oit.hasNext()) {
+                oit.next();
+                bytes += NODE_BYTES + getStringBytes(oit.key()) +
+                    getVectorBytes(oit.value());
+            }
+        }
+        addMemoryUsage(&usage, "Probability order tables", bytes);
+
+        bytes = 0;
+        {
+            QMutexLocker indexLocker (&data->definitionIndexMutex);
+            QHashIterator<QString, QVector<qint32> > tit
+                (data->definitionIndex.tokenWords);
+            while (tit.hasNext()) {
+                tit.next();
+                bytes += NODE_BYTES + CONTAINER_BYTES +
+                    getStringBytes(tit.key()) + getVectorBytes(tit.value());
+            }
+        }
+        addMemoryUsage(&usage, "Definition index", bytes);
+
+        addMemoryUsage(&usage, "Word cache", data->wordCache.getBytes());
+        addMemoryUsage(&usage, "Search result cache",
+                       data->searchCache.getBytes());
+        addMemoryUsage(&usage, "Definition cache",
+                       data->definitionCache.getBytes());
+        addMemoryUsage(&usage, "Combination cache",
+                       data->combinationCache.getNumEntries() * NODE_BYTES);
+    }
+
+    return report;
+}
+
+//---------------------------------------------------------------------------
+//  getMinOrders
+//
+//! Get the minimum playability or probability order of each of a list of
+//! words.  Orders are read from the word attributes if they are loaded,
+//! otherwise from the word info of the words, which is added to the cache
+//! in one batch.
+//
+//! @param lexicon the name of the lexicon
+//! @param words the words
+//! @param probability whether to get probability orders instead of
+//! playability orders
+//! @param numBlanks the number of blanks to consider for probability
+//! @param distribution the letter distribution to consider for
+//! probability, or empty for the default distribution
+//! @return the minimum order of each word, in the order of the words, or
+//! zero for words with no order
+//---------------------------------------------------------------------------
+QVector<int>
+WordEngine::getMinOrders(const QString& lexicon, const QStringList& words,
+                         bool probability, int numBlanks, const QString&
+                         distribution) const
+{
+    QVector<int> orders (words.size(), 0);
+    if (!lexiconData.contains(lexicon))
+        return orders;
+
+    // Orders not stored in the database are all in the computed table
+    if (probability && !hasStoredProbabilityOrders(numBlanks, distribution)) {
+        const WordGraph* graph = lexiconData[lexicon]->graph;
+        QVector<qint32> table = getProbabilityOrderTable(lexicon, numBlanks,
+                                                         distribution);
+        for (int i = 0; i < words.size(); ++i) {
+            int id = graph ? graph->indexOf(words[i].toUpper()) : -1;
+            if ((id >= 0) && (3 * id < table.size()))
+                orders[i] = table[3 * id + 1];
+        }
+        return orders;
+    }
+
+    const WordAttributes& attributes = lexiconData[lexicon]->attributes;
+
+    QStringList missingWords;
+    QVector<int> missingIndexes;
+    for (int i = 0; i < words.size(); ++i) {
+        int id = getWordId(lexicon, words[i]);
+        if (id < 0) {
+            missingWords.append(words[i]);
+            missingIndexes.append(i);
+        }
+        else if (probability) {
+            orders[i] = attributes.probabilityOrders[9 * id + 3 * numBlanks
+                                                     + 1];
+        }
+        else {
+            orders[i] = attributes.playabilityOrders[3 * id + 1];
+        }
+    }
+
+    if (missingWords.isEmpty())
+        return orders;
+
+    addToCache(lexicon, missingWords);
+    const WordInfoCache& cache = lexiconData[lexicon]->wordCache;
+    for (int i = 0; i < missingWords.size(); ++i) {
+        WordInfo info = cache.value(missingWords[i]);
+        if (!info.isValid())
+            continue;
+        orders[missingIndexes[i]] = probability ?
+            info.blankProbabilityOrder.value(numBlanks).minValueOrder :
+            info.playabilityOrder.minValueOrder;
+    }
+
+    return orders;
+}
+
+//---------------------------------------------------------------------------
+//  getMinOrdersById
+//
+//! Get the minimum playability or probability order of each of a list of
+//! word IDs.  Orders are read directly from the word attributes, which are
+//! indexed by word ID.  Only the words whose attributes are not loaded are
+//! looked up by word.
+//
+//! @param lexicon the name of the lexicon
+//! @param ids the IDs of the words
+//! @param probability whether to get probability orders instead of
+//! playability orders
+//! @param numBlanks the number of blanks to consider for probability
+//! @param distribution the letter distribution to consider for
+//! probability, or empty for the default distribution
+//! @return the minimum order of each word, in the order of the IDs, or zero
+//! for words with no order
+//---------------------------------------------------------------------------
+QVector<int>
+WordEngine::getMinOrdersById(const QString& lexicon, const QVector<qint32>&
+                             ids, bool probability, int numBlanks, const
+                             QString& distribution) const
+{
+    QVector<int> orders (ids.size(), 0);
+    if (!lexiconData.contains(lexicon))
+        return orders;
+
+    const LexiconData* data = lexiconData[lexicon];
+    const WordGraph* graph = data->graph;
+    if (!graph || !graph->hasWordCounts())
+        return orders;
+
+    // Orders not stored in the database are all in the computed table
+    if (probability && !hasStoredProbabilityOrders(numBlanks, distribution)) {
+        QVector<qint32> table = getProbabilityOrderTable(lexicon, numBlanks,
+                                                         distribution);
+        for (int i = 0; i < ids.size(); ++i) {
+            qint32 id = ids[i];
+            if ((id >= 0) && (3 * id < table.size()))
+                orders[i] = table[3 * id + 1];
+        }
+        return orders;
+    }
+
+    const WordAttributes& attributes = data->attributes;
+    int numAttributes = attributes.flags.size();
+    int numWords = graph->getNumWords();
+
+    QStringList missingWords;
+    QVector<int> missingIndexes;
+    for (int i = 0; i < ids.size(); ++i) {
+        qint32 id = ids[i];
+        if ((id < 0) || (id >= numWords))
             continue;
+        if ((id >= numAttributes) ||
+            !(attributes.flags[id] & WordAttributes::ValidFlag))
+        {
+            missingWords.append(graph->wordAt(id));
+            missingIndexes.append(i);
+        }
+        else if (probability) {
+            orders[i] = attributes.probabilityOrders[9 * id + 3 * numBlanks
+                                                     + 1];
+        }
+        else {
+            orders[i] = attributes.playabilityOrders[3 * id + 1];
+        }
+    }
 
-        if (foundCondition)
-            whereStr += " AND";
-        foundCondition = true;
-        whereStr += " (";
+    if (missingWords.isEmpty())
+        return orders;
 
-        switch (condition.type) {
-            case SearchCondition::PatternMatch: {
-                tables.insert("words");
-                QString str =
-                    condition.stringValue.replace("?", "_").replace("*", "%");
-                whereStr += " words.word";
-                if (condition.negated)
-                    whereStr += " NOT";
-                whereStr += " LIKE '" + str + "'";
+    QVector<int> missingOrders = getMinOrders(lexicon, missingWords,
+                                              probability, numBlanks);
+    for (int i = 0; i < missingIndexes.size(); ++i)
+        orders[missingIndexes[i]] = missingOrders[i];
+    return orders;
+}
+
+//---------------------------------------------------------------------------
+//  hasStoredProbabilityOrders
+//
+//! Determine whether the probability orders of a letter distribution and
+//! number of blanks are stored in the database.  Only the orders of the
+//! default distribution with up to MAX_STORED_BLANKS blanks are stored.
+//
+//! @param numBlanks the number of blanks
+//! @param distribution the letter distribution, or empty for the default
+//! distribution
+//! @return true if the orders are stored, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::hasStoredProbabilityOrders(int numBlanks, const QString&
+                                       distribution)
+{
+    return (numBlanks >= 0) && (numBlanks <= MAX_STORED_BLANKS) &&
+        (distribution.isEmpty() ||
+         (distribution == MainSettings::getLetterDistribution()));
+}
+
+//---------------------------------------------------------------------------
+//  ProbabilityOrderJob
+//
+//! A job that orders the words of lengths taken in turn from a shared list
+//! by probability, until none are left, as CreateDatabaseThread orders
+//! them for the database: by decreasing number of combinations, then by
+//! alphagram, then alphabetically.  Words with the same number of
+//! combinations share their minimum and maximum orders.  The thread that
+//! submits the jobs can take part by calling orderAll.
+//---------------------------------------------------------------------------
+class WordEngine::ProbabilityOrderJob : public Job
+{
+    public:
+    ProbabilityOrderJob(const LetterBag* b, int nb, const
+                        QList<QStringList>* w, const QList<QVector<qint32> >*
+                        i, qint32* o, int* n, QMutex* m)
+        : Job(), bag(b), numBlanks(nb), words(w), ids(i), orders(o),
+          nextLength(n), mutex(m) { }
+    ~ProbabilityOrderJob() { }
+
+    void orderAll() {
+        forever {
+            int i;
+            {
+                QMutexLocker locker (mutex);
+                i = (*nextLength)++;
             }
-            break;
+            if (i >= words->size())
+                break;
+            orderLength(words->at(i), ids->at(i));
+        }
+    }
 
-            case SearchCondition::PartOfSpeech:
-            case SearchCondition::Definition: {
-                tables.insert("words");
+    protected:
+    void run() { orderAll(); }
+
+    private:
+    void orderLength(const QStringList& lengthWords, const QVector<qint32>&
+                     lengthIds) {
+        QVector<double> combinations;
+        bag->getNumCombinations(lengthWords, numBlanks, &combinations);
+
+        int numWords = lengthWords.size();
+        QVector<LimitKey> keys (numWords);
+        for (int i = 0; i < numWords; ++i) {
+            keys[i] = LimitKey(qint64(combinations[i]),
+                               Auxil::getAlphagram(lengthWords[i]),
+                               lengthWords[i], i);
+        }
+        qSort(keys);
+
+        for (int start = 0; start < numWords; ) {
+            int end = start + 1;
+            while ((end < numWords) && (keys[end].value == keys[start].value))
+                ++end;
+            for (int i = start; i < end; ++i) {
+                qint32* order = orders + 3 * lengthIds[keys[i].index];
+                order[0] = i + 1;
+                order[1] = start + 1;
+                order[2] = end;
+            }
+            start = end;
+        }
+    }
 
-                // Escape % and _ characters when preceded by an even number
-                // of backslashes
-                QString str = condition.stringValue.replace(
-                    QRegExp("((?:\\\\\\\\)*)([%%_'\\\\])"), "\\1\\\\2");
+    private:
+    const LetterBag* bag;
+    int numBlanks;
+    const QList<QStringList>* words;
+    const QList<QVector<qint32> >* ids;
+    qint32* orders;
+    int* nextLength;
+    QMutex* mutex;
+};
 
-                // ### replace * with % and ? with _ for more flexible search
-                // tricky to get right
+//---------------------------------------------------------------------------
+//  getProbabilityOrderTable
+//
+//! Get the probability orders of every word of a lexicon for a letter
+//! distribution and number of blanks, in groups of three indexed by the
+//! alphabetical index of each word as in WordAttributes.  The orders are
+//! computed the first time they are needed and kept for the lexicon, with
+//! the words of each length ordered in parallel.
+//
+//! @param lexicon the name of the lexicon
+//! @param numBlanks the number of blanks
+//! @param distribution the letter distribution, or empty for the default
+//! distribution
+//! @return the orders, or an empty vector if the word graph has no word
+//! counts or the number of blanks is out of range
+//---------------------------------------------------------------------------
+QVector<qint32>
+WordEngine::getProbabilityOrderTable(const QString& lexicon, int numBlanks,
+                                     const QString& distribution) const
+{
+    LexiconData* data = lexiconData.value(lexicon);
+    const WordGraph* graph = data ? data->graph : 0;
+    if (!graph || !graph->hasWordCounts() || (numBlanks < 0) ||
+        (numBlanks > MAX_BLANKS))
+    {
+        return QVector<qint32>();
+    }
 
-                str.replace("'", "''");
-                str.replace(";", "\\;");
+    // The default distribution is keyed by its letters, so the orders are
+    // computed again if it is changed
+    QString bagDistribution = distribution.isEmpty() ?
+        MainSettings::getLetterDistribution() : distribution;
+    QString key = QString::number(numBlanks) + ":" + bagDistribution;
+
+    QMutexLocker locker (&data->probabilityOrderMutex);
+    QHash<QString, QVector<qint32> >::const_iterator it =
+        data->probabilityOrders.constFind(key);
+    if (it != data->probabilityOrders.constEnd())
+        return *it;
+
+    Z_TRACE_SCOPE("WordEngine::getProbabilityOrderTable");
+
+    // Group the words by length, largest groups first so the jobs finish
+    // at about the same time
+    int numWords = graph->getNumWords();
+    QVector<QStringList> wordsByLength (MAX_WORD_LEN + 1);
+    QVector<QVector<qint32> > idsByLength (MAX_WORD_LEN + 1);
+    for (int id = 0; id < numWords; ++id) {
+        QString word = graph->wordAt(id);
+        int length = word.length();
+        if ((length < 1) || (length > MAX_WORD_LEN))
+            continue;
+        wordsByLength[length].append(word);
+        idsByLength[length].append(id);
+    }
 
-                QString notStr;
-                QString conjStr = " OR";
-                if (condition.negated) {
-                    conjStr = " AND";
-                    notStr = " NOT";
-                }
+    QMap<int, int> lengthsBySize;
+    for (int length = 1; length <= MAX_WORD_LEN; ++length) {
+        if (!wordsByLength[length].isEmpty())
+            lengthsBySize.insertMulti(-wordsByLength[length].size(), length);
+    }
+    QList<QStringList> lengthWords;
+    QList<QVector<qint32> > lengthIds;
+    foreach (int length, lengthsBySize) {
+        lengthWords.append(wordsByLength[length]);
+        lengthIds.append(idsByLength[length]);
+    }
 
-                QString whereSecondStr;
-                if (condition.type == SearchCondition::PartOfSpeech) {
-                    whereSecondStr = conjStr +
-                        " words.definition" + notStr +
-                        " LIKE '\%[" + str + "]\%' ESCAPE '\\'";
-                    str = "[" + str + " ";
-                }
+    QVector<qint32> orders (3 * numWords, 0);
+    LetterBag bag (bagDistribution);
+    int nextLength = 0;
+    QMutex mutex;
+    int numThreads = qMin(MainSettings::getSearchNumThreads(),
+                          lengthWords.size());
+    ProbabilityOrderJob job (&bag, numBlanks, &lengthWords, &lengthIds,
+                             orders.data(), &nextLength, &mutex);
+    QList<JobPointer> jobs;
+    for (int i = 1; i < numThreads; ++i) {
+        jobs.append(JobScheduler::getInstance()->submit(
+            new ProbabilityOrderJob(&bag, numBlanks, &lengthWords,
+                                    &lengthIds, orders.data(), &nextLength,
+                                    &mutex),
+            JobScheduler::InteractivePriority));
+    }
+    job.orderAll();
 
-                whereStr +=
-                    " words.definition" + notStr +
-                    " LIKE '\%" + str + "\%' ESCAPE '\\'" + whereSecondStr;
-            }
-            break;
+    // Jobs that have not started by now have no lengths left to order
+    foreach (const JobPointer& otherJob, jobs) {
+        otherJob->cancel();
+        otherJob->wait();
+    }
 
-            case SearchCondition::ProbabilityOrder:
-            case SearchCondition::PlayabilityOrder: {
-                tables.insert("words");
-                QString col;
-                if (condition.type == SearchCondition::ProbabilityOrder) {
-                    col = QString("probability_order%1").arg(
-                        condition.intValue);
-                }
-                else if (condition.type == SearchCondition::PlayabilityOrder) {
-                    col = "playability_order";
-                }
+    data->probabilityOrders.insert(key, orders);
+    return orders;
+}
 
-                // Lax boundaries
-                if (condition.boolValue) {
-                    whereStr += QString(" words.max_%1>=").arg(col) +
-                        QString::number(condition.minValue) +
-                        QString(" AND words.min_%1<=").arg(col) +
-                        QString::number(condition.maxValue);
-                }
-                // Strict boundaries
-                else {
-                    whereStr += QString(" words.%1").arg(col);
-                    if (condition.minValue == condition.maxValue) {
-                        whereStr += "=" + QString::number(condition.minValue);
-                    }
-                    else {
-                        whereStr += ">=" +
-                            QString::number(condition.minValue) +
-                            QString(" AND words.%1<=").arg(col) +
-                            QString::number(condition.maxValue);
-                    }
-                }
+//---------------------------------------------------------------------------
+//  getCachedCombinations
+//
+//! Get the number of ways of drawing each of a list of words from a full
+//! bag of letters, from the combination cache of a lexicon if possible.
+//! Numbers that are not cached are calculated and added to the cache.
+//
+//! @param lexicon the name of the lexicon
+//! @param words the words
+//! @param numBlanks the number of blanks
+//! @param combinations returns the number of combinations of each word, in
+//! the order of the words
+//---------------------------------------------------------------------------
+void
+WordEngine::getCachedCombinations(const QString& lexicon, const QStringList&
+                                  words, int numBlanks, QVector<double>*
+                                  combinations) const
+{
+    combinations->fill(0.0, words.size());
+    LexiconData* data = lexiconData.value(lexicon);
+
+    QStringList missingWords;
+    QVector<int> missingIndexes;
+    QVector<quint64> missingKeys;
+    for (int i = 0; i < words.size(); ++i) {
+        quint64 alphagramKey = 0;
+        if (data) {
+            alphagramKey = Auxil::getAlphagramKey(words[i]);
+            if (CombinationCache::canCache(alphagramKey, numBlanks) &&
+                data->combinationCache.find(alphagramKey, numBlanks,
+                                            &(*combinations)[i]))
+            {
+                continue;
             }
-            break;
+        }
+        missingWords.append(words[i]);
+        missingIndexes.append(i);
+        missingKeys.append(alphagramKey);
+    }
 
-            case SearchCondition::Length:
-            case SearchCondition::NumVowels:
-            case SearchCondition::NumUniqueLetters:
-            case SearchCondition::PointValue:
-            case SearchCondition::NumAnagrams: {
-                tables.insert("words");
-                QString column;
-                if (condition.type == SearchCondition::Length)
-                    column = "words.length";
-                if (condition.type == SearchCondition::NumVowels)
-                    column = "words.num_vowels";
-                if (condition.type == SearchCondition::NumUniqueLetters)
-                    column = "words.num_unique_letters";
-                if (condition.type == SearchCondition::PointValue)
-                    column = "words.point_value";
-                if (condition.type == SearchCondition::NumAnagrams)
-                    column = "words.num_anagrams";
+    if (missingWords.isEmpty())
+        return;
 
-                whereStr += " " + column;
-                if (condition.minValue == condition.maxValue) {
-                    whereStr += "=" + QString::number(condition.minValue);
-                }
-                else {
-                    whereStr += ">=" + QString::number(condition.minValue) +
-                        " AND " + column + "<=" +
-                        QString::number(condition.maxValue);
-                }
-            }
-            break;
+    LetterBag bag;
+    QVector<double> missingCombinations;
+    bag.getNumCombinations(missingWords, numBlanks, &missingCombinations);
+    for (int i = 0; i < missingWords.size(); ++i) {
+        double value = missingCombinations[i];
+        (*combinations)[missingIndexes[i]] = value;
+        if (data && CombinationCache::canCache(missingKeys[i], numBlanks))
+            data->combinationCache.insert(missingKeys[i], numBlanks, value);
+    }
+}
 
-            case SearchCondition::IncludeLetters: {
-                tables.insert("words");
-                QString str = condition.stringValue;
-                QMap<QChar, int> letters;
-                for (int i = 0; i < str.length(); ++i) {
-                    ++letters[str.at(i)];
-                }
+//---------------------------------------------------------------------------
+//  getLimitKeys
+//
+//! Get the sort keys of words for Limit by Probability/Playability Order
+//! conditions.  Playability values are read from the word attributes if
+//! they are loaded, otherwise from the database in chunks with one prepared
+//! statement, and words not in the lexicon get no key.
+//
+//! @param lexicon the name of the lexicon
+//! @param words the words
+//! @param probCondition whether to sort by probability instead of
+//! playability
+//! @param probNumBlanks the number of blanks to consider for probability
+//! @param alphabetical whether words with equal probability are sorted
+//! alphabetically instead of by alphagram
+//! @param keys returns the sort keys
+//! @return false if the database is needed but not connected, true
+//! otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::getLimitKeys(const QString& lexicon, const QStringList& words,
+                         bool probCondition, int probNumBlanks, bool
+                         alphabetical, QVector<LimitKey>* keys) const
+{
+    keys->clear();
+    keys->reserve(words.size());
+
+    if (probCondition) {
+        QStringList wordsUpper;
+        foreach (const QString& word, words)
+            wordsUpper.append(word.toUpper());
+
+        QVector<double> combinations;
+        getCachedCombinations(lexicon, wordsUpper, probNumBlanks,
+                              &combinations);
+        for (int i = 0; i < wordsUpper.size(); ++i) {
+            const QString& wordUpper = wordsUpper[i];
+            keys->append(LimitKey(int(combinations[i]), alphabetical ?
+                                  QString() : Auxil::getAlphagram(wordUpper),
+                                  wordUpper, i));
+        }
+        return true;
+    }
 
-                QMapIterator<QChar, int> it (letters);
-                for (int i = 0; it.hasNext(); ++i) {
-                    it.next();
-                    QChar c = it.key();
-                    if (i)
-                        whereStr += " AND";
-                    whereStr += " word";
-                    if (condition.negated)
-                        whereStr += " NOT";
-                    whereStr += " LIKE '%";
-                    int count = condition.negated ? 1 : it.value();
-                    for (int j = 0; j < count; ++j) {
-                        whereStr += QString(c) + "%";
-                    }
-                    whereStr += "'";
-                }
-            }
-            break;
+    LexiconData* data = lexiconData.value(lexicon);
+    if (data && !data->attributes.isEmpty()) {
+        const QVector<qint64>& playability = data->attributes.playability;
+        for (int i = 0; i < words.size(); ++i) {
+            QString wordUpper = words[i].toUpper();
+            int id = getWordId(lexicon, wordUpper);
+            if ((id < 0) || (id >= playability.size()))
+                continue;
+            keys->append(LimitKey(playability[id],
+                                  Auxil::getAlphagram(wordUpper), wordUpper,
+                                  i));
+        }
+        return true;
+    }
 
-            case SearchCondition::BelongToGroup: {
-                tables.insert("words");
-                SearchSet searchSet =
-                    Auxil::stringToSearchSet(condition.stringValue);
-                int target = condition.negated ? 0 : 1;
-                switch (searchSet) {
-                    case SetFrontHooks:
-                    whereStr += " words.is_front_hook=" +
-                        QString::number(target);
-                    break;
+    DatabaseConnection* connection = data ? getConnection(data) : 0;
+    QSqlQuery* query = connection ? getPlayabilityQuery(connection) : 0;
+    if (!query)
+        return false;
 
-                    case SetBackHooks:
-                    whereStr += " words.is_back_hook=" +
-                        QString::number(target);
-                    break;
+    QStringList wordsUpper;
+    QHash<QString, int> wordIndexes;
+    for (int i = 0; i < words.size(); ++i) {
+        QString wordUpper = words[i].toUpper();
+        wordsUpper.append(wordUpper);
+        wordIndexes.insert(wordUpper, i);
+    }
 
-                    case SetHookWords:
-                    if (condition.negated) {
-                        whereStr += " (words.is_front_hook=0 AND "
-                            "words.is_back_hook=0)";
-                    }
-                    else {
-                        whereStr += " (words.is_front_hook=1 OR "
-                            "words.is_back_hook=1)";
-                    }
-                    break;
+    // Look the words up in chunks with the same prepared statement, padding
+    // the last chunk with null values that match no words
+    int numWords = wordsUpper.size();
+    for (int start = 0; start < numWords; start += CACHE_QUERY_CHUNK_SIZE) {
+        int chunkWords = qMin(numWords - start, CACHE_QUERY_CHUNK_SIZE);
+        for (int i = 0; i < CACHE_QUERY_CHUNK_SIZE; ++i) {
+            query->bindValue(i, (i < chunkWords)
+                             ? QVariant(wordsUpper[start + i])
+                             : QVariant(QVariant::String));
+        }
+        query->exec();
+        while (query->next()) {
+            QString wordUpper = query->value(0).toString();
+            if (!wordIndexes.contains(wordUpper))
+                continue;
+            keys->append(LimitKey(query->value(1).toLongLong(),
+                                  Auxil::getAlphagram(wordUpper), wordUpper,
+                                  wordIndexes[wordUpper]));
+        }
+        query->finish();
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  compilePostConditions
+//
+//! Compile the conditions of a search that are tested by
+//! matchesPostConditions, so they can be tested against many words.  The
+//! compiled conditions are ordered by estimated cost, cheapest first, so a
+//! word failing a cheap condition is not tested against the others.
+//
+//! @param lexicon the name of the lexicon
+//! @param conditions the list of conditions
+//! @return the compiled post conditions
+//---------------------------------------------------------------------------
+QVector<WordEngine::PostConditionOp>
+WordEngine::compilePostConditions(const QString& lexicon, const
+                                  QList<SearchCondition>& conditions) const
+{
+    QVector<PostConditionOp> ops;
+    if (!lexiconData.contains(lexicon))
+        return ops;
+
+    const WordGraph* graph = lexiconData[lexicon]->graph;
+    QListIterator<SearchCondition> it (conditions);
+    while (it.hasNext()) {
+        const SearchCondition& condition = it.next();
+        if (getConditionPhase(condition) != PostConditionPhase)
+            continue;
+
+        PostConditionOp op;
+        op.type = condition.type;
+        op.negated = condition.negated;
+        op.stringValue = condition.stringValue;
+        op.graph = graph;
+
+        switch (condition.type) {
 
-                    default:
-                    break;
-                }
-            }
+            // A word graph lookup, after building the word to look up
+            case SearchCondition::Prefix:
+            case SearchCondition::Suffix:
+            op.cost = 2;
             break;
 
-            case SearchCondition::InWordList: {
-                tables.insert("words");
-                whereStr += " words.word";
-                if (condition.negated)
-                    whereStr += " NOT";
-                whereStr += " IN (";
-                QStringList words = condition.stringValue.split(QChar(' '));
-                QStringListIterator it (words);
-                bool firstWord = true;
-                while (it.hasNext()) {
-                    QString word = it.next();
-                    if (!firstWord)
-                        whereStr += ",";
-                    firstWord = false;
-                    whereStr += "'" + word + "'";
+            case SearchCondition::BelongToGroup:
+            op.searchSet = Auxil::stringToSearchSet(condition.stringValue);
+            if (op.searchSet == UnknownSearchSet)
+                continue;
+            op.members = getSetMembers(lexicon, op.searchSet);
+            if (!op.members.isEmpty())
+                op.cost = 2;
+            else if ((op.searchSet == SetFrontHooks) ||
+                     (op.searchSet == SetBackHooks))
+                op.cost = 3;
+            else if (op.searchSet == SetHookWords)
+                op.cost = 4;
+            else
+                op.cost = 5;
+            break;
+
+            // A word graph lookup of the word itself
+            case SearchCondition::InLexicon:
+            op.graph = lexiconData.contains(condition.stringValue) ?
+                lexiconData[condition.stringValue]->graph : 0;
+            op.cost = 1;
+            break;
+
+            // A lookup of the word in the words with orders in range
+            case SearchCondition::ProbabilityOrder: {
+                QVector<qint32> table = getProbabilityOrderTable(lexicon,
+                    condition.intValue, QString());
+                int numWords = table.size() / 3;
+                op.members = QBitArray(numWords);
+                for (int id = 0; id < numWords; ++id) {
+                    const qint32* order = table.constData() + 3 * id;
+                    bool inRange = condition.boolValue
+                        ? ((order[2] >= condition.minValue) &&
+                           (order[1] <= condition.maxValue))
+                        : ((order[0] >= condition.minValue) &&
+                           (order[0] <= condition.maxValue));
+                    if (inRange)
+                        op.members.setBit(id);
                 }
-                whereStr += ")";
+                op.cost = 2;
             }
             break;
 
             default:
-            break;
+            continue;
         }
 
-        whereStr += ")";
+        // Keep conditions of equal cost in their original order
+        int i = ops.size();
+        ops.append(op);
+        for (; (i > 0) && (ops[i - 1].cost > op.cost); --i)
+            ops[i] = ops[i - 1];
+        ops[i] = op;
     }
 
-    // Make sure results are in the provided word list
-    QMap<QString, QString> upperToLower;
-    if (wordList) {
-        tables.insert("words");
-        whereStr += " AND words.word IN (";
-        QStringListIterator it (*wordList);
-        bool firstWord = true;
-        while (it.hasNext()) {
-            QString word = it.next();
-            QString wordUpper = word.toUpper();
-            upperToLower[wordUpper] = word;
-            if (!firstWord)
-                whereStr += ",";
-            firstWord = false;
-            whereStr += "'" + wordUpper + "'";
-        }
-        whereStr += ")";
-    }
+    return ops;
+}
 
-    QStringList tablesList = tables.toList();
-    QString tableStr = " " + tablesList.join(", ");
-    QString selectColStr = "word";
-    if (tables.contains("words")) {
-        selectColStr = " words.word";
-    }
+//---------------------------------------------------------------------------
+//  matchesPostConditions
+//
+//! Test whether a word matches compiled post conditions.  Only the
+//! conditions that cannot be easily tested in WordGraph::search are
+//! compiled by compilePostConditions.
+//
+//! @param lexicon the lexicon
+//! @param wordUpper the word to be tested, in upper case
+//! @param ops the compiled post conditions
+//! @return true if the word matches all the conditions, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::matchesPostConditions(const Lexicon& lexicon, const QString&
+                                  wordUpper, const QVector<PostConditionOp>&
+                                  ops) const
+{
+    const PostConditionOp* op = ops.constData();
+    const PostConditionOp* end = op + ops.size();
+    for (; op != end; ++op) {
+        bool match = false;
+        switch (op->type) {
 
-    QString queryStr = "SELECT" + selectColStr + " FROM" + tableStr +
-        " WHERE" + whereStr;
+            case SearchCondition::Prefix:
+            match = op->graph &&
+                op->graph->containsWord(op->stringValue + wordUpper);
+            break;
 
-    //qDebug("Query str: |%s|", queryStr.toUtf8().constData());
+            case SearchCondition::Suffix:
+            match = op->graph &&
+                op->graph->containsWord(wordUpper + op->stringValue);
+            break;
 
-    // Query the database
-    QStringList resultList;
-    QSqlDatabase* db = lexiconData[lexicon]->db;
-    QSqlQuery query (queryStr, *db);
-    while (query.next()) {
-        QString word = query.value(0).toString();
-        if (!upperToLower.isEmpty() && upperToLower.contains(word)) {
-            word = upperToLower[word];
+            case SearchCondition::BelongToGroup: {
+                int id = op->members.isEmpty() ? -1 :
+                    op->graph->indexOf(wordUpper);
+                if ((id >= 0) && (id < op->members.size()))
+                    match = op->members.testBit(id);
+                else
+                    match = isSetMember(lexicon, wordUpper, op->searchSet);
+            }
+            break;
+
+            case SearchCondition::InLexicon:
+            match = op->graph && op->graph->containsWord(wordUpper);
+            break;
+
+            case SearchCondition::ProbabilityOrder: {
+                int id = op->graph ? op->graph->indexOf(wordUpper) : -1;
+                match = (id >= 0) && (id < op->members.size()) &&
+                    op->members.testBit(id);
+            }
+            break;
+
+            default:
+            continue;
         }
-        resultList.append(word);
+
+        if (!match ^ op->negated)
+            return false;
     }
 
-    return resultList;
+    return true;
 }
 
 //---------------------------------------------------------------------------
-//  applyPostConditions
+//  isSetMember
 //
-//! Limit search results by search conditions that cannot be easily used to
-//! limit word graph or database searches.
+//! Determine whether a word is a member of a set.  Assumes the word has
+//! already been determined to be acceptable.
 //
-//! @param optimizedSpec the search spec
-//! @param wordList optional list of words that results must be in
-//! @return a list of words matching the search spec
+//! @param lexicon the lexicon
+//! @param word the word to look up
+//! @param ss the search set
+//! @return true if a member of the set, false otherwise
 //---------------------------------------------------------------------------
-QStringList
-WordEngine::applyPostConditions(const QString& lexicon,
-    const SearchSpec& optimizedSpec, const QStringList& wordList) const
+bool
+WordEngine::isSetMember(const Lexicon& lexicon, const QString& word,
+                        SearchSet ss) const
 {
-    QStringList returnList = wordList;
+    const LexiconData* data = lexicon.data;
+    if (!data)
+        return false;
 
-    // Check special postconditions
-    QStringList::iterator wit;
-    for (wit = returnList.begin(); wit != returnList.end();) {
-        if (matchesPostConditions(lexicon, *wit, optimizedSpec.conditions))
-            ++wit;
-        else
-            wit = returnList.erase(wit);
-    }
-    if (returnList.isEmpty())
-        return returnList;
+    static QString typeTwoChars = "AAADEEEEGIIILNNOORRSSTTU";
+    static int typeTwoCharsLen = typeTwoChars.length();
+    static LetterSignature typeTwoLetters (typeTwoChars);
+    static LetterBag letterBag("A:9 B:2 C:2 D:4 E:12 F:2 G:3 H:2 I:9 J:1 "
+                               "K:1 L:4 M:2 N:6 O:8 P:2 Q:1 R:6 S:4 T:6 "
+                               "U:4 V:2 W:2 X:1 Y:2 Z:1 _:2");
 
-    // Handle Limit by Probability/Playability Order conditions
-    bool legacyProbCondition = false;
-    const int MIN_INDEX = 0;
-    const int MAX_INDEX = 1;
-    const int MIN_LAX_INDEX = 2;
-    const int MAX_LAX_INDEX = 3;
-    QMap<QPair<SearchCondition::SearchType, int>, QVector<int> > limits;
-    QListIterator<SearchCondition> cit (optimizedSpec.conditions);
-    while (cit.hasNext()) {
-        SearchCondition condition = cit.next();
-        if ((condition.type == SearchCondition::LimitByProbabilityOrder) ||
-            (condition.type == SearchCondition::LimitByPlayabilityOrder))
-        {
-            int probNumBlanks = 0;
-            if (condition.type == SearchCondition::LimitByProbabilityOrder) {
-                probNumBlanks = condition.intValue;
-                if (condition.legacy)
-                    legacyProbCondition = true;
+    // ### For backward compatibility, set membership is calculated using
+    // probability calculated with two blanks - should make this customizable
+    static double typeThreeSevenCombos
+        = letterBag.getNumCombinations("HUNTERS", 2);
+    static double typeThreeEightCombos
+        = letterBag.getNumCombinations("NOTIFIED", 2);
+
+    switch (ss) {
+        case SetHookWords:
+        return (lexicon.isAcceptable(word.left(word.length() - 1)) ||
+                lexicon.isAcceptable(word.right(word.length() - 1)));
+
+        case SetFrontHooks:
+        return lexicon.isAcceptable(word.right(word.length() - 1));
+
+        case SetBackHooks:
+        return lexicon.isAcceptable(word.left(word.length() - 1));
+
+        case SetHighFives: {
+            if (word.length() != 5)
+                return false;
+
+            bool ok = false;
+            for (int i = 0; i < word.length(); ++i) {
+                int value = letterBag.getLetterValue(word[i]);
+                if (value > 5)
+                    return false;
+                if (((value == 4) || (value == 5)) && ((i == 0) || (i == 4)))
+                    ok = true;
             }
+            return ok;
+        }
 
-            QPair<SearchCondition::SearchType, int> typePair =
-                qMakePair(condition.type, probNumBlanks);
+        case SetTypeOneSevens: {
+            if (word.length() != 7)
+                return false;
 
-            // Initialize limits
-            if (!limits.contains(typePair)) {
-                limits[typePair] = (QVector<int>() << 0 <<
-                    LIMIT_RANGE_MAX << 0 << LIMIT_RANGE_MAX);
+            if (!data->stemAlphagrams.contains(word.length() - 1))
+                return false;
+
+            QMap<int, StemIndex>::const_iterator sit =
+                data->stemIndexes.constFind(word.length() - 1);
+            if (sit != data->stemIndexes.constEnd())
+                return sit->wordStems.contains(data->graph->indexOf(word));
+
+            CompactWord agram (Auxil::getAlphagram(word));
+            const QSet<CompactWord>& alphaSet =
+                data->stemAlphagrams[word.length() - 1];
+
+            for (int i = 0; i < agram.length(); ++i) {
+                if (alphaSet.contains(agram.withoutLetter(i)))
+                    return true;
             }
+            return false;
+        }
 
-            if (condition.boolValue) {
-                if (condition.minValue > limits[typePair][MIN_LAX_INDEX])
-                    limits[typePair][MIN_LAX_INDEX] = condition.minValue;
-                if (condition.maxValue < limits[typePair][MAX_LAX_INDEX])
-                    limits[typePair][MAX_LAX_INDEX] = condition.maxValue;
+        case SetTypeOneEights: {
+            if (word.length() != 8)
+                return false;
+
+            if (!data->stemAlphagrams.contains(word.length() - 2))
+                return false;
+
+            // Remove each pair of letters from the alphagram of the word,
+            // and look up the remaining letters in the stem alphagrams
+            CompactWord agram (Auxil::getAlphagram(word));
+            const QSet<CompactWord>& alphaSet =
+                data->stemAlphagrams[word.length() - 2];
+
+            const QByteArray& letters = agram.getBytes();
+            int agramLen = agram.length();
+            for (int i = 0; i < agramLen - 1; ++i) {
+                // Removing a letter equal to the last one removed gives the
+                // same alphagrams again
+                if ((i > 0) && (letters.at(i) == letters.at(i - 1)))
+                    continue;
+                CompactWord rest = agram.withoutLetter(i);
+                for (int j = i + 1; j < agramLen; ++j) {
+                    if ((j > i + 1) && (letters.at(j) == letters.at(j - 1)))
+                        continue;
+                    if (alphaSet.contains(rest.withoutLetter(j - 1)))
+                        return true;
+                }
+            }
+            return false;
+        }
+
+        case SetTypeTwoSevens:
+        case SetTypeTwoEights:
+        {
+            if (((ss == SetTypeTwoSevens) && (word.length() != 7)) ||
+                ((ss == SetTypeTwoEights) && (word.length() != 8)))
+                return false;
+
+            // Type II words are made only of the Type II letters
+            bool ok = false;
+            LetterSignature wordLetters (word);
+            if (wordLetters.isValid() && !wordLetters.getNumBlanks()) {
+                ok = typeTwoLetters.contains(wordLetters);
             }
             else {
-                if (condition.minValue > limits[typePair][MIN_INDEX])
-                    limits[typePair][MIN_INDEX] = condition.minValue;
-                if (condition.maxValue < limits[typePair][MAX_INDEX])
-                    limits[typePair][MAX_INDEX] = condition.maxValue;
+                QString alphagram = Auxil::getAlphagram(word);
+                int wi = 0;
+                QChar wc = alphagram[wi];
+                for (int ti = 0; ti < typeTwoCharsLen; ++ti) {
+                    QChar tc = typeTwoChars[ti];
+                    if (tc == wc) {
+                        ++wi;
+                        if (wi == alphagram.length()) {
+                            ok = true;
+                            break;
+                        }
+                        wc = alphagram[wi];
+                    }
+                }
             }
+            return (ok && !isSetMember(lexicon, word,
+                (ss == SetTypeTwoSevens ? SetTypeOneSevens : SetTypeOneEights)));
         }
-    }
 
-    // Keep only words in the limit ranges
-    if (!limits.isEmpty()) {
-        QSet<QString> returnSet = returnList.toSet();
-        QMap<int, QMap<QString, QString> > probValueMap;
-        QMap<QString, QString> playValueMap;
+        case SetTypeThreeSevens: {
+            if (word.length() != 7)
+                return false;
 
-        QMapIterator<QPair<SearchCondition::SearchType, int>, QVector<int> >
-            it (limits);
-        while (it.hasNext()) {
-            it.next();
-            SearchCondition::SearchType searchType = it.key().first;
-            int probNumBlanks = it.key().second;
-            const QVector<int> limitValues = it.value();
-            bool probCondition =
-                (searchType == SearchCondition::LimitByProbabilityOrder);
+            // ### For backward compatibility, set membership is calculated
+            // using probability calculated with two blanks - should make this
+            // customizable
+            double combos = letterBag.getNumCombinations(word, 2);
+            return ((combos >= typeThreeSevenCombos) &&
+                    !isSetMember(lexicon, word, SetTypeOneSevens) &&
+                    !isSetMember(lexicon, word, SetTypeTwoSevens));
+        }
 
-            if ((limitValues[MIN_INDEX] > limitValues[MAX_INDEX]) ||
-                (limitValues[MIN_INDEX] > returnList.size()) ||
-                (limitValues[MIN_LAX_INDEX] > returnList.size()))
-            {
-                return QStringList();
-            }
+        case SetTypeThreeEights: {
+            if (word.length() != 8)
+                return false;
 
-            // Convert from 1-based to 0-based offset
-            int limitMin = limitValues[MIN_INDEX] - 1;
-            int limitMax = limitValues[MAX_INDEX] - 1;
-            int limitMinLax = limitValues[MIN_LAX_INDEX] - 1;
-            int limitMaxLax = limitValues[MAX_LAX_INDEX] - 1;
+            // ### For backward compatibility, set membership is calculated
+            // using probability calculated with two blanks - should make this
+            // customizable
+            double combos = letterBag.getNumCombinations(word, 2);
+            return ((combos >= typeThreeEightCombos) &&
+                    !isSetMember(lexicon, word, SetTypeOneEights) &&
+                    !isSetMember(lexicon, word, SetTypeTwoEights));
+        }
+
+        case SetEightsFromSevenLetterStems: {
+            if (word.length() != 8)
+                return false;
 
-            // Snap limits to endpoints
-            if (limitMin < 0)
-                limitMin = 0;
-            if (limitMinLax < 0)
-                limitMinLax = 0;
-            if (limitMax > returnList.size() - 1)
-                limitMax = returnList.size() - 1;
-            if (limitMaxLax > returnList.size() - 1)
-                limitMaxLax = returnList.size() - 1;
+            if (!data->stemAlphagrams.contains(word.length() - 1))
+                return false;
 
-            // Use the higher of the min values as working min
-            int min = (limitMin > limitMinLax) ? limitMin : limitMinLax;
+            QMap<int, StemIndex>::const_iterator sit =
+                data->stemIndexes.constFind(word.length() - 1);
+            if (sit != data->stemIndexes.constEnd())
+                return sit->wordStems.contains(data->graph->indexOf(word));
 
-            // Use the lower of the max values as working max
-            int max = (limitMax < limitMaxLax) ? limitMax : limitMaxLax;
+            CompactWord agram (Auxil::getAlphagram(word));
+            const QSet<CompactWord>& alphaSet =
+                data->stemAlphagrams[word.length() - 1];
 
-            // Sort the words according to probability order
-            if (probCondition) {
-                QMap<QString, QString>& valueMap = probValueMap[probNumBlanks];
-                if (valueMap.isEmpty()) {
-                    LetterBag bag;
-                    foreach (const QString& word, returnList) {
-                        QString radix;
-                        QString wordUpper = word.toUpper();
-                        int combinations =
-                            bag.getNumCombinations(wordUpper, probNumBlanks);
-                        radix.sprintf("%018lld", 999999999999999999LL -
-                            combinations);
-                        // Legacy probability order limits are sorted
-                        // alphabetically, not by alphagram
-                        if (!legacyProbCondition)
-                            radix += Auxil::getAlphagram(wordUpper) + ":";
-                        radix += wordUpper;
-                        valueMap.insert(radix, word);
-                    }
-                }
+            for (int i = 0; i < agram.length(); ++i) {
+                if (alphaSet.contains(agram.withoutLetter(i)))
+                    return true;
             }
+            return false;
+        }
 
-            // Sort the words according to playability order
-            else if (playValueMap.isEmpty()) {
-                LexiconData* lexData = lexiconData.value(lexicon);
-                if (!lexData)
-                    return returnList;
-
-                QSqlDatabase* db = lexData->db;
-                if (!db || !db->isOpen())
-                    return returnList;
+        default: return false;
+    }
+}
 
-                QMap<QString, QString> origCase;
-                QString qstr = "SELECT word, playability FROM words "
-                    "WHERE word IN (";
-                QStringListIterator it (returnList);
-                for (int i = 0; it.hasNext(); ++i) {
-                    const QString& word = it.next();
-                    origCase[word.toUpper()] = word;
-                    if (i)
-                        qstr += ", ";
-                    qstr += "'" + word.toUpper() + "'";
-                }
-                qstr += ")";
-
-                QSqlQuery query (*db);
-                query.prepare(qstr);
-                query.exec();
-
-                while (query.next()) {
-                    QString word = origCase[query.value(0).toString()];
-                    qint64 playability = query.value(1).toLongLong();
-                    QString radix;
-                    QString wordUpper = word.toUpper();
-                    radix.sprintf("%018lld", 999999999999999999LL - playability);
-                    radix += Auxil::getAlphagram(wordUpper) + ":";
-                    radix += wordUpper;
-                    playValueMap.insert(radix, word);
-                }
-            }
+//---------------------------------------------------------------------------
+//  getSetMembers
+//
+//! Get the words of a lexicon that belong to a search set, finding them the
+//! first time the set is used.  Only sets of words of a single length that
+//! are checked word by word are found this way.
+//
+//! @param lexicon the name of the lexicon
+//! @param ss the search set
+//! @return a bit for each word in the lexicon, indexed by the alphabetical
+//! index of the word, that is set if the word belongs to the search set,
+//! or an empty array if the members of the set cannot be found this way
+//---------------------------------------------------------------------------
+QBitArray
+WordEngine::getSetMembers(const QString& lexicon, SearchSet ss) const
+{
+    int length = 0;
+    switch (ss) {
+        case SetHighFives:
+        length = 5;
+        break;
 
-            QMap<QString, QString>& valueMap = probCondition ?
-                probValueMap[probNumBlanks] : playValueMap;
-            QStringList keys = valueMap.keys();
+        case SetTypeOneSevens:
+        case SetTypeTwoSevens:
+        case SetTypeThreeSevens:
+        length = 7;
+        break;
 
-            // Allow Lax matches only up to hard Min limit
-            QString minRadix = keys[min];
-            QString minValue = minRadix.left(18);
-            while ((min > 0) && (min > limitMin)) {
-                if (minValue != keys[min - 1].left(18))
-                    break;
-                --min;
-            }
+        case SetTypeOneEights:
+        case SetTypeTwoEights:
+        case SetTypeThreeEights:
+        case SetEightsFromSevenLetterStems:
+        length = 8;
+        break;
 
-            // Allow Lax matches only up to hard Max limit
-            QString maxRadix = keys[max];
-            QString maxValue = maxRadix.left(18);
-            while ((max < keys.size() - 1) && (max < limitMax)) {
-                if (maxValue != keys[max + 1].left(18))
-                    break;
-                ++max;
-            }
+        default:
+        return QBitArray();
+    }
 
-            if (min > max)
-                return QStringList();
+    if (!lexiconData.contains(lexicon))
+        return QBitArray();
 
-            // Only keep candidates that matched constraints
-            returnSet &= (valueMap.values().mid(min, max - min + 1)).toSet();
+    LexiconData* data = lexiconData[lexicon];
+    const WordGraph* graph = data->graph;
+    if (!graph || !graph->hasWordCounts())
+        return QBitArray();
+
+    QMutexLocker locker (&data->setMemberMutex);
+    if (data->setMembers.contains(ss))
+        return data->setMembers[ss];
+
+    // Words formed from stems are taken straight from the stem index
+    int stemLength = ((ss == SetTypeOneSevens) ||
+                      (ss == SetEightsFromSevenLetterStems)) ? length - 1 : 0;
+    QMap<int, StemIndex>::const_iterator sit =
+        data->stemIndexes.constFind(stemLength);
+    if (stemLength && (sit != data->stemIndexes.constEnd())) {
+        QBitArray members (graph->getNumWords());
+        QHashIterator<qint32, QStringList> wit (sit->wordStems);
+        while (wit.hasNext()) {
+            qint32 id = wit.next().key();
+            if ((id >= 0) && (id < members.size()))
+                members.setBit(id);
         }
+        data->setMembers.insert(ss, members);
+        return members;
+    }
 
-        returnList = returnSet.toList();
+    SearchCondition condition;
+    condition.type = SearchCondition::PatternMatch;
+    condition.stringValue = QString(length, '?');
+    SearchSpec spec;
+    spec.conditions.append(condition);
+
+    Lexicon handle (this, lexicon, data);
+    QBitArray members (graph->getNumWords());
+    foreach (const QString& word, graph->search(spec)) {
+        QString wordUpper = word.toUpper();
+        if (!isSetMember(handle, wordUpper, ss))
+            continue;
+        int id = graph->indexOf(wordUpper);
+        if ((id >= 0) && (id < members.size()))
+            members.setBit(id);
     }
 
-    return returnList;
+    data->setMembers.insert(ss, members);
+    return members;
 }
 
 //---------------------------------------------------------------------------
-//  lexiconIsLoaded
+//  getNumAnagrams
 //
-//! Determine whether a lexicon is loaded.
+//! Determine the number of valid anagrams of a word.
 //
 //! @param lexicon the name of the lexicon
-//! @return true if the lexicon is loaded, false otherwise
+//! @param word the word
+//! @return the number of valid anagrams
 //---------------------------------------------------------------------------
-bool
-WordEngine::lexiconIsLoaded(const QString& lexicon) const
+int
+WordEngine::getNumAnagrams(const QString& lexicon, const QString& word) const
 {
-    return lexiconData.contains(lexicon);
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return lexiconData[lexicon]->attributes.numAnagrams[id];
+
+    WordInfo info = getWordInfo(lexicon, word);
+    if (info.isValid()) {
+        return info.numAnagrams;
+    }
+    else {
+        QString alpha = Auxil::getAlphagram(word);
+        const AnagramIndex& index = lexiconData[lexicon]->anagramIndex;
+        if (!index.isEmpty()) {
+            QPair<qint32, qint32> group = index.groups.value(alpha);
+            return group.second - group.first;
+        }
+        return lexiconData[lexicon]->numAnagramsMap.value(
+            CompactWord(alpha));
+    }
 }
 
 //---------------------------------------------------------------------------
-//  isAcceptable
+//  getPlayabilityValue
 //
-//! Determine whether a word is acceptable in a lexicon.
+//! Get the playability value for a word.
 //
 //! @param lexicon the name of the lexicon
-//! @param word the word to look up
-//! @return true if acceptable, false otherwise
+//! @param word the word
+//! @return the playability value
 //---------------------------------------------------------------------------
-bool
-WordEngine::isAcceptable(const QString& lexicon, const QString& word) const
+qint64
+WordEngine::getPlayabilityValue(const QString& lexicon, const QString& word)
+    const
+{
+    return getLexicon(lexicon).getPlayabilityValue(word);
+}
+
+//---------------------------------------------------------------------------
+//  getPlayabilityOrder
+//
+//! Get the playability order for a word.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @return the playability order
+//---------------------------------------------------------------------------
+int
+WordEngine::getPlayabilityOrder(const QString& lexicon, const QString& word)
+    const
 {
+    QReadLocker locker (&lexiconLock);
+
     if (!lexiconData.contains(lexicon))
-        return false;
+        return 0;
+
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return lexiconData[lexicon]->attributes.playabilityOrders[3 * id];
 
-    return lexiconData[lexicon]->graph->containsWord(word);
+    WordInfo info = getWordInfo(lexicon, word);
+    return info.isValid() ? info.playabilityOrder.valueOrder : 0;
 }
 
 //---------------------------------------------------------------------------
-//  search
+//  getMinPlayabilityOrder
 //
-//! Search for acceptable words matching a search specification.
+//! Get the minimum playability order for a word.
 //
 //! @param lexicon the name of the lexicon
-//! @param spec the search specification
-//! @param allCaps whether to ensure the words in the list are all caps
-//! @return a list of acceptable words
+//! @param word the word
+//! @return the playability order
 //---------------------------------------------------------------------------
-QStringList
-WordEngine::search(const QString& lexicon, const SearchSpec& spec, bool
-                   allCaps) const
+int
+WordEngine::getMinPlayabilityOrder(const QString& lexicon, const QString&
+                                   word) const
 {
+    QReadLocker locker (&lexiconLock);
+
     if (!lexiconData.contains(lexicon))
-        return QStringList();
+        return 0;
 
-    SearchSpec optimizedSpec = spec;
-    optimizedSpec.optimize(lexicon);
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return lexiconData[lexicon]->attributes.playabilityOrders[3 * id + 1];
 
-    // Discover which kinds of search conditions are present
-    QMap<ConditionPhase, int> phaseCounts;
-    int lengthConditions = 0;
-    QListIterator<SearchCondition> cit (optimizedSpec.conditions);
-    while (cit.hasNext()) {
-        SearchCondition condition = cit.next();
-        ConditionPhase phase = getConditionPhase(condition);
-        ++phaseCounts[phase];
-        if (condition.type == SearchCondition::Length)
-            ++lengthConditions;
-    }
+    WordInfo info = getWordInfo(lexicon, word);
+    return info.isValid() ? info.playabilityOrder.minValueOrder : 0;
+}
 
-    // Do not search the database based on Length conditions that were only
-    // added by SearchSpec::optimize to optimize word graph searches
-    if ((phaseCounts.contains(WordGraphPhase)) && lengthConditions &&
-        (lengthConditions == phaseCounts.value(DatabasePhase)))
-    {
-        --phaseCounts[DatabasePhase];
-    }
+//---------------------------------------------------------------------------
+//  getMaxPlayabilityOrder
+//
+//! Get the maximum playability order for a word.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @return the playability order
+//---------------------------------------------------------------------------
+int
+WordEngine::getMaxPlayabilityOrder(const QString& lexicon, const QString&
+                                   word) const
+{
+    QReadLocker locker (&lexiconLock);
 
-    // Search the word graph if necessary
-    QStringList resultList;
-    if (phaseCounts.value(WordGraphPhase) ||
-        !phaseCounts.value(DatabasePhase))
-    {
-        resultList = wordGraphSearch(lexicon, optimizedSpec);
-        if (resultList.isEmpty())
-            return resultList;
-    }
+    if (!lexiconData.contains(lexicon))
+        return 0;
 
-    // Search the database if necessary, passing word graph results
-    if (phaseCounts.value(DatabasePhase)) {
-        resultList = databaseSearch(lexicon, optimizedSpec,
-            phaseCounts.contains(WordGraphPhase) ? &resultList : 0);
-        if (resultList.isEmpty())
-            return resultList;
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return lexiconData[lexicon]->attributes.playabilityOrders[3 * id + 2];
+
+    WordInfo info = getWordInfo(lexicon, word);
+    return info.isValid() ? info.playabilityOrder.maxValueOrder : 0;
+}
+
+//---------------------------------------------------------------------------
+//  getProbabilityOrder
+//
+//! Get the probability order for a word.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @param numBlanks the number of blanks
+//! @param distribution the letter distribution, or empty for the default
+//! distribution
+//! @return the probability order
+//---------------------------------------------------------------------------
+int
+WordEngine::getProbabilityOrder(const QString& lexicon, const QString& word,
+                                int numBlanks, const QString& distribution)
+    const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    if (!hasStoredProbabilityOrders(numBlanks, distribution)) {
+        return getTableProbabilityOrder(lexicon, word, numBlanks,
+                                        distribution, 0);
     }
 
-    // Check post conditions if necessary
-    if (phaseCounts.value(PostConditionPhase)) {
-        resultList = applyPostConditions(lexicon, optimizedSpec, resultList);
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return lexiconData[lexicon]->
+            attributes.probabilityOrders[9 * id + 3 * numBlanks];
+
+    WordInfo info = getWordInfo(lexicon, word);
+    return info.isValid() ?
+        info.blankProbabilityOrder.value(numBlanks).valueOrder : 0;
+}
+
+//---------------------------------------------------------------------------
+//  getMinProbabilityOrder
+//
+//! Get the minimum probability order for a word.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @param numBlanks the number of blanks
+//! @param distribution the letter distribution, or empty for the default
+//! distribution
+//! @return the probability order
+//---------------------------------------------------------------------------
+int
+WordEngine::getMinProbabilityOrder(const QString& lexicon, const QString&
+                                   word, int numBlanks, const QString&
+                                   distribution) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    if (!hasStoredProbabilityOrders(numBlanks, distribution)) {
+        return getTableProbabilityOrder(lexicon, word, numBlanks,
+                                        distribution, 1);
     }
 
-    // Convert to all caps if necessary
-    if (allCaps) {
-        QStringList::iterator it;
-        for (it = resultList.begin(); it != resultList.end(); ++it)
-            *it = (*it).toUpper();
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return lexiconData[lexicon]->
+            attributes.probabilityOrders[9 * id + 3 * numBlanks + 1];
+
+    WordInfo info = getWordInfo(lexicon, word);
+    return info.isValid() ?
+        info.blankProbabilityOrder.value(numBlanks).minValueOrder : 0;
+}
+
+//---------------------------------------------------------------------------
+//  getMaxProbabilityOrder
+//
+//! Get the maximum probability order for a word.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @param numBlanks the number of blanks
+//! @param distribution the letter distribution, or empty for the default
+//! distribution
+//! @return the probability order
+//---------------------------------------------------------------------------
+int
+WordEngine::getMaxProbabilityOrder(const QString& lexicon, const QString&
+                                   word, int numBlanks, const QString&
+                                   distribution) const
+{
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    if (!hasStoredProbabilityOrders(numBlanks, distribution)) {
+        return getTableProbabilityOrder(lexicon, word, numBlanks,
+                                        distribution, 2);
     }
 
-    if (!resultList.isEmpty()) {
-        clearCache(lexicon);
-        addToCache(lexicon, resultList);
-    }
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return lexiconData[lexicon]->
+            attributes.probabilityOrders[9 * id + 3 * numBlanks + 2];
+
+    WordInfo info = getWordInfo(lexicon, word);
+    return info.isValid() ?
+        info.blankProbabilityOrder.value(numBlanks).maxValueOrder : 0;
+}
+
+//---------------------------------------------------------------------------
+//  getTableProbabilityOrder
+//
+//! Get a probability order of a word from the probability orders computed
+//! for a letter distribution and number of blanks.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @param numBlanks the number of blanks
+//! @param distribution the letter distribution, or empty for the default
+//! distribution
+//! @param offset 0 for the order, 1 for the minimum order, or 2 for the
+//! maximum order
+//! @return the probability order, or zero if the word has none
+//---------------------------------------------------------------------------
+int
+WordEngine::getTableProbabilityOrder(const QString& lexicon, const QString&
+                                     word, int numBlanks, const QString&
+                                     distribution, int offset) const
+{
+    const WordGraph* graph = lexiconData[lexicon]->graph;
+    int id = graph ? graph->indexOf(word.toUpper()) : -1;
+    if (id < 0)
+        return 0;
 
-    return resultList;
+    QVector<qint32> orders = getProbabilityOrderTable(lexicon, numBlanks,
+                                                      distribution);
+    return (3 * id < orders.size()) ? orders[3 * id + offset] : 0;
 }
 
 //---------------------------------------------------------------------------
-//  wordGraphSearch
+//  getStemWords
 //
-//! Search the word graph for words matching the conditions in a search spec.
+//! Get the words formed by adding one letter to the letters of a stem.  The
+//! words of imported stems are found in the stem index.
 //
 //! @param lexicon the name of the lexicon
-//! @param optimizedSpec the search spec
-//! @return a list of words
+//! @param stem the stem
+//! @return the words, in alphabetical order
 //---------------------------------------------------------------------------
 QStringList
-WordEngine::wordGraphSearch(const QString& lexicon, const SearchSpec&
-                            optimizedSpec) const
+WordEngine::getStemWords(const QString& lexicon, const QString& stem) const
 {
+    QReadLocker locker (&lexiconLock);
+
+    QStringList words;
     if (!lexiconData.contains(lexicon))
-        return QStringList();
+        return words;
+
+    const LexiconData* data = lexiconData[lexicon];
+    const WordGraph* graph = data->graph;
+    if (!graph || !graph->hasWordCounts() || data->anagramIndex.isEmpty())
+        return words;
+
+    QString alphagram = Auxil::getAlphagram(stem.toUpper());
+    QVector<qint32> ids;
+    QMap<int, StemIndex>::const_iterator it =
+        data->stemIndexes.constFind(alphagram.length());
+    if ((it != data->stemIndexes.constEnd()) &&
+        it->stemWords.contains(alphagram))
+    {
+        ids = it->stemWords.value(alphagram);
+    }
+    else {
+        ids = findStemWords(data->anagramIndex, alphagram);
+    }
 
-    return lexiconData[lexicon]->graph->search(optimizedSpec);
+    foreach (qint32 id, ids)
+        words.append(graph->wordAt(id));
+    return words;
 }
 
 //---------------------------------------------------------------------------
-//  alphagrams
+//  getAnagramHooks
 //
-//! Transform a list of strings into a list of alphagrams of those strings.
-//! The created list may be shorter than the original list.
+//! Find the anagram hooks of a word: the words formed by adding one letter
+//! to the word and anagramming it.  With the anagram index, this is one
+//! alphagram lookup for each letter of the lexicon instead of a search.
 //
-//! @param list the list of strings
-//! @return a list of alphagrams
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @return the words, in alphabetical order, keyed by the added letter
 //---------------------------------------------------------------------------
-QStringList
-WordEngine::alphagrams(const QStringList& strList) const
+QMap<QChar, QStringList>
+WordEngine::getAnagramHooks(const QString& lexicon, const QString& word)
+    const
 {
-    // Insert into a set to remove duplicates
-    QSet<QString> alphaSet;
-    foreach (const QString& str, strList) {
-        alphaSet.insert(Auxil::getAlphagram(str));
+    QReadLocker locker (&lexiconLock);
+
+    QMap<QChar, QStringList> hooks;
+    if (!lexiconData.contains(lexicon) || word.isEmpty())
+        return hooks;
+
+    QString upper = word.toUpper();
+    const AnagramIndex& index = lexiconData[lexicon]->anagramIndex;
+    if (!index.isEmpty()) {
+        foreach (const QChar& letter, index.letters) {
+            QStringList words = getIndexedAnagrams(lexicon, upper + letter);
+            if (!words.isEmpty())
+                hooks.insert(letter, words);
+        }
+        return hooks;
     }
 
-    QStringList alphaList = alphaSet.toList();
-    qSort(alphaList.begin(), alphaList.end(),
-          Auxil::localeAwareLessThanQString);
-    return alphaList;
+    // Without the index, search for the anagrams of the word plus a blank,
+    // and find the letter each one adds
+    SearchCondition condition;
+    condition.type = SearchCondition::AnagramMatch;
+    condition.stringValue = "?" + upper;
+    SearchSpec spec;
+    spec.conditions.append(condition);
+    foreach (const QString& hookWord, search(lexicon, spec, true)) {
+        QString added = hookWord;
+        for (int i = 0; i < upper.length(); ++i) {
+            int pos = added.indexOf(upper.at(i));
+            if (pos >= 0)
+                added.remove(pos, 1);
+        }
+        if (added.length() == 1)
+            hooks[added.at(0)].append(hookWord);
+    }
+    return hooks;
 }
 
 //---------------------------------------------------------------------------
-//  getWordInfo
+//  getAnagramStems
 //
-//! Get information about a word from the database.  Also cache the
-//! information for future queries.  Fail if the information is not in the
-//! cache and the database is not open.
+//! Find the words formed by removing one letter from a word and
+//! anagramming it.  With the anagram index, this is one alphagram lookup
+//! for each distinct letter of the word instead of a search.
 //
 //! @param lexicon the name of the lexicon
 //! @param word the word
-//! @return information about the word from the database
+//! @return the words, in alphabetical order, keyed by the removed letter
 //---------------------------------------------------------------------------
-WordEngine::WordInfo
-WordEngine::getWordInfo(const QString& lexicon, const QString& word) const
+QMap<QChar, QStringList>
+WordEngine::getAnagramStems(const QString& lexicon, const QString& word)
+    const
 {
-    if (word.isEmpty())
-        return WordInfo();
+    QReadLocker locker (&lexiconLock);
 
-    if (!lexiconData.contains(lexicon))
-        return WordInfo();
+    QMap<QChar, QStringList> stems;
+    if (!lexiconData.contains(lexicon) || (word.length() < 2))
+        return stems;
 
-    if (lexiconData[lexicon]->wordCache.contains(word)) {
-        //qDebug("Cache HIT: |%s|", word.toUtf8().data());
-        return lexiconData[lexicon]->wordCache[word];
-    }
-    //qDebug("Cache MISS: |%s|", word.toUtf8().data());
+    QString upper = word.toUpper();
+    bool indexed = !lexiconData[lexicon]->anagramIndex.isEmpty();
+    for (int i = 0; i < upper.length(); ++i) {
+        QChar letter = upper.at(i);
+        if (upper.indexOf(letter) < i)
+            continue;
 
-    addToCache(lexicon, QStringList(word));
-    return lexiconData[lexicon]->wordCache.value(word);
+        QString letters = upper;
+        letters.remove(i, 1);
+        QStringList words;
+        if (indexed)
+            words = getIndexedAnagrams(lexicon, letters);
+        else {
+            SearchCondition condition;
+            condition.type = SearchCondition::AnagramMatch;
+            condition.stringValue = letters;
+            SearchSpec spec;
+            spec.conditions.append(condition);
+            words = search(lexicon, spec, true);
+        }
+        if (!words.isEmpty())
+            stems.insert(letter, words);
+    }
+    return stems;
 }
 
 //---------------------------------------------------------------------------
-//  getNumWords
+//  getWordStems
 //
-//! Return a word count for the current lexicon.
+//! Get the imported stems a word is formed from by adding one letter.
 //
 //! @param lexicon the name of the lexicon
-//! @return the word count
+//! @param word the word
+//! @return the alphagrams of the stems
 //---------------------------------------------------------------------------
-int
-WordEngine::getNumWords(const QString& lexicon) const
+QStringList
+WordEngine::getWordStems(const QString& lexicon, const QString& word) const
 {
+    QReadLocker locker (&lexiconLock);
+
     if (!lexiconData.contains(lexicon))
-        return 0;
+        return QStringList();
 
-    QSqlDatabase* db = lexiconData[lexicon]->db;
-    if (db && db->isOpen()) {
-        QString qstr = "SELECT count(*) FROM words";
-        QSqlQuery query (qstr, *db);
-        if (query.next())
-            return query.value(0).toInt();
-    }
-    else
-        return lexiconData[lexicon]->graph->getNumWords();
+    const LexiconData* data = lexiconData[lexicon];
+    QMap<int, StemIndex>::const_iterator it =
+        data->stemIndexes.constFind(word.length() - 1);
+    if (!data->graph || (it == data->stemIndexes.constEnd()))
+        return QStringList();
 
-    return 0;
+    return it->wordStems.value(data->graph->indexOf(word.toUpper()));
 }
 
 //---------------------------------------------------------------------------
-//  getLexiconFile
+//  getMinPlayabilityOrders
 //
-//! Get the text file associated with a lexicon, if applicable.  This is
-//! normally only meaningful for custom lexicons.
+//! Get the minimum playability order of each of a list of words.
 //
 //! @param lexicon the name of the lexicon
-//! @return the lexicon file
+//! @param words the words
+//! @return the minimum playability order of each word, in the order of the
+//! words, or zero for words with no playability order
 //---------------------------------------------------------------------------
-QString
-WordEngine::getLexiconFile(const QString& lexicon) const
+QVector<int>
+WordEngine::getMinPlayabilityOrders(const QString& lexicon, const
+                                    QStringList& words) const
 {
-    if (!lexiconData.contains(lexicon))
-        return QString();
-
-    return lexiconData[lexicon]->lexiconFile;
+    QReadLocker locker (&lexiconLock);
+    return getMinOrders(lexicon, words, false, 0);
 }
 
 //---------------------------------------------------------------------------
-//  getDefinition
+//  getMinProbabilityOrders
 //
-//! Return the definition associated with a word.
+//! Get the minimum probability order of each of a list of words.
 //
 //! @param lexicon the name of the lexicon
-//! @param word the word whose definition to look up
-//! @param replaceLinks whether to resolve links to other definitions
-//! @return the definition, or empty String if no definition
+//! @param words the words
+//! @param numBlanks the number of blanks
+//! @param distribution the letter distribution, or empty for the default
+//! distribution
+//! @return the minimum probability order of each word, in the order of the
+//! words, or zero for words with no probability order
 //---------------------------------------------------------------------------
-QString
-WordEngine::getDefinition(const QString& lexicon, const QString& word,
-                          bool replaceLinks) const
+QVector<int>
+WordEngine::getMinProbabilityOrders(const QString& lexicon, const
+                                    QStringList& words, int numBlanks, const
+                                    QString& distribution) const
 {
-    if (!lexiconData.contains(lexicon))
-        return QString();
+    QReadLocker locker (&lexiconLock);
+    return getMinOrders(lexicon, words, true, numBlanks, distribution);
+}
 
-    WordInfo info = getWordInfo(lexicon, word);
-    //qDebug("WordEngine::getDefinition: lexicon: |%s|, word: |%s|",
-    //       lexicon.toUtf8().constData(), word.toUtf8().constData());
-    //qDebug("info.isValid: %d, info.word: |%s|, "
-    //       "info.numVowels: %d, info.numUniqueLetters: %d, "
-    //       "info.numAnagrams: %d, info.pointValue: %d, "
-    //       "info.frontHooks: |%s|, info.backHooks: |%s|, "
-    //       "info.isFrontHook: %d, info.isBackHook: %d, "
-    //       "info.lexiconSymbols: |%s|, info.definition: |%s|",
-    //       info.isValid(), info.word.toUtf8().constData(),
-    //       info.numVowels, info.numUniqueLetters, info.numAnagrams,
-    //       info.pointValue, info.frontHooks.toUtf8().constData(),
-    //       info.backHooks.toUtf8().constData(), info.isFrontHook,
-    //       info.isBackHook, info.lexiconSymbols.toUtf8().constData(),
-    //       info.definition.toUtf8().constData());
-    //QMapIterator<int, ProbabilityOrder> it (info.blankProbability);
-    //while (it.hasNext()) {
-    //    it.next();
-    //    int numBlanks = it.key();
-    //    const ProbabilityOrder& probOrder = it.value();
-    //    qDebug("numBlanks: %d, prob order: %d, min prob order: %d, "
-    //           "max prob order: %d", numBlanks, probOrder.probabilityOrder,
-    //           probOrder.minProbabilityOrder, probOrder.maxProbabilityOrder);
-    //}
+//---------------------------------------------------------------------------
+//  getMinPlayabilityOrders
+//
+//! Get the minimum playability order of each of a list of word IDs.
+//
+//! @param lexicon the name of the lexicon
+//! @param ids the IDs of the words
+//! @return the minimum playability order of each word, in the order of the
+//! IDs, or zero for words with no playability order
+//---------------------------------------------------------------------------
+QVector<int>
+WordEngine::getMinPlayabilityOrders(const QString& lexicon, const
+                                    QVector<qint32>& ids) const
+{
+    QReadLocker locker (&lexiconLock);
+    return getMinOrdersById(lexicon, ids, false, 0);
+}
 
-    QString definition;
-    if (info.isValid()) {
-        if (replaceLinks) {
-            QStringList defs = info.definition.split(DEF_ORIG_SEP);
-            definition = QString();
-            foreach (const QString& def, defs) {
-                if (!definition.isEmpty())
-                    definition += DEF_DISPLAY_SEP;
-                definition += def;
-            }
-            return definition;
-        }
-        else {
-            return info.definition;
-        }
-    }
+//---------------------------------------------------------------------------
+//  getMinProbabilityOrders
+//
+//! Get the minimum probability order of each of a list of word IDs.
+//
+//! @param lexicon the name of the lexicon
+//! @param ids the IDs of the words
+//! @param numBlanks the number of blanks
+//! @param distribution the letter distribution, or empty for the default
+//! distribution
+//! @return the minimum probability order of each word, in the order of the
+//! IDs, or zero for words with no probability order
+//---------------------------------------------------------------------------
+QVector<int>
+WordEngine::getMinProbabilityOrders(const QString& lexicon, const
+                                    QVector<qint32>& ids, int numBlanks, const
+                                    QString& distribution) const
+{
+    QReadLocker locker (&lexiconLock);
+    return getMinOrdersById(lexicon, ids, true, numBlanks, distribution);
+}
 
-    else {
-        if (!lexiconData[lexicon]->definitions.contains(word))
-            return QString();
+//---------------------------------------------------------------------------
+//  getNumCombinations
+//
+//! Get the number of ways of drawing each of a list of words from a full
+//! bag of letters.  Anagrams have the same number of combinations, so the
+//! numbers are cached by alphagram for each lexicon.
+//
+//! @param lexicon the name of the lexicon
+//! @param words the words
+//! @param numBlanks the number of blanks
+//! @return the number of combinations of each word, in the order of the
+//! words
+//---------------------------------------------------------------------------
+QVector<double>
+WordEngine::getNumCombinations(const QString& lexicon, const QStringList&
+                               words, int numBlanks) const
+{
+    QReadLocker locker (&lexiconLock);
 
-        const QMultiMap<QString, QString>& mmap =
-            lexiconData[lexicon]->definitions.value(word);
-        QMapIterator<QString, QString> it (mmap);
-        while (it.hasNext()) {
-            it.next();
-            if (!definition.isEmpty()) {
-                if (replaceLinks)
-                    definition += DEF_DISPLAY_SEP;
-                else
-                    definition += DEF_ORIG_SEP;
-            }
-            definition += it.value();
-        }
-        return definition;
-    }
+    QVector<double> combinations;
+    getCachedCombinations(lexicon, words, numBlanks, &combinations);
+    return combinations;
 }
 
 //---------------------------------------------------------------------------
-//  getFrontHookLetters
+//  getNumVowels
 //
-//! Get a string of letters that can be added to the front of a word to make
-//! other valid words.
+//! Get the number of vowels in a word.
 //
 //! @param lexicon the name of the lexicon
-//! @param word the word, assumed to be upper case
-//! @return a string containing lower case letters representing front hooks
+//! @param word the word
+//! @return the number of vowels
 //---------------------------------------------------------------------------
-QString
-WordEngine::getFrontHookLetters(const QString& lexicon, const QString& word)
-    const
+int
+WordEngine::getNumVowels(const QString& lexicon, const QString& word) const
 {
-    QString ret;
+    QReadLocker locker (&lexiconLock);
 
-    WordInfo info = getWordInfo(lexicon, word);
-    if (info.isValid()) {
-        ret = info.frontHooks;
-    }
+    // No test of lexiconData because we want to calculate if even not cached
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return lexiconData[lexicon]->attributes.numVowels[id];
 
-    else {
-        SearchSpec spec;
-        SearchCondition condition;
-        condition.type = SearchCondition::PatternMatch;
-        condition.stringValue = "?" + word;
-        spec.conditions.append(condition);
+    WordInfo info = getWordInfo(lexicon, word);
+    return info.isValid() ? info.numVowels : Auxil::getNumVowels(word);
+}
 
-        // Get and sort first letters of each word
-        QStringList words = search(lexicon, spec, true);
-        QList<QChar> letters;
-        foreach (const QString& str, words) {
-            letters.append(str.at(0).toLower());
-        }
-        qSort(letters.begin(), letters.end(),
-              Auxil::localeAwareLessThanQChar);
+//---------------------------------------------------------------------------
+//  getNumUniqueLetters
+//
+//! Get the number of unique letters in a word.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @return the number of unique letters
+//---------------------------------------------------------------------------
+int
+WordEngine::getNumUniqueLetters(const QString& lexicon, const QString& word) const
+{
+    QReadLocker locker (&lexiconLock);
 
-        QListIterator<QChar> it (letters);
-        while (it.hasNext())
-            ret += it.next();
-    }
+    // No test of lexiconData because we want to calculate if even not cached
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return lexiconData[lexicon]->attributes.numUniqueLetters[id];
 
-    return ret;
+    WordInfo info = getWordInfo(lexicon, word);
+    return info.isValid() ? info.numUniqueLetters
+                          : Auxil::getNumUniqueLetters(word);
 }
 
 //---------------------------------------------------------------------------
-//  getBackHookLetters
+//  getPointValue
 //
-//! Get a string of letters that can be added to the back of a word to make
-//! other valid words.
+//! Get the point value for a word.
 //
 //! @param lexicon the name of the lexicon
-//! @param word the word, assumed to be upper case
-//! @return a string containing lower case letters representing back hooks
+//! @param word the word
+//! @return the point value
 //---------------------------------------------------------------------------
-QString
-WordEngine::getBackHookLetters(const QString& lexicon, const QString& word) const
+int
+WordEngine::getPointValue(const QString& lexicon, const QString& word) const
 {
-    QString ret;
+    QReadLocker locker (&lexiconLock);
+
+    if (!lexiconData.contains(lexicon))
+        return 0;
+
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return lexiconData[lexicon]->attributes.pointValue[id];
 
     WordInfo info = getWordInfo(lexicon, word);
-    if (info.isValid()) {
-        ret = info.backHooks;
-    }
+    return info.isValid() ? info.pointValue : 0;
+}
 
-    else {
-        SearchSpec spec;
-        SearchCondition condition;
-        condition.type = SearchCondition::PatternMatch;
-        condition.stringValue = word + "?";
-        spec.conditions.append(condition);
+//---------------------------------------------------------------------------
+//  getIsFrontHook
+//
+//! Determine whether a word is a front hook.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @return true if the word is a front hook, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::getIsFrontHook(const QString& lexicon, const QString& word) const
+{
+    QReadLocker locker (&lexiconLock);
 
-        // Get and sort last letters of each word
-        QStringList words = search(lexicon, spec, true);
-        QList<QChar> letters;
-        foreach (const QString& str, words) {
-            letters.append(str.at(str.length() - 1).toLower());
-        }
-        qSort(letters.begin(), letters.end(),
-              Auxil::localeAwareLessThanQChar);
+    if (!lexiconData.contains(lexicon))
+        return 0;
 
-        QListIterator<QChar> it (letters);
-        while (it.hasNext())
-            ret += it.next();
-    }
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return (lexiconData[lexicon]->attributes.flags[id] &
+                WordAttributes::FrontHookFlag);
 
-    return ret;
+    WordInfo info = getWordInfo(lexicon, word);
+    return info.isValid() ? info.isFrontHook : false;
 }
 
 //---------------------------------------------------------------------------
-//  addToCache
+//  getIsBackHook
 //
-//! Add information about a list of words to the cache.
+//! Determine whether a word is a back hook.
 //
 //! @param lexicon the name of the lexicon
-//! @param words the list of words
+//! @param word the word
+//! @return true if the word is a back hook, false otherwise
 //---------------------------------------------------------------------------
-void
-WordEngine::addToCache(const QString& lexicon, const QStringList& words) const
+bool
+WordEngine::getIsBackHook(const QString& lexicon, const QString& word) const
 {
-    if (words.isEmpty() || !lexiconData.contains(lexicon))
-        return;
-
-    LexiconData* lexData = lexiconData[lexicon];
-    QSqlDatabase* db = lexData->db;
-    if (!db || !db->isOpen())
-        return;
-
-    QString qstr = "SELECT word, num_vowels, "
-        "num_unique_letters, num_anagrams, point_value, "
-        "front_hooks, back_hooks, is_front_hook, "
-        "is_back_hook, lexicon_symbols, definition, playability, "
-        "playability_order, min_playability_order, max_playability_order, "
-        "probability_order0, min_probability_order0, max_probability_order0, "
-        "probability_order1, min_probability_order1, max_probability_order1, "
-        "probability_order2, min_probability_order2, max_probability_order2 "
-        "FROM words WHERE words.word";
-
-    // Throw out words that are already in the cache
-    QStringList needWords;
-    foreach (const QString& word, words) {
-        if (lexData->wordCache.contains(word))
-            continue;
-        needWords.append(word);
-    }
+    QReadLocker locker (&lexiconLock);
 
-    // Construct the where clause from the word list
-    if (needWords.count() == 1) {
-        qstr += "='" + needWords.first() + "'";
-    }
-    else {
-        qstr += " IN (";
-        QStringListIterator it (needWords);
-        for (int i = 0; it.hasNext(); ++i) {
-            if (i)
-                qstr += ", ";
-            qstr += "'" + it.next().toUpper() + "'";
-        }
-        qstr += ")";
-    }
+    if (!lexiconData.contains(lexicon))
+        return 0;
 
-    QSqlQuery query (*db);
-    query.prepare(qstr);
-    query.exec();
+    int id = getWordId(lexicon, word);
+    if (id >= 0)
+        return (lexiconData[lexicon]->attributes.flags[id] &
+                WordAttributes::BackHookFlag);
 
-    while (query.next()) {
-        int placeNum = 0;
-        WordInfo info;
-        info.word                 = query.value(placeNum++).toString();
-        info.numVowels            = query.value(placeNum++).toInt();
-        info.numUniqueLetters     = query.value(placeNum++).toInt();
-        info.numAnagrams          = query.value(placeNum++).toInt();
-        info.pointValue           = query.value(placeNum++).toInt();
-        info.frontHooks           = query.value(placeNum++).toString();
-        info.backHooks            = query.value(placeNum++).toString();
-        info.isFrontHook          = query.value(placeNum++).toBool();
-        info.isBackHook           = query.value(placeNum++).toBool();
-        info.lexiconSymbols       = query.value(placeNum++).toString();
-        info.definition           = query.value(placeNum++).toString();
-        info.playability          = query.value(placeNum++).toLongLong();
+    WordInfo info = getWordInfo(lexicon, word);
+    return info.isValid() ? info.isBackHook : false;
+}
 
-        ValueOrder playOrder;
-        playOrder.valueOrder    = query.value(placeNum++).toInt();
-        playOrder.minValueOrder = query.value(placeNum++).toInt();
-        playOrder.maxValueOrder = query.value(placeNum++).toInt();
-        info.playabilityOrder = playOrder;
+//---------------------------------------------------------------------------
+//  getLexiconSymbols
+//
+//! Get lexicon symbols to be displayed along with this word.
+//
+//! @param lexicon the name of the lexicon
+//! @param word the word
+//! @return a lexicon symbol string
+//---------------------------------------------------------------------------
+QString
+WordEngine::getLexiconSymbols(const QString& lexicon, const QString& word) const
+{
+    QReadLocker locker (&lexiconLock);
 
-        for (int numBlanks = 0; numBlanks <= 2; ++numBlanks) {
-            ValueOrder probOrder;
-            probOrder.valueOrder    = query.value(placeNum++).toInt();
-            probOrder.minValueOrder = query.value(placeNum++).toInt();
-            probOrder.maxValueOrder = query.value(placeNum++).toInt();
-            info.blankProbabilityOrder[numBlanks] = probOrder;
-        }
+    if (!lexiconData.contains(lexicon))
+        return 0;
 
-        lexiconData[lexicon]->wordCache[info.word] = info;
-    }
+    WordInfo info = getWordInfo(lexicon, word);
+    return info.isValid() ? info.lexiconSymbols : QString();
 }
 
 //---------------------------------------------------------------------------
-//  matchesPostConditions
+//  nonGraphSearch
 //
-//! Test whether a word matches certain conditions.  Not all conditions in the
-//! list are tested.  Only the conditions that cannot be easily tested in
-//! WordGraph::search are tested here.
+//! Search for valid words matching conditions that can be matched without
+//! searching the word graph.
 //
 //! @param lexicon the name of the lexicon
-//! @param word the word to be tested
-//! @param conditions the list of conditions to test
-//! @return true if the word matches all special conditions, false otherwise
+//! @param spec the search specification
+//! @return a list of acceptable words matching the In Word List conditions
 //---------------------------------------------------------------------------
-bool
-WordEngine::matchesPostConditions(const QString& lexicon, const QString& word,
-                                  const QList<SearchCondition>& conditions) const
+QStringList
+WordEngine::nonGraphSearch(const QString& lexicon, const SearchSpec& spec) const
 {
-    if (!lexiconData.contains(lexicon))
-        return false;
+    QStringList wordList;
+    QSet<QString> finalWordSet;
+    int conditionNum = 0;
 
-    QString wordUpper = word.toUpper();
-    QListIterator<SearchCondition> it (conditions);
+    const int MAX_ANAGRAMS = 65535;
+    int minAnagrams = 0;
+    int maxAnagrams = MAX_ANAGRAMS;
+    int minNumVowels = 0;
+    int maxNumVowels = MAX_WORD_LEN;
+    int minNumUniqueLetters = 0;
+    int maxNumUniqueLetters = MAX_WORD_LEN;
+    int minPointValue = 0;
+    int maxPointValue = 10 * MAX_WORD_LEN;
+
+    // Look for InWordList conditions first, to narrow the search as much as
+    // possible
+    QListIterator<SearchCondition> it (spec.conditions);
     while (it.hasNext()) {
         const SearchCondition& condition = it.next();
-        if (getConditionPhase(condition) != PostConditionPhase)
-            continue;
 
-        switch (condition.type) {
+        // Note the minimum and maximum number of anagrams from any Number of
+        // Anagrams conditions
+        if (condition.type == SearchCondition::NumAnagrams) {
+            if ((condition.minValue > maxAnagrams) ||
+                (condition.maxValue < minAnagrams))
+                return wordList;
+            if (condition.minValue > minAnagrams)
+                minAnagrams = condition.minValue;
+            if (condition.maxValue < maxAnagrams)
+                maxAnagrams = condition.maxValue;
+        }
 
-            case SearchCondition::Prefix:
-            if ((!isAcceptable(lexicon, condition.stringValue + wordUpper))
-                ^ condition.negated)
-                return false;
-            break;
+        // Note the minimum and maximum number of vowels from any Number of
+        // Vowels conditions
+        else if (condition.type == SearchCondition::NumVowels) {
+            if ((condition.minValue > maxNumVowels) ||
+                (condition.maxValue < minNumVowels))
+                return wordList;
+            if (condition.minValue > minNumVowels)
+                minNumVowels = condition.minValue;
+            if (condition.maxValue < maxNumVowels)
+                maxNumVowels = condition.maxValue;
+        }
 
-            case SearchCondition::Suffix:
-            if ((!isAcceptable(lexicon, wordUpper + condition.stringValue))
-                ^ condition.negated)
-                return false;
-            break;
+        // Note the minimum and maximum number of unique letters from any
+        // Number of Unique Letters conditions
+        else if (condition.type == SearchCondition::NumUniqueLetters) {
+            if ((condition.minValue > maxNumUniqueLetters) ||
+                (condition.maxValue < minNumUniqueLetters))
+                return wordList;
+            if (condition.minValue > minNumUniqueLetters)
+                minNumUniqueLetters = condition.minValue;
+            if (condition.maxValue < maxNumUniqueLetters)
+                maxNumUniqueLetters = condition.maxValue;
+        }
 
-            case SearchCondition::BelongToGroup: {
-                SearchSet searchSet =
-                    Auxil::stringToSearchSet(condition.stringValue);
-                if (searchSet == UnknownSearchSet)
-                    continue;
-                if (!isSetMember(lexicon, wordUpper, searchSet)
-                    ^ condition.negated)
-                    return false;
+        // Note the minimum and maximum point value from any Point Value
+        // conditions
+        else if (condition.type == SearchCondition::PointValue) {
+            if ((condition.minValue > maxPointValue) ||
+                (condition.maxValue < minPointValue))
+                return wordList;
+            if (condition.minValue > minPointValue)
+                minPointValue = condition.minValue;
+            if (condition.maxValue < maxPointValue)
+                maxPointValue = condition.maxValue;
+        }
+
+        // Only InWordList conditions allowed beyond this point - look up
+        // words for acceptability and combine the word lists
+        if (condition.type != SearchCondition::InWordList)
+            continue;
+
+        bool allAcceptable = false;
+        QStringList words = getWordListWords(condition, lexicon,
+                                             &allAcceptable);
+        QSet<QString> wordSet;
+        if (allAcceptable) {
+            wordSet = words.toSet();
+        }
+        else {
+            QBitArray acceptable = areAcceptable(lexicon, words);
+            for (int i = 0; i < words.size(); ++i) {
+                if (acceptable.testBit(i))
+                    wordSet.insert(words[i]);
             }
-            break;
+        }
 
-            case SearchCondition::InLexicon:
-            if ((!isAcceptable(condition.stringValue, wordUpper))
-                ^ condition.negated)
-                return false;
-            break;
+        // Combine search result set with words already found
+        if (!conditionNum) {
+            finalWordSet = wordSet;
+        }
 
-            default: break;
+        else if (spec.conjunction) {
+            QSet<QString> conjunctionSet = finalWordSet & wordSet;
+            if (conjunctionSet.isEmpty())
+                return wordList;
+            finalWordSet = conjunctionSet;
+        }
+
+        else {
+            finalWordSet += wordSet;
         }
+
+        ++conditionNum;
     }
 
-    return true;
-}
+    // Now limit the set only to those words containing the requisite number
+    // of anagrams.  If some words are already in the finalWordSet, then only
+    // test those words.  Otherwise, run through the map of number of anagrams
+    // and pull out all words matching the conditions.
+    if (!finalWordSet.isEmpty() &&
+        ((minAnagrams > 0) || (maxAnagrams < MAX_ANAGRAMS)) ||
+        ((minNumVowels > 0) || (maxNumVowels < MAX_WORD_LEN)) ||
+        ((minNumUniqueLetters > 0) || (maxNumUniqueLetters < MAX_WORD_LEN)) ||
+        ((minPointValue > 0) || (minPointValue < 10 * MAX_WORD_LEN)))
+    {
+        bool testAnagrams = ((minAnagrams > 0) ||
+                             (maxAnagrams < MAX_ANAGRAMS));
+        bool testNumVowels = ((minNumVowels > 0) ||
+                              (maxNumVowels < MAX_WORD_LEN));
+        bool testNumUniqueLetters = ((minNumUniqueLetters > 0) ||
+                                     (maxNumUniqueLetters < MAX_WORD_LEN));
+        bool testPointValue = ((minPointValue > 0) ||
+                               (minPointValue < 10 * MAX_WORD_LEN));
 
-//---------------------------------------------------------------------------
-//  isSetMember
-//
-//! Determine whether a word is a member of a set.  Assumes the word has
-//! already been determined to be acceptable.
-//
-//! @param lexicon the name of the lexicon
-//! @param word the word to look up
-//! @param ss the search set
-//! @return true if a member of the set, false otherwise
-//---------------------------------------------------------------------------
-bool
-WordEngine::isSetMember(const QString& lexicon, const QString& word,
-                        SearchSet ss) const
-{
-    if (!lexiconData.contains(lexicon))
-        return false;
+        QSet<QString> wordSet;
+        QSetIterator<QString> it (finalWordSet);
+        while (it.hasNext()) {
+            QString word = it.next();
 
-    static QString typeTwoChars = "AAADEEEEGIIILNNOORRSSTTU";
-    static int typeTwoCharsLen = typeTwoChars.length();
-    static LetterBag letterBag("A:9 B:2 C:2 D:4 E:12 F:2 G:3 H:2 I:9 J:1 "
-                               "K:1 L:4 M:2 N:6 O:8 P:2 Q:1 R:6 S:4 T:6 "
-                               "U:4 V:2 W:2 X:1 Y:2 Z:1 _:2");
+            if (testAnagrams) {
+                int numAnagrams = getNumAnagrams(lexicon, word);
+                if ((numAnagrams < minAnagrams) || (numAnagrams > maxAnagrams))
+                    continue;
+            }
 
-    // ### For backward compatibility, set membership is calculated using
-    // probability calculated with two blanks - should make this customizable
-    static double typeThreeSevenCombos
-        = letterBag.getNumCombinations("HUNTERS", 2);
-    static double typeThreeEightCombos
-        = letterBag.getNumCombinations("NOTIFIED", 2);
+            if (testNumVowels) {
+                int numVowels = getNumVowels(lexicon, word);
+                if ((numVowels < minNumVowels) || (numVowels > maxNumVowels))
+                    continue;
+            }
 
-    switch (ss) {
-        case SetHookWords:
-        return (isAcceptable(lexicon, word.left(word.length() - 1)) ||
-                isAcceptable(lexicon, word.right(word.length() - 1)));
+            if (testNumUniqueLetters) {
+                int numUniqueLetters = getNumUniqueLetters(lexicon, word);
+                if ((numUniqueLetters < minNumUniqueLetters) ||
+                    (numUniqueLetters > maxNumUniqueLetters))
+                    continue;
+            }
 
-        case SetFrontHooks:
-        return isAcceptable(lexicon, word.right(word.length() - 1));
+            if (testPointValue) {
+                int pointValue = getPointValue(lexicon, word);
+                if ((pointValue < minPointValue) ||
+                    (pointValue > maxPointValue))
+                    continue;
+            }
 
-        case SetBackHooks:
-        return isAcceptable(lexicon, word.left(word.length() - 1));
+            wordSet.insert(word);
+        }
+        finalWordSet = wordSet;
+    }
 
-        case SetHighFives: {
-            if (word.length() != 5)
-                return false;
+    return finalWordSet.toList();
+}
 
-            bool ok = false;
-            for (int i = 0; i < word.length(); ++i) {
-                int value = letterBag.getLetterValue(word[i]);
-                if (value > 5)
-                    return false;
-                if (((value == 4) || (value == 5)) && ((i == 0) || (i == 4)))
-                    ok = true;
-            }
-            return ok;
-        }
+//---------------------------------------------------------------------------
+//  getFileDefinitions
+//
+//! Read the definition of a word from the text file its lexicon was
+//! imported from, and separate its parts of speech.
+//
+//! @param data the data of the lexicon
+//! @param word the word
+//! @return the definitions of the word, grouped by part of speech, or an
+//! empty list if the word has no definition or the file has changed
+//---------------------------------------------------------------------------
+QStringList
+WordEngine::getFileDefinitions(const LexiconData* data, const QString& word)
+    const
+{
+    QHash<CompactWord, qint64>::const_iterator it =
+        data->definitionOffsets.constFind(CompactWord(word));
+    if (it == data->definitionOffsets.constEnd())
+        return QStringList();
 
-        case SetTypeOneSevens: {
-            if (word.length() != 7)
-                return false;
+    QFile file (data->lexiconFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text) ||
+        !file.seek(it.value()))
+    {
+        return QStringList();
+    }
 
-            if (!lexiconData[lexicon]->stemAlphagrams.contains(word.length() - 1))
-                return false;
+    char buffer[MAX_INPUT_LINE_LEN];
+    if (file.readLine(buffer, MAX_INPUT_LINE_LEN) <= 0)
+        return QStringList();
 
-            QString agram = Auxil::getAlphagram(word);
-            const QSet<QString>& alphaSet =
-                lexiconData[lexicon]->stemAlphagrams[word.length() - 1];
+    // A line holding another word means the file changed since the import
+    QString line (buffer);
+    line = line.simplified();
+    if (line.section(' ', 0, 0).toUpper() != word)
+        return QStringList();
 
-            for (int i = 0; i < int(agram.length()); ++i) {
-                if (alphaSet.contains(agram.left(i) +
-                                      agram.right(agram.length() - i - 1)))
-                {
-                    return true;
-                }
-            }
-            return false;
+    QRegExp posRegex (QString("\\[(\\w+)"));
+    QMultiMap<QString, QString> defMap;
+    QStringList defs = line.section(' ', 1).split(DEF_ORIG_SEP);
+    foreach (const QString& def, defs) {
+        QString pos;
+        if (posRegex.indexIn(def, 0) >= 0) {
+            pos = posRegex.cap(1);
         }
+        defMap.insert(pos, def);
+    }
+    return defMap.values();
+}
 
-        case SetTypeOneEights: {
-            if (word.length() != 8)
-                return false;
+//---------------------------------------------------------------------------
+//  getConditionPhase
+//
+//! Determine the search phase during which a search condition should be
+//! considered.
+//
+//! @param condition the search condition
+//! @return the appropriate search phase
+//---------------------------------------------------------------------------
+WordEngine::ConditionPhase
+WordEngine::getConditionPhase(const SearchCondition& condition) const
+{
+    switch (condition.type) {
+        case SearchCondition::AnagramMatch:
+        case SearchCondition::SubanagramMatch:
+        case SearchCondition::ConsistOf:
+        return WordGraphPhase;
 
-            if (!lexiconData[lexicon]->stemAlphagrams.contains(word.length() - 2))
-                return false;
+        // Orders with more blanks than the database stores are computed
+        case SearchCondition::ProbabilityOrder:
+        return (condition.intValue > MAX_STORED_BLANKS) ?
+            PostConditionPhase : DatabasePhase;
 
-            // Compare the letters of the word with the letters of each
-            // alphagram, ensuring that no more than two letters in the word
-            // are missing from the alphagram.
-            QString agram = Auxil::getAlphagram(word);
-            const QSet<QString>& alphaSet =
-                lexiconData[lexicon]->stemAlphagrams[word.length() - 2];
+        case SearchCondition::Length:
+        case SearchCondition::InWordList:
+        case SearchCondition::NumVowels:
+        case SearchCondition::IncludeLetters:
+        case SearchCondition::PlayabilityOrder:
+        case SearchCondition::NumUniqueLetters:
+        case SearchCondition::PointValue:
+        case SearchCondition::NumAnagrams:
+        case SearchCondition::PartOfSpeech:
+        case SearchCondition::Definition:
+        return DatabasePhase;
 
-            QSetIterator<QString> it (alphaSet);
-            while (it.hasNext()) {
-                QString setAlphagram = it.next();
-                int missing = 0;
-                int saIndex = 0;
-                for (int i = 0; (i < int(agram.length())) &&
-                                (saIndex < setAlphagram.length()); ++i)
-                {
-                    if (agram.at(i) == setAlphagram.at(saIndex))
-                        ++saIndex;
-                    else
-                        ++missing;
-                    if (missing > 2)
-                        break;
-                }
-                if (missing <= 2)
-                    return true;
-            }
-            return false;
-        }
+        case SearchCondition::Prefix:
+        case SearchCondition::Suffix:
+        case SearchCondition::InLexicon:
+        case SearchCondition::LimitByProbabilityOrder:
+        case SearchCondition::LimitByPlayabilityOrder:
+        return PostConditionPhase;
 
-        case SetTypeTwoSevens:
-        case SetTypeTwoEights:
+        case SearchCondition::PatternMatch:
+        if (condition.stringValue.startsWith("*") &&
+            condition.stringValue.endsWith("*") &&
+            !condition.stringValue.contains("["))
         {
-            if (((ss == SetTypeTwoSevens) && (word.length() != 7)) ||
-                ((ss == SetTypeTwoEights) && (word.length() != 8)))
-                return false;
-
-            bool ok = false;
-            QString alphagram = Auxil::getAlphagram(word);
-            int wi = 0;
-            QChar wc = alphagram[wi];
-            for (int ti = 0; ti < typeTwoCharsLen; ++ti) {
-                QChar tc = typeTwoChars[ti];
-                if (tc == wc) {
-                    ++wi;
-                    if (wi == alphagram.length()) {
-                        ok = true;
-                        break;
-                    }
-                    wc = alphagram[wi];
-                }
-            }
-            return (ok && !isSetMember(lexicon, word,
-                (ss == SetTypeTwoSevens ? SetTypeOneSevens : SetTypeOneEights)));
+            return DatabasePhase;
         }
+        else
+            return WordGraphPhase;
 
-        case SetTypeThreeSevens: {
-            if (word.length() != 7)
-                return false;
-
-            // ### For backward compatibility, set membership is calculated
-            // using probability calculated with two blanks - should make this
-            // customizable
-            double combos = letterBag.getNumCombinations(word, 2);
-            return ((combos >= typeThreeSevenCombos) &&
-                    !isSetMember(lexicon, word, SetTypeOneSevens) &&
-                    !isSetMember(lexicon, word, SetTypeTwoSevens));
+        case SearchCondition::BelongToGroup: {
+            SearchSet searchSet =
+                Auxil::stringToSearchSet(condition.stringValue);
+            if ((searchSet == SetHookWords) || (searchSet == SetFrontHooks) ||
+                (searchSet == SetBackHooks))
+            {
+                return DatabasePhase;
+            }
+            else
+                return PostConditionPhase;
         }
 
-        case SetTypeThreeEights: {
-            if (word.length() != 8)
-                return false;
+        default:
+        return UnknownPhase;
+    }
+}
 
-            // ### For backward compatibility, set membership is calculated
-            // using probability calculated with two blanks - should make this
-            // customizable
-            double combos = letterBag.getNumCombinations(word, 2);
-            return ((combos >= typeThreeEightCombos) &&
-                    !isSetMember(lexicon, word, SetTypeOneEights) &&
-                    !isSetMember(lexicon, word, SetTypeTwoEights));
-        }
+//---------------------------------------------------------------------------
+//  Lexicon::isAcceptable
+//
+//! Determine whether a word is acceptable in the lexicon.
+//
+//! @param word the word to look up
+//! @return true if acceptable, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::Lexicon::isAcceptable(const QString& word) const
+{
+    if (!data)
+        return false;
 
-        case SetEightsFromSevenLetterStems: {
-            if (word.length() != 8)
-                return false;
+    QReadLocker locker (&engine->lexiconLock);
+    return data->graph->containsWord(word);
+}
 
-            if (!lexiconData[lexicon]->stemAlphagrams.contains(word.length() - 1))
-                return false;
+//---------------------------------------------------------------------------
+//  Lexicon::areAcceptable
+//
+//! Determine whether each of a list of words is acceptable in the lexicon.
+//
+//! @param words the words to look up
+//! @return a bit for each word, set if the word is acceptable
+//---------------------------------------------------------------------------
+QBitArray
+WordEngine::Lexicon::areAcceptable(const QStringList& words) const
+{
+    if (!data)
+        return QBitArray(words.size());
 
-            QString agram = Auxil::getAlphagram(word);
-            const QSet<QString>& alphaSet =
-                lexiconData[lexicon]->stemAlphagrams[word.length() - 1];
+    QReadLocker locker (&engine->lexiconLock);
+    return data->graph->containsWords(words);
+}
 
-            for (int i = 0; i < int(agram.length()); ++i) {
-                if (alphaSet.contains(agram.left(i) +
-                                      agram.right(agram.length() - i - 1)))
-                {
-                    return true;
-                }
-            }
-            return false;
-        }
+//---------------------------------------------------------------------------
+//  Lexicon::getHooks
+//
+//! Find the letters A to Z that form acceptable words when added to the
+//! front or back of a word.
+//
+//! @param word the word, in upper case
+//! @param frontHooks returns the mask of front hook letters, with bit 0
+//! standing for A
+//! @param backHooks returns the mask of back hook letters
+//---------------------------------------------------------------------------
+void
+WordEngine::Lexicon::getHooks(const QString& word, quint32* frontHooks,
+                              quint32* backHooks) const
+{
+    *frontHooks = 0;
+    *backHooks = 0;
+    if (!data)
+        return;
 
-        default: return false;
-    }
+    QReadLocker locker (&engine->lexiconLock);
+    data->graph->hooks(word, frontHooks, backHooks);
 }
 
 //---------------------------------------------------------------------------
-//  getNumAnagrams
+//  Lexicon::getWordInfo
 //
-//! Determine the number of valid anagrams of a word.
+//! Get information about a word from the database, caching it for future
+//! queries - see WordEngine::getWordInfo.
 //
-//! @param lexicon the name of the lexicon
 //! @param word the word
-//! @return the number of valid anagrams
+//! @return information about the word from the database
 //---------------------------------------------------------------------------
-int
-WordEngine::getNumAnagrams(const QString& lexicon, const QString& word) const
+WordEngine::WordInfo
+WordEngine::Lexicon::getWordInfo(const QString& word) const
 {
-    if (!lexiconData.contains(lexicon))
-        return 0;
+    if (!data || word.isEmpty())
+        return WordInfo();
 
-    WordInfo info = getWordInfo(lexicon, word);
-    if (info.isValid()) {
-        return info.numAnagrams;
-    }
-    else {
-        QString alpha = Auxil::getAlphagram(word);
-        return lexiconData[lexicon]->numAnagramsMap.value(alpha);
-    }
+    QReadLocker locker (&engine->lexiconLock);
+
+    WordInfo info;
+    if (data->wordCache.find(word, &info))
+        return info;
+
+    engine->addToCache(name, QStringList(word));
+    return data->wordCache.value(word);
 }
 
 //---------------------------------------------------------------------------
-//  getPlayabilityValue
+//  Lexicon::getPlayabilityValue
 //
 //! Get the playability value for a word.
 //
-//! @param lexicon the name of the lexicon
 //! @param word the word
 //! @return the playability value
 //---------------------------------------------------------------------------
 qint64
-WordEngine::getPlayabilityValue(const QString& lexicon, const QString& word)
-    const
+WordEngine::Lexicon::getPlayabilityValue(const QString& word) const
 {
-    if (!lexiconData.contains(lexicon))
+    if (!data)
         return 0;
 
-    WordInfo info = getWordInfo(lexicon, word);
+    QReadLocker locker (&engine->lexiconLock);
+
+    int id = engine->getWordId(data, word);
+    if (id >= 0)
+        return data->attributes.playability[id];
+
+    WordInfo info = getWordInfo(word);
     return info.isValid() ? info.playability : 0;
 }
 
 //---------------------------------------------------------------------------
-//  getPlayabilityOrder
+//  WordInfoCache::contains
 //
-//! Get the playability order for a word.
+//! Determine whether the information for a word is in the cache.
 //
-//! @param lexicon the name of the lexicon
 //! @param word the word
-//! @return the playability order
+//! @return true if the word is in the cache, false otherwise
 //---------------------------------------------------------------------------
-int
-WordEngine::getPlayabilityOrder(const QString& lexicon, const QString& word)
-    const
+bool
+WordEngine::WordInfoCache::contains(const QString& word) const
 {
-    if (!lexiconData.contains(lexicon))
-        return 0;
-
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ? info.playabilityOrder.valueOrder : 0;
+    QMutexLocker locker (&mutex);
+    return cache.contains(word);
 }
 
 //---------------------------------------------------------------------------
-//  getMinPlayabilityOrder
+//  WordInfoCache::find
 //
-//! Get the minimum playability order for a word.
+//! Find the information for a word in the cache, and count the lookup as a
+//! hit or a miss.  The word becomes the most recently used.
 //
-//! @param lexicon the name of the lexicon
 //! @param word the word
-//! @return the playability order
+//! @param info returns the information if the word is in the cache
+//! @return true if the word is in the cache, false otherwise
 //---------------------------------------------------------------------------
-int
-WordEngine::getMinPlayabilityOrder(const QString& lexicon, const QString&
-                                   word) const
+bool
+WordEngine::WordInfoCache::find(const QString& word, WordInfo* info)
 {
-    if (!lexiconData.contains(lexicon))
-        return 0;
+    QMutexLocker locker (&mutex);
+    const WordInfo* cached = cache.object(word);
+    if (!cached) {
+        ++misses;
+        return false;
+    }
 
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ? info.playabilityOrder.minValueOrder : 0;
+    ++hits;
+    *info = *cached;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  WordInfoCache::value
+//
+//! Get the information for a word in the cache, without counting the
+//! lookup.
+//
+//! @param word the word
+//! @return the information, or invalid information if the word is not in
+//! the cache
+//---------------------------------------------------------------------------
+WordEngine::WordInfo
+WordEngine::WordInfoCache::value(const QString& word) const
+{
+    QMutexLocker locker (&mutex);
+    const WordInfo* info = cache.object(word);
+    return info ? *info : WordInfo();
 }
 
 //---------------------------------------------------------------------------
-//  getMaxPlayabilityOrder
+//  WordInfoCache::insert
 //
-//! Get the maximum playability order for a word.
+//! Add the information for a word to the cache, dropping the least recently
+//! used words if the cache would exceed its size limit.
 //
-//! @param lexicon the name of the lexicon
-//! @param word the word
-//! @return the playability order
+//! @param info the information
 //---------------------------------------------------------------------------
-int
-WordEngine::getMaxPlayabilityOrder(const QString& lexicon, const QString&
-                                   word) const
+void
+WordEngine::WordInfoCache::insert(const WordInfo& info)
 {
-    if (!lexiconData.contains(lexicon))
-        return 0;
+    QMutexLocker locker (&mutex);
+    int numWords = cache.size();
+    if (!cache.contains(info.word))
+        ++numWords;
+
+    // The cache takes ownership of the copy, deleting it if it is larger
+    // than the whole cache
+    if (!cache.insert(info.word, new WordInfo(info), getNumBytes(info)))
+        return;
 
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ? info.playabilityOrder.maxValueOrder : 0;
+    evictions += numWords - cache.size();
 }
 
 //---------------------------------------------------------------------------
-//  getProbabilityOrder
+//  WordInfoCache::setMaxBytes
 //
-//! Get the probability order for a word.
+//! Set the size limit of the cache, dropping the least recently used words
+//! if the cache exceeds the new limit.
 //
-//! @param lexicon the name of the lexicon
-//! @param word the word
-//! @param numBlanks the number of blanks
-//! @return the probability order
+//! @param maxBytes the size limit in bytes
 //---------------------------------------------------------------------------
-int
-WordEngine::getProbabilityOrder(const QString& lexicon, const QString& word,
-                                int numBlanks) const
+void
+WordEngine::WordInfoCache::setMaxBytes(int maxBytes)
 {
-    if (!lexiconData.contains(lexicon))
-        return 0;
+    QMutexLocker locker (&mutex);
+    int numWords = cache.size();
+    cache.setMaxCost(maxBytes);
+    evictions += numWords - cache.size();
+}
 
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ?
-        info.blankProbabilityOrder.value(numBlanks).valueOrder : 0;
+//---------------------------------------------------------------------------
+//  WordInfoCache::clear
+//
+//! Remove every word from the cache.
+//---------------------------------------------------------------------------
+void
+WordEngine::WordInfoCache::clear()
+{
+    QMutexLocker locker (&mutex);
+    cache.clear();
 }
 
 //---------------------------------------------------------------------------
-//  getMinProbabilityOrder
+//  WordInfoCache::save
 //
-//! Get the minimum probability order for a word.
+//! Save the words in the cache to a file.
 //
-//! @param lexicon the name of the lexicon
-//! @param word the word
-//! @param numBlanks the number of blanks
-//! @return the probability order
+//! @param filename the name of the file
+//! @param build the build of the database the words were read from
+//! @return true if successful, false otherwise
 //---------------------------------------------------------------------------
-int
-WordEngine::getMinProbabilityOrder(const QString& lexicon, const QString&
-                                   word, int numBlanks) const
+bool
+WordEngine::WordInfoCache::save(const QString& filename, const QString&
+                                build) const
 {
-    if (!lexiconData.contains(lexicon))
-        return 0;
+    QByteArray bytes;
+    QDataStream stream (&bytes, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_6);
+    {
+        QMutexLocker locker (&mutex);
+        QList<QString> words = cache.keys();
+        stream << WORD_CACHE_MAGIC << WORD_CACHE_VERSION << build
+            << qint32(words.size());
+
+        foreach (const QString& word, words) {
+            const WordInfo* info = cache.object(word);
+            stream << info->word << qint32(info->numVowels)
+                << qint32(info->numUniqueLetters)
+                << qint32(info->numAnagrams) << qint32(info->pointValue)
+                << info->frontHooks << info->backHooks << info->isFrontHook
+                << info->isBackHook << info->lexiconSymbols
+                << info->definition << info->playability;
+
+            const ValueOrder& order = info->playabilityOrder;
+            stream << qint32(order.valueOrder)
+                << qint32(order.minValueOrder)
+                << qint32(order.maxValueOrder);
+
+            stream << qint32(info->blankProbabilityOrder.size());
+            QMapIterator<int, ValueOrder> it (info->blankProbabilityOrder);
+            while (it.hasNext()) {
+                it.next();
+                stream << qint32(it.key()) << qint32(it.value().valueOrder)
+                    << qint32(it.value().minValueOrder)
+                    << qint32(it.value().maxValueOrder);
+            }
+        }
+    }
 
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ?
-        info.blankProbabilityOrder.value(numBlanks).minValueOrder : 0;
+    QDir dir;
+    dir.mkpath(QFileInfo(filename).absolutePath());
+
+    QFile file (filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    if (file.write(bytes) != bytes.size()) {
+        file.close();
+        QFile::remove(filename);
+        return false;
+    }
+
+    return true;
 }
 
 //---------------------------------------------------------------------------
-//  getMaxProbabilityOrder
+//  WordInfoCache::load
 //
-//! Get the maximum probability order for a word.
+//! Add the words saved to a file to the cache, if they were read from the
+//! same build of the database.  Words already in the cache are kept.
 //
-//! @param lexicon the name of the lexicon
-//! @param word the word
-//! @param numBlanks the number of blanks
-//! @return the probability order
+//! @param filename the name of the file
+//! @param build the build of the database
+//! @return the number of words added
 //---------------------------------------------------------------------------
 int
-WordEngine::getMaxProbabilityOrder(const QString& lexicon, const QString&
-                                   word, int numBlanks) const
+WordEngine::WordInfoCache::load(const QString& filename, const QString&
+                                build)
 {
-    if (!lexiconData.contains(lexicon))
+    QFile file (filename);
+    if (build.isEmpty() || !file.open(QIODevice::ReadOnly))
         return 0;
 
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ?
-        info.blankProbabilityOrder.value(numBlanks).maxValueOrder : 0;
+    QDataStream stream (&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString fileBuild;
+    qint32 numWords = 0;
+    stream >> magic >> version >> fileBuild >> numWords;
+    if ((stream.status() != QDataStream::Ok) || (magic != WORD_CACHE_MAGIC)
+        || (version != WORD_CACHE_VERSION) || (fileBuild != build))
+    {
+        return 0;
+    }
+
+    int numAdded = 0;
+    for (qint32 i = 0; i < numWords; ++i) {
+        WordInfo info;
+        qint32 numVowels, numUniqueLetters, numAnagrams, pointValue;
+        stream >> info.word >> numVowels >> numUniqueLetters >> numAnagrams
+            >> pointValue >> info.frontHooks >> info.backHooks
+            >> info.isFrontHook >> info.isBackHook >> info.lexiconSymbols
+            >> info.definition >> info.playability;
+        info.numVowels = numVowels;
+        info.numUniqueLetters = numUniqueLetters;
+        info.numAnagrams = numAnagrams;
+        info.pointValue = pointValue;
+
+        qint32 valueOrder, minValueOrder, maxValueOrder;
+        stream >> valueOrder >> minValueOrder >> maxValueOrder;
+        info.playabilityOrder.valueOrder = valueOrder;
+        info.playabilityOrder.minValueOrder = minValueOrder;
+        info.playabilityOrder.maxValueOrder = maxValueOrder;
+
+        qint32 numOrders = 0;
+        stream >> numOrders;
+        for (qint32 j = 0; j < numOrders; ++j) {
+            qint32 numBlanks;
+            stream >> numBlanks >> valueOrder >> minValueOrder
+                >> maxValueOrder;
+            ValueOrder& order = info.blankProbabilityOrder[numBlanks];
+            order.valueOrder = valueOrder;
+            order.minValueOrder = minValueOrder;
+            order.maxValueOrder = maxValueOrder;
+        }
+
+        if (stream.status() != QDataStream::Ok)
+            break;
+        if (!info.isValid() || contains(info.word))
+            continue;
+
+        insert(info);
+        ++numAdded;
+    }
+
+    return numAdded;
 }
 
 //---------------------------------------------------------------------------
-//  getNumVowels
+//  WordInfoCache::getNumBytes
 //
-//! Get the number of vowels in a word.
+//! Estimate the memory used by the cached information for a word.
 //
-//! @param lexicon the name of the lexicon
-//! @param word the word
-//! @return the number of vowels
+//! @param info the information
+//! @return the estimated number of bytes
 //---------------------------------------------------------------------------
 int
-WordEngine::getNumVowels(const QString& lexicon, const QString& word) const
+WordEngine::WordInfoCache::getNumBytes(const WordInfo& info) const
 {
-    // No test of lexiconData because we want to calculate if even not cached
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ? info.numVowels : Auxil::getNumVowels(word);
+    // The word is held both in the information and as the key
+    int numChars = 2 * info.word.length() + info.frontHooks.length() +
+        info.backHooks.length() + info.lexiconSymbols.length() +
+        info.definition.length();
+
+    return sizeof(WordInfo) + CACHE_ENTRY_BYTES +
+        (6 * CACHE_STRING_BYTES) + (numChars * int(sizeof(QChar))) +
+        (info.blankProbabilityOrder.size() *
+         (int(sizeof(ValueOrder)) + CACHE_MAP_NODE_BYTES));
 }
 
 //---------------------------------------------------------------------------
-//  getNumUniqueLetters
+//  OptimizedSpecCache::find
 //
-//! Get the number of unique letters in a word.
+//! Find an optimized search spec in the cache.  The spec becomes the most
+//! recently used.
 //
-//! @param lexicon the name of the lexicon
-//! @param word the word
-//! @return the number of unique letters
+//! @param key the canonical string of the spec before optimization
+//! @param spec returns the optimized spec if it is in the cache
+//! @return true if the spec is in the cache, false otherwise
 //---------------------------------------------------------------------------
-int
-WordEngine::getNumUniqueLetters(const QString& lexicon, const QString& word) const
+bool
+WordEngine::OptimizedSpecCache::find(const QString& key, OptimizedSpec* spec)
 {
-    // No test of lexiconData because we want to calculate if even not cached
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ? info.numUniqueLetters
-                          : Auxil::getNumUniqueLetters(word);
+    QMutexLocker locker (&mutex);
+    const OptimizedSpec* cached = cache.object(key);
+    if (!cached)
+        return false;
+
+    *spec = *cached;
+    return true;
 }
 
 //---------------------------------------------------------------------------
-//  getPointValue
+//  OptimizedSpecCache::insert
 //
-//! Get the point value for a word.
+//! Add an optimized search spec to the cache, dropping the least recently
+//! used spec if the cache is full.
 //
-//! @param lexicon the name of the lexicon
-//! @param word the word
-//! @return the point value
+//! @param key the canonical string of the spec before optimization
+//! @param spec the optimized spec
 //---------------------------------------------------------------------------
-int
-WordEngine::getPointValue(const QString& lexicon, const QString& word) const
+void
+WordEngine::OptimizedSpecCache::insert(const QString& key, const
+                                       OptimizedSpec& spec)
 {
-    if (!lexiconData.contains(lexicon))
-        return 0;
-
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ? info.pointValue : 0;
+    QMutexLocker locker (&mutex);
+    cache.insert(key, new OptimizedSpec(spec));
 }
 
 //---------------------------------------------------------------------------
-//  getIsFrontHook
-//
-//! Determine whether a word is a front hook.
+//  OptimizedSpecCache::clear
 //
-//! @param lexicon the name of the lexicon
-//! @param word the word
-//! @return true if the word is a front hook, false otherwise
+//! Remove every spec from the cache.
 //---------------------------------------------------------------------------
-bool
-WordEngine::getIsFrontHook(const QString& lexicon, const QString& word) const
+void
+WordEngine::OptimizedSpecCache::clear()
 {
-    if (!lexiconData.contains(lexicon))
-        return 0;
-
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ? info.isFrontHook : false;
+    QMutexLocker locker (&mutex);
+    cache.clear();
 }
 
 //---------------------------------------------------------------------------
-//  getIsBackHook
+//  SearchResultCache::find
 //
-//! Determine whether a word is a back hook.
+//! Find the results of a search in the cache, and count the lookup as a hit
+//! or a miss.  The search becomes the most recently used.  Results cached
+//! for a different search with the same hash count as a miss.
 //
-//! @param lexicon the name of the lexicon
-//! @param word the word
-//! @return true if the word is a back hook, false otherwise
+//! @param hash the hash of the search
+//! @param key the canonical key of the search
+//! @param words returns the results if the search is in the cache
+//! @return true if the search is in the cache, false otherwise
 //---------------------------------------------------------------------------
 bool
-WordEngine::getIsBackHook(const QString& lexicon, const QString& word) const
+WordEngine::SearchResultCache::find(quint64 hash, const QString& key,
+                                    QStringList* words)
 {
-    if (!lexiconData.contains(lexicon))
-        return 0;
+    QMutexLocker locker (&mutex);
+    const Entry* cached = cache.object(hash);
+    if (!cached || (cached->key != key)) {
+        ++misses;
+        return false;
+    }
 
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ? info.isBackHook : false;
+    ++hits;
+    *words = cached->words;
+    return true;
 }
 
 //---------------------------------------------------------------------------
-//  getLexiconSymbols
+//  SearchResultCache::insert
 //
-//! Get lexicon symbols to be displayed along with this word.
+//! Add the results of a search to the cache, dropping the least recently
+//! used searches if the cache would exceed its size limit.  Results cached
+//! for a different search with the same hash are replaced.
 //
-//! @param lexicon the name of the lexicon
-//! @param word the word
-//! @return a lexicon symbol string
+//! @param hash the hash of the search
+//! @param key the canonical key of the search
+//! @param words the results
 //---------------------------------------------------------------------------
-QString
-WordEngine::getLexiconSymbols(const QString& lexicon, const QString& word) const
+void
+WordEngine::SearchResultCache::insert(quint64 hash, const QString& key, const
+                                      QStringList& words)
 {
-    if (!lexiconData.contains(lexicon))
-        return 0;
+    QMutexLocker locker (&mutex);
+    int numSearches = cache.size();
+    if (!cache.contains(hash))
+        ++numSearches;
+
+    // The cache takes ownership of the entry, deleting it if it is larger
+    // than the whole cache
+    Entry* entry = new Entry;
+    entry->key = key;
+    entry->words = words;
+    if (!cache.insert(hash, entry, getNumBytes(key, words)))
+        return;
 
-    WordInfo info = getWordInfo(lexicon, word);
-    return info.isValid() ? info.lexiconSymbols : QString();
+    evictions += numSearches - cache.size();
 }
 
 //---------------------------------------------------------------------------
-//  nonGraphSearch
+//  SearchResultCache::setMaxBytes
 //
-//! Search for valid words matching conditions that can be matched without
-//! searching the word graph.
+//! Set the size limit of the cache, dropping the least recently used
+//! searches if the cache exceeds the new limit.
 //
-//! @param lexicon the name of the lexicon
-//! @param spec the search specification
-//! @return a list of acceptable words matching the In Word List conditions
+//! @param maxBytes the size limit in bytes
 //---------------------------------------------------------------------------
-QStringList
-WordEngine::nonGraphSearch(const QString& lexicon, const SearchSpec& spec) const
+void
+WordEngine::SearchResultCache::setMaxBytes(int maxBytes)
 {
-    QStringList wordList;
-    QSet<QString> finalWordSet;
-    int conditionNum = 0;
-
-    const int MAX_ANAGRAMS = 65535;
-    int minAnagrams = 0;
-    int maxAnagrams = MAX_ANAGRAMS;
-    int minNumVowels = 0;
-    int maxNumVowels = MAX_WORD_LEN;
-    int minNumUniqueLetters = 0;
-    int maxNumUniqueLetters = MAX_WORD_LEN;
-    int minPointValue = 0;
-    int maxPointValue = 10 * MAX_WORD_LEN;
-
-    // Look for InWordList conditions first, to narrow the search as much as
-    // possible
-    QListIterator<SearchCondition> it (spec.conditions);
-    while (it.hasNext()) {
-        const SearchCondition& condition = it.next();
-
-        // Note the minimum and maximum number of anagrams from any Number of
-        // Anagrams conditions
-        if (condition.type == SearchCondition::NumAnagrams) {
-            if ((condition.minValue > maxAnagrams) ||
-                (condition.maxValue < minAnagrams))
-                return wordList;
-            if (condition.minValue > minAnagrams)
-                minAnagrams = condition.minValue;
-            if (condition.maxValue < maxAnagrams)
-                maxAnagrams = condition.maxValue;
-        }
-
-        // Note the minimum and maximum number of vowels from any Number of
-        // Vowels conditions
-        else if (condition.type == SearchCondition::NumVowels) {
-            if ((condition.minValue > maxNumVowels) ||
-                (condition.maxValue < minNumVowels))
-                return wordList;
-            if (condition.minValue > minNumVowels)
-                minNumVowels = condition.minValue;
-            if (condition.maxValue < maxNumVowels)
-                maxNumVowels = condition.maxValue;
-        }
-
-        // Note the minimum and maximum number of unique letters from any
-        // Number of Unique Letters conditions
-        else if (condition.type == SearchCondition::NumUniqueLetters) {
-            if ((condition.minValue > maxNumUniqueLetters) ||
-                (condition.maxValue < minNumUniqueLetters))
-                return wordList;
-            if (condition.minValue > minNumUniqueLetters)
-                minNumUniqueLetters = condition.minValue;
-            if (condition.maxValue < maxNumUniqueLetters)
-                maxNumUniqueLetters = condition.maxValue;
-        }
+    QMutexLocker locker (&mutex);
+    int numSearches = cache.size();
+    cache.setMaxCost(maxBytes);
+    evictions += numSearches - cache.size();
+}
 
-        // Note the minimum and maximum point value from any Point Value
-        // conditions
-        else if (condition.type == SearchCondition::PointValue) {
-            if ((condition.minValue > maxPointValue) ||
-                (condition.maxValue < minPointValue))
-                return wordList;
-            if (condition.minValue > minPointValue)
-                minPointValue = condition.minValue;
-            if (condition.maxValue < maxPointValue)
-                maxPointValue = condition.maxValue;
-        }
+//---------------------------------------------------------------------------
+//  SearchResultCache::clear
+//
+//! Remove every search from the cache.
+//---------------------------------------------------------------------------
+void
+WordEngine::SearchResultCache::clear()
+{
+    QMutexLocker locker (&mutex);
+    cache.clear();
+}
 
-        // Only InWordList conditions allowed beyond this point - look up
-        // words for acceptability and combine the word lists
-        if (condition.type != SearchCondition::InWordList)
-            continue;
+//---------------------------------------------------------------------------
+//  SearchResultCache::getNumBytes
+//
+//! Estimate the memory used by the cached results of a search.
+//
+//! @param key the canonical key of the search
+//! @param words the results
+//! @return the estimated number of bytes
+//---------------------------------------------------------------------------
+int
+WordEngine::SearchResultCache::getNumBytes(const QString& key, const
+                                           QStringList& words) const
+{
+    int numChars = key.length();
+    foreach (const QString& word, words)
+        numChars += word.length();
 
-        QStringList words = condition.stringValue.split(QChar(' '));
-        QSet<QString> wordSet;
-        QStringListIterator wit (words);
-        while (wit.hasNext()) {
-            QString word = wit.next();
-            if (isAcceptable(lexicon, word))
-                wordSet.insert(word);
-        }
+    return SEARCH_CACHE_ENTRY_BYTES + (words.size() * SEARCH_CACHE_WORD_BYTES)
+        + (numChars * int(sizeof(QChar)));
+}
 
-        // Combine search result set with words already found
-        if (!conditionNum) {
-            finalWordSet = wordSet;
-        }
+//---------------------------------------------------------------------------
+//  DefinitionCache::find
+//
+//! Find the definition of a word in the cache.
+//
+//! @param word the word
+//! @param replaceLinks whether links in the definition are replaced
+//! @param definition returns the definition if found
+//! @return true if the definition is in the cache, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::DefinitionCache::find(const QString& word, bool replaceLinks,
+                                  QString* definition)
+{
+    QMutexLocker locker (&mutex);
+    const QString* cached = cache.object(getKey(word, replaceLinks));
+    if (!cached)
+        return false;
 
-        else if (spec.conjunction) {
-            QSet<QString> conjunctionSet = finalWordSet & wordSet;
-            if (conjunctionSet.isEmpty())
-                return wordList;
-            finalWordSet = conjunctionSet;
-        }
+    *definition = *cached;
+    return true;
+}
 
-        else {
-            finalWordSet += wordSet;
-        }
+//---------------------------------------------------------------------------
+//  DefinitionCache::insert
+//
+//! Add the definition of a word to the cache, dropping the least recently
+//! used definitions if the cache would exceed its size limit.
+//
+//! @param word the word
+//! @param replaceLinks whether links in the definition are replaced
+//! @param definition the definition
+//---------------------------------------------------------------------------
+void
+WordEngine::DefinitionCache::insert(const QString& word, bool replaceLinks,
+                                    const QString& definition)
+{
+    QMutexLocker locker (&mutex);
+    QString key = getKey(word, replaceLinks);
+    int numBytes = DEFINITION_CACHE_ENTRY_BYTES +
+        ((key.length() + definition.length()) * int(sizeof(QChar)));
+    cache.insert(key, new QString(definition), numBytes);
+}
 
-        ++conditionNum;
-    }
+//---------------------------------------------------------------------------
+//  DefinitionCache::clear
+//
+//! Remove every definition from the cache.
+//---------------------------------------------------------------------------
+void
+WordEngine::DefinitionCache::clear()
+{
+    QMutexLocker locker (&mutex);
+    cache.clear();
+}
 
-    // Now limit the set only to those words containing the requisite number
-    // of anagrams.  If some words are already in the finalWordSet, then only
-    // test those words.  Otherwise, run through the map of number of anagrams
-    // and pull out all words matching the conditions.
-    if (!finalWordSet.isEmpty() &&
-        ((minAnagrams > 0) || (maxAnagrams < MAX_ANAGRAMS)) ||
-        ((minNumVowels > 0) || (maxNumVowels < MAX_WORD_LEN)) ||
-        ((minNumUniqueLetters > 0) || (maxNumUniqueLetters < MAX_WORD_LEN)) ||
-        ((minPointValue > 0) || (minPointValue < 10 * MAX_WORD_LEN)))
-    {
-        bool testAnagrams = ((minAnagrams > 0) ||
-                             (maxAnagrams < MAX_ANAGRAMS));
-        bool testNumVowels = ((minNumVowels > 0) ||
-                              (maxNumVowels < MAX_WORD_LEN));
-        bool testNumUniqueLetters = ((minNumUniqueLetters > 0) ||
-                                     (maxNumUniqueLetters < MAX_WORD_LEN));
-        bool testPointValue = ((minPointValue > 0) ||
-                               (minPointValue < 10 * MAX_WORD_LEN));
+//---------------------------------------------------------------------------
+//  CombinationCache::find
+//
+//! Find the number of combinations of an alphagram in the cache.
+//
+//! @param alphagramKey the packed alphagram key
+//! @param numBlanks the number of blanks
+//! @param combinations returns the number of combinations if found
+//! @return true if the number is in the cache, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::CombinationCache::find(quint64 alphagramKey, int numBlanks,
+                                   double* combinations)
+{
+    QMutexLocker locker (&mutex);
+    QHash<quint64, double>::const_iterator it =
+        cache.constFind(alphagramKey | quint64(numBlanks));
+    if (it == cache.constEnd())
+        return false;
 
-        QSet<QString> wordSet;
-        QSetIterator<QString> it (finalWordSet);
-        while (it.hasNext()) {
-            QString word = it.next();
+    *combinations = it.value();
+    return true;
+}
 
-            if (testAnagrams) {
-                int numAnagrams = getNumAnagrams(lexicon, word);
-                if ((numAnagrams < minAnagrams) || (numAnagrams > maxAnagrams))
-                    continue;
-            }
+//---------------------------------------------------------------------------
+//  CombinationCache::insert
+//
+//! Add the number of combinations of an alphagram to the cache.
+//
+//! @param alphagramKey the packed alphagram key
+//! @param numBlanks the number of blanks
+//! @param combinations the number of combinations
+//---------------------------------------------------------------------------
+void
+WordEngine::CombinationCache::insert(quint64 alphagramKey, int numBlanks,
+                                     double combinations)
+{
+    QMutexLocker locker (&mutex);
+    cache.insert(alphagramKey | quint64(numBlanks), combinations);
+}
 
-            if (testNumVowels) {
-                int numVowels = getNumVowels(lexicon, word);
-                if ((numVowels < minNumVowels) || (numVowels > maxNumVowels))
-                    continue;
-            }
+//---------------------------------------------------------------------------
+//  CombinationCache::clear
+//
+//! Remove every number from the cache.
+//---------------------------------------------------------------------------
+void
+WordEngine::CombinationCache::clear()
+{
+    QMutexLocker locker (&mutex);
+    cache.clear();
+}
 
-            if (testNumUniqueLetters) {
-                int numUniqueLetters = getNumUniqueLetters(lexicon, word);
-                if ((numUniqueLetters < minNumUniqueLetters) ||
-                    (numUniqueLetters > maxNumUniqueLetters))
-                    continue;
-            }
+//---------------------------------------------------------------------------
+//  WordListFileCache::getWords
+//
+//! Get the words of a text word list file, reading the file if it has not
+//! been read or has changed since it was read.
+//
+//! @param filename the name of the file
+//! @param words returns the distinct words of the file, in the order they
+//! first appear
+//! @param wordSet if not null, returns the set of words of the file
+//! @return true if successful, false if the file cannot be read or is a
+//! word ID list file
+//---------------------------------------------------------------------------
+bool
+WordEngine::WordListFileCache::getWords(const QString& filename, QStringList*
+                                        words, QSet<QString>* wordSet)
+{
+    QMutexLocker locker (&mutex);
+    const Entry* entry = findEntry(filename);
+    if (!entry || entry->isIdList)
+        return false;
 
-            if (testPointValue) {
-                int pointValue = getPointValue(lexicon, word);
-                if ((pointValue < minPointValue) ||
-                    (pointValue > maxPointValue))
-                    continue;
-            }
+    *words = entry->words;
+    if (wordSet)
+        *wordSet = entry->wordSet;
+    return true;
+}
 
-            wordSet.insert(word);
-        }
-        finalWordSet = wordSet;
-    }
+//---------------------------------------------------------------------------
+//  WordListFileCache::getWordIds
+//
+//! Get the word IDs of a word ID list file, reading the file if it has not
+//! been read or has changed since it was read.
+//
+//! @param filename the name of the file
+//! @param idList returns the word ID list
+//! @return true if successful, false if the file cannot be read or is not
+//! a word ID list file
+//---------------------------------------------------------------------------
+bool
+WordEngine::WordListFileCache::getWordIds(const QString& filename,
+                                          WordIdList* idList)
+{
+    QMutexLocker locker (&mutex);
+    const Entry* entry = findEntry(filename);
+    if (!entry || !entry->isIdList)
+        return false;
 
-    return finalWordSet.toList();
+    *idList = entry->idList;
+    return true;
 }
 
 //---------------------------------------------------------------------------
-//  addDefinition
+//  WordListFileCache::findEntry
 //
-//! Add a word with its definition.  Parse the definition and separate its
-//! parts of speech.
+//! Find the entry of a word list file, reading the file if it has not been
+//! read or has changed since it was read.  The mutex must be held.
 //
-//! @param lexicon the name of the lexicon
-//! @param word the word
-//! @param definition the definition
+//! @param filename the name of the file
+//! @return the entry, or 0 if the file cannot be read
 //---------------------------------------------------------------------------
-void
-WordEngine::addDefinition(const QString& lexicon, const QString& word,
-                          const QString& definition)
+const WordEngine::WordListFileCache::Entry*
+WordEngine::WordListFileCache::findEntry(const QString& filename)
 {
-    if (word.isEmpty() || definition.isEmpty() ||
-        !lexiconData.contains(lexicon))
-    {
-        return;
+    QFileInfo info (filename);
+    if (!info.exists()) {
+        entries.remove(filename);
+        return 0;
     }
 
-    QRegExp posRegex (QString("\\[(\\w+)"));
-    QMultiMap<QString, QString> defMap;
-    QStringList defs = definition.split(DEF_ORIG_SEP);
-    foreach (const QString& def, defs) {
-        QString pos;
-        if (posRegex.indexIn(def, 0) >= 0) {
-            pos = posRegex.cap(1);
+    QHash<QString, Entry>::iterator it = entries.find(filename);
+    if ((it == entries.end()) || (it.value().size != info.size()) ||
+        (it.value().modified != info.lastModified()))
+    {
+        Entry entry;
+        if (!readFile(filename, &entry)) {
+            entries.remove(filename);
+            return 0;
         }
-        defMap.insert(pos, def);
+        entry.size = info.size();
+        entry.modified = info.lastModified();
+        it = entries.insert(filename, entry);
     }
-    lexiconData[lexicon]->definitions.insert(word, defMap);
+    return &it.value();
 }
 
 //---------------------------------------------------------------------------
-//  getConditionPhase
+//  WordListFileCache::getStamp
 //
-//! Determine the search phase during which a search condition should be
-//! considered.
+//! Get a string that changes whenever a word list file changes, made of its
+//! size and modification time.
 //
-//! @param condition the search condition
-//! @return the appropriate search phase
+//! @param filename the name of the file
+//! @return the stamp
 //---------------------------------------------------------------------------
-WordEngine::ConditionPhase
-WordEngine::getConditionPhase(const SearchCondition& condition) const
+QString
+WordEngine::WordListFileCache::getStamp(const QString& filename) const
 {
-    switch (condition.type) {
-        case SearchCondition::AnagramMatch:
-        case SearchCondition::SubanagramMatch:
-        case SearchCondition::ConsistOf:
-        return WordGraphPhase;
+    QFileInfo info (filename);
+    if (!info.exists())
+        return QString("[]");
+    return QString("[%1:%2]").arg(info.size())
+        .arg(info.lastModified().toTime_t());
+}
 
-        case SearchCondition::Length:
-        case SearchCondition::InWordList:
-        case SearchCondition::NumVowels:
-        case SearchCondition::IncludeLetters:
-        case SearchCondition::ProbabilityOrder:
-        case SearchCondition::PlayabilityOrder:
-        case SearchCondition::NumUniqueLetters:
-        case SearchCondition::PointValue:
-        case SearchCondition::NumAnagrams:
-        case SearchCondition::PartOfSpeech:
-        case SearchCondition::Definition:
-        return DatabasePhase;
+//---------------------------------------------------------------------------
+//  WordListFileCache::clear
+//
+//! Remove every word list from the cache.
+//---------------------------------------------------------------------------
+void
+WordEngine::WordListFileCache::clear()
+{
+    QMutexLocker locker (&mutex);
+    entries.clear();
+}
 
-        case SearchCondition::Prefix:
-        case SearchCondition::Suffix:
-        case SearchCondition::InLexicon:
-        case SearchCondition::LimitByProbabilityOrder:
-        case SearchCondition::LimitByPlayabilityOrder:
-        return PostConditionPhase;
+//---------------------------------------------------------------------------
+//  WordListFileCache::readFile
+//
+//! Read a word list file.  Word ID list files are read as IDs.  Text files
+//! are read a line at a time, so even very large files are never held in
+//! memory whole.  The first word of each line is used, and empty lines and
+//! lines starting with '#' are skipped.  Each distinct word is held once,
+//! shared by the list and the set of words.
+//
+//! @param filename the name of the file
+//! @param entry returns the words of the file
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngine::WordListFileCache::readFile(const QString& filename, Entry*
+                                        entry) const
+{
+    if (WordIdList::isWordIdFile(filename)) {
+        entry->isIdList = true;
+        return entry->idList.readFile(filename);
+    }
 
-        case SearchCondition::PatternMatch:
-        if (condition.stringValue.startsWith("*") &&
-            condition.stringValue.endsWith("*") &&
-            !condition.stringValue.contains("["))
-        {
-            return DatabasePhase;
-        }
-        else
-            return WordGraphPhase;
+    QFile file (filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
 
-        case SearchCondition::BelongToGroup: {
-            SearchSet searchSet =
-                Auxil::stringToSearchSet(condition.stringValue);
-            if ((searchSet == SetHookWords) || (searchSet == SetFrontHooks) ||
-                (searchSet == SetBackHooks))
-            {
-                return DatabasePhase;
-            }
-            else
-                return PostConditionPhase;
-        }
+    char* buffer = new char[MAX_INPUT_LINE_LEN + 1];
+    bool readNewline = true;
+    while (file.readLine(buffer, MAX_INPUT_LINE_LEN) > 0) {
+        QString line (buffer);
 
-        default:
-        return UnknownPhase;
+        // If first line didn't contain newline, skip subsequent reads
+        // until we see a newline (effectively truncating long lines)
+        bool skip = !readNewline;
+        readNewline = (line.right(1) == QString("\n"));
+        if (skip)
+            continue;
+
+        line = line.simplified();
+        if (line.isEmpty() || (line.at(0) == '#'))
+            continue;
+        QString word = line.section(' ', 0, 0).toUpper();
+        if (entry->wordSet.contains(word))
+            continue;
+        entry->wordSet.insert(word);
+        entry->words.append(word);
+    }
+    delete[] buffer;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  SearchProfile::toString
+//
+//! Describe the phases of a search in a single line, with the time taken
+//! and the number of words entering and leaving each phase.
+//
+//! @return the description
+//---------------------------------------------------------------------------
+QString
+WordEngine::SearchProfile::toString() const
+{
+    QStringList phaseStrings;
+    foreach (const Phase& phase, phases) {
+        QString str = phase.name + QString(" %1 ms").arg(phase.msecs);
+        if (phase.numOut >= 0) {
+            QString inStr = (phase.numIn >= 0) ? QString::number(phase.numIn)
+                                               : QString("all");
+            str += QString(" (%1 -> %2)").arg(inStr).arg(phase.numOut);
+        }
+        phaseStrings.append(str);
     }
+    return phaseStrings.join(", ");
+}
+
+//---------------------------------------------------------------------------
+//  WordAttributes::clear
+//
+//! Remove the attributes of all words.
+//---------------------------------------------------------------------------
+void
+WordEngine::WordAttributes::clear()
+{
+    flags.clear();
+    numVowels.clear();
+    numUniqueLetters.clear();
+    numAnagrams.clear();
+    pointValue.clear();
+    playability.clear();
+    playabilityOrders.clear();
+    probabilityOrders.clear();
+}
+
+//---------------------------------------------------------------------------
+//  WordAttributes::resize
+//
+//! Make room for the attributes of a number of words, with no word marked
+//! valid.
+//
+//! @param numWords the number of words
+//---------------------------------------------------------------------------
+void
+WordEngine::WordAttributes::resize(int numWords)
+{
+    flags.fill(0, numWords);
+    numVowels.fill(0, numWords);
+    numUniqueLetters.fill(0, numWords);
+    numAnagrams.fill(0, numWords);
+    pointValue.fill(0, numWords);
+    playability.fill(0, numWords);
+    playabilityOrders.fill(0, 3 * numWords);
+    probabilityOrders.fill(0, 9 * numWords);
 }
@@ -25,15 +25,30 @@
 #ifndef ZYZZYVA_WORD_ENGINE_H
 #define ZYZZYVA_WORD_ENGINE_H
 
+#include "CompactWord.h"
+#include "JobScheduler.h"
+#include "SearchStats.h"
 #include "WordGraph.h"
+#include "WordIdList.h"
+#include <QBitArray>
+#include <QCache>
+#include <QDateTime>
+#include <QHash>
 #include <QMap>
 #include <QMultiMap>
+#include <QMutex>
+#include <QReadWriteLock>
 #include <QSet>
 #include <QString>
 #include <QStringList>
 #include <QSqlDatabase>
+#include <QTime>
+#include <QVector>
 #include <stdint.h>
 
+class LexiconSnapshot;
+class QSqlQuery;
+
 class WordEngine : public QObject
 {
     Q_OBJECT
@@ -75,49 +90,571 @@ class WordEngine : public QObject
         QMap<int, ValueOrder> blankProbabilityOrder;
     };
 
+    // Word information cache limited to a number of bytes.  The least
+    // recently used words are dropped first when the limit is reached.  The
+    // cache can be used from more than one thread, but the sizes and counts
+    // are only approximate while other threads use it.  The cached words
+    // can be saved to a file and read back in a later session, tagged with
+    // the build of the database they were read from.
+    class WordInfoCache {
+        public:
+        WordInfoCache(int maxBytes = 64 * 1024 * 1024)
+            : cache(maxBytes), hits(0), misses(0), evictions(0) { }
+        ~WordInfoCache() { }
+
+        bool contains(const QString& word) const;
+        bool find(const QString& word, WordInfo* info);
+        WordInfo value(const QString& word) const;
+        void insert(const WordInfo& info);
+        void clear();
+        bool save(const QString& filename, const QString& build) const;
+        int load(const QString& filename, const QString& build);
+        int getMaxBytes() const { return cache.maxCost(); }
+        void setMaxBytes(int maxBytes);
+        int getBytes() const { return cache.totalCost(); }
+        int getNumWords() const { return cache.size(); }
+        int getHits() const { return hits; }
+        int getMisses() const { return misses; }
+        int getEvictions() const { return evictions; }
+
+        private:
+        int getNumBytes(const WordInfo& info) const;
+
+        mutable QMutex mutex;
+        QCache<QString, WordInfo> cache;
+        int hits;
+        int misses;
+        int evictions;
+    };
+
+    // A search spec after optimization, with the canonical string of the
+    // optimized spec and its hash, which together key the search result
+    // cache
+    class OptimizedSpec {
+        public:
+        OptimizedSpec() : hash(0) { }
+        SearchSpec spec;
+        QString key;
+        quint64 hash;
+    };
+
+    // Word lists read from files by In Word List conditions, keyed by file
+    // name.  Each file is read once, and read again only if its size or
+    // modification time changes.  Text files are held as words, and word ID
+    // list files as IDs.  It can be used from more than one thread.
+    class WordListFileCache {
+        public:
+        WordListFileCache() { }
+        ~WordListFileCache() { }
+
+        bool getWords(const QString& filename, QStringList* words,
+                      QSet<QString>* wordSet = 0);
+        bool getWordIds(const QString& filename, WordIdList* idList);
+        QString getStamp(const QString& filename) const;
+        void clear();
+
+        private:
+        class Entry {
+            public:
+            Entry() : size(-1), isIdList(false) { }
+            qint64 size;
+            QDateTime modified;
+            bool isIdList;
+            QStringList words;
+            QSet<QString> wordSet;
+            WordIdList idList;
+        };
+
+        const Entry* findEntry(const QString& filename);
+        bool readFile(const QString& filename, Entry* entry) const;
+
+        mutable QMutex mutex;
+        QHash<QString, Entry> entries;
+    };
+
+    // A post condition compiled for testing many words.  The word graph,
+    // search set or set members it uses are found once, when the conditions
+    // of a search are compiled, and each condition has an estimated cost so
+    // the cheapest conditions are tested first.
+    class PostConditionOp {
+        public:
+        PostConditionOp() : type(SearchCondition::UnknownSearchType),
+                            negated(false), graph(0),
+                            searchSet(UnknownSearchSet), cost(0) { }
+        SearchCondition::SearchType type;
+        bool negated;
+        QString stringValue;
+        const WordGraph* graph;
+        SearchSet searchSet;
+        QBitArray members;
+        int cost;
+    };
+
+    // Optimized search specs limited to a number of specs, keyed by the
+    // canonical string of each spec before optimization.  Optimizing a spec
+    // only depends on the spec, the name of the lexicon and the search
+    // statistics of its database, so repeated searches are not optimized
+    // again until the database changes.  It can be used from more than one
+    // thread.
+    class OptimizedSpecCache {
+        public:
+        OptimizedSpecCache(int maxSpecs = 1024) : cache(maxSpecs) { }
+        ~OptimizedSpecCache() { }
+
+        bool find(const QString& key, OptimizedSpec* spec);
+        void insert(const QString& key, const OptimizedSpec& spec);
+        void clear();
+        int getNumSpecs() const { return cache.size(); }
+
+        private:
+        mutable QMutex mutex;
+        QCache<QString, OptimizedSpec> cache;
+    };
+
+    // Search result cache limited to a number of bytes, keyed by the hash
+    // of the canonical string of each optimized search spec.  The string is
+    // kept with the results, so a search whose hash collides with another
+    // search is not mistaken for it.  The least recently used results are
+    // dropped first when the limit is reached.  Like the word information
+    // cache, it can be used from more than one thread.
+    class SearchResultCache {
+        public:
+        SearchResultCache(int maxBytes = 16 * 1024 * 1024)
+            : cache(maxBytes), hits(0), misses(0), evictions(0) { }
+        ~SearchResultCache() { }
+
+        bool find(quint64 hash, const QString& key, QStringList* words);
+        void insert(quint64 hash, const QString& key, const QStringList&
+                    words);
+        void clear();
+        int getMaxBytes() const { return cache.maxCost(); }
+        void setMaxBytes(int maxBytes);
+        int getBytes() const { return cache.totalCost(); }
+        int getNumSearches() const { return cache.size(); }
+        int getHits() const { return hits; }
+        int getMisses() const { return misses; }
+        int getEvictions() const { return evictions; }
+
+        private:
+        class Entry {
+            public:
+            QString key;
+            QStringList words;
+        };
+
+        int getNumBytes(const QString& key, const QStringList& words) const;
+
+        mutable QMutex mutex;
+        QCache<quint64, Entry> cache;
+        int hits;
+        int misses;
+        int evictions;
+    };
+
+    // Display-ready definitions limited to a number of bytes, keyed by word
+    // and whether links are replaced.  Unlike the word information cache,
+    // it is not cleared by each search, so definitions shown repeatedly are
+    // not looked up and processed again.  It can be used from more than one
+    // thread.
+    class DefinitionCache {
+        public:
+        DefinitionCache(int maxBytes = 4 * 1024 * 1024)
+            : cache(maxBytes) { }
+        ~DefinitionCache() { }
+
+        bool find(const QString& word, bool replaceLinks, QString*
+                  definition);
+        void insert(const QString& word, bool replaceLinks, const QString&
+                    definition);
+        void clear();
+        int getBytes() const { return cache.totalCost(); }
+
+        private:
+        QString getKey(const QString& word, bool replaceLinks) const {
+            return QString(replaceLinks ? "L" : "O") + word; }
+
+        QMutex mutex;
+        QCache<QString, QString> cache;
+    };
+
+    // Numbers of ways of drawing alphagrams from a full bag, keyed by packed
+    // alphagram key and number of blanks.  Anagrams share their counts, so
+    // each alphagram is only looked up or calculated once.  It can be used
+    // from more than one thread.
+    class CombinationCache {
+        public:
+        CombinationCache() { }
+        ~CombinationCache() { }
+
+        bool find(quint64 alphagramKey, int numBlanks, double*
+                  combinations);
+        void insert(quint64 alphagramKey, int numBlanks, double
+                    combinations);
+        void clear();
+        int getNumEntries() const { return cache.size(); }
+
+        // Packed alphagram keys leave their lowest bits free to hold the
+        // number of blanks
+        static bool canCache(quint64 alphagramKey, int numBlanks) {
+            return alphagramKey && (numBlanks >= 0) &&
+                   (numBlanks <= MAX_NUM_BLANKS); }
+
+        private:
+        static const int MAX_NUM_BLANKS = 15;
+
+        QMutex mutex;
+        QHash<quint64, double> cache;
+    };
+
+    // Wall time and candidate counts of each phase of a search, recorded if
+    // search profiling is enabled.  A count of -1 means the phase did not
+    // start from a list of candidates, or passed its words on without
+    // counting them.
+    class SearchProfile {
+        public:
+        class Phase {
+            public:
+            Phase(const QString& n = QString(), int ms = 0, int in = -1,
+                  int out = -1, const QString& q = QString())
+                : name(n), msecs(ms), numIn(in), numOut(out), query(q) { }
+
+            QString name;
+            int msecs;
+            int numIn;
+            int numOut;
+            QString query;
+        };
+
+        public:
+        SearchProfile() : msecs(0) { }
+        ~SearchProfile() { }
+
+        bool isEmpty() const { return phases.isEmpty(); }
+        QString toString() const;
+
+        QString lexicon;
+        QString spec;
+        int msecs;
+        QList<Phase> phases;
+    };
+
+    // Numeric word attributes from the database, held in one array for each
+    // attribute and indexed by the alphabetical index of each word in the
+    // word graph.  Playability orders are held in groups of three: the
+    // order, minimum order and maximum order.  Probability orders are held
+    // in groups of nine: three orders for each number of blanks from 0 to 2.
+    class WordAttributes {
+        public:
+        enum Flag {
+            ValidFlag = 1,
+            FrontHookFlag = 2,
+            BackHookFlag = 4
+        };
+
+        public:
+        WordAttributes() { }
+        ~WordAttributes() { }
+
+        bool isEmpty() const { return flags.isEmpty(); }
+        void clear();
+        void resize(int numWords);
+
+        QVector<quint8> flags;
+        QVector<quint8> numVowels;
+        QVector<quint8> numUniqueLetters;
+        QVector<quint8> numAnagrams;
+        QVector<quint8> pointValue;
+        QVector<qint64> playability;
+        QVector<qint32> playabilityOrders;
+        QVector<qint32> probabilityOrders;
+    };
+
+    // Sort key of a word for Limit by Probability/Playability Order
+    // conditions - words with higher values come first, then words are
+    // ordered by alphagram if one is given, then alphabetically.  The index
+    // is the position of the word in the list being limited.
+    class LimitKey {
+        public:
+        LimitKey(qint64 v = 0, const QString& a = QString(),
+                 const QString& w = QString(), int i = 0)
+            : value(v), alphagram(a), word(w), index(i) { }
+        bool operator<(const LimitKey& other) const {
+            if (value != other.value)
+                return value > other.value;
+            if (alphagram != other.alphagram)
+                return alphagram < other.alphagram;
+            if (word != other.word)
+                return word < other.word;
+            return index < other.index;
+        }
+
+        qint64 value;
+        QString alphagram;
+        QString word;
+        int index;
+    };
+
+    // Words of a lexicon grouped by alphagram.  Each alphagram maps to the
+    // start and end of its group in a list of the alphabetical indexes of
+    // the words, so the anagrams of a word can be found in one lookup.
+    class AnagramIndex {
+        public:
+        AnagramIndex() { }
+        ~AnagramIndex() { }
+
+        bool isEmpty() const { return wordIds.isEmpty(); }
+        void clear() { groups.clear(); wordIds.clear(); letters.clear(); }
+
+        QHash<QString, QPair<qint32, qint32> > groups;
+        QVector<qint32> wordIds;
+
+        // The letters found in the words, in alphagram order
+        QString letters;
+    };
+
+    // Words formed by adding one letter to the stems of one length, found in
+    // the anagram index when the stems or the word graph are loaded.  Each
+    // stem alphagram maps to the sorted alphabetical indexes of its words,
+    // and each word index to the alphagrams of the stems it is formed from,
+    // so stem sets and the words of a stem are found in one lookup.
+    class StemIndex {
+        public:
+        StemIndex() { }
+        ~StemIndex() { }
+
+        bool isEmpty() const { return wordStems.isEmpty(); }
+        void clear() { stemWords.clear(); wordStems.clear(); }
+
+        QHash<QString, QVector<qint32> > stemWords;
+        QHash<qint32, QStringList> wordStems;
+    };
+
+    // Lower case tokens found in definitions, each mapped to the sorted
+    // alphabetical indexes of the words whose definitions contain it.  Used
+    // to find the few words whose definitions can match a Definition or
+    // Part of Speech condition - see getDefinitionCandidates.
+    class DefinitionIndex {
+        public:
+        DefinitionIndex() : loaded(false) { }
+        ~DefinitionIndex() { }
+
+        void clear() { loaded = false; tokenWords.clear(); }
+
+        bool loaded;
+        QHash<QString, QVector<qint32> > tokenWords;
+    };
+
+    // Database connection used by one thread, with its prepared statements
+    // looking up one word or a chunk of words for the word cache, and the
+    // playability values of a chunk of words - see getCacheQuery and
+    // getPlayabilityQuery
+    class DatabaseConnection {
+        public:
+        DatabaseConnection() : db(0), cloned(false), cacheWordQuery(0),
+                               cacheChunkQuery(0), playabilityQuery(0) { }
+
+        public:
+        QSqlDatabase* db;
+        QString name;
+        bool cloned;
+        QSqlQuery* cacheWordQuery;
+        QSqlQuery* cacheChunkQuery;
+        QSqlQuery* playabilityQuery;
+    };
+
+    // Job creating deferred database indexes in the background, through
+    // its own connection - see requireIndexSets
+    class IndexJob;
+
+    // Job reading the word cache saved in an earlier session in the
+    // background - see startWordCacheJob
+    class WordCacheJob;
+
+    // Job ordering the words of each length by probability - see
+    // getProbabilityOrderTable
+    class ProbabilityOrderJob;
+
+    // Estimated memory used by one structure of a lexicon - see
+    // memoryReport
+    typedef WordGraph::MemoryUsage MemoryUsage;
+
     class LexiconData {
         public:
-        LexiconData() : graph(0), db(0) { }
+        LexiconData() : graph(0), db(0), snapshot(0), dbThread(0) { }
 
         public:
         QString name;
         QString lexiconFile;
-        QMap<QString, QMultiMap<QString, QString> > definitions;
-        QMap<int, QStringList> stems;
-        QMap<QString, int> numAnagramsMap;
-        QMap<QString, qint64> playabilityMap;
-        QMap<int, QSet<QString> > stemAlphagrams;
-        mutable QMap<QString, WordInfo> wordCache;
+        // Offsets of the lines of a text lexicon file that hold the
+        // definitions of its words, which are read from the file when
+        // they are first shown - see getFileDefinitions
+        QHash<CompactWord, qint64> definitionOffsets;
+        QMap<int, QList<CompactWord> > stems;
+        QHash<CompactWord, int> numAnagramsMap;
+        QHash<CompactWord, qint64> playabilityMap;
+        QMap<int, QSet<CompactWord> > stemAlphagrams;
+        QMap<int, StemIndex> stemIndexes;
+        mutable WordInfoCache wordCache;
+        mutable OptimizedSpecCache specCache;
+        mutable SearchResultCache searchCache;
+        mutable DefinitionCache definitionCache;
+        mutable CombinationCache combinationCache;
+        WordAttributes attributes;
+        AnagramIndex anagramIndex;
         WordGraph* graph;
         QSqlDatabase* db;
         QString dbConnectionName;
+
+        // Snapshot of the database, memory-mapped when the database is
+        // connected if it was made from the current database file, and
+        // read in place of the database where possible - see loadSnapshot
+        LexiconSnapshot* snapshot;
+
+        // A QSqlDatabase can only be used by the thread that opened it, so
+        // other threads use connections cloned from it - see getConnection
+        Qt::HANDLE dbThread;
+        QHash<Qt::HANDLE, DatabaseConnection*> connections;
+        QMutex connectionMutex;
+
+        // Histograms of the words in the database, used to estimate how
+        // many words a search will match
+        SearchStats searchStats;
+
+        // Members of search sets that are checked word by word, found for
+        // the whole lexicon the first time each set is used and indexed by
+        // the alphabetical index of each word - see getSetMembers
+        QMap<int, QBitArray> setMembers;
+        QMutex setMemberMutex;
+
+        // Probability orders of the letter distributions and numbers of
+        // blanks not stored in the database, keyed by number of blanks and
+        // distribution.  Each is found for the whole lexicon the first
+        // time it is used, and indexed by the alphabetical index of each
+        // word in groups of three as in WordAttributes - see
+        // getProbabilityOrderTable
+        QHash<QString, QVector<qint32> > probabilityOrders;
+        QMutex probabilityOrderMutex;
+
+        // Definition tokens, indexed the first time a definition is searched
+        // and guarded by the mutex since searches can run concurrently
+        DefinitionIndex definitionIndex;
+        QMutex definitionIndexMutex;
+
+        // Index sets of the database that exist, are being created, or are
+        // not to be created, and the jobs creating deferred index sets the
+        // first time a search needs them
+        QSet<QString> indexSets;
+        QList<JobPointer> indexJobs;
+        QMutex indexMutex;
+
+        // Job reading the word cache saved for the same build of the
+        // database in an earlier session
+        JobPointer wordCacheJob;
+
+        // Build of the database the saved search results belong to, or
+        // empty if results are not saved - see loadSavedResults
+        QString savedResultsBuild;
     };
 
+    // A lexicon looked up by name once, so that many queries on it do not
+    // each look it up again - see getLexicon.  The data of a lexicon is
+    // kept until the engine is destroyed, so a handle stays valid as long
+    // as the engine.  A null handle answers every query as a lexicon that
+    // is not loaded would.
+    class Lexicon {
+        friend class WordEngine;
+
+        public:
+        Lexicon() : engine(0), data(0) { }
+        ~Lexicon() { }
+
+        bool isNull() const { return !data; }
+        QString getName() const { return name; }
+        bool isAcceptable(const QString& word) const;
+        QBitArray areAcceptable(const QStringList& words) const;
+        void getHooks(const QString& word, quint32* frontHooks, quint32*
+                      backHooks) const;
+        WordInfo getWordInfo(const QString& word) const;
+        qint64 getPlayabilityValue(const QString& word) const;
+
+        private:
+        Lexicon(const WordEngine* e, const QString& n, const LexiconData* d)
+            : engine(e), name(n), data(d) { }
+
+        const WordEngine* engine;
+        QString name;
+        const LexiconData* data;
+    };
+    friend class Lexicon;
+
     public:
     WordEngine(QObject* parent = 0)
-        : QObject(parent) { }
+        : QObject(parent), lexiconLock(QReadWriteLock::Recursive) { }
     ~WordEngine() { }
 
     bool connectToDatabase(const QString& lexicon, const QString& filename,
                            QString* errString = 0);
     bool disconnectFromDatabase(const QString& lexicon);
     bool databaseIsConnected(const QString& lexicon) const;
+    void saveWordCaches() const;
     int importTextFile(const QString& lexicon, const QString& filename, bool
                        loadDefinitions = true, QString* errString = 0);
     bool importDawgFile(const QString& lexicon, const QString& filename, bool
                         reverse = false, QString* errString = 0, quint16*
                         expectedChecksum = 0);
+    void addGraph(const QString& lexicon, WordGraph* graph);
+    static WordGraph* loadDawgGraph(const QString& filename, const QString&
+                                    reverseFilename, QString* errString = 0);
     int importStems(const QString& lexicon, const QString& filename,
                     QString* errString = 0);
+    bool loadLexicon(const QString& lexicon, bool useDatabase = true,
+                     QString* errString = 0);
     bool lexiconIsLoaded(const QString& lexicon) const;
+    Lexicon getLexicon(const QString& lexicon) const;
     bool isAcceptable(const QString& lexicon, const QString& word) const;
+    QBitArray areAcceptable(const QString& lexicon, const QStringList& words)
+        const;
+    QVector<quint32> getLexiconMembership(const QStringList& lexicons, const
+                                          QStringList& words) const;
+    void getHooks(const QString& lexicon, const QString& word, quint32*
+                  frontHooks, quint32* backHooks) const;
+    QStringList getBlankVariations(const QString& lexicon, const QString&
+                                   word, bool anagram) const;
+    QStringList getEditNeighbors(const QString& lexicon, const QString& word,
+                                 int maxDistance, int operations =
+                                 WordGraph::AllEditOperations) const;
+    QStringList getExtensions(const QString& lexicon, const QString& word,
+                              WordGraph::ExtensionType type, int maxLength =
+                              Defs::MAX_WORD_LEN) const;
     QStringList search(const QString& lexicon, const SearchSpec& spec,
                        bool allCaps) const;
+    bool search(const QString& lexicon, const SearchSpec& spec, bool allCaps,
+                WordVisitor* visitor, SearchProfile* profile = 0) const;
+    QList<QStringList> searchMany(const QString& lexicon, const
+                                  QList<SearchSpec>& specs, bool allCaps)
+                                  const;
+    QStringList refineSearch(const QString& lexicon, const SearchSpec& spec,
+                             bool allCaps, const SearchSpec& previousSpec,
+                             const QStringList& previousResults, const
+                             WordVisitor* canceller = 0, SearchProfile*
+                             profile = 0) const;
+    SearchProfile getLastSearchProfile() const;
+    int countMatches(const QString& lexicon, const SearchSpec& spec) const;
     QStringList wordGraphSearch(const QString& lexicon, const SearchSpec&
-                                spec) const;
+                                spec, const QStringList* wordList = 0) const;
     QStringList alphagrams(const QStringList& strList) const;
     int getNumWords(const QString& lexicon) const;
     QString getLexiconFile(const QString& lexicon) const;
+    quint64 getLexiconBuild(const QString& lexicon) const;
+    QVector<qint32> getWordIds(const QString& lexicon, const QStringList&
+                               words) const;
+    QVector<qint32> searchIds(const QString& lexicon, const SearchSpec&
+                              spec) const;
+    QString getWordById(const QString& lexicon, qint32 id) const;
+    QStringList getWordsById(const QString& lexicon, const QVector<qint32>&
+                             ids) const;
+    QStringList getCompletions(const QString& lexicon, const QString& prefix,
+                               int maxWords) const;
     WordInfo getWordInfo(const QString& lexicon, const QString& word) const;
     QString getDefinition(const QString& lexicon, const QString& word,
                           bool replaceLinks = true) const;
@@ -134,11 +671,37 @@ class WordEngine : public QObject
     int getMaxPlayabilityOrder(const QString& lexicon, const QString& word)
         const;
     int getProbabilityOrder(const QString& lexicon, const QString& word,
-                            int numBlanks) const;
+                            int numBlanks, const QString& distribution =
+                            QString()) const;
     int getMinProbabilityOrder(const QString& lexicon, const QString& word,
-                               int numBlanks) const;
+                               int numBlanks, const QString& distribution =
+                               QString()) const;
     int getMaxProbabilityOrder(const QString& lexicon, const QString& word,
-                               int numBlanks) const;
+                               int numBlanks, const QString& distribution =
+                               QString()) const;
+    QMap<QChar, QStringList> getAnagramHooks(const QString& lexicon, const
+                                             QString& word) const;
+    QMap<QChar, QStringList> getAnagramStems(const QString& lexicon, const
+                                             QString& word) const;
+    QStringList getStemWords(const QString& lexicon, const QString& stem)
+        const;
+    QStringList getWordStems(const QString& lexicon, const QString& word)
+        const;
+    QVector<int> getMinPlayabilityOrders(const QString& lexicon, const
+                                         QStringList& words) const;
+    QVector<int> getMinProbabilityOrders(const QString& lexicon, const
+                                         QStringList& words, int numBlanks,
+                                         const QString& distribution =
+                                         QString()) const;
+    QVector<int> getMinPlayabilityOrders(const QString& lexicon, const
+                                         QVector<qint32>& ids) const;
+    QVector<int> getMinProbabilityOrders(const QString& lexicon, const
+                                         QVector<qint32>& ids, int numBlanks,
+                                         const QString& distribution =
+                                         QString()) const;
+    QVector<double> getNumCombinations(const QString& lexicon, const
+                                       QStringList& words, int numBlanks)
+        const;
     // XXX: Lexicon parameter doesn't really make sense here, but it is
     // retained to use word info caching
     int getNumVowels(const QString& lexicon, const QString& word) const;
@@ -149,6 +712,9 @@ class WordEngine : public QObject
     QString getLexiconSymbols(const QString& lexicon, const QString& word) const;
 
     void addToCache(const QString& lexicon, const QStringList& words) const;
+    const WordInfoCache* getWordCache(const QString& lexicon) const;
+    const SearchResultCache* getSearchCache(const QString& lexicon) const;
+    QMap<QString, QList<MemoryUsage> > memoryReport() const;
 
     private:
     enum ConditionPhase {
@@ -158,27 +724,190 @@ class WordEngine : public QObject
         PostConditionPhase
     };
 
+    enum SearchDriver {
+        DriveFromGraph = 0,
+        DriveFromDatabase,
+        DriveFromWordList,
+        DriveFromLexicon
+    };
+
+    // Pass words to another visitor in upper case
+    class UpperCaseVisitor : public WordVisitor {
+        public:
+        UpperCaseVisitor(WordVisitor* v) : visitor(v) { }
+        bool visitWord(const QString& word) {
+            return visitor->visitWord(word.toUpper()); }
+        bool isCancelled() const { return visitor->isCancelled(); }
+
+        private:
+        WordVisitor* visitor;
+    };
+
+    // Pass words to another visitor, counting the words passed
+    class CountingVisitor : public WordVisitor {
+        public:
+        CountingVisitor(WordVisitor* v) : visitor(v), numWords(0) { }
+        bool visitWord(const QString& word) {
+            ++numWords; return visitor->visitWord(word); }
+        bool isCancelled() const { return visitor->isCancelled(); }
+        int getNumWords() const { return numWords; }
+
+        private:
+        WordVisitor* visitor;
+        int numWords;
+    };
+
+    // Pass the IDs of words in a word graph to a list instead of the words
+    class WordIdVisitor : public WordVisitor {
+        public:
+        WordIdVisitor(const WordGraph* g, QVector<qint32>* i)
+            : graph(g), ids(i) { }
+        bool visitWord(const QString& word) {
+            qint32 id = graph->indexOf(word);
+            if (id >= 0)
+                ids->append(id);
+            return true;
+        }
+
+        private:
+        const WordGraph* graph;
+        QVector<qint32>* ids;
+    };
+
     private:
     void clearCache(const QString& lexicon) const;
-    bool matchesPostConditions(const QString& lexicon, const QString& word,
-                               const QList<SearchCondition>& conditions) const;
-    bool isSetMember(const QString& lexicon, const QString& word,
+    void clearSearchCaches() const;
+    void initLexiconData(const QString& lexicon);
+    void loadSnapshot(const QString& lexicon, const QString& filename);
+    void loadWordAttributes(const QString& lexicon);
+    bool loadSnapshotAttributes(LexiconData* data);
+    void loadSearchStats(const QString& lexicon);
+    void loadIndexSets(const QString& lexicon);
+    void requireIndexSets(const QString& lexicon, const SearchSpec&
+                          optimizedSpec) const;
+    void waitForIndexJobs(LexiconData* data);
+    void startWordCacheJob(const QString& lexicon);
+    void waitForWordCacheJob(LexiconData* data);
+    void loadSavedResults(const QString& lexicon);
+    bool findSavedResults(const QString& lexicon, quint64 hash, QStringList*
+                          resultList) const;
+    void saveResults(const QString& lexicon, const OptimizedSpec& optimized,
+                     quint64 hash, const QStringList& resultList) const;
+    QString getDatabaseBuild(const LexiconData* data) const;
+    void loadAnagramIndex(const QString& lexicon);
+    void loadStemIndexes(const QString& lexicon);
+    QVector<qint32> findStemWords(const AnagramIndex& index, const QString&
+                                  stemAlphagram) const;
+    bool isExactAnagramSearch(const SearchSpec& optimizedSpec, QString*
+                              letters) const;
+    QStringList getIndexedAnagrams(const QString& lexicon, const QString&
+                                   letters) const;
+    int getWordId(const QString& lexicon, const QString& word) const;
+    int getWordId(const LexiconData* data, const QString& word) const;
+    DatabaseConnection* getConnection(LexiconData* data) const;
+    QSqlDatabase* getDatabase(const QString& lexicon) const;
+    void closeConnections(LexiconData* data);
+    QSqlQuery* getCacheQuery(DatabaseConnection* connection, bool chunk)
+        const;
+    QSqlQuery* getPlayabilityQuery(DatabaseConnection* connection) const;
+    WordInfo getQueryWordInfo(const QSqlQuery& query) const;
+    WordInfo getSnapshotWordInfo(const LexiconSnapshot* snapshot, int id)
+        const;
+    QString getSavedDawgFilename(const QString& filename, bool reverse)
+        const;
+    QVector<int> getMinOrders(const QString& lexicon, const QStringList&
+                              words, bool probability, int numBlanks, const
+                              QString& distribution = QString()) const;
+    QVector<int> getMinOrdersById(const QString& lexicon, const
+                                  QVector<qint32>& ids, bool probability, int
+                                  numBlanks, const QString& distribution =
+                                  QString()) const;
+    static bool hasStoredProbabilityOrders(int numBlanks, const QString&
+                                           distribution);
+    QVector<qint32> getProbabilityOrderTable(const QString& lexicon, int
+                                             numBlanks, const QString&
+                                             distribution) const;
+    int getTableProbabilityOrder(const QString& lexicon, const QString& word,
+                                 int numBlanks, const QString& distribution,
+                                 int offset) const;
+    void getCachedCombinations(const QString& lexicon, const QStringList&
+                               words, int numBlanks, QVector<double>*
+                               combinations) const;
+    bool getLimitKeys(const QString& lexicon, const QStringList& words, bool
+                      probCondition, int probNumBlanks, bool alphabetical,
+                      QVector<LimitKey>* keys) const;
+    QVector<PostConditionOp> compilePostConditions(const QString& lexicon,
+        const QList<SearchCondition>& conditions) const;
+    bool matchesPostConditions(const Lexicon& lexicon, const QString&
+                               wordUpper, const QVector<PostConditionOp>& ops)
+                               const;
+    bool isSetMember(const Lexicon& lexicon, const QString& word,
                      SearchSet ss) const;
+    QBitArray getSetMembers(const QString& lexicon, SearchSet ss) const;
     int getNumAnagrams(const QString& lexicon, const QString& word) const;
     QStringList nonGraphSearch(const QString& lexicon,
                                const SearchSpec& spec) const;
-    void addDefinition(const QString& lexicon, const QString& word,
-                       const QString& definition);
+    QStringList getFileDefinitions(const LexiconData* data, const QString&
+                                   word) const;
     QStringList databaseSearch(const QString& lexicon, const SearchSpec&
-                               optimizedSpec, const QStringList* wordList = 0)
-                               const;
+                               optimizedSpec, const QStringList* wordList = 0,
+                               QString* queryText = 0) const;
+    bool getDefinitionCandidates(const QString& lexicon, const SearchSpec&
+                                 optimizedSpec, const QStringList* wordList,
+                                 QStringList* candidates) const;
+    void loadDefinitionIndex(const QString& lexicon) const;
+    QString getDatabaseQuery(const SearchSpec& optimizedSpec, const
+                             QStringList* wordList, bool countOnly,
+                             QMap<QString, QString>* upperToLower = 0) const;
     QStringList applyPostConditions(const QString& lexicon, const SearchSpec&
                                     optimizedSpec, const QStringList&
                                     wordList) const;
     ConditionPhase getConditionPhase(const SearchCondition& condition) const;
+    QMap<ConditionPhase, int> getPhaseCounts(const SearchSpec& optimizedSpec)
+        const;
+    OptimizedSpec optimizeSpec(const QString& lexicon, const SearchSpec&
+                               spec) const;
+    QStringList cachedSearch(const QString& lexicon, const SearchSpec& spec,
+                             bool allCaps, const WordVisitor* canceller,
+                             SearchProfile* profile = 0) const;
+    QStringList sampleSearch(const QString& lexicon, const SearchSpec& spec,
+                             bool allCaps, const WordVisitor* canceller,
+                             SearchProfile* profile = 0) const;
+    QStringList getSearchResults(const QString& lexicon, const SearchSpec&
+                                 optimizedSpec, bool allCaps, const
+                                 WordVisitor* canceller = 0, SearchProfile*
+                                 profile = 0) const;
+    void addProfilePhase(SearchProfile* profile, QTime* timer, const QString&
+                         name, int numIn, int numOut, const QString& query =
+                         QString()) const;
+    void saveSearchProfile(SearchProfile* profile, const QString& lexicon,
+                           const SearchSpec& spec, int msecs) const;
+    SearchDriver planSearch(const QString& lexicon, const SearchSpec&
+                            optimizedSpec, const QMap<ConditionPhase, int>&
+                            phaseCounts) const;
+    int estimateDatabaseMatches(const QString& lexicon, const SearchSpec&
+                                optimizedSpec, int* wordListSize) const;
+    QStringList getWordListWords(const SearchCondition& condition, const
+                                 QString& lexicon = QString(), bool*
+                                 acceptable = 0) const;
+    bool getLexiconJoin(const QString& lexicon, const SearchSpec&
+                        optimizedSpec, const WordGraph** other = 0, bool*
+                        difference = 0) const;
+    QStringList getLexiconJoinCandidates(const QString& lexicon, const
+                                         SearchSpec& optimizedSpec) const;
+    QStringList getWordListCandidates(const QString& lexicon, const
+                                      SearchSpec& optimizedSpec) const;
 
     private:
+    // Lexicons may be searched from more than one thread at once, but are
+    // only loaded and connected to databases while no other thread uses them
+    mutable QReadWriteLock lexiconLock;
+    mutable WordListFileCache wordListFiles;
     QMap<QString, LexiconData*> lexiconData;
+
+    // The profile of the last search profiled from any thread
+    mutable QMutex profileMutex;
+    mutable SearchProfile lastSearchProfile;
 };
 
 #endif // ZYZZYVA_WORD_ENGINE_H
@@ -40,12 +40,14 @@ using namespace Defs;
 //
 //! Constructor.
 //
+//! @param e the word engine completing the words typed
 //! @param parent the parent widget
 //! @param name the name of this widget
 //! @param modal whether the dialog is modal
 //! @param f widget flags
 //---------------------------------------------------------------------------
-WordEntryDialog::WordEntryDialog(QWidget* parent, Qt::WFlags f)
+WordEntryDialog::WordEntryDialog(WordEngine* e, QWidget* parent, Qt::WFlags
+                                 f)
     : QDialog(parent, f),
     wordValidator(new WordValidator(this))
 {
@@ -54,6 +56,8 @@ WordEntryDialog::WordEntryDialog(QWidget* parent, Qt::WFlags f)
     mainVlay->setSpacing(SPACING);
 
     lexiconWidget = new LexiconSelectWidget;
+    connect(lexiconWidget->getComboBox(), SIGNAL(activated(const QString&)),
+        SLOT(lexiconActivated(const QString&)));
     mainVlay->addWidget(lexiconWidget);
 
     QHBoxLayout* lineHlay = new QHBoxLayout;
@@ -63,8 +67,9 @@ WordEntryDialog::WordEntryDialog(QWidget* parent, Qt::WFlags f)
     QLabel* label = new QLabel("Word:");
     lineHlay->addWidget(label);
 
-    wordLine = new QLineEdit;
+    wordLine = new WordLineEdit;
     wordLine->setValidator(wordValidator);
+    wordLine->setCompletionEngine(e, lexiconWidget->getCurrentLexicon());
     lineHlay->addWidget(wordLine);
 
     // OK/Cancel buttons
@@ -111,3 +116,17 @@ WordEntryDialog::getLexicon() const
 {
     return lexiconWidget->getCurrentLexicon();
 }
+
+//---------------------------------------------------------------------------
+//  lexiconActivated
+//
+//! Called when the lexicon combo box is activated.  Complete words from
+//! the activated lexicon.
+//
+//! @param lexicon the activated lexicon
+//---------------------------------------------------------------------------
+void
+WordEntryDialog::lexiconActivated(const QString& lexicon)
+{
+    wordLine->setCompletionLexicon(lexicon);
+}
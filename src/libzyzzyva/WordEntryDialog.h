@@ -25,25 +25,29 @@
 #ifndef ZYZZYVA_WORD_ENTRY_DIALOG_H
 #define ZYZZYVA_WORD_ENTRY_DIALOG_H
 
+#include "WordLineEdit.h"
 #include <QDialog>
-#include <QLineEdit>
 
 class LexiconSelectWidget;
+class WordEngine;
 class WordValidator;
 
 class WordEntryDialog : public QDialog
 {
     Q_OBJECT
     public:
-    WordEntryDialog(QWidget* parent = 0, Qt::WFlags f = 0);
+    WordEntryDialog(WordEngine* e, QWidget* parent = 0, Qt::WFlags f = 0);
     ~WordEntryDialog();
 
     QString getWord() const { return wordLine->text(); }
     QString getLexicon() const;
 
+    private slots:
+    void lexiconActivated(const QString& lexicon);
+
     private:
     LexiconSelectWidget* lexiconWidget;
-    QLineEdit*     wordLine;
+    WordLineEdit*  wordLine;
     WordValidator* wordValidator;
 };
 
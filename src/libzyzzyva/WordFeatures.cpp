@@ -0,0 +1,158 @@
+//---------------------------------------------------------------------------
+// WordFeatures.cpp
+//
+// A class for calculating the letter features of blocks of words.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "WordFeatures.h"
+#include "LetterBag.h"
+#include "Auxil.h"
+
+//---------------------------------------------------------------------------
+//  WordFeatures
+//
+//! Constructor.  Look up the point value of each letter and whether it is a
+//! vowel once, so words of plain letters can be scored by table.
+//
+//! @param bag the letter bag giving letter frequencies and point values
+//---------------------------------------------------------------------------
+WordFeatures::WordFeatures(const LetterBag& bag)
+    : letterBag(bag)
+{
+    for (int i = 0; i < NUM_LETTERS; ++i) {
+        QChar c (ushort('A' + i));
+        letterValues[i] = letterBag.getLetterValue(c);
+        vowels[i] = Auxil::isVowel(c);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  compute
+//
+//! Calculate the features of a block of words, replacing any features
+//! previously calculated.
+//
+//! @param words the words
+//---------------------------------------------------------------------------
+void
+WordFeatures::compute(const QStringList& words)
+{
+    clear();
+    foreach (const QString& word, words) {
+        if (!computePlain(word))
+            computeGeneral(word);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  clear
+//
+//! Remove the features of all words.
+//---------------------------------------------------------------------------
+void
+WordFeatures::clear()
+{
+    combinations0.clear();
+    combinations1.clear();
+    combinations2.clear();
+    alphagrams.clear();
+    numUniqueLetters.clear();
+    numVowels.clear();
+    pointValues.clear();
+}
+
+//---------------------------------------------------------------------------
+//  computePlain
+//
+//! Calculate the features of a word consisting only of the letters A to Z.
+//! The letters are counted in a single pass, and every feature is derived
+//! from the counts.
+//
+//! @param word the word
+//! @return true if successful, false if the word contains other characters
+//---------------------------------------------------------------------------
+bool
+WordFeatures::computePlain(const QString& word)
+{
+    int counts[NUM_LETTERS] = { 0 };
+    const QChar* letters = word.unicode();
+    int length = word.length();
+    for (int i = 0; i < length; ++i) {
+        uint index = uint(letters[i].unicode()) - 'A';
+        if (index >= uint(NUM_LETTERS))
+            return false;
+        ++counts[index];
+    }
+
+    QString alphagram;
+    alphagram.resize(length);
+    QChar* alphagramLetters = alphagram.data();
+    int numUnique = 0;
+    int numVowelLetters = 0;
+    int points = 0;
+    for (int i = 0; i < NUM_LETTERS; ++i) {
+        int count = counts[i];
+        if (!count)
+            continue;
+        ++numUnique;
+        if (vowels[i])
+            numVowelLetters += count;
+        points += count * letterValues[i];
+        QChar c (ushort('A' + i));
+        for (int j = 0; j < count; ++j)
+            *alphagramLetters++ = c;
+    }
+
+    double combinations[3];
+    letterBag.getNumCombinations(counts, 2, combinations);
+
+    combinations0.append(combinations[0]);
+    combinations1.append(combinations[1]);
+    combinations2.append(combinations[2]);
+    alphagrams.append(alphagram);
+    numUniqueLetters.append(numUnique);
+    numVowels.append(numVowelLetters);
+    pointValues.append(points);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  computeGeneral
+//
+//! Calculate the features of a word that may contain any characters.
+//
+//! @param word the word
+//---------------------------------------------------------------------------
+void
+WordFeatures::computeGeneral(const QString& word)
+{
+    int points = 0;
+    for (int i = 0; i < word.length(); ++i)
+        points += letterBag.getLetterValue(word.at(i));
+
+    combinations0.append(letterBag.getNumCombinations(word, 0));
+    combinations1.append(letterBag.getNumCombinations(word, 1));
+    combinations2.append(letterBag.getNumCombinations(word, 2));
+    alphagrams.append(Auxil::getAlphagram(word));
+    numUniqueLetters.append(Auxil::getNumUniqueLetters(word));
+    numVowels.append(Auxil::getNumVowels(word));
+    pointValues.append(points);
+}
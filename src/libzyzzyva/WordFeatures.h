@@ -0,0 +1,68 @@
+//---------------------------------------------------------------------------
+// WordFeatures.h
+//
+// A class for calculating the letter features of blocks of words.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_WORD_FEATURES_H
+#define ZYZZYVA_WORD_FEATURES_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+class LetterBag;
+
+// The features of a block of words that are derived from their letters, one
+// list per feature with an entry for each word, ready to be bound to a
+// batch insert
+class WordFeatures
+{
+    public:
+    WordFeatures(const LetterBag& bag);
+    ~WordFeatures() { }
+
+    void compute(const QStringList& words);
+    void clear();
+    int size() const { return alphagrams.size(); }
+
+    public:
+    QVariantList combinations0;
+    QVariantList combinations1;
+    QVariantList combinations2;
+    QVariantList alphagrams;
+    QVariantList numUniqueLetters;
+    QVariantList numVowels;
+    QVariantList pointValues;
+
+    private:
+    bool computePlain(const QString& word);
+    void computeGeneral(const QString& word);
+
+    private:
+    static const int NUM_LETTERS = 26;
+
+    const LetterBag& letterBag;
+    int letterValues[NUM_LETTERS];
+    bool vowels[NUM_LETTERS];
+};
+
+#endif // ZYZZYVA_WORD_FEATURES_H
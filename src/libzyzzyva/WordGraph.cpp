@@ -23,14 +23,32 @@
 //---------------------------------------------------------------------------
 
 #include "WordGraph.h"
+#include "Auxil.h"
+#include "DawgBuilder.h"
 #include "Defs.h"
+#include "JobScheduler.h"
+#include "LetterSignature.h"
+#include "Rand.h"
+#include "SuccinctDawg.h"
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
 #include <QList>
+#include <QMap>
+#include <QAtomicInt>
 #include <QRegExp>
+#include <QSet>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <stack>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 const qint32 TERMINAL_NODE = 0;
 const qint32 ROOT_NODE = 1;
 
@@ -43,16 +61,248 @@ const qint32 V_LETTER       = 24;
 const qint32 M_LETTER       = 0xFF;
 const qint32 M_NODE_POINTER = 0x1FFFFFL;
 
+// Native-endian DAWG files begin with a header of two 32-bit words: the
+// number of edges and the checksum of the original little-endian file
+const qint32 NATIVE_HEADER_WORDS = 2;
+const QString NATIVE_DAWG_EXTENSION = ".native";
+
+const int NUM_LOOKUP_LETTERS = 26;
+const int NUM_EDGE_LETTERS = 256;
+
+// Separates the reversed and forward parts of each path in the infix index
+const int INFIX_SEPARATOR = '^';
+
+// Number of edges followed by a traversal between checks of whether its
+// visitor has cancelled the search
+const int CANCEL_CHECK_STEPS = 4096;
+
+// Size of the record of each word in the word array - see buildWordArray
+const int WORD_RECORD_SIZE = 16;
+
 using namespace std;
 using namespace Defs;
 
+//---------------------------------------------------------------------------
+//  lessThanWordPair
+//
+//! Compare two word pairs by upper case word.
+//
+//! @param a a word pair
+//! @param b another word pair
+//! @return true if a is less than b
+//---------------------------------------------------------------------------
+bool
+lessThanWordPair(const pair<QString, QString>& a, const pair<QString,
+                 QString>& b)
+{
+    return (a.first < b.first);
+}
+
+//---------------------------------------------------------------------------
+//  equalWordPair
+//
+//! Determine whether two word pairs have the same upper case word.
+//
+//! @param a a word pair
+//! @param b another word pair
+//! @return true if a and b are equal
+//---------------------------------------------------------------------------
+bool
+equalWordPair(const pair<QString, QString>& a, const pair<QString,
+              QString>& b)
+{
+    return (a.first == b.first);
+}
+
+//---------------------------------------------------------------------------
+//  WordCountVisitor
+//
+//! A visitor that only counts the words it receives.
+//---------------------------------------------------------------------------
+class WordCountVisitor : public WordVisitor
+{
+    public:
+    WordCountVisitor() : count(0) { }
+    bool visitWord(const QString&) { ++count; return true; }
+    int getCount() const { return count; }
+
+    private:
+    int count;
+};
+
+//---------------------------------------------------------------------------
+//  countBits
+//
+//! Count the number of bits set in a 32-bit value.
+//
+//! @param value the value
+//! @return the number of bits set
+//---------------------------------------------------------------------------
+static inline quint32
+countBits(quint32 value)
+{
+    value = value - ((value >> 1) & 0x55555555);
+    value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+    return (((value + (value >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
+
+//---------------------------------------------------------------------------
+//  RequiredLetters
+//
+//! The letters every word found by a traversal must contain.  Each required
+//! letter has one bit for each time it is required, and a prefix is tracked
+//! by the mask of required letters it matches, so the number of letters
+//! still missing is known at each edge without undoing anything when the
+//! traversal backs up.
+//---------------------------------------------------------------------------
+class RequiredLetters
+{
+    public:
+    RequiredLetters(const QString& letters);
+    bool isEmpty() const { return !numRequired; }
+    quint32 match(quint32 matched, int c) const {
+        quint32 open = letterBits[c] & ~matched;
+        return matched | (open & (~open + 1)); }
+    int getNumMissing(quint32 matched) const {
+        return numRequired - int(countBits(matched)); }
+
+    private:
+    quint32 letterBits[NUM_EDGE_LETTERS];
+    int numRequired;
+};
+
+//---------------------------------------------------------------------------
+//  RequiredLetters
+//
+//! Constructor.
+//
+//! @param letters the required letters, with repeats
+//---------------------------------------------------------------------------
+RequiredLetters::RequiredLetters(const QString& letters)
+    : numRequired(0)
+{
+    for (int i = 0; i < NUM_EDGE_LETTERS; ++i)
+        letterBits[i] = 0;
+
+    int length = qMin(letters.length(), 32);
+    for (int i = 0; i < length; ++i) {
+        ushort c = letters.at(i).unicode();
+        if (c < NUM_EDGE_LETTERS)
+            letterBits[c] |= (1U << numRequired++);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  getEdgeLengthMasks
+//
+//! Find the lengths of the rest of the words reached through each edge of a
+//! DAWG, with bit n of the mask of an edge set if a word ends n letters
+//! below the node the edge leaves.  Lengths too long to fit in the mask are
+//! left out, since no search finds words that long.
+//
+//! @param edges the DAWG
+//! @return the mask of each edge, indexed like the edges
+//---------------------------------------------------------------------------
+static QVector<quint16>
+getEdgeLengthMasks(const qint32* edges)
+{
+    // Find the mask of each node, finding the masks of the children of a
+    // node before the node itself
+    QHash<qint32, quint16> nodeMasks;
+    nodeMasks.insert(TERMINAL_NODE, 0);
+    QVector<qint32> stack;
+    stack.append(ROOT_NODE);
+    qint32 lastEdge = ROOT_NODE;
+
+    while (!stack.isEmpty()) {
+        qint32 node = stack.last();
+        if (nodeMasks.contains(node)) {
+            stack.pop_back();
+            continue;
+        }
+
+        bool childrenDone = true;
+        for (const qint32* edge = &edges[node]; ; ++edge) {
+            qint32 child = *edge & M_NODE_POINTER;
+            if (!nodeMasks.contains(child)) {
+                stack.append(child);
+                childrenDone = false;
+            }
+            if (*edge & M_END_OF_NODE)
+                break;
+        }
+        if (!childrenDone)
+            continue;
+
+        quint16 mask = 0;
+        const qint32* edge = &edges[node];
+        for (; ; ++edge) {
+            mask |= quint16(((*edge & M_END_OF_WORD) ? 2 : 0) |
+                            (nodeMasks.value(*edge & M_NODE_POINTER) << 1));
+            if (*edge & M_END_OF_NODE)
+                break;
+        }
+        nodeMasks.insert(node, mask);
+        lastEdge = qMax(lastEdge, qint32(edge - edges));
+        stack.pop_back();
+    }
+
+    QVector<quint16> masks (lastEdge + 1, 0);
+    QHashIterator<qint32, quint16> it (nodeMasks);
+    while (it.hasNext()) {
+        it.next();
+        if (it.key() == TERMINAL_NODE)
+            continue;
+        for (qint32 i = it.key(); ; ++i) {
+            masks[i] = quint16(((edges[i] & M_END_OF_WORD) ? 2 : 0) |
+                (nodeMasks.value(edges[i] & M_NODE_POINTER) << 1));
+            if (edges[i] & M_END_OF_NODE)
+                break;
+        }
+    }
+    return masks;
+}
+
+//---------------------------------------------------------------------------
+//  getDepthMasks
+//
+//! Find the lengths of the rest of a word that keep it within a range of
+//! lengths, for each number of letters already in the word, in the form of
+//! the masks of getEdgeLengthMasks.
+//
+//! @param minLength the minimum length of words
+//! @param maxLength the maximum length of words
+//! @param depthMasks returns the mask for each number of letters from zero
+//! to MAX_WORD_LEN - 1
+//! @return true if the range excludes any lengths, false if every length is
+//! allowed and nothing can be pruned
+//---------------------------------------------------------------------------
+static bool
+getDepthMasks(int minLength, int maxLength, quint16* depthMasks)
+{
+    if ((minLength <= 1) && (maxLength >= MAX_WORD_LEN))
+        return false;
+
+    for (int depth = 0; depth < MAX_WORD_LEN; ++depth) {
+        quint16 mask = 0;
+        for (int n = 1; depth + n <= MAX_WORD_LEN; ++n) {
+            if ((depth + n >= minLength) && (depth + n <= maxLength))
+                mask |= quint16(1 << n);
+        }
+        depthMasks[depth] = mask;
+    }
+    return true;
+}
+
 //---------------------------------------------------------------------------
 //  WordGraph
 //
 //! Constructor.
 //---------------------------------------------------------------------------
 WordGraph::WordGraph()
-    : dawg(0), rdawg(0), top(0), rtop(0), numWords(0)
+    : dawg(0), rdawg(0), gaddag(0), succinctRdawg(0), dawgFile(0),
+      rdawgFile(0), dawgEdges(0), rdawgEdges(0), gaddagEdges(0), top(0),
+      rtop(0), numWords(0)
 {
     // Test for endianness
     char endianTest[2] = { 1, 0 };
@@ -77,12 +327,42 @@ WordGraph::~WordGraph()
 void
 WordGraph::clear()
 {
-    if (dawg)
+    if (dawgFile) {
+        // Closing the file also unmaps it
+        delete dawgFile;
+        dawgFile = 0;
+    }
+    else if (dawg)
         delete[] dawg;
-    if (rdawg)
+
+    if (rdawgFile) {
+        delete rdawgFile;
+        rdawgFile = 0;
+    }
+    else if (rdawg)
         delete[] rdawg;
+
     dawg = 0;
     rdawg = 0;
+    dawgEdges = 0;
+    rdawgEdges = 0;
+
+    delete succinctRdawg;
+    succinctRdawg = 0;
+
+    delete[] gaddag;
+    gaddag = 0;
+    gaddagEdges = 0;
+
+    lookupMasks.clear();
+    lookupFirstChild.clear();
+    lookupChildren.clear();
+    wordCounts.clear();
+    wordRecords.clear();
+    wordMasks.clear();
+    dawgLengthMasks.clear();
+    rdawgLengthMasks.clear();
+    lookupLengthMasks.clear();
 }
 
 //---------------------------------------------------------------------------
@@ -91,6 +371,12 @@ WordGraph::clear()
 //! Import words from a DAWG file as generated by Graham Toal's dawgutils
 //! programs: http://www.gtoal.com/wordgames/dawgutils/
 //
+//! The file is memory-mapped read-only and the edges are used in place, so
+//! the pages can be shared between processes.  On big-endian hosts, a
+//! native-endian copy of the file is created in the user lexicon directory
+//! the first time it is loaded, and that copy is mapped instead.  If the file
+//! cannot be mapped, it is read into memory.
+//
 //! @param filename the name of the DAWG file to import
 //! @param reverse whether the DAWG contains reversed words
 //! @param errString returns the error string in case of error
@@ -101,526 +387,4027 @@ bool
 WordGraph::importDawgFile(const QString& filename, bool reverse, QString*
                           errString, quint16* expectedChecksum)
 {
-    QFile file (filename);
-    if (!file.open(QIODevice::ReadOnly)) {
-        if (errString)
-            *errString = "Can't open file '" + filename + "': "
-            + file.errorString();
-        return false;
+    // Only compute a checksum if it will be compared
+    QFile* mappedFile = 0;
+    quint16 checksum = 0;
+    quint16* checksumPtr = (expectedChecksum && errString) ? &checksum : 0;
+    qint32 numEdges = 0;
+    qint32* edges = mapDawgFile(filename, &mappedFile, checksumPtr,
+                                errString);
+    if (!edges) {
+        edges = readDawgFile(filename, &numEdges, checksumPtr, errString);
+        if (!edges)
+            return false;
     }
 
-    qint32 numEdges;
-    qint32* p = &numEdges;
-    char* cp = (char*) p;
-    file.read(cp, 1 * sizeof(qint32));
-    if (bigEndian)
-        convertEndian(p, 1);
-
     if (reverse) {
-        rdawg = new qint32[numEdges + 1];
-        rdawg[0] = 0;
-        p = &rdawg[1];
-        cp = (char*) p;
-        file.read(cp, numEdges * sizeof(qint32));
+        if (rdawgFile)
+            delete rdawgFile;
+        else
+            delete[] rdawg;
+        rdawg = edges;
+        rdawgFile = mappedFile;
+        rdawgEdges = numEdges;
+        rdawgLengthMasks.clear();
+        delete succinctRdawg;
+        succinctRdawg = 0;
     }
     else {
-        dawg = new qint32[numEdges + 1];
-        dawg[0] = 0;
-        p = &dawg[1];
-        cp = (char*) p;
-        file.read(cp, numEdges * sizeof(qint32));
+        if (dawgFile)
+            delete dawgFile;
+        else
+            delete[] dawg;
+        dawg = edges;
+        dawgFile = mappedFile;
+        dawgEdges = numEdges;
+
+        // Any lookup table, word counts, word array, length masks or infix
+        // index refer to the old forward DAWG
+        lookupMasks.clear();
+        lookupFirstChild.clear();
+        lookupChildren.clear();
+        wordCounts.clear();
+        wordRecords.clear();
+        wordMasks.clear();
+        dawgLengthMasks.clear();
+        lookupLengthMasks.clear();
+        delete[] gaddag;
+        gaddag = 0;
+        gaddagEdges = 0;
     }
 
-    if (expectedChecksum && errString) {
-        char* cp = (char*) p;
+    if (checksumPtr) {
         //qDebug("file: %s", filename.toUtf8().constData());
         //qDebug("expected checksum: %d", *expectedChecksum);
-        //qDebug("got checksum:      %d", qChecksum(cp, numEdges));
-        if (*expectedChecksum != qChecksum(cp, numEdges)) {
+        //qDebug("got checksum:      %d", checksum);
+        if (*expectedChecksum != checksum) {
             *errString =
                 "The lexicon checksum does not match the expected checksum.  "
                 "It is possible the lexicon has been corrupted.";
         }
     }
 
-    if (bigEndian)
-        convertEndian(p, numEdges);
-
     return true;
 }
 
 //---------------------------------------------------------------------------
-//  addWord
+//  importWords
 //
-//! Add a word to the old-style graph.  Represent the word in both forward and
-//! reverse order for quick lookup in either direction.
+//! Build a minimized DAWG from a list of words, and use it in place of any
+//! DAWG already loaded in the same direction.  The DAWG can also be saved to
+//! a file in the format read by importDawgFile.
 //
-//! @param w the word to add
+//! @param words the words to import, in any order
+//! @param reverse whether to build the reverse DAWG from the reversed words
+//! @param errString returns the error string in case of error
+//! @param saveFilename the name of the file to save the DAWG to, or empty
+//! if the DAWG should not be saved
+//! @return true if successful, false otherwise
 //---------------------------------------------------------------------------
-void
-WordGraph::addWord(const QString& w)
+bool
+WordGraph::importWords(const QStringList& words, bool reverse, QString*
+                       errString, const QString& saveFilename)
 {
-    if (w.isEmpty())
-        return;
+    QStringList sortedWords;
+    if (reverse) {
+        foreach (const QString& word, words)
+            sortedWords.append(reverseString(word));
+    }
+    else
+        sortedWords = words;
+    sortedWords.sort();
+
+    DawgBuilder builder;
+    foreach (const QString& word, sortedWords) {
+        if (!builder.addWord(word)) {
+            if (errString) {
+                *errString = "The word '" + word + "' cannot be stored in "
+                    "a DAWG.";
+            }
+            return false;
+        }
+    }
 
-    addWordOld(w, false);
-    addWordOld(w, true);
-    ++numWords;
+    qint32 numEdges = 0;
+    qint32* edges = builder.finish(&numEdges, errString);
+    if (!edges)
+        return false;
+
+    // Save the edges in little-endian order following the number of edges.
+    // Failing to save is not an error, since the DAWG can still be used.
+    if (!saveFilename.isEmpty()) {
+        QDir dir;
+        dir.mkpath(QFileInfo(saveFilename).absolutePath());
+
+        QFile file (saveFilename);
+        bool ok = file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        if (ok) {
+            edges[0] = numEdges;
+            if (bigEndian)
+                convertEndian(edges, numEdges + 1);
+            qint64 size = (numEdges + 1) * sizeof(qint32);
+            ok = (file.write((const char*) edges, size) == size);
+            if (bigEndian)
+                convertEndian(edges, numEdges + 1);
+            edges[0] = 0;
+            file.close();
+            if (!ok)
+                file.remove();
+        }
+    }
+
+    if (reverse) {
+        if (rdawgFile)
+            delete rdawgFile;
+        else
+            delete[] rdawg;
+        rdawg = edges;
+        rdawgFile = 0;
+        rdawgEdges = numEdges;
+        rdawgLengthMasks.clear();
+        delete succinctRdawg;
+        succinctRdawg = 0;
+    }
+    else {
+        if (dawgFile)
+            delete dawgFile;
+        else
+            delete[] dawg;
+        dawg = edges;
+        dawgFile = 0;
+        dawgEdges = numEdges;
+
+        // Any lookup table, word counts, word array, length masks or infix
+        // index refer to the old forward DAWG
+        lookupMasks.clear();
+        lookupFirstChild.clear();
+        lookupChildren.clear();
+        wordCounts.clear();
+        wordRecords.clear();
+        wordMasks.clear();
+        dawgLengthMasks.clear();
+        lookupLengthMasks.clear();
+        delete[] gaddag;
+        gaddag = 0;
+        gaddagEdges = 0;
+    }
+
+    return true;
 }
 
 //---------------------------------------------------------------------------
-//  containsWord
+//  buildLookupTable
 //
-//! Determine whether the graph contains a word.
+//! Build a compiled lookup table from the forward DAWG, so that word lookups
+//! find the edge for each letter directly instead of scanning the edges of
+//! each node.  The table can only be built if every letter in the DAWG is an
+//! upper case letter from A to Z.
 //
-//! @param w the word to search for
+//! @return true if successful, false otherwise
 //---------------------------------------------------------------------------
 bool
-WordGraph::containsWord(const QString& w) const
+WordGraph::buildLookupTable()
 {
-    if (w.isEmpty())
-        return false;
+    lookupMasks.clear();
+    lookupFirstChild.clear();
+    lookupChildren.clear();
+    lookupLengthMasks.clear();
 
     if (!dawg)
-        return containsWordOld(w);
+        return false;
 
-    qint32 node = ROOT_NODE;
-    bool eow = false;
+    // Assign a table index to each distinct node reachable from the root
+    QHash<qint32, quint32> nodeIndexes;
+    QVector<qint32> nodes;
+    nodeIndexes.insert(TERMINAL_NODE, 0);
+    nodes.append(TERMINAL_NODE);
+    nodeIndexes.insert(ROOT_NODE, 1);
+    nodes.append(ROOT_NODE);
+
+    for (int i = 1; i < nodes.size(); ++i) {
+        for (qint32* edge = &dawg[nodes[i]]; ; ++edge) {
+            qint32 child = *edge & M_NODE_POINTER;
+            if (!nodeIndexes.contains(child)) {
+                nodeIndexes.insert(child, nodes.size());
+                nodes.append(child);
+            }
+            if (*edge & M_END_OF_NODE)
+                break;
+        }
+    }
 
-    for (int i = 0; i < w.length(); ++i) {
-        if (!node)
-            return false;
+    // Fill in the letter mask and child entries for each node, with child
+    // entries in letter order
+    QVector<quint32> masks (nodes.size(), 0);
+    QVector<quint32> firstChild (nodes.size(), 0);
+    QVector<quint32> children;
+    quint32 letterEntries[NUM_LOOKUP_LETTERS];
+
+    for (int i = 1; i < nodes.size(); ++i) {
+        quint32 mask = 0;
+        for (qint32* edge = &dawg[nodes[i]]; ; ++edge) {
+            int letter = ((*edge >> V_LETTER) & M_LETTER) - 'A';
+            if ((letter < 0) || (letter >= NUM_LOOKUP_LETTERS) ||
+                (mask & (1 << letter)))
+            {
+                return false;
+            }
 
-        QChar letter = w.at(i);
-        for (qint32* edge = &dawg[node]; ; ++edge) {
-            qint32 lc = *edge;
-            lc = lc >> V_LETTER;
-            lc = lc & M_LETTER;
-            char c = (char) lc;
+            mask |= (1 << letter);
+            quint32 child = nodeIndexes.value(*edge & M_NODE_POINTER);
+            letterEntries[letter] = (child << 1) |
+                ((*edge & M_END_OF_WORD) ? 1 : 0);
 
-            if (letter == c) {
-                node = (*edge & M_NODE_POINTER);
-                eow = (*edge & M_END_OF_WORD);
+            if (*edge & M_END_OF_NODE)
                 break;
-            }
+        }
 
-            if (*edge & M_END_OF_NODE)
-                return false;
+        masks[i] = mask;
+        firstChild[i] = children.size();
+        for (int letter = 0; letter < NUM_LOOKUP_LETTERS; ++letter) {
+            if (mask & (1 << letter))
+                children.append(letterEntries[letter]);
         }
     }
 
-    return eow;
+    lookupMasks = masks;
+    lookupFirstChild = firstChild;
+    lookupChildren = children;
+    return true;
 }
 
 //---------------------------------------------------------------------------
-//  search
+//  buildWordArray
 //
-//! Search for acceptable words matching a search specification.
+//! Build an array of fixed-width records of every word of the forward DAWG,
+//! in alphabetical order, with a mask of the letters of each word.  Pattern
+//! matches the DAWG cannot prune, and conditions like Include Letters and
+//! Consist Of that it cannot prune at all, are searched by scanning the
+//! records instead of traversing the DAWG.  The array can only be built if
+//! every letter in the DAWG is an upper case letter from A to Z.
 //
-//! @param spec the search specification
-//! @return a list of acceptable words
+//! @return true if successful, false otherwise
 //---------------------------------------------------------------------------
-QStringList
-WordGraph::search(const SearchSpec& spec) const
+bool
+WordGraph::buildWordArray()
 {
-    QStringList wordList;
-    if (spec.conditions.empty())
-        return wordList;
+    wordRecords.clear();
+    wordMasks.clear();
 
     if (!dawg)
-        return searchOld(spec);
+        return false;
 
-    QList<SearchCondition> posMatchConditions;
-    QList<SearchCondition> negMatchConditions;
-    int maxLength = MAX_WORD_LEN;
-    QString excludeLetters;
-    int numWildcardConditions = 0;
+    QByteArray records;
+    QVector<quint32> masks;
+    records.reserve(getNumWords() * WORD_RECORD_SIZE);
+    masks.reserve(getNumWords());
+
+    const qint32* frameEdges[MAX_WORD_LEN];
+    char record[WORD_RECORD_SIZE];
+    memset(record, 0, WORD_RECORD_SIZE);
+    int depth = 0;
+    frameEdges[0] = &dawg[ROOT_NODE];
+
+    while (true) {
+        const qint32* edge = frameEdges[depth];
+        if (!edge) {
+            if (!depth)
+                break;
+            record[depth] = 0;
+            --depth;
+            frameEdges[depth] = (*frameEdges[depth] & M_END_OF_NODE)
+                ? 0 : frameEdges[depth] + 1;
+            continue;
+        }
 
-    QListIterator<SearchCondition> it (spec.conditions);
-    while (it.hasNext()) {
-        const SearchCondition& condition = it.next();
+        int c = (*edge >> V_LETTER) & M_LETTER;
+        if ((c < 'A') || (c > 'Z'))
+            return false;
+        record[depth] = char(c);
+
+        if (*edge & M_END_OF_WORD) {
+            quint32 mask = 0;
+            for (int i = 0; i <= depth; ++i)
+                mask |= (1U << (record[i] - 'A'));
+            record[WORD_RECORD_SIZE - 1] = char(depth + 1);
+            records.append(record, WORD_RECORD_SIZE);
+            record[WORD_RECORD_SIZE - 1] = 0;
+            masks.append(mask);
+        }
 
-        switch (condition.type) {
-            case SearchCondition::PatternMatch:
-            case SearchCondition::AnagramMatch:
-            case SearchCondition::SubanagramMatch:
-            if (condition.negated)
-                negMatchConditions.append(condition);
-            else
-                posMatchConditions.append(condition);
-            if (condition.stringValue.contains("?") ||
-                condition.stringValue.contains("["))
-                ++numWildcardConditions;
-            break;
+        qint32 child = *edge & M_NODE_POINTER;
+        if (child && (depth + 1 < MAX_WORD_LEN)) {
+            ++depth;
+            frameEdges[depth] = &dawg[child];
+            continue;
+        }
 
-            case SearchCondition::Length:
-            if (condition.maxValue < maxLength)
-                maxLength = condition.maxValue;
-            break;
+        record[depth] = 0;
+        frameEdges[depth] = (*edge & M_END_OF_NODE) ? 0 : edge + 1;
+    }
 
-            case SearchCondition::IncludeLetters:
-            if (condition.negated)
-                excludeLetters += condition.stringValue;
-            break;
+    wordRecords = records;
+    wordMasks = masks;
+    return true;
+}
 
-            default: break;
+//---------------------------------------------------------------------------
+//  buildGaddag
+//
+//! Build an infix index from the words of the forward DAWG, so that Pattern
+//! matches anchored by letters in the middle of the pattern can start from
+//! those letters instead of the first letter of each word.  The index is a
+//! GADDAG: for each word and each nonempty prefix of the word, it contains
+//! the reversed prefix, a separator, and the rest of the word.
+//
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::buildGaddag(QString* errString)
+{
+    delete[] gaddag;
+    gaddag = 0;
+    gaddagEdges = 0;
+
+    if (!dawg)
+        return false;
+
+    SearchSpec spec;
+    SearchCondition condition;
+    condition.type = SearchCondition::PatternMatch;
+    condition.stringValue = "*";
+    spec.conditions.append(condition);
+    QStringList words = search(spec);
+
+    bool hasLetter[NUM_EDGE_LETTERS];
+    for (int i = 0; i < NUM_EDGE_LETTERS; ++i)
+        hasLetter[i] = false;
+    foreach (const QString& word, words) {
+        int length = word.length();
+        for (int i = 0; i < length; ++i) {
+            ushort c = word.at(i).unicode();
+            if (c < NUM_EDGE_LETTERS)
+                hasLetter[c] = true;
         }
     }
 
-    // Only replace wildcard matches with lower case letters if there is
-    // exactly one pattern using wildcards
-    // XXX: Commented out because it may be a reasonable default to use the
-    // lower case lettering as matched by the first such condition
-    //bool wildcardLower =(numWildcardConditions == 1);
-    bool wildcardLower = true;
+    // Each path begins with the last letter of its prefix, so the paths can
+    // be added in order one starting letter at a time, without holding all
+    // of them at once
+    QChar separator = QChar(ushort(INFIX_SEPARATOR));
+    DawgBuilder builder;
+    for (int c = 0; c < NUM_EDGE_LETTERS; ++c) {
+        if (!hasLetter[c])
+            continue;
+
+        QStringList paths;
+        foreach (const QString& word, words) {
+            int length = word.length();
+            for (int i = 0; i < length; ++i) {
+                if (word.at(i).unicode() == c) {
+                    paths.append(reverseString(word.left(i + 1)) + separator
+                                 + word.mid(i + 1));
+                }
+            }
+        }
+        paths.sort();
 
-    // If no match condition was specified, search for all words matching the
-    // other conditions
-    if (posMatchConditions.empty()) {
-        SearchCondition condition;
-        condition.type = SearchCondition::PatternMatch;
-        condition.stringValue = "*";
-        posMatchConditions.append(condition);
+        foreach (const QString& path, paths) {
+            if (!builder.addWord(path)) {
+                if (errString) {
+                    *errString = "The word '" + path + "' cannot be stored "
+                        "in the infix index.";
+                }
+                return false;
+            }
+        }
     }
 
-    map<QString, QString> finalWordSet;
-    map<QString, QString>::iterator sit;
-    int conditionNum = 0;
+    gaddag = builder.finish(&gaddagEdges, errString);
+    return (gaddag != 0);
+}
 
-    // Search for each condition separately, and take the conjunction or
-    // disjunction of the result sets. Search for positive conditions first,
-    // followed by negative conditions.
-    QListIterator<SearchCondition> mit (posMatchConditions +
+//---------------------------------------------------------------------------
+//  buildWordCounts
+//
+//! Annotate each edge of the forward DAWG with the number of words reached
+//! through it, so that words can be found by their index in alphabetical
+//! order, and the index of a word can be found, by following a single path
+//! from the root.
+//
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::buildWordCounts()
+{
+    wordCounts.clear();
+
+    if (!dawg)
+        return false;
+
+    // Count the words below each node, counting the children of a node
+    // before the node itself
+    QHash<qint32, qint32> nodeCounts;
+    nodeCounts.insert(TERMINAL_NODE, 0);
+    QVector<qint32> stack;
+    stack.append(ROOT_NODE);
+    qint32 lastEdge = ROOT_NODE;
+
+    while (!stack.isEmpty()) {
+        qint32 node = stack.last();
+        if (nodeCounts.contains(node)) {
+            stack.pop_back();
+            continue;
+        }
+
+        bool childrenCounted = true;
+        for (qint32* edge = &dawg[node]; ; ++edge) {
+            qint32 child = *edge & M_NODE_POINTER;
+            if (!nodeCounts.contains(child)) {
+                stack.append(child);
+                childrenCounted = false;
+            }
+            if (*edge & M_END_OF_NODE)
+                break;
+        }
+        if (!childrenCounted)
+            continue;
+
+        qint32 count = 0;
+        qint32* edge = &dawg[node];
+        for (; ; ++edge) {
+            if (*edge & M_END_OF_WORD)
+                ++count;
+            count += nodeCounts.value(*edge & M_NODE_POINTER);
+            if (*edge & M_END_OF_NODE)
+                break;
+        }
+        nodeCounts.insert(node, count);
+        lastEdge = qMax(lastEdge, qint32(edge - dawg));
+        stack.pop_back();
+    }
+
+    QVector<qint32> counts (lastEdge + 1, 0);
+    QHashIterator<qint32, qint32> it (nodeCounts);
+    while (it.hasNext()) {
+        it.next();
+        if (it.key() == TERMINAL_NODE)
+            continue;
+        for (qint32 i = it.key(); ; ++i) {
+            counts[i] = ((dawg[i] & M_END_OF_WORD) ? 1 : 0) +
+                nodeCounts.value(dawg[i] & M_NODE_POINTER);
+            if (dawg[i] & M_END_OF_NODE)
+                break;
+        }
+    }
+
+    wordCounts = counts;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  buildLengthMasks
+//
+//! Annotate each edge of the DAWGs, and each child entry of the lookup
+//! table if it has been built, with a mask of the lengths of the rest of
+//! the words reached through it, so that searches for words of some
+//! lengths do not descend into subgraphs with no words of those lengths.
+//
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::buildLengthMasks()
+{
+    dawgLengthMasks.clear();
+    rdawgLengthMasks.clear();
+    lookupLengthMasks.clear();
+
+    if (!dawg)
+        return false;
+
+    dawgLengthMasks = getEdgeLengthMasks(dawg);
+    if (rdawg)
+        rdawgLengthMasks = getEdgeLengthMasks(rdawg);
+
+    if (lookupMasks.isEmpty())
+        return true;
+
+    // Find the mask of each lookup table node, finding the masks of the
+    // children of a node before the node itself
+    const quint32* masks = lookupMasks.constData();
+    const quint32* firstChild = lookupFirstChild.constData();
+    const quint32* children = lookupChildren.constData();
+    QVector<qint32> nodeMasks (lookupMasks.size(), -1);
+    nodeMasks[TERMINAL_NODE] = 0;
+    QVector<quint32> stack;
+    stack.append(ROOT_NODE);
+
+    while (!stack.isEmpty()) {
+        quint32 node = stack.last();
+        if (nodeMasks[node] >= 0) {
+            stack.pop_back();
+            continue;
+        }
+
+        int numChildren = countBits(masks[node]);
+        const quint32* entries = &children[firstChild[node]];
+        bool childrenDone = true;
+        for (int i = 0; i < numChildren; ++i) {
+            quint32 child = entries[i] >> 1;
+            if (nodeMasks[child] < 0) {
+                stack.append(child);
+                childrenDone = false;
+            }
+        }
+        if (!childrenDone)
+            continue;
+
+        quint16 mask = 0;
+        for (int i = 0; i < numChildren; ++i) {
+            mask |= quint16(((entries[i] & 1) ? 2 : 0) |
+                            (nodeMasks[entries[i] >> 1] << 1));
+        }
+        nodeMasks[node] = mask;
+        stack.pop_back();
+    }
+
+    QVector<quint16> entryMasks (lookupChildren.size(), 0);
+    for (int i = 0; i < lookupChildren.size(); ++i) {
+        entryMasks[i] = quint16(((children[i] & 1) ? 2 : 0) |
+                                (nodeMasks[children[i] >> 1] << 1));
+    }
+    lookupLengthMasks = entryMasks;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  buildSuccinctReverseDawg
+//
+//! Replace the packed reverse DAWG with the same edges in the succinct
+//! encoding of SuccinctDawg, which holds most edges in a byte and a few
+//! bits of node pointer, and release the packed reverse DAWG and its length
+//! masks.  Front hooks and front extensions are then found in the succinct
+//! encoding, and patterns ending in letters are matched against the forward
+//! DAWG, so the reverse DAWG uses much less memory at some cost in speed.
+//
+//! @return true if successful, false if there is no packed reverse DAWG or
+//! it has more distinct letters than the encoding can hold
+//---------------------------------------------------------------------------
+bool
+WordGraph::buildSuccinctReverseDawg()
+{
+    if (!rdawg)
+        return false;
+
+    // The nodes follow one another from the root, so the edges end with
+    // the last edge of the node starting furthest along
+    qint32 lastNode = ROOT_NODE;
+    qint32 numEdges = ROOT_NODE;
+    for (qint32 i = ROOT_NODE; ; ++i) {
+        lastNode = qMax(lastNode, rdawg[i] & M_NODE_POINTER);
+        if ((rdawg[i] & M_END_OF_NODE) && (i >= lastNode)) {
+            numEdges = i + 1;
+            break;
+        }
+    }
+
+    // Edge 0 only stands for the terminal node
+    SuccinctDawg* succinct = new SuccinctDawg;
+    for (qint32 i = 0; i < numEdges; ++i) {
+        qint32 edge = i ? rdawg[i] : 0;
+        if (!succinct->addEdge(ushort((edge >> V_LETTER) & M_LETTER),
+                               (edge & M_END_OF_WORD) != 0,
+                               (edge & M_END_OF_NODE) != 0,
+                               edge & M_NODE_POINTER))
+        {
+            delete succinct;
+            return false;
+        }
+    }
+    succinct->finish();
+
+    if (rdawgFile) {
+        delete rdawgFile;
+        rdawgFile = 0;
+    }
+    else
+        delete[] rdawg;
+    rdawg = 0;
+    rdawgEdges = 0;
+    rdawgLengthMasks.clear();
+
+    delete succinctRdawg;
+    succinctRdawg = succinct;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  addWord
+//
+//! Add a word to the old-style graph.  Represent the word in both forward and
+//! reverse order for quick lookup in either direction.
+//
+//! @param w the word to add
+//---------------------------------------------------------------------------
+void
+WordGraph::addWord(const QString& w)
+{
+    if (w.isEmpty())
+        return;
+
+    addWordOld(w, false);
+    addWordOld(w, true);
+    ++numWords;
+}
+
+//---------------------------------------------------------------------------
+//  containsWord
+//
+//! Determine whether the graph contains a word.
+//
+//! @param w the word to search for
+//---------------------------------------------------------------------------
+bool
+WordGraph::containsWord(const QString& w) const
+{
+    if (w.isEmpty())
+        return false;
+
+    if (!dawg)
+        return containsWordOld(w);
+
+    if (!lookupMasks.isEmpty())
+        return containsWordLookup(w);
+
+    qint32 node = ROOT_NODE;
+    bool eow = false;
+
+    for (int i = 0; i < w.length(); ++i) {
+        if (!node)
+            return false;
+
+        QChar letter = w.at(i);
+        for (qint32* edge = &dawg[node]; ; ++edge) {
+            qint32 lc = *edge;
+            lc = lc >> V_LETTER;
+            lc = lc & M_LETTER;
+            char c = (char) lc;
+
+            if (letter == c) {
+                node = (*edge & M_NODE_POINTER);
+                eow = (*edge & M_END_OF_WORD);
+                break;
+            }
+
+            if (*edge & M_END_OF_NODE)
+                return false;
+        }
+    }
+
+    return eow;
+}
+
+//---------------------------------------------------------------------------
+//  containsWordLookup
+//
+//! Determine whether the graph contains a word, using the compiled lookup
+//! table.
+//
+//! @param w the word to search for
+//---------------------------------------------------------------------------
+bool
+WordGraph::containsWordLookup(const QString& w) const
+{
+    const quint32* masks = lookupMasks.constData();
+    const quint32* firstChild = lookupFirstChild.constData();
+    const quint32* children = lookupChildren.constData();
+
+    quint32 node = ROOT_NODE;
+    quint32 entry = 0;
+    int length = w.length();
+    for (int i = 0; i < length; ++i) {
+        if (!node)
+            return false;
+
+        int letter = w.at(i).unicode() - 'A';
+        if ((letter < 0) || (letter >= NUM_LOOKUP_LETTERS))
+            return false;
+
+        quint32 bit = 1 << letter;
+        quint32 mask = masks[node];
+        if (!(mask & bit))
+            return false;
+
+        entry = children[firstChild[node] + countBits(mask & (bit - 1))];
+        node = entry >> 1;
+    }
+
+    return (entry & 1);
+}
+
+//---------------------------------------------------------------------------
+//  containsWords
+//
+//! Determine whether the graph contains each of a list of words.  Each
+//! lookup resumes from the node reached by the prefix the word shares with
+//! the previous word in the list, so lists with words sharing prefixes next
+//! to each other, such as sorted lists or a word followed by its back
+//! hooks, are looked up faster than one word at a time.
+//
+//! @param words the words to search for
+//! @return a bit for each word, set if the graph contains the word
+//---------------------------------------------------------------------------
+QBitArray
+WordGraph::containsWords(const QStringList& words) const
+{
+    int numWords = words.size();
+    QBitArray found (numWords);
+
+    if (!dawg) {
+        for (int i = 0; i < numWords; ++i)
+            found.setBit(i, containsWordOld(words[i]));
+        return found;
+    }
+
+    // The node reached after each letter of the previous word, and whether
+    // the edge to it ends a word.  Only the first numReached letters of the
+    // previous word were found.
+    quint32 nodes[MAX_WORD_LEN + 1];
+    bool ends[MAX_WORD_LEN + 1];
+    nodes[0] = ROOT_NODE;
+    ends[0] = false;
+    const QString* previous = 0;
+    int numReached = 0;
+
+    for (int i = 0; i < numWords; ++i) {
+        const QString& word = words[i];
+        int length = word.length();
+        if (length > MAX_WORD_LEN) {
+            found.setBit(i, containsWord(word));
+            continue;
+        }
+
+        int prefixLength = 0;
+        int minLength = previous ? qMin(length, numReached) : 0;
+        while ((prefixLength < minLength) &&
+               (word.at(prefixLength) == previous->at(prefixLength)))
+        {
+            ++prefixLength;
+        }
+
+        numReached = prefixLength;
+        while (numReached < length) {
+            quint32 node = nodes[numReached];
+            bool eow = false;
+            if (!node || !followEdge(&node, &eow, word.at(numReached)))
+                break;
+            ++numReached;
+            nodes[numReached] = node;
+            ends[numReached] = eow;
+        }
+
+        if (length && (numReached == length) && ends[length])
+            found.setBit(i);
+        previous = &word;
+    }
+
+    return found;
+}
+
+//---------------------------------------------------------------------------
+//  followEdge
+//
+//! Follow the edge for a letter from a node of the forward DAWG, using the
+//! compiled lookup table if there is one.  Nodes are numbered as in the
+//! lookup table if there is one, or the DAWG otherwise.
+//
+//! @param node the node, returns the node reached by the edge
+//! @param eow returns whether the edge ends a word
+//! @param letter the letter
+//! @return true if the node has an edge for the letter, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::followEdge(quint32* node, bool* eow, const QChar& letter) const
+{
+    if (!lookupMasks.isEmpty()) {
+        int index = letter.unicode() - 'A';
+        if ((index < 0) || (index >= NUM_LOOKUP_LETTERS))
+            return false;
+
+        quint32 bit = 1 << index;
+        quint32 mask = lookupMasks[*node];
+        if (!(mask & bit))
+            return false;
+
+        quint32 entry = lookupChildren[lookupFirstChild[*node] +
+                                       countBits(mask & (bit - 1))];
+        *node = entry >> 1;
+        *eow = (entry & 1);
+        return true;
+    }
+
+    for (const qint32* edge = &dawg[*node]; ; ++edge) {
+        if (letter == QChar(ushort((*edge >> V_LETTER) & M_LETTER))) {
+            *node = (*edge & M_NODE_POINTER);
+            *eow = (*edge & M_END_OF_WORD);
+            return true;
+        }
+
+        if (*edge & M_END_OF_NODE)
+            return false;
+    }
+}
+
+//---------------------------------------------------------------------------
+//  hooks
+//
+//! Find the hook letters of a word: the letters A to Z that form a word when
+//! added to the front or back of the word.  Back hooks are the letters of
+//! the edges ending words below the word in the forward DAWG, and front
+//! hooks are found the same way below the reversed word in the reverse
+//! DAWG.  Bit 0 of each mask stands for A, bit 1 for B, and so on.  A mask
+//! also has INCOMPLETE_HOOKS set if a letter other than A to Z hooks the
+//! word, or if the graph has no DAWG to find the hooks in, so callers that
+//! need every hook know to look them up another way.
+//
+//! @param word the word, in upper case
+//! @param frontHooks returns the mask of front hook letters
+//! @param backHooks returns the mask of back hook letters
+//---------------------------------------------------------------------------
+void
+WordGraph::hooks(const QString& word, quint32* frontHooks, quint32*
+                 backHooks) const
+{
+    *frontHooks = 0;
+    *backHooks = 0;
+    if (word.isEmpty())
+        return;
+
+    if (!dawg) {
+        for (int i = 0; i < NUM_LOOKUP_LETTERS; ++i) {
+            QChar letter (ushort('A' + i));
+            if (containsWordOld(letter + word))
+                *frontHooks |= (1 << i);
+            if (containsWordOld(word + letter))
+                *backHooks |= (1 << i);
+        }
+        *frontHooks |= INCOMPLETE_HOOKS;
+        *backHooks |= INCOMPLETE_HOOKS;
+        return;
+    }
+
+    *backHooks = getHookMask(dawg, word);
+    if (rdawg)
+        *frontHooks = getHookMask(rdawg, reverseString(word));
+    else if (succinctRdawg)
+        *frontHooks = getHookMask(*succinctRdawg, reverseString(word));
+    else
+        *frontHooks = INCOMPLETE_HOOKS;
+}
+
+//---------------------------------------------------------------------------
+//  getHookMask
+//
+//! Find the letters A to Z that end a word when added after a sequence of
+//! letters in a DAWG.
+//
+//! @param edges the DAWG
+//! @param letters the letters
+//! @return the mask of letters, with bit 0 standing for A, and with
+//! INCOMPLETE_HOOKS set if another letter also ends a word
+//---------------------------------------------------------------------------
+quint32
+WordGraph::getHookMask(const qint32* edges, const QString& letters) const
+{
+    qint32 node = ROOT_NODE;
+    int length = letters.length();
+    for (int i = 0; (i < length) && node; ++i) {
+        ushort letter = letters.at(i).unicode();
+        const qint32* edge = &edges[node];
+        while (((*edge >> V_LETTER) & M_LETTER) != letter) {
+            if (*edge & M_END_OF_NODE)
+                return 0;
+            ++edge;
+        }
+        node = *edge & M_NODE_POINTER;
+    }
+
+    quint32 mask = 0;
+    if (!node)
+        return mask;
+
+    for (const qint32* edge = &edges[node]; ; ++edge) {
+        int index = ((*edge >> V_LETTER) & M_LETTER) - 'A';
+        if (*edge & M_END_OF_WORD) {
+            if ((index >= 0) && (index < NUM_LOOKUP_LETTERS))
+                mask |= (1 << index);
+            else
+                mask |= INCOMPLETE_HOOKS;
+        }
+        if (*edge & M_END_OF_NODE)
+            break;
+    }
+    return mask;
+}
+
+//---------------------------------------------------------------------------
+//  getHookMask
+//
+//! Find the letters A to Z that end a word when added after a sequence of
+//! letters in a DAWG in the succinct encoding.
+//
+//! @param edges the DAWG
+//! @param letters the letters
+//! @return the mask of letters, with bit 0 standing for A, and with
+//! INCOMPLETE_HOOKS set if another letter also ends a word
+//---------------------------------------------------------------------------
+quint32
+WordGraph::getHookMask(const SuccinctDawg& edges, const QString& letters)
+    const
+{
+    quint32 mask = 0;
+    qint32 node = edges.findNode(letters);
+    if (!node)
+        return mask;
+
+    for (qint32 edge = node; ; ++edge) {
+        int index = edges.getLetter(edge) - 'A';
+        if (edges.endsWord(edge)) {
+            if ((index >= 0) && (index < NUM_LOOKUP_LETTERS))
+                mask |= (1 << index);
+            else
+                mask |= INCOMPLETE_HOOKS;
+        }
+        if (edges.endsNode(edge))
+            break;
+    }
+    return mask;
+}
+
+//---------------------------------------------------------------------------
+//  search
+//
+//! Search for acceptable words matching a search specification.
+//
+//! @param spec the search specification
+//! @param numThreads the number of threads to use for each match condition
+//! @return a list of acceptable words
+//---------------------------------------------------------------------------
+QStringList
+WordGraph::search(const SearchSpec& spec, int numThreads) const
+{
+    QStringList wordList;
+    if (spec.conditions.empty())
+        return wordList;
+
+    if (!dawg)
+        return searchOld(spec);
+
+    QList<SearchCondition> posMatchConditions;
+    QList<SearchCondition> negMatchConditions;
+    int maxLength = MAX_WORD_LEN;
+    QString excludeLetters;
+    int numWildcardConditions = getMatchConditions(spec, &posMatchConditions,
+        &negMatchConditions, &maxLength, &excludeLetters);
+
+    // Only replace wildcard matches with lower case letters if there is
+    // exactly one pattern using wildcards
+    // XXX: Commented out because it may be a reasonable default to use the
+    // lower case lettering as matched by the first such condition
+    //bool wildcardLower =(numWildcardConditions == 1);
+    Q_UNUSED(numWildcardConditions);
+    bool wildcardLower = true;
+
+    WordSet finalWordSet;
+    WordSet::const_iterator sit;
+    int conditionNum = 0;
+
+    // Search for each condition separately, and take the conjunction or
+    // disjunction of the result sets. Search for positive conditions first,
+    // followed by negative conditions.
+    QListIterator<SearchCondition> mit (posMatchConditions +
                                         negMatchConditions);
     while (mit.hasNext()) {
         const SearchCondition& condition = mit.next();
-        QString unmatched = condition.stringValue;
         bool negated = condition.negated;
 
-        // Use set to eliminate duplicates since patterns with wildcards may
-        // match the same word in more than one way
-        map<QString, QString> wordSet;
-        stack <TraversalState> states;
-        QString word;
+        // Sort the results and eliminate duplicates since patterns with
+        // wildcards may match the same word in more than one way
+        WordSet wordSet;
+        if ((numThreads > 1) && !usesInfixIndex(condition)) {
+            searchParallel(condition, spec, maxLength, excludeLetters,
+                           numThreads, wordSet);
+        }
+        else {
+            searchCondition(condition, spec, maxLength, excludeLetters, -1,
+                            wordSet);
+        }
+        sortWordSet(wordSet);
+
+        // Take conjunction or disjunction with final result set
+        if (!conditionNum) {
+            finalWordSet.swap(wordSet);
+        }
+
+        else if (spec.conjunction) {
+            WordSet conjunctionSet;
+            combineWordSets(finalWordSet, wordSet, negated ?
+                            WordSetDifference : WordSetIntersection,
+                            conjunctionSet);
+            if (conjunctionSet.empty())
+                return wordList;
+            finalWordSet.swap(conjunctionSet);
+        }
+
+        else {
+            // FIXME: disjunction is broken for negated conditions! Fix this
+            // when disjunction is enabled in the UI.
+            WordSet disjunctionSet;
+            combineWordSets(finalWordSet, wordSet, WordSetUnion,
+                            disjunctionSet);
+            finalWordSet.swap(disjunctionSet);
+        }
+
+        ++conditionNum;
+    }
+
+    // Transform word set into word list and return it
+    for (sit = finalWordSet.begin(); sit != finalWordSet.end(); ++sit) {
+        wordList << (wildcardLower ? sit->second : sit->first);
+    }
+
+    return wordList;
+}
+
+//---------------------------------------------------------------------------
+//  blankVariations
+//
+//! Find the acceptable words that differ from a word by one letter played
+//! as a blank, in one traversal of the graph.  Each word is found by
+//! matching letters of the word where possible and playing the blank for
+//! the first letter that cannot be matched, so the letter played as a
+//! blank is in lower case, and words matching the word exactly are all in
+//! upper case.
+//
+//! @param word the word
+//! @param anagram whether to find anagrams of the word with one letter
+//! replaced by a blank, or else words matching the word with one letter
+//! replaced by a blank
+//! @return the words in alphabetical order
+//---------------------------------------------------------------------------
+QStringList
+WordGraph::blankVariations(const QString& word, bool anagram) const
+{
+    QStringList wordList;
+    int length = word.length();
+    if ((length < 1) || (length > MAX_WORD_LEN))
+        return wordList;
+
+    // Search for each blank position separately without a DAWG
+    if (!dawg) {
+        SearchSpec spec;
+        SearchCondition condition;
+        condition.type = anagram ? SearchCondition::AnagramMatch
+                                 : SearchCondition::PatternMatch;
+        QMap<QString, QString> wordMap;
+        for (int i = 0; i < length; ++i) {
+            condition.stringValue = word.left(i) + "?" + word.mid(i + 1);
+            spec.conditions.clear();
+            spec.conditions.append(condition);
+            foreach (const QString& found, search(spec))
+                wordMap.insert(found.toUpper(), found);
+        }
+        return wordMap.values();
+    }
+
+    char pattern[MAX_WORD_LEN];
+    int letterCounts[NUM_EDGE_LETTERS];
+    bool excluded[NUM_EDGE_LETTERS];
+    char lowerLetters[NUM_EDGE_LETTERS];
+    initLetterTables(QString(), excluded, lowerLetters);
+    for (int i = 0; i < NUM_EDGE_LETTERS; ++i)
+        letterCounts[i] = 0;
+    QString wordUpper = word.toUpper();
+    for (int i = 0; i < length; ++i) {
+        ushort c = wordUpper.at(i).unicode();
+        if (c >= NUM_EDGE_LETTERS)
+            return wordList;
+        pattern[i] = char(c);
+        ++letterCounts[c];
+    }
+
+    // One frame per letter of the current word: the edge being examined,
+    // and whether the blank was played for its letter
+    const qint32* frameEdges[MAX_WORD_LEN];
+    bool frameBlank[MAX_WORD_LEN];
+    char found[MAX_WORD_LEN];
+    char foundUpper[MAX_WORD_LEN];
+    bool blankPlayed = false;
+
+    int depth = 0;
+    frameEdges[0] = &dawg[ROOT_NODE];
+
+    // Edges of a node are in alphabetical order, so words are found in
+    // alphabetical order, each once
+    while (true) {
+        const qint32* edge = frameEdges[depth];
+
+        // All edges of this node have been examined, so return to the
+        // parent, restoring what its letter used
+        if (!edge) {
+            if (!depth)
+                break;
+            --depth;
+            edge = frameEdges[depth];
+            if (frameBlank[depth])
+                blankPlayed = false;
+            else if (anagram)
+                ++letterCounts[uchar(foundUpper[depth])];
+            frameEdges[depth] = (*edge & M_END_OF_NODE) ? 0 : edge + 1;
+            continue;
+        }
+
+        qint32 edgeValue = *edge;
+        const qint32* nextEdge = (edgeValue & M_END_OF_NODE) ? 0 : edge + 1;
+        int c = (edgeValue >> V_LETTER) & M_LETTER;
+        bool matched = anagram ? (letterCounts[c] > 0)
+                               : (c == uchar(pattern[depth]));
+        if (!matched && blankPlayed) {
+            frameEdges[depth] = nextEdge;
+            continue;
+        }
+
+        found[depth] = matched ? char(c) : lowerLetters[c];
+        foundUpper[depth] = char(c);
+        if (depth + 1 == length) {
+            if (edgeValue & M_END_OF_WORD)
+                wordList.append(QString::fromLatin1(found, length));
+            frameEdges[depth] = nextEdge;
+            continue;
+        }
+
+        qint32 child = edgeValue & M_NODE_POINTER;
+        if (!child) {
+            frameEdges[depth] = nextEdge;
+            continue;
+        }
+
+        if (!matched)
+            blankPlayed = true;
+        else if (anagram)
+            --letterCounts[c];
+        frameBlank[depth] = !matched;
+        ++depth;
+        frameEdges[depth] = &dawg[child];
+    }
+
+    return wordList;
+}
+
+//---------------------------------------------------------------------------
+//  editNeighbors
+//
+//! Find the acceptable words within an edit distance of a word, in one
+//! traversal of the graph.  A row of edit distances between the word and
+//! the letters of the path so far is kept for each depth, as in a
+//! Levenshtein automaton, and a branch is abandoned as soon as every
+//! distance in its row exceeds the maximum.  Swapping two adjacent letters
+//! counts as one edit if transpositions are allowed.
+//
+//! @param word the word
+//! @param maxDistance the maximum number of edits
+//! @param operations the edit operations allowed - see EditOperation
+//! @return the words in alphabetical order, including the word itself if
+//! it is acceptable
+//---------------------------------------------------------------------------
+QStringList
+WordGraph::editNeighbors(const QString& word, int maxDistance, int
+                         operations) const
+{
+    QStringList wordList;
+    int length = word.length();
+    if (!dawg || (maxDistance < 0) || (length > MAX_WORD_LEN))
+        return wordList;
+
+    char pattern[MAX_WORD_LEN];
+    QString wordUpper = word.toUpper();
+    for (int i = 0; i < length; ++i) {
+        ushort c = wordUpper.at(i).unicode();
+        if (c >= NUM_EDGE_LETTERS)
+            return wordList;
+        pattern[i] = char(c);
+    }
+
+    // Distances beyond the maximum are all the same as far as the search
+    // is concerned, so they are capped
+    int tooFar = maxDistance + 1;
+    int substituteCost = (operations & EditSubstitute) ? 1 : tooFar;
+    int insertCost = (operations & EditInsert) ? 1 : tooFar;
+    int deleteCost = (operations & EditDelete) ? 1 : tooFar;
+    bool transpose = (operations & EditTranspose);
+    int maxLength = length;
+    if (operations & EditInsert)
+        maxLength = qMin(length + maxDistance, int(MAX_WORD_LEN));
+
+    // Row d holds the distances between the first d letters of the path and
+    // each prefix of the word
+    int rows[MAX_WORD_LEN + 1][MAX_WORD_LEN + 1];
+    for (int j = 0; j <= length; ++j)
+        rows[0][j] = qMin(j * deleteCost, tooFar);
+
+    const qint32* frameEdges[MAX_WORD_LEN];
+    char found[MAX_WORD_LEN];
+
+    int depth = 0;
+    frameEdges[0] = &dawg[ROOT_NODE];
+
+    while (true) {
+        const qint32* edge = frameEdges[depth];
+        if (!edge) {
+            if (!depth)
+                break;
+            --depth;
+            edge = frameEdges[depth];
+            frameEdges[depth] = (*edge & M_END_OF_NODE) ? 0 : edge + 1;
+            continue;
+        }
+
+        qint32 edgeValue = *edge;
+        const qint32* nextEdge = (edgeValue & M_END_OF_NODE) ? 0 : edge + 1;
+        char c = char((edgeValue >> V_LETTER) & M_LETTER);
+        found[depth] = c;
+
+        // Compute the row for the path extended by this letter
+        const int* prevRow = rows[depth];
+        int* row = rows[depth + 1];
+        row[0] = qMin(prevRow[0] + insertCost, tooFar);
+        int minDistance = row[0];
+        for (int j = 1; j <= length; ++j) {
+            int d = prevRow[j - 1] + ((c == pattern[j - 1]) ? 0
+                                                            : substituteCost);
+            d = qMin(d, prevRow[j] + insertCost);
+            d = qMin(d, row[j - 1] + deleteCost);
+            if (transpose && depth && (j > 1) && (c == pattern[j - 2]) &&
+                (found[depth - 1] == pattern[j - 1]))
+            {
+                d = qMin(d, rows[depth - 1][j - 2] + 1);
+            }
+            row[j] = qMin(d, tooFar);
+            minDistance = qMin(minDistance, row[j]);
+        }
+
+        if ((edgeValue & M_END_OF_WORD) && (row[length] <= maxDistance))
+            wordList.append(QString::fromLatin1(found, depth + 1));
+
+        qint32 child = edgeValue & M_NODE_POINTER;
+        if (!child || (minDistance > maxDistance) ||
+            (depth + 1 >= maxLength))
+        {
+            frameEdges[depth] = nextEdge;
+            continue;
+        }
+
+        ++depth;
+        frameEdges[depth] = &dawg[child];
+    }
+
+    return wordList;
+}
+
+//---------------------------------------------------------------------------
+//  joinWords
+//
+//! Find the words of this graph that are also in another graph, or that are
+//! not in it, by walking the forward DAWGs of both graphs in step.  The
+//! edges of each node are in letter order, so the edge of the other graph
+//! matching each edge is found by moving forward through the edges of its
+//! node, and a subgraph is left as soon as the other graph has no words
+//! below it for an intersection.  No word is looked up on its own.
+//
+//! @param other the other graph
+//! @param difference whether to find the words not in the other graph
+//! instead of the words in it
+//! @param minLength the minimum length of words to find
+//! @param maxLength the maximum length of words to find
+//! @return the words found, in upper case and alphabetical order
+//---------------------------------------------------------------------------
+QStringList
+WordGraph::joinWords(const WordGraph& other, bool difference, int minLength,
+                     int maxLength) const
+{
+    QStringList words;
+    if (!dawg || !other.dawg)
+        return words;
+
+    if (maxLength > MAX_WORD_LEN)
+        maxLength = MAX_WORD_LEN;
+    if (maxLength < 1)
+        return words;
+
+    quint16 depthMasks[MAX_WORD_LEN];
+    const quint16* edgeMasks = (!dawgLengthMasks.isEmpty() &&
+        getDepthMasks(minLength, maxLength, depthMasks))
+        ? dawgLengthMasks.constData() : 0;
+
+    // One frame per letter of the current word: the edge of this graph
+    // being examined, and the first edge of the other graph not yet passed,
+    // or null if the other graph has no more edges at this node
+    const qint32* otherDawg = other.dawg;
+    const qint32* frameEdges[MAX_WORD_LEN];
+    const qint32* frameOtherEdges[MAX_WORD_LEN];
+    char word[MAX_WORD_LEN];
+
+    int depth = 0;
+    frameEdges[0] = &dawg[ROOT_NODE];
+    frameOtherEdges[0] = &otherDawg[ROOT_NODE];
+
+    while (depth >= 0) {
+        const qint32* edge = frameEdges[depth];
+        if (!edge) {
+            --depth;
+            continue;
+        }
+
+        qint32 edgeValue = *edge;
+        frameEdges[depth] = (edgeValue & M_END_OF_NODE) ? 0 : edge + 1;
+
+        // Skip edges through which no word has a length in range
+        if (edgeMasks && !(edgeMasks[edge - dawg] & depthMasks[depth]))
+            continue;
+
+        int c = (edgeValue >> V_LETTER) & M_LETTER;
+        const qint32* otherEdge = frameOtherEdges[depth];
+        while (otherEdge && (((*otherEdge >> V_LETTER) & M_LETTER) < c)) {
+            otherEdge = (*otherEdge & M_END_OF_NODE) ? 0 : otherEdge + 1;
+        }
+        frameOtherEdges[depth] = otherEdge;
+
+        bool matched = otherEdge &&
+            (((*otherEdge >> V_LETTER) & M_LETTER) == c);
+        if (!matched && !difference)
+            continue;
+
+        word[depth] = char(c);
+        int length = depth + 1;
+        bool inOther = matched && (*otherEdge & M_END_OF_WORD);
+        if ((edgeValue & M_END_OF_WORD) && (inOther != difference) &&
+            (length >= minLength))
+        {
+            words.append(QString::fromLatin1(word, length));
+        }
+
+        // Below an edge the other graph does not have, every word is in the
+        // difference
+        qint32 child = edgeValue & M_NODE_POINTER;
+        qint32 otherChild = matched ? (*otherEdge & M_NODE_POINTER) : 0;
+        if (child && (length < maxLength) && (otherChild || difference)) {
+            ++depth;
+            frameEdges[depth] = &dawg[child];
+            frameOtherEdges[depth] = otherChild ? &otherDawg[otherChild] : 0;
+        }
+    }
+
+    return words;
+}
+
+//---------------------------------------------------------------------------
+//  countMatches
+//
+//! Count the acceptable words matching a search specification without
+//! building a list of them.  If the only conditions are a Pattern match
+//! made of letters followed or preceded by a single *, and Length, the
+//! words below the node reached by the letters are counted directly.
+//
+//! @param spec the search specification
+//! @param numThreads the number of threads to use for each match condition
+//! @return the number of acceptable words
+//---------------------------------------------------------------------------
+int
+WordGraph::countMatches(const SearchSpec& spec, int numThreads) const
+{
+    if (spec.conditions.empty())
+        return 0;
+
+    int count = 0;
+    if (dawg && countSubtreeMatches(spec, &count))
+        return count;
+
+    WordCountVisitor visitor;
+    search(spec, &visitor, numThreads);
+    return visitor.getCount();
+}
+
+//---------------------------------------------------------------------------
+//  countSubtreeMatches
+//
+//! Count the words matching a search specification by counting the words
+//! below a single node, if the search specification allows it.
+//
+//! @param spec the search specification
+//! @param count returns the number of matching words
+//! @return true if the words were counted, false if the search
+//! specification has other conditions
+//---------------------------------------------------------------------------
+bool
+WordGraph::countSubtreeMatches(const SearchSpec& spec, int* count) const
+{
+    QString pattern = "*";
+    bool foundPattern = false;
+    int minLength = 0;
+    int maxLength = MAX_WORD_LEN;
+
+    QListIterator<SearchCondition> it (spec.conditions);
+    while (it.hasNext()) {
+        const SearchCondition& condition = it.next();
+        switch (condition.type) {
+            case SearchCondition::PatternMatch:
+            if (condition.negated || foundPattern)
+                return false;
+            foundPattern = true;
+            if (!condition.stringValue.isEmpty())
+                pattern = condition.stringValue;
+            break;
+
+            case SearchCondition::Length:
+            if (condition.minValue > minLength)
+                minLength = condition.minValue;
+            if (condition.maxValue < maxLength)
+                maxLength = condition.maxValue;
+            break;
+
+            default:
+            return false;
+        }
+    }
+
+    // The pattern must be letters with a single * at one end
+    pattern.replace(QRegExp("\\*+"), "*");
+    bool reversePattern = !pattern.endsWith("*");
+    if (!pattern.startsWith("*") && reversePattern)
+        return false;
+    QString letters = reversePattern ? reverseString(pattern.mid(1))
+                                     : pattern.left(pattern.length() - 1);
+    if (letters.contains(QRegExp("[*?\\[\\]]")))
+        return false;
+
+    const qint32* edges = reversePattern ? rdawg : dawg;
+    if (!edges)
+        return false;
+    *count = 0;
+    if (minLength > maxLength)
+        return true;
+
+    // Follow the letters from the root
+    qint32 node = ROOT_NODE;
+    bool eow = false;
+    int numLetters = letters.length();
+    for (int i = 0; i < numLetters; ++i) {
+        if (!node)
+            return true;
+
+        ushort letter = letters.at(i).unicode();
+        const qint32* edge = &edges[node];
+        while (((*edge >> V_LETTER) & M_LETTER) != letter) {
+            if (*edge & M_END_OF_NODE)
+                return true;
+            ++edge;
+        }
+        node = *edge & M_NODE_POINTER;
+        eow = (*edge & M_END_OF_WORD);
+    }
+
+    if (eow && (numLetters >= minLength) && (numLetters <= maxLength))
+        ++*count;
+    if (node && (numLetters < maxLength))
+        *count += getNumWords(edges, node, numLetters, minLength, maxLength);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  wordAt
+//
+//! Find the word at an index in the alphabetical list of words in the
+//! graph.  The word counts must have been built with buildWordCounts.
+//
+//! @param index the index of the word, starting from zero
+//! @return the word, or an empty string if the index is out of range
+//---------------------------------------------------------------------------
+QString
+WordGraph::wordAt(int index) const
+{
+    if (wordCounts.isEmpty() || (index < 0))
+        return QString();
+
+    QString word;
+    qint32 node = ROOT_NODE;
+    while (node) {
+        // Skip the words below each edge until the index is below an edge
+        qint32 i = node;
+        while (index >= wordCounts[i]) {
+            if (dawg[i] & M_END_OF_NODE)
+                return QString();
+            index -= wordCounts[i];
+            ++i;
+        }
+
+        word.append(QChar(ushort((dawg[i] >> V_LETTER) & M_LETTER)));
+        if (dawg[i] & M_END_OF_WORD) {
+            if (!index)
+                return word;
+            --index;
+        }
+        node = dawg[i] & M_NODE_POINTER;
+    }
+
+    return QString();
+}
+
+//---------------------------------------------------------------------------
+//  indexOf
+//
+//! Find the index of a word in the alphabetical list of words in the graph.
+//! The word counts must have been built with buildWordCounts.
+//
+//! @param word the word
+//! @return the index of the word, starting from zero, or -1 if the word is
+//! not in the graph
+//---------------------------------------------------------------------------
+int
+WordGraph::indexOf(const QString& word) const
+{
+    int first = 0;
+    int count = 0;
+    if (word.isEmpty() || !getPrefixRange(word, &first, &count) || !count ||
+        !containsWord(word))
+    {
+        return -1;
+    }
+
+    // A word comes before the longer words beginning with it
+    return first;
+}
+
+//---------------------------------------------------------------------------
+//  getPrefixWords
+//
+//! Find the first words in alphabetical order that begin with a prefix.
+//! The node reached by the prefix is located once, and only the subgraph
+//! below it is traversed, stopping as soon as enough words are found.
+//
+//! @param prefix the prefix, which is itself included if it is a word
+//! @param maxWords the maximum number of words to find
+//! @return the words, in alphabetical order
+//---------------------------------------------------------------------------
+QStringList
+WordGraph::getPrefixWords(const QString& prefix, int maxWords) const
+{
+    QStringList words;
+    if (!dawg || prefix.isEmpty() || (maxWords <= 0))
+        return words;
+
+    QString word = prefix.toUpper();
+    int length = word.length();
+    qint32 node = ROOT_NODE;
+    qint32 e = 0;
+    for (int i = 0; i < length; ++i) {
+        if (!node)
+            return words;
+
+        ushort letter = word.at(i).unicode();
+        e = node;
+        while (((dawg[e] >> V_LETTER) & M_LETTER) != letter) {
+            if (dawg[e] & M_END_OF_NODE)
+                return words;
+            ++e;
+        }
+        node = dawg[e] & M_NODE_POINTER;
+    }
+
+    if (dawg[e] & M_END_OF_WORD)
+        words.append(word);
+
+    // Depth-first traversal below the prefix node, holding the current
+    // edge at each depth, so words come out in alphabetical order
+    qint32 edges[MAX_WORD_LEN + 1];
+    int depth = 0;
+    if (node)
+        edges[depth++] = node;
+    while (depth && (words.size() < maxWords)) {
+        e = edges[depth - 1];
+        word.truncate(length + depth - 1);
+        word.append(QChar(ushort((dawg[e] >> V_LETTER) & M_LETTER)));
+        if (dawg[e] & M_END_OF_WORD)
+            words.append(word);
+
+        qint32 child = dawg[e] & M_NODE_POINTER;
+        if (child && (depth <= MAX_WORD_LEN)) {
+            edges[depth++] = child;
+            continue;
+        }
+
+        // Move to the next edge, leaving the nodes whose edges are done
+        while (depth && (dawg[edges[depth - 1]] & M_END_OF_NODE))
+            --depth;
+        if (depth)
+            ++edges[depth - 1];
+    }
+
+    return words;
+}
+
+//---------------------------------------------------------------------------
+//  getExtensions
+//
+//! Find the extensions of a word: the words formed by adding one or more
+//! letters to its front, its back, or both.  Only the subtree below the
+//! node reached by the word is traversed.  Back extensions are found below
+//! the word in the forward DAWG, front extensions below the reversed word
+//! in the reverse DAWG, and double extensions below the reversed word in
+//! the infix index, whose paths below it hold the rest of the reversed
+//! prefix, the separator, and the rest of the word.
+//
+//! @param word the word, in upper case
+//! @param type the kind of extensions
+//! @param maxLength the maximum length of extensions to find
+//! @param words returns the extensions, with the added letters in lower
+//! case, in alphabetical order
+//! @return true if successful, false if the graph has no structure to find
+//! the extensions in
+//---------------------------------------------------------------------------
+bool
+WordGraph::getExtensions(const QString& word, ExtensionType type, int
+                         maxLength, QStringList* words) const
+{
+    words->clear();
+    const qint32* edges = (type == BackExtensions) ? dawg
+        : (type == FrontExtensions) ? rdawg : gaddag;
+    const SuccinctDawg* succinctEdges =
+        (type == FrontExtensions) ? succinctRdawg : 0;
+    if (!edges && !succinctEdges)
+        return false;
+
+    int length = word.length();
+    if (maxLength > MAX_WORD_LEN)
+        maxLength = MAX_WORD_LEN;
+    if (!length || (maxLength <= length))
+        return true;
+
+    QString start = (type == BackExtensions) ? word : reverseString(word);
+    qint32 node = edges ? findNode(edges, start)
+                        : succinctEdges->findNode(start);
+    if (!node)
+        return true;
+
+    // Each path of the infix index also holds the separator
+    int maxPathLength = maxLength - length;
+    if (type == DoubleExtensions)
+        ++maxPathLength;
+    QStringList paths = edges
+        ? getSubtreePaths(edges, node, maxPathLength)
+        : succinctEdges->getSubtreePaths(node, maxPathLength);
+
+    if (type == BackExtensions) {
+        foreach (const QString& path, paths)
+            words->append(word + path.toLower());
+        return true;
+    }
+
+    // Front and double extensions are sorted by their upper case form.  A
+    // word holding the word more than once is only kept once, with the
+    // letters around its first occurrence in lower case.
+    QMap<QString, QString> extensions;
+    foreach (const QString& path, paths) {
+        QString front = path;
+        QString back;
+        if (type == DoubleExtensions) {
+            int separator = path.indexOf(QChar(ushort(INFIX_SEPARATOR)));
+            if ((separator < 1) || (separator == path.length() - 1))
+                continue;
+            front = path.left(separator);
+            back = path.mid(separator + 1);
+        }
+        front = reverseString(front);
+        QString upper = front + word + back;
+        if (!extensions.contains(upper))
+            extensions.insert(upper, front.toLower() + word + back.toLower());
+    }
+    *words = extensions.values();
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  findNode
+//
+//! Follow a sequence of letters from the root of a DAWG.
+//
+//! @param edges the DAWG
+//! @param letters the letters
+//! @return the node reached by the letters, or 0 if the letters are not
+//! all followed or no edges leave the node
+//---------------------------------------------------------------------------
+qint32
+WordGraph::findNode(const qint32* edges, const QString& letters) const
+{
+    qint32 node = ROOT_NODE;
+    int length = letters.length();
+    for (int i = 0; i < length; ++i) {
+        if (!node)
+            return 0;
+
+        ushort letter = letters.at(i).unicode();
+        const qint32* edge = &edges[node];
+        while (((*edge >> V_LETTER) & M_LETTER) != letter) {
+            if (*edge & M_END_OF_NODE)
+                return 0;
+            ++edge;
+        }
+        node = *edge & M_NODE_POINTER;
+    }
+    return node;
+}
+
+//---------------------------------------------------------------------------
+//  getSubtreePaths
+//
+//! Find the paths ending words below a node of a DAWG, by a depth-first
+//! traversal of the subtree below the node, so the paths come out in
+//! alphabetical order.
+//
+//! @param edges the DAWG
+//! @param node the node
+//! @param maxLength the maximum length of paths to find
+//! @return the letters of each path below the node
+//---------------------------------------------------------------------------
+QStringList
+WordGraph::getSubtreePaths(const qint32* edges, qint32 node, int maxLength)
+    const
+{
+    QStringList paths;
+    if (!node || (maxLength < 1))
+        return paths;
+    if (maxLength > MAX_WORD_LEN + 1)
+        maxLength = MAX_WORD_LEN + 1;
+
+    // Hold the current edge at each depth
+    qint32 stack[MAX_WORD_LEN + 1];
+    QString path;
+    int depth = 0;
+    stack[depth++] = node;
+    while (depth) {
+        qint32 e = stack[depth - 1];
+        path.truncate(depth - 1);
+        path.append(QChar(ushort((edges[e] >> V_LETTER) & M_LETTER)));
+        if (edges[e] & M_END_OF_WORD)
+            paths.append(path);
+
+        qint32 child = edges[e] & M_NODE_POINTER;
+        if (child && (depth < maxLength)) {
+            stack[depth++] = child;
+            continue;
+        }
+
+        // Move to the next edge, leaving the nodes whose edges are done
+        while (depth && (edges[stack[depth - 1]] & M_END_OF_NODE))
+            --depth;
+        if (depth)
+            ++stack[depth - 1];
+    }
+
+    return paths;
+}
+
+//---------------------------------------------------------------------------
+//  getFingerprint
+//
+//! Get a number identifying the words of the graph, so saved word indexes
+//! can be checked against it.  It is a hash of the number of words and of
+//! words sampled at evenly spaced indexes, so it is quick to compute but
+//! changes with the indexes of nearly any change to the words.  The word
+//! counts must have been built with buildWordCounts.
+//
+//! @return the fingerprint, or zero if the word counts are not built
+//---------------------------------------------------------------------------
+quint64
+WordGraph::getFingerprint() const
+{
+    if (wordCounts.isEmpty())
+        return 0;
+
+    // FNV-1a over the number of words and the sampled words
+    const int NUM_SAMPLES = 64;
+    int n = getNumWords();
+    QString str = QString::number(n);
+    for (int i = 0; (i < NUM_SAMPLES) && (i < n); ++i)
+        str += QChar(' ') + wordAt(int(qint64(n - 1) * i / NUM_SAMPLES));
+    if (n)
+        str += QChar(' ') + wordAt(n - 1);
+
+    quint64 hash = Q_UINT64_C(14695981039346656037);
+    for (int i = 0; i < str.length(); ++i) {
+        hash ^= str.at(i).unicode();
+        hash *= Q_UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+//---------------------------------------------------------------------------
+//  randomWord
+//
+//! Choose a word matching a search specification at random, with every
+//! matching word equally likely.  The word is drawn by index if possible,
+//! as described for sampleWords, and otherwise chosen from all matching
+//! words.
+//
+//! @param spec the search specification
+//! @param rng the random number generator
+//! @return the word, or an empty string if no word matches
+//---------------------------------------------------------------------------
+QString
+WordGraph::randomWord(const SearchSpec& spec, Rand* rng) const
+{
+    if (spec.conditions.empty())
+        return QString();
+
+    QStringList sample;
+    if (sampleWords(spec, 1, rng, &sample))
+        return sample.isEmpty() ? QString() : sample.first();
+
+    QStringList words = search(spec);
+    if (words.isEmpty())
+        return QString();
+    int index = (words.size() > 1) ? rng->rand(words.size() - 1) : 0;
+    return words[index].toUpper();
+}
+
+//---------------------------------------------------------------------------
+//  sampleWords
+//
+//! Draw distinct words matching a search specification at random, with
+//! every set of matching words equally likely, without finding all matching
+//! words.  Only specifications with a Pattern match and Length conditions
+//! can be sampled this way.  Words are drawn by index from the range of
+//! words beginning with the letters before the first wildcard of the
+//! pattern, found from the word counts of the graph, and kept if they match
+//! and were not drawn before.
+//
+//! @param spec the search specification
+//! @param numWords the number of words to draw
+//! @param rng the random number generator
+//! @param words returns the words drawn in upper case, in the order drawn
+//! @return true if the words were drawn, or no word matches, false if the
+//! specification cannot be sampled by index or too few matches were drawn
+//! after a number of tries
+//---------------------------------------------------------------------------
+bool
+WordGraph::sampleWords(const SearchSpec& spec, int numWords, Rand* rng,
+                       QStringList* words) const
+{
+    const int MAX_TOKENS = 2 * (MAX_WORD_LEN + 1);
+    const int MAX_DFA_STATES = 1024;
+    const int MAX_TRIES = 1000;
+
+    words->clear();
+    if (spec.conditions.empty() || (numWords <= 0))
+        return false;
+
+    QString pattern = "*";
+    bool foundPattern = false;
+    bool drawByIndex = !wordCounts.isEmpty();
+    int minLength = 0;
+    int maxLength = MAX_WORD_LEN;
+
+    QListIterator<SearchCondition> it (spec.conditions);
+    while (drawByIndex && it.hasNext()) {
+        const SearchCondition& condition = it.next();
+        switch (condition.type) {
+            case SearchCondition::PatternMatch:
+            if (condition.negated || foundPattern)
+                drawByIndex = false;
+            foundPattern = true;
+            if (!condition.stringValue.isEmpty())
+                pattern = condition.stringValue;
+            break;
+
+            case SearchCondition::Length:
+            if (condition.minValue > minLength)
+                minLength = condition.minValue;
+            if (condition.maxValue < maxLength)
+                maxLength = condition.maxValue;
+            break;
+
+            default:
+            drawByIndex = false;
+            break;
+        }
+    }
+
+    PatternDfa dfa;
+    if (drawByIndex) {
+        pattern.replace(QRegExp("\\*+"), "*");
+        LetterSet tokenLetters[MAX_TOKENS];
+        bool tokenStar[MAX_TOKENS];
+        bool tokenLower[MAX_TOKENS];
+        int numTokens = compilePattern(pattern, tokenLetters, tokenStar,
+                                       tokenLower);
+        if ((numTokens < 0) || (minLength > maxLength))
+            return true;
+
+        bool excluded[NUM_EDGE_LETTERS];
+        for (int i = 0; i < NUM_EDGE_LETTERS; ++i)
+            excluded[i] = false;
+        drawByIndex = dfa.compile(tokenLetters, tokenStar, tokenLower,
+                                  numTokens, excluded, MAX_DFA_STATES);
+    }
+
+    if (!drawByIndex)
+        return false;
+
+    int prefixLength = pattern.indexOf(QRegExp("[*?\\[]"));
+    if (prefixLength < 0)
+        prefixLength = pattern.length();
+
+    int first = 0;
+    int count = 0;
+    if (!getPrefixRange(pattern.left(prefixLength), &first, &count) ||
+        !count)
+    {
+        return true;
+    }
+
+    // Drawing most of a range is no cheaper than searching it
+    if ((numWords > 1) && (numWords > count / 2))
+        return false;
+
+    QSet<int> drawn;
+    int maxTries = MAX_TRIES * numWords;
+    for (int i = 0; (i < maxTries) && (words->size() < numWords) &&
+         (drawn.size() < count); ++i)
+    {
+        int index = first;
+        if (count > 1)
+            index += rng->rand(count - 1);
+        if (drawn.contains(index))
+            continue;
+        drawn.insert(index);
+        QString word = wordAt(index);
+        if ((word.length() >= minLength) && (word.length() <= maxLength) &&
+            dfa.matches(word))
+        {
+            words->append(word);
+        }
+    }
+    return (words->size() == numWords);
+}
+
+//---------------------------------------------------------------------------
+//  getPrefixRange
+//
+//! Find the range of indexes of the words beginning with a prefix, in the
+//! alphabetical list of words in the graph.
+//
+//! @param prefix the prefix
+//! @param first returns the index of the first word beginning with the
+//! prefix
+//! @param count returns the number of words beginning with the prefix
+//! @return true if successful, false if the word counts have not been built
+//---------------------------------------------------------------------------
+bool
+WordGraph::getPrefixRange(const QString& prefix, int* first, int* count)
+    const
+{
+    *first = 0;
+    *count = 0;
+    if (wordCounts.isEmpty())
+        return false;
+
+    int length = prefix.length();
+    if (!length) {
+        *count = getNumWords(ROOT_NODE);
+        return true;
+    }
+
+    int index = 0;
+    qint32 node = ROOT_NODE;
+    for (int i = 0; i < length; ++i) {
+        if (!node)
+            return true;
+
+        ushort letter = prefix.at(i).unicode();
+        qint32 e = node;
+        while (((dawg[e] >> V_LETTER) & M_LETTER) != letter) {
+            if (dawg[e] & M_END_OF_NODE)
+                return true;
+            index += wordCounts[e];
+            ++e;
+        }
+
+        if (i == length - 1) {
+            *first = index;
+            *count = wordCounts[e];
+            return true;
+        }
+
+        if (dawg[e] & M_END_OF_WORD)
+            ++index;
+        node = dawg[e] & M_NODE_POINTER;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  sortWordSet
+//
+//! Sort a word set by upper case word, and remove duplicate words, keeping
+//! the first form found of each word.  Word sets found by traversing the
+//! forward DAWG are often already in order, in which case nothing is moved.
+//
+//! @param wordSet the word set to sort
+//---------------------------------------------------------------------------
+void
+WordGraph::sortWordSet(WordSet& wordSet) const
+{
+    bool ordered = true;
+    WordSet::size_type size = wordSet.size();
+    for (WordSet::size_type i = 1; i < size; ++i) {
+        if (!(wordSet[i - 1].first < wordSet[i].first)) {
+            ordered = false;
+            break;
+        }
+    }
+
+    if (ordered)
+        return;
+
+    stable_sort(wordSet.begin(), wordSet.end(), lessThanWordPair);
+    wordSet.erase(unique(wordSet.begin(), wordSet.end(), equalWordPair),
+                  wordSet.end());
+}
+
+//---------------------------------------------------------------------------
+//  combineWordSets
+//
+//! Combine two sorted word sets by merging them in a single pass.  Words
+//! are taken from the first set wherever a word is in both sets.
+//
+//! @param a the first sorted word set
+//! @param b the second sorted word set
+//! @param operation the set operation to perform
+//! @param result returns the sorted combined word set
+//---------------------------------------------------------------------------
+void
+WordGraph::combineWordSets(const WordSet& a, const WordSet& b,
+                           WordSetOperation operation, WordSet& result) const
+{
+    WordSet::const_iterator ait = a.begin();
+    WordSet::const_iterator bit = b.begin();
+
+    if (operation != WordSetIntersection) {
+        result.reserve(operation == WordSetUnion ? a.size() + b.size()
+                                                 : a.size());
+    }
+
+    while ((ait != a.end()) && (bit != b.end())) {
+        if (ait->first < bit->first) {
+            if (operation != WordSetIntersection)
+                result.push_back(*ait);
+            ++ait;
+        }
+        else if (bit->first < ait->first) {
+            if (operation == WordSetUnion)
+                result.push_back(*bit);
+            ++bit;
+        }
+        else {
+            if (operation != WordSetDifference)
+                result.push_back(*ait);
+            ++ait;
+            ++bit;
+        }
+    }
+
+    if (operation != WordSetIntersection)
+        result.insert(result.end(), ait, a.end());
+    if (operation == WordSetUnion)
+        result.insert(result.end(), bit, b.end());
+}
+
+//---------------------------------------------------------------------------
+//  search
+//
+//! Search for acceptable words matching a search specification, passing
+//! each word to a visitor instead of building a list.  If the search has a
+//! single match condition that cannot match a word in more than one way, and
+//! a single thread is used, words are passed to the visitor as they are
+//! found, in no particular order.  Otherwise the words are collected as by
+//! the other form of search, and passed to the visitor in order.
+//
+//! @param spec the search specification
+//! @param visitor the visitor to receive each acceptable word
+//! @param numThreads the number of threads to use for each match condition
+//! @return false if the visitor stopped the search, true otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::search(const SearchSpec& spec, WordVisitor* visitor, int
+                  numThreads) const
+{
+    if (spec.conditions.empty())
+        return true;
+
+    QList<SearchCondition> posMatchConditions;
+    QList<SearchCondition> negMatchConditions;
+    int maxLength = MAX_WORD_LEN;
+    QString excludeLetters;
+    getMatchConditions(spec, &posMatchConditions, &negMatchConditions,
+                       &maxLength, &excludeLetters);
+
+    if (dawg && (numThreads <= 1) && negMatchConditions.empty() &&
+        (posMatchConditions.size() == 1) &&
+        matchesUniquely(posMatchConditions.first()))
+    {
+        WordSet unusedWordSet;
+        return searchCondition(posMatchConditions.first(), spec, maxLength,
+                               excludeLetters, -1, unusedWordSet, visitor);
+    }
+
+    QStringList wordList = search(spec, numThreads);
+    foreach (const QString& word, wordList) {
+        if (!visitor->visitWord(word))
+            return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  getMatchConditions
+//
+//! Separate the match conditions of a search specification from the
+//! conditions that restrict the traversal.  If there are no positive match
+//! conditions, a Pattern match condition matching all words is added.
+//
+//! @param spec the search specification
+//! @param posMatchConditions return the positive match conditions
+//! @param negMatchConditions return the negated match conditions
+//! @param maxLength return the maximum length of words to find
+//! @param excludeLetters return letters that must not appear in words
+//! @return the number of match conditions using wildcards
+//---------------------------------------------------------------------------
+int
+WordGraph::getMatchConditions(const SearchSpec& spec, QList<SearchCondition>*
+                              posMatchConditions, QList<SearchCondition>*
+                              negMatchConditions, int* maxLength, QString*
+                              excludeLetters) const
+{
+    int numWildcardConditions = 0;
+
+    QListIterator<SearchCondition> it (spec.conditions);
+    while (it.hasNext()) {
+        const SearchCondition& condition = it.next();
+
+        switch (condition.type) {
+            case SearchCondition::PatternMatch:
+            case SearchCondition::AnagramMatch:
+            case SearchCondition::SubanagramMatch:
+            if (condition.negated)
+                negMatchConditions->append(condition);
+            else
+                posMatchConditions->append(condition);
+            if (condition.stringValue.contains("?") ||
+                condition.stringValue.contains("["))
+                ++numWildcardConditions;
+            break;
+
+            case SearchCondition::Length:
+            if (condition.maxValue < *maxLength)
+                *maxLength = condition.maxValue;
+            break;
+
+            case SearchCondition::IncludeLetters:
+            if (condition.negated)
+                *excludeLetters += condition.stringValue;
+            break;
+
+            default: break;
+        }
+    }
+
+    // Letters words cannot consist of are excluded as well
+    if (!spec.allowedLetters.isEmpty()) {
+        for (ushort c = 'A'; c <= 'Z'; ++c) {
+            if (!spec.allowedLetters.contains(QChar(c)))
+                *excludeLetters += QChar(c);
+        }
+    }
+
+    // If no match condition was specified, search for all words matching the
+    // other conditions
+    if (posMatchConditions->empty()) {
+        SearchCondition condition;
+        condition.type = SearchCondition::PatternMatch;
+        condition.stringValue = "*";
+        posMatchConditions->append(condition);
+    }
+
+    return numWildcardConditions;
+}
+
+//---------------------------------------------------------------------------
+//  getMinLength
+//
+//! Get the minimum length of words matching the Length conditions of a
+//! search specification.
+//
+//! @param spec the search specification
+//! @return the minimum length
+//---------------------------------------------------------------------------
+int
+WordGraph::getMinLength(const SearchSpec& spec) const
+{
+    int minLength = 1;
+    QListIterator<SearchCondition> it (spec.conditions);
+    while (it.hasNext()) {
+        const SearchCondition& condition = it.next();
+        if ((condition.type == SearchCondition::Length) &&
+            (condition.minValue > minLength))
+        {
+            minLength = condition.minValue;
+        }
+    }
+    return minLength;
+}
+
+//---------------------------------------------------------------------------
+//  matchesUniquely
+//
+//! Determine whether the traversal for a match condition finds each word at
+//! most once.  A Pattern match with more than one * or an Anagram match with
+//! more than one character class can match a word in more than one way.
+//
+//! @param condition the match condition
+//! @return true if each word is found at most once
+//---------------------------------------------------------------------------
+bool
+WordGraph::matchesUniquely(const SearchCondition& condition) const
+{
+    QString pattern = condition.stringValue;
+    if (condition.type == SearchCondition::PatternMatch) {
+        pattern.replace(QRegExp("\\*+"), "*");
+        return (pattern.count('*') <= 1);
+    }
+    return (pattern.count('[') <= 1);
+}
+
+//---------------------------------------------------------------------------
+//  SearchJob
+//
+//! A job that searches the DAWG for words matching a single match
+//! condition.  Jobs take root edges one at a time from a shared counter
+//! until none are left, and collect their results separately.  The thread
+//! that submits the jobs takes part by calling searchAll.
+//---------------------------------------------------------------------------
+class WordGraph::SearchJob : public Job
+{
+    public:
+    SearchJob(const WordGraph* g, const SearchCondition& c, const SearchSpec&
+              s, int m, const QString& e, int n, QAtomicInt* next)
+        : Job(), graph(g), condition(c), spec(s), maxLength(m),
+          excludeLetters(e), numRootEdges(n), nextRootEdge(next) { }
+    ~SearchJob() { }
+
+    void searchAll() {
+        while (true) {
+            int rootEdge = nextRootEdge->fetchAndAddOrdered(1);
+            if (rootEdge >= numRootEdges)
+                break;
+            graph->searchCondition(condition, spec, maxLength,
+                                   excludeLetters, rootEdge, wordSet);
+        }
+    }
+
+    protected:
+    void run() { searchAll(); }
+
+    public:
+    WordSet wordSet;
+
+    private:
+    const WordGraph* graph;
+    const SearchCondition& condition;
+    const SearchSpec& spec;
+    int maxLength;
+    QString excludeLetters;
+    int numRootEdges;
+    QAtomicInt* nextRootEdge;
+};
+
+//---------------------------------------------------------------------------
+//  searchCondition
+//
+//! Search the DAWG for words matching a single match condition.
+//
+//! @param condition the match condition
+//! @param spec the search specification
+//! @param maxLength the maximum length of words to find
+//! @param excludeLetters letters that must not appear in found words
+//! @param rootEdge the index of the only root edge to traverse, or -1 to
+//! traverse all root edges, using the infix index if possible
+//! @param wordSet returns the matching words in the order found, paired
+//! with the form with wildcard matches in lower case
+//! @param visitor if not null, the visitor to receive each matching word
+//! instead of the word set
+//! @return false if the visitor stopped the search, true otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::searchCondition(const SearchCondition& condition, const
+                           SearchSpec& spec, int maxLength, const QString&
+                           excludeLetters, int rootEdge, WordSet& wordSet,
+                           WordVisitor* visitor) const
+{
+    if ((rootEdge < 0) && usesWordArray(condition)) {
+        return scanWordArray(condition, spec, maxLength, excludeLetters,
+                             wordSet, visitor);
+    }
+    else if ((rootEdge < 0) && usesInfixIndex(condition)) {
+        return searchInfix(condition, spec, maxLength, excludeLetters,
+                           wordSet, visitor);
+    }
+    else if (condition.type == SearchCondition::PatternMatch) {
+        return searchPattern(condition, spec, maxLength, excludeLetters,
+                             rootEdge, wordSet, visitor);
+    }
+    else if (isRackCondition(condition)) {
+        return searchRack(condition, spec, maxLength, excludeLetters,
+                          rootEdge, wordSet, visitor);
+    }
+    else {
+        return searchAnagrams(condition, spec, maxLength, excludeLetters,
+                              rootEdge, wordSet, visitor);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  searchParallel
+//
+//! Search the DAWG for words matching a single match condition using jobs
+//! on the shared worker pool and the calling thread, each traversing the
+//! subgraphs of different root edges.  Each
+//! word is found below exactly one root edge, and each thread finds it the
+//! same way the serial search does, so the merged results are identical to
+//! those of the serial search.
+//
+//! @param condition the match condition
+//! @param spec the search specification
+//! @param maxLength the maximum length of words to find
+//! @param excludeLetters letters that must not appear in found words
+//! @param numThreads the number of threads to use
+//! @param wordSet returns the matching words in the order found, paired
+//! with the form with wildcard matches in lower case
+//---------------------------------------------------------------------------
+void
+WordGraph::searchParallel(const SearchCondition& condition, const
+                          SearchSpec& spec, int maxLength, const QString&
+                          excludeLetters, int numThreads, WordSet& wordSet)
+                          const
+{
+    // Patterns beginning but not ending with * are matched against the
+    // reverse DAWG, if there is a packed one
+    const QString& pattern = condition.stringValue;
+    bool reversePattern = (condition.type == SearchCondition::PatternMatch)
+        && pattern.startsWith("*") && !pattern.endsWith("*") && rdawg;
+    const qint32* edges = reversePattern ? rdawg : dawg;
+    if (!edges)
+        return;
+
+    int numRootEdges = 1;
+    for (const qint32* edge = &edges[ROOT_NODE]; !(*edge & M_END_OF_NODE);
+         ++edge)
+    {
+        ++numRootEdges;
+    }
+
+    if (numThreads > numRootEdges)
+        numThreads = numRootEdges;
+
+    QAtomicInt nextRootEdge (0);
+    QList<QSharedPointer<SearchJob> > jobs;
+    for (int i = 0; i < numThreads; ++i) {
+        jobs.append(QSharedPointer<SearchJob>(new SearchJob(this, condition,
+            spec, maxLength, excludeLetters, numRootEdges, &nextRootEdge)));
+        if (i > 0) {
+            JobScheduler::getInstance()->submit(jobs[i],
+                JobScheduler::InteractivePriority);
+        }
+    }
+    jobs[0]->searchAll();
+
+    // Jobs that have not started once the calling thread runs out of root
+    // edges have nothing left to do.  Each word is found by only one job,
+    // so the results need only be sorted, in place of the serial traversal
+    // order.
+    for (int i = 0; i < jobs.size(); ++i) {
+        if (i > 0) {
+            jobs[i]->cancel();
+            jobs[i]->wait();
+        }
+        wordSet.insert(wordSet.end(), jobs[i]->wordSet.begin(),
+                       jobs[i]->wordSet.end());
+    }
+    sortWordSet(wordSet);
+}
+
+//---------------------------------------------------------------------------
+//  parseLetterClass
+//
+//! Parse a character class such as "[AEIOU]" or "[^AEIOU]" in a pattern.
+//
+//! @param pattern the pattern
+//! @param start the index of the opening bracket
+//! @param letters returns the set of letters matched by the class
+//! @return the index of the closing bracket, or the index of the last
+//! character of the pattern if the class is not closed
+//---------------------------------------------------------------------------
+int
+WordGraph::parseLetterClass(const QString& pattern, int start, LetterSet*
+                            letters) const
+{
+    letters->clear();
+    bool negated = false;
+    int length = pattern.length();
+    int i = start + 1;
+    for (; i < length; ++i) {
+        ushort c = pattern.at(i).unicode();
+        if (c == ']')
+            break;
+        else if (c == '^')
+            negated = true;
+        else if (c < NUM_EDGE_LETTERS)
+            letters->insert(c);
+    }
+
+    if (negated)
+        letters->invert();
+
+    return (i < length) ? i : length - 1;
+}
+
+//---------------------------------------------------------------------------
+//  compilePattern
+//
+//! Compile a pattern into a sequence of tokens, one for each letter, *, ?
+//! or character class.  Since redundant * characters are removed, the
+//! arrays need room for at most 2 * (MAX_WORD_LEN + 1) tokens.
+//
+//! @param pattern the pattern, with redundant * characters removed
+//! @param tokenLetters returns the set of letters matched by each token
+//! @param tokenStar returns whether each token is a *
+//! @param tokenLower returns whether letters matched by each token are
+//! shown in lower case
+//! @return the number of tokens, or -1 if the pattern requires more letters
+//! than any word has
+//---------------------------------------------------------------------------
+int
+WordGraph::compilePattern(const QString& pattern, LetterSet* tokenLetters,
+                          bool* tokenStar, bool* tokenLower) const
+{
+    int numTokens = 0;
+    int numLetterTokens = 0;
+    int patternLength = pattern.length();
+    for (int i = 0; i < patternLength; ++i) {
+        ushort c = pattern.at(i).unicode();
+        LetterSet& letters = tokenLetters[numTokens];
+        tokenStar[numTokens] = (c == '*');
+        tokenLower[numTokens] = (c != '*');
+        if ((c == '*') || (c == '?'))
+            letters.fill();
+        else if (c == '[')
+            i = parseLetterClass(pattern, i, &letters);
+        else {
+            letters.clear();
+            if (c < NUM_EDGE_LETTERS)
+                letters.insert(c);
+            tokenLower[numTokens] = false;
+        }
+
+        if (!tokenStar[numTokens])
+            ++numLetterTokens;
+        if (numLetterTokens > MAX_WORD_LEN)
+            return -1;
+        ++numTokens;
+    }
+    return numTokens;
+}
+
+//---------------------------------------------------------------------------
+//  searchAnagrams
+//
+//! Search the DAWG for words matching a single Anagram or Subanagram match
+//! condition.  The pattern is represented as a count of each letter, a count
+//! of blanks, and a list of character classes, and the traversal keeps one
+//! frame per letter of the current word, so no memory is allocated while
+//! traversing.  Letters are matched by the letter itself if possible, then
+//! by a character class, then by a blank, then by the * wildcard if present.
+//! If a letter matches more than one character class, each class is tried
+//! in turn.
+//
+//! @param condition the match condition
+//! @param spec the search specification
+//! @param maxLength the maximum length of words to find
+//! @param excludeLetters letters that must not appear in found words
+//! @param rootEdge the index of the only root edge to traverse, or -1 to
+//! traverse all root edges
+//! @param wordSet returns the matching words in the order found, paired
+//! with the form with wildcard matches in lower case
+//! @param visitor if not null, the visitor to receive each matching word
+//! instead of the word set
+//! @return false if the visitor stopped the search, true otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::searchAnagrams(const SearchCondition& condition, const
+                          SearchSpec& spec, int maxLength, const QString&
+                          excludeLetters, int rootEdge, WordSet& wordSet,
+                          WordVisitor* visitor) const
+{
+    // Values recorded for what was consumed from the pattern to match a
+    // letter.  Nonnegative values below NUM_EDGE_LETTERS are letters.
+    const int CONSUMED_NOTHING = -1;
+    const int CONSUMED_BLANK = -2;
+    const int CONSUMED_CLASS = NUM_EDGE_LETTERS;
+    int numSteps = 0;
+
+    if (maxLength > MAX_WORD_LEN)
+        maxLength = MAX_WORD_LEN;
+    if (maxLength < 1)
+        return true;
+
+    int letterCounts[NUM_EDGE_LETTERS];
+    bool excluded[NUM_EDGE_LETTERS];
+    char lowerLetters[NUM_EDGE_LETTERS];
+    initLetterTables(excludeLetters, excluded, lowerLetters);
+    for (int i = 0; i < NUM_EDGE_LETTERS; ++i)
+        letterCounts[i] = 0;
+
+    LetterSet classes[MAX_WORD_LEN];
+    bool classUsed[MAX_WORD_LEN];
+    int numClasses = 0;
+    int numBlanks = 0;
+    int remaining = 0;
+    bool wildcard = false;
+
+    // Letters and classes that can never be matched are only counted as
+    // remaining, so they prevent Anagram matches from completing
+    const QString& pattern = condition.stringValue;
+    int patternLength = pattern.length();
+    for (int i = 0; i < patternLength; ++i) {
+        ushort c = pattern.at(i).unicode();
+        if (c == '*') {
+            wildcard = true;
+            continue;
+        }
+
+        ++remaining;
+        if (c == '?')
+            ++numBlanks;
+        else if (c == '[') {
+            LetterSet letters;
+            i = parseLetterClass(pattern, i, &letters);
+            if (numClasses < MAX_WORD_LEN) {
+                classUsed[numClasses] = false;
+                classes[numClasses++] = letters;
+            }
+        }
+        else if (c < NUM_EDGE_LETTERS)
+            ++letterCounts[c];
+    }
+
+    bool subanagram = (condition.type == SearchCondition::SubanagramMatch);
+
+    // Anagram matches use every letter of the pattern, and without a *
+    // words can only be as long as the pattern
+    int minLength = getMinLength(spec);
+    if (!subanagram)
+        minLength = qMax(minLength, remaining);
+    if (!wildcard)
+        maxLength = qMin(maxLength, remaining);
+    quint16 depthMasks[MAX_WORD_LEN];
+    const quint16* edgeMasks = (!dawgLengthMasks.isEmpty() &&
+        getDepthMasks(minLength, maxLength, depthMasks))
+        ? dawgLengthMasks.constData() : 0;
+
+    // One frame per letter of the current word: the edge being examined,
+    // what was consumed from the pattern to match it, the first character
+    // class to try when matching it, and the required letters matched by
+    // the letters before it
+    const qint32* frameEdges[MAX_WORD_LEN];
+    int frameConsumed[MAX_WORD_LEN];
+    int frameNextClass[MAX_WORD_LEN];
+    quint32 frameMatched[MAX_WORD_LEN];
+    RequiredLetters required (spec.requiredLetters);
+    char word[MAX_WORD_LEN];
+    char wordUpper[MAX_WORD_LEN];
+
+    // When only one root edge is traversed, stop at the edge after it
+    const qint32* rootEdges = &dawg[ROOT_NODE];
+    const qint32* rootEnd = 0;
+    if (rootEdge >= 0) {
+        rootEdges += rootEdge;
+        rootEnd = rootEdges + 1;
+    }
+
+    int depth = 0;
+    frameEdges[0] = rootEdges;
+    frameNextClass[0] = 0;
+    frameMatched[0] = 0;
+
+    while (true) {
+        const qint32* edge = frameEdges[depth];
+        if (!depth && (edge == rootEnd))
+            edge = 0;
+
+        // All edges of this node have been examined, so return to the parent
+        // and restore what the parent's edge consumed.  If the parent's
+        // letter was matched by a character class, try matching it with the
+        // next class instead.
+        if (!edge) {
+            if (!depth)
+                break;
+            --depth;
+
+            int consumed = frameConsumed[depth];
+            if (consumed != CONSUMED_NOTHING)
+                ++remaining;
+            if (consumed >= CONSUMED_CLASS) {
+                classUsed[consumed - CONSUMED_CLASS] = false;
+                frameNextClass[depth] = consumed - CONSUMED_CLASS + 1;
+            }
+            else {
+                if (consumed >= 0)
+                    ++letterCounts[consumed];
+                else if (consumed == CONSUMED_BLANK)
+                    ++numBlanks;
+                frameEdges[depth] = (*frameEdges[depth] & M_END_OF_NODE)
+                    ? 0 : frameEdges[depth] + 1;
+                frameNextClass[depth] = 0;
+            }
+            continue;
+        }
+
+        qint32 edgeValue = *edge;
+        const qint32* nextEdge = (edgeValue & M_END_OF_NODE) ? 0 : edge + 1;
+        int c = (edgeValue >> V_LETTER) & M_LETTER;
+        int nextClass = frameNextClass[depth];
+
+        // Skip excluded letters, edges through which no word has a length
+        // in range, and edges below which the required letters still
+        // missing cannot fit
+        quint32 matched = required.isEmpty() ? 0
+            : required.match(frameMatched[depth], c);
+        if (excluded[c] ||
+            (edgeMasks && !(edgeMasks[edge - dawg] & depthMasks[depth])) ||
+            (required.getNumMissing(matched) > maxLength - depth - 1))
+        {
+            frameEdges[depth] = nextEdge;
+            continue;
+        }
+
+        // Find what the letter can consume from the pattern.  Identical
+        // classes are only tried once.
+        int consumed = CONSUMED_NOTHING;
+        int classIndex = -1;
+        if (!nextClass && letterCounts[c]) {
+            consumed = c;
+            --letterCounts[c];
+        }
+        else {
+            for (int i = nextClass; (i < numClasses) && (classIndex < 0);
+                 ++i)
+            {
+                if (classUsed[i] || !classes[i].contains(c))
+                    continue;
+                classIndex = i;
+                for (int j = 0; j < i; ++j) {
+                    if (!classUsed[j] && (classes[j] == classes[i])) {
+                        classIndex = -1;
+                        break;
+                    }
+                }
+            }
+
+            if (classIndex >= 0) {
+                consumed = CONSUMED_CLASS + classIndex;
+                classUsed[classIndex] = true;
+            }
+            else if (!nextClass && numBlanks) {
+                consumed = CONSUMED_BLANK;
+                --numBlanks;
+            }
+            else if (nextClass || !wildcard) {
+                frameEdges[depth] = nextEdge;
+                frameNextClass[depth] = 0;
+                continue;
+            }
+        }
+
+        if (consumed != CONSUMED_NOTHING)
+            --remaining;
+        word[depth] = (consumed == c) ? char(c) : lowerLetters[c];
+        wordUpper[depth] = char(c);
+
+        // Matching the same letter with a later class can only lead to
+        // longer words, so only check the word the first time
+        if (!nextClass && (edgeValue & M_END_OF_WORD) &&
+            (subanagram || !remaining) && !required.getNumMissing(matched) &&
+            !addFoundWord(word, wordUpper, depth + 1, spec, wordSet, visitor))
+        {
+            return false;
+        }
+
+        // Check now and then whether the visitor has cancelled the search
+        if (visitor && !(++numSteps % CANCEL_CHECK_STEPS) &&
+            visitor->isCancelled())
+        {
+            return false;
+        }
+
+        // Descend to the child if there is more of the pattern to match
+        qint32 child = edgeValue & M_NODE_POINTER;
+        if (child && (wildcard || remaining) && (depth + 1 < maxLength)) {
+            frameConsumed[depth] = consumed;
+            ++depth;
+            frameEdges[depth] = &dawg[child];
+            frameNextClass[depth] = 0;
+            frameMatched[depth] = matched;
+            continue;
+        }
+
+        // Otherwise restore the pattern and move on to the next edge.  No
+        // other class would lead to a descent either.
+        if (consumed != CONSUMED_NOTHING)
+            ++remaining;
+        if (consumed >= CONSUMED_CLASS)
+            classUsed[consumed - CONSUMED_CLASS] = false;
+        else if (consumed >= 0)
+            ++letterCounts[consumed];
+        else if (consumed == CONSUMED_BLANK)
+            ++numBlanks;
+        frameEdges[depth] = nextEdge;
+        frameNextClass[depth] = 0;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  usesWordArray
+//
+//! Determine whether a match condition is searched by scanning the word
+//! array: a Pattern match of only * or one whose letters are all at fixed
+//! positions, starting with ?, so that the DAWG cannot prune by its first
+//! letters.
+//
+//! @param condition the match condition
+//! @return true if the condition is searched by scanning the word array
+//---------------------------------------------------------------------------
+bool
+WordGraph::usesWordArray(const SearchCondition& condition) const
+{
+    if (wordMasks.isEmpty() ||
+        (condition.type != SearchCondition::PatternMatch))
+    {
+        return false;
+    }
+
+    QString pattern = condition.stringValue;
+    pattern.replace(QRegExp("\\*+"), "*");
+    if (pattern == "*")
+        return true;
+
+    int length = pattern.length();
+    if (!length || (length > MAX_WORD_LEN) || (pattern.at(0) != '?'))
+        return false;
+    for (int i = 0; i < length; ++i) {
+        ushort c = pattern.at(i).unicode();
+        if ((c != '?') && ((c < 'A') || (c > 'Z')))
+            return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  recordMatches
+//
+//! Determine whether a word record matches a pattern record in every byte
+//! selected by a mask record, comparing all the bytes at once.
+//
+//! @param record the word record
+//! @param pattern the pattern record
+//! @param care the mask record, with each byte to compare set to 0xff and
+//! each other byte set to zero
+//! @return true if the record matches
+//---------------------------------------------------------------------------
+static inline bool
+recordMatches(const char* record, const char* pattern, const char* care)
+{
+#if defined(__SSE2__)
+    __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(record));
+    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(care));
+    __m128i diff = _mm_and_si128(_mm_xor_si128(r, p), c);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) ==
+        0xffff;
+#else
+    quint64 r[2], p[2], c[2];
+    memcpy(r, record, WORD_RECORD_SIZE);
+    memcpy(p, pattern, WORD_RECORD_SIZE);
+    memcpy(c, care, WORD_RECORD_SIZE);
+    return !(((r[0] ^ p[0]) & c[0]) | ((r[1] ^ p[1]) & c[1]));
+#endif
+}
+
+//---------------------------------------------------------------------------
+//  scanWordArray
+//
+//! Search the word array for words matching a single Pattern match
+//! condition of only * or of letters at fixed positions.  The pattern is
+//! compiled into a pattern record and a mask record compared against each
+//! word record at once, and the letter masks of the words are compared
+//! against the letters the search requires, excludes or allows, so only
+//! words passing both are built as strings and checked against the rest
+//! of the search specification.
+//
+//! @param condition the match condition
+//! @param spec the search specification
+//! @param maxLength the maximum length of words to find
+//! @param excludeLetters letters that must not appear in found words
+//! @param wordSet returns the matching words in alphabetical order, paired
+//! with the form with ? matches in lower case
+//! @param visitor if not null, the visitor to receive each matching word
+//! instead of the word set
+//! @return false if the visitor stopped the search, true otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::scanWordArray(const SearchCondition& condition, const SearchSpec&
+                         spec, int maxLength, const QString& excludeLetters,
+                         WordSet& wordSet, WordVisitor* visitor) const
+{
+    const quint32 ALL_LETTERS = (1U << NUM_LOOKUP_LETTERS) - 1;
+
+    // Compile a fixed-length pattern into records, comparing the length
+    // byte too
+    char patternRecord[WORD_RECORD_SIZE];
+    char careRecord[WORD_RECORD_SIZE];
+    bool lowerPosition[MAX_WORD_LEN];
+    memset(patternRecord, 0, WORD_RECORD_SIZE);
+    memset(careRecord, 0, WORD_RECORD_SIZE);
+    for (int i = 0; i < MAX_WORD_LEN; ++i)
+        lowerPosition[i] = false;
+
+    int minLength = 1;
+    if (maxLength > MAX_WORD_LEN)
+        maxLength = MAX_WORD_LEN;
+
+    const QString& pattern = condition.stringValue;
+    bool fixedLength = !pattern.contains('*');
+    if (fixedLength) {
+        int length = pattern.length();
+        for (int i = 0; i < length; ++i) {
+            ushort c = pattern.at(i).unicode();
+            if (c == '?') {
+                lowerPosition[i] = true;
+                continue;
+            }
+            patternRecord[i] = char(c);
+            careRecord[i] = char(0xff);
+        }
+        patternRecord[WORD_RECORD_SIZE - 1] = char(length);
+        careRecord[WORD_RECORD_SIZE - 1] = char(0xff);
+        minLength = qMax(minLength, length);
+        maxLength = qMin(maxLength, length);
+    }
+
+    // Letters every word must contain, and letters words may contain
+    quint32 required = 0;
+    quint32 allowed = ALL_LETTERS;
+    for (int i = 0; i < excludeLetters.length(); ++i) {
+        int c = excludeLetters.at(i).unicode() - 'A';
+        if ((c >= 0) && (c < NUM_LOOKUP_LETTERS))
+            allowed &= ~(1U << c);
+    }
+
+    QListIterator<SearchCondition> it (spec.conditions);
+    while (it.hasNext()) {
+        const SearchCondition& specCondition = it.next();
+        switch (specCondition.type) {
+            case SearchCondition::Length:
+            minLength = qMax(minLength, specCondition.minValue);
+            maxLength = qMin(maxLength, specCondition.maxValue);
+            break;
+
+            case SearchCondition::IncludeLetters:
+            if (!specCondition.negated) {
+                const QString& letters = specCondition.stringValue;
+                for (int i = 0; i < letters.length(); ++i) {
+                    int c = letters.at(i).unicode() - 'A';
+                    if ((c >= 0) && (c < NUM_LOOKUP_LETTERS))
+                        required |= (1U << c);
+                }
+            }
+            break;
+
+            // Words consisting entirely of the letters can only contain
+            // those letters
+            case SearchCondition::ConsistOf:
+            if (specCondition.minValue >= 100) {
+                quint32 letterMask = 0;
+                const QString& letters = specCondition.stringValue;
+                for (int i = 0; i < letters.length(); ++i) {
+                    int c = letters.at(i).unicode() - 'A';
+                    if ((c >= 0) && (c < NUM_LOOKUP_LETTERS))
+                        letterMask |= (1U << c);
+                }
+                allowed &= letterMask;
+            }
+            break;
+
+            default: break;
+        }
+    }
+
+    if ((minLength > maxLength) || (required & ~allowed))
+        return true;
+
+    const char* records = wordRecords.constData();
+    const quint32* masks = wordMasks.constData();
+    int numWords = wordMasks.size();
+    char word[MAX_WORD_LEN];
+    for (int i = 0; i < numWords; ++i) {
+        // Check now and then whether the visitor has cancelled the search
+        if (visitor && !((i + 1) % CANCEL_CHECK_STEPS) &&
+            visitor->isCancelled())
+        {
+            return false;
+        }
+
+        quint32 mask = masks[i];
+        if ((mask & required) != required)
+            continue;
+        if (mask & ~allowed)
+            continue;
+
+        const char* record = records + i * WORD_RECORD_SIZE;
+        int length = record[WORD_RECORD_SIZE - 1];
+        if ((length < minLength) || (length > maxLength))
+            continue;
+        if (fixedLength && !recordMatches(record, patternRecord, careRecord))
+            continue;
+
+        for (int j = 0; j < length; ++j) {
+            word[j] = lowerPosition[j] ? char(record[j] - 'A' + 'a')
+                                       : record[j];
+        }
+        if (!addFoundWord(word, record, length, spec, wordSet, visitor))
+            return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  isRackCondition
+//
+//! Determine whether an Anagram or Subanagram match condition can be
+//! searched as a rack of tiles by searchRack: whether the lookup table is
+//! built and the pattern holds only the letters A to Z and blanks.
+//
+//! @param condition the match condition
+//! @return true if the condition can be searched as a rack
+//---------------------------------------------------------------------------
+bool
+WordGraph::isRackCondition(const SearchCondition& condition) const
+{
+    if (lookupMasks.isEmpty() ||
+        ((condition.type != SearchCondition::AnagramMatch) &&
+         (condition.type != SearchCondition::SubanagramMatch)))
+    {
+        return false;
+    }
+
+    const QString& pattern = condition.stringValue;
+    int length = pattern.length();
+    if (!length || (length > MAX_WORD_LEN))
+        return false;
+    for (int i = 0; i < length; ++i) {
+        ushort c = pattern.at(i).unicode();
+        if ((c != '?') && ((c < 'A') || (c > 'Z')))
+            return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  searchRack
+//
+//! Search the lookup table for words that can be made from a rack of
+//! tiles: an Anagram or Subanagram match condition of letters and blanks.
+//! The traversal keeps a count of each letter, the number of blanks and a
+//! mask of the letters left on the rack, and only follows the edges of a
+//! node whose letters are in the mask, or all of them while a blank is
+//! left.  A letter is played from the rack if possible and as a blank
+//! otherwise, so each word is reached by exactly one path, with the blanks
+//! in lower case and no duplicates to remove.
+//
+//! @param condition the match condition
+//! @param spec the search specification
+//! @param maxLength the maximum length of words to find
+//! @param excludeLetters letters that must not appear in found words
+//! @param rootEdge the index of the only root edge to traverse, or -1 to
+//! traverse all root edges
+//! @param wordSet returns the matching words in the order found, paired
+//! with the form with blanks in lower case
+//! @param visitor if not null, the visitor to receive each matching word
+//! instead of the word set
+//! @return false if the visitor stopped the search, true otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::searchRack(const SearchCondition& condition, const SearchSpec&
+                      spec, int maxLength, const QString& excludeLetters, int
+                      rootEdge, WordSet& wordSet, WordVisitor* visitor) const
+{
+    const quint32* masks = lookupMasks.constData();
+    const quint32* firstChild = lookupFirstChild.constData();
+    const quint32* children = lookupChildren.constData();
+    const quint32 ALL_LETTERS = (1U << NUM_LOOKUP_LETTERS) - 1;
+    int numSteps = 0;
+
+    if (maxLength > MAX_WORD_LEN)
+        maxLength = MAX_WORD_LEN;
+    if (maxLength < 1)
+        return true;
+
+    bool excluded[NUM_EDGE_LETTERS];
+    char lowerLetters[NUM_EDGE_LETTERS];
+    initLetterTables(excludeLetters, excluded, lowerLetters);
+    quint32 allowed = 0;
+    for (int i = 0; i < NUM_LOOKUP_LETTERS; ++i) {
+        if (!excluded['A' + i])
+            allowed |= (1U << i);
+    }
+
+    int letterCounts[NUM_LOOKUP_LETTERS];
+    for (int i = 0; i < NUM_LOOKUP_LETTERS; ++i)
+        letterCounts[i] = 0;
+    quint32 available = 0;
+    int numBlanks = 0;
+    const QString& pattern = condition.stringValue;
+    int remaining = pattern.length();
+    for (int i = 0; i < remaining; ++i) {
+        ushort c = pattern.at(i).unicode();
+        if (c == '?') {
+            ++numBlanks;
+        }
+        else {
+            ++letterCounts[c - 'A'];
+            available |= (1U << (c - 'A'));
+        }
+    }
+
+    bool subanagram = (condition.type == SearchCondition::SubanagramMatch);
+
+    // Words can only be as long as the rack, and Anagram matches use the
+    // whole rack
+    int minLength = subanagram ? getMinLength(spec) : remaining;
+    maxLength = qMin(maxLength, remaining);
+    quint16 depthMasks[MAX_WORD_LEN];
+    const quint16* entryMasks = (!lookupLengthMasks.isEmpty() &&
+        getDepthMasks(minLength, maxLength, depthMasks))
+        ? lookupLengthMasks.constData() : 0;
+
+    // When only one root edge is traversed, only follow its letter
+    quint32 rootLetters = ALL_LETTERS;
+    if (rootEdge >= 0) {
+        int c = (dawg[ROOT_NODE + rootEdge] >> V_LETTER) & M_LETTER;
+        rootLetters = 1U << (c - 'A');
+    }
+
+    // One frame per letter of the current word: the node, the letters of
+    // its edges left to follow, the letter followed and whether it was
+    // played as a blank, and the required letters matched by the letters
+    // before it
+    quint32 frameNodes[MAX_WORD_LEN];
+    quint32 framePending[MAX_WORD_LEN];
+    int frameLetters[MAX_WORD_LEN];
+    bool frameBlanks[MAX_WORD_LEN];
+    quint32 frameMatched[MAX_WORD_LEN];
+    RequiredLetters required (spec.requiredLetters);
+    char word[MAX_WORD_LEN];
+    char wordUpper[MAX_WORD_LEN];
+
+    int depth = 0;
+    frameNodes[0] = ROOT_NODE;
+    framePending[0] = masks[ROOT_NODE] & rootLetters & allowed &
+        (numBlanks ? ALL_LETTERS : available);
+    frameMatched[0] = 0;
+
+    while (true) {
+        quint32 pending = framePending[depth];
+
+        // All edges of this node have been followed, so return to the
+        // parent and put the parent's tile back on the rack
+        if (!pending) {
+            if (!depth)
+                break;
+            --depth;
+            int letter = frameLetters[depth];
+            ++remaining;
+            if (frameBlanks[depth])
+                ++numBlanks;
+            else if (!letterCounts[letter]++)
+                available |= (1U << letter);
+            continue;
+        }
+
+        quint32 bit = pending & (~pending + 1);
+        framePending[depth] = pending & ~bit;
+        int letter = countBits(bit - 1);
+        quint32 node = frameNodes[depth];
+        quint32 entryIndex = firstChild[node] +
+            countBits(masks[node] & (bit - 1));
+
+        // Skip edges through which no word has a length in range, and
+        // edges below which the required letters still missing cannot fit
+        if (entryMasks && !(entryMasks[entryIndex] & depthMasks[depth]))
+            continue;
+        quint32 matched = required.isEmpty() ? 0
+            : required.match(frameMatched[depth], 'A' + letter);
+        if (required.getNumMissing(matched) > maxLength - depth - 1)
+            continue;
+        quint32 entry = children[entryIndex];
+
+        // Play the letter from the rack if possible, or as a blank
+        bool blank = !(available & bit);
+        if (blank)
+            --numBlanks;
+        else if (!--letterCounts[letter])
+            available &= ~bit;
+        --remaining;
+
+        char c = char('A' + letter);
+        wordUpper[depth] = c;
+        word[depth] = blank ? lowerLetters[uchar(c)] : c;
+
+        if ((entry & 1) && (subanagram || !remaining) &&
+            !required.getNumMissing(matched) &&
+            !addFoundWord(word, wordUpper, depth + 1, spec, wordSet, visitor))
+        {
+            return false;
+        }
 
-        bool wildcard = false;
-        bool reversePattern = false;
+        // Check now and then whether the visitor has cancelled the search
+        if (visitor && !(++numSteps % CANCEL_CHECK_STEPS) &&
+            visitor->isCancelled())
+        {
+            return false;
+        }
 
-        // If Pattern match is unspecified, change it to a single wildcard
-        // character.  Also, remove any redundant wildcards.
-        if (condition.type == SearchCondition::PatternMatch) {
-            if (unmatched.isEmpty())
-                unmatched = "*";
-            else
-                unmatched.replace(QRegExp("\\*+"), "*");
+        // Descend to the child if any of its letters can still be played
+        quint32 child = entry >> 1;
+        quint32 childPending = masks[child] & allowed &
+            (numBlanks ? ALL_LETTERS : available);
+        if (childPending && remaining && (depth + 1 < maxLength)) {
+            frameLetters[depth] = letter;
+            frameBlanks[depth] = blank;
+            ++depth;
+            frameNodes[depth] = child;
+            framePending[depth] = childPending;
+            frameMatched[depth] = matched;
+            continue;
+        }
 
-            if ((unmatched.left(1) == "*") && (unmatched.right(1) != "*")) {
-                unmatched = reverseString(unmatched);
-                reversePattern = true;
-            }
+        // Otherwise put the tile back and move on to the next edge
+        ++remaining;
+        if (blank)
+            ++numBlanks;
+        else if (!letterCounts[letter]++)
+            available |= bit;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  searchPattern
+//
+//! Search the DAWG for words matching a single Pattern match condition.  The
+//! pattern is compiled into a list of tokens, each matching a single letter
+//! or any number of letters.  The traversal uses a bounded array of frames,
+//! each examining the edges of a node against one token, and the current
+//! word is kept in a buffer shared by all frames, so no memory is allocated
+//! while traversing.  Patterns beginning but not ending with * are matched
+//! against the reverse DAWG.
+//
+//! @param condition the match condition
+//! @param spec the search specification
+//! @param maxLength the maximum length of words to find
+//! @param excludeLetters letters that must not appear in found words
+//! @param rootEdge the index of the only root edge to traverse, or -1 to
+//! traverse all root edges
+//! @param wordSet returns the matching words in the order found, paired
+//! with the form with wildcard matches in lower case
+//! @param visitor if not null, the visitor to receive each matching word
+//! instead of the word set
+//! @return false if the visitor stopped the search, true otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::searchPattern(const SearchCondition& condition, const
+                         SearchSpec& spec, int maxLength, const QString&
+                         excludeLetters, int rootEdge, WordSet& wordSet,
+                         WordVisitor* visitor) const
+{
+    const int MAX_TOKENS = 2 * (MAX_WORD_LEN + 1);
+    const int MAX_FRAMES = 2 * (MAX_WORD_LEN + 1);
+    const int MAX_DFA_STATES = 1024;
+
+    if (maxLength > MAX_WORD_LEN)
+        maxLength = MAX_WORD_LEN;
+    if (maxLength < 1)
+        return true;
+
+    // If Pattern match is unspecified, change it to a single wildcard
+    // character.  Also, remove any redundant wildcards.
+    QString pattern = condition.stringValue;
+    if (pattern.isEmpty())
+        pattern = "*";
+    else
+        pattern.replace(QRegExp("\\*+"), "*");
+
+    // Without a packed reverse DAWG, such patterns are matched against the
+    // forward DAWG like any other
+    bool reversePattern = false;
+    if ((pattern.left(1) == "*") && (pattern.right(1) != "*") && rdawg) {
+        pattern = reverseString(pattern);
+        reversePattern = true;
+    }
+
+    const qint32* edges = reversePattern ? rdawg : dawg;
+
+    // Compile the pattern into tokens.  A word is accepted at a token
+    // position if only * tokens remain.
+    LetterSet tokenLetters[MAX_TOKENS];
+    bool tokenStar[MAX_TOKENS];
+    bool tokenLower[MAX_TOKENS];
+    bool acceptAt[MAX_TOKENS + 1];
+    int numTokens = compilePattern(pattern, tokenLetters, tokenStar,
+                                   tokenLower);
+
+    // Patterns requiring more letters than any word has cannot match
+    if (numTokens < 0)
+        return true;
+
+    acceptAt[numTokens] = true;
+    for (int i = numTokens - 1; i >= 0; --i)
+        acceptAt[i] = tokenStar[i] && acceptAt[i + 1];
+
+    bool excluded[NUM_EDGE_LETTERS];
+    char lowerLetters[NUM_EDGE_LETTERS];
+    initLetterTables(excludeLetters, excluded, lowerLetters);
+
+    // Run the pattern as a deterministic automaton if it has few enough
+    // states, so that each edge is examined once for each node visited
+    PatternDfa dfa;
+    if (dfa.compile(tokenLetters, tokenStar, tokenLower, numTokens, excluded,
+                    MAX_DFA_STATES))
+    {
+        return searchPatternDfa(dfa, edges, reversePattern, spec, maxLength,
+                                lowerLetters, rootEdge, wordSet, visitor);
+    }
+
+    // Otherwise each frame examines the edges of a node against a single
+    // token.  A frame for a * token is always followed by a frame for the
+    // next token at the same node, so * can match the empty string.  Since
+    // redundant * tokens are removed, at most two frames are active for each
+    // letter of the current word.
+    const qint32* frameEdges[MAX_FRAMES];
+    int frameTokens[MAX_FRAMES];
+    int frameDepths[MAX_FRAMES];
+    char word[MAX_WORD_LEN];
+    char wordUpper[MAX_WORD_LEN];
+    char found[MAX_WORD_LEN];
+    char foundUpper[MAX_WORD_LEN];
+
+    // The required letters matched by the letters before each depth, shared
+    // by the frames at that depth like the current word
+    RequiredLetters required (spec.requiredLetters);
+    quint32 depthMatched[MAX_WORD_LEN];
+    depthMatched[0] = 0;
+
+    // When only one root edge is traversed, stop at the edge after it
+    const qint32* rootEdges = &edges[ROOT_NODE];
+    const qint32* rootEnd = 0;
+    if (rootEdge >= 0) {
+        rootEdges += rootEdge;
+        rootEnd = rootEdges + 1;
+    }
+
+    quint16 depthMasks[MAX_WORD_LEN];
+    const QVector<quint16>& lengthMasks =
+        reversePattern ? rdawgLengthMasks : dawgLengthMasks;
+    const quint16* edgeMasks = (!lengthMasks.isEmpty() &&
+        getDepthMasks(getMinLength(spec), maxLength, depthMasks))
+        ? lengthMasks.constData() : 0;
+
+    int numFrames = 0;
+    for (int token = 0; token < numTokens; ++token) {
+        frameEdges[numFrames] = rootEdges;
+        frameTokens[numFrames] = token;
+        frameDepths[numFrames] = 0;
+        ++numFrames;
+        if (!tokenStar[token])
+            break;
+    }
+
+    while (numFrames) {
+        int top = numFrames - 1;
+        const qint32* edge = frameEdges[top];
+        if (!frameDepths[top] && (edge == rootEnd))
+            edge = 0;
+        if (!edge) {
+            --numFrames;
+            continue;
         }
 
-        // If Anagram or Subanagram match contains a wildcard, note it and remove
-        // the wildcard character from the match pattern.  Also move character
-        // classes to the end of the string so they will be seen last if
-        // moving sequentially through the string looking for matches.
-        else if ((condition.type == SearchCondition::AnagramMatch) ||
-                 (condition.type == SearchCondition::SubanagramMatch))
+        qint32 edgeValue = *edge;
+        frameEdges[top] = (edgeValue & M_END_OF_NODE) ? 0 : edge + 1;
+
+        int c = (edgeValue >> V_LETTER) & M_LETTER;
+        int token = frameTokens[top];
+        int depth = frameDepths[top];
+        if (excluded[c] || !tokenLetters[token].contains(c))
+            continue;
+
+        // Skip edges through which no word has a length in range, and
+        // edges below which the required letters still missing cannot fit
+        if (edgeMasks && !(edgeMasks[edge - edges] & depthMasks[depth]))
+            continue;
+        quint32 matched = required.isEmpty() ? 0
+            : required.match(depthMatched[depth], c);
+        if (required.getNumMissing(matched) > maxLength - depth - 1)
+            continue;
+
+        word[depth] = tokenLower[token] ? lowerLetters[c] : char(c);
+        wordUpper[depth] = char(c);
+
+        // A * token can keep matching letters
+        int nextToken = tokenStar[token] ? token : token + 1;
+
+        // If end of word and end of pattern, put the word in the list.  If
+        // we are searching the reverse DAWG, reverse the word first.
+        if ((edgeValue & M_END_OF_WORD) && acceptAt[nextToken] &&
+            !required.getNumMissing(matched))
         {
-            wildcard = unmatched.contains('*');
-            if (wildcard)
-                unmatched = unmatched.replace('*', QString());
+            int length = depth + 1;
+            for (int i = 0; i < length; ++i) {
+                int j = reversePattern ? (length - 1 - i) : i;
+                found[i] = word[j];
+                foundUpper[i] = wordUpper[j];
+            }
 
-            QRegExp re ("\\[[^\\]]*\\][^\\W_\\d]");
-            int pos = 0;
-            while ((pos = re.indexIn(unmatched, pos)) >= 0) {
-                unmatched = unmatched.left(re.pos()) +
-                    unmatched.right(unmatched.length() -
-                                   (re.pos() + re.matchedLength()) + 1) +
-                    unmatched.mid(re.pos(), re.matchedLength() - 1);
-                pos += re.matchedLength();
+            if (!addFoundWord(found, foundUpper, length, spec, wordSet,
+                              visitor))
+            {
+                return false;
             }
         }
 
-        qint32 node = ROOT_NODE;
+        // Push frames for the child node so its edges are examined next
+        qint32 child = edgeValue & M_NODE_POINTER;
+        if (child && (depth + 1 < maxLength)) {
+            depthMatched[depth + 1] = matched;
+            for (int t = nextToken; t < numTokens; ++t) {
+                frameEdges[numFrames] = &edges[child];
+                frameTokens[numFrames] = t;
+                frameDepths[numFrames] = depth + 1;
+                ++numFrames;
+                if (!tokenStar[t])
+                    break;
+            }
+        }
+    }
 
-        // Traverse the tree looking for matches
-        while (node) {
+    return true;
+}
 
-            // Stop if word is at max length
-            if (int(word.length()) < maxLength) {
-                QString origWord = word;
-                QString origUnmatched = unmatched;
+//---------------------------------------------------------------------------
+//  searchPatternDfa
+//
+//! Search a DAWG for words accepted by a pattern automaton.  A single frame
+//! is active for each letter of the current word, and an edge is skipped
+//! unless its letter leads to a live state.
+//
+//! @param dfa the pattern automaton
+//! @param edges the DAWG to search
+//! @param reversePattern whether the DAWG and automaton are reversed
+//! @param spec the search specification
+//! @param maxLength the maximum length of words to find
+//! @param lowerLetters the lower case form of each letter
+//! @param rootEdge the index of the only root edge to traverse, or -1 to
+//! traverse all root edges
+//! @param wordSet returns the matching words in the order found, paired
+//! with the form with wildcard matches in lower case
+//! @param visitor if not null, the visitor to receive each matching word
+//! instead of the word set
+//! @return false if the visitor stopped the search, true otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::searchPatternDfa(const PatternDfa& dfa, const qint32* edges, bool
+                            reversePattern, const SearchSpec& spec, int
+                            maxLength, const char* lowerLetters, int
+                            rootEdge, WordSet& wordSet, WordVisitor* visitor)
+                            const
+{
+    const qint16* transitions = dfa.transitions.constData();
+    const LetterSet* liveLetters = dfa.liveLetters.constData();
+    const bool* accepting = dfa.accepting.constData();
+    const int* minRemaining = dfa.minRemaining.constData();
+    int numSteps = 0;
+
+    const qint32* frameEdges[MAX_WORD_LEN];
+    int frameStates[MAX_WORD_LEN];
+    quint32 frameMatched[MAX_WORD_LEN];
+    RequiredLetters required (spec.requiredLetters);
+    char wordUpper[MAX_WORD_LEN];
+    char form[MAX_WORD_LEN];
+    char found[MAX_WORD_LEN];
+    char foundUpper[MAX_WORD_LEN];
+
+    // When only one root edge is traversed, stop at the edge after it
+    const qint32* rootEdges = &edges[ROOT_NODE];
+    const qint32* rootEnd = 0;
+    if (rootEdge >= 0) {
+        rootEdges += rootEdge;
+        rootEnd = rootEdges + 1;
+    }
 
-                QString match;
-                int closeIndex = 0;
+    quint16 depthMasks[MAX_WORD_LEN];
+    const QVector<quint16>& lengthMasks =
+        reversePattern ? rdawgLengthMasks : dawgLengthMasks;
+    const quint16* edgeMasks = (!lengthMasks.isEmpty() &&
+        getDepthMasks(getMinLength(spec), maxLength, depthMasks))
+        ? lengthMasks.constData() : 0;
+
+    int depth = 0;
+    frameEdges[0] = rootEdges;
+    frameStates[0] = 0;
+    frameMatched[0] = 0;
+
+    while (depth >= 0) {
+        const qint32* edge = frameEdges[depth];
+        if (!depth && (edge == rootEnd))
+            edge = 0;
+        if (!edge) {
+            --depth;
+            continue;
+        }
 
-                // Get the next character in the Pattern match.  Allow a
-                // wildcard to match the empty string.
-                if ((condition.type == SearchCondition::PatternMatch) &&
-                    (!unmatched.isEmpty()))
-                {
-                    match = unmatched.at(0);
-                    if (match == "*") {
-                        states.push(TraversalState(node, word,
-                            unmatched.right(unmatched.length() - 1)));
-                    }
-                    else if (match == "[") {
-                        closeIndex = unmatched.indexOf(']', 0);
-                        match = unmatched.mid(1, closeIndex);
-                    }
-                }
+        qint32 edgeValue = *edge;
+        frameEdges[depth] = (edgeValue & M_END_OF_NODE) ? 0 : edge + 1;
+
+        int c = (edgeValue >> V_LETTER) & M_LETTER;
+        int state = frameStates[depth];
+        if (!liveLetters[state].contains(c))
+            continue;
+
+        // Skip edges through which no word has a length in range, and
+        // edges below which the required letters still missing cannot fit
+        if (edgeMasks && !(edgeMasks[edge - edges] & depthMasks[depth]))
+            continue;
+        quint32 matched = required.isEmpty() ? 0
+            : required.match(frameMatched[depth], c);
+        if (required.getNumMissing(matched) > maxLength - depth - 1)
+            continue;
+
+        int nextState = transitions[state * NUM_EDGE_LETTERS + c];
+        wordUpper[depth] = char(c);
+        int length = depth + 1;
+
+        // If end of word and end of pattern, put the word in the list.  If
+        // we are searching the reverse DAWG, reverse the word first.
+        if ((edgeValue & M_END_OF_WORD) && accepting[nextState] &&
+            !required.getNumMissing(matched))
+        {
+            dfa.getMatchForm(wordUpper, length, lowerLetters, form);
+            for (int i = 0; i < length; ++i) {
+                int j = reversePattern ? (length - 1 - i) : i;
+                found[i] = form[j];
+                foundUpper[i] = wordUpper[j];
+            }
 
-                qint32* edge = reversePattern ? &rdawg[node] : &dawg[node];
+            if (!addFoundWord(found, foundUpper, length, spec, wordSet,
+                              visitor))
+            {
+                return false;
+            }
+        }
 
-                // Traverse next nodes, looking for matches
-                for (; ; ++edge) {
-                    qint32 longLetter = *edge;
-                    longLetter = longLetter >> V_LETTER;
-                    longLetter = longLetter & M_LETTER;
+        // Check now and then whether the visitor has cancelled the search
+        if (visitor && !(++numSteps % CANCEL_CHECK_STEPS) &&
+            visitor->isCancelled())
+        {
+            return false;
+        }
 
-                    QChar letter = (char) longLetter;
+        // Descend only if the pattern can still be completed within the
+        // maximum length
+        qint32 child = edgeValue & M_NODE_POINTER;
+        if (child && (length + qMax(minRemaining[nextState], 1) <= maxLength))
+        {
+            ++depth;
+            frameEdges[depth] = &edges[child];
+            frameStates[depth] = nextState;
+            frameMatched[depth] = matched;
+        }
+    }
 
-                    if (excludeLetters.contains(letter)) {
-                        if (*edge & M_END_OF_NODE)
-                            break;
-                        else
-                            continue;
-                    }
+    return true;
+}
 
-                    unmatched = origUnmatched;
-                    word = origWord;
+//---------------------------------------------------------------------------
+//  PatternDfa::compile
+//
+//! Compile pattern tokens into a deterministic automaton by subset
+//! construction.  A position is the index of the next token to match, and
+//! the position after the last token accepts.  A position before a * token
+//! also stands for the positions after it, since * can match nothing.
+//
+//! @param letters the set of letters matched by each token
+//! @param star whether each token is a *
+//! @param lower whether letters matched by each token are shown in lower
+//! case
+//! @param n the number of tokens
+//! @param excluded whether each letter is excluded from found words
+//! @param maxStates the maximum number of states
+//! @return true if successful, false if more states would be needed
+//---------------------------------------------------------------------------
+bool
+WordGraph::PatternDfa::compile(const LetterSet* letters, const bool* star,
+                               const bool* lower, int n, const bool* excluded,
+                               int maxStates)
+{
+    numTokens = n;
+    hasLowerTokens = false;
+    hasStarTokens = false;
+    tokenLetters.resize(n);
+    tokenStar.resize(n);
+    tokenLower.resize(n);
+    for (int i = 0; i < n; ++i) {
+        tokenLetters[i] = letters[i];
+        tokenStar[i] = star[i];
+        tokenLower[i] = lower[i];
+        hasLowerTokens = hasLowerTokens || lower[i];
+        hasStarTokens = hasStarTokens || star[i];
+    }
 
-                    // Special processing for Pattern match
-                    if (condition.type == SearchCondition::PatternMatch) {
+    // Closure of each position, and the number of letter tokens after it
+    closures.resize(n + 1);
+    QVector<int> remaining (n + 1, 0);
+    closures[n] = quint64(1) << n;
+    for (int p = n - 1; p >= 0; --p) {
+        closures[p] = quint64(1) << p;
+        if (star[p])
+            closures[p] |= closures[p + 1];
+        remaining[p] = remaining[p + 1] + (star[p] ? 0 : 1);
+    }
 
-                        // A node matches wildcard characters or its own
-                        // letter
-                        bool matchLetter = match.contains(letter);
-                        bool matchNegated = match.contains("^");
-                        QChar c = letter;
-                        if (match.contains ("]") || (match == "?"))
-                            c = c.toLower();
+    transitions.clear();
+    liveLetters.clear();
+    accepting.clear();
+    minRemaining.clear();
 
-                        if ((match == "*") || (match == "?") ||
-                            (matchLetter ^ matchNegated))
-                            word += c;
-                        else {
-                            if (*edge & M_END_OF_NODE)
-                                break;
-                            else
-                                continue;
-                        }
+    QVector<quint64> states;
+    QHash<quint64, int> stateIndexes;
+    states.append(closures[0]);
+    stateIndexes.insert(closures[0], 0);
 
-                        qint32 child = *edge & M_NODE_POINTER;
+    for (int s = 0; s < states.size(); ++s) {
+        quint64 positions = states[s];
 
-                        // If this node matches, push its child on the stack
-                        // to be traversed later
-                        if (child) {
-                            if (match == "*") {
-                                states.push(TraversalState(child, word,
-                                                           unmatched));
-                            }
+        int minLeft = MAX_WORD_LEN + 1;
+        for (int p = 0; p <= n; ++p) {
+            if ((positions & (quint64(1) << p)) && (remaining[p] < minLeft))
+                minLeft = remaining[p];
+        }
+        accepting.append((positions & (quint64(1) << n)) != 0);
+        minRemaining.append(minLeft);
+
+        int base = transitions.size();
+        transitions.resize(base + NUM_EDGE_LETTERS);
+        LetterSet live;
+        for (int c = 0; c < NUM_EDGE_LETTERS; ++c) {
+            transitions[base + c] = -1;
+            if (excluded[c])
+                continue;
+
+            quint64 next = 0;
+            for (int p = 0; p < n; ++p) {
+                if ((positions & (quint64(1) << p)) &&
+                    letters[p].contains(c))
+                {
+                    next |= star[p] ? closures[p] : closures[p + 1];
+                }
+            }
+            if (!next)
+                continue;
 
-                            if (closeIndex < unmatched.length() - 1) {
-                                states.push(TraversalState(child, word,
-                                    unmatched.right(unmatched.length() -
-                                    closeIndex - 1)));
-                            }
-                        }
+            QHash<quint64, int>::const_iterator it = stateIndexes.find(next);
+            int index = 0;
+            if (it == stateIndexes.end()) {
+                if (states.size() >= maxStates)
+                    return false;
+                index = states.size();
+                states.append(next);
+                stateIndexes.insert(next, index);
+            }
+            else
+                index = it.value();
 
-                        // If end of word and end of pattern, put the word in
-                        // the list.  If we are searching the reverse list,
-                        // reverse the word first.
-                        QString wordUpper = word.toUpper();
-                        if (reversePattern)
-                            wordUpper = reverseString(wordUpper);
+            transitions[base + c] = index;
+            live.insert(c);
+        }
+        liveLetters.append(live);
+    }
 
-                        if ((*edge & M_END_OF_WORD) &&
-                            ((int(unmatched.length()) == closeIndex + 1) ||
-                            ((int(unmatched.length()) == closeIndex + 2) &&
-                             (QChar(unmatched.at(closeIndex + 1)) == '*'))) &&
-                            matchesSpec(wordUpper, spec) &&
-                            !wordSet.count(wordUpper))
-                        {
-                            wordSet.insert(make_pair(wordUpper,
-                                reversePattern ? reverseString(word)
-                                               : word));
-                        }
-                    }
+    return true;
+}
 
-                    // Special processing for Anagram or Subanagram match
-                    else if
-                        ((condition.type == SearchCondition::AnagramMatch) ||
-                         (condition.type == SearchCondition::SubanagramMatch))
-                    {
-                        // Find the current letter in the pattern.  First,
-                        // prefer to match the letter itself.  Second, prefer
-                        // to match the letter as part of a character class.
-                        // If the letter matches more than one character
-                        // class, match the first one and push traversal
-                        // states for each of the others that is matched.
-                        // Character classes are guaranteed to be at the end
-                        // of the search string, so once you're in a character
-                        // class, you're always in a character class.
-                        int len = unmatched.length();
-                        bool inGroup = false;
-                        bool found = false;
-                        bool negated = false;
-                        int matchStart = -1;
-                        int matchEnd = -1;
-                        int groupStart = -1;
-                        bool wildcardMatch = false;
-                        for (int i = 0; i < len; ++i) {
-                            QChar c = unmatched.at(i);
+//---------------------------------------------------------------------------
+//  PatternDfa::matches
+//
+//! Determine whether a word is accepted by the automaton.
+//
+//! @param word the word
+//! @return true if the word is accepted, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::PatternDfa::matches(const QString& word) const
+{
+    if (accepting.isEmpty())
+        return false;
 
-                            if (c == '[') {
-                                inGroup = true;
-                                negated = false;
-                                groupStart = i;
-                            }
+    int state = 0;
+    int length = word.length();
+    for (int i = 0; i < length; ++i) {
+        ushort c = word.at(i).unicode();
+        if (c >= NUM_EDGE_LETTERS)
+            return false;
+        state = transitions[state * NUM_EDGE_LETTERS + c];
+        if (state < 0)
+            return false;
+    }
+    return accepting[state];
+}
 
-                            else if (inGroup) {
-                                if (c == '^')
-                                    negated = true;
+//---------------------------------------------------------------------------
+//  PatternDfa::getMatchForm
+//
+//! Determine the form of an accepted word with letters matched by ? and
+//! character classes in lower case.  If the word can be matched in more
+//! than one way, each * matches as few letters as possible.
+//
+//! @param wordUpper the word in upper case
+//! @param length the length of the word
+//! @param lowerLetters the lower case form of each letter
+//! @param word returns the word with wildcard matches in lower case
+//---------------------------------------------------------------------------
+void
+WordGraph::PatternDfa::getMatchForm(const char* wordUpper, int length, const
+                                    char* lowerLetters, char* word) const
+{
+    if (!hasLowerTokens || !hasStarTokens) {
+        for (int i = 0; i < length; ++i) {
+            uchar c = wordUpper[i];
+            word[i] = (hasLowerTokens && tokenLower[i]) ? lowerLetters[c]
+                                                        : char(c);
+        }
+        return;
+    }
 
-                                else if (c == ']') {
-                                    if (found ^ negated) {
-                                        qint32 child = *edge & M_NODE_POINTER;
+    // Working backward, find the tokens that can match each letter and still
+    // have the rest of the word match the rest of the pattern
+    quint64 usable[MAX_WORD_LEN];
+    quint64 completes = 0;
+    for (int p = 0; p <= numTokens; ++p) {
+        if (closures[p] & (quint64(1) << numTokens))
+            completes |= quint64(1) << p;
+    }
 
-                                        if (matchEnd < 0) {
-                                            matchStart = groupStart;
-                                            matchEnd = i;
-                                            wildcardMatch = true;
-                                        }
+    for (int i = length - 1; i >= 0; --i) {
+        uchar c = wordUpper[i];
+        usable[i] = 0;
+        for (int q = 0; q < numTokens; ++q) {
+            int target = tokenStar[q] ? q : q + 1;
+            if (tokenLetters[q].contains(c) &&
+                (completes & (quint64(1) << target)))
+            {
+                usable[i] |= quint64(1) << q;
+            }
+        }
 
-                                        else if (child) {
-                                            states.push(TraversalState(child,
-                                                word + letter,
-                                                unmatched.left(groupStart) +
-                                                unmatched.right(
-                                                unmatched.length() - i - 1)));
-                                        }
-                                    }
-                                    inGroup = false;
-                                    found = false;
-                                    negated = false;
-                                }
+        completes = 0;
+        for (int p = 0; p <= numTokens; ++p) {
+            if (closures[p] & usable[i])
+                completes |= quint64(1) << p;
+        }
+    }
+
+    // Working forward, match each letter with the last usable token, moving
+    // past any * tokens as soon as possible
+    int position = 0;
+    for (int i = 0; i < length; ++i) {
+        uchar c = wordUpper[i];
+        quint64 candidates = closures[position] & usable[i];
+        int q = numTokens - 1;
+        while (!(candidates & (quint64(1) << q)))
+            --q;
+        word[i] = tokenLower[q] ? lowerLetters[c] : char(c);
+        position = tokenStar[q] ? q : q + 1;
+    }
+}
+
+//---------------------------------------------------------------------------
+//  usesInfixIndex
+//
+//! Determine whether a match condition is searched using the infix index.
+//! The index is used for Pattern matches with * only at the start or end,
+//! containing a letter, whose first letter matched by the DAWG is not
+//! fixed, such as "*QU*" or "?ITE".
+//
+//! @param condition the match condition
+//! @return true if the infix index is used
+//---------------------------------------------------------------------------
+bool
+WordGraph::usesInfixIndex(const SearchCondition& condition) const
+{
+    const int MAX_TOKENS = 2 * (MAX_WORD_LEN + 1);
+
+    if (!gaddag || (condition.type != SearchCondition::PatternMatch))
+        return false;
+
+    QString pattern = condition.stringValue;
+    pattern.replace(QRegExp("\\*+"), "*");
+    int length = pattern.length();
+    if (!length)
+        return false;
 
-                                else if (c == letter)
-                                    found = true;
-                            }
+    bool leadStar = pattern.startsWith("*");
+    bool trailStar = (length > 1) && pattern.endsWith("*");
+    if (pattern.count('*') != int(leadStar) + int(trailStar))
+        return false;
 
-                            // Matched the character itself
-                            else if (c == letter) {
-                                found = true;
-                                matchStart = i;
-                                matchEnd = i;
-                                break;
-                            }
-                        }
+    // The DAWGs start from the first letter, or from the last letter of
+    // patterns beginning but not ending with *
+    QChar first = (leadStar && !trailStar) ? pattern.at(length - 1)
+                                           : pattern.at(0);
+    if (!QString("*?[]").contains(first))
+        return false;
 
-                        // Try to match the current letter against the
-                        // pattern.  If the letter doesn't match exactly,
-                        // match a ? char.
-                        //int index = unmatched.find(node->letter);
-                        found = (matchStart >= 0);
-                        if (!found) {
-                            matchStart = matchEnd = unmatched.indexOf("?");
-                            found = (matchStart >= 0);
-                            wildcardMatch = true;
-                        }
+    LetterSet tokenLetters[MAX_TOKENS];
+    bool tokenStar[MAX_TOKENS];
+    bool tokenLower[MAX_TOKENS];
+    int numTokens = compilePattern(pattern, tokenLetters, tokenStar,
+                                   tokenLower);
+    for (int i = 0; i < numTokens; ++i) {
+        if (!tokenStar[i] && !tokenLower[i])
+            return true;
+    }
+    return false;
+}
 
-                        // If this letter matched or a wildcard was specified,
-                        // keep traversing after possibly adding the current
-                        // word.
-                        if (found || wildcard) {
-                            word += (found && !wildcardMatch) ? QChar(letter)
-                                : QChar(letter).toLower();
+//---------------------------------------------------------------------------
+//  searchInfix
+//
+//! Search the infix index for words matching a Pattern match condition, as
+//! determined by usesInfixIndex.  The traversal starts from the longest run
+//! of letters in the pattern, matched backward along with the rest of the
+//! pattern before it, then crosses the separator and matches the rest of
+//! the pattern forward.
+//
+//! @param condition the match condition
+//! @param spec the search specification
+//! @param maxLength the maximum length of words to find
+//! @param excludeLetters letters that must not appear in found words
+//! @param wordSet returns the matching words in the order found, paired
+//! with the form with wildcard matches in lower case
+//! @param visitor if not null, the visitor to receive each matching word
+//! instead of the word set
+//! @return false if the visitor stopped the search, true otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::searchInfix(const SearchCondition& condition, const SearchSpec&
+                       spec, int maxLength, const QString& excludeLetters,
+                       WordSet& wordSet, WordVisitor* visitor) const
+{
+    const int MAX_TOKENS = 2 * (MAX_WORD_LEN + 1);
+    int numSteps = 0;
+
+    if (maxLength > MAX_WORD_LEN)
+        maxLength = MAX_WORD_LEN;
+    if (maxLength < 1)
+        return true;
+
+    // Compile the pattern without its leading and trailing *
+    QString pattern = condition.stringValue;
+    pattern.replace(QRegExp("\\*+"), "*");
+    bool leadStar = pattern.startsWith("*");
+    bool trailStar = (pattern.length() > 1) && pattern.endsWith("*");
+    if (leadStar)
+        pattern.remove(0, 1);
+    if (trailStar)
+        pattern.chop(1);
+
+    LetterSet tokenLetters[MAX_TOKENS];
+    bool tokenStar[MAX_TOKENS];
+    bool tokenLower[MAX_TOKENS];
+    int numTokens = compilePattern(pattern, tokenLetters, tokenStar,
+                                   tokenLower);
+    if ((numTokens < 1) || (numTokens > maxLength))
+        return true;
+
+    // Find the end of the longest run of letters
+    int anchorEnd = 0;
+    int longestRun = 0;
+    int run = 0;
+    for (int i = 0; i < numTokens; ++i) {
+        run = tokenLower[i] ? 0 : run + 1;
+        if (run > longestRun) {
+            longestRun = run;
+            anchorEnd = i + 1;
+        }
+    }
 
-                            if (found)
-                                unmatched.replace(matchStart,
-                                                  matchEnd - matchStart + 1,
-                                                  QString());
+    bool excluded[NUM_EDGE_LETTERS];
+    char lowerLetters[NUM_EDGE_LETTERS];
+    initLetterTables(excludeLetters, excluded, lowerLetters);
+
+    // Each path holds a reversed prefix of a word ending at the end of the
+    // anchor, the separator, and the rest of the word.  One frame is active
+    // for each edge of the current path, and the letters of the path are
+    // kept in path order.
+    const qint32* frameEdges[MAX_WORD_LEN + 1];
+    char path[MAX_WORD_LEN];
+    char pathUpper[MAX_WORD_LEN];
+    char found[MAX_WORD_LEN];
+    char foundUpper[MAX_WORD_LEN];
+    int separatorDepth = -1;
+
+    int depth = 0;
+    frameEdges[0] = &gaddag[ROOT_NODE];
+
+    while (depth >= 0) {
+        const qint32* edge = frameEdges[depth];
+        if (!edge) {
+            --depth;
+            continue;
+        }
 
-                            qint32 child = *edge & M_NODE_POINTER;
-                            if (child &&
-                                (wildcard || !unmatched.isEmpty()))
-                            {
-                                states.push(TraversalState(child, word,
-                                                           unmatched));
-                            }
+        qint32 edgeValue = *edge;
+        frameEdges[depth] = (edgeValue & M_END_OF_NODE) ? 0 : edge + 1;
 
-                            QString wordUpper = word.toUpper();
-                            if ((*edge & M_END_OF_WORD) &&
-                                ((condition.type ==
-                                  SearchCondition::SubanagramMatch) ||
-                                  unmatched.isEmpty()) &&
-                                  matchesSpec(wordUpper, spec) &&
-                                  !wordSet.count(wordUpper))
-                            {
-                                wordSet.insert(make_pair(wordUpper, word));
-                            }
-                        }
-                    }
+        // Once the separator edge is left behind, the path is before it again
+        if (separatorDepth >= depth)
+            separatorDepth = -1;
 
-                    if (*edge & M_END_OF_NODE)
-                        break;
-                }
-            }
+        int c = (edgeValue >> V_LETTER) & M_LETTER;
+        int numLetters = 0;
+        int nextToken = 0;
+        bool separator = (c == INFIX_SEPARATOR);
 
-            // Done traversing next nodes, pop a child off the stack
-            node = 0;
-            if (states.size()) {
-                TraversalState state = states.top();
-                node = state.node;
-                unmatched = state.unmatched;
-                word = state.word;
-                states.pop();
-            }
+        if (separator) {
+            // The path must have matched every token up to the anchor end
+            if (depth < anchorEnd)
+                continue;
+            numLetters = depth;
+            nextToken = anchorEnd;
         }
 
-        // Take conjunction or disjunction with final result set
-        if (!conditionNum) {
-            finalWordSet = wordSet;
+        else {
+            if (excluded[c])
+                continue;
+
+            bool forward = (separatorDepth >= 0);
+            int token = forward ? (anchorEnd + depth - separatorDepth - 1)
+                                : (anchorEnd - 1 - depth);
+            bool lower = false;
+            if (forward ? (token < numTokens) : (token >= 0)) {
+                if (!tokenLetters[token].contains(c))
+                    continue;
+                lower = tokenLower[token];
+            }
+            else if (!(forward ? trailStar : leadStar))
+                continue;
+
+            numLetters = forward ? depth : depth + 1;
+            if (numLetters > maxLength)
+                continue;
+            nextToken = forward ? token + 1 : anchorEnd;
+            path[numLetters - 1] = lower ? lowerLetters[c] : char(c);
+            pathUpper[numLetters - 1] = char(c);
         }
 
-        else if (spec.conjunction) {
-            map<QString, QString> conjunctionSet;
-            for (sit = wordSet.begin(); sit != wordSet.end(); ++sit) {
-                map<QString, QString>::iterator found =
-                    finalWordSet.find(sit->first);
-                if (found != finalWordSet.end()) {
-                    if (negated)
-                        finalWordSet.erase(found);
-                    else
-                        conjunctionSet.insert(*found);
-                }
+        // If end of word past the separator and end of pattern, put the word
+        // in the list, with the letters before the separator reversed
+        if ((edgeValue & M_END_OF_WORD) && (separator || (separatorDepth >= 0))
+            && (nextToken >= numTokens))
+        {
+            int numReversed = separator ? depth : separatorDepth;
+            for (int i = 0; i < numLetters; ++i) {
+                int j = (i < numReversed) ? (numReversed - 1 - i) : i;
+                found[i] = path[j];
+                foundUpper[i] = pathUpper[j];
             }
-            if (!negated) {
-                if (conjunctionSet.empty())
-                    return wordList;
-                finalWordSet = conjunctionSet;
+
+            if (!addFoundWord(found, foundUpper, numLetters, spec, wordSet,
+                              visitor))
+            {
+                return false;
             }
         }
 
-        else {
-            // FIXME: disjunction is broken for negated conditions! Fix this
-            // when disjunction is enabled in the UI.
-            for (sit = wordSet.begin(); sit != wordSet.end(); ++sit) {
-                finalWordSet.insert(*sit);
-            }
+        // Check now and then whether the visitor has cancelled the search
+        if (visitor && !(++numSteps % CANCEL_CHECK_STEPS) &&
+            visitor->isCancelled())
+        {
+            return false;
         }
 
-        ++conditionNum;
+        // Paths before the separator need one more edge for the separator
+        qint32 child = edgeValue & M_NODE_POINTER;
+        bool beforeSeparator = !separator && (separatorDepth < 0);
+        if (child && ((numLetters < maxLength) || beforeSeparator)) {
+            if (separator)
+                separatorDepth = depth;
+            ++depth;
+            frameEdges[depth] = &gaddag[child];
+        }
     }
 
-    // Transform word set into word list and return it
-    for (sit = finalWordSet.begin(); sit != finalWordSet.end(); ++sit) {
-        wordList << (wildcardLower ? sit->second : sit->first);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  addFoundWord
+//
+//! Add a word found by a traversal to a word set, or pass it to a visitor,
+//! if it matches the other conditions of a search specification.
+//
+//! @param word the word with wildcard matches in lower case
+//! @param wordUpper the word in upper case
+//! @param length the length of the word
+//! @param spec the search specification
+//! @param wordSet the word set to append the word to
+//! @param visitor if not null, the visitor to receive the word instead of
+//! the word set
+//! @return false if the visitor stopped the search, true otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::addFoundWord(const char* word, const char* wordUpper, int length,
+                        const SearchSpec& spec, WordSet& wordSet,
+                        WordVisitor* visitor) const
+{
+    QString upper = QString::fromLatin1(wordUpper, length);
+    if (visitor) {
+        return !matchesSpec(upper, spec) ||
+            visitor->visitWord(QString::fromLatin1(word, length));
     }
 
-    return wordList;
+    if (matchesSpec(upper, spec))
+        wordSet.push_back(make_pair(upper, QString::fromLatin1(word, length)));
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  initLetterTables
+//
+//! Initialize the tables of excluded letters and lower case letters used
+//! while traversing the DAWG.
+//
+//! @param excludeLetters letters that must not appear in found words
+//! @param excluded returns whether each letter is excluded
+//! @param lowerLetters returns the lower case form of each letter
+//---------------------------------------------------------------------------
+void
+WordGraph::initLetterTables(const QString& excludeLetters, bool* excluded,
+                            char* lowerLetters) const
+{
+    for (int i = 0; i < NUM_EDGE_LETTERS; ++i) {
+        excluded[i] = false;
+        lowerLetters[i] = QChar(ushort(i)).toLower().toLatin1();
+    }
+
+    int numExcluded = excludeLetters.length();
+    for (int i = 0; i < numExcluded; ++i) {
+        ushort c = excludeLetters.at(i).unicode();
+        if (c < NUM_EDGE_LETTERS)
+            excluded[c] = true;
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -636,6 +4423,71 @@ WordGraph::getNumWords() const
     return (dawg ? getNumWords(ROOT_NODE) : numWords);
 }
 
+//---------------------------------------------------------------------------
+//  getMemoryUsage
+//
+//! Estimate the memory used by each structure of the graph.  Memory-mapped
+//! DAWGs are counted at the size of their files, although only the pages
+//! that have been read are resident.
+//
+//! @param usage the list to append the usage of each structure to
+//---------------------------------------------------------------------------
+void
+WordGraph::getMemoryUsage(QList<MemoryUsage>* usage) const
+{
+    if (dawgFile)
+        usage->append(MemoryUsage("DAWG", dawgFile->size(), true));
+    else if (dawg)
+        usage->append(MemoryUsage("DAWG", (dawgEdges + 1) * sizeof(qint32)));
+
+    if (rdawgFile) {
+        usage->append(MemoryUsage("Reverse DAWG", rdawgFile->size(), true));
+    }
+    else if (rdawg) {
+        usage->append(MemoryUsage("Reverse DAWG", (rdawgEdges + 1) *
+                                  sizeof(qint32)));
+    }
+    else if (succinctRdawg) {
+        usage->append(MemoryUsage("Reverse DAWG (succinct)",
+                                  succinctRdawg->getMemoryUsage()));
+    }
+
+    if (gaddag) {
+        usage->append(MemoryUsage("Infix index", (gaddagEdges + 1) *
+                                  sizeof(qint32)));
+    }
+
+    if (!lookupMasks.isEmpty()) {
+        qint64 bytes = (lookupMasks.capacity() +
+                        lookupFirstChild.capacity() +
+                        lookupChildren.capacity()) * sizeof(quint32);
+        usage->append(MemoryUsage("Lookup table", bytes));
+    }
+
+    if (!wordCounts.isEmpty()) {
+        usage->append(MemoryUsage("Word counts", wordCounts.capacity() *
+                                  sizeof(qint32)));
+    }
+
+    if (!wordMasks.isEmpty()) {
+        usage->append(MemoryUsage("Word array", wordRecords.capacity() +
+                                  wordMasks.capacity() * sizeof(quint32)));
+    }
+
+    if (!dawgLengthMasks.isEmpty()) {
+        qint64 bytes = (dawgLengthMasks.capacity() +
+                        rdawgLengthMasks.capacity() +
+                        lookupLengthMasks.capacity()) * sizeof(quint16);
+        usage->append(MemoryUsage("Length masks", bytes));
+    }
+
+    if (top || rtop) {
+        qint64 bytes = (getNumNodesOld(top) + getNumNodesOld(rtop)) *
+            sizeof(Node);
+        usage->append(MemoryUsage("Node tree", bytes));
+    }
+}
+
 //---------------------------------------------------------------------------
 //  matchesSpec
 //
@@ -660,6 +4512,20 @@ WordGraph::matchesSpec(QString word, const SearchSpec& spec) const
             break;
 
             case SearchCondition::IncludeLetters: {
+                LetterSignature wordLetters (word);
+                LetterSignature includeLetters (condition.stringValue);
+                if (wordLetters.isValid() && includeLetters.isValid() &&
+                    !includeLetters.getNumBlanks())
+                {
+                    if (condition.negated ?
+                        wordLetters.intersects(includeLetters) :
+                        !wordLetters.contains(includeLetters))
+                    {
+                        return false;
+                    }
+                    break;
+                }
+
                 QString tmpWord = word;
                 int includeLen = condition.stringValue.length();
                 for (int i = 0; i < includeLen; ++i) {
@@ -722,6 +4588,197 @@ WordGraph::convertEndian(qint32* data, qint32 count)
     return count;
 }
 
+//---------------------------------------------------------------------------
+//  mapDawgFile
+//
+//! Memory-map a DAWG file and return a pointer to its edges, arranged so that
+//! the first edge is at index ROOT_NODE.  On big-endian hosts, the
+//! native-endian copy of the file is mapped, creating it if necessary.
+//
+//! @param filename the name of the DAWG file
+//! @param mappedFile returns the mapped file, which must be kept open as
+//! long as the edges are in use
+//! @param checksum returns the checksum of the original file contents, if
+//! not null
+//! @param errString returns the error string in case of error
+//! @return a pointer to the edges, or 0 if the file could not be mapped
+//---------------------------------------------------------------------------
+qint32*
+WordGraph::mapDawgFile(const QString& filename, QFile** mappedFile, quint16*
+                       checksum, QString* errString)
+{
+    QString mapFilename = filename;
+    qint32 headerWords = 1;
+    if (bigEndian) {
+        mapFilename = getNativeDawgFilename(filename);
+        headerWords = NATIVE_HEADER_WORDS;
+
+        QFileInfo origInfo (filename);
+        QFileInfo nativeInfo (mapFilename);
+        if ((!nativeInfo.exists() ||
+             (nativeInfo.lastModified() < origInfo.lastModified())) &&
+            !createNativeDawgFile(filename, mapFilename, errString))
+        {
+            return 0;
+        }
+    }
+
+    QFile* file = new QFile(mapFilename);
+    if (!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        return 0;
+    }
+
+    qint64 fileSize = file->size();
+    if (fileSize < qint64(headerWords * sizeof(qint32))) {
+        delete file;
+        return 0;
+    }
+
+    uchar* data = file->map(0, fileSize);
+    if (!data) {
+        delete file;
+        return 0;
+    }
+
+    const qint32* header = reinterpret_cast<const qint32*>(data);
+    qint32 numEdges = header[0];
+    if ((numEdges < 0) ||
+        (fileSize < qint64((numEdges + headerWords) * sizeof(qint32))))
+    {
+        if (errString)
+            *errString = "The lexicon file '" + filename + "' is truncated.";
+        delete file;
+        return 0;
+    }
+
+    // The original checksum covers the first numEdges bytes of the edges in
+    // little-endian order, which are only available directly when the host
+    // is also little-endian
+    if (checksum) {
+        if (bigEndian)
+            *checksum = quint16(header[1]);
+        else
+            *checksum = qChecksum(reinterpret_cast<const char*>(header + 1),
+                                  numEdges);
+    }
+
+    *mappedFile = file;
+
+    // Point one word before the first edge, so edge indexes line up with
+    // node indexes
+    return reinterpret_cast<qint32*>(data) + (headerWords - 1);
+}
+
+//---------------------------------------------------------------------------
+//  readDawgFile
+//
+//! Read a DAWG file into heap memory and convert it to native byte order.
+//! This is used when a DAWG file cannot be memory-mapped.
+//
+//! @param filename the name of the DAWG file
+//! @param numEdges returns the number of edges
+//! @param checksum returns the checksum of the original file contents, if
+//! not null
+//! @param errString returns the error string in case of error
+//! @return a newly allocated array of edges, with the first edge at index
+//! ROOT_NODE, or 0 if error
+//---------------------------------------------------------------------------
+qint32*
+WordGraph::readDawgFile(const QString& filename, qint32* numEdges, quint16*
+                        checksum, QString* errString)
+{
+    QFile file (filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errString)
+            *errString = "Can't open file '" + filename + "': "
+            + file.errorString();
+        return 0;
+    }
+
+    qint32* p = numEdges;
+    char* cp = (char*) p;
+    file.read(cp, 1 * sizeof(qint32));
+    if (bigEndian)
+        convertEndian(p, 1);
+
+    qint32* edges = new qint32[*numEdges + 1];
+    edges[0] = 0;
+    p = &edges[1];
+    cp = (char*) p;
+    file.read(cp, *numEdges * sizeof(qint32));
+
+    if (checksum)
+        *checksum = qChecksum(cp, *numEdges);
+
+    if (bigEndian)
+        convertEndian(p, *numEdges);
+
+    return edges;
+}
+
+//---------------------------------------------------------------------------
+//  createNativeDawgFile
+//
+//! Create a native-endian copy of a little-endian DAWG file, so it can be
+//! memory-mapped and used in place on a big-endian host.  The copy begins
+//! with the number of edges and the checksum of the original file.
+//
+//! @param filename the name of the original DAWG file
+//! @param nativeFilename the name of the native-endian file to create
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordGraph::createNativeDawgFile(const QString& filename, const QString&
+                                nativeFilename, QString* errString)
+{
+    qint32 numEdges = 0;
+    quint16 checksum = 0;
+    qint32* edges = readDawgFile(filename, &numEdges, &checksum, errString);
+    if (!edges)
+        return false;
+
+    QDir dir;
+    dir.mkpath(QFileInfo(nativeFilename).absolutePath());
+
+    QFile file (nativeFilename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        delete[] edges;
+        return false;
+    }
+
+    qint32 header[NATIVE_HEADER_WORDS];
+    header[0] = numEdges;
+    header[1] = checksum;
+    qint64 headerSize = NATIVE_HEADER_WORDS * sizeof(qint32);
+    qint64 edgesSize = numEdges * sizeof(qint32);
+    bool ok = (file.write((const char*) header, headerSize) == headerSize) &&
+        (file.write((const char*) &edges[1], edgesSize) == edgesSize);
+    delete[] edges;
+    file.close();
+
+    if (!ok)
+        file.remove();
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+//  getNativeDawgFilename
+//
+//! Determine the name of the native-endian copy of a DAWG file.
+//
+//! @param filename the name of the original DAWG file
+//! @return the native-endian filename
+//---------------------------------------------------------------------------
+QString
+WordGraph::getNativeDawgFilename(const QString& filename) const
+{
+    QFileInfo info (filename);
+    return Auxil::getUserDir() + "/lexicons/" + info.fileName() +
+        NATIVE_DAWG_EXTENSION;
+}
+
 //---------------------------------------------------------------------------
 //  addWordOld
 //
@@ -1211,6 +5268,33 @@ WordGraph::searchOld(const SearchSpec& spec) const
     return wordList;
 }
 
+//---------------------------------------------------------------------------
+//  getNumNodesOld
+//
+//! Count the nodes of an old-style node tree.
+//
+//! @param node the first node of the tree
+//! @return the number of nodes
+//---------------------------------------------------------------------------
+int
+WordGraph::getNumNodesOld(const Node* node) const
+{
+    int count = 0;
+    stack<const Node*> nodes;
+    if (node)
+        nodes.push(node);
+    while (!nodes.empty()) {
+        const Node* n = nodes.top();
+        nodes.pop();
+        ++count;
+        if (n->next)
+            nodes.push(n->next);
+        if (n->child)
+            nodes.push(n->child);
+    }
+    return count;
+}
+
 //---------------------------------------------------------------------------
 //  getNumWords
 //
@@ -1222,6 +5306,15 @@ int
 WordGraph::getNumWords(qint32 node) const
 {
     int count = 0;
+    if (!wordCounts.isEmpty()) {
+        for (qint32 i = node; ; ++i) {
+            count += wordCounts[i];
+            if (dawg[i] & M_END_OF_NODE)
+                break;
+        }
+        return count;
+    }
+
     for (qint32* edge = &dawg[node]; ; ++edge) {
         if ((*edge & M_END_OF_WORD) != 0)
             ++count;
@@ -1234,6 +5327,57 @@ WordGraph::getNumWords(qint32 node) const
     return count;
 }
 
+//---------------------------------------------------------------------------
+//  getNumWords
+//
+//! Return the number of words of a range of lengths below a node.
+//
+//! @param edges the DAWG
+//! @param node the node
+//! @param depth the number of letters leading to the node
+//! @param minLength the minimum length of words to count
+//! @param maxLength the maximum length of words to count
+//! @return the number of words
+//---------------------------------------------------------------------------
+int
+WordGraph::getNumWords(const qint32* edges, qint32 node, int depth, int
+                       minLength, int maxLength) const
+{
+    if (maxLength > MAX_WORD_LEN)
+        maxLength = MAX_WORD_LEN;
+    if ((minLength <= depth + 1) && (maxLength == MAX_WORD_LEN) &&
+        (edges == dawg))
+    {
+        return getNumWords(node);
+    }
+
+    const qint32* frameEdges[MAX_WORD_LEN];
+    int top = 0;
+    frameEdges[0] = &edges[node];
+    int count = 0;
+
+    while (top >= 0) {
+        const qint32* edge = frameEdges[top];
+        if (!edge) {
+            --top;
+            continue;
+        }
+
+        qint32 edgeValue = *edge;
+        frameEdges[top] = (edgeValue & M_END_OF_NODE) ? 0 : edge + 1;
+
+        int length = depth + top + 1;
+        if ((edgeValue & M_END_OF_WORD) && (length >= minLength))
+            ++count;
+
+        qint32 child = edgeValue & M_NODE_POINTER;
+        if (child && (length < maxLength))
+            frameEdges[++top] = &edges[child];
+    }
+
+    return count;
+}
+
 //---------------------------------------------------------------------------
 //  Node
 //
@@ -26,12 +26,54 @@
 #define ZYZZYVA_WORD_GRAPH_H
 
 #include "SearchSpec.h"
+#include "WordVisitor.h"
+#include <QBitArray>
+#include <QByteArray>
 #include <QFile>
 #include <QString>
 #include <QStringList>
+#include <QVector>
+#include <utility>
+#include <vector>
+
+class Rand;
+class SuccinctDawg;
 
 class WordGraph
 {
+    public:
+    // Edit operations allowed between a word and its neighbors - see
+    // editNeighbors
+    enum EditOperation {
+        EditSubstitute = 1,
+        EditInsert = 2,
+        EditDelete = 4,
+        EditTranspose = 8,
+        AllEditOperations = 15
+    };
+
+    // The kinds of extensions of a word - see getExtensions
+    enum ExtensionType {
+        FrontExtensions,
+        BackExtensions,
+        DoubleExtensions
+    };
+
+    // Set in a hook mask that may be missing hooks - see hooks
+    static const quint32 INCOMPLETE_HOOKS = 0x80000000;
+
+    // Estimated memory used by one structure, in bytes.  Mapped structures
+    // are read in place from files, so their pages can be shared between
+    // processes and dropped by the system when memory is short.
+    class MemoryUsage {
+      public:
+        MemoryUsage(const QString& s = QString(), qint64 b = 0, bool m =
+                    false) : structure(s), bytes(b), mapped(m) { }
+        QString structure;
+        qint64 bytes;
+        bool mapped;
+    };
+
     public:
     WordGraph();
     ~WordGraph();
@@ -39,10 +81,46 @@ class WordGraph
     void clear();
     bool importDawgFile(const QString& filename, bool reverse, QString*
                         errString, quint16* expectedChecksum);
+    bool importWords(const QStringList& words, bool reverse, QString*
+                     errString = 0, const QString& saveFilename = QString());
+    bool buildLookupTable();
+    bool hasLookupTable() const { return !lookupMasks.isEmpty(); }
+    bool buildGaddag(QString* errString = 0);
+    bool hasGaddag() const { return (gaddag != 0); }
+    bool buildWordCounts();
+    bool hasWordCounts() const { return !wordCounts.isEmpty(); }
+    bool buildWordArray();
+    bool hasWordArray() const { return !wordMasks.isEmpty(); }
+    bool buildLengthMasks();
+    bool hasLengthMasks() const { return !dawgLengthMasks.isEmpty(); }
+    bool buildSuccinctReverseDawg();
+    bool hasSuccinctReverseDawg() const { return (succinctRdawg != 0); }
     void addWord(const QString& w);
     bool containsWord(const QString& w) const;
-    QStringList search(const SearchSpec& spec) const;
+    QBitArray containsWords(const QStringList& words) const;
+    void hooks(const QString& word, quint32* frontHooks, quint32* backHooks)
+        const;
+    QStringList search(const SearchSpec& spec, int numThreads = 1) const;
+    bool search(const SearchSpec& spec, WordVisitor* visitor, int numThreads =
+                1) const;
+    QStringList blankVariations(const QString& word, bool anagram) const;
+    QStringList editNeighbors(const QString& word, int maxDistance, int
+                              operations = AllEditOperations) const;
+    QStringList joinWords(const WordGraph& other, bool difference, int
+                          minLength, int maxLength) const;
+    int countMatches(const SearchSpec& spec, int numThreads = 1) const;
     int getNumWords() const;
+    QString wordAt(int index) const;
+    int indexOf(const QString& word) const;
+    bool getPrefixRange(const QString& prefix, int* first, int* count) const;
+    QStringList getPrefixWords(const QString& prefix, int maxWords) const;
+    bool getExtensions(const QString& word, ExtensionType type, int
+                       maxLength, QStringList* words) const;
+    quint64 getFingerprint() const;
+    QString randomWord(const SearchSpec& spec, Rand* rng) const;
+    bool sampleWords(const SearchSpec& spec, int numWords, Rand* rng,
+                     QStringList* words) const;
+    void getMemoryUsage(QList<MemoryUsage>* usage) const;
 
     private:
     class Node {
@@ -56,13 +134,64 @@ class WordGraph
         Node* child;
     };
 
-    class TraversalState {
+    class SearchJob;
+
+    // Words found by a search, in upper case paired with the form with
+    // wildcard matches in lower case
+    typedef std::vector<std::pair<QString, QString> > WordSet;
+
+    enum WordSetOperation {
+        WordSetIntersection,
+        WordSetDifference,
+        WordSetUnion
+    };
+
+    class LetterSet {
       public:
-        TraversalState(qint32 n, const QString& w, const QString& u)
-            : node(n), word(w), unmatched(u) { }
-        qint32 node;
-        QString word;
-        QString unmatched;
+        LetterSet() { clear(); }
+        void clear() { for (int i = 0; i < 8; ++i) bits[i] = 0; }
+        void fill() { for (int i = 0; i < 8; ++i) bits[i] = ~0U; }
+        void invert() { for (int i = 0; i < 8; ++i) bits[i] = ~bits[i]; }
+        void insert(int c) { bits[c >> 5] |= (1U << (c & 31)); }
+        bool contains(int c) const {
+            return (bits[c >> 5] & (1U << (c & 31))) != 0; }
+        bool operator==(const LetterSet& rhs) const {
+            for (int i = 0; i < 8; ++i) {
+                if (bits[i] != rhs.bits[i])
+                    return false;
+            }
+            return true;
+        }
+        quint32 bits[8];
+    };
+
+    // Deterministic automaton compiled from the tokens of a pattern.  Each
+    // state is a set of token positions the pattern may have reached.
+    class PatternDfa {
+      public:
+        PatternDfa() : numTokens(0), hasLowerTokens(false),
+                       hasStarTokens(false) { }
+        bool compile(const LetterSet* letters, const bool* star, const bool*
+                     lower, int numTokens, const bool* excluded, int
+                     maxStates);
+        void getMatchForm(const char* wordUpper, int length, const char*
+                          lowerLetters, char* word) const;
+        bool matches(const QString& word) const;
+
+        // The next state for each state and letter, or -1 if none
+        QVector<qint16> transitions;
+        QVector<LetterSet> liveLetters;
+        QVector<bool> accepting;
+        QVector<int> minRemaining;
+
+      private:
+        QVector<LetterSet> tokenLetters;
+        QVector<bool> tokenStar;
+        QVector<bool> tokenLower;
+        QVector<quint64> closures;
+        int numTokens;
+        bool hasLowerTokens;
+        bool hasStarTokens;
     };
 
     class TraversalStateOld {
@@ -75,18 +204,135 @@ class WordGraph
     };
 
     private:
+    bool containsWordLookup(const QString& w) const;
+    bool followEdge(quint32* node, bool* eow, const QChar& letter) const;
+    quint32 getHookMask(const qint32* edges, const QString& letters) const;
+    quint32 getHookMask(const SuccinctDawg& edges, const QString& letters)
+        const;
+    qint32 findNode(const qint32* edges, const QString& letters) const;
+    QStringList getSubtreePaths(const qint32* edges, qint32 node, int
+                                maxLength) const;
+    int compilePattern(const QString& pattern, LetterSet* tokenLetters, bool*
+                       tokenStar, bool* tokenLower) const;
+    int parseLetterClass(const QString& pattern, int start, LetterSet*
+                         letters) const;
+    int getMatchConditions(const SearchSpec& spec, QList<SearchCondition>*
+                           posMatchConditions, QList<SearchCondition>*
+                           negMatchConditions, int* maxLength, QString*
+                           excludeLetters) const;
+    int getMinLength(const SearchSpec& spec) const;
+    bool matchesUniquely(const SearchCondition& condition) const;
+    bool countSubtreeMatches(const SearchSpec& spec, int* count) const;
+    bool searchCondition(const SearchCondition& condition, const SearchSpec&
+                         spec, int maxLength, const QString& excludeLetters,
+                         int rootEdge, WordSet& wordSet, WordVisitor*
+                         visitor = 0) const;
+    void searchParallel(const SearchCondition& condition, const SearchSpec&
+                        spec, int maxLength, const QString& excludeLetters,
+                        int numThreads, WordSet& wordSet) const;
+    bool searchAnagrams(const SearchCondition& condition, const SearchSpec&
+                        spec, int maxLength, const QString& excludeLetters,
+                        int rootEdge, WordSet& wordSet, WordVisitor*
+                        visitor) const;
+    bool usesWordArray(const SearchCondition& condition) const;
+    bool scanWordArray(const SearchCondition& condition, const SearchSpec&
+                       spec, int maxLength, const QString& excludeLetters,
+                       WordSet& wordSet, WordVisitor* visitor) const;
+    bool isRackCondition(const SearchCondition& condition) const;
+    bool searchRack(const SearchCondition& condition, const SearchSpec& spec,
+                    int maxLength, const QString& excludeLetters, int
+                    rootEdge, WordSet& wordSet, WordVisitor* visitor) const;
+    bool searchPattern(const SearchCondition& condition, const SearchSpec&
+                       spec, int maxLength, const QString& excludeLetters,
+                       int rootEdge, WordSet& wordSet, WordVisitor*
+                       visitor) const;
+    bool searchPatternDfa(const PatternDfa& dfa, const qint32* edges, bool
+                          reversePattern, const SearchSpec& spec, int
+                          maxLength, const char* lowerLetters, int rootEdge,
+                          WordSet& wordSet, WordVisitor* visitor) const;
+    bool usesInfixIndex(const SearchCondition& condition) const;
+    bool searchInfix(const SearchCondition& condition, const SearchSpec&
+                     spec, int maxLength, const QString& excludeLetters,
+                     WordSet& wordSet, WordVisitor* visitor) const;
+    bool addFoundWord(const char* word, const char* wordUpper, int length,
+                      const SearchSpec& spec, WordSet& wordSet, WordVisitor*
+                      visitor) const;
+    void sortWordSet(WordSet& wordSet) const;
+    void combineWordSets(const WordSet& a, const WordSet& b,
+                         WordSetOperation operation, WordSet& result) const;
+    void initLetterTables(const QString& excludeLetters, bool* excluded,
+                          char* lowerLetters) const;
     bool matchesSpec(QString word, const SearchSpec& spec) const;
     QString reverseString(const QString& s) const;
     qint32 convertEndian(qint32* data, qint32 count);
+    qint32* mapDawgFile(const QString& filename, QFile** mappedFile,
+                        quint16* checksum, QString* errString);
+    qint32* readDawgFile(const QString& filename, qint32* numEdges,
+                         quint16* checksum, QString* errString);
+    bool createNativeDawgFile(const QString& filename, const QString&
+                              nativeFilename, QString* errString);
+    QString getNativeDawgFilename(const QString& filename) const;
 
     void addWordOld(const QString& w, bool reverse);
     bool containsWordOld(const QString& w) const;
     QStringList searchOld(const SearchSpec& spec) const;
     int getNumWords(qint32 node) const;
+    int getNumNodesOld(const Node* node) const;
+    int getNumWords(const qint32* edges, qint32 node, int depth, int
+                    minLength, int maxLength) const;
 
     qint32* dawg;
     qint32* rdawg;
 
+    // Infix index built from the forward DAWG, in the same edge format - see
+    // buildGaddag
+    qint32* gaddag;
+
+    // Reverse DAWG in the succinct encoding, held in place of the packed
+    // reverse DAWG - see buildSuccinctReverseDawg
+    SuccinctDawg* succinctRdawg;
+
+    // Files backing memory-mapped DAWGs - null if the DAWG was read into
+    // heap memory instead
+    QFile* dawgFile;
+    QFile* rdawgFile;
+
+    // Number of edges of the DAWGs and infix index held in heap memory,
+    // used to estimate their size - see getMemoryUsage
+    qint32 dawgEdges;
+    qint32 rdawgEdges;
+    qint32 gaddagEdges;
+
+    // Compiled lookup table for the forward DAWG.  Each node has a mask of
+    // the letters leaving it and the index of its first child entry; child
+    // entries are ordered by letter, so the entry for a letter is found by
+    // counting the lower bits set in the mask.  Each child entry holds the
+    // child node index shifted left by one, with the low bit set if the edge
+    // ends a word.  Node 0 is the terminal node.
+    QVector<quint32> lookupMasks;
+    QVector<quint32> lookupFirstChild;
+    QVector<quint32> lookupChildren;
+
+    // Number of words reached through each edge of the forward DAWG,
+    // including the word ending at the edge - see buildWordCounts
+    QVector<qint32> wordCounts;
+
+    // Every word in alphabetical order as a fixed-width record of
+    // WORD_RECORD_SIZE bytes - the letters, padded with zeros, and the
+    // length in the last byte - with a mask of the letters of each word, for
+    // scanning conditions the DAWG cannot prune - see buildWordArray
+    QByteArray wordRecords;
+    QVector<quint32> wordMasks;
+
+    // Lengths of the rest of the words reached through each edge of the
+    // DAWGs and each child entry of the lookup table, with bit n set if a
+    // word ends n letters below the node the edge leaves, so traversals can
+    // skip edges leading to no words of the lengths searched for - see
+    // buildLengthMasks
+    QVector<quint16> dawgLengthMasks;
+    QVector<quint16> rdawgLengthMasks;
+    QVector<quint16> lookupLengthMasks;
+
     bool bigEndian;
 
     // OLD dawg structures - only used where new DAWG is unavailable
@@ -0,0 +1,456 @@
+//---------------------------------------------------------------------------
+// WordIdList.cpp
+//
+// A class for saving and loading word lists as the IDs of their words in a
+// lexicon.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "WordIdList.h"
+#include <QDataStream>
+#include <QFile>
+#include <QtAlgorithms>
+
+// A word ID list file holds, in QDataStream format, the magic number, the
+// format version, the lexicon name, the lexicon build, the number of words,
+// the number of attributes and the attributes, followed by a byte array of
+// the differences between successive sorted IDs, each in seven-bit groups
+// with the high bit set on all but the last group, and then the attribute
+// values of each word in ID order.
+const quint32 WORD_ID_LIST_MAGIC = 0x5a59574c;
+const quint32 WORD_ID_LIST_VERSION = 1;
+
+//---------------------------------------------------------------------------
+//  clear
+//
+//! Remove the lexicon, build, attributes and words of the list.
+//---------------------------------------------------------------------------
+void
+WordIdList::clear()
+{
+    lexicon = QString();
+    build = 0;
+    attributes.clear();
+    entries.clear();
+}
+
+//---------------------------------------------------------------------------
+//  addWord
+//
+//! Add a word to the list.  If the word is already in the list, its
+//! attribute values are replaced.
+//
+//! @param id the ID of the word
+//! @param values the values of the attributes of the word, in the order of
+//! the attributes of the list
+//---------------------------------------------------------------------------
+void
+WordIdList::addWord(qint32 id, const QStringList& values)
+{
+    if (id < 0)
+        return;
+    entries.insert(id, values);
+}
+
+//---------------------------------------------------------------------------
+//  getIds
+//
+//! Get the IDs of the words in the list.
+//
+//! @return the IDs, in ascending order
+//---------------------------------------------------------------------------
+QVector<qint32>
+WordIdList::getIds() const
+{
+    QVector<qint32> ids;
+    ids.reserve(entries.size());
+    QMapIterator<qint32, QStringList> it (entries);
+    while (it.hasNext())
+        ids.append(it.next().key());
+    return ids;
+}
+
+//---------------------------------------------------------------------------
+//  readFile
+//
+//! Read a word ID list file, replacing the contents of the list.
+//
+//! @param filename the name of the file
+//! @param errString returns an error string on failure
+//! @return true if successful, false otherwise, in which case the list is
+//! left empty
+//---------------------------------------------------------------------------
+bool
+WordIdList::readFile(const QString& filename, QString* errString)
+{
+    clear();
+
+    QFile file (filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errString)
+            *errString = file.errorString();
+        return false;
+    }
+
+    QDataStream stream (&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString fileLexicon;
+    quint64 fileBuild = 0;
+    qint32 numIds = 0;
+    qint32 numAttributes = 0;
+    stream >> magic >> version >> fileLexicon >> fileBuild >> numIds
+        >> numAttributes;
+    if ((stream.status() != QDataStream::Ok) ||
+        (magic != WORD_ID_LIST_MAGIC) || (version != WORD_ID_LIST_VERSION) ||
+        (numIds < 0) || (numAttributes < 0))
+    {
+        if (errString)
+            *errString = "Not a valid word ID list file";
+        return false;
+    }
+
+    QList<WordAttribute> fileAttributes;
+    for (int i = 0; i < numAttributes; ++i) {
+        qint32 attribute = 0;
+        stream >> attribute;
+        fileAttributes.append(WordAttribute(attribute));
+    }
+
+    QByteArray idBytes;
+    stream >> idBytes;
+    QVector<qint32> ids;
+    if ((stream.status() != QDataStream::Ok) ||
+        !decodeIds(idBytes, numIds, &ids))
+    {
+        if (errString)
+            *errString = "Not a valid word ID list file";
+        return false;
+    }
+
+    for (int i = 0; i < numIds; ++i) {
+        QStringList values;
+        for (int j = 0; j < numAttributes; ++j) {
+            QString value;
+            stream >> value;
+            values.append(value);
+        }
+        entries.insert(ids[i], values);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        clear();
+        if (errString)
+            *errString = "Word ID list file is truncated";
+        return false;
+    }
+
+    lexicon = fileLexicon;
+    build = fileBuild;
+    attributes = fileAttributes;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  writeFile
+//
+//! Write the list to a word ID list file.
+//
+//! @param filename the name of the file
+//! @param errString returns an error string on failure
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordIdList::writeFile(const QString& filename, QString* errString) const
+{
+    QFile file (filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errString)
+            *errString = file.errorString();
+        return false;
+    }
+
+    QDataStream stream (&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << WORD_ID_LIST_MAGIC << WORD_ID_LIST_VERSION << lexicon << build
+        << qint32(entries.size()) << qint32(attributes.size());
+    foreach (WordAttribute attribute, attributes)
+        stream << qint32(attribute);
+    stream << encodeIds(getIds());
+
+    // Pad or truncate the values of each word to the number of attributes
+    QMapIterator<qint32, QStringList> it (entries);
+    while (it.hasNext()) {
+        const QStringList& values = it.next().value();
+        for (int i = 0; i < attributes.size(); ++i)
+            stream << ((i < values.size()) ? values[i] : QString());
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        if (errString)
+            *errString = file.errorString();
+        file.close();
+        QFile::remove(filename);
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  isWordIdFile
+//
+//! Determine whether a file is a word ID list file, from its magic number.
+//
+//! @param filename the name of the file
+//! @return true if the file is a word ID list file
+//---------------------------------------------------------------------------
+bool
+WordIdList::isWordIdFile(const QString& filename)
+{
+    QFile file (filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream (&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    quint32 magic = 0;
+    stream >> magic;
+    return (stream.status() == QDataStream::Ok) &&
+        (magic == WORD_ID_LIST_MAGIC);
+}
+
+//---------------------------------------------------------------------------
+//  normalize
+//
+//! Sort an array of IDs and remove duplicate and negative IDs, so it can be
+//! used with the other ID array operations.
+//
+//! @param ids the IDs
+//---------------------------------------------------------------------------
+void
+WordIdList::normalize(QVector<qint32>* ids)
+{
+    qSort(ids->begin(), ids->end());
+    int numIds = 0;
+    for (int i = 0; i < ids->size(); ++i) {
+        qint32 id = ids->at(i);
+        if ((id < 0) || (numIds && ((*ids)[numIds - 1] == id)))
+            continue;
+        (*ids)[numIds++] = id;
+    }
+    ids->resize(numIds);
+}
+
+//---------------------------------------------------------------------------
+//  contains
+//
+//! Determine whether a sorted array of IDs contains an ID.
+//
+//! @param ids the IDs, in ascending order
+//! @param id the ID to find
+//! @return true if the ID is in the array
+//---------------------------------------------------------------------------
+bool
+WordIdList::contains(const QVector<qint32>& ids, qint32 id)
+{
+    QVector<qint32>::const_iterator it = qBinaryFind(ids.begin(), ids.end(),
+                                                     id);
+    return (it != ids.end());
+}
+
+//---------------------------------------------------------------------------
+//  intersect
+//
+//! Find the IDs in both of two sorted arrays of IDs.  If one array is much
+//! smaller than the other, each of its IDs is found in the other array by
+//! binary search instead of stepping through both arrays.
+//
+//! @param a the first IDs, in ascending order
+//! @param b the second IDs, in ascending order
+//! @return the IDs in both arrays, in ascending order
+//---------------------------------------------------------------------------
+QVector<qint32>
+WordIdList::intersect(const QVector<qint32>& a, const QVector<qint32>& b)
+{
+    const QVector<qint32>& small = (a.size() <= b.size()) ? a : b;
+    const QVector<qint32>& large = (a.size() <= b.size()) ? b : a;
+
+    QVector<qint32> ids;
+    ids.reserve(small.size());
+    QVector<qint32>::const_iterator lit = large.begin();
+    QVector<qint32>::const_iterator lend = large.end();
+
+    if (small.size() * 16 < large.size()) {
+        foreach (qint32 id, small) {
+            lit = qLowerBound(lit, lend, id);
+            if (lit == lend)
+                break;
+            if (*lit == id)
+                ids.append(id);
+        }
+        return ids;
+    }
+
+    QVector<qint32>::const_iterator sit = small.begin();
+    QVector<qint32>::const_iterator send = small.end();
+    while ((sit != send) && (lit != lend)) {
+        if (*sit < *lit)
+            ++sit;
+        else if (*lit < *sit)
+            ++lit;
+        else {
+            ids.append(*sit);
+            ++sit;
+            ++lit;
+        }
+    }
+    return ids;
+}
+
+//---------------------------------------------------------------------------
+//  unite
+//
+//! Find the IDs in either of two sorted arrays of IDs.
+//
+//! @param a the first IDs, in ascending order
+//! @param b the second IDs, in ascending order
+//! @return the IDs in either array, in ascending order
+//---------------------------------------------------------------------------
+QVector<qint32>
+WordIdList::unite(const QVector<qint32>& a, const QVector<qint32>& b)
+{
+    QVector<qint32> ids;
+    ids.reserve(a.size() + b.size());
+    int i = 0;
+    int j = 0;
+    while ((i < a.size()) && (j < b.size())) {
+        if (a[i] < b[j])
+            ids.append(a[i++]);
+        else if (b[j] < a[i])
+            ids.append(b[j++]);
+        else {
+            ids.append(a[i++]);
+            ++j;
+        }
+    }
+    for (; i < a.size(); ++i)
+        ids.append(a[i]);
+    for (; j < b.size(); ++j)
+        ids.append(b[j]);
+    return ids;
+}
+
+//---------------------------------------------------------------------------
+//  subtract
+//
+//! Find the IDs in one sorted array of IDs that are not in another.
+//
+//! @param a the IDs to keep, in ascending order
+//! @param b the IDs to remove, in ascending order
+//! @return the IDs in the first array but not the second, in ascending
+//! order
+//---------------------------------------------------------------------------
+QVector<qint32>
+WordIdList::subtract(const QVector<qint32>& a, const QVector<qint32>& b)
+{
+    QVector<qint32> ids;
+    ids.reserve(a.size());
+    int j = 0;
+    for (int i = 0; i < a.size(); ++i) {
+        while ((j < b.size()) && (b[j] < a[i]))
+            ++j;
+        if ((j == b.size()) || (b[j] != a[i]))
+            ids.append(a[i]);
+    }
+    return ids;
+}
+
+//---------------------------------------------------------------------------
+//  encodeIds
+//
+//! Encode sorted IDs as the differences between successive IDs, in
+//! seven-bit groups.
+//
+//! @param ids the IDs, in ascending order
+//! @return the encoded IDs
+//---------------------------------------------------------------------------
+QByteArray
+WordIdList::encodeIds(const QVector<qint32>& ids)
+{
+    QByteArray bytes;
+    bytes.reserve(ids.size() * 2);
+    qint32 previous = 0;
+    for (int i = 0; i < ids.size(); ++i) {
+        quint32 delta = quint32(ids[i] - previous);
+        previous = ids[i];
+        while (delta >= 0x80) {
+            bytes.append(char((delta & 0x7f) | 0x80));
+            delta >>= 7;
+        }
+        bytes.append(char(delta));
+    }
+    return bytes;
+}
+
+//---------------------------------------------------------------------------
+//  decodeIds
+//
+//! Decode IDs encoded by encodeIds.
+//
+//! @param bytes the encoded IDs
+//! @param numIds the number of IDs
+//! @param ids returns the IDs
+//! @return true if successful, false if the encoded IDs are not valid
+//---------------------------------------------------------------------------
+bool
+WordIdList::decodeIds(const QByteArray& bytes, int numIds, QVector<qint32>*
+                      ids)
+{
+    ids->clear();
+    ids->reserve(numIds);
+    const char* data = bytes.constData();
+    int size = bytes.size();
+    int pos = 0;
+    quint64 id = 0;
+    for (int i = 0; i < numIds; ++i) {
+        quint32 delta = 0;
+        int shift = 0;
+        for (;;) {
+            if ((pos >= size) || (shift > 28))
+                return false;
+            uchar byte = uchar(data[pos++]);
+            delta |= quint32(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                break;
+            shift += 7;
+        }
+
+        // IDs after the first must be distinct and in ascending order
+        if ((i > 0) && !delta)
+            return false;
+        id += delta;
+        if (id > 0x7fffffff)
+            return false;
+        ids->append(qint32(id));
+    }
+    return (pos == size);
+}
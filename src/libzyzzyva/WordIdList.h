@@ -0,0 +1,91 @@
+//---------------------------------------------------------------------------
+// WordIdList.h
+//
+// A class for saving and loading word lists as the IDs of their words in a
+// lexicon.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_WORD_ID_LIST_H
+#define ZYZZYVA_WORD_ID_LIST_H
+
+#include "WordAttribute.h"
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// A word list held as the indexes of its words in the alphabetical list of
+// words of a lexicon, with the build of the lexicon the indexes belong to,
+// and optionally the values of some attributes of each word.  The IDs are
+// kept sorted and distinct, and are saved delta-coded, so a list can be
+// loaded without reading or checking any words.
+class WordIdList
+{
+    public:
+    WordIdList() : build(0) { }
+    ~WordIdList() { }
+
+    void clear();
+    bool isEmpty() const { return entries.isEmpty(); }
+    int size() const { return entries.size(); }
+
+    QString getLexicon() const { return lexicon; }
+    void setLexicon(const QString& lex) { lexicon = lex; }
+    quint64 getBuild() const { return build; }
+    void setBuild(quint64 b) { build = b; }
+    QList<WordAttribute> getAttributes() const { return attributes; }
+    void setAttributes(const QList<WordAttribute>& attrs) {
+        attributes = attrs; }
+
+    void addWord(qint32 id, const QStringList& values = QStringList());
+    QVector<qint32> getIds() const;
+    QStringList getValues(qint32 id) const { return entries.value(id); }
+
+    bool readFile(const QString& filename, QString* errString = 0);
+    bool writeFile(const QString& filename, QString* errString = 0) const;
+
+    static bool isWordIdFile(const QString& filename);
+
+    // Operations on sorted arrays of distinct IDs
+    static void normalize(QVector<qint32>* ids);
+    static bool contains(const QVector<qint32>& ids, qint32 id);
+    static QVector<qint32> intersect(const QVector<qint32>& a, const
+                                     QVector<qint32>& b);
+    static QVector<qint32> unite(const QVector<qint32>& a, const
+                                 QVector<qint32>& b);
+    static QVector<qint32> subtract(const QVector<qint32>& a, const
+                                    QVector<qint32>& b);
+
+    private:
+    static QByteArray encodeIds(const QVector<qint32>& ids);
+    static bool decodeIds(const QByteArray& bytes, int numIds,
+                          QVector<qint32>* ids);
+
+    private:
+    QString lexicon;
+    quint64 build;
+    QList<WordAttribute> attributes;
+    QMap<qint32, QStringList> entries;
+};
+
+#endif // ZYZZYVA_WORD_ID_LIST_H
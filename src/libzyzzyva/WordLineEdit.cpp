@@ -0,0 +1,106 @@
+//---------------------------------------------------------------------------
+// WordLineEdit.cpp
+//
+// A class derived from QLineEdit, used to input words.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "WordLineEdit.h"
+#include "WordEngine.h"
+#include <QAbstractItemView>
+#include <QCompleter>
+#include <QStringListModel>
+
+// The number of completions offered for a prefix
+const int MAX_COMPLETIONS = 20;
+
+//---------------------------------------------------------------------------
+//  setCompletionEngine
+//
+//! Complete words as they are typed, offering the most playable words of a
+//! lexicon beginning with the text typed so far.
+//
+//! @param e the word engine, or null to stop completing words
+//! @param lex the name of the lexicon
+//---------------------------------------------------------------------------
+void
+WordLineEdit::setCompletionEngine(const WordEngine* e, const QString& lex)
+{
+    engine = e;
+    lexicon = lex;
+
+    if (!engine) {
+        if (completer) {
+            disconnect(this, SIGNAL(textEdited(const QString&)), this,
+                       SLOT(updateCompletions(const QString&)));
+            setCompleter(0);
+            completer = 0;
+            completionModel = 0;
+        }
+        return;
+    }
+
+    if (completer)
+        return;
+
+    // The completions are already filtered and ordered by the engine
+    completionModel = new QStringListModel(this);
+    completer = new QCompleter(completionModel, this);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer->setCaseSensitivity(Qt::CaseInsensitive);
+    setCompleter(completer);
+    connect(this, SIGNAL(textEdited(const QString&)),
+            SLOT(updateCompletions(const QString&)));
+}
+
+//---------------------------------------------------------------------------
+//  updateCompletions
+//
+//! Called when the text is edited.  Replace the completions with the words
+//! beginning with the new text, if it is only letters.
+//
+//! @param text the new text
+//---------------------------------------------------------------------------
+void
+WordLineEdit::updateCompletions(const QString& text)
+{
+    if (!engine || !completionModel)
+        return;
+
+    QStringList completions;
+    bool letters = !text.isEmpty();
+    for (int i = 0; letters && (i < text.length()); ++i)
+        letters = text.at(i).isLetter();
+    if (letters)
+        completions = engine->getCompletions(lexicon, text, MAX_COMPLETIONS);
+
+    // There is nothing to complete if the text is the only word offered
+    if ((completions.size() == 1) &&
+        (completions.first().compare(text, Qt::CaseInsensitive) == 0))
+    {
+        completions.clear();
+    }
+
+    completionModel->setStringList(completions);
+    if (completions.isEmpty())
+        completer->popup()->hide();
+    else
+        completer->complete();
+}
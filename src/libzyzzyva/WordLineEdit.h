@@ -1,8 +1,8 @@
 //---------------------------------------------------------------------------
 // WordLineEdit.h
 //
-// A class derived from QLineEdit, used to input words.  This class currently
-// does nothing special.  It only exists so objects of this class can be
+// A class derived from QLineEdit, used to input words.  It can complete
+// words as they are typed, and exists so objects of this class can be
 // distinguished from other QLineEdit objects when applying font settings.
 //
 // Copyright 2005-2012 Boshvark Software, LLC.
@@ -29,16 +29,33 @@
 
 #include <QLineEdit>
 
+class QCompleter;
+class QStringListModel;
+class WordEngine;
+
 class WordLineEdit : public QLineEdit
 {
     Q_OBJECT
     public:
     WordLineEdit(QWidget* parent = 0)
-        : QLineEdit(parent) { }
+        : QLineEdit(parent), engine(0), completer(0), completionModel(0) { }
     WordLineEdit(const QString& contents, QWidget* parent = 0)
-        : QLineEdit(contents, parent) { }
+        : QLineEdit(contents, parent), engine(0), completer(0),
+          completionModel(0) { }
 
     virtual ~WordLineEdit() { }
+
+    void setCompletionEngine(const WordEngine* e, const QString& lex);
+    void setCompletionLexicon(const QString& lex) { lexicon = lex; }
+
+    private slots:
+    void updateCompletions(const QString& text);
+
+    private:
+    const WordEngine* engine;
+    QString lexicon;
+    QCompleter* completer;
+    QStringListModel* completionModel;
 };
 
 #endif // ZYZZYVA_WORD_LINE_EDIT_H
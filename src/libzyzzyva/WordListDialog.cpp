@@ -23,6 +23,7 @@
 //---------------------------------------------------------------------------
 
 #include "WordListDialog.h"
+#include "SearchCondition.h"
 #include "ZPushButton.h"
 #include "Auxil.h"
 #include "Defs.h"
@@ -68,6 +69,11 @@ WordListDialog::WordListDialog(QWidget* parent, Qt::WFlags f)
     connect(openFileButton, SIGNAL(clicked()), SLOT(openFileClicked()));
     buttonHlay->addWidget(openFileButton);
 
+    ZPushButton* linkFileButton = new ZPushButton("&Link File...");
+    linkFileButton->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+    connect(linkFileButton, SIGNAL(clicked()), SLOT(linkFileClicked()));
+    buttonHlay->addWidget(linkFileButton);
+
     ZPushButton* clearButton = new ZPushButton("&Clear");
     clearButton->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     connect(clearButton, SIGNAL(clicked()), SLOT(clearClicked()));
@@ -103,7 +109,8 @@ WordListDialog::~WordListDialog()
 //  setWords
 //
 //! Set the contents of the word list to be the words in a space-separated
-//! string of words.
+//! string of words, or link the word list to a file if the string is the
+//! string of a word list file condition.
 //
 //! @param string the word list string
 //---------------------------------------------------------------------------
@@ -111,6 +118,17 @@ void
 WordListDialog::setWords(const QString& string)
 {
     wordList->clear();
+    SearchCondition condition;
+    condition.type = SearchCondition::InWordList;
+    condition.stringValue = string;
+    linkedFile = condition.getWordListFile();
+    if (!linkedFile.isEmpty()) {
+        wordList->setEnabled(false);
+        updateLabel();
+        return;
+    }
+
+    wordList->setEnabled(true);
     QStringList words = string.split(QChar(' '), QString::SkipEmptyParts);
     foreach (const QString& word, words) {
         new QListWidgetItem(word, wordList);
@@ -121,13 +139,20 @@ WordListDialog::setWords(const QString& string)
 //---------------------------------------------------------------------------
 //  getWords
 //
-//! Return the word list, with words separated by single spaces.
+//! Return the word list, with words separated by single spaces, or the
+//! string of a word list file condition if the list is linked to a file.
 //
 //! @return the word list string
 //---------------------------------------------------------------------------
 QString
 WordListDialog::getWords() const
 {
+    if (!linkedFile.isEmpty()) {
+        SearchCondition condition;
+        condition.setWordListFile(linkedFile);
+        return condition.stringValue;
+    }
+
     QString str;
     QListWidgetItem* lookItem = 0;
     for (int i = 0; i < wordList->count(); ++i) {
@@ -154,6 +179,11 @@ WordListDialog::openFileClicked()
     if (filename.isEmpty())
         return;
 
+    if (!linkedFile.isEmpty()) {
+        linkedFile = QString();
+        wordList->setEnabled(true);
+    }
+
     QFile file (filename);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         QString caption = "Error Opening Word List File";
@@ -190,10 +220,37 @@ WordListDialog::openFileClicked()
 void
 WordListDialog::clearClicked()
 {
+    linkedFile = QString();
+    wordList->setEnabled(true);
     wordList->clear();
     updateLabel();
 }
 
+//---------------------------------------------------------------------------
+//  linkFileClicked
+//
+//! Called when the Link File button is clicked.  Open a file chooser
+//! dialog, and link the word list to the chosen file, so its words are read
+//! from the file whenever the list is searched instead of being copied into
+//! the list.
+//---------------------------------------------------------------------------
+void
+WordListDialog::linkFileClicked()
+{
+    QString filename = QFileDialog::getOpenFileName(this,
+        "Link Word List File", Auxil::getUserWordsDir() + "/saved",
+        "Word List Files (*.txt *.zwl);;Text Files (*.txt);;"
+        "Word ID Lists (*.zwl)");
+
+    if (filename.isEmpty())
+        return;
+
+    wordList->clear();
+    wordList->setEnabled(false);
+    linkedFile = filename;
+    updateLabel();
+}
+
 //---------------------------------------------------------------------------
 //  updateLabel
 //
@@ -202,6 +259,12 @@ WordListDialog::clearClicked()
 void
 WordListDialog::updateLabel()
 {
+    if (!linkedFile.isEmpty()) {
+        numWordsLabel->setText(LIST_HEADER_PREFIX + "words read from " +
+                               linkedFile);
+        return;
+    }
+
     numWordsLabel->setText(LIST_HEADER_PREFIX +
                            QString::number(wordList->count()) + " words");
 }
@@ -38,11 +38,13 @@ class WordListDialog : public QDialog
     ~WordListDialog();
 
     int numWords() const { return wordList->count(); }
+    bool isLinkedFile() const { return !linkedFile.isEmpty(); }
     void setWords(const QString& string);
     QString getWords() const;
 
     public slots:
     void openFileClicked();
+    void linkFileClicked();
     void clearClicked();
 
     private:
@@ -51,6 +53,7 @@ class WordListDialog : public QDialog
     private:
     QLabel* numWordsLabel;
     QListWidget* wordList;
+    QString linkedFile;
 };
 
 #endif // ZYZZYVA_WORD_LIST_DIALOG_H
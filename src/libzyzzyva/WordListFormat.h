@@ -31,7 +31,8 @@ enum WordListFormat
     WordListOnePerLine,
     WordListAnagramQuestionAnswer,
     WordListAnagramTwoColumn,
-    WordListDistinctAlphagrams
+    WordListDistinctAlphagrams,
+    WordListWordIds
 };
 
 #endif // ZYZZYVA_WORD_LIST_FORMAT_H
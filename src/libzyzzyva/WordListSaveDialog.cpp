@@ -65,6 +65,7 @@ WordListSaveDialog::WordListSaveDialog(QWidget* parent, Qt::WFlags f)
         Auxil::wordListFormatToString(WordListAnagramTwoColumn));
     formatCombo->addItem(
         Auxil::wordListFormatToString(WordListDistinctAlphagrams));
+    formatCombo->addItem(Auxil::wordListFormatToString(WordListWordIds));
     connect(formatCombo, SIGNAL(activated(const QString&)),
         SLOT(formatActivated(const QString&)));
     formatHlay->addWidget(formatCombo);
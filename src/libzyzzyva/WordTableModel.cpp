@@ -25,8 +25,11 @@
 #include "WordTableModel.h"
 #include "WordEngine.h"
 #include "MainSettings.h"
+#include "Trace.h"
 #include "Auxil.h"
 #include <QBrush>
+#include <QSet>
+#include <QVector>
 
 using namespace std;
 
@@ -42,6 +45,10 @@ const QString DEFINITION_HEADER = "Definition";
 const int ITEM_MARGIN = 5;
 const int DEFAULT_COLUMN_WIDTH = 100;
 
+// Number of rows whose attributes are fetched together when the view asks
+// for the data of a row whose attributes have not been fetched
+const int FETCH_PAGE_ROWS = 64;
+
 const QColor VALID_NORMAL_WORD_FOREGROUND = Qt::black;
 const QColor VALID_NORMAL_WORD_BACKGROUND = Qt::white;
 const QColor VALID_NORMAL_ALTERNATE_FOREGROUND = Qt::black;
@@ -97,13 +104,28 @@ lessThan(const WordTableModel::WordItem& a,
     }
 
     if (MainSettings::getWordListGroupByAnagrams()) {
-        QString aa = Auxil::getAlphagram(a.getWord().toUpper());
-        QString ab = Auxil::getAlphagram(b.getWord().toUpper());
-        int compare = QString::localeAwareCompare(aa, ab);
-        if (compare < 0)
-            return true;
-        else if (compare > 0)
-            return false;
+        QString wa = a.getWord().toUpper();
+        QString wb = b.getWord().toUpper();
+
+        // Compare packed alphagram keys of short words without building
+        // alphagram strings
+        quint64 ka = Auxil::getAlphagramKey(wa);
+        quint64 kb = Auxil::getAlphagramKey(wb);
+        if (ka && kb) {
+            if (ka < kb)
+                return true;
+            else if (ka > kb)
+                return false;
+        }
+        else {
+            QString aa = Auxil::getAlphagram(wa);
+            QString ab = Auxil::getAlphagram(wb);
+            int compare = QString::localeAwareCompare(aa, ab);
+            if (compare < 0)
+                return true;
+            else if (compare > 0)
+                return false;
+        }
     }
 
     if (MainSettings::getWordListSortByProbabilityOrder()) {
@@ -119,6 +141,146 @@ lessThan(const WordTableModel::WordItem& a,
                                         b.getWord().toUpper()) < 0);
 }
 
+// The values lessThan compares for a word item, computed once per item
+// when sorting
+class WordSortKey
+{
+    public:
+    WordSortKey() : playValue(0), playOrder(0), length(0), alphagramKey(0),
+                    probOrder(0), index(0) { }
+    qint64 playValue;
+    int playOrder;
+    int length;
+    quint64 alphagramKey;
+    QString alphagram;
+    int probOrder;
+    QString word;
+    int index;
+};
+
+// Compares sort keys the way lessThan compares word items, with the sort
+// settings read once when the comparison is created
+class WordSortKeyLessThan
+{
+    public:
+    WordSortKeyLessThan() { }
+
+    QVector<WordSortKey> getKeys(const QList<WordTableModel::WordItem>& items)
+        const;
+    bool operator()(const WordSortKey& a, const WordSortKey& b) const;
+
+    private:
+    WordListSettings settings;
+};
+
+//---------------------------------------------------------------------------
+//  getKeys
+//
+//! Compute the sort keys of a list of word items.
+//
+//! @param items the word items
+//! @return the sort keys, in the order of the items
+//---------------------------------------------------------------------------
+QVector<WordSortKey>
+WordSortKeyLessThan::getKeys(const QList<WordTableModel::WordItem>& items)
+    const
+{
+    QVector<WordSortKey> keys (items.size());
+    bool needAlphagrams = false;
+    for (int i = 0; i < items.size(); ++i) {
+        const WordTableModel::WordItem& item = items[i];
+        WordSortKey& key = keys[i];
+        key.index = i;
+        key.word = item.getWord().toUpper();
+        key.length = item.getWord().length();
+        key.playValue = item.getPlayabilityValue();
+        key.playOrder = item.getPlayabilityOrder();
+        key.probOrder = item.getProbabilityOrder();
+        if (settings.groupByAnagrams) {
+            key.alphagramKey = Auxil::getAlphagramKey(key.word);
+            if (!key.alphagramKey)
+                needAlphagrams = true;
+        }
+    }
+
+    // Alphagram strings are compared whenever either word has no packed
+    // key, so build them for every word if any word has no packed key
+    if (needAlphagrams) {
+        for (int i = 0; i < keys.size(); ++i)
+            keys[i].alphagram = Auxil::getAlphagram(keys[i].word);
+    }
+
+    return keys;
+}
+
+//---------------------------------------------------------------------------
+//  operator()
+//
+//! Compare two sort keys in the same way lessThan compares the word items
+//! they were computed from.
+//
+//! @param a the first sort key
+//! @param b the second sort key
+//! @return true if a comes before b
+//---------------------------------------------------------------------------
+bool
+WordSortKeyLessThan::operator()(const WordSortKey& a, const WordSortKey& b)
+    const
+{
+    if (settings.sortByPlayabilityOrder) {
+        // High playability values compare as less
+        if (b.playValue < a.playValue)
+            return true;
+        else if (a.playValue < b.playValue)
+            return false;
+
+        if (a.playOrder < b.playOrder)
+            return true;
+        else if (b.playOrder < a.playOrder)
+            return false;
+    }
+
+    if (settings.sortByLength) {
+        bool reverse = settings.sortByReverseLength;
+        if ((!reverse && (a.length < b.length)) ||
+            (reverse && (a.length > b.length)))
+        {
+            return true;
+        }
+        else if ((!reverse && (b.length < a.length)) ||
+                 (reverse && (b.length > a.length)))
+        {
+            return false;
+        }
+    }
+
+    if (settings.groupByAnagrams) {
+        if (a.alphagramKey && b.alphagramKey) {
+            if (a.alphagramKey < b.alphagramKey)
+                return true;
+            else if (a.alphagramKey > b.alphagramKey)
+                return false;
+        }
+        else {
+            int compare = QString::localeAwareCompare(a.alphagram,
+                                                      b.alphagram);
+            if (compare < 0)
+                return true;
+            else if (compare > 0)
+                return false;
+        }
+    }
+
+    if (settings.sortByProbabilityOrder) {
+        if (a.probOrder < b.probOrder)
+            return true;
+        else if (b.probOrder < a.probOrder)
+            return false;
+    }
+
+    return (QString::localeAwareCompare(a.word, b.word) < 0);
+}
+
 //---------------------------------------------------------------------------
 //  WordTableModel
 //
@@ -129,7 +291,7 @@ lessThan(const WordTableModel::WordItem& a,
 //---------------------------------------------------------------------------
 WordTableModel::WordTableModel(WordEngine* e, QObject* parent)
     : QAbstractTableModel(parent), wordEngine(e), probNumBlanks(0),
-      lastAddedIndex(-1)
+      lastAddedIndex(-1), sorted(true)
 {
     probNumBlanks = MainSettings::getProbabilityNumBlanks();
 }
@@ -161,7 +323,9 @@ WordTableModel::clear()
 //---------------------------------------------------------------------------
 //  addWord
 //
-//! Add a word to the model.
+//! Add a word to the model.  If the words are sorted, the word is inserted
+//! in place instead of sorting every word, and only the anagram groups
+//! around it are marked again.
 //
 //! @param word the word item to add
 //! @param updateLastAdded whether to update the last added index
@@ -170,6 +334,22 @@ WordTableModel::clear()
 bool
 WordTableModel::addWord(const WordItem& word, bool updateLastAdded)
 {
+    if (sorted) {
+        int row = qUpperBound(wordList.begin(), wordList.end(), word,
+                              lessThan) - wordList.begin();
+        bool ok = insertRow(row);
+        if (!ok)
+            return false;
+
+        addWordPrivate(word, row);
+        sorted = true;
+        if (MainSettings::getWordListGroupByAnagrams())
+            markAlternates(row);
+        lastAddedIndex = updateLastAdded ? row : -1;
+        emit wordsChanged();
+        return true;
+    }
+
     int row = rowCount();
     bool ok = insertRow(row);
     if (!ok)
@@ -186,7 +366,10 @@ WordTableModel::addWord(const WordItem& word, bool updateLastAdded)
 //---------------------------------------------------------------------------
 //  addWords
 //
-//! Add a list of words to the model.
+//! Add a list of words to the model.  The word items are added as they are,
+//! and their hooks, symbols and orders are fetched from the word engine a
+//! page at a time as the view asks for them.  If the words already in the
+//! model are sorted, only the new words are sorted, and are merged in.
 //
 //! @param words the word items to add
 //! @return true if successful, false otherwise
@@ -194,15 +377,23 @@ WordTableModel::addWord(const WordItem& word, bool updateLastAdded)
 bool
 WordTableModel::addWords(const QList<WordItem>& words)
 {
-    int row = rowCount();
-    bool ok = insertRows(row, words.size());
-    if (!ok)
-        return false;
-    foreach (const WordItem& word, words) {
-        addWordPrivate(word, row);
-        ++row;
+    if (words.isEmpty()) {
+        sort(WORD_COLUMN);
+        lastAddedIndex = -1;
+        emit wordsChanged();
+        return true;
     }
-    sort(WORD_COLUMN);
+
+    int row = rowCount();
+    bool merge = sorted && row;
+    beginInsertRows(QModelIndex(), row, row + words.size() - 1);
+    wordList += words;
+    endInsertRows();
+
+    if (merge)
+        mergeWords(row);
+    else
+        sort(WORD_COLUMN);
     lastAddedIndex = -1;
     emit wordsChanged();
     return true;
@@ -234,14 +425,14 @@ WordTableModel::removeWord(const QString& word)
                 lastAddedIndex = -1;
         }
         else if (count) {
-            bool ok = removeRows(start, count);
-            emit wordsChanged();
-            return ok;
+            break;
         }
     }
 
     if (count) {
         bool ok = removeRows(start, count);
+        if (MainSettings::getWordListGroupByAnagrams())
+            markAlternates(start);
         emit wordsChanged();
         return ok;
     }
@@ -249,6 +440,46 @@ WordTableModel::removeWord(const QString& word)
     return false;
 }
 
+//---------------------------------------------------------------------------
+//  removeWords
+//
+//! Remove a list of words from the model, in one pass over the model.
+//
+//! @param words the words to remove
+//! @return true if any words were removed, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordTableModel::removeWords(const QStringList& words)
+{
+    QSet<QString> wordSet = words.toSet();
+    bool removed = false;
+    for (int i = rowCount() - 1; i >= 0; ) {
+        if (!wordSet.contains(wordList.at(i).getWord())) {
+            --i;
+            continue;
+        }
+
+        // Remove each run of matching rows at once
+        int end = i;
+        while ((i >= 0) && wordSet.contains(wordList.at(i).getWord()))
+            --i;
+        int start = i + 1;
+        int count = end - start + 1;
+        if (lastAddedIndex > end)
+            lastAddedIndex -= count;
+        else if (lastAddedIndex >= start)
+            lastAddedIndex = -1;
+        removeRows(start, count);
+        if (MainSettings::getWordListGroupByAnagrams())
+            markAlternates(start);
+        removed = true;
+    }
+
+    if (removed)
+        emit wordsChanged();
+    return removed;
+}
+
 //---------------------------------------------------------------------------
 //  rowCount
 //
@@ -298,7 +529,15 @@ WordTableModel::data(const QModelIndex& index, int role) const
     if ((index.row() < 0) || (index.row() >= wordList.count()))
         return QVariant();
 
+    const WordListSettings& settings = getSettings();
     WordItem& wordItem = wordList[index.row()];
+    if (!wordItem.attributesAreFetched() &&
+        ((role == Qt::DisplayRole) || (role == Qt::EditRole) ||
+         (role == PlayabilityValueRole)))
+    {
+        fetchAttributes(index.row());
+    }
+
     WordType type = (lastAddedIndex == index.row()) ? WordLastAdded
         : wordItem.getType();
 
@@ -398,7 +637,7 @@ WordTableModel::data(const QModelIndex& index, int role) const
                 return wordItem.getWildcard();
 
                 case PROBABILITY_ORDER_COLUMN: {
-                    if (!MainSettings::getWordListShowProbabilityOrder()) {
+                    if (!settings.showProbabilityOrder) {
                         return QString();
                     }
 
@@ -414,7 +653,7 @@ WordTableModel::data(const QModelIndex& index, int role) const
                 }
 
                 case PLAYABILITY_ORDER_COLUMN: {
-                    if (!MainSettings::getWordListShowPlayabilityOrder()) {
+                    if (!settings.showPlayabilityOrder) {
                         return QString();
                     }
 
@@ -434,7 +673,7 @@ WordTableModel::data(const QModelIndex& index, int role) const
                 }
 
                 case FRONT_HOOK_COLUMN:
-                if (!MainSettings::getWordListShowHooks()) {
+                if (!settings.showHooks) {
                     return QString();
                 }
                 else if (!wordItem.hooksAreValid()) {
@@ -445,7 +684,7 @@ WordTableModel::data(const QModelIndex& index, int role) const
                 return wordItem.getFrontHooks();
 
                 case BACK_HOOK_COLUMN:
-                if (!MainSettings::getWordListShowHooks()) {
+                if (!settings.showHooks) {
                     return QString();
                 }
                 else if (!wordItem.hooksAreValid()) {
@@ -461,14 +700,14 @@ WordTableModel::data(const QModelIndex& index, int role) const
                 }
                 else if (role == Qt::DisplayRole) {
                     QString str (word);
-                    if (MainSettings::getWordListShowHookParents()) {
+                    if (settings.showHookParents) {
                         if (!wordItem.parentHooksAreValid()) {
                             wordItem.setParentHooks(
                                 wordEngine->getIsFrontHook(lexicon, wordUpper),
                                 wordEngine->getIsBackHook(lexicon, wordUpper));
                         }
                         QChar hookChar =
-                            (MainSettings::getWordListUseHookParentHyphens() ?
+                            (settings.useHookParentHyphens ?
                                 PARENT_HOOK_HYPHEN_CHAR : PARENT_HOOK_CHAR);
                         str = (wordItem.getFrontParentHook() ? hookChar
                                : QChar(' '))
@@ -476,7 +715,7 @@ WordTableModel::data(const QModelIndex& index, int role) const
                             + (wordItem.getBackParentHook() ? hookChar
                                : QChar(' '));
                     }
-                    if (MainSettings::getWordListUseLexiconStyles()) {
+                    if (settings.useLexiconStyles) {
                         if (!wordItem.lexiconSymbolsAreValid()) {
                             wordItem.setLexiconSymbols(
                                 wordEngine->getLexiconSymbols(lexicon,
@@ -490,7 +729,7 @@ WordTableModel::data(const QModelIndex& index, int role) const
                     return word;
 
                 case DEFINITION_COLUMN:
-                return MainSettings::getWordListShowDefinitions() ?
+                return settings.showDefinitions ?
                     wordEngine->getDefinition(lexicon, wordUpper) :
                     QString();
 
@@ -527,32 +766,33 @@ WordTableModel::headerData(int section, Qt::Orientation orientation, int
         return QVariant();
 
     if (role == Qt::DisplayRole) {
+        const WordListSettings& settings = getSettings();
         switch (section) {
             case WILDCARD_MATCH_COLUMN:
-            return MainSettings::getWordListGroupByAnagrams() ?
+            return settings.groupByAnagrams ?
                 WILDCARD_MATCH_HEADER : QString();
 
             case PROBABILITY_ORDER_COLUMN:
-            return MainSettings::getWordListShowProbabilityOrder() ?
+            return settings.showProbabilityOrder ?
                 PROBABILITY_ORDER_HEADER.arg(probNumBlanks) : QString();
 
             case PLAYABILITY_ORDER_COLUMN:
-            return MainSettings::getWordListShowPlayabilityOrder() ?
+            return settings.showPlayabilityOrder ?
                 PLAYABILITY_ORDER_HEADER : QString();
 
             case FRONT_HOOK_COLUMN:
-            return MainSettings::getWordListShowHooks() ?
+            return settings.showHooks ?
                 FRONT_HOOK_HEADER : QString();
 
             case BACK_HOOK_COLUMN:
-            return MainSettings::getWordListShowHooks() ?
+            return settings.showHooks ?
                 BACK_HOOK_HEADER : QString();
 
             case WORD_COLUMN:
             return WORD_HEADER;
 
             case DEFINITION_COLUMN:
-            return MainSettings::getWordListShowDefinitions() ?
+            return settings.showDefinitions ?
                 DEFINITION_HEADER : QString();
 
             default:
@@ -578,6 +818,7 @@ bool
 WordTableModel::insertRows(int row, int count, const QModelIndex&)
 {
     beginInsertRows(QModelIndex(), row, row + count - 1);
+    sorted = false;
 
     for (int i = 0; i < count; ++i) {
         wordList.insert(row, WordItem(QString(), WordNormal));
@@ -611,6 +852,8 @@ WordTableModel::removeRows(int row, int count, const QModelIndex&)
     }
 
     endRemoveRows();
+    if (wordList.isEmpty())
+        sorted = true;
     return true;
 }
 
@@ -634,6 +877,7 @@ WordTableModel::setData(const QModelIndex& index, const QVariant& value, int
             wordList[index.row()].setWildcard(value.toString());
         }
         else if (index.column() == WORD_COLUMN) {
+            sorted = false;
             WordItem& word = wordList[index.row()];
             word.setWord(value.toString());
             QString wordUpper = word.getWord().toUpper();
@@ -653,9 +897,11 @@ WordTableModel::setData(const QModelIndex& index, const QVariant& value, int
             }
         }
         else if (index.column() == PROBABILITY_ORDER_COLUMN) {
+            sorted = false;
             wordList[index.row()].setProbabilityOrder(value.toInt());
         }
         else if (index.column() == PLAYABILITY_ORDER_COLUMN) {
+            sorted = false;
             wordList[index.row()].setPlayabilityOrder(value.toInt());
         }
         else {
@@ -670,6 +916,7 @@ WordTableModel::setData(const QModelIndex& index, const QVariant& value, int
         return true;
     }
     else if (index.isValid() && (role == PlayabilityValueRole)) {
+        sorted = false;
         wordList[index.row()].setPlayabilityValue(value.toLongLong());
         emit dataChanged(index, index);
         return true;
@@ -689,7 +936,55 @@ WordTableModel::setData(const QModelIndex& index, const QVariant& value, int
 void
 WordTableModel::sort(int, Qt::SortOrder)
 {
-    qSort(wordList.begin(), wordList.end(), lessThan);
+    Z_TRACE_SCOPE("WordTableModel::sort");
+    // Sort keys computed once per item instead of comparing the items
+    WordSortKeyLessThan keyLessThan;
+    QVector<WordSortKey> keys = keyLessThan.getKeys(wordList);
+    qSort(keys.begin(), keys.end(), keyLessThan);
+
+    QList<WordItem> sortedList;
+    sortedList.reserve(keys.size());
+    foreach (const WordSortKey& key, keys)
+        sortedList.append(wordList[key.index]);
+    wordList = sortedList;
+
+    sorted = true;
+
+    if (MainSettings::getWordListGroupByAnagrams())
+        markAlternates();
+
+    emit dataChanged(index(0, 0),
+                     index(wordList.size() - 1, DEFINITION_COLUMN));
+}
+
+//---------------------------------------------------------------------------
+//  mergeWords
+//
+//! Sort the words added after the sorted words at the start of the model,
+//! and merge them with the sorted words, in one pass over the model.
+//
+//! @param numSorted the number of sorted words at the start of the model
+//---------------------------------------------------------------------------
+void
+WordTableModel::mergeWords(int numSorted)
+{
+    WordSortKeyLessThan keyLessThan;
+    QVector<WordSortKey> keys = keyLessThan.getKeys(wordList);
+    qSort(keys.begin() + numSorted, keys.end(), keyLessThan);
+
+    // Words already in the model come before equal new words
+    QList<WordItem> mergedList;
+    mergedList.reserve(keys.size());
+    int i = 0;
+    int j = numSorted;
+    while ((i < numSorted) || (j < keys.size())) {
+        bool takeNew = (j < keys.size()) &&
+            ((i == numSorted) || keyLessThan(keys[j], keys[i]));
+        mergedList.append(wordList[keys[takeNew ? j++ : i++].index]);
+    }
+    wordList = mergedList;
+
+    sorted = true;
 
     if (MainSettings::getWordListGroupByAnagrams())
         markAlternates();
@@ -711,6 +1006,7 @@ WordTableModel::reverse()
     for (; iForward < iReverse; ++iForward, --iReverse) {
         wordList.swap(iForward, iReverse);
     }
+    sorted = (wordList.size() < 2);
 
     emit dataChanged(index(0, 0),
         index(wordList.size() - 1, DEFINITION_COLUMN));
@@ -760,6 +1056,83 @@ WordTableModel::addWordPrivate(const WordItem& word, int row)
     }
 }
 
+//---------------------------------------------------------------------------
+//  getSettings
+//
+//! Get the word list settings the model is displayed with, reading them
+//! again only if the settings have changed since they were last read.
+//
+//! @return the word list settings
+//---------------------------------------------------------------------------
+const WordListSettings&
+WordTableModel::getSettings() const
+{
+    if (!currentSettings.isCurrent())
+        currentSettings.refresh();
+    return currentSettings;
+}
+
+//---------------------------------------------------------------------------
+//  fetchAttributes
+//
+//! Fetch the attributes shown by the view for the page of rows containing a
+//! row, loading the words of the page into the word engine cache at once.
+//
+//! @param row the row
+//---------------------------------------------------------------------------
+void
+WordTableModel::fetchAttributes(int row) const
+{
+    int start = row - (row % FETCH_PAGE_ROWS);
+    int end = qMin(start + FETCH_PAGE_ROWS, wordList.size());
+
+    QStringList words;
+    for (int i = start; i < end; ++i) {
+        if (!wordList[i].attributesAreFetched())
+            words.append(wordList[i].getWord().toUpper());
+    }
+    wordEngine->addToCache(lexicon, words);
+
+    const WordListSettings& settings = getSettings();
+
+    for (int i = start; i < end; ++i) {
+        WordItem& item = wordList[i];
+        if (item.attributesAreFetched())
+            continue;
+
+        QString wordUpper = item.getWord().toUpper();
+        if (settings.showHooks && !item.hooksAreValid()) {
+            item.setHooks(
+                wordEngine->getFrontHookLetters(lexicon, wordUpper),
+                wordEngine->getBackHookLetters(lexicon, wordUpper));
+        }
+        if (settings.showHookParents && !item.parentHooksAreValid()) {
+            item.setParentHooks(
+                wordEngine->getIsFrontHook(lexicon, wordUpper),
+                wordEngine->getIsBackHook(lexicon, wordUpper));
+        }
+        if (settings.useLexiconStyles && !item.lexiconSymbolsAreValid()) {
+            item.setLexiconSymbols(
+                wordEngine->getLexiconSymbols(lexicon, wordUpper));
+        }
+        if (settings.showProbabilityOrder && !item.probabilityOrderIsValid()) {
+            int p = wordEngine->getProbabilityOrder(lexicon, wordUpper,
+                                                    probNumBlanks);
+            if (p)
+                item.setProbabilityOrder(p);
+        }
+        if (settings.showPlayabilityOrder && !item.playabilityOrderIsValid()) {
+            qint64 pv = wordEngine->getPlayabilityValue(lexicon, wordUpper);
+            if (pv)
+                item.setPlayabilityValue(pv);
+            int po = wordEngine->getPlayabilityOrder(lexicon, wordUpper);
+            if (po)
+                item.setPlayabilityOrder(po);
+        }
+        item.setAttributesFetched();
+    }
+}
+
 //---------------------------------------------------------------------------
 //  markAlternates
 //
@@ -779,11 +1152,151 @@ WordTableModel::markAlternates()
                 alternate = !alternate;
             prevAlphagram = alphagram;
         }
-        if (alternate && (item.getType() == WordNormal))
-            item.setType(WordNormalAlternate);
+        if (isAlternateType(item.getType()))
+            item.setType(alternate ? WordNormalAlternate : WordNormal);
     }
 }
 
+//---------------------------------------------------------------------------
+//  markAlternates
+//
+//! Mark alternating groups of alphagram matching items again after a row
+//! has been added or removed.  Groups are marked starting with the group
+//! before the row, and marking stops at the first group after the row that
+//! is already marked correctly.  Only rows whose marking changes are
+//! reported as changed.
+//
+//! @param row the row that was added, or the row after the rows that were
+//! removed
+//---------------------------------------------------------------------------
+void
+WordTableModel::markAlternates(int row)
+{
+    if (wordList.isEmpty())
+        return;
+
+    // Start with the group before the group containing the row, or further
+    // back until a group whose marking is known
+    int start = qBound(0, row, wordList.size() - 1);
+    start = getGroupStart(start);
+    if (start > 0)
+        start = getGroupStart(start - 1);
+    int state = -1;
+    while (state < 0) {
+        state = getGroupState(start);
+        if (start == 0)
+            state = 0;
+        else if (state < 0)
+            start = getGroupStart(start - 1);
+    }
+
+    bool alternate = (state == 1);
+    int firstChanged = -1;
+    int lastChanged = -1;
+    int groupStart = start;
+    while (groupStart < wordList.size()) {
+        QString alphagram =
+            Auxil::getAlphagram(wordList[groupStart].getWord().toUpper());
+        bool markable = false;
+        bool changed = false;
+        int i = groupStart;
+        for (; i < wordList.size(); ++i) {
+            WordItem& item = wordList[i];
+            if ((i > groupStart) && (Auxil::getAlphagram(
+                    item.getWord().toUpper()) != alphagram))
+            {
+                break;
+            }
+            if (!isAlternateType(item.getType()))
+                continue;
+            markable = true;
+            WordType type = alternate ? WordNormalAlternate : WordNormal;
+            if (item.getType() != type) {
+                item.setType(type);
+                changed = true;
+                if (firstChanged < 0)
+                    firstChanged = i;
+                lastChanged = i;
+            }
+        }
+
+        // Groups after this one were marked correctly before the change
+        if ((groupStart > row) && markable && !changed)
+            break;
+
+        groupStart = i;
+        alternate = !alternate;
+    }
+
+    if (firstChanged >= 0) {
+        emit dataChanged(index(firstChanged, 0),
+                         index(lastChanged, DEFINITION_COLUMN));
+    }
+}
+
+//---------------------------------------------------------------------------
+//  getGroupStart
+//
+//! Find the first row of the anagram group containing a row.
+//
+//! @param row the row
+//! @return the first row of the group
+//---------------------------------------------------------------------------
+int
+WordTableModel::getGroupStart(int row) const
+{
+    QString alphagram = Auxil::getAlphagram(wordList[row].getWord().toUpper());
+    while ((row > 0) && (Auxil::getAlphagram(
+               wordList[row - 1].getWord().toUpper()) == alphagram))
+    {
+        --row;
+    }
+    return row;
+}
+
+//---------------------------------------------------------------------------
+//  getGroupState
+//
+//! Determine how an anagram group is marked, from the first of its rows
+//! whose type shows the marking.
+//
+//! @param start the first row of the group
+//! @return 1 if the group is marked as alternate, 0 if it is marked as
+//! normal, or -1 if none of its rows shows the marking
+//---------------------------------------------------------------------------
+int
+WordTableModel::getGroupState(int start) const
+{
+    QString alphagram =
+        Auxil::getAlphagram(wordList[start].getWord().toUpper());
+    for (int i = start; i < wordList.size(); ++i) {
+        const WordItem& item = wordList[i];
+        if ((i > start) &&
+            (Auxil::getAlphagram(item.getWord().toUpper()) != alphagram))
+        {
+            break;
+        }
+        if (isAlternateType(item.getType()))
+            return (item.getType() == WordNormalAlternate) ? 1 : 0;
+    }
+    return -1;
+}
+
+//---------------------------------------------------------------------------
+//  isAlternateType
+//
+//! Determine whether a word type is one of the types used to mark
+//! alternating anagram groups.
+//
+//! @param type the word type
+//! @return true if the type is WordNormal or WordNormalAlternate
+//---------------------------------------------------------------------------
+bool
+WordTableModel::isAlternateType(WordType type)
+{
+    return (type == WordNormal) || (type == WordNormalAlternate);
+}
+
 ////---------------------------------------------------------------------------
 ////  isFrontHook
 ////
@@ -852,6 +1365,7 @@ WordTableModel::markAlternates()
 void
 WordTableModel::WordItem::init()
 {
+    attributesFetched = false;
     hooksValid = false;
     parentHooksValid = false;
     probabilityOrderValid = false;
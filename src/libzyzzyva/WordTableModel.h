@@ -25,6 +25,7 @@
 #ifndef ZYZZYVA_WORD_TABLE_MODEL_H
 #define ZYZZYVA_WORD_TABLE_MODEL_H
 
+#include "MainSettings.h"
 #include <QAbstractTableModel>
 #include <QChar>
 #include <QStringList>
@@ -81,6 +82,8 @@ class WordTableModel : public QAbstractTableModel
         bool probabilityOrderIsValid() const { return probabilityOrderValid; }
         bool playabilityOrderIsValid() const { return playabilityOrderValid; }
         bool lexiconSymbolsAreValid() const { return lexiconSymbolsValid; }
+        bool attributesAreFetched() const { return attributesFetched; }
+        void setAttributesFetched() { attributesFetched = true; }
 
         bool operator==(const WordItem& other) const {
             return ((word == other.word) && (type == other.type));
@@ -90,6 +93,7 @@ class WordTableModel : public QAbstractTableModel
         }
 
         private:
+        bool attributesFetched;
         bool hooksValid;
         bool parentHooksValid;
         bool probabilityOrderValid;
@@ -117,6 +121,7 @@ class WordTableModel : public QAbstractTableModel
     bool addWord(const WordItem& word, bool updateLastAdded = true);
     bool addWords(const QList<WordItem>& words);
     bool removeWord(const QString& word);
+    bool removeWords(const QStringList& words);
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const;
     int columnCount(const QModelIndex& parent = QModelIndex()) const;
@@ -143,7 +148,14 @@ class WordTableModel : public QAbstractTableModel
 
     private:
     void addWordPrivate(const WordItem& word, int row);
+    void mergeWords(int numSorted);
+    const WordListSettings& getSettings() const;
+    void fetchAttributes(int row) const;
     void markAlternates();
+    void markAlternates(int row);
+    int getGroupStart(int row) const;
+    int getGroupState(int start) const;
+    static bool isAlternateType(WordType type);
 
     private:
     WordEngine* wordEngine;
@@ -151,6 +163,8 @@ class WordTableModel : public QAbstractTableModel
     mutable QList<WordItem> wordList;
     int probNumBlanks;
     int lastAddedIndex;
+    bool sorted;
+    mutable WordListSettings currentSettings;
 
     public:
     enum {
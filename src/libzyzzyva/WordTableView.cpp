@@ -32,6 +32,7 @@
 #include "QuizStatsDatabase.h"
 #include "SearchSpec.h"
 #include "WordEngine.h"
+#include "WordIdList.h"
 #include "WordListSaveDialog.h"
 #include "WordTableModel.h"
 #include "WordVariationDialog.h"
@@ -44,9 +45,11 @@
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QMenu>
+#include <QProgressDialog>
 #include <QPushButton>
 #include <QSignalMapper>
 #include <QTextStream>
+#include <QTimer>
 #include <QToolTip>
 
 using namespace std;
@@ -55,6 +58,15 @@ const int WordTableModel::ITEM_XPADDING = 5;
 const int WordTableModel::ITEM_YPADDING = 0;
 const int TWO_COLUMN_ANAGRAM_PADDING = 3;
 
+// Number of rows exported between updates of the export progress
+const int EXPORT_PROGRESS_ROWS = 500;
+
+// Number of rows, spread evenly over the list, measured to size columns
+// right away, and number of rows measured in each step of exact sizing
+// while the application is idle
+const int SIZE_SAMPLE_ROWS = 200;
+const int SIZE_STEP_ROWS = 500;
+
 //---------------------------------------------------------------------------
 //  WordTableView
 //
@@ -63,8 +75,12 @@ const int TWO_COLUMN_ANAGRAM_PADDING = 3;
 //! @param parent the parent object
 //---------------------------------------------------------------------------
 WordTableView::WordTableView(WordEngine* e, QWidget* parent)
-    : QTreeView(parent), wordEngine(e)
+    : QTreeView(parent), wordEngine(e), sizeRow(0)
 {
+    sizeTimer = new QTimer(this);
+    sizeTimer->setInterval(0);
+    connect(sizeTimer, SIGNAL(timeout()), SLOT(sizeNextRows()));
+
     setFocusPolicy(Qt::NoFocus);
     setSelectionBehavior(QAbstractItemView::SelectRows);
     setSelectionMode(QAbstractItemView::SingleSelection);
@@ -91,15 +107,70 @@ WordTableView::WordTableView(WordEngine* e, QWidget* parent)
 //---------------------------------------------------------------------------
 //  resizeItemsToContents
 //
-//! Resize all columns to fit the model contents.
+//! Resize all columns to fit the model contents.  Large lists are first
+//! sized to fit the visible rows and a sample of other rows, and then sized
+//! to fit every row a few rows at a time while the application is idle.
 //---------------------------------------------------------------------------
 void
 WordTableView::resizeItemsToContents()
 {
 //    for (int i = 0; i < model()->rowCount(); ++i)
 //        resizeRowToContents(i);
+    sizeTimer->stop();
     for (int i = 0; i < model()->columnCount(); ++i)
         resizeColumnToContents(i);
+
+    if (model()->rowCount() > SIZE_SAMPLE_ROWS) {
+        sizeRow = 0;
+        sizeWidths.fill(0, model()->columnCount());
+        sizeTimer->start();
+    }
+}
+
+//---------------------------------------------------------------------------
+//  sizeNextRows
+//
+//! Measure the next few rows for exact column sizing, and resize the
+//! columns to fit every row once all rows have been measured.
+//---------------------------------------------------------------------------
+void
+WordTableView::sizeNextRows()
+{
+    int numRows = model()->rowCount();
+    int numColumns = qMin(model()->columnCount(), sizeWidths.size());
+    int end = qMin(sizeRow + SIZE_STEP_ROWS, numRows);
+    for (int column = 0; column < numColumns; ++column) {
+        for (int row = sizeRow; row < end; ++row) {
+            sizeWidths[column] = qMax(sizeWidths[column],
+                getContentWidth(row, column));
+        }
+    }
+    sizeRow = end;
+    if (sizeRow < numRows)
+        return;
+
+    sizeTimer->stop();
+    for (int column = 0; column < numColumns; ++column) {
+        int width = sizeWidths[column] + (2 * WordTableModel::ITEM_XPADDING);
+        if (!header()->isHidden())
+            width = qMax(width, header()->sectionSizeHint(column));
+        header()->resizeSection(column, width);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  getContentWidth
+//
+//! Determine the width needed to display the contents of a cell.
+//
+//! @param row the row of the cell
+//! @param column the column of the cell
+//! @return the width
+//---------------------------------------------------------------------------
+int
+WordTableView::getContentWidth(int row, int column) const
+{
+    return sizeHintForIndex(model()->index(row, column)).width();
 }
 
 //---------------------------------------------------------------------------
@@ -193,15 +264,19 @@ WordTableView::exportRequested()
     if (attributes.empty())
         return;
 
+    bool wordIds = (format == WordListWordIds);
+    QString extension = wordIds ? QString(".zwl") : QString(".txt");
+    QString filter = wordIds ? QString("Word ID Lists (*.zwl)")
+                             : QString("Text Files (*.txt)");
     QString filename = QFileDialog::getSaveFileName(this, "Save Word List",
-        Auxil::getUserWordsDir() + "/saved", "Text Files (*.txt)", 0,
+        Auxil::getUserWordsDir() + "/saved", filter, 0,
         QFileDialog::DontConfirmOverwrite);
 
     if (filename.isEmpty())
         return;
 
-    if (!filename.endsWith(".txt", Qt::CaseInsensitive))
-        filename += ".txt";
+    if (!filename.endsWith(extension, Qt::CaseInsensitive))
+        filename += extension;
 
     bool append = false;
     if (QFile::exists(filename)) {
@@ -237,10 +312,10 @@ WordTableView::exportRequested()
             append = true;
     }
 
-    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
     QString error;
-    bool ok = exportFile(filename, format, attributes, &error, append);
-    QApplication::restoreOverrideCursor();
+    bool ok = wordIds ? exportWordIdFile(filename, attributes, &error, append)
+                      : exportFile(filename, format, attributes, &error,
+                                   append);
     if (!ok) {
         QString caption = "Error Saving Word List";
         QString message = "Cannot save word list:\n" + error + ".";
@@ -404,7 +479,9 @@ WordTableView::removeFromCardboxRequested()
 //---------------------------------------------------------------------------
 //  exportFile
 //
-//! Export the words in the list to a file, one word per line.
+//! Export the words in the list to a file, one word per line.  Progress is
+//! shown as the rows are written, and the user can cancel the export, in
+//! which case the file is left as it was before the export.
 //
 //! @param filename the name of the file
 //! @param format the save file format
@@ -416,9 +493,10 @@ WordTableView::removeFromCardboxRequested()
 bool
 WordTableView::exportFile(const QString& filename, WordListFormat format,
                           const QList<WordAttribute>& attributes,
-                          QString* err, bool append) const
+                          QString* err, bool append)
 {
-    if (model()->rowCount() == 0) {
+    int numRows = model()->rowCount();
+    if (numRows == 0) {
         if (err)
             *err = "No words to save";
         return false;
@@ -429,21 +507,39 @@ WordTableView::exportFile(const QString& filename, WordListFormat format,
     if (append)
         mode |= QIODevice::Append;
 
+    qint64 origSize = append ? QFileInfo(filename).size() : 0;
     if (!file.open(mode)) {
         if (err)
             *err = file.errorString();
         return false;
     }
 
+    // Lines are ended with plain newlines rather than endl, so the stream
+    // buffers its output instead of flushing every line
     QTextStream stream (&file);
 
+    bool twoColumns = (format == WordListAnagramTwoColumn);
+    QProgressDialog progress ("Saving word list...", "Cancel", 0,
+                              twoColumns ? 2 * numRows : numRows, this);
+    progress.setWindowTitle("Saving Word List");
+    progress.setWindowModality(Qt::WindowModal);
+    int rowsDone = 0;
+    bool canceled = false;
+
     if (format == WordListOnePerLine) {
         QModelIndex index = model()->index(0, WordTableModel::WORD_COLUMN);
-        for (int i = 0; i < model()->rowCount(); ++i) {
+        for (int i = 0; i < numRows; ++i) {
             index = index.sibling(i, WordTableModel::WORD_COLUMN);
             QStringList strings = getExportStrings(index, attributes);
-            stream << strings.join("\t");
-            endl(stream);
+            stream << strings.join("\t") << "\n";
+
+            if ((++rowsDone % EXPORT_PROGRESS_ROWS) == 0) {
+                progress.setValue(rowsDone);
+                if (progress.wasCanceled()) {
+                    canceled = true;
+                    break;
+                }
+            }
         }
     }
 
@@ -454,15 +550,13 @@ WordTableView::exportFile(const QString& filename, WordListFormat format,
         // Build map of alphagrams to indexes
         QMap<QString, QList<int> > alphaIndexes;
         QModelIndex index = model()->index(0, WordTableModel::WORD_COLUMN);
-        for (int i = 0; i < model()->rowCount(); ++i) {
+        for (int i = 0; i < numRows; ++i) {
             index = index.sibling(i, WordTableModel::WORD_COLUMN);
             QString word = model()->data(index, Qt::EditRole).toString();
             QString alphagram = Auxil::getAlphagram(word);
             alphaIndexes[alphagram].append(i);
         }
 
-        bool twoColumns = (format == WordListAnagramTwoColumn);
-
         // Iterate over the list, finding out the maximum column width
         // of each of the attribute fields. (Trading a bit of time for space,
         // we call getExportStrings twice per list, rather than store the
@@ -479,7 +573,7 @@ WordTableView::exportFile(const QString& filename, WordListFormat format,
 
         if (twoColumns) {
             QMapIterator<QString, QList<int> > it (alphaIndexes);
-            while (it.hasNext()) {
+            while (it.hasNext() && !canceled) {
                 it.next();
                 anagramWidth = max(anagramWidth, it.key().length());
                 QListIterator<int> jt (it.value());
@@ -490,6 +584,14 @@ WordTableView::exportFile(const QString& filename, WordListFormat format,
                     for (int i = 0; i < fields; ++i) {
                         columnWidths[i] = max(columnWidths[i], strings[i].length());
                     }
+
+                    if ((++rowsDone % EXPORT_PROGRESS_ROWS) == 0) {
+                        progress.setValue(rowsDone);
+                        if (progress.wasCanceled()) {
+                            canceled = true;
+                            break;
+                        }
+                    }
                 }
             }
 
@@ -503,19 +605,22 @@ WordTableView::exportFile(const QString& filename, WordListFormat format,
 
         QString anagramPadding = QString(anagramWidth, ' ');
         QMapIterator<QString, QList<int> > it (alphaIndexes);
-        while (it.hasNext()) {
+        while (it.hasNext() && !canceled) {
             it.next();
             if (twoColumns) {
                 stream << it.key().leftJustified(anagramWidth, ' ');
             }
             else if (format == WordListDistinctAlphagrams) {
-                stream << it.key();
-                endl(stream);
+                stream << it.key() << "\n";
+                rowsDone += it.value().count();
+                if (progress.value() + EXPORT_PROGRESS_ROWS <= rowsDone) {
+                    progress.setValue(rowsDone);
+                    canceled = progress.wasCanceled();
+                }
                 continue;
             }
             else {
-                stream << "Q: " << it.key();
-                endl(stream);
+                stream << "Q: " << it.key() << "\n";
             }
 
             bool firstAnagram = true;
@@ -536,18 +641,133 @@ WordTableView::exportFile(const QString& filename, WordListFormat format,
                 else {
                     stream << "A: " << strings.join(" ");
                 }
-                endl(stream);
+                stream << "\n";
+
+                if ((++rowsDone % EXPORT_PROGRESS_ROWS) == 0) {
+                    progress.setValue(rowsDone);
+                    canceled = progress.wasCanceled();
+                }
             }
 
             if (!twoColumns) {
-                endl(stream);
+                stream << "\n";
             }
         }
     }
 
+    // Leave the file as it was if the export was canceled
+    if (canceled) {
+        file.close();
+        if (append)
+            QFile::resize(filename, origSize);
+        else
+            QFile::remove(filename);
+        return true;
+    }
+
+    stream.flush();
+    progress.setValue(progress.maximum());
+    if (stream.status() != QTextStream::Ok) {
+        if (err)
+            *err = file.errorString();
+        return false;
+    }
+
     return true;
 }
 
+//---------------------------------------------------------------------------
+//  exportWordIdFile
+//
+//! Export the words in the list to a word ID list file, with the values of
+//! the attributes that have their own columns.  The word itself is saved as
+//! its ID, and attributes that only change how the word is shown are
+//! dropped.  Appending adds the words to the list already in the file,
+//! which must be of the same lexicon build and have the same attributes.
+//
+//! @param filename the name of the file
+//! @param attributes a list of attributes to export
+//! @param err return error string on failure
+//! @param append whether to add the words to the list in the file
+//
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordTableView::exportWordIdFile(const QString& filename, const
+                                QList<WordAttribute>& attributes, QString*
+                                err, bool append)
+{
+    WordTableModel* wordModel = static_cast<WordTableModel*>(model());
+    QString lexicon = wordModel->getLexicon();
+    if (lexicon.isEmpty())
+        lexicon = MainSettings::getDefaultLexicon();
+
+    QList<WordAttribute> idAttributes;
+    foreach (WordAttribute attribute, attributes) {
+        switch (attribute) {
+            case WordAttrWord:
+            case WordAttrInnerHooks:
+            case WordAttrLexiconSymbols:
+            case WordAttrFrontExtensions:
+            case WordAttrBackExtensions:
+            case WordAttrDoubleExtensions:
+            break;
+
+            default:
+            idAttributes.append(attribute);
+            break;
+        }
+    }
+
+    WordIdList idList;
+    if (append) {
+        if (!idList.readFile(filename, err))
+            return false;
+        if ((idList.getLexicon() != lexicon) ||
+            (idList.getBuild() != wordEngine->getLexiconBuild(lexicon)))
+        {
+            if (err)
+                *err = "The file holds a list from a different lexicon";
+            return false;
+        }
+        if (idList.getAttributes() != idAttributes) {
+            if (err)
+                *err = "The file holds a list with different attributes";
+            return false;
+        }
+    }
+    else {
+        idList.setLexicon(lexicon);
+        idList.setBuild(wordEngine->getLexiconBuild(lexicon));
+        idList.setAttributes(idAttributes);
+    }
+
+    int numRows = model()->rowCount();
+    QStringList words;
+    QModelIndex index = model()->index(0, WordTableModel::WORD_COLUMN);
+    for (int i = 0; i < numRows; ++i) {
+        index = index.sibling(i, WordTableModel::WORD_COLUMN);
+        words.append(model()->data(index, Qt::EditRole).toString());
+    }
+
+    QVector<qint32> ids = wordEngine->getWordIds(lexicon, words);
+    for (int i = 0; i < numRows; ++i) {
+        if (ids[i] < 0)
+            continue;
+        index = index.sibling(i, WordTableModel::WORD_COLUMN);
+        idList.addWord(ids[i], idAttributes.isEmpty() ? QStringList()
+                       : getExportStrings(index, idAttributes));
+    }
+
+    if (idList.isEmpty()) {
+        if (err)
+            *err = "No acceptable words to save";
+        return false;
+    }
+
+    return idList.writeFile(filename, err);
+}
+
 //---------------------------------------------------------------------------
 //  getExportStrings
 //
@@ -969,8 +1189,27 @@ WordTableView::viewportEvent(QEvent* e)
 int
 WordTableView::sizeHintForColumn(int column) const
 {
-    return QAbstractItemView::sizeHintForColumn(column) +
-        (2 * WordTableModel::ITEM_XPADDING);
+    int numRows = model()->rowCount();
+    if (numRows <= SIZE_SAMPLE_ROWS) {
+        return QAbstractItemView::sizeHintForColumn(column) +
+            (2 * WordTableModel::ITEM_XPADDING);
+    }
+
+    // Measure the visible rows and rows spread evenly over the list
+    int width = 0;
+    QModelIndex first = indexAt(QPoint(0, 0));
+    QModelIndex last = indexAt(QPoint(0, viewport()->height() - 1));
+    int firstRow = first.isValid() ? first.row() : 0;
+    int lastRow = last.isValid() ? last.row()
+                                 : qMin(numRows, firstRow + 100) - 1;
+    for (int row = firstRow; row <= lastRow; ++row)
+        width = qMax(width, getContentWidth(row, column));
+
+    int step = numRows / SIZE_SAMPLE_ROWS;
+    for (int row = 0; row < numRows; row += step)
+        width = qMax(width, getContentWidth(row, column));
+
+    return width + (2 * WordTableModel::ITEM_XPADDING);
 }
 
 //---------------------------------------------------------------------------
@@ -29,8 +29,10 @@
 #include "WordListFormat.h"
 #include <QString>
 #include <QTreeView>
+#include <QVector>
 
 class WordEngine;
+class QTimer;
 
 class WordTableView : public QTreeView
 {
@@ -53,6 +55,7 @@ class WordTableView : public QTreeView
     virtual int sizeHintForRow(int row) const;
 
     private slots:
+    void sizeNextRows();
     void viewDefinition();
     void viewVariation(int variation);
     void headerSectionClicked(int section);
@@ -61,8 +64,9 @@ class WordTableView : public QTreeView
     // XXX: Hmm, these methods probably don't belong in WordTableView
     bool exportFile(const QString& filename, WordListFormat format,
                     const QList<WordAttribute>& attributes, QString* err,
-                    bool append = false)
-        const;
+                    bool append = false);
+    bool exportWordIdFile(const QString& filename, const QList<WordAttribute>&
+                          attributes, QString* err, bool append = false);
     QStringList getExportStrings(QModelIndex& index,
                                  const QList<WordAttribute>& attributes) const;
     bool addToCardbox(const QStringList& words, const QString& lexicon,
@@ -73,10 +77,16 @@ class WordTableView : public QTreeView
 
     QString hookToolTipText(const QString& word, const QString& hooks,
                             bool front) const;
+    int getContentWidth(int row, int column) const;
 
     private:
     WordEngine* wordEngine;
 
+    // Exact column sizing done while the application is idle
+    QTimer* sizeTimer;
+    int sizeRow;
+    QVector<int> sizeWidths;
+
 };
 
 #endif // ZYZZYVA_WORD_TABLE_VIEW_H
@@ -34,6 +34,7 @@
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QList>
+#include <QRegExp>
 #include <QVBoxLayout>
 
 using namespace Defs;
@@ -200,54 +201,23 @@ WordVariationDialog::setWordVariation(const QString& word, WordVariationType
 
         case VariationAnagramHooks:
         title = "Anagram Hooks for: " + word;
-        condition.type = SearchCondition::AnagramMatch;
-        condition.stringValue = "?" + word;
-        spec.conditions.append(condition);
-        topSpecs.append(spec);
         topTitle = "Anagram Hooks";
+        middleTitle = "Anagrams Minus One Letter";
         break;
 
         case VariationBlankAnagrams:
         title = "Blank Anagrams for: " + word;
-        condition.type = SearchCondition::AnagramMatch;
-        for (int i = 0; i < int(word.length()); ++i) {
-            condition.stringValue = word.left(i) + "?" +
-                word.right(word.length() - i - 1);
-            spec.conditions.clear();
-            spec.conditions.append(condition);
-            topSpecs.append(spec);
-        }
         topTitle = "Blank Anagrams";
         break;
 
         case VariationBlankMatches:
         title = "Blank Matches for: " + word;
-        condition.type = SearchCondition::PatternMatch;
-        for (int i = 0; i < int(word.length()); ++i) {
-            condition.stringValue = word.left(i) + "?" +
-                word.right(word.length() - i - 1);
-            spec.conditions.clear();
-            spec.conditions.append(condition);
-            topSpecs.append(spec);
-        }
         topTitle = "Blank Matches";
         forceAlphabetSort = true;
         break;
 
         case VariationExtensions:
         title = "Extensions for: " + word;
-        condition.type = SearchCondition::PatternMatch;
-        condition.stringValue = "*?" + word;
-        spec.conditions.append(condition);
-        topSpecs.append(spec);
-        condition.stringValue = word + "?*";
-        spec.conditions.clear();
-        spec.conditions.append(condition);
-        middleSpecs.append(spec);
-        condition.stringValue = "*?" + word + "?*";
-        spec.conditions.clear();
-        spec.conditions.append(condition);
-        bottomSpecs.append(spec);
         topTitle = "Front Extensions";
         middleTitle = "Back Extensions";
         bottomTitle = "Double Extensions";
@@ -256,14 +226,6 @@ WordVariationDialog::setWordVariation(const QString& word, WordVariationType
 
         case VariationTranspositions:
         title = "Transpositions for: " + word;
-        condition.type = SearchCondition::PatternMatch;
-        for (int i = 0; i < int(word.length()); ++i) {
-            condition.stringValue = word.left(i) + word.mid(i + 1, 1) +
-                word.mid(i, 1) + word.right(word.length() - i - 2);
-            spec.conditions.clear();
-            spec.conditions.append(condition);
-            topSpecs.append(spec);
-        }
         topTitle = "Transpositions";
         break;
 
@@ -277,8 +239,35 @@ WordVariationDialog::setWordVariation(const QString& word, WordVariationType
 
     QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 
-    // Populate the top list
-    QList<WordTableModel::WordItem> wordItems = getWordItems(topSpecs);
+    // Populate the top list.  Blank variations and transpositions are found
+    // in one traversal of the word graph instead of a search for each
+    // position, and extensions by traversing the subtree below the word.
+    QList<WordTableModel::WordItem> wordItems;
+    if (variation == VariationBlankAnagrams) {
+        wordItems = getWordItems(wordEngine->getBlankVariations(lexicon,
+                                                                word, true));
+    }
+    else if (variation == VariationBlankMatches) {
+        wordItems = getWordItems(wordEngine->getBlankVariations(lexicon,
+                                                                word, false));
+    }
+    else if (variation == VariationTranspositions) {
+        // The word is only its own transposition if it has a double letter
+        QStringList words = wordEngine->getEditNeighbors(lexicon, word, 1,
+            WordGraph::EditTranspose);
+        if (!word.contains(QRegExp("(.)\\1")))
+            words.removeAll(word.toUpper());
+        wordItems = getWordItems(words);
+    }
+    else if (variation == VariationExtensions) {
+        wordItems = getWordItems(wordEngine->getExtensions(lexicon, word,
+            WordGraph::FrontExtensions));
+    }
+    else if (variation == VariationAnagramHooks) {
+        wordItems = getWordItems(wordEngine->getAnagramHooks(lexicon, word));
+    }
+    else
+        wordItems = getWordItems(topSpecs);
 
     // FIXME: Probably not the right way to get alphabetical sorting instead
     // of alphagram sorting
@@ -295,8 +284,19 @@ WordVariationDialog::setWordVariation(const QString& word, WordVariationType
     topLabel->setText(topTitle);
 
     // Populate the middle list
-    if (!middleSpecs.empty()) {
-        wordItems = getWordItems(middleSpecs);
+    bool extensions = (variation == VariationExtensions);
+    bool anagramHooks = (variation == VariationAnagramHooks);
+    if (!middleSpecs.empty() || extensions || anagramHooks) {
+        if (extensions) {
+            wordItems = getWordItems(wordEngine->getExtensions(lexicon, word,
+                WordGraph::BackExtensions));
+        }
+        else if (anagramHooks) {
+            wordItems = getWordItems(wordEngine->getAnagramStems(lexicon,
+                                                                 word));
+        }
+        else
+            wordItems = getWordItems(middleSpecs);
 
         // FIXME: Probably not the right way to get alphabetical sorting
         // instead of alphagram sorting
@@ -314,8 +314,13 @@ WordVariationDialog::setWordVariation(const QString& word, WordVariationType
     }
 
     // Populate the bottom list
-    if (!bottomSpecs.empty()) {
-        wordItems = getWordItems(bottomSpecs);
+    if (!bottomSpecs.empty() || extensions) {
+        if (extensions) {
+            wordItems = getWordItems(wordEngine->getExtensions(lexicon, word,
+                WordGraph::DoubleExtensions));
+        }
+        else
+            wordItems = getWordItems(bottomSpecs);
 
         // FIXME: Probably not the right way to get alphabetical sorting
         // instead of alphagram sorting
@@ -346,17 +351,33 @@ WordVariationDialog::setWordVariation(const QString& word, WordVariationType
 //---------------------------------------------------------------------------
 QList<WordTableModel::WordItem>
 WordVariationDialog::getWordItems(const QList<SearchSpec>& searchSpecs) const
+{
+    QStringList words;
+    QList<QStringList> wordLists = wordEngine->searchMany(lexicon,
+                                                          searchSpecs, false);
+    foreach (const QStringList& wordList, wordLists)
+        words += wordList;
+    return getWordItems(words);
+}
+
+//---------------------------------------------------------------------------
+//  getWordItems
+//
+//! Construct a list of word items to be inserted into a word list, based on
+//! a list of words with letters matched by wildcards in lower case.
+//
+//! @param words the list of words
+//! @return a list of word items
+//---------------------------------------------------------------------------
+QList<WordTableModel::WordItem>
+WordVariationDialog::getWordItems(const QStringList& words) const
 {
     QList<WordTableModel::WordItem> wordItems;
     QMap<QString, QString> wordMap;
-    QListIterator<SearchSpec> lit (searchSpecs);
-    while (lit.hasNext()) {
-        QStringList wordList = wordEngine->search(lexicon, lit.next(), false);
-        QStringListIterator wit (wordList);
-        while (wit.hasNext()) {
-            QString str = wit.next();
-            wordMap.insert(str.toUpper(), str);
-        }
+    QStringListIterator wit (words);
+    while (wit.hasNext()) {
+        QString str = wit.next();
+        wordMap.insert(str.toUpper(), str);
     }
 
     QMapIterator<QString, QString> mit (wordMap);
@@ -383,6 +404,32 @@ WordVariationDialog::getWordItems(const QList<SearchSpec>& searchSpecs) const
     return wordItems;
 }
 
+//---------------------------------------------------------------------------
+//  getWordItems
+//
+//! Construct a list of word items to be inserted into a word list, based on
+//! lists of words keyed by a letter added to or removed from a word.  The
+//! letter is shown as the wildcard match of each word.
+//
+//! @param letterWords the lists of words keyed by letter
+//! @return a list of word items
+//---------------------------------------------------------------------------
+QList<WordTableModel::WordItem>
+WordVariationDialog::getWordItems(const QMap<QChar, QStringList>&
+                                  letterWords) const
+{
+    QList<WordTableModel::WordItem> wordItems;
+    QMapIterator<QChar, QStringList> it (letterWords);
+    while (it.hasNext()) {
+        it.next();
+        foreach (const QString& word, it.value()) {
+            wordItems.append(WordTableModel::WordItem(
+                word, WordTableModel::WordNormal, QString(it.key())));
+        }
+    }
+    return wordItems;
+}
+
 //---------------------------------------------------------------------------
 //  getNumLists
 //
@@ -397,6 +444,7 @@ WordVariationDialog::getNumLists(WordVariationType variation)
     switch (variation) {
         case VariationHooks: return 2;
         case VariationExtensions: return 3;
+        case VariationAnagramHooks: return 2;
         default: return 1;
     }
 }
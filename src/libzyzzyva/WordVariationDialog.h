@@ -31,6 +31,7 @@
 #include <QDialog>
 #include <QList>
 #include <QLabel>
+#include <QMap>
 
 class DefinitionLabel;
 class WordEngine;
@@ -50,6 +51,11 @@ class WordVariationDialog : public QDialog
     void setWordVariation(const QString& word, WordVariationType variation);
     QList<WordTableModel::WordItem> getWordItems(const QList<SearchSpec>&
                                                  searchSpecs) const;
+    QList<WordTableModel::WordItem> getWordItems(const QStringList& words)
+        const;
+    QList<WordTableModel::WordItem> getWordItems(const QMap<QChar,
+                                                 QStringList>& letterWords)
+        const;
     int getNumLists(WordVariationType variation);
 
     private:
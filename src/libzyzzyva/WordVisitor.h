@@ -0,0 +1,44 @@
+//---------------------------------------------------------------------------
+// WordVisitor.h
+//
+// An interface for receiving words one at a time as they are found.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_WORD_VISITOR_H
+#define ZYZZYVA_WORD_VISITOR_H
+
+#include <QString>
+
+class WordVisitor
+{
+    public:
+    WordVisitor() { }
+    virtual ~WordVisitor() { }
+
+    // Called once for each word found.  Return false to stop the search.
+    virtual bool visitWord(const QString& word) = 0;
+
+    // Called now and then during long searches, even when no words are
+    // found.  Return true to stop the search.
+    virtual bool isCancelled() const { return false; }
+};
+
+#endif // ZYZZYVA_WORD_VISITOR_H
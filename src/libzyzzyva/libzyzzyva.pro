@@ -43,48 +43,71 @@ win32 {
 SOURCES = \
     AboutDialog.cpp \
     AnalyzeQuizDialog.cpp \
+    AnswerTracker.cpp \
     Auxil.cpp \
+    BatchJudge.cpp \
     CardboxAddDialog.cpp \
     CardboxForm.cpp \
     CardboxRemoveDialog.cpp \
     CardboxRescheduleDaysSpinBox.cpp \
     CardboxRescheduleDialog.cpp \
+    CardboxScheduler.cpp \
+    CompactWord.cpp \
     CreateDatabaseThread.cpp \
+    DatabaseIndexSet.cpp \
     DatabaseRebuildDialog.cpp \
+    DatabaseRebuildProgressDialog.cpp \
+    DawgBuilder.cpp \
     DefineForm.cpp \
     DefinitionBox.cpp \
     DefinitionDialog.cpp \
     IntroForm.cpp \
     IscConnectionThread.cpp \
     IscConverter.cpp \
+    JobScheduler.cpp \
     JudgeDialog.cpp \
     JudgeSelectDialog.cpp \
+    LatencyStats.cpp \
     LetterBag.cpp \
+    LetterSignature.cpp \
+    LexiconChecksumThread.cpp \
     LexiconSelectDialog.cpp \
     LexiconSelectWidget.cpp \
+    LexiconSnapshot.cpp \
     LexiconStyleDialog.cpp \
     LexiconStyleWidget.cpp \
     MainSettings.cpp \
     MainWindow.cpp \
     NewQuizDialog.cpp \
+    PlayabilityTable.cpp \
     QuizCanvas.cpp \
     QuizEngine.cpp \
+    QuizExporter.cpp \
     QuizForm.cpp \
     QuizProgress.cpp \
     QuizQuestion.cpp \
     QuizSpec.cpp \
     QuizStatsDatabase.cpp \
     QuizTimerSpec.cpp \
+    RackSampler.cpp \
     Rand.cpp \
     SearchForm.cpp \
     SearchCondition.cpp \
     SearchConditionForm.cpp \
     SearchSpec.cpp \
     SearchSpecForm.cpp \
+    SearchStats.cpp \
+    SearchThread.cpp \
     SettingsDialog.cpp \
+    Shuffle.cpp \
+    SuccinctDawg.cpp \
+    Trace.cpp \
     WordEngine.cpp \
     WordEntryDialog.cpp \
+    WordFeatures.cpp \
     WordGraph.cpp \
+    WordIdList.cpp \
+    WordLineEdit.cpp \
     WordListDialog.cpp \
     WordListSaveDialog.cpp \
     WordTableModel.cpp \
@@ -106,6 +129,7 @@ HEADERS = \
     CardboxRescheduleDialog.h \
     CreateDatabaseThread.h \
     DatabaseRebuildDialog.h \
+    DatabaseRebuildProgressDialog.h \
     DefineForm.h \
     DefinitionBox.h \
     DefinitionDialog.h \
@@ -115,6 +139,7 @@ HEADERS = \
     IscConnectionThread.h \
     JudgeDialog.h \
     JudgeSelectDialog.h \
+    LexiconChecksumThread.h \
     LexiconSelectDialog.h \
     LexiconSelectWidget.h \
     LexiconStyleDialog.h \
@@ -129,6 +154,7 @@ HEADERS = \
     SearchForm.h \
     SearchConditionForm.h \
     SearchSpecForm.h \
+    SearchThread.h \
     SettingsDialog.h \
     WordEngine.h \
     WordEntryDialog.h \
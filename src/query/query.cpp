@@ -0,0 +1,539 @@
+//---------------------------------------------------------------------------
+// query.cpp
+//
+// A headless program for running searches against a lexicon.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "BatchJudge.h"
+#include "QuizExporter.h"
+#include "WordEngine.h"
+#include "SearchSpec.h"
+#include "WordListFormat.h"
+#include "MainSettings.h"
+#include "Auxil.h"
+#include <QApplication>
+#include <QDomDocument>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QPair>
+#include <QTextStream>
+
+const QString SETTINGS_ORGANIZATION_NAME = "Piet Depsi";
+const QString SETTINGS_DOMAIN_NAME = "pietdepsi.com";
+const QString SETTINGS_APPLICATION_NAME = "Zyzzyva";
+
+const QString LEXICON_ARG = "--lexicon=";
+const QString FORMAT_ARG = "--format=";
+const QString SPEC_ARG = "--spec=";
+const QString BATCH_ARG = "--batch=";
+const QString JUDGE_ARG = "--judge=";
+const QString WORD_LIST_ARG = "--word-list=";
+const QString EXPORT_QUIZ_ARG = "--export-quiz=";
+const QString NO_DATABASE_ARG = "--no-database";
+const QString HELP_ARG = "--help";
+
+const QString SEARCH_FILE_EXTENSION = ".zzs";
+const int TWO_COLUMN_ANAGRAM_PADDING = 3;
+
+typedef QPair<QString, SearchSpec> NamedSpec;
+
+//---------------------------------------------------------------------------
+//  printUsage
+//
+//! Print a summary of the command-line arguments.
+//
+//! @param stream the stream to print to
+//---------------------------------------------------------------------------
+static void
+printUsage(QTextStream& stream)
+{
+    stream << "Usage: zyzzyva-query [options] [search-file ...]\n"
+        "       zyzzyva-query [options] --judge=FILE\n"
+        "\n"
+        "Run searches against a lexicon and write the words found to "
+        "standard output,\n"
+        "or judge the words in a file.\n"
+        "\n"
+        "Options:\n"
+        "  --lexicon=NAME    Search the lexicon NAME instead of the "
+        "default lexicon\n"
+        "  --format=FORMAT   Write words in FORMAT: words, question-answer,\n"
+        "                    two-column or alphagrams (default words)\n"
+        "  --spec=XML        Run the search described by XML\n"
+        "  --batch=FILE      Run every search file named in FILE, one per "
+        "line,\n"
+        "                    or in standard input if FILE is -\n"
+        "  --word-list=FILE  Search for the words in FILE, one per line\n"
+        "  --export-quiz=FILE\n"
+        "                    Write an anagram quiz of the words found to "
+        "FILE for\n"
+        "                    the mobile quiz app, instead of writing the "
+        "words\n"
+        "  --judge=FILE      Judge the words in FILE, or in standard input "
+        "if FILE\n"
+        "                    is -, writing each word, VALID or INVALID, and "
+        "its\n"
+        "                    lexicon symbols\n"
+        "  --no-database     Do not connect to the lexicon database\n"
+        "  --help            Print this summary\n"
+        "\n"
+        "Search files not found as given are looked for among the "
+        "predefined\n"
+        "searches, so \"JQXZ/J 4s\" runs a predefined search.\n";
+}
+
+//---------------------------------------------------------------------------
+//  stringToFormat
+//
+//! Convert a format given on the command line to a word list format.  The
+//! names shown by the Save Word List dialog are also accepted.
+//
+//! @param str the format
+//! @return the word list format, or WordListInvalid if not recognized
+//---------------------------------------------------------------------------
+static WordListFormat
+stringToFormat(const QString& str)
+{
+    QString lower = str.toLower();
+    if (lower == "words")
+        return WordListOnePerLine;
+    else if (lower == "question-answer")
+        return WordListAnagramQuestionAnswer;
+    else if (lower == "two-column")
+        return WordListAnagramTwoColumn;
+    else if (lower == "alphagrams")
+        return WordListDistinctAlphagrams;
+    return Auxil::stringToWordListFormat(str);
+}
+
+//---------------------------------------------------------------------------
+//  parseSearchSpec
+//
+//! Read a search spec from its XML representation.
+//
+//! @param xml the XML representation
+//! @param spec returns the search spec
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+static bool
+parseSearchSpec(const QString& xml, SearchSpec* spec, QString* errString)
+{
+    QString errorMsg;
+    int errorLine = 0;
+    int errorColumn = 0;
+    QDomDocument document;
+    if (!document.setContent(xml, false, &errorMsg, &errorLine,
+                             &errorColumn))
+    {
+        *errString = "line " + QString::number(errorLine) + ", column " +
+            QString::number(errorColumn) + ": " + errorMsg;
+        return false;
+    }
+
+    if (!spec->fromDomElement(document.documentElement())) {
+        *errString = "not a valid search";
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  readSearchFile
+//
+//! Read a search spec from a search file.  If the file does not exist, it
+//! is looked for among the predefined searches, with or without its
+//! extension.
+//
+//! @param filename the name of the search file
+//! @param spec returns the search spec
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+static bool
+readSearchFile(const QString& filename, SearchSpec* spec, QString*
+               errString)
+{
+    QString path = filename;
+    if (!QFileInfo(path).exists()) {
+        QString predefined = Auxil::getSearchDir() + "/predefined/" +
+            filename;
+        if (QFileInfo(predefined).exists())
+            path = predefined;
+        else if (QFileInfo(predefined + SEARCH_FILE_EXTENSION).exists())
+            path = predefined + SEARCH_FILE_EXTENSION;
+    }
+
+    QFile file (path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *errString = file.errorString();
+        return false;
+    }
+
+    return parseSearchSpec(QString::fromUtf8(file.readAll()), spec,
+                           errString);
+}
+
+//---------------------------------------------------------------------------
+//  readBatchFile
+//
+//! Read the names of search files from a batch file, one per line.  Blank
+//! lines and lines starting with # are skipped.
+//
+//! @param filename the name of the batch file, or - for standard input
+//! @param filenames returns the names of the search files
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+static bool
+readBatchFile(const QString& filename, QStringList* filenames, QString*
+              errString)
+{
+    QFile file;
+    bool ok = false;
+    if (filename == "-") {
+        ok = file.open(stdin, QIODevice::ReadOnly | QIODevice::Text);
+    }
+    else {
+        file.setFileName(filename);
+        ok = file.open(QIODevice::ReadOnly | QIODevice::Text);
+    }
+
+    if (!ok) {
+        *errString = file.errorString();
+        return false;
+    }
+
+    QTextStream stream (&file);
+    while (!stream.atEnd()) {
+        QString line = stream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith("#"))
+            continue;
+        filenames->append(line);
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  writeWords
+//
+//! Write a list of words in a word list format.  Words are written in
+//! alphabetical order, or grouped by alphagram in alphabetical order of
+//! alphagram, as in word lists saved from a word table.
+//
+//! @param stream the stream to write to
+//! @param words the words
+//! @param format the word list format
+//---------------------------------------------------------------------------
+static void
+writeWords(QTextStream& stream, const QStringList& words, WordListFormat
+           format)
+{
+    if (format == WordListOnePerLine) {
+        QStringList sortedWords = words;
+        sortedWords.sort();
+        foreach (const QString& word, sortedWords)
+            stream << word << "\n";
+        return;
+    }
+
+    QMap<QString, QStringList> alphagramWords;
+    int alphagramWidth = 0;
+    foreach (const QString& word, words) {
+        QString alphagram = Auxil::getAlphagram(word);
+        alphagramWords[alphagram].append(word);
+        alphagramWidth = qMax(alphagramWidth, alphagram.length());
+    }
+    alphagramWidth += TWO_COLUMN_ANAGRAM_PADDING;
+    QString alphagramPadding (alphagramWidth, ' ');
+
+    QMapIterator<QString, QStringList> it (alphagramWords);
+    while (it.hasNext()) {
+        it.next();
+        if (format == WordListDistinctAlphagrams) {
+            stream << it.key() << "\n";
+            continue;
+        }
+
+        QStringList anagrams = it.value();
+        anagrams.sort();
+        if (format == WordListAnagramTwoColumn) {
+            stream << it.key().leftJustified(alphagramWidth, ' ');
+            for (int i = 0; i < anagrams.size(); ++i) {
+                if (i > 0)
+                    stream << alphagramPadding;
+                stream << anagrams[i] << "\n";
+            }
+        }
+        else {
+            stream << "Q: " << it.key() << "\n";
+            foreach (const QString& anagram, anagrams)
+                stream << "A: " << anagram << "\n";
+            stream << "\n";
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+//  judgeFile
+//
+//! Judge the words of a file against a lexicon, writing the verdicts to
+//! standard output.  The word counts and judging rate are reported to
+//! standard error.  The lexicons compared by the lexicon styles of the
+//! lexicon are loaded too, so the symbols of the styles can be given.
+//
+//! @param engine the word engine, with the lexicon loaded
+//! @param lexicon the name of the lexicon
+//! @param filename the name of the file, or - for standard input
+//! @param err the stream to report errors to
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+static bool
+judgeFile(WordEngine* engine, const QString& lexicon, const QString&
+          filename, QTextStream& err)
+{
+    QList<LexiconStyle> styles = MainSettings::getWordListLexiconStyles();
+    foreach (const LexiconStyle& style, styles) {
+        if ((style.lexicon == lexicon) &&
+            !engine->lexiconIsLoaded(style.compareLexicon))
+        {
+            engine->loadLexicon(style.compareLexicon, false);
+        }
+    }
+
+    QFile in;
+    bool ok = false;
+    if (filename == "-") {
+        ok = in.open(stdin, QIODevice::ReadOnly);
+    }
+    else {
+        in.setFileName(filename);
+        ok = in.open(QIODevice::ReadOnly);
+    }
+
+    if (!ok) {
+        err << "zyzzyva-query: " << filename << ": " << in.errorString()
+            << "\n";
+        return false;
+    }
+
+    QFile out;
+    out.open(stdout, QIODevice::WriteOnly);
+
+    QElapsedTimer timer;
+    timer.start();
+    BatchJudge judge (engine, lexicon, styles);
+    QString errString;
+    if (!judge.judgeStream(&in, &out, &errString)) {
+        err << "zyzzyva-query: cannot write verdicts: " << errString << "\n";
+        return false;
+    }
+    out.flush();
+
+    qint64 msecs = qMax(qint64(1), timer.elapsed());
+    err << "zyzzyva-query: " << judge.getNumWords() << " words, "
+        << judge.getNumAcceptable() << " valid, "
+        << qint64(judge.getNumWords() * 1000 / msecs) << " words/sec\n";
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  main
+//
+//! Run the searches given on the command line.  All searches are run in
+//! one batch against a lexicon loaded once, and the words found by each are
+//! written in turn, preceded by the name of the search if there is more
+//! than one, or exported together as one quiz.
+//
+//! @return zero if every search ran, or nonzero otherwise
+//---------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    // No window is shown, so queries can run headless
+    QApplication app (argc, argv, false);
+    QCoreApplication::setOrganizationName(SETTINGS_ORGANIZATION_NAME);
+    QCoreApplication::setOrganizationDomain(SETTINGS_DOMAIN_NAME);
+    QCoreApplication::setApplicationName(SETTINGS_APPLICATION_NAME);
+    MainSettings::readSettings();
+
+    QTextStream out (stdout);
+    QTextStream err (stderr);
+
+    QString lexicon = MainSettings::getDefaultLexicon();
+    WordListFormat format = WordListOnePerLine;
+    bool useDatabase = true;
+    bool ok = true;
+    QList<NamedSpec> specs;
+    QStringList filenames;
+    QString judgeFilename;
+    QString exportFilename;
+
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        const QString& arg = args[i];
+        QString errString;
+        if (arg == HELP_ARG) {
+            printUsage(out);
+            return 0;
+        }
+        else if (arg.startsWith(LEXICON_ARG)) {
+            lexicon = arg.mid(LEXICON_ARG.length());
+        }
+        else if (arg.startsWith(FORMAT_ARG)) {
+            format = stringToFormat(arg.mid(FORMAT_ARG.length()));
+            if (format == WordListInvalid) {
+                err << "zyzzyva-query: unknown format '"
+                    << arg.mid(FORMAT_ARG.length()) << "'\n";
+                return 1;
+            }
+        }
+        else if (arg.startsWith(SPEC_ARG)) {
+            SearchSpec spec;
+            if (parseSearchSpec(arg.mid(SPEC_ARG.length()), &spec,
+                                &errString))
+            {
+                specs.append(NamedSpec(spec.asString(), spec));
+            }
+            else {
+                err << "zyzzyva-query: invalid search: " << errString
+                    << "\n";
+                ok = false;
+            }
+        }
+        else if (arg.startsWith(BATCH_ARG)) {
+            QString batchFilename = arg.mid(BATCH_ARG.length());
+            if (!readBatchFile(batchFilename, &filenames, &errString)) {
+                err << "zyzzyva-query: " << batchFilename << ": "
+                    << errString << "\n";
+                return 1;
+            }
+        }
+        else if (arg.startsWith(WORD_LIST_ARG)) {
+            QString wordListFilename = arg.mid(WORD_LIST_ARG.length());
+            SearchCondition condition;
+            condition.setWordListFile(wordListFilename);
+            SearchSpec spec;
+            spec.conditions.append(condition);
+            specs.append(NamedSpec(wordListFilename, spec));
+        }
+        else if (arg.startsWith(EXPORT_QUIZ_ARG)) {
+            exportFilename = arg.mid(EXPORT_QUIZ_ARG.length());
+        }
+        else if (arg.startsWith(JUDGE_ARG)) {
+            judgeFilename = arg.mid(JUDGE_ARG.length());
+        }
+        else if (arg == NO_DATABASE_ARG) {
+            useDatabase = false;
+        }
+        else if (arg.startsWith("--")) {
+            err << "zyzzyva-query: unknown option '" << arg << "'\n";
+            printUsage(err);
+            return 1;
+        }
+        else {
+            filenames.append(arg);
+        }
+    }
+
+    foreach (const QString& filename, filenames) {
+        SearchSpec spec;
+        QString errString;
+        if (readSearchFile(filename, &spec, &errString)) {
+            specs.append(NamedSpec(filename, spec));
+        }
+        else {
+            err << "zyzzyva-query: " << filename << ": " << errString
+                << "\n";
+            ok = false;
+        }
+    }
+
+    bool judging = !judgeFilename.isEmpty();
+    if (judging && (!specs.isEmpty() || !ok)) {
+        err << "zyzzyva-query: cannot judge words and search at once\n";
+        return 1;
+    }
+    else if (!judging && specs.isEmpty()) {
+        if (ok)
+            printUsage(err);
+        return 1;
+    }
+
+    // Judging only needs the word graph, not the database
+    WordEngine engine;
+    QString errString;
+    if (!engine.loadLexicon(lexicon, useDatabase && !judging, &errString)) {
+        err << "zyzzyva-query: cannot load lexicon '" << lexicon << "'";
+        if (!errString.isEmpty())
+            err << ": " << errString;
+        err << "\n";
+        return 1;
+    }
+
+    if (judging)
+        return judgeFile(&engine, lexicon, judgeFilename, err) ? 0 : 1;
+
+    QList<SearchSpec> searchSpecs;
+    foreach (const NamedSpec& spec, specs)
+        searchSpecs.append(spec.second);
+    QList<QStringList> results = engine.searchMany(lexicon, searchSpecs,
+                                                   true);
+
+    if (!exportFilename.isEmpty()) {
+        QStringList words;
+        foreach (const QStringList& result, results)
+            words += result;
+
+        QElapsedTimer timer;
+        timer.start();
+        QuizExporter exporter (&engine, lexicon);
+        if (!exporter.exportQuiz(words, exportFilename, &errString)) {
+            err << "zyzzyva-query: cannot export quiz to " << exportFilename
+                << ": " << errString << "\n";
+            ok = false;
+        }
+        else {
+            err << "zyzzyva-query: " << exporter.getNumQuestions()
+                << " questions, " << exporter.getNumWords() << " words, "
+                << timer.elapsed() << " ms\n";
+        }
+        engine.disconnectFromDatabase(lexicon);
+        return ok ? 0 : 1;
+    }
+
+    for (int i = 0; i < specs.size(); ++i) {
+        if (specs.size() > 1) {
+            if (i > 0)
+                out << "\n";
+            out << "# " << specs[i].first << "\n";
+        }
+        writeWords(out, results.value(i), format);
+    }
+    out.flush();
+
+    // Wait for any background work on the database before exiting
+    engine.disconnectFromDatabase(lexicon);
+    return ok ? 0 : 1;
+}
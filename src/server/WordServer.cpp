@@ -0,0 +1,351 @@
+//---------------------------------------------------------------------------
+// WordServer.cpp
+//
+// A server answering word lookup requests from local clients.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "WordServer.h"
+#include "WordEngine.h"
+#include "SearchSpec.h"
+#include "SearchCondition.h"
+#include <QBitArray>
+#include <QDomDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QThread>
+
+// Largest number of requests of one client queued or being answered at
+// once.  More requests are left unread until some have been answered.
+const int MAX_PENDING_REQUESTS = 256;
+
+// Longest request line accepted, in bytes
+const qint64 MAX_REQUEST_LENGTH = 1024 * 1024;
+
+//---------------------------------------------------------------------------
+//  WorkerThread
+//
+//! Thread answering queued requests until the server stops.
+//---------------------------------------------------------------------------
+class WordServer::WorkerThread : public QThread
+{
+    public:
+    WorkerThread(WordServer* s) : server(s) { }
+
+    protected:
+    void run() {
+        Request request;
+        while (server->takeRequest(&request)) {
+            QString response = server->processRequest(request.line);
+            QMetaObject::invokeMethod(server, "sendResponse",
+                                      Qt::QueuedConnection,
+                                      Q_ARG(int, request.clientId),
+                                      Q_ARG(QString, response));
+        }
+    }
+
+    private:
+    WordServer* server;
+};
+
+//---------------------------------------------------------------------------
+//  WordServer
+//
+//! Constructor.  Start the worker threads.
+//
+//! @param e the word engine, with the lexicons loaded
+//! @param lex the lexicons that can be used by requests
+//! @param numThreads the number of worker threads, or 0 for one per
+//! processor
+//! @param parent the parent object
+//---------------------------------------------------------------------------
+WordServer::WordServer(WordEngine* e, const QStringList& lex, int
+                       numThreads, QObject* parent)
+    : QObject(parent), engine(e), lexicons(lex),
+      server(new QLocalServer(this)), nextClientId(1), stopping(false)
+{
+    connect(server, SIGNAL(newConnection()), SLOT(newConnection()));
+
+    if (numThreads <= 0)
+        numThreads = qMax(1, QThread::idealThreadCount());
+    for (int i = 0; i < numThreads; ++i) {
+        WorkerThread* worker = new WorkerThread(this);
+        workers.append(worker);
+        worker->start();
+    }
+}
+
+//---------------------------------------------------------------------------
+//  ~WordServer
+//
+//! Destructor.  Stop the worker threads, dropping any queued requests.
+//---------------------------------------------------------------------------
+WordServer::~WordServer()
+{
+    queueMutex.lock();
+    stopping = true;
+    queue.clear();
+    queueCondition.wakeAll();
+    queueMutex.unlock();
+
+    foreach (WorkerThread* worker, workers) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+//---------------------------------------------------------------------------
+//  listen
+//
+//! Listen for clients on a local socket.  A socket left behind by a server
+//! that did not exit cleanly is removed first.
+//
+//! @param name the name of the socket
+//! @param errString returns the error string in case of error
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordServer::listen(const QString& name, QString* errString)
+{
+    QLocalServer::removeServer(name);
+    if (!server->listen(name)) {
+        if (errString)
+            *errString = server->errorString();
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+//  processRequest
+//
+//! Answer a request.  Can be called from any thread.  The commands are:
+//!   LEXICONS - list the lexicons that can be used
+//!   CHECK lexicon word... - 1 or 0 for whether each word is acceptable
+//!   DEFINE lexicon word - the definition of a word
+//!   HOOKS lexicon word - the front and back hooks of a word, or - if none
+//!   ANAGRAM lexicon letters - the anagrams of letters, with ? for blanks
+//!   SEARCH lexicon xml - the words matching a search spec
+//
+//! @param line the request line
+//! @return the response line, without a newline
+//---------------------------------------------------------------------------
+QString
+WordServer::processRequest(const QString& line) const
+{
+    QString id = line.section(' ', 0, 0, QString::SectionSkipEmpty);
+    QString command = line.section(' ', 1, 1,
+                                   QString::SectionSkipEmpty).toUpper();
+    if (id.isEmpty() || command.isEmpty())
+        return id + " ERR missing command";
+
+    if (command == "LEXICONS")
+        return id + " OK " + lexicons.join(" ");
+
+    QString lexicon = line.section(' ', 2, 2, QString::SectionSkipEmpty);
+    QString args = line.section(' ', 3, -1, QString::SectionSkipEmpty);
+    if (!lexicons.contains(lexicon))
+        return id + " ERR unknown lexicon '" + lexicon + "'";
+
+    if (command == "CHECK") {
+        QStringList words = args.toUpper().split(' ',
+                                                 QString::SkipEmptyParts);
+        QBitArray acceptable = engine->areAcceptable(lexicon, words);
+        QStringList verdicts;
+        for (int i = 0; i < words.size(); ++i)
+            verdicts.append(acceptable.testBit(i) ? "1" : "0");
+        return id + " OK " + verdicts.join(" ");
+    }
+
+    QString word = args.trimmed().toUpper();
+
+    if (command == "DEFINE") {
+        QString definition = engine->getDefinition(lexicon, word);
+        definition.replace('\n', WordEngine::DEF_DISPLAY_SEP);
+        return id + " OK " + definition;
+    }
+
+    else if (command == "HOOKS") {
+        if (!engine->isAcceptable(lexicon, word))
+            return id + " ERR unacceptable word '" + word + "'";
+        QString front = engine->getFrontHookLetters(lexicon, word).toUpper();
+        QString back = engine->getBackHookLetters(lexicon, word).toUpper();
+        return id + " OK " + (front.isEmpty() ? QString("-") : front) + " " +
+            (back.isEmpty() ? QString("-") : back);
+    }
+
+    else if (command == "ANAGRAM") {
+        SearchCondition condition;
+        condition.type = SearchCondition::AnagramMatch;
+        condition.stringValue = word;
+        SearchSpec spec;
+        spec.conditions.append(condition);
+        QStringList words = engine->search(lexicon, spec, true);
+        words.sort();
+        return id + " OK " + words.join(" ");
+    }
+
+    else if (command == "SEARCH") {
+        QDomDocument document;
+        SearchSpec spec;
+        if (!document.setContent(args) ||
+            !spec.fromDomElement(document.documentElement()))
+        {
+            return id + " ERR invalid search";
+        }
+        QStringList words = engine->search(lexicon, spec, true);
+        words.sort();
+        return id + " OK " + words.join(" ");
+    }
+
+    return id + " ERR unknown command '" + command + "'";
+}
+
+//---------------------------------------------------------------------------
+//  sendResponse
+//
+//! Send a response to a client, and read more of its requests if it was
+//! waiting for responses.  Responses for clients that have disconnected are
+//! dropped.
+//
+//! @param clientId the id of the client
+//! @param response the response line
+//---------------------------------------------------------------------------
+void
+WordServer::sendResponse(int clientId, const QString& response)
+{
+    if (!clients.contains(clientId))
+        return;
+
+    Client& client = clients[clientId];
+    client.socket->write(response.toUtf8() + "\n");
+    --client.numPending;
+    readRequests(clientId);
+}
+
+//---------------------------------------------------------------------------
+//  newConnection
+//
+//! Accept new clients.
+//---------------------------------------------------------------------------
+void
+WordServer::newConnection()
+{
+    while (server->hasPendingConnections()) {
+        QLocalSocket* socket = server->nextPendingConnection();
+        int clientId = nextClientId++;
+        clients.insert(clientId, Client(socket));
+        socketClients.insert(socket, clientId);
+        connect(socket, SIGNAL(readyRead()), SLOT(readyRead()));
+        connect(socket, SIGNAL(disconnected()), SLOT(clientDisconnected()));
+        readRequests(clientId);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  readyRead
+//
+//! Read the requests sent by a client.
+//---------------------------------------------------------------------------
+void
+WordServer::readyRead()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket && socketClients.contains(socket))
+        readRequests(socketClients.value(socket));
+}
+
+//---------------------------------------------------------------------------
+//  clientDisconnected
+//
+//! Forget a client that has disconnected.  Its requests that are still
+//! queued are answered, but the responses are dropped.
+//---------------------------------------------------------------------------
+void
+WordServer::clientDisconnected()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (!socket || !socketClients.contains(socket))
+        return;
+
+    clients.remove(socketClients.take(socket));
+    socket->deleteLater();
+}
+
+//---------------------------------------------------------------------------
+//  readRequests
+//
+//! Queue the complete request lines sent by a client, until it has as many
+//! requests pending as allowed.  A client sending a line longer than
+//! allowed is disconnected.
+//
+//! @param clientId the id of the client
+//---------------------------------------------------------------------------
+void
+WordServer::readRequests(int clientId)
+{
+    Client& client = clients[clientId];
+    QLocalSocket* socket = client.socket;
+    QList<Request> requests;
+    while ((client.numPending < MAX_PENDING_REQUESTS) &&
+           socket->canReadLine())
+    {
+        QString line = QString::fromUtf8(socket->readLine()).trimmed();
+        if (line.isEmpty())
+            continue;
+        requests.append(Request(clientId, line));
+        ++client.numPending;
+    }
+
+    if (!requests.isEmpty()) {
+        QMutexLocker locker (&queueMutex);
+        queue.append(requests);
+        queueCondition.wakeAll();
+    }
+
+    if ((socket->bytesAvailable() > MAX_REQUEST_LENGTH) &&
+        !socket->canReadLine())
+    {
+        socket->write("0 ERR request too long\n");
+        socket->disconnectFromServer();
+    }
+}
+
+//---------------------------------------------------------------------------
+//  takeRequest
+//
+//! Take the next request from the queue, waiting for one if the queue is
+//! empty.  Called by the worker threads.
+//
+//! @param request returns the request
+//! @return true if a request was taken, false if the server is stopping
+//---------------------------------------------------------------------------
+bool
+WordServer::takeRequest(Request* request)
+{
+    QMutexLocker locker (&queueMutex);
+    while (queue.isEmpty() && !stopping)
+        queueCondition.wait(&queueMutex);
+    if (stopping)
+        return false;
+
+    *request = queue.dequeue();
+    return true;
+}
@@ -0,0 +1,110 @@
+//---------------------------------------------------------------------------
+// WordServer.h
+//
+// A server answering word lookup requests from local clients.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#ifndef ZYZZYVA_WORD_SERVER_H
+#define ZYZZYVA_WORD_SERVER_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QStringList>
+#include <QWaitCondition>
+
+class QLocalServer;
+class QLocalSocket;
+class WordEngine;
+
+// Server answering requests from clients connected to a local socket.  Each
+// request is one line, beginning with an id chosen by the client, and is
+// answered by one line beginning with the same id.  Clients can send many
+// requests without waiting for the responses, which are answered by a pool
+// of worker threads sharing one word engine, and can come back in any
+// order.
+class WordServer : public QObject
+{
+    Q_OBJECT
+    public:
+    WordServer(WordEngine* e, const QStringList& lex, int numThreads = 0,
+               QObject* parent = 0);
+    ~WordServer();
+
+    bool listen(const QString& name, QString* errString = 0);
+    QString processRequest(const QString& line) const;
+
+    public slots:
+    void sendResponse(int clientId, const QString& response);
+
+    private slots:
+    void newConnection();
+    void readyRead();
+    void clientDisconnected();
+
+    private:
+    // Thread answering requests from the request queue
+    class WorkerThread;
+
+    class Request {
+        public:
+        Request(int c = 0, const QString& l = QString())
+            : clientId(c), line(l) { }
+
+        int clientId;
+        QString line;
+    };
+
+    class Client {
+        public:
+        Client(QLocalSocket* s = 0) : socket(s), numPending(0) { }
+
+        QLocalSocket* socket;
+        int numPending;
+    };
+
+    private:
+    void readRequests(int clientId);
+    bool takeRequest(Request* request);
+
+    private:
+    WordEngine* engine;
+    QStringList lexicons;
+    QLocalServer* server;
+    QList<WorkerThread*> workers;
+
+    // Connected clients, by id and by socket.  Clients are only used by the
+    // thread the server was created in.
+    QHash<int, Client> clients;
+    QHash<QLocalSocket*, int> socketClients;
+    int nextClientId;
+
+    // Requests waiting for a worker, guarded by the mutex
+    QMutex queueMutex;
+    QWaitCondition queueCondition;
+    QQueue<Request> queue;
+    bool stopping;
+};
+
+#endif // ZYZZYVA_WORD_SERVER_H
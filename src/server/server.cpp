@@ -0,0 +1,163 @@
+//---------------------------------------------------------------------------
+// server.cpp
+//
+// The Zyzzyva word server program.
+//
+// Copyright 2012 Boshvark Software, LLC.
+//
+// This file is part of Zyzzyva.
+//
+// Zyzzyva is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Zyzzyva is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//---------------------------------------------------------------------------
+
+#include "WordServer.h"
+#include "WordEngine.h"
+#include "MainSettings.h"
+#include <QApplication>
+#include <QTextStream>
+
+const QString SETTINGS_ORGANIZATION_NAME = "Piet Depsi";
+const QString SETTINGS_DOMAIN_NAME = "pietdepsi.com";
+const QString SETTINGS_APPLICATION_NAME = "Zyzzyva";
+
+const QString NAME_ARG = "--name=";
+const QString THREADS_ARG = "--threads=";
+const QString NO_DATABASE_ARG = "--no-database";
+const QString HELP_ARG = "--help";
+
+const QString DEFAULT_SERVER_NAME = "zyzzyva";
+
+//---------------------------------------------------------------------------
+//  printUsage
+//
+//! Print a summary of the command-line arguments.
+//
+//! @param stream the stream to print to
+//---------------------------------------------------------------------------
+static void
+printUsage(QTextStream& stream)
+{
+    stream << "Usage: zyzzyva-server [options] [lexicon ...]\n"
+        "\n"
+        "Load lexicons once and answer word lookup requests from local "
+        "clients.\n"
+        "The default lexicon is loaded if no lexicon is named.\n"
+        "\n"
+        "Options:\n"
+        "  --name=NAME       Listen on the local socket NAME (default "
+        "zyzzyva)\n"
+        "  --threads=N       Answer requests with N worker threads "
+        "(default one\n"
+        "                    per processor)\n"
+        "  --no-database     Do not connect to the lexicon databases\n"
+        "  --help            Print this summary\n"
+        "\n"
+        "Each request is one line: an id, a command and its arguments.  "
+        "Each\n"
+        "response is one line: the id, OK or ERR, and the result.\n"
+        "\n"
+        "Commands:\n"
+        "  LEXICONS                  List the lexicons loaded\n"
+        "  CHECK lexicon word...     1 or 0 for each word if it is "
+        "acceptable\n"
+        "  DEFINE lexicon word       The definition of a word\n"
+        "  HOOKS lexicon word        Front and back hooks of a word\n"
+        "  ANAGRAM lexicon letters   Anagrams of letters, with ? for "
+        "blanks\n"
+        "  SEARCH lexicon xml        Words matching a search on one line\n";
+}
+
+//---------------------------------------------------------------------------
+//  main
+//
+//! Load the lexicons named on the command line, and answer requests until
+//! the server is killed.
+//
+//! @return nonzero if the server could not start
+//---------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    // No window is shown, so the server can run headless
+    QApplication app (argc, argv, false);
+    QCoreApplication::setOrganizationName(SETTINGS_ORGANIZATION_NAME);
+    QCoreApplication::setOrganizationDomain(SETTINGS_DOMAIN_NAME);
+    QCoreApplication::setApplicationName(SETTINGS_APPLICATION_NAME);
+    MainSettings::readSettings();
+
+    QTextStream out (stdout);
+    QTextStream err (stderr);
+
+    QString name = DEFAULT_SERVER_NAME;
+    int numThreads = 0;
+    bool useDatabase = true;
+    QStringList lexicons;
+
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        const QString& arg = args[i];
+        if (arg == HELP_ARG) {
+            printUsage(out);
+            return 0;
+        }
+        else if (arg.startsWith(NAME_ARG)) {
+            name = arg.mid(NAME_ARG.length());
+        }
+        else if (arg.startsWith(THREADS_ARG)) {
+            numThreads = arg.mid(THREADS_ARG.length()).toInt();
+        }
+        else if (arg == NO_DATABASE_ARG) {
+            useDatabase = false;
+        }
+        else if (arg.startsWith("--")) {
+            err << "zyzzyva-server: unknown option '" << arg << "'\n";
+            printUsage(err);
+            return 1;
+        }
+        else if (!lexicons.contains(arg)) {
+            lexicons.append(arg);
+        }
+    }
+
+    if (lexicons.isEmpty())
+        lexicons.append(MainSettings::getDefaultLexicon());
+
+    // Each lexicon is loaded once, and its memory-mapped word graph is
+    // shared by every worker thread
+    WordEngine engine;
+    foreach (const QString& lexicon, lexicons) {
+        QString errString;
+        if (!engine.loadLexicon(lexicon, useDatabase, &errString)) {
+            err << "zyzzyva-server: cannot load lexicon '" << lexicon << "'";
+            if (!errString.isEmpty())
+                err << ": " << errString;
+            err << "\n";
+            return 1;
+        }
+    }
+
+    WordServer server (&engine, lexicons, numThreads);
+    QString errString;
+    if (!server.listen(name, &errString)) {
+        err << "zyzzyva-server: cannot listen on '" << name << "': "
+            << errString << "\n";
+        return 1;
+    }
+
+    out << "zyzzyva-server: listening on '" << name << "' with "
+        << lexicons.join(", ") << "\n";
+    out.flush();
+
+    return app.exec();
+}
@@ -23,4 +23,4 @@
 #---------------------------------------------------------------------------
 
 TEMPLATE = subdirs
-SUBDIRS = libzyzzyva zyzzyva tests
+SUBDIRS = libzyzzyva zyzzyva query server tests bench
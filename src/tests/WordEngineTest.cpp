@@ -24,6 +24,7 @@
 
 #include <QtTest/QtTest>
 
+#include "BatchJudge.h"
 #include "WordEngine.h"
 #include "MainSettings.h"
 #include "Auxil.h"
@@ -38,18 +39,41 @@ class WordEngineTest : public QObject
     private slots:
     void testSearch_data();
     void testSearch();
+    void testJudgeStream();
+    void testSampleSearch();
+    void testLetterConstraintSearch();
+    void benchSearch_data();
+    void benchSearch();
+    void cleanupTestCase();
 
     private:
     void tryImport();
+    bool readSearchSpec(const QString& testName, SearchSpec* spec);
+    void readBaseline();
+    void writeBaseline() const;
 
     private:
     WordEngine engine;
     bool prepared;
 
+    // Microseconds per search of each benchmark, from the baseline file,
+    // and as measured
+    QMap<QString, double> baselineUsecs;
+    QMap<QString, double> measuredUsecs;
 };
 
 QString TEST_LEXICON = Defs::LEXICON_OWL2;
 
+// The benchmark baseline file, holding the microseconds per search of each
+// benchmark, one benchmark per line
+const QString BENCH_BASELINE_FILENAME = "search-baseline.txt";
+
+// Environment variables: the percentage by which a benchmark can be slower
+// than its baseline before failing, and whether to record the measured
+// times as the new baseline
+const char* BENCH_THRESHOLD_VARIABLE = "ZYZZYVA_BENCH_THRESHOLD";
+const char* BENCH_RECORD_VARIABLE = "ZYZZYVA_BENCH_RECORD";
+
 //---------------------------------------------------------------------------
 //  tryImport
 //
@@ -78,6 +102,10 @@ WordEngineTest::tryImport()
     engine.importStems(TEST_LEXICON, Auxil::getWordsDir() +
                        "/north-american/7-letter-stems.txt");
 
+    // Search results are not cached, so repeated searches are measured in
+    // full by the benchmarks
+    MainSettings::setSearchCacheSize(0);
+
     MainSettings::setLetterDistribution("A:9 B:2 C:2 D:4 E:12 F:2 G:3 H:2 "
                                         "I:9 J:1 K:1 L:4 M:2 N:6 O:8 P:2 "
                                         "Q:1 R:6 S:4 T:6 U:4 V:2 W:2 X:1 "
@@ -124,27 +152,10 @@ WordEngineTest::testSearch()
     tryImport();
 
     QFETCH(QString, testName);
-    QString testFilename = testName + ".zzs";
     QString resultFilename = testName + ".txt";
 
-    // Create a SearchSpec from a test file
-    QFile testFile (Auxil::getRootDir() + "/src/tests/data/" + testFilename);
-    if (!testFile.open(QIODevice::ReadOnly | QIODevice::Text))
-        QFAIL("Cannot open test file");
-
-    QString errorMsg;
-    int errorLine = 0;
-    int errorColumn = 0;
-
-    QDomDocument document;
-    bool success = document.setContent(&testFile, false, &errorMsg,
-                                       &errorLine, &errorColumn);
-
-    if (!success)
-        QFAIL("Error in test file XML");
-
     SearchSpec spec;
-    if (!spec.fromDomElement(document.documentElement()))
+    if (!readSearchSpec(testName, &spec))
         QFAIL("Error in test file");
 
     // Get a list of expected results
@@ -166,6 +177,270 @@ WordEngineTest::testSearch()
     QCOMPARE(foundResults, expectedResults);
 }
 
+//---------------------------------------------------------------------------
+//  testJudgeStream
+//
+//! Test judging words read from a stream.
+//---------------------------------------------------------------------------
+void
+WordEngineTest::testJudgeStream()
+{
+    tryImport();
+
+    QByteArray input ("quiz QZXJ\n  aa\txyzzy\n");
+    QBuffer in (&input);
+    in.open(QIODevice::ReadOnly);
+    QByteArray output;
+    QBuffer out (&output);
+    out.open(QIODevice::WriteOnly);
+
+    BatchJudge judge (&engine, TEST_LEXICON);
+    QVERIFY(judge.judgeStream(&in, &out));
+
+    QByteArray expected ("QUIZ\tVALID\t\n"
+                         "QZXJ\tINVALID\t\n"
+                         "AA\tVALID\t\n"
+                         "XYZZY\tINVALID\t\n");
+    QCOMPARE(output, expected);
+    QCOMPARE(judge.getNumWords(), qint64(4));
+    QCOMPARE(judge.getNumAcceptable(), qint64(2));
+}
+
+//---------------------------------------------------------------------------
+//  testSampleSearch
+//
+//! Test drawing a seeded random sample of the matches of a search.
+//---------------------------------------------------------------------------
+void
+WordEngineTest::testSampleSearch()
+{
+    tryImport();
+
+    SearchCondition condition;
+    condition.type = SearchCondition::PatternMatch;
+    condition.stringValue = "Q*";
+    SearchSpec spec;
+    spec.conditions.append(condition);
+    QStringList matches = engine.search(TEST_LEXICON, spec, true);
+
+    spec.sampleSize = 10;
+    spec.sampleSeed = 12345;
+    QStringList sample = engine.search(TEST_LEXICON, spec, true);
+    QCOMPARE(sample.size(), qMin(spec.sampleSize, matches.size()));
+    QCOMPARE(sample.toSet().size(), sample.size());
+    foreach (const QString& word, sample)
+        QVERIFY(matches.contains(word));
+    QCOMPARE(engine.search(TEST_LEXICON, spec, true), sample);
+    QCOMPARE(engine.countMatches(TEST_LEXICON, spec), sample.size());
+}
+
+//---------------------------------------------------------------------------
+//  testLetterConstraintSearch
+//
+//! Test that Include Letters and Consist Of conditions pruning the word
+//! graph traversal find the same words as checking every match.
+//---------------------------------------------------------------------------
+void
+WordEngineTest::testLetterConstraintSearch()
+{
+    tryImport();
+
+    const QString consistLetters = "AEINRST";
+    QList<SearchCondition> matchConditions;
+    SearchCondition condition;
+    condition.type = SearchCondition::PatternMatch;
+    condition.stringValue = "R*";
+    matchConditions.append(condition);
+    condition.type = SearchCondition::SubanagramMatch;
+    condition.stringValue = "AEEINRST";
+    matchConditions.append(condition);
+
+    foreach (const SearchCondition& matchCondition, matchConditions) {
+        SearchSpec spec;
+        spec.conditions.append(matchCondition);
+        QStringList expected;
+        foreach (const QString& word, engine.search(TEST_LEXICON, spec,
+                                                    true))
+        {
+            bool consists = true;
+            for (int i = 0; i < word.length(); ++i) {
+                if (!consistLetters.contains(word.at(i)))
+                    consists = false;
+            }
+            if (consists && (word.count('E') >= 2))
+                expected.append(word);
+        }
+
+        condition = SearchCondition();
+        condition.type = SearchCondition::IncludeLetters;
+        condition.stringValue = "EE";
+        spec.conditions.append(condition);
+        condition = SearchCondition();
+        condition.type = SearchCondition::ConsistOf;
+        condition.stringValue = consistLetters;
+        condition.minValue = 100;
+        condition.maxValue = 100;
+        spec.conditions.append(condition);
+
+        QStringList found = engine.search(TEST_LEXICON, spec, true);
+        qSort(expected);
+        qSort(found);
+        QVERIFY(!expected.isEmpty());
+        QCOMPARE(found, expected);
+    }
+}
+
+//---------------------------------------------------------------------------
+//  benchSearch_data
+//
+//! Set up the searches to benchmark, the same as the search tests.
+//---------------------------------------------------------------------------
+void
+WordEngineTest::benchSearch_data()
+{
+    testSearch_data();
+}
+
+//---------------------------------------------------------------------------
+//  benchSearch
+//
+//! Benchmark a search.  If a regression threshold is set, fail if the
+//! search is slower than its baseline by more than the threshold.
+//---------------------------------------------------------------------------
+void
+WordEngineTest::benchSearch()
+{
+    tryImport();
+    if (baselineUsecs.isEmpty())
+        readBaseline();
+
+    QFETCH(QString, testName);
+    SearchSpec spec;
+    if (!readSearchSpec(testName, &spec))
+        QFAIL("Error in test file");
+
+    qint64 nsecs = 0;
+    int numSearches = 0;
+    QElapsedTimer timer;
+    QBENCHMARK {
+        timer.start();
+        engine.search(TEST_LEXICON, spec, true);
+        nsecs += timer.nsecsElapsed();
+        ++numSearches;
+    }
+
+    double usecs = nsecs / (1000.0 * numSearches);
+    measuredUsecs[testName] = usecs;
+
+    bool ok = false;
+    double threshold = QString(qgetenv(BENCH_THRESHOLD_VARIABLE)).toDouble(
+        &ok);
+    if (!ok || !baselineUsecs.contains(testName))
+        return;
+
+    double maxUsecs = baselineUsecs[testName] * (1 + threshold / 100);
+    QString message = QString("%1 us per search, more than %2 us allowed "
+                              "by a baseline of %3 us").arg(usecs, 0, 'f', 1)
+        .arg(maxUsecs, 0, 'f', 1).arg(baselineUsecs[testName], 0, 'f', 1);
+    QVERIFY2(usecs <= maxUsecs, message.toUtf8().constData());
+}
+
+//---------------------------------------------------------------------------
+//  cleanupTestCase
+//
+//! Write the measured benchmark times as the new baseline, if recording is
+//! asked for.
+//---------------------------------------------------------------------------
+void
+WordEngineTest::cleanupTestCase()
+{
+    if (!qgetenv(BENCH_RECORD_VARIABLE).isEmpty() && !measuredUsecs.isEmpty())
+        writeBaseline();
+}
+
+//---------------------------------------------------------------------------
+//  readSearchSpec
+//
+//! Read the search spec of a test from its test file.
+//
+//! @param testName the name of the test
+//! @param spec returns the search spec
+//! @return true if successful, false otherwise
+//---------------------------------------------------------------------------
+bool
+WordEngineTest::readSearchSpec(const QString& testName, SearchSpec* spec)
+{
+    QFile testFile (Auxil::getRootDir() + "/src/tests/data/" + testName +
+                    ".zzs");
+    if (!testFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    QDomDocument document;
+    if (!document.setContent(&testFile, false))
+        return false;
+
+    return spec->fromDomElement(document.documentElement());
+}
+
+//---------------------------------------------------------------------------
+//  readBaseline
+//
+//! Read the benchmark baseline file.  Each line holds the name of a
+//! benchmark and its microseconds per search.  Lines starting with # are
+//! comments.
+//---------------------------------------------------------------------------
+void
+WordEngineTest::readBaseline()
+{
+    QFile file (Auxil::getRootDir() + "/src/tests/data/" +
+                BENCH_BASELINE_FILENAME);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return;
+
+    while (!file.atEnd()) {
+        QString line = QString(file.readLine()).simplified();
+        if (line.isEmpty() || line.startsWith("#"))
+            continue;
+
+        bool ok = false;
+        double usecs = line.section(' ', 1, 1).toDouble(&ok);
+        if (ok)
+            baselineUsecs[line.section(' ', 0, 0)] = usecs;
+    }
+}
+
+//---------------------------------------------------------------------------
+//  writeBaseline
+//
+//! Write the measured microseconds per search of each benchmark to the
+//! benchmark baseline file.
+//---------------------------------------------------------------------------
+void
+WordEngineTest::writeBaseline() const
+{
+    QFile file (Auxil::getRootDir() + "/src/tests/data/" +
+                BENCH_BASELINE_FILENAME);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate |
+                   QIODevice::Text))
+    {
+        return;
+    }
+
+    QTextStream stream (&file);
+    stream << "# Microseconds per search of each benchmark in test_zyzzyva";
+    endl(stream);
+    stream << "# Recorded by running test_zyzzyva with "
+        << BENCH_RECORD_VARIABLE << " set";
+    endl(stream);
+
+    QMapIterator<QString, double> it (measuredUsecs);
+    while (it.hasNext()) {
+        it.next();
+        stream << it.key() << " " << QString::number(it.value(), 'f', 1);
+        endl(stream);
+    }
+}
+
 // Create a main function for a standalone executable
 QTEST_MAIN(WordEngineTest);
 #include "WordEngineTest.moc"
@@ -28,6 +28,7 @@
 #include <QObject>
 #include <QPixmap>
 #include <QSplashScreen>
+#include <QTimer>
 
 const QString SETTINGS_ORGANIZATION_NAME = "Piet Depsi";
 const QString SETTINGS_DOMAIN_NAME = "pietdepsi.com";
@@ -35,6 +36,8 @@ const QString SETTINGS_APPLICATION_NAME = "Zyzzyva";
 
 int main(int argc, char** argv)
 {
+    MainWindow::markStartupPhase("start");
+
     ZApplication app(argc, argv);
     QCoreApplication::setOrganizationName(SETTINGS_ORGANIZATION_NAME);
     QCoreApplication::setOrganizationDomain(SETTINGS_DOMAIN_NAME);
@@ -47,16 +50,21 @@ int main(int argc, char** argv)
     QPixmap pixmap (":/zyzzyva-splash");
     QSplashScreen* splash = new QSplashScreen(pixmap);
     splash->show();
+    MainWindow::markStartupPhase("application");
 
     MainWindow* window = new MainWindow(0, splash);
+    MainWindow::markStartupPhase("main window");
 
     window->tryUpdateUserDataDir();
     window->tryAutoImport();
+    MainWindow::markStartupPhase("lexicons");
     window->tryConnectToDatabases();
+    MainWindow::markStartupPhase("databases");
 
     window->show();
     splash->finish(window);
     delete splash;
+    MainWindow::markStartupPhase("shown");
 
     // Now that the splash screen is gone, process any database errors
     window->processDatabaseErrors();
@@ -82,5 +90,8 @@ int main(int argc, char** argv)
                      window, SLOT(fileOpenRequested(const QString&)));
 #endif
 
+    // Finish the startup trace once the event loop is running
+    QTimer::singleShot(0, window, SLOT(startupFinished()));
+
     return app.exec();
 }
@@ -38,6 +38,11 @@ else {
 
 CONFIG = $$unique(CONFIG)
 
+# Scoped trace events in hot paths, saved in the Chrome trace event format
+contains(BUILD, trace) {
+    DEFINES += Z_TRACE
+}
+
 unix {
     DEFINES += Z_UNIX
 }